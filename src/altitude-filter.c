@@ -0,0 +1,211 @@
+/**
+ * @file altitude-filter.c
+ * @desc Kalman filter for altitude and vertical velocity
+ * @author agent
+ * @date 2026-10-16
+ * Last Author:
+ * Last Edited On:
+ */
+
+#include "altitude-filter.h"
+
+/** Longest period over which the state will be propagated in one step */
+#define ALT_FILTER_MAX_STEP         MS_TO_MILLIS(10000)
+/** Number of millis in a second */
+#define ALT_FILTER_MILLIS_PER_SEC   MS_TO_MILLIS(1000)
+
+
+/**
+ *  Steady state Kalman gains for one interval between barometer measurements.
+ */
+struct alt_filter_gains_t {
+    /** Interval between barometer measurements */
+    uint16_t period;
+    /** Gain for altitude with 16 fractional bits */
+    int32_t altitude;
+    /** Gain for velocity in per second with 16 fractional bits */
+    int32_t velocity;
+    /** Gain for acceleration bias in per second squared with 16 fractional
+        bits */
+    int32_t accel_bias;
+};
+
+//
+//  Steady state gains found by iterating the discrete Riccati equation until
+//  it converges. The state is altitude, velocity and acceleration bias.
+//  Acceleration noise enters through the input, the bias is a random walk and
+//  barometric altitude is the measurement. The noise levels are:
+//      barometric altitude:        1 m standard deviation
+//      vertical acceleration:      1 m/s^2 standard deviation, this includes
+//                                  errors from the rocket not being exactly
+//                                  vertical
+//      acceleration bias wander:   0.05 m/s^2 per root second
+//
+//  #! /usr/bin/env python3
+//  r, qa, sb = 1.0 ** 2, 1.0 ** 2, 0.05
+//  for ms in (10, 15, 20, 30, 40, 50, 70, 100, 150, 200, 300, 500, 1000):
+//      t = ms / 1000
+//      f = [[1, t, -t * t / 2], [0, 1, -t], [0, 0, 1]]
+//      g = [t * t / 2, t, 0]
+//      q = [[g[i] * g[j] * qa + (sb * sb * t if i == j == 2 else 0)
+//            for j in range(3)] for i in range(3)]
+//      p = [[0] * 3 for _ in range(3)]
+//      for _ in range(2000):
+//          fp = [[sum(f[i][k] * p[k][j] for k in range(3)) for j in range(3)]
+//                for i in range(3)]
+//          pp = [[sum(fp[i][k] * f[j][k] for k in range(3)) + q[i][j]
+//                 for j in range(3)] for i in range(3)]
+//          k = [pp[i][0] / (pp[0][0] + r) for i in range(3)]
+//          p = [[pp[i][j] - k[i] * pp[0][j] for j in range(3)]
+//               for i in range(3)]
+//      print('    {{ MS_TO_MILLIS({}), {}, {}, {} }},'.format(
+//            ms, *(round(v * 65536) for v in k)))
+static const struct alt_filter_gains_t alt_filter_gains[] = {
+    { MS_TO_MILLIS(10), 1192, 1093, -325 },
+    { MS_TO_MILLIS(15), 1715, 1516, -396 },
+    { MS_TO_MILLIS(20), 2224, 1920, -455 },
+    { MS_TO_MILLIS(30), 3211, 2689, -553 },
+    { MS_TO_MILLIS(40), 4168, 3424, -634 },
+    { MS_TO_MILLIS(50), 5101, 4133, -704 },
+    { MS_TO_MILLIS(70), 6906, 5491, -820 },
+    { MS_TO_MILLIS(100), 9485, 7410, -958 },
+    { MS_TO_MILLIS(150), 13493, 10357, -1131 },
+    { MS_TO_MILLIS(200), 17184, 13039, -1259 },
+    { MS_TO_MILLIS(300), 23748, 17735, -1433 },
+    { MS_TO_MILLIS(500), 34204, 24959, -1602 },
+    { MS_TO_MILLIS(1000), 49938, 34379, -1599 },
+};
+
+#define ALT_FILTER_NUM_GAINS    (sizeof(alt_filter_gains) / \
+                                 sizeof(alt_filter_gains[0]))
+
+
+/**
+ *  Select the gains from the table which were calculated for the interval
+ *  closest to a given interval between barometer measurements. Intervals are
+ *  compared by ratio, so the boundary between two entries is at the geometric
+ *  mean of their intervals.
+ *
+ *  @param filter The filter instance
+ *  @param period The interval between barometer measurements
+ */
+static void select_gains(struct altitude_filter_t *const filter,
+                         uint32_t const period)
+{
+    uint32_t const period_sq = ((period < ALT_FILTER_MAX_STEP) ?
+                                (period * period) :
+                                (ALT_FILTER_MAX_STEP * ALT_FILTER_MAX_STEP));
+
+    unsigned int i = 0;
+    for (; i < (ALT_FILTER_NUM_GAINS - 1); i++) {
+        if (period_sq < ((uint32_t)alt_filter_gains[i].period *
+                         alt_filter_gains[i + 1].period)) {
+            break;
+        }
+    }
+
+    filter->gain_altitude = alt_filter_gains[i].altitude;
+    filter->gain_velocity = alt_filter_gains[i].velocity;
+    filter->gain_accel_bias = alt_filter_gains[i].accel_bias;
+    filter->gain_period = alt_filter_gains[i].period;
+}
+
+/**
+ *  Propagate the filter state forward to a given time using the most recent
+ *  acceleration measurement.
+ *
+ *  @param filter The filter instance
+ *  @param time The time to which the state should be propagated
+ */
+static void propagate(struct altitude_filter_t *const filter,
+                      uint32_t const time)
+{
+    int32_t const elapsed = (int32_t)(time - filter->time);
+    if (elapsed <= 0) {
+        return;
+    }
+    filter->time = time;
+
+    uint32_t const step = (((uint32_t)elapsed > ALT_FILTER_MAX_STEP) ?
+                           ALT_FILTER_MAX_STEP : (uint32_t)elapsed);
+    // Time step in seconds with 16 fractional bits
+    int64_t const dt = (int64_t)((step << 16) / ALT_FILTER_MILLIS_PER_SEC);
+
+    // Acceleration and change in velocity with 8 fractional bits
+    int32_t const accel = (filter->accel * 256) - filter->accel_bias;
+    int32_t const dv = (int32_t)((accel * dt) >> 16);
+
+    // h += v * dt + (a * dt^2) / 2, the result of the multiplications has 24
+    // fractional bits and altitude has 4
+    filter->altitude += (int32_t)(((filter->velocity * dt) +
+                                   ((dv * dt) / 2)) >> 20);
+    filter->velocity += dv;
+}
+
+void init_altitude_filter(struct altitude_filter_t *const filter,
+                          uint32_t const baro_period)
+{
+    filter->altitude = 0;
+    filter->velocity = 0;
+    filter->accel_bias = 0;
+    filter->accel = 0;
+    filter->time = 0;
+    filter->baro_time = 0;
+    filter->baro_period = baro_period;
+    filter->initialized = 0;
+
+    select_gains(filter, baro_period);
+}
+
+void altitude_filter_predict(struct altitude_filter_t *const filter,
+                             int32_t const accel, uint32_t const time)
+{
+    filter->accel = accel;
+
+    if (!filter->initialized) {
+        // Nothing to propagate until we have an altitude
+        return;
+    }
+
+    propagate(filter, time);
+}
+
+void altitude_filter_update(struct altitude_filter_t *const filter,
+                            int32_t const altitude, uint32_t const time)
+{
+    if (!filter->initialized) {
+        // Start from the first measurement at rest
+        filter->altitude = altitude * 16;
+        filter->velocity = 0;
+        filter->accel_bias = 0;
+        filter->time = time;
+        filter->baro_time = time;
+        filter->initialized = 1;
+        return;
+    }
+
+    // Follow the average barometer rate with the gains, the average keeps an
+    // occasional late or missed measurement from changing the gains
+    uint32_t const period = time - filter->baro_time;
+    filter->baro_time = time;
+    if (period < ALT_FILTER_MAX_STEP) {
+        filter->baro_period = ((filter->baro_period * 7) + period) / 8;
+    }
+    select_gains(filter, filter->baro_period);
+
+    // Bring the state up to the time of the measurement, if the acceleration
+    // measurements have already taken the state past this time the
+    // measurement is applied to the newer state
+    propagate(filter, time);
+
+    int32_t const innovation = (altitude * 16) - filter->altitude;
+
+    // Gains have 16 fractional bits and the innovation has 4, altitude has 4
+    // fractional bits and velocity and acceleration bias have 8
+    filter->altitude += (int32_t)(((int64_t)filter->gain_altitude *
+                                   innovation) >> 16);
+    filter->velocity += (int32_t)(((int64_t)filter->gain_velocity *
+                                   innovation) >> 12);
+    filter->accel_bias += (int32_t)(((int64_t)filter->gain_accel_bias *
+                                     innovation) >> 12);
+}
@@ -0,0 +1,143 @@
+/**
+ * @file altitude-filter.h
+ * @desc Kalman filter for altitude and vertical velocity
+ * @author agent
+ * @date 2026-10-16
+ * Last Author:
+ * Last Edited On:
+ */
+
+#ifndef altitude_filter_h
+#define altitude_filter_h
+
+#include "global.h"
+
+/*
+ *  The filter estimates altitude, vertical velocity and the bias of the
+ *  vertical acceleration measurement. Vertical acceleration is used as an input
+ *  to propagate the state forward in time at the IMU sample rate and barometric
+ *  altitude is used as the measurement.
+ *
+ *  The state is kept in fixed point and propagating it or applying a
+ *  measurement uses only integer multiplies, adds and shifts. The filter uses
+ *  the steady state Kalman gain for the interval between barometer
+ *  measurements. The gains are calculated ahead of time for a range of
+ *  intervals and kept in a fixed point table, so following a change in the
+ *  barometer rate only means selecting a different entry.
+ *
+ *  All times are in units of millis.
+ */
+
+/**
+ *  Instance of the altitude filter.
+ */
+struct altitude_filter_t {
+    /** Estimated altitude in sixteenths of a millimeter */
+    int32_t altitude;
+    /** Estimated vertical velocity in 256ths of a millimeter per second */
+    int32_t velocity;
+    /** Estimated bias of the acceleration measurement in 256ths of a
+        millimeter per second squared */
+    int32_t accel_bias;
+    /** Most recent vertical acceleration measurement in millimeters per
+        second squared */
+    int32_t accel;
+
+    /** Time to which the state has been propagated */
+    uint32_t time;
+    /** Time of the last barometer measurement */
+    uint32_t baro_time;
+    /** Moving average of the interval between barometer measurements */
+    uint32_t baro_period;
+    /** Interval between barometer measurements for which the selected gains
+        were calculated */
+    uint32_t gain_period;
+
+    /** Kalman gain for altitude with 16 fractional bits */
+    int32_t gain_altitude;
+    /** Kalman gain for velocity in per second with 16 fractional bits */
+    int32_t gain_velocity;
+    /** Kalman gain for acceleration bias in per second squared with 16
+        fractional bits */
+    int32_t gain_accel_bias;
+
+    /** Flag to indicate that the state has been initialized from a barometer
+        measurement */
+    uint8_t initialized:1;
+};
+
+
+/**
+ *  Initialize an altitude filter.
+ *
+ *  @param filter The filter instance to be initialized
+ *  @param baro_period The expected interval between barometer measurements
+ */
+extern void init_altitude_filter(struct altitude_filter_t *filter,
+                                 uint32_t baro_period);
+
+/**
+ *  Propagate the filter state forward to a given time using a vertical
+ *  acceleration measurement. The acceleration is held until the next
+ *  measurement and is also used to propagate the state to the time of any
+ *  barometer measurements.
+ *
+ *  @param filter The filter instance
+ *  @param accel Vertical acceleration in millimeters per second squared, not
+ *               including gravity
+ *  @param time The time up to which the measurement applies
+ */
+extern void altitude_filter_predict(struct altitude_filter_t *filter,
+                                    int32_t accel, uint32_t time);
+
+/**
+ *  Correct the filter state with a barometric altitude measurement.
+ *
+ *  @param filter The filter instance
+ *  @param altitude Measured altitude in millimeters
+ *  @param time The time at which the altitude was measured
+ */
+extern void altitude_filter_update(struct altitude_filter_t *filter,
+                                   int32_t altitude, uint32_t time);
+
+/**
+ *  Get the estimated altitude.
+ *
+ *  @param filter The filter instance
+ *
+ *  @return The estimated altitude in millimeters
+ */
+static inline int32_t altitude_filter_get_altitude(
+                                    const struct altitude_filter_t *filter)
+{
+    return filter->altitude / 16;
+}
+
+/**
+ *  Get the estimated vertical velocity.
+ *
+ *  @param filter The filter instance
+ *
+ *  @return The estimated vertical velocity in millimeters per second
+ */
+static inline int32_t altitude_filter_get_velocity(
+                                    const struct altitude_filter_t *filter)
+{
+    return filter->velocity / 256;
+}
+
+/**
+ *  Get the estimated vertical acceleration.
+ *
+ *  @param filter The filter instance
+ *
+ *  @return The estimated vertical acceleration in millimeters per second
+ *          squared
+ */
+static inline int32_t altitude_filter_get_accel(
+                                    const struct altitude_filter_t *filter)
+{
+    return filter->accel - (filter->accel_bias / 256);
+}
+
+#endif /* altitude_filter_h */
@@ -24,6 +24,9 @@
 #include "sdhc.h"
 
 #include "kx134-1211.h"
+#include "timebase.h"
+#include "scheduler.h"
+#include "evsys.h"
 
 // MARK: Hardware Resources from Config File
 #ifdef ENABLE_SPI0
@@ -61,6 +64,145 @@ struct kx134_1211_desc_t kx134_g;
 #endif
 
 
+// MARK: Scheduler Tasks
+#define STAT_PERIOD MS_TO_MILLIS(1500)
+/** Period at which the watchdog is patted, well within its timeout */
+#define WDT_PAT_PERIOD MS_TO_MILLIS(50)
+/** Period at which the SD host controller driver is run for the delays and
+    timeouts in its state machine which are not ended by an interrupt */
+#define SDHC_TASK_PERIOD MS_TO_MILLIS(1)
+/** Period at which the KX134 driver is run for the delays in its
+    initialization sequence */
+#define KX134_TASK_PERIOD MS_TO_MILLIS(1)
+
+#ifdef ENABLE_WATCHDOG
+static struct sched_task_t wdt_task_g;
+
+static void wdt_task(void *context)
+{
+    // Pat the watchdog
+    wdt_pat();
+}
+#endif
+
+static struct sched_task_t debug_blink_task_g;
+
+static void debug_blink_task(void *context)
+{
+    gpio_toggle_output(DEBUG0_LED_PIN);
+}
+
+static struct sched_task_t stat_blink_task_g;
+
+static void stat_blink_task(void *context)
+{
+    gpio_toggle_output(STAT_R_LED_PIN);
+    gpio_toggle_output(STAT_G_LED_PIN);
+}
+
+#if defined(ENABLE_I2C0) || defined(ENABLE_I2C1)
+SCHED_TASK_FUNC(i2c_task, sercom_i2c_service, struct sercom_i2c_desc_t)
+#endif
+#ifdef ENABLE_I2C0
+static struct sched_task_t i2c0_task_g;
+#endif
+#ifdef ENABLE_I2C1
+static struct sched_task_t i2c1_task_g;
+#endif
+
+#if (defined(ENABLE_UART0) || defined(ENABLE_UART1) || \
+     defined(ENABLE_UART2) || defined(ENABLE_UART3))
+SCHED_TASK_FUNC(uart_task, sercom_uart_service, struct sercom_uart_desc_t)
+#endif
+#ifdef ENABLE_UART0
+static struct sched_task_t uart0_task_g;
+#endif
+#ifdef ENABLE_UART1
+static struct sched_task_t uart1_task_g;
+#endif
+#ifdef ENABLE_UART2
+static struct sched_task_t uart2_task_g;
+#endif
+#ifdef ENABLE_UART3
+static struct sched_task_t uart3_task_g;
+#endif
+
+#ifdef ENABLE_ADC
+static struct sched_task_t adc_task_g;
+
+static void adc_task(void *context)
+{
+    adc_service();
+}
+#endif
+
+#ifdef ENABLE_SDHC0
+static struct sched_task_t sdhc0_task_g;
+SCHED_TASK_FUNC(sdhc_task, sdhc_service, struct sdhc_desc_t)
+#endif
+
+#ifdef ENABLE_KX134_1211
+static struct sched_task_t kx134_task_g;
+SCHED_TASK_FUNC(kx134_task, kx134_1211_service, struct kx134_1211_desc_t)
+#endif
+
+/**
+ *  Add the service functions for board level drivers to the scheduler. Drivers
+ *  are run when one of their interrupts or callbacks signals that they have
+ *  work to do and periodically for anything that depends only on time. Data
+ *  received by DMA does not cause an interrupt, so the UARTs are run
+ *  periodically to notice it and wake the tasks which are waiting on them.
+ */
+static void init_board_tasks(void)
+{
+#ifdef ENABLE_WATCHDOG
+    sched_add_task(&wdt_task_g, wdt_task, NULL, "wdt", WDT_PAT_PERIOD, 0);
+#endif
+    sched_add_task(&debug_blink_task_g, debug_blink_task, NULL, "blink",
+                   DEBUG_BLINK_PERIOD, 0);
+    sched_add_task(&stat_blink_task_g, stat_blink_task, NULL, "stat",
+                   STAT_PERIOD, 0);
+#ifdef ENABLE_I2C0
+    sched_add_task(&i2c0_task_g, i2c_task, &i2c0_g, "i2c0", 0, 0);
+    sched_event_add_task(&i2c0_g.event, &i2c0_task_g);
+#endif
+#ifdef ENABLE_I2C1
+    sched_add_task(&i2c1_task_g, i2c_task, &i2c1_g, "i2c1", 0, 0);
+    sched_event_add_task(&i2c1_g.event, &i2c1_task_g);
+#endif
+#ifdef ENABLE_UART0
+    sched_add_task(&uart0_task_g, uart_task, &uart0_g, "uart0",
+                   SERCOM_UART_RX_SYNC_PERIOD, 0);
+#endif
+#ifdef ENABLE_UART1
+    sched_add_task(&uart1_task_g, uart_task, &uart1_g, "uart1",
+                   SERCOM_UART_RX_SYNC_PERIOD, 0);
+#endif
+#ifdef ENABLE_UART2
+    sched_add_task(&uart2_task_g, uart_task, &uart2_g, "uart2",
+                   SERCOM_UART_RX_SYNC_PERIOD, 0);
+#endif
+#ifdef ENABLE_UART3
+    sched_add_task(&uart3_task_g, uart_task, &uart3_g, "uart3",
+                   SERCOM_UART_RX_SYNC_PERIOD, 0);
+#endif
+#ifdef ENABLE_ADC
+    sched_add_task(&adc_task_g, adc_task, NULL, "adc", ADC_PERIOD, 0);
+#endif
+#ifdef ENABLE_SDHC0
+    sched_add_task(&sdhc0_task_g, sdhc_task, &sdhc0_g, "sdhc0",
+                   SDHC_TASK_PERIOD, 0);
+    sched_event_add_task(&sdhc0_g.event, &sdhc0_task_g);
+#endif
+#ifdef ENABLE_KX134_1211
+    sched_add_task(&kx134_task_g, kx134_task, &kx134_g, "kx134",
+                   KX134_TASK_PERIOD, 0);
+    sched_event_add_task(&kx134_g.event, &kx134_task_g);
+    sched_event_add_task(&kx134_g.spi_inst->event, &kx134_task_g);
+#endif
+}
+
+
 // MARK: Functions
 static inline void init_io (void)
 {
@@ -244,40 +386,52 @@ void init_board(void)
 #ifdef ENABLE_UART0
 #ifndef UART0_DMA_CHAN
 #define UART0_DMA_CHAN -1
+#endif
+#ifndef UART0_RX_DMA_CHAN
+#define UART0_RX_DMA_CHAN -1
 #endif
     init_sercom_uart(&uart0_g, UART0_SERCOM_INST, UART0_BAUD, 48000000UL,
-                     SAME54_CLK_MSK_48MHZ, UART0_DMA_CHAN, UART0_ECHO,
-                     UART0_TX_PIN_GROUP, UART0_TX_PIN_NUM);
+                     SAME54_CLK_MSK_48MHZ, UART0_DMA_CHAN, UART0_RX_DMA_CHAN,
+                     UART0_ECHO, UART0_TX_PIN_GROUP, UART0_TX_PIN_NUM);
 #endif
 
     // Init UART 1
 #ifdef ENABLE_UART1
 #ifndef UART1_DMA_CHAN
 #define UART1_DMA_CHAN -1
+#endif
+#ifndef UART1_RX_DMA_CHAN
+#define UART1_RX_DMA_CHAN -1
 #endif
     init_sercom_uart(&uart1_g, UART1_SERCOM_INST, UART1_BAUD, 48000000UL,
-                     SAME54_CLK_MSK_48MHZ, UART1_DMA_CHAN, UART1_ECHO,
-                     UART1_TX_PIN_GROUP, UART1_TX_PIN_NUM);
+                     SAME54_CLK_MSK_48MHZ, UART1_DMA_CHAN, UART1_RX_DMA_CHAN,
+                     UART1_ECHO, UART1_TX_PIN_GROUP, UART1_TX_PIN_NUM);
 #endif
 
     // Init UART 2
 #ifdef ENABLE_UART2
 #ifndef UART2_DMA_CHAN
 #define UART2_DMA_CHAN -1
+#endif
+#ifndef UART2_RX_DMA_CHAN
+#define UART2_RX_DMA_CHAN -1
 #endif
     init_sercom_uart(&uart2_g, UART2_SERCOM_INST, UART2_BAUD, 48000000UL,
-                     SAME54_CLK_MSK_48MHZ, UART2_DMA_CHAN, UART2_ECHO,
-                     UART2_TX_PIN_GROUP, UART2_TX_PIN_NUM);
+                     SAME54_CLK_MSK_48MHZ, UART2_DMA_CHAN, UART2_RX_DMA_CHAN,
+                     UART2_ECHO, UART2_TX_PIN_GROUP, UART2_TX_PIN_NUM);
 #endif
 
     // Init UART 3
 #ifdef ENABLE_UART3
 #ifndef UART3_DMA_CHAN
 #define UART3_DMA_CHAN -1
+#endif
+#ifndef UART3_RX_DMA_CHAN
+#define UART3_RX_DMA_CHAN -1
 #endif
     init_sercom_uart(&uart3_g, UART3_SERCOM_INST, UART3_BAUD, 48000000UL,
-                     SAME54_CLK_MSK_48MHZ, UART3_DMA_CHAN, UART3_ECHO,
-                     UART3_TX_PIN_GROUP, UART3_TX_PIN_NUM);
+                     SAME54_CLK_MSK_48MHZ, UART3_DMA_CHAN, UART3_RX_DMA_CHAN,
+                     UART3_ECHO, UART3_TX_PIN_GROUP, UART3_TX_PIN_NUM);
 #endif
 
     // Init ADC
@@ -327,71 +481,23 @@ void init_board(void)
                     KX134_1211_RES);
 #endif
 
+    // Microsecond timebase
+#ifdef ENABLE_TIMEBASE
+    init_timebase(TIMEBASE_TC, SAME54_CLK_MSK_1MHZ, 1000000UL);
+#ifdef TIMEBASE_CAPTURE_PIN
+    // The interrupt for the captured pin must already be enabled
+    init_evsys();
+    timebase_capture_pin(TIMEBASE_CAPTURE_PIN, TIMEBASE_EVENT_CHAN,
+                         SAME54_CLK_MSK_48MHZ);
+#endif
+#endif
+
 
     // WDT
 #ifdef ENABLE_WATCHDOG
     // 2 seconds, no early warning interrupt
     init_wdt(0, 11, 0);
 #endif
-}
-
-
-
-#define STAT_PERIOD MS_TO_MILLIS(1500)
-
-void board_service(void)
-{
-#ifdef ENABLE_WATCHDOG
-    // Pat the watchdog
-    wdt_pat();
-#endif
-
-    static uint32_t last_debug_blink_time = 0;
-    if ((millis - last_debug_blink_time) >= DEBUG_BLINK_PERIOD) {
-        last_debug_blink_time = millis;
-        gpio_toggle_output(DEBUG0_LED_PIN);
-    }
-
-    static uint32_t last_stat_blink_time = 0;
-    if (((millis - last_stat_blink_time) >= STAT_PERIOD)) {
-        last_stat_blink_time = millis;
-        gpio_toggle_output(STAT_R_LED_PIN);
-        gpio_toggle_output(STAT_G_LED_PIN);
-    }
-
-#ifdef ENABLE_I2C0
-    sercom_i2c_service(&i2c0_g);
-#endif
-
-#ifdef ENABLE_I2C1
-    sercom_i2c_service(&i2c1_g);
-#endif
-
-#ifdef ENABLE_UART0
-    sercom_uart_service(&uart0_g);
-#endif
-
-#ifdef ENABLE_UART1
-    sercom_uart_service(&uart1_g);
-#endif
 
-#ifdef ENABLE_UART2
-    sercom_uart_service(&uart2_g);
-#endif
-
-#ifdef ENABLE_UART3
-    sercom_uart_service(&uart3_g);
-#endif
-
-#ifdef ENABLE_ADC
-    adc_service();
-#endif
-
-#ifdef ENABLE_SDHC0
-    sdhc_service(&sdhc0_g);
-#endif
-
-#ifdef ENABLE_KX134_1211
-    kx134_1211_service(&kx134_g);
-#endif
+    init_board_tasks();
 }
@@ -186,6 +186,8 @@ extern struct sercom_i2c_desc_t i2c1_g;
 #define UART0_SERCOM_INST SERCOM1
 /* DMA Channel used for UART TX, DMA not used if not defined or defined as -1 */
 #define UART0_DMA_CHAN 14
+/* DMA Channel used for UART RX, DMA not used if not defined or defined as -1 */
+#define UART0_RX_DMA_CHAN 18
 /* Group number for UART TX pin */
 #define UART0_TX_PIN_GROUP 0
 /* Pin number for UART TX pin */
@@ -198,6 +200,8 @@ extern struct sercom_uart_desc_t uart0_g;
 #define UART1_SERCOM_INST SERCOM0
 /* DMA Channel used for UART TX, DMA not used if not defined or defined as -1 */
 #define UART1_DMA_CHAN 15
+/* DMA Channel used for UART RX, DMA not used if not defined or defined as -1 */
+#define UART1_RX_DMA_CHAN 19
 /* Group number for UART TX pin */
 #define UART1_TX_PIN_GROUP 2
 /* Pin number for UART TX pin */
@@ -210,6 +214,8 @@ extern struct sercom_uart_desc_t uart1_g;
 #define UART2_SERCOM_INST SERCOM3
 /* DMA Channel used for UART TX, DMA not used if not defined or defined as -1 */
 #define UART2_DMA_CHAN 16
+/* DMA Channel used for UART RX, DMA not used if not defined or defined as -1 */
+#define UART2_RX_DMA_CHAN 20
 /* Group number for UART TX pin */
 #define UART2_TX_PIN_GROUP 2
 /* Pin number for UART TX pin */
@@ -222,6 +228,8 @@ extern struct sercom_uart_desc_t uart2_g;
 #define UART3_SERCOM_INST SERCOM4
 /* DMA Channel used for UART TX, DMA not used if not defined or defined as -1 */
 #define UART3_DMA_CHAN 17
+/* DMA Channel used for UART RX, DMA not used if not defined or defined as -1 */
+#define UART3_RX_DMA_CHAN 21
 /* Group number for UART TX pin */
 #define UART3_TX_PIN_GROUP 1
 /* Pin number for UART TX pin */
@@ -314,6 +322,23 @@ extern struct kx134_1211_desc_t kx134_g;
 #endif
 
 
+//
+//
+//  Timebase
+//
+//
+
+/* Microsecond timebase enabled if defined */
+#define ENABLE_TIMEBASE
+/* Timer Counter used for timebase, the next Timer Counter is also used */
+#define TIMEBASE_TC TC2
+/* Pin for which interrupts are time stamped by hardware, not used if not
+   defined */
+#define TIMEBASE_CAPTURE_PIN KX134_1211_INT1_PIN
+/* Event channel used to capture TIMEBASE_CAPTURE_PIN */
+#define TIMEBASE_EVENT_CHAN 0
+
+
 //
 //
 // Temperature Sensor
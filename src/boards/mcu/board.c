@@ -22,6 +22,8 @@
 #include "usb-cdc.h"
 #include "wdt.h"
 #include "sdspi.h"
+#include "timebase.h"
+#include "scheduler.h"
 
 // MARK: Hardware Resources from Config File
 #ifdef ENABLE_SPI0
@@ -56,6 +58,138 @@ struct sdspi_desc_t sdspi_g;
 #endif
 
 
+// MARK: Scheduler Tasks
+#define STAT_PERIOD MS_TO_MILLIS(1500)
+/** Period at which the watchdog is patted, well within its timeout */
+#define WDT_PAT_PERIOD MS_TO_MILLIS(50)
+/** Period at which the IO expander's input pins are read */
+#define IO_EXPANDER_POLL_PERIOD MS_TO_MILLIS(100)
+/** Period at which the SD card driver is run to detect a card and check its
+    timeouts */
+#define SDSPI_TASK_PERIOD MS_TO_MILLIS(10)
+
+#ifdef ENABLE_WATCHDOG
+static struct sched_task_t wdt_task_g;
+
+static void wdt_task(void *context)
+{
+    // Pat the watchdog
+    wdt_pat();
+}
+#endif
+
+static struct sched_task_t debug_blink_task_g;
+
+static void debug_blink_task(void *context)
+{
+    gpio_toggle_output(DEBUG0_LED_PIN);
+}
+
+#if defined(STAT_R_LED_PIN) && defined(STAT_G_LED_PIN)
+static struct sched_task_t stat_blink_task_g;
+
+static void stat_blink_task(void *context)
+{
+    gpio_toggle_output(STAT_R_LED_PIN);
+    gpio_toggle_output(STAT_G_LED_PIN);
+}
+#endif
+
+#ifdef ENABLE_I2C0
+static struct sched_task_t i2c0_task_g;
+SCHED_TASK_FUNC(i2c_task, sercom_i2c_service, struct sercom_i2c_desc_t)
+#endif
+
+#if (defined(ENABLE_UART0) || defined(ENABLE_UART1) || \
+     defined(ENABLE_UART2) || defined(ENABLE_UART3))
+SCHED_TASK_FUNC(uart_task, sercom_uart_service, struct sercom_uart_desc_t)
+#endif
+#ifdef ENABLE_UART0
+static struct sched_task_t uart0_task_g;
+#endif
+#ifdef ENABLE_UART1
+static struct sched_task_t uart1_task_g;
+#endif
+#ifdef ENABLE_UART2
+static struct sched_task_t uart2_task_g;
+#endif
+#ifdef ENABLE_UART3
+static struct sched_task_t uart3_task_g;
+#endif
+
+#ifdef ENABLE_IO_EXPANDER
+static struct sched_task_t io_expander_task_g;
+SCHED_TASK_FUNC(io_expander_task, mcp23s17_service, struct mcp23s17_desc_t)
+#endif
+
+#ifdef ENABLE_ADC
+static struct sched_task_t adc_task_g;
+
+static void adc_task(void *context)
+{
+    adc_service();
+}
+#endif
+
+#ifdef ENABLE_SDSPI
+static struct sched_task_t sdspi_task_g;
+SCHED_TASK_FUNC(sdspi_task, sdspi_service, struct sdspi_desc_t)
+#endif
+
+/**
+ *  Add the service functions for board level drivers to the scheduler. Drivers
+ *  are run when one of their interrupts or callbacks signals that they have
+ *  work to do and periodically for anything that depends only on time. Data
+ *  received by DMA does not cause an interrupt, so the UARTs are run
+ *  periodically to notice it and wake the tasks which are waiting on them.
+ */
+static void init_board_tasks(void)
+{
+#ifdef ENABLE_WATCHDOG
+    sched_add_task(&wdt_task_g, wdt_task, NULL, "wdt", WDT_PAT_PERIOD, 0);
+#endif
+    sched_add_task(&debug_blink_task_g, debug_blink_task, NULL, "blink",
+                   DEBUG_BLINK_PERIOD, 0);
+#if defined(STAT_R_LED_PIN) && defined(STAT_G_LED_PIN)
+    sched_add_task(&stat_blink_task_g, stat_blink_task, NULL, "stat",
+                   STAT_PERIOD, 0);
+#endif
+#ifdef ENABLE_I2C0
+    sched_add_task(&i2c0_task_g, i2c_task, &i2c0_g, "i2c0", 0, 0);
+    sched_event_add_task(&i2c0_g.event, &i2c0_task_g);
+#endif
+#ifdef ENABLE_UART0
+    sched_add_task(&uart0_task_g, uart_task, &uart0_g, "uart0",
+                   SERCOM_UART_RX_SYNC_PERIOD, 0);
+#endif
+#ifdef ENABLE_UART1
+    sched_add_task(&uart1_task_g, uart_task, &uart1_g, "uart1",
+                   SERCOM_UART_RX_SYNC_PERIOD, 0);
+#endif
+#ifdef ENABLE_UART2
+    sched_add_task(&uart2_task_g, uart_task, &uart2_g, "uart2",
+                   SERCOM_UART_RX_SYNC_PERIOD, 0);
+#endif
+#ifdef ENABLE_UART3
+    sched_add_task(&uart3_task_g, uart_task, &uart3_g, "uart3",
+                   SERCOM_UART_RX_SYNC_PERIOD, 0);
+#endif
+#ifdef ENABLE_IO_EXPANDER
+    sched_add_task(&io_expander_task_g, io_expander_task, &io_expander_g,
+                   "io-exp", IO_EXPANDER_POLL_PERIOD, 0);
+    sched_event_add_task(&io_expander_g.spi_inst->event, &io_expander_task_g);
+#endif
+#ifdef ENABLE_ADC
+    sched_add_task(&adc_task_g, adc_task, NULL, "adc", ADC_PERIOD, 0);
+#endif
+#ifdef ENABLE_SDSPI
+    sched_add_task(&sdspi_task_g, sdspi_task, &sdspi_g, "sdspi",
+                   SDSPI_TASK_PERIOD, 0);
+    sched_event_add_task(&sdspi_g.spi_inst->event, &sdspi_task_g);
+#endif
+}
+
+
 // MARK: Functions
 static inline void init_io (void)
 {
@@ -166,40 +300,52 @@ void init_board(void)
 #ifdef ENABLE_UART0
 #ifndef UART0_DMA_CHAN
 #define UART0_DMA_CHAN -1
+#endif
+#ifndef UART0_RX_DMA_CHAN
+#define UART0_RX_DMA_CHAN -1
 #endif
     init_sercom_uart(&uart0_g, UART0_SERCOM_INST, UART0_BAUD, F_CPU,
-                     SAMD21_CLK_MSK_48MHZ, UART0_DMA_CHAN, UART0_ECHO,
-                     UART0_TX_PIN_GROUP, UART0_TX_PIN_NUM);
+                     SAMD21_CLK_MSK_48MHZ, UART0_DMA_CHAN, UART0_RX_DMA_CHAN,
+                     UART0_ECHO, UART0_TX_PIN_GROUP, UART0_TX_PIN_NUM);
 #endif
 
     // Init UART 1
 #ifdef ENABLE_UART1
 #ifndef UART1_DMA_CHAN
 #define UART1_DMA_CHAN -1
+#endif
+#ifndef UART1_RX_DMA_CHAN
+#define UART1_RX_DMA_CHAN -1
 #endif
     init_sercom_uart(&uart1_g, UART1_SERCOM_INST, UART1_BAUD, F_CPU,
-                     SAMD21_CLK_MSK_48MHZ, UART1_DMA_CHAN, UART1_ECHO,
-                     UART1_TX_PIN_GROUP, UART1_TX_PIN_NUM);
+                     SAMD21_CLK_MSK_48MHZ, UART1_DMA_CHAN, UART1_RX_DMA_CHAN,
+                     UART1_ECHO, UART1_TX_PIN_GROUP, UART1_TX_PIN_NUM);
 #endif
 
     // Init UART 2
 #ifdef ENABLE_UART2
 #ifndef UART2_DMA_CHAN
 #define UART2_DMA_CHAN -1
+#endif
+#ifndef UART2_RX_DMA_CHAN
+#define UART2_RX_DMA_CHAN -1
 #endif
     init_sercom_uart(&uart2_g, UART2_SERCOM_INST, UART2_BAUD, F_CPU,
-                     SAMD21_CLK_MSK_48MHZ, UART2_DMA_CHAN, UART2_ECHO,
-                     UART2_TX_PIN_GROUP, UART2_TX_PIN_NUM);
+                     SAMD21_CLK_MSK_48MHZ, UART2_DMA_CHAN, UART2_RX_DMA_CHAN,
+                     UART2_ECHO, UART2_TX_PIN_GROUP, UART2_TX_PIN_NUM);
 #endif
 
     // Init UART 3
 #ifdef ENABLE_UART3
 #ifndef UART3_DMA_CHAN
 #define UART3_DMA_CHAN -1
+#endif
+#ifndef UART3_RX_DMA_CHAN
+#define UART3_RX_DMA_CHAN -1
 #endif
     init_sercom_uart(&uart3_g, UART3_SERCOM_INST, UART3_BAUD, F_CPU,
-                     SAMD21_CLK_MSK_48MHZ, UART3_DMA_CHAN, UART3_ECHO,
-                     UART3_TX_PIN_GROUP, UART3_TX_PIN_NUM);
+                     SAMD21_CLK_MSK_48MHZ, UART3_DMA_CHAN, UART3_RX_DMA_CHAN,
+                     UART3_ECHO, UART3_TX_PIN_GROUP, UART3_TX_PIN_NUM);
 #endif
 
     // Init ADC
@@ -233,8 +379,8 @@ void init_board(void)
 
     // GPIO
 #ifdef ENABLE_IO_EXPANDER
-    init_mcp23s17(&io_expander_g, 0, &spi0_g, 100, IO_EXPANDER_CS_PIN_MASK,
-                  IO_EXPANDER_CS_PIN_GROUP);
+    init_mcp23s17(&io_expander_g, 0, &spi0_g, IO_EXPANDER_POLL_PERIOD,
+                  IO_EXPANDER_CS_PIN_MASK, IO_EXPANDER_CS_PIN_GROUP);
 #ifdef ENABLE_LORA
     init_gpio(SAMD21_CLK_MSK_48MHZ, &io_expander_g, IO_EXPANDER_INT_PIN,
               radios_g);
@@ -265,6 +411,11 @@ void init_board(void)
     gpio_set_pin_mode(STAT_B_LED_PIN, GPIO_PIN_OUTPUT_STRONG);
 #endif
 
+    // Microsecond timebase
+#ifdef ENABLE_TIMEBASE
+    init_timebase(TIMEBASE_TC, SAMD21_CLK_MSK_1MHZ, 1000000UL);
+#endif
+
 #ifdef ENABLE_SDSPI
     init_sdpsi(&sdspi_g, &spi0_g, SDSPI_CS_PIN_MASK, SDSPI_CS_PIN_GROUP,
                SDSPI_DETECT_PIN);
@@ -273,65 +424,6 @@ void init_board(void)
 #ifdef ENABLE_WATCHDOG
     init_wdt(SAMD21_CLK_MSK_8KHZ, 14, 0);
 #endif
-}
-
-
-
-#define STAT_PERIOD MS_TO_MILLIS(1500)
-
-void board_service(void)
-{
-#ifdef ENABLE_WATCHDOG
-    // Pat the watchdog
-    wdt_pat();
-#endif
-
-    static uint32_t last_debug_blink_time = 0;
-    if ((millis - last_debug_blink_time) >= DEBUG_BLINK_PERIOD) {
-        last_debug_blink_time = millis;
-        gpio_toggle_output(DEBUG0_LED_PIN);
-    }
-
-#ifdef STAT_R_LED_PIN
-#ifdef STAT_G_LED_PIN
-    static uint32_t last_stat_blink_time = 0;
-    if (((millis - last_stat_blink_time) >= STAT_PERIOD)) {
-        last_stat_blink_time = millis;
-        gpio_toggle_output(STAT_R_LED_PIN);
-        gpio_toggle_output(STAT_G_LED_PIN);
-    }
-#endif
-#endif
-
-#ifdef ENABLE_I2C0
-    sercom_i2c_service(&i2c0_g);
-#endif
 
-#ifdef ENABLE_UART0
-    sercom_uart_service(&uart0_g);
-#endif
-
-#ifdef ENABLE_UART1
-    sercom_uart_service(&uart1_g);
-#endif
-
-#ifdef ENABLE_UART2
-    sercom_uart_service(&uart2_g);
-#endif
-
-#ifdef ENABLE_UART3
-    sercom_uart_service(&uart3_g);
-#endif
-
-#ifdef ENABLE_IO_EXPANDER
-    mcp23s17_service(&io_expander_g);
-#endif
-
-#ifdef ENABLE_ADC
-    adc_service();
-#endif
-
-#ifdef ENABLE_SDSPI
-    sdspi_service(&sdspi_g);
-#endif
+    init_board_tasks();
 }
@@ -156,6 +156,8 @@ extern struct sercom_i2c_desc_t i2c0_g;
 #define UART0_SERCOM_INST SERCOM0
 /* DMA Channel used for UART TX, DMA not used if not defined or defined as -1 */
 #define UART0_DMA_CHAN 7
+/* DMA Channel used for UART RX, DMA not used if not defined or defined as -1 */
+#define UART0_RX_DMA_CHAN 0
 /* Group number for UART TX pin */
 #define UART0_TX_PIN_GROUP 0
 /* Pin number for UART TX pin */
@@ -168,6 +170,8 @@ extern struct sercom_uart_desc_t uart0_g;
 #define UART1_SERCOM_INST SERCOM1
 /* DMA Channel used for UART TX, DMA not used if not defined or defined as -1 */
 #define UART1_DMA_CHAN 8
+/* DMA Channel used for UART RX, DMA not used if not defined or defined as -1 */
+#define UART1_RX_DMA_CHAN 1
 /* Group number for UART TX pin */
 #define UART1_TX_PIN_GROUP 0
 /* Pin number for UART TX pin */
@@ -180,6 +184,8 @@ extern struct sercom_uart_desc_t uart1_g;
 #define UART2_SERCOM_INST SERCOM2
 /* DMA Channel used for UART TX, DMA not used if not defined or defined as -1 */
 #define UART2_DMA_CHAN 9
+/* DMA Channel used for UART RX, DMA not used if not defined or defined as -1 */
+#define UART2_RX_DMA_CHAN 2
 /* Group number for UART TX pin */
 #define UART2_TX_PIN_GROUP 0
 /* Pin number for UART TX pin */
@@ -192,6 +198,8 @@ extern struct sercom_uart_desc_t uart2_g;
 #define UART3_SERCOM_INST SERCOM3
 /* DMA Channel used for UART TX, DMA not used if not defined or defined as -1 */
 #define UART3_DMA_CHAN 10
+/* DMA Channel used for UART RX, DMA not used if not defined or defined as -1 */
+#define UART3_RX_DMA_CHAN 3
 /* Group number for UART TX pin */
 #define UART3_TX_PIN_GROUP 0
 /* Pin number for UART TX pin */
@@ -243,4 +251,15 @@ extern struct mcp23s17_desc_t io_expander_g;
 extern struct sdspi_desc_t sdspi_g;
 #endif
 
+//
+//
+//  Timebase
+//
+//
+
+/* Microsecond timebase enabled if defined */
+#define ENABLE_TIMEBASE
+/* Timer Counter used for timebase, the next Timer Counter is also used */
+#define TIMEBASE_TC TC4
+
 #endif /* board_h */
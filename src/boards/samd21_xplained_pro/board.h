@@ -204,4 +204,15 @@ extern struct sercom_uart_desc_t uart3_g;
 /* Maximum impedance of source in ohms, see figure 37-5 in SAMD21 datasheet */
 #define ADC_SOURCE_IMPEDANCE 100000
 
+//
+//
+//  Timebase
+//
+//
+
+/* Microsecond timebase enabled if defined */
+#define ENABLE_TIMEBASE
+/* Timer Counter used for timebase, the next Timer Counter is also used */
+#define TIMEBASE_TC TC4
+
 #endif /* board_h */
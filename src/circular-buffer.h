@@ -22,6 +22,16 @@ struct circular_buffer_t {
     uint16_t head;
     uint16_t tail;
     uint16_t length;
+
+    /** Number of bytes after the head which have been scanned for lines and
+        delimiters */
+    uint16_t scanned;
+    /** Number of "\r\n" sequences in the scanned part of the buffer */
+    uint16_t line_count;
+    /** Number of delimiter characters in the scanned part of the buffer */
+    uint16_t delim_count;
+    /** The delimiter character which is being counted */
+    uint8_t delim;
 };
 
 
@@ -41,6 +51,89 @@ static inline void init_circular_buffer(struct circular_buffer_t *buffer,
     buffer->head = 0;
     buffer->tail = 0;
     buffer->length = 0;
+
+    buffer->scanned = 0;
+    buffer->line_count = 0;
+    buffer->delim_count = 0;
+    buffer->delim = '\0';
+}
+
+/**
+ *  Remove the item at the head of a circular buffer from the line and delimiter
+ *  counts. Must be called with interrupts disabled before the head is moved
+ *  forward, and only while the item at the head is still the item which was
+ *  scanned.
+ *
+ *  @param buffer The circular buffer for which the head is being removed.
+ */
+static inline void circular_buffer_unscan_head(struct circular_buffer_t *buffer)
+{
+    if (buffer->scanned == 0) {
+        return;
+    }
+
+    uint8_t const c = buffer->buffer[buffer->head];
+    if (c == buffer->delim) {
+        buffer->delim_count--;
+    }
+    // A newline following this carriage return is no longer part of a line
+    // ending once the carriage return is gone
+    if ((c == '\r') && (buffer->scanned > 1) &&
+            (buffer->buffer[(buffer->head + 1) % buffer->capacity] == '\n')) {
+        buffer->line_count--;
+    }
+
+    buffer->scanned--;
+}
+
+/**
+ *  Discard the line and delimiter counts for a circular buffer so that the
+ *  whole buffer is scanned again from the head on the next check. Must be used
+ *  instead of removing items from the counts when the items after the head are
+ *  no longer the ones which were scanned, for example because a DMA transfer
+ *  has overwritten them.
+ *
+ *  @param buffer The circular buffer which should be scanned again.
+ */
+static inline void circular_buffer_rescan_from_head(
+                                            struct circular_buffer_t *buffer)
+{
+    profiler_disable_irq();
+
+    buffer->scanned = 0;
+    buffer->line_count = 0;
+    buffer->delim_count = 0;
+
+    profiler_enable_irq();
+}
+
+/**
+ *  Scan any items in a circular buffer which have not yet been scanned and
+ *  update the line and delimiter counts. Each item is only scanned once, so the
+ *  cost of checking for lines is proportional to the amount of new data rather
+ *  than the amount of data in the buffer. Must be called with interrupts
+ *  disabled.
+ *
+ *  @param buffer The circular buffer which should be scanned.
+ */
+static inline void circular_buffer_scan(struct circular_buffer_t *buffer)
+{
+    uint16_t prev = (buffer->head + buffer->scanned + buffer->capacity - 1) %
+                        buffer->capacity;
+    for (; buffer->scanned < buffer->length; buffer->scanned++) {
+        uint16_t const i = (prev + 1) % buffer->capacity;
+        uint8_t const c = buffer->buffer[i];
+
+        if (c == buffer->delim) {
+            buffer->delim_count++;
+        }
+        if ((c == '\n') && (buffer->scanned != 0) &&
+                (buffer->buffer[prev] == '\r')) {
+            buffer->line_count++;
+        }
+
+        prev = i;
+    }
 }
 
 /**
@@ -106,10 +199,11 @@ static inline uint16_t circular_buffer_capacity(struct circular_buffer_t *buffer
 static inline void circular_buffer_push(struct circular_buffer_t *buffer,
                                         uint8_t value)
 {
-    __disable_irq();
+    profiler_disable_irq();
     
     // If the buffer is full, don't let the tail pass the head
     if (circular_buffer_is_full(buffer)) {
+        circular_buffer_unscan_head(buffer);
         buffer->head = (buffer->head + 1) % buffer->capacity;
     } else {
         buffer->length++;
@@ -118,7 +212,7 @@ static inline void circular_buffer_push(struct circular_buffer_t *buffer,
     buffer->buffer[buffer->tail] = value;
     buffer->tail = (buffer->tail + 1) % buffer->capacity;
     
-    __enable_irq();
+    profiler_enable_irq();
 }
 
 /**
@@ -156,13 +250,14 @@ static inline int circular_buffer_pop(struct circular_buffer_t *buffer,
     if (circular_buffer_is_empty(buffer)) {
         return 1;
     } else {
-        __disable_irq();
+        profiler_disable_irq();
         
+        circular_buffer_unscan_head(buffer);
         *value = buffer->buffer[buffer->head];
         buffer->head = (buffer->head + 1) % buffer->capacity;
         buffer->length--;
         
-        __enable_irq();
+        profiler_enable_irq();
         return 0;
     }
 }
@@ -196,39 +291,87 @@ static inline uint16_t circular_buffer_get_head(struct circular_buffer_t *buffer
  *  buffer would be moved past the tail, the head will be moved up to match the
  *  tail.
  *
+ *  @note The bytes being removed are taken out of the line and delimiter counts
+ *        one by one, so they must still be the bytes which were scanned. This
+ *        function must not be used on its own to drop bytes which have been
+ *        overwritten behind the buffer's back (for example by a DMA transfer
+ *        that has overrun the head), call circular_buffer_rescan_from_head()
+ *        first in that case.
+ *
  *  @param buffer The circular buffer for which the head should be moved.
  *  @param length The distance which the head should be moved.
  */
 static inline void circular_buffer_move_head(struct circular_buffer_t *buffer,
                                              uint16_t length)
 {
-    __disable_irq();
+    profiler_disable_irq();
     
-    if (circular_buffer_is_empty(buffer)) {
-        __enable_irq();
-        return;
-    } else if (buffer->head < buffer->tail) {
-        if (buffer->head + length < buffer->tail) {
-            buffer->head += length;
-            buffer->length -= length;
-        } else {
-            buffer->head = buffer->tail;
-            buffer->length = 0;
-        }
-    } else {
-        if (buffer->head + length < buffer->capacity) {
-            buffer->head += length;
-            buffer->length -= length;
-        } else if (((buffer->head + length) % buffer->capacity) < buffer->tail) {
-            buffer->head = (buffer->head + length) % buffer->capacity;
-            buffer->length -= length;
-        } else {
-            buffer->head = buffer->tail;
-            buffer->length = 0;
-        }
+    if (length > buffer->length) {
+        length = buffer->length;
+    }
+
+    // Remove any scanned items from the line and delimiter counts
+    uint16_t const unscan = (length < buffer->scanned) ? length :
+                                                         buffer->scanned;
+    for (uint16_t i = 0; i < unscan; i++) {
+        circular_buffer_unscan_head(buffer);
+        buffer->head = (buffer->head + 1) % buffer->capacity;
     }
+
+    buffer->head = (uint16_t)((buffer->head + length - unscan) %
+                              buffer->capacity);
+    buffer->length -= length;
     
-    __enable_irq();
+    profiler_enable_irq();
+}
+
+/**
+ *  Get a pointer to the tail of the buffer and the number of contiguous unused
+ *  bytes following the pointer. Data can be written directly into this space
+ *  and then added to the buffer with circular_buffer_move_tail().
+ *
+ *  @param buffer The circular buffer for which the tail should be found.
+ *  @param tail Pointer where a pointer to the tail will be placed.
+ *
+ *  @return The number of contiguous unused bytes in the buffer after the tail.
+ */
+static inline uint16_t circular_buffer_get_tail(struct circular_buffer_t *buffer,
+                                                uint8_t **tail)
+{
+    *tail = buffer->buffer + buffer->tail;
+
+    if (circular_buffer_is_full(buffer)) {
+        return 0;
+    } else if (buffer->tail >= buffer->head) {
+        return buffer->capacity - buffer->tail;
+    } else {
+        return buffer->head - buffer->tail;
+    }
+}
+
+/**
+ *  Move the tail of the buffer forwards by a certain number of bytes. This has
+ *  the effect of adding `length` bytes, which have already been written after
+ *  the tail, to the buffer. If the tail would be moved past the head, the tail
+ *  will be moved up to match the head.
+ *
+ *  @param buffer The circular buffer for which the tail should be moved.
+ *  @param length The distance which the tail should be moved.
+ */
+static inline void circular_buffer_move_tail(struct circular_buffer_t *buffer,
+                                             uint16_t length)
+{
+    profiler_disable_irq();
+
+    uint16_t const unused = circular_buffer_unused(buffer);
+    if (length > unused) {
+        length = unused;
+    }
+
+    buffer->tail = (uint16_t)((buffer->tail + length) % buffer->capacity);
+    buffer->length += length;
+
+    profiler_enable_irq();
 }
 
 /**
@@ -263,15 +406,31 @@ static inline int circular_buffer_unpush(struct circular_buffer_t *buffer)
     if (circular_buffer_is_empty(buffer)) {
         return 1;
     } else {
-        __disable_irq();
+        profiler_disable_irq();
 
         if (buffer->tail == 0) {
             buffer->tail = buffer->capacity;
         }
         buffer->tail--;
+
+        if (buffer->scanned == buffer->length) {
+            // Remove the item from the line and delimiter counts
+            uint8_t const c = buffer->buffer[buffer->tail];
+            uint16_t const prev = ((buffer->tail + buffer->capacity - 1) %
+                                   buffer->capacity);
+            if (c == buffer->delim) {
+                buffer->delim_count--;
+            }
+            if ((c == '\n') && (buffer->length > 1) &&
+                    (buffer->buffer[prev] == '\r')) {
+                buffer->line_count--;
+            }
+            buffer->scanned--;
+        }
+
         buffer->length--;
         
-        __enable_irq();
+        profiler_enable_irq();
         return 0;
     }
 }
@@ -288,20 +447,26 @@ static inline int circular_buffer_unpush(struct circular_buffer_t *buffer)
 static inline int circular_buffer_has_char(struct circular_buffer_t *buffer,
                                            char c)
 {
-    if (circular_buffer_is_empty(buffer)) {
-        return 0;
-    }
-    
-    uint16_t i = buffer->head;
-    do {
-        if (buffer->buffer[i] == c) {
-            return 1;
+    profiler_disable_irq();
+
+    if ((uint8_t)c != buffer->delim) {
+        // Count the new delimiter in the part of the buffer which has
+        // already been scanned
+        buffer->delim = (uint8_t)c;
+        buffer->delim_count = 0;
+        for (uint16_t i = 0; i < buffer->scanned; i++) {
+            if (buffer->buffer[(buffer->head + i) % buffer->capacity] ==
+                    buffer->delim) {
+                buffer->delim_count++;
+            }
         }
-        
-        i = ((i + 1) % buffer->capacity);
-    } while (i != buffer->tail);
-    
-    return 0;
+    }
+
+    circular_buffer_scan(buffer);
+    int const ret = buffer->delim_count != 0;
+
+    profiler_enable_irq();
+    return ret;
 }
 
 /**
@@ -314,23 +479,13 @@ static inline int circular_buffer_has_char(struct circular_buffer_t *buffer,
  */
 static inline int circular_buffer_has_line(struct circular_buffer_t *buffer)
 {
-    if (circular_buffer_is_empty(buffer)) {
-        return 0;
-    }
-    
-    uint16_t i = buffer->head;
-    do {
-        if (buffer->buffer[i] == '\r') {
-            uint16_t next = (i + 1) % buffer->capacity;
-            if ((next != buffer->tail) && (buffer->buffer[next] == '\n')) {
-                return 1;
-            }
-        }
-        
-        i = ((i + 1) % buffer->capacity);
-    } while (i != buffer->tail);
-    
-    return 0;
+    profiler_disable_irq();
+
+    circular_buffer_scan(buffer);
+    int const ret = buffer->line_count != 0;
+
+    profiler_enable_irq();
+    return ret;
 }
 
 /**
@@ -343,6 +498,10 @@ static inline void circular_buffer_clear(struct circular_buffer_t *buffer)
     buffer->head = 0;
     buffer->tail = 0;
     buffer->length = 0;
+
+    buffer->scanned = 0;
+    buffer->line_count = 0;
+    buffer->delim_count = 0;
 }
 
 #endif /* circular_buffer_h */
@@ -20,6 +20,8 @@
 #include "wdt.h"
 #include "sercom-i2c.h"
 #include "sercom-spi.h"
+#include "scheduler.h"
+#include "profiler.h"
 
 // MARK: Version
 
@@ -632,3 +634,130 @@ void debug_gpio (uint8_t argc, char **argv, struct console_desc_t *console)
         console_send_str(console, "\" is not a valid command.\n");
     }
 }
+
+// MARK: Profile
+
+/**
+ *  Print a value right aligned in a field of the given width.
+ */
+static void debug_profile_print_field(struct console_desc_t *console,
+                                      uint32_t value, uint8_t width)
+{
+    char str[11];
+    utoa(value, str, 10);
+    for (size_t i = strlen(str); i < width; i++) {
+        console_send_str(console, " ");
+    }
+    console_send_str(console, str);
+}
+
+/**
+ *  Print a name left aligned in a field of the given width.
+ */
+static void debug_profile_print_name(struct console_desc_t *console,
+                                     const char *name, uint8_t width)
+{
+    console_send_str(console, name);
+    for (size_t i = strlen(name); i < width; i++) {
+        console_send_str(console, " ");
+    }
+}
+
+/**
+ *  Print the summary statistics and non-empty histogram buckets for a
+ *  histogram.
+ *
+ *  @param console Console to print to
+ *  @param name Name of the measured quantity
+ *  @param hist The histogram
+ *  @param cycles Non-zero if the histogram values are in CPU cycles rather
+ *                than profiler ticks
+ */
+static void debug_profile_print_hist(struct console_desc_t *console,
+                                     const char *name,
+                                     const struct profiler_hist_t *hist,
+                                     uint8_t cycles)
+{
+    uint32_t (*const to_ns)(uint32_t) = (cycles ? profiler_cycles_to_ns :
+                                         profiler_ticks_to_ns);
+
+    debug_profile_print_name(console, name, 8);
+    debug_profile_print_field(console, hist->count, 10);
+    debug_profile_print_field(console, to_ns(hist->min), 12);
+    debug_profile_print_field(console, to_ns(profiler_hist_mean(hist)), 12);
+    debug_profile_print_field(console, to_ns(hist->max), 12);
+    console_send_str(console, "\n");
+
+    for (uint8_t i = 0; i < PROFILER_HIST_BUCKETS; i++) {
+        if (hist->buckets[i] == 0) {
+            continue;
+        }
+        if (i == (PROFILER_HIST_BUCKETS - 1)) {
+            console_send_str(console, "      >= ");
+        } else {
+            console_send_str(console, "       < ");
+        }
+        uint32_t const bound = 1UL << (i + PROFILER_HIST_SHIFT -
+                                (i == (PROFILER_HIST_BUCKETS - 1)));
+        debug_profile_print_field(console, to_ns(bound), 10);
+        console_send_str(console, " ns: ");
+        debug_profile_print_field(console, hist->buckets[i], 0);
+        console_send_str(console, "\n");
+    }
+}
+
+void debug_profile (uint8_t argc, char **argv, struct console_desc_t *console)
+{
+    if (argc == 2 && !strcmp(argv[1], "clear")) {
+        profiler_clear();
+        sched_clear_stats();
+        return;
+    } else if (argc == 2 && !strcmp(argv[1], "log")) {
+#ifdef ENABLE_LOGGING
+        if (profiler_log(&logging_g) != 0) {
+            console_send_str(console, "Could not log profile.\n");
+        }
+#else
+        console_send_str(console, "Logging is not enabled.\n");
+#endif
+        return;
+    } else if (argc != 1) {
+        console_send_str(console, DEBUG_PROFILE_HELP);
+        console_send_str(console, "\n");
+        return;
+    }
+
+    const struct sched_stats_t *const stats = sched_get_stats();
+
+#ifndef ENABLE_PROFILER
+    console_send_str(console, "Build with PROFILE=1 for isr-lat and irq-off "
+                              "statistics.\n");
+#endif
+    console_send_str(console, "            count    min (ns)    avg (ns)"
+                              "    max (ns)\n");
+    debug_profile_print_hist(console, "isr-lat", &profiler_isr_latency_g, 1);
+    debug_profile_print_hist(console, "irq-off", &profiler_irq_off_g, 0);
+    debug_profile_print_hist(console, "loop", &stats->pass_time, 0);
+
+    console_send_str(console, "Sleep: ");
+    debug_profile_print_field(console,
+                              (uint32_t)((stats->sleep_time * 1000) /
+                                         PROFILER_TICK_FREQ), 0);
+    console_send_str(console, " ms\n\ntask          runs    min (us)"
+                              "    avg (us)    max (us)\n");
+
+    for (struct sched_task_t *t = sched_get_tasks(); t != NULL; t = t->next) {
+        debug_profile_print_name(console, t->name, 8);
+        debug_profile_print_field(console, t->run_time.count, 10);
+        debug_profile_print_field(console,
+                                  profiler_ticks_to_ns(t->run_time.min) / 1000,
+                                  12);
+        debug_profile_print_field(console, profiler_ticks_to_ns(
+                                    profiler_hist_mean(&t->run_time)) / 1000,
+                                  12);
+        debug_profile_print_field(console,
+                                  profiler_ticks_to_ns(t->run_time.max) / 1000,
+                                  12);
+        console_send_str(console, "\n");
+    }
+}
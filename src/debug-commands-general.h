@@ -67,4 +67,12 @@ extern void debug_io_exp_regs (uint8_t argc, char **argv,
 extern void debug_gpio (uint8_t argc, char **argv,
                         struct console_desc_t *console);
 
+
+#define DEBUG_PROFILE_NAME  "profile"
+#define DEBUG_PROFILE_HELP  "Print interrupt latency and main loop run time "\
+                            "statistics.\nUsage: profile [clear|log]"
+
+extern void debug_profile (uint8_t argc, char **argv,
+                           struct console_desc_t *console);
+
 #endif /* debug_commands_general_h */
@@ -86,6 +86,41 @@ static void print_enabled_antennas(struct console_desc_t *console,
     }
 }
 
+static void print_antenna_stats(struct console_desc_t *console,
+                                const struct radio_antmgr_desc *antmgr)
+{
+    char str[16];
+
+    for (uint8_t i = 0; i < RADIO_MAX_NUM_ANTENNAS; i++) {
+        if (!(antmgr->antenna_mask & (1 << i))) {
+            continue;
+        }
+        console_send_str(console, "\n\t\tAntenna ");
+        utoa(i + 1, str, 10);
+        console_send_str(console, str);
+        console_send_str(console, ":\n\t\t\tPackets: ");
+        utoa(antmgr->rx_packets[i], str, 10);
+        console_send_str(console, str);
+        console_send_str(console, "\n\t\t\tAvg. RSSI: ");
+        itoa(antmgr->avg_rssi[i], str, 10);
+        console_send_str(console, str);
+        console_send_str(console, " dBm\n\t\t\tAvg. RX loss: ");
+        itoa(antmgr->avg_rx_power_loss[i], str, 10);
+        console_send_str(console, str);
+        console_send_str(console, " dBm\n\t\t\tAvg. TX loss: ");
+        itoa(antmgr->avg_tx_power_loss[i], str, 10);
+        console_send_str(console, str);
+        console_send_str(console, " dBm\n\t\t\tLast RX: ");
+        if (antmgr->rx_packets[i] == 0) {
+            console_send_str(console, "never");
+        } else {
+            utoa(millis - antmgr->last_rx_time[i], str, 10);
+            console_send_str(console, str);
+            console_send_str(console, " ms ago");
+        }
+    }
+}
+
 void debug_radio_info (uint8_t argc, char **argv,
                        struct console_desc_t *console)
 {
@@ -106,6 +141,43 @@ void debug_radio_info (uint8_t argc, char **argv,
     console_send_str(console, str);
     console_send_str(console, " milliseconds ago)\n");
 
+    // Transmit statistics
+    const uint32_t stats_secs = ((millis -
+                                  radio_transport_g.tx_stats_start_time) /
+                                 1000);
+    console_send_str(console, "\nTX airtime: ");
+    utoa(radio_transport_g.tx_airtime, str, 10);
+    console_send_str(console, str);
+    console_send_str(console, " ms in the last ");
+    utoa(stats_secs, str, 10);
+    console_send_str(console, str);
+    console_send_str(console, " seconds\nBlock bytes per second of airtime: ");
+    utoa((radio_transport_g.tx_airtime == 0) ? 0 :
+         ((radio_transport_g.tx_block_bytes * 1000) /
+          radio_transport_g.tx_airtime), str, 10);
+    console_send_str(console, str);
+    console_send_str(console, "\nData block rates (blocks per minute):");
+    for (unsigned int i = 0; i < RADIO_DATA_BLOCK_NUM_SUBTYPES; i++) {
+        const struct radio_trans_tx_stats *const stats =
+                                                &radio_transport_g.tx_stats[i];
+        if ((stats->requested == 0) || (stats_secs == 0)) {
+            continue;
+        }
+        console_send_str(console, "\n\tSubtype 0x");
+        utoa(i, str, 16);
+        console_send_str(console, str);
+        console_send_str(console, ": requested ");
+        utoa((stats->requested * 60) / stats_secs, str, 10);
+        console_send_str(console, str);
+        console_send_str(console, ", sent ");
+        utoa((stats->sent * 60) / stats_secs, str, 10);
+        console_send_str(console, str);
+        console_send_str(console, ", dropped ");
+        utoa((stats->dropped * 60) / stats_secs, str, 10);
+        console_send_str(console, str);
+    }
+    console_send_str(console, "\n");
+
     // Radio instances
     for (struct radio_instance_desc *const *radio_p = radios_g;
                 *radio_p != NULL; radio_p++) {
@@ -122,6 +194,18 @@ void debug_radio_info (uint8_t argc, char **argv,
         utoa((*radio_p)->rn2483.state, str, 16);
         console_send_str(console, str);
 
+        // Channel
+        console_send_str(console, "\n\tChannel: ");
+        utoa((*radio_p)->channel, str, 10);
+        console_send_str(console, str);
+        console_send_str(console, " (");
+        utoa((*radio_p)->settings.freq, str, 10);
+        console_send_str(console, str);
+        console_send_str(console, " Hz)");
+        if ((*radio_p)->tx_busy) {
+            console_send_str(console, ", transmitting");
+        }
+
         // Link performance
         console_send_str(console, "\n\tLink performance:\n\t\tAvg. RX loss: ");
         itoa((*radio_p)->avg_rx_power_loss, str, 10);
@@ -146,6 +230,16 @@ void debug_radio_info (uint8_t argc, char **argv,
             console_send_str(console, "\n\t\tCurrent antenna: ");
             utoa(radio_antmgr_get_current_antenna(*radio_p), str, 10);
             console_send_str(console, str);
+            console_send_str(console, "\n\t\tBest antenna: ");
+            utoa((*radio_p)->antmgr->best_antenna, str, 10);
+            console_send_str(console, str);
+            console_send_str(console, "\n\t\tSwitches: ");
+            utoa((*radio_p)->antmgr->num_switches, str, 10);
+            console_send_str(console, str);
+            console_send_str(console, "\n\t\tProbes: ");
+            utoa((*radio_p)->antmgr->num_probes, str, 10);
+            console_send_str(console, str);
+            print_antenna_stats(console, (*radio_p)->antmgr);
         }
 
         wdt_pat();
@@ -222,6 +316,51 @@ void debug_radio_info (uint8_t argc, char **argv,
     utoa(radio_transport_g.radio_settings.sync_byte, str, 16);
     console_send_str(console, str);
 
+    // Link control
+    console_send_str(console, "\n\nLink Control:\n\tProfile: ");
+    utoa(radio_transport_g.link.profile, str, 10);
+    console_send_str(console, str);
+    if (radio_transport_g.link.pending) {
+        console_send_str(console, " (changing to ");
+        utoa(radio_transport_g.link.pending_profile, str, 10);
+        console_send_str(console, str);
+        console_send_str(console, ")");
+    }
+    console_send_str(console, "\n\tAvg. local SNR: ");
+    itoa(radio_transport_g.link.avg_local_snr, str, 10);
+    console_send_str(console, str);
+    console_send_str(console, " dB\n\tAvg. remote SNR: ");
+    itoa(radio_transport_g.link.avg_remote_snr, str, 10);
+    console_send_str(console, str);
+    console_send_str(console, " dB\n\tProfile changes: ");
+    utoa(radio_transport_g.link.num_changes, str, 10);
+    console_send_str(console, str);
+
+    // Erasure coding
+    const struct radio_fec_desc *const fec = radio_transport_g.fec;
+    if (fec != NULL) {
+        console_send_str(console, "\n\nErasure Coding:\n\tData packets: ");
+        utoa(fec->data_packets, str, 10);
+        console_send_str(console, str);
+        console_send_str(console, "\n\tParity packets: ");
+        utoa(fec->parity_packets, str, 10);
+        console_send_str(console, str);
+        if (fec->pending) {
+            console_send_str(console, " (requested)");
+        } else if (!fec->confirmed) {
+            console_send_str(console, " (not confirmed)");
+        }
+        console_send_str(console, "\n\tGroups: ");
+        utoa(fec->num_groups, str, 10);
+        console_send_str(console, str);
+        console_send_str(console, "\n\tRecovered packets: ");
+        utoa(fec->num_recovered, str, 10);
+        console_send_str(console, str);
+        console_send_str(console, "\n\tUnrecoverable packets: ");
+        utoa(fec->num_unrecoverable, str, 10);
+        console_send_str(console, str);
+    }
+
     console_send_str(console, "\n");
     return;
 }
@@ -420,5 +559,6 @@ void debug_radio_tx (uint8_t argc, char **argv, struct console_desc_t *console)
                                RADIO_DEVICE_ADDRESS_MULTICAST,
                                RADIO_BLOCK_TYPE_DATA,
                                RADIO_DATA_BLOCK_DEBUG);
-    radio_send_block(&radio_transport_g, block, block_length, 0, 0);
+    radio_send_block(&radio_transport_g, block, block_length, 0, 0,
+                     RADIO_BLOCK_PRIORITY_NORMAL);
 }
@@ -775,15 +775,30 @@ void debug_logging(uint8_t argc, char **argv, struct console_desc_t *console)
         utoa(logging_g.sb.flights[logging_g.flight].num_blocks, str, 10);
         console_send_str(console, str);
 
-        // Current buffer
+        // Cursors
+        uint32_t const cursor = logging_g.prod_cursor;
         console_send_str(console, "\n\nCurrent buffer: ");
-        if (logging_g.insert_point == NULL) {
-            console_send_str(console, "none");
-        } else {
-            uintptr_t buf = ((uintptr_t)logging_g.insert_point) & 0x3;
-            utoa(buf, str, 10);
-            console_send_str(console, str);
-        }
+        utoa(LOGGING_BUF_IDX(LOGGING_CURSOR_SEQ(cursor)), str, 10);
+        console_send_str(console, str);
+        console_send_str(console, " (sequence ");
+        utoa(LOGGING_CURSOR_SEQ(cursor), str, 10);
+        console_send_str(console, str);
+        console_send_str(console, ")\nInsert point: buffer + ");
+        utoa(LOGGING_CURSOR_OFFSET(cursor), str, 10);
+        console_send_str(console, str);
+        console_send_str(console, "\nNext buffer to write: ");
+        utoa(LOGGING_BUF_IDX(logging_g.cons_cursor), str, 10);
+        console_send_str(console, str);
+        console_send_str(console, " (sequence ");
+        utoa(logging_g.cons_cursor, str, 10);
+        console_send_str(console, str);
+        console_send_str(console, ")\nBuffers closed: ");
+        utoa((uint16_t)(LOGGING_CURSOR_SEQ(cursor) - logging_g.cons_cursor),
+             str, 10);
+        console_send_str(console, str);
+        console_send_str(console, "/");
+        utoa(LOGGING_NUM_BUFFERS, str, 10);
+        console_send_str(console, str);
 
         // Buffer info
         for (int i = 0; i < LOGGING_NUM_BUFFERS; i++) {
@@ -799,41 +814,37 @@ void debug_logging(uint8_t argc, char **argv, struct console_desc_t *console)
             console_send_str(console, ", checkouts: ");
             utoa(logging_g.buffer[i].checkout_count, str, 10);
             console_send_str(console, str);
-            console_send_str(console, ", pending: ");
-            console_send_str(console,
-                             logging_g.buffer[i].pending_write ? "yes" : "no");
         }
 
-        // Insert point
-        console_send_str(console, "\nInsert point: ");
-        if (logging_g.insert_point == NULL) {
-            console_send_str(console, "NULL");
-        } else {
-            int i = 0;
-            for (; i < LOGGING_NUM_BUFFERS; i++) {
-                uintptr_t const start = (uintptr_t)logging_g.buffer[i].data;
-                uintptr_t const end = start + LOGGING_BUFFER_SIZE;
-                if (((uintptr_t)logging_g.insert_point >= start) &&
-                    ((uintptr_t)logging_g.insert_point <= end)) {
-                    console_send_str(console, "buffer ");
-                    itoa(i, str, 10);
-                    console_send_str(console, str);
-                    console_send_str(console, " + ");
-                    utoa((uintptr_t)logging_g.insert_point - start, str, 10);
-                    console_send_str(console, str);
-                    break;
-                }
-            }
+        console_send_str(console, "\nNumber of missed checkouts: ");
+        utoa(logging_g.out_of_space_count, str, 10);
+        console_send_str(console, str);
 
-            if (i == LOGGING_NUM_BUFFERS) {
-                utoa((uintptr_t)logging_g.insert_point, str, 16);
+        // Write latency histogram
+        console_send_str(console, "\n\nSD write latency (ms):");
+        for (int i = 0; i < LOGGING_LATENCY_HIST_BUCKETS; i++) {
+            console_send_str(console, "\n    ");
+            if (i == 0) {
+                console_send_str(console, "< 1");
+            } else if (i == (LOGGING_LATENCY_HIST_BUCKETS - 1)) {
+                console_send_str(console, ">= ");
+                utoa(1 << (i - 1), str, 10);
+                console_send_str(console, str);
+            } else {
+                utoa(1 << (i - 1), str, 10);
+                console_send_str(console, str);
+                console_send_str(console, " - ");
+                utoa((1 << i) - 1, str, 10);
                 console_send_str(console, str);
             }
+            console_send_str(console, ": ");
+            utoa(logging_g.write_latency_hist[i], str, 10);
+            console_send_str(console, str);
         }
-
-        console_send_str(console, "\nNumber of missed checkouts: ");
-        utoa(logging_g.out_of_space_count, str, 10);
+        console_send_str(console, "\nLongest SD write: ");
+        utoa(logging_g.max_write_latency, str, 10);
         console_send_str(console, str);
+        console_send_str(console, " ms");
 
         console_send_str(console, "\n");
 
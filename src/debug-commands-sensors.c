@@ -223,7 +223,7 @@ void debug_alt (uint8_t argc, char **argv, struct console_desc_t *console)
     utoa(altimeter_g.d1, str, 10);
     console_send_str(console, str);
     console_send_str(console, ", p0 = ");
-    debug_print_fixed_point(console, (int32_t)(altimeter_g.p0 * 100), 2);
+    debug_print_fixed_point(console, altimeter_g.p0, 2);
 
     wdt_pat();
 
@@ -235,10 +235,26 @@ void debug_alt (uint8_t argc, char **argv, struct console_desc_t *console)
     console_send_str(console, str);
 
     // Altitude
-    int32_t altitude = (int32_t)(altimeter_g.altitude * 100);
+    int32_t altitude = altimeter_g.altitude / 10;
     console_send_str(console, ")\nAltitude: ");
     debug_print_fixed_point(console, altitude, 2);
     console_send_str(console, " m\n");
+
+    wdt_pat();
+
+    // Sampling
+    static const char *const osr_names[] = { "256", "512", "1024", "2048",
+                                             "4096" };
+    console_send_str(console, "Sample rate: ");
+    debug_print_fixed_point(console, ms5611_get_sample_rate(&altimeter_g), 2);
+    console_send_str(console, " Hz (pressure OSR ");
+    console_send_str(console, osr_names[altimeter_g.pres_osr]);
+    console_send_str(console, ", temperature OSR ");
+    console_send_str(console, osr_names[altimeter_g.temp_osr]);
+    console_send_str(console, " every ");
+    utoa(altimeter_g.temp_interval, str, 10);
+    console_send_str(console, str);
+    console_send_str(console, " readings)\n");
 #endif
 }
 
@@ -390,7 +406,7 @@ void debug_gnss (uint8_t argc, char **argv, struct console_desc_t *console)
     return;
 #endif
 
-    char str[8];
+    char str[11];
 
     /* Timestamps */
     console_send_str(console, "Timestamps\n\tLast sentence at ");
@@ -424,8 +440,28 @@ void debug_gnss (uint8_t argc, char **argv, struct console_desc_t *console)
     console_send_str(console, str);
 #endif
 
+    console_send_str(console, " milliseconds ago)\n\tChecksum errors: ");
+    utoa(gnss_xa1110_get_checksum_errors(), str, 10);
+    console_send_str(console, str);
+
+    /* Mode */
+    const struct gnss_xa1110_mode *const mode = gnss_xa1110_get_mode();
+    console_send_str(console, "\nGNSS Mode\n\tFix rate: ");
+    utoa(mode->fix_rate, str, 10);
+    console_send_str(console, str);
+    console_send_str(console, " Hz\n\tBaud rate: ");
+    utoa(mode->baud, str, 10);
+    console_send_str(console, str);
+    console_send_str(console, "\n\tGSA every ");
+    utoa(mode->gsa_divisor, str, 10);
+    console_send_str(console, str);
+    console_send_str(console, " fixes\n\tGSV every ");
+    utoa(mode->gsv_divisor, str, 10);
+    console_send_str(console, str);
+    console_send_str(console, " fixes");
+
     /* Fix */
-    console_send_str(console, " milliseconds ago)\nGNSS Fix\n\t");
+    console_send_str(console, "\nGNSS Fix\n\t");
     int32_t lat_seconds = gnss_xa1110_descriptor.latitude;
     uint8_t lat_dir = lat_seconds >= 0;
     lat_seconds *= lat_dir ? 1 : -1;
@@ -814,6 +850,7 @@ void debug_mpu9250_test (uint8_t argc, char **argv,
         case MPU9250_FIFO_WAIT:
         case MPU9250_FIFO_READ_COUNT:
         case MPU9250_FIFO_READ:
+        case MPU9250_FIFO_RESET:
             break;
         case MPU9250_FAILED:
             console_send_str(console, "Failed\n");
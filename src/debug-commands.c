@@ -75,6 +75,8 @@ const struct cli_func_desc_t debug_commands_funcs[] = {
         .help_string = DEBUG_IO_EXP_REGS_HELP},
     {.func = debug_gpio, .name = DEBUG_GPIO_NAME,
         .help_string = DEBUG_GPIO_HELP},
+    {.func = debug_profile, .name = DEBUG_PROFILE_NAME,
+        .help_string = DEBUG_PROFILE_HELP},
     // Analog
     {.func = debug_temp, .name = DEBUG_TEMP_NAME,
         .help_string = DEBUG_TEMP_HELP},
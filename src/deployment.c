@@ -9,11 +9,11 @@
 
 #include "deployment.h"
 
-#include <math.h>
-
 #include "variant.h"
 #include "gpio.h"
 
+/** Standard gravity in millimeters per second squared */
+#define DEPLOYMENT_GRAVITY  9807
 
 void init_deployment(struct deployment_service_desc_t *const inst,
                      struct ms5611_desc_t *const ms5611_alt,
@@ -23,9 +23,13 @@ void init_deployment(struct deployment_service_desc_t *const inst,
 
     inst->ms5611_alt = ms5611_alt;
     inst->mpu9250_imu = mpu9250_imu;
-    inst->max_altitude = 0.0f;
-    inst->last_sample_time = 0;
-    inst->decending_sample_count = 0;
+    inst->last_altitude = 0.0f;
+    inst->last_alt_time = 0;
+    inst->deployment_time = 0;
+
+#ifdef ENABLE_DEPLOYMENT_SERVICE
+    init_altitude_filter(&inst->filter, ALTIMETER_PERIOD);
+#endif
 }
 
 
@@ -55,65 +59,67 @@ static inline int test_abs_acceleration(
     return abs > (threashold * threashold);
 }
 
-static inline int is_decending(struct deployment_service_desc_t *const inst)
-{
 #ifdef ENABLE_DEPLOYMENT_SERVICE
-    // Check if we have a new sample
-    const uint32_t alt_time = ms5611_get_last_reading_time(inst->ms5611_alt);
-    if (alt_time <= inst->last_sample_time) {
-        return 0;
+/**
+ *  Give any new IMU and altimeter data to the altitude filter.
+ *
+ *  @param inst A deployment service instance descriptor
+ */
+static void update_filter(struct deployment_service_desc_t *const inst)
+{
+    // Propagate the filter with the average acceleration along the rocket's
+    // vertical axis since the last time we were called
+    int32_t sums[3];
+    const uint16_t count = mpu9250_take_accel_sums(inst->mpu9250_imu, sums);
+    if (count != 0) {
+        const int32_t mean = sums[DEPLOYMENT_UP_AXIS] / count;
+        int32_t accel = ((mean * DEPLOYMENT_GRAVITY) /
+                         mpu9250_accel_sensitivity(inst->mpu9250_imu));
+#if DEPLOYMENT_UP_AXIS_INVERTED
+        accel = -accel;
+#endif
+        // The accelerometer measures specific force, remove gravity to get
+        // the acceleration of the rocket
+        altitude_filter_predict(&inst->filter, accel - DEPLOYMENT_GRAVITY,
+                                mpu9250_get_last_time(inst->mpu9250_imu));
     }
-    inst->last_sample_time = alt_time;
 
-    // Check if the new sample is the highest we have been
-    const float altitude = ms5611_get_altitude(inst->ms5611_alt);
-    if (altitude >= inst->max_altitude) {
-        inst->max_altitude = altitude;
-        inst->decending_sample_count = 0;
-        return 0;
+    // Correct the filter if there is a new altimeter reading
+    const uint32_t alt_time = ms5611_get_last_reading_time(inst->ms5611_alt);
+    if (alt_time != inst->last_alt_time) {
+        inst->last_alt_time = alt_time;
+        altitude_filter_update(&inst->filter,
+                               ms5611_get_altitude_mm(inst->ms5611_alt),
+                               alt_time);
     }
+}
 
-    // This sample is less than our highest
-    inst->decending_sample_count++;
-
-    // Check if we have enough samples to be sure we are decending
-    return (inst->decending_sample_count >
-            DEPLOYMENT_DESCENDING_SAMPLE_THREASHOLD);
-#else
-    return 0;
-#endif
+static inline int is_decending(struct deployment_service_desc_t *const inst)
+{
+    return (altitude_filter_get_velocity(&inst->filter) <
+            DEPLOYMENT_DESCENDING_VELOCITY);
 }
 
 static inline int is_landed(struct deployment_service_desc_t *const inst)
 {
-#ifdef ENABLE_DEPLOYMENT_SERVICE
-    // Check if we have a new sample
-    const uint32_t alt_time = ms5611_get_last_reading_time(inst->ms5611_alt);
-    if (alt_time <= inst->last_sample_time) {
+    const int32_t velocity = altitude_filter_get_velocity(&inst->filter);
+    if ((velocity > DEPLOYMENT_LANDED_VELOCITY) ||
+            (velocity < -DEPLOYMENT_LANDED_VELOCITY)) {
+        inst->last_moving_time = millis;
         return 0;
     }
-    inst->last_sample_time = alt_time;
 
-    // Check if the new sample is close to the last sample we saw
-    const float altitude = ms5611_get_altitude(inst->ms5611_alt);
-    if (fabsf(inst->last_altitude - altitude) > DEPLOYMENT_LANDED_ALT_CHANGE) {
-        inst->landing_sample_count = 0;
-        return 0;
-    }
-
-    inst->landing_sample_count++;
-
-    // Check if we have enough samples to be sure we have landed
-    return inst->landing_sample_count > DEPLOYMENT_LANDED_SAMPLE_THREASHOLD;
-#else
-    return 0;
-#endif
+    // Check if we have been still for long enough to be sure we have landed
+    return (millis - inst->last_moving_time) > DEPLOYMENT_LANDED_TIME;
 }
+#endif
 
 
 void deployment_service(struct deployment_service_desc_t *const inst)
 {
 #ifdef ENABLE_DEPLOYMENT_SERVICE
+    update_filter(inst);
+
     switch (inst->state) {
         case DEPLOYMENT_STATE_IDLE:
             if (is_armed()) {
@@ -126,6 +132,12 @@ void deployment_service(struct deployment_service_desc_t *const inst)
                                 DEPLOYMENT_POWERED_ASCENT_ACCEL_THREASHOLD) ||
                 inst->last_altitude >
                                 DEPLOYMENT_POWERED_ASCENT_ALT_THREASHOLD) {
+                // Sample the altimeter faster at lower resolution during
+                // ascent
+                ms5611_set_sampling(inst->ms5611_alt, ALTIMETER_ASCENT_PERIOD,
+                                    ALTIMETER_ASCENT_PRES_OSR,
+                                    ALTIMETER_ASCENT_TEMP_OSR,
+                                    ALTIMETER_ASCENT_TEMP_INTERVAL);
                 inst->state = DEPLOYMENT_STATE_POWERED_ASCENT;
             }
             break;
@@ -155,6 +167,11 @@ void deployment_service(struct deployment_service_desc_t *const inst)
                     DEPLOYMENT_EMATCH_FIRE_DURATION) {
                 gpio_set_output(EMATCH_1_PIN, 0);
                 gpio_set_output(EMATCH_2_PIN, 0);
+                // Go back to full resolution altimeter readings for descent
+                ms5611_set_sampling(inst->ms5611_alt, ALTIMETER_PERIOD,
+                                    MS5611_OSR_SEL_4096, MS5611_OSR_SEL_4096,
+                                    1);
+                inst->last_moving_time = millis;
                 inst->state = DEPLOYMENT_STATE_DESCENT;
             }
             break;
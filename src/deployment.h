@@ -12,6 +12,7 @@
 
 #include "ms5611.h"
 #include "mpu9250.h"
+#include "altitude-filter.h"
 
 enum deployment_service_state {
     DEPLOYMENT_STATE_IDLE = 0x0,
@@ -24,20 +25,21 @@ enum deployment_service_state {
 };
 
 struct deployment_service_desc_t {
+    /** Estimate of altitude and vertical velocity from the altimeter and
+        IMU */
+    struct altitude_filter_t filter;
     enum deployment_service_state state;
     struct ms5611_desc_t *ms5611_alt;
     struct mpu9250_desc_t *mpu9250_imu;
+    float last_altitude;
+    /** Time of the last altimeter reading given to the filter */
+    uint32_t last_alt_time;
     union {
-        float max_altitude;
-        float last_altitude;
-    };
-    union {
-        uint32_t last_sample_time;
+        /** Time at which the ematches were fired */
         uint32_t deployment_time;
-    };
-    union {
-        uint8_t decending_sample_count;
-        uint8_t landing_sample_count;
+        /** Last time at which the estimated velocity showed that we were
+            still moving */
+        uint32_t last_moving_time;
     };
 };
 
@@ -70,5 +72,23 @@ static inline enum deployment_service_state deployment_get_state(
     return inst->state;
 }
 
+/**
+ *  Get the estimated vertical velocity in millimeters per second.
+ */
+static inline int32_t deployment_get_velocity(
+                            const struct deployment_service_desc_t *const inst)
+{
+    return altitude_filter_get_velocity(&inst->filter);
+}
+
+/**
+ *  Get the estimated altitude in millimeters.
+ */
+static inline int32_t deployment_get_altitude(
+                            const struct deployment_service_desc_t *const inst)
+{
+    return altitude_filter_get_altitude(&inst->filter);
+}
+
 
 #endif /* deployment_h */
@@ -12,6 +12,7 @@
 
 // Include target.h for millis and MCU specific headers
 #include "target.h"
+#include "profiler.h"
 
 #include <stdint.h>
 #include <stddef.h> // NULL
@@ -26,10 +27,6 @@ extern void init_target(void);
 extern void init_board(void);
 extern void init_variant(void);
 
-// Service functions
-extern void board_service(void);
-extern void variant_service(void);
-
 // Clock control functions (defined in target.c)
 extern void enable_bus_clock(enum peripheral_bus_clock clock);
 extern void disable_bus_clock(enum peripheral_bus_clock clock);
@@ -47,9 +44,9 @@ extern volatile uint8_t inhibit_sleep_g;
  */
 static inline void inhibit_sleep (void)
 {
-    __disable_irq();
+    profiler_disable_irq();
     inhibit_sleep_g++;
-    __enable_irq();
+    profiler_enable_irq();
 }
 
 /**
@@ -57,9 +54,9 @@ static inline void inhibit_sleep (void)
  */
 static inline void allow_sleep (void)
 {
-    __disable_irq();
+    profiler_disable_irq();
     inhibit_sleep_g--;
-    __enable_irq();
+    profiler_enable_irq();
 }
 
 #endif /* global_h */
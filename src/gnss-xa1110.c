@@ -11,61 +11,51 @@
 
 #include "gnss-xa1110.h"
 
-
-#define I(x) ((x) - '0')
+/** Longest NMEA sentence including the start character and line ending */
+#define GNSS_MAX_SENTENCE_LENGTH    82
+/** Most GSV sentences sent for each constellation */
+#define GNSS_NUM_GSV_SENTENCES      ((GNSS_MAX_SATS_IN_VIEW + 3) / 4)
+/** Largest percentage of the UART bandwidth which should be used by sentences
+    from the module */
+#define GNSS_MAX_UART_LOAD          50
+/** Target interval between GSA sentences in seconds */
+#define GNSS_GSA_PERIOD             1
+/** Target interval between GSV sentences in seconds */
+#define GNSS_GSV_PERIOD             5
+/** Largest number of fixes between sentences which can be set with PMTK314 */
+#define GNSS_MAX_DIVISOR            5
+
+/** Time to listen for a valid sentence before trying another baud rate */
+#define GNSS_SEARCH_TIMEOUT         MS_TO_MILLIS(1500)
+/** Time without a valid sentence after which communication with the module is
+    considered to have been lost */
+#define GNSS_LOST_TIMEOUT           MS_TO_MILLIS(3000)
+
+/** Time of day value used when there is no valid fix */
+#define GNSS_NO_FIX_TIME            UINT32_MAX
+
+/** Baud rates which the module can be configured to use */
+static const uint32_t gnss_bauds[] = { 9600, 19200, 38400, 57600, 115200 };
+
+#define NUM_GNSS_BAUDS (sizeof(gnss_bauds) / sizeof(gnss_bauds[0]))
 
 
 struct gnss gnss_xa1110_descriptor;
 
 
 /**
- *  Parse the latitude and longitude from a NMEA sentence.
+ *  Parse a latitude or longitude from a NMEA sentence field.
+ *
+ *  @param field The field containing the coordinate in degrees and decimal
+ *               minutes
  *
- *  @param lat The latitude string
- *  @param north_south North-South indicator string
- *  @param lon The longitude string
- *  @param east_west East-West indicator string
- *  @param desc GNSS descriptor in which coordinates should be stored
+ *  @return The coordinate in 100 microminutes per least significant bit
  */
-static void gnss_parse_coordinates (char *lat, char *north_south, char *lon,
-                                    char *east_west, struct gnss *desc)
+static int32_t gnss_parse_coordinate (const struct nmea_field_t *field)
 {
-    /* Latitude */
-    // Whole degrees
-    desc->latitude =  I(lat[0]) * 6000000;
-    desc->latitude += I(lat[1]) * 600000;
-    // Whole minutes
-    desc->latitude += I(lat[2]) * 100000;
-    desc->latitude += I(lat[3]) * 10000;
-    // Fractional minutes
-    desc->latitude += I(lat[5]) * 1000;
-    desc->latitude += I(lat[6]) * 100;
-    desc->latitude += I(lat[7]) * 10;
-    desc->latitude += I(lat[8]) * 1;
-    
-    // North/South
-    if (north_south[0] == 'S') {
-        desc->latitude *= -1;
-    }
-    
-    /* Longitude */
-    // Whole degrees
-    desc->longitude =  I(lon[0]) * 60000000;
-    desc->longitude += I(lon[1]) * 6000000;
-    desc->longitude += I(lon[2]) * 600000;
-    // Whole minutes
-    desc->longitude += I(lon[3]) * 100000;
-    desc->longitude += I(lon[4]) * 10000;
-    // Fractional minutes
-    desc->longitude += I(lon[6]) * 1000;
-    desc->longitude += I(lon[7]) * 100;
-    desc->longitude += I(lon[8]) * 10;
-    desc->longitude += I(lon[9]) * 1;
-    
-    // East/West
-    if (east_west[0] == 'W') {
-        desc->longitude *= -1;
-    }
+    // Degrees are above the last two whole digits of minutes
+    int32_t const value = nmea_field_fixed(field, 4);
+    return ((value / 1000000) * 600000) + (value % 1000000);
 }
 
 /**
@@ -111,12 +101,13 @@ static const uint16_t month_add[] = {0, 31, 31 + 28, 2*31 + 28, 2*31 + 30 + 28,
 /**
  *  Parse the time from a NMEA sentence.
  *
- *  @param date The date string
- *  @param time The time string
+ *  @param date The date field as an integer (ddmmyy)
+ *  @param time The whole part of the time field as an integer (hhmmss)
  *
- *  @return Unix time representation of string time
+ *  @return Unix time representation of the date and time, 0 if the date is not
+ *          valid
  */
-static uint32_t gnss_parse_time (char *date, char *time)
+static uint32_t gnss_parse_time (uint32_t date, uint32_t time)
 {
     /* Start at January 1st 2000 */
     uint32_t unix_time = 946684800;
@@ -124,12 +115,15 @@ static uint32_t gnss_parse_time (char *date, char *time)
     /* Date */
     // Convert date to days since January 1st 2000
     // Days
-    uint32_t days = (I(date[0]) * 10) + I(date[1]) - 1;
+    uint32_t days = (date / 10000) - 1;
     // Months
-    uint8_t month = (I(date[2]) * 10) + I(date[3]) - 1;
+    uint8_t month = ((date / 100) % 100) - 1;
+    if (month > 11) {
+        return 0;
+    }
     days += month_add[month];
     // Years since 2000
-    uint32_t years_since_2000 = (I(date[4]) * 10) + I(date[5]);
+    uint32_t years_since_2000 = date % 100;
     days += years_since_2000 * 365;
     // Leap years since 2000 (including 2000 its self, not including the current
     // year)
@@ -142,251 +136,378 @@ static uint32_t gnss_parse_time (char *date, char *time)
     
     /* Time */
     // Hours
-    unix_time += I(time[0]) * 60 * 60 * 10;
-    unix_time += I(time[1]) * 60 * 60;
+    unix_time += (time / 10000) * 60 * 60;
     // Minutes
-    unix_time += I(time[2]) * 60 * 10;
-    unix_time += I(time[3]) * 60;
+    unix_time += ((time / 100) % 100) * 60;
     // Whole Seconds
-    unix_time += I(time[4]) * 10;
-    unix_time += I(time[5]);
+    unix_time += time % 100;
     
     return unix_time;
 }
 
+
+
+
 /**
- *  Parse a floating point number an integer with a given scaling factor.
- *  The number will be parsed up to log(scale) decimal places. The returned
- *  value is scale times the value in the string.
- *
- *  @param str The string containing the floating point number
- *  @param scale The scaling factor, must be a power of 10
- *
- *  @return The parsed integer
+ *  Values from the sentence which is being received. These are only copied to
+ *  the descriptor once the checksum for the sentence has been verified.
  */
-static int32_t gnss_parse_fp (char *str, uint32_t scale)
+static union {
+    struct {
+        /** Time of day as hhmmss with three decimal places */
+        uint32_t time;
+        uint32_t date;
+        int32_t latitude;
+        int32_t longitude;
+        int16_t speed;
+        int16_t course;
+        char status;
+        char north_south;
+        char east_west;
+    } rmc;
+    struct {
+        /** Time of day as hhmmss with three decimal places */
+        uint32_t time;
+        int32_t altitude;
+        uint8_t quality;
+        uint8_t num_sats;
+    } gga;
+    struct {
+        uint32_t sats_in_use;
+        uint16_t pdop;
+        uint16_t hdop;
+        uint16_t vdop;
+        enum gnss_fix_type fix_type;
+    } gsa;
+    struct {
+        struct {
+            uint16_t id;
+            uint16_t azimuth;
+            uint8_t elevation;
+            uint8_t snr;
+        } sats[4];
+        uint8_t message_num;
+        uint8_t num_in_view;
+        uint8_t num_sats;
+    } gsv;
+    struct {
+        enum gnss_antenna antenna;
+    } pgack;
+} staging;
+
+/**
+ *  States for communication with the GNSS module.
+ */
+enum gnss_state {
+    /** Waiting for a valid sentence at the current baud rate, the module is
+        configured once one is received */
+    GNSS_STATE_SEARCH,
+    /** Waiting for the baud rate change command to be sent */
+    GNSS_STATE_CHANGE_BAUD,
+    /** Module is configured */
+    GNSS_STATE_RUNNING
+};
+
+/** Parser for sentences from the GNSS module */
+static struct nmea_parser_t gnss_parser;
+/** UART used to communicate with the GNSS module */
+static struct sercom_uart_desc_t *gnss_uart;
+/** Number of valid sentences the parser had received as of the last time the
+    service ran */
+static uint32_t gnss_valid_sentences;
+/** Output configuration for the module */
+static struct gnss_xa1110_mode gnss_mode;
+/** Current state of communication with the module */
+static enum gnss_state gnss_state;
+/** Time at which the current state was entered */
+static uint32_t gnss_state_time;
+/** Index in gnss_bauds of the baud rate being used */
+static uint8_t gnss_baud_index;
+/** Time of day of the last RMC sentence with a valid fix */
+static uint32_t gnss_rmc_time;
+/** Time of day of the last GGA sentence */
+static uint32_t gnss_gga_time;
+
+
+static void gnss_rmc_field (void *context, uint32_t id, uint8_t index,
+                            const struct nmea_field_t *field)
 {
-    int32_t out = 0;
-    
-    /* Find decimal place */
-    char *decimal = str;
-    for (; (*decimal != '.') && (*decimal != '\0'); decimal++);
-    
-    /* Whole part */
-    int32_t weight = scale;
-    char *c = decimal - 1;
-    
-    for (; (*c != '\0') && (*c != '-'); c--) {
-        out += I(*c) * weight;
-        weight *= 10;
-    }
-    
-    int8_t negation = (*c == '-' ? -1 : 1);
-    
-    /* Fractional part */
-    if (*decimal == '\0') {
-        // No fractional part
-        return out * negation;
-    }
-    
-    weight = scale;
-    c = decimal + 1;
-    
-    for (; (*c != '\0') && (weight != 1); c++) {
-        weight /= 10;
-        out += I(*c) * weight;
+    switch (index) {
+        case 1:
+            // UTC Time
+            staging.rmc.time = (uint32_t)nmea_field_fixed(field, 3);
+            break;
+        case 2:
+            // Status
+            staging.rmc.status = field->text[0];
+            break;
+        case 3:
+            // Latitude
+            staging.rmc.latitude = gnss_parse_coordinate(field);
+            break;
+        case 4:
+            // North/South
+            staging.rmc.north_south = field->text[0];
+            break;
+        case 5:
+            // Longitude
+            staging.rmc.longitude = gnss_parse_coordinate(field);
+            break;
+        case 6:
+            // East/West
+            staging.rmc.east_west = field->text[0];
+            break;
+        case 7:
+            // Speed over ground
+            staging.rmc.speed = (int16_t)nmea_field_fixed(field, 2);
+            break;
+        case 8:
+            // Course over ground
+            staging.rmc.course = (int16_t)nmea_field_fixed(field, 2);
+            break;
+        case 9:
+            // Date
+            staging.rmc.date = (uint32_t)nmea_field_int(field);
+            break;
+        default:
+            // 10/11: Magnetic Variation (ignored)
+            // 12: Mode (ignored)
+            break;
     }
-    
-    return out * negation;
 }
 
-
-
-
-static void gnss_parse_gga (uint8_t argc, char **argv, struct gnss *desc)
+static void gnss_rmc_commit (void *context, uint32_t id)
 {
-    // 1: UTC Time (ignored)
-    
-    // 2: Latitude
-    // 3: North/South
-    // 4: Longitude
-    // 5: East/West
-    //gnss_parse_coordinates(argv[2], argv[3], argv[4], argv[5], desc);
-    
-    // 6: Position Fix Indicator
-    desc->fix_quality = strtoul(argv[6], NULL, 10);
+    struct gnss *desc = (struct gnss*)context;
     
-    // 7: Number of satellites used
-    desc->num_sats_in_use = strtoul(argv[7], NULL, 10);
-    
-    // 8: Horizontal Dilution of Precision
-    //desc->hdop = (uint16_t)gnss_parse_fp(argv[8], 100);
-    
-    // 9: Altitude
-    desc->altitude = gnss_parse_fp(argv[9], 1000);
-    
-    // 10: Altitude Units (ignored)
-    
-    // 11/12: Geoidal Separation (ignored)
+    uint32_t const utc_time = gnss_parse_time(staging.rmc.date,
+                                              staging.rmc.time / 1000);
+    if (utc_time != 0) {
+        desc->utc_time = utc_time;
+    }
     
-    // 13: Age of Differential Correction (ignored)
+    if (staging.rmc.status != 'A') {
+        // No fix
+        gnss_rmc_time = GNSS_NO_FIX_TIME;
+        return;
+    }
     
-    // All done!
+    desc->latitude = ((staging.rmc.north_south == 'S') ?
+                      -staging.rmc.latitude : staging.rmc.latitude);
+    desc->longitude = ((staging.rmc.east_west == 'W') ?
+                       -staging.rmc.longitude : staging.rmc.longitude);
+    desc->speed = staging.rmc.speed;
+    desc->course = staging.rmc.course;
+    
+    // The fix is complete once the RMC and GGA sentences for it have both been
+    // received, they can arrive in either order
+    gnss_rmc_time = staging.rmc.time;
+    if (gnss_gga_time == gnss_rmc_time) {
+        desc->last_fix = millis;
+    }
 }
 
-#ifdef GNSS_STORE_IN_USE_SAT_SVS
-/**
- *  Parse a comma separated list of satellite PRNs into a bit field.
- *
- *  @param num_chans The number of channels to parse
- *  @param offset Lowest possible satellite number
- *  @param str Array of strings for each channel
- *  @param field Bit field in which present channels should be stored
- */
-static void gnss_parse_sat_list (uint8_t num_chans, uint8_t offset,
-                                 char **str, uint32_t *field)
+static void gnss_gga_field (void *context, uint32_t id, uint8_t index,
+                            const struct nmea_field_t *field)
 {
-    *field = 0;
-    for (uint8_t i = 0; i < num_chans; i++) {
-        if (str[i][0] != '\0') {
-            *field |= (1 << (strtoul(str[i], NULL, 10) - offset));
-        }
+    switch (index) {
+        case 1:
+            // UTC Time
+            staging.gga.time = (uint32_t)nmea_field_fixed(field, 3);
+            break;
+        case 6:
+            // Position Fix Indicator
+            staging.gga.quality = (uint8_t)nmea_field_int(field);
+            break;
+        case 7:
+            // Number of satellites used
+            staging.gga.num_sats = (uint8_t)nmea_field_int(field);
+            break;
+        case 9:
+            // Altitude
+            staging.gga.altitude = nmea_field_fixed(field, 3);
+            break;
+        default:
+            // 2-5: Latitude and longitude (ignored)
+            // 8: Horizontal Dilution of Precision (ignored)
+            // 10: Altitude Units (ignored)
+            // 11/12: Geoidal Separation (ignored)
+            // 13: Age of Differential Correction (ignored)
+            break;
     }
 }
-#endif
 
-static void gnss_parse_gsa (uint8_t argc, char **argv, struct gnss *desc)
+static void gnss_gga_commit (void *context, uint32_t id)
 {
-#ifdef GNSS_STORE_IN_USE_SAT_SVS
-    // Determine if this sentence contains info on GPS or GLONASS satellites
-    uint8_t gps = !strcmp(argv[0] + 1, "GPGSA");
-#endif
+    struct gnss *desc = (struct gnss*)context;
     
-    // 1: Mode 1 (ignored)
+    desc->fix_quality = staging.gga.quality;
+    desc->num_sats_in_use = staging.gga.num_sats;
+    desc->altitude = staging.gga.altitude;
     
-    // 2: Mode 2
-    switch (argv[2][0]) {
-        case '1':
-            desc->fix_type = GNSS_FIX_NOT_AVAILABLE;
+    gnss_gga_time = staging.gga.time;
+    if (gnss_rmc_time == gnss_gga_time) {
+        desc->last_fix = millis;
+    }
+}
+
+static void gnss_gsa_field (void *context, uint32_t id, uint8_t index,
+                            const struct nmea_field_t *field)
+{
+    switch (index) {
+        case 1:
+            // Mode 1 (ignored)
+            staging.gsa.sats_in_use = 0;
             break;
-        case '2':
-            desc->fix_type = GNSS_FIX_2D;
+        case 2:
+            // Mode 2
+            switch (field->text[0]) {
+                case '1':
+                    staging.gsa.fix_type = GNSS_FIX_NOT_AVAILABLE;
+                    break;
+                case '2':
+                    staging.gsa.fix_type = GNSS_FIX_2D;
+                    break;
+                case '3':
+                    staging.gsa.fix_type = GNSS_FIX_3D;
+                    break;
+                default:
+                    staging.gsa.fix_type = GNSS_FIX_UNKOWN;
+                    break;
+            }
             break;
-        case '3':
-            desc->fix_type = GNSS_FIX_3D;
+        case 15:
+            // Position Dilution of Precision
+            staging.gsa.pdop = (uint16_t)nmea_field_fixed(field, 2);
+            break;
+        case 16:
+            // Horizontal Dilution of Precision
+            staging.gsa.hdop = (uint16_t)nmea_field_fixed(field, 2);
+            break;
+        case 17:
+            // Vertical Dilution of Precision
+            staging.gsa.vdop = (uint16_t)nmea_field_fixed(field, 2);
             break;
         default:
-            desc->fix_type = GNSS_FIX_UNKOWN;
+            // 3 through 14: Satellites on channels 1 through 12
+#ifdef GNSS_STORE_IN_USE_SAT_SVS
+            if ((index >= 3) && (index <= 14) && (field->length != 0)) {
+                uint8_t const offset = ((id == NMEA_ID('G','P','G','S','A')) ?
+                                        GPS_SV_OFFSET : GLONASS_SV_OFFSET);
+                uint32_t const sat = (uint32_t)nmea_field_int(field) - offset;
+                if (sat < 32) {
+                    staging.gsa.sats_in_use |= (1UL << sat);
+                }
+            }
+#endif
             break;
     }
+}
+
+static void gnss_gsa_commit (void *context, uint32_t id)
+{
+    struct gnss *desc = (struct gnss*)context;
     
-    // 3: Satellite on channel 1
-    // 4: Satellite on channel 2
-    // 5: Satellite on channel 3
-    // 6: Satellite on channel 4
-    // 7: Satellite on channel 5
-    // 8: Satellite on channel 6
-    // 9: Satellite on channel 7
-    // 10: Satellite on channel 8
-    // 11: Satellite on channel 9
-    // 12: Satellite on channel 10
-    // 13: Satellite on channel 11
-    // 14: Satellite on channel 12
 #ifdef GNSS_STORE_IN_USE_SAT_SVS
-    gnss_parse_sat_list(12, gps ? GPS_SV_OFFSET : GLONASS_SV_OFFSET, argv + 3,
-                        gps ? &desc->gps_sats_in_use :
-                        &desc->glonass_sats_in_use);
+    // Determine if this sentence contains info on GPS or GLONASS satellites
+    if (id == NMEA_ID('G','P','G','S','A')) {
+        desc->gps_sats_in_use = staging.gsa.sats_in_use;
+    } else {
+        desc->glonass_sats_in_use = staging.gsa.sats_in_use;
+    }
 #endif
     
-    // 15: Position Dilution of Precision
-    desc->pdop = (uint16_t)gnss_parse_fp(argv[15], 100);
-    
-    // 16: Horizontal Dilution of Precision
-    desc->hdop = (uint16_t)gnss_parse_fp(argv[16], 100);
-    
-    // 17: Vertical Dilution of Precision
-    desc->vdop = (uint16_t)gnss_parse_fp(argv[17], 100);
+    desc->fix_type = staging.gsa.fix_type;
+    desc->pdop = staging.gsa.pdop;
+    desc->hdop = staging.gsa.hdop;
+    desc->vdop = staging.gsa.vdop;
     
     // All done!
     desc->last_meta = millis;
 }
 
-static void gnss_parse_rmc (uint8_t argc, char **argv, struct gnss *desc)
+#ifdef GNSS_STORE_IN_VIEW_SAT_INFO
+static void gnss_gsv_field (void *context, uint32_t id, uint8_t index,
+                            const struct nmea_field_t *field)
 {
-    // 9: Date
-    // 1: UTC Time
-    desc->utc_time = gnss_parse_time(argv[9], argv[1]);
-    
-    // 2: Status
-    if (argv[2][0] == 'V') {
-        //desc->status = 0;
+    if (index == 1) {
+        // Number of Messages (ignored)
+        staging.gsv.num_sats = 0;
+        return;
+    } else if (index == 2) {
+        // Message Number
+        staging.gsv.message_num = (uint8_t)(nmea_field_int(field) - 1);
+        return;
+    } else if (index == 3) {
+        // Satellites in View
+        staging.gsv.num_in_view = (uint8_t)nmea_field_int(field);
         return;
     }
     
-    // 3: Latitude
-    // 4: North/South
-    // 5: Longitude
-    // 6: East/West
-    gnss_parse_coordinates(argv[3], argv[4], argv[5], argv[6], desc);
-    
-    // 7: Speed over ground
-    desc->speed = (uint16_t)gnss_parse_fp(argv[7], 100);
-    
-    // 8: Course over ground
-    desc->course = (uint16_t)gnss_parse_fp(argv[8], 100);
-    
-    // 10/11: Magnetic Variation (ignored)
-    
-    // 12: Mode (ignored)
+    // 4 onwards: In view satellite info, four fields per satellite
+    uint8_t const sat = (index - 4) / 4;
+    if (sat >= 4) {
+        return;
+    }
     
-    // All done!
-    //desc->status = 1;
-    desc->last_fix = millis;
+    uint16_t const value = (uint16_t)nmea_field_int(field);
+    switch ((index - 4) % 4) {
+        case 0:
+            staging.gsv.sats[sat].id = value;
+            break;
+        case 1:
+            staging.gsv.sats[sat].elevation = (uint8_t)value;
+            break;
+        case 2:
+            staging.gsv.sats[sat].azimuth = value;
+            break;
+        case 3:
+            staging.gsv.sats[sat].snr = (uint8_t)value;
+            staging.gsv.num_sats = sat + 1;
+            break;
+    }
 }
 
-#ifdef GNSS_STORE_IN_VIEW_SAT_INFO
-static void gnss_parse_gsv (uint8_t argc, char **argv, struct gnss *desc)
+static void gnss_gsv_commit (void *context, uint32_t id)
 {
-    // Determine if this sentence contains info on GPS or GLONASS satellites
-    uint8_t gps = !strcmp(argv[0] + 1, "GPGSV");
-    
-    // 1: Number of Messages (ignored)
+    struct gnss *desc = (struct gnss*)context;
     
-    // 2: Message Number
-    uint8_t message_num = strtoul(argv[2], NULL, 10) - 1;
+    // Determine if this sentence contains info on GPS or GLONASS satellites
+    uint8_t const gps = (id == NMEA_ID('G','P','G','S','V'));
     
-    // 3: Satellites in View
-    uint8_t num_in_view = strtoul(argv[3], NULL, 10);
+    uint8_t const num_in_view = ((staging.gsv.num_in_view >
+                                  GNSS_MAX_SATS_IN_VIEW) ?
+                                 GNSS_MAX_SATS_IN_VIEW :
+                                 staging.gsv.num_in_view);
     if (gps) {
-        desc->num_gps_sats_in_view = ((num_in_view > GNSS_MAX_SATS_IN_VIEW) ?
-                                      GNSS_MAX_SATS_IN_VIEW : num_in_view);
+        desc->num_gps_sats_in_view = num_in_view;
     } else {
-        desc->num_glonass_sats_in_view = ((num_in_view > GNSS_MAX_SATS_IN_VIEW)
-                                          ? GNSS_MAX_SATS_IN_VIEW :
-                                          num_in_view);
+        desc->num_glonass_sats_in_view = num_in_view;
     }
     
-    // 4 through (argc - 1): In view satellite info
-    uint8_t num_sats = (argc - 4) / 4;
-    for (uint8_t i = 0; i < num_sats; i++) {
-        uint8_t sat = (4 * message_num) + i;
-        
-        uint16_t id = strtoul(argv[(4 * i) + 4], NULL, 10);
-        uint8_t elevation = strtoul((argv[(4 * i) + 5]), NULL, 10);
-        uint16_t azimuth = strtoul((argv[(4 * i) + 6]), NULL, 10);
-        uint8_t snr = strtoul((argv[(4 * i) + 7]), NULL, 10);
+    for (uint8_t i = 0; i < staging.gsv.num_sats; i++) {
+        uint16_t const sat = (4 * (uint16_t)staging.gsv.message_num) + i;
+        if (sat >= GNSS_MAX_SATS_IN_VIEW) {
+            break;
+        }
         
         if (gps) {
-            desc->in_view_gps_satellites[sat].prn = id - GPS_SV_OFFSET;
-            desc->in_view_gps_satellites[sat].elevation = elevation;
-            desc->in_view_gps_satellites[sat].azimuth = azimuth;
-            desc->in_view_gps_satellites[sat].snr = snr;
+            desc->in_view_gps_satellites[sat].prn = (staging.gsv.sats[i].id -
+                                                     GPS_SV_OFFSET);
+            desc->in_view_gps_satellites[sat].elevation =
+                                                staging.gsv.sats[i].elevation;
+            desc->in_view_gps_satellites[sat].azimuth =
+                                                staging.gsv.sats[i].azimuth;
+            desc->in_view_gps_satellites[sat].snr = staging.gsv.sats[i].snr;
         } else {
-            desc->in_view_glonass_satellites[sat].sat_id = (id -
-                                                            GLONASS_SV_OFFSET);
-            desc->in_view_glonass_satellites[sat].elevation = elevation;
-            desc->in_view_glonass_satellites[sat].azimuth = azimuth;
-            desc->in_view_glonass_satellites[sat].snr = snr;
+            desc->in_view_glonass_satellites[sat].sat_id =
+                                (staging.gsv.sats[i].id - GLONASS_SV_OFFSET);
+            desc->in_view_glonass_satellites[sat].elevation =
+                                                staging.gsv.sats[i].elevation;
+            desc->in_view_glonass_satellites[sat].azimuth =
+                                                staging.gsv.sats[i].azimuth;
+            desc->in_view_glonass_satellites[sat].snr =
+                                                staging.gsv.sats[i].snr;
         }
     }
     
@@ -395,133 +516,336 @@ static void gnss_parse_gsv (uint8_t argc, char **argv, struct gnss *desc)
 }
 #endif
 
-static void gnss_parse_pgack (uint8_t argc, char **argv, struct gnss *desc)
+static void gnss_pgack_field (void *context, uint32_t id, uint8_t index,
+                              const struct nmea_field_t *field)
 {
-    if (!strncmp(argv[1], "SW_ANT_Internal", 15)) {
+    if (index != 1) {
+        return;
+    }
+    
+    if (!strncmp(field->text, "SW_ANT_Internal", 15)) {
         // Using internal antenna
-        desc->antenna = GNSS_ANTENNA_INTERNAL;
-    } else if (!strncmp(argv[1], "SW_ANT_External", 15)) {
+        staging.pgack.antenna = GNSS_ANTENNA_INTERNAL;
+    } else if (!strncmp(field->text, "SW_ANT_External", 15)) {
         // Using external antenna
-        desc->antenna = GNSS_ANTENNA_EXTERNAL;
+        staging.pgack.antenna = GNSS_ANTENNA_EXTERNAL;
+    } else {
+        staging.pgack.antenna = GNSS_ANTENNA_UNKOWN;
     }
 }
 
+static void gnss_pgack_commit (void *context, uint32_t id)
+{
+    struct gnss *desc = (struct gnss*)context;
+    
+    if (staging.pgack.antenna != GNSS_ANTENNA_UNKOWN) {
+        desc->antenna = staging.pgack.antenna;
+    }
+}
 
 
 
 
-/**
- *  Descriptor for a NMEA sentence parser
- */
-struct gps_parser_t {
-    void (*parse)(uint8_t, char**, struct gnss*);
-    const char *type;
-};
 
 /**
  *  List of available NMEA sentence parsers
  */
-static const struct gps_parser_t nmea_parsers[] = {
-    {.parse = gnss_parse_rmc, .type = "GNRMC"},
+static const struct nmea_sentence_t nmea_parsers[] = {
+    {.id = NMEA_ID('G','N','R','M','C'), .field = gnss_rmc_field,
+        .commit = gnss_rmc_commit},
 #ifdef GNSS_STORE_IN_VIEW_SAT_INFO
-    {.parse = gnss_parse_gsv, .type = "GPGSV"},
-    {.parse = gnss_parse_gsv, .type = "GLGSV"},
+    {.id = NMEA_ID('G','P','G','S','V'), .field = gnss_gsv_field,
+        .commit = gnss_gsv_commit},
+    {.id = NMEA_ID('G','L','G','S','V'), .field = gnss_gsv_field,
+        .commit = gnss_gsv_commit},
 #endif
-    {.parse = gnss_parse_gga, .type = "GNGGA"},
+    {.id = NMEA_ID('G','N','G','G','A'), .field = gnss_gga_field,
+        .commit = gnss_gga_commit},
 #ifdef GNSS_STORE_IN_USE_SAT_SVS
     // Don't need to parse both GSA sentences if we are not keeping track of
     // satellite numbers
-    {.parse = gnss_parse_gsa, .type = "GLGSA"},
+    {.id = NMEA_ID('G','L','G','S','A'), .field = gnss_gsa_field,
+        .commit = gnss_gsa_commit},
 #endif
-    {.parse = gnss_parse_gsa, .type = "GPGSA"},
-    {.parse = gnss_parse_pgack, .type = "PGACK"}
+    {.id = NMEA_ID('G','P','G','S','A'), .field = gnss_gsa_field,
+        .commit = gnss_gsa_commit},
+    {.id = NMEA_ID('P','G','A','C','K'), .field = gnss_pgack_field,
+        .commit = gnss_pgack_commit}
 };
 
+#define NUM_NMEA_PARSERS (sizeof(nmea_parsers) / sizeof(nmea_parsers[0]))
+
 
 /**
- *  Verify the checksum of a NMEA sentence. The first character of the sentence
- *  (should be '$') is skipped.
- *
- *  @param str The sentence to be verified
+ *  Send a command to the GNSS module. The start character, checksum and line
+ *  ending are added.
  *
- *  @return 0 if the checksum is incorrect or the sentence is otherwise invalid,
- *          a positive integer otherwise
+ *  @param body The body of the command
  */
-static uint8_t verify_checksum (char *str)
+static void gnss_send_command (const char *body)
 {
-    uint8_t checksum = str[1];
-    uint8_t i;
+    static const char hex[] = "0123456789ABCDEF";
     
-    for (i = 2; (str[i] != '*') && (str[i] != '\0'); i++) {
-        checksum ^= str[i];
+    uint8_t checksum = 0;
+    for (const char *c = body; *c != '\0'; c++) {
+        checksum ^= (uint8_t)*c;
     }
     
-    if (str[i] != '*') {
-        // No checksum present
-        return 0;
-    }
+    char end[] = "*00\r\n";
+    end[1] = hex[checksum >> 4];
+    end[2] = hex[checksum & 0xF];
     
-    char* end;
-    uint8_t chk = strtoul(str + i + 1, &end, 16);
-    return (*end == '\0') ? (checksum == chk) : 0;
+    sercom_uart_put_string_blocking(gnss_uart, "$");
+    sercom_uart_put_string_blocking(gnss_uart, body);
+    sercom_uart_put_string_blocking(gnss_uart, end);
 }
 
-
-static void gnss_line_callback (char *line, struct console_desc_t *console,
-                                void *context)
+/**
+ *  Send the commands to configure the GNSS module's fix rate and outputs.
+ */
+static void gnss_send_config (void)
 {
-    if (!verify_checksum(line)) {
-        return;
-    }
+    char cmd[48];
     
-    gnss_xa1110_descriptor.last_sentence = millis;
+    // Set output/fix rate
+    strcpy(cmd, "PMTK220,");
+    utoa(1000 / gnss_mode.fix_rate, cmd + strlen(cmd), 10);
+    gnss_send_command(cmd);
+    // Set navigation mode to "avionic"
+    gnss_send_command("PMTK886,2");
+    // Disable EPE information sentence
+    gnss_send_command("PGCMD,231,1");
+    // Enable RMC and GGA every fix and GSA and GSV at the calculated rates
+    strcpy(cmd, "PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0");
+    cmd[16] = (char)('0' + gnss_mode.gsa_divisor);
+    cmd[18] = (char)('0' + gnss_mode.gsv_divisor);
+    gnss_send_command(cmd);
     
-    /* Count the number of comma separated tokens in the line */
-    uint8_t num_args = 1;
-    for (uint16_t i = 0; i < strlen(line); i++) {
-        num_args += (line[i] == ',');
+    // Poll antenna advisor
+    gnss_send_command("PGCMD,203");
+}
+
+/**
+ *  Send the command to change the GNSS module's baud rate.
+ *
+ *  @param baud The new baud rate
+ */
+static void gnss_send_baud (uint32_t baud)
+{
+    char cmd[16];
+    strcpy(cmd, "PMTK251,");
+    utoa(baud, cmd + strlen(cmd), 10);
+    gnss_send_command(cmd);
+}
+
+/**
+ *  Find the number of bytes per second sent by the GNSS module in a given
+ *  mode, assuming that every sentence is as long as possible.
+ *
+ *  @param mode The output configuration
+ *
+ *  @return The number of bytes per second
+ */
+static uint32_t gnss_mode_bytes_per_second (const struct gnss_xa1110_mode *mode)
+{
+    // RMC and GGA every fix
+    uint32_t sentences = 2 * (uint32_t)mode->fix_rate;
+    // GSA and GSV for both GPS and GLONASS, multiplied by the largest divisor
+    // so that fractional rates are accounted for
+    uint32_t other = 0;
+    if (mode->gsa_divisor != 0) {
+        other += ((2 * (uint32_t)mode->fix_rate * GNSS_MAX_DIVISOR) /
+                  mode->gsa_divisor);
     }
+    if (mode->gsv_divisor != 0) {
+        other += ((2 * GNSS_NUM_GSV_SENTENCES * (uint32_t)mode->fix_rate *
+                   GNSS_MAX_DIVISOR) / mode->gsv_divisor);
+    }
+    sentences += (other + GNSS_MAX_DIVISOR - 1) / GNSS_MAX_DIVISOR;
     
-    /* Create an array of pointers to each token */
-    // Array is one large to leave room for NULL pointer
-    char *args[num_args + 1];
-    for (uint16_t i = 0; (args[i] = strsep(&line, ",")) != NULL; i++);
-    
-    /* Run parser for received sentence */
-    uint8_t num_parsers = sizeof(nmea_parsers)/sizeof(nmea_parsers[0]);
-    for (int i = 0; i < num_parsers; i++) {
-        if (!strcasecmp(args[0] + 1, nmea_parsers[i].type)) {
-            nmea_parsers[i].parse(num_args, args, &gnss_xa1110_descriptor);
-            break;
-        }
+    return sentences * GNSS_MAX_SENTENCE_LENGTH;
+}
+
+/**
+ *  Limit the number of fixes between sentences to what the module supports.
+ */
+static inline uint8_t gnss_clamp_divisor (uint32_t divisor)
+{
+    if (divisor < 1) {
+        return 1;
+    } else if (divisor > GNSS_MAX_DIVISOR) {
+        return GNSS_MAX_DIVISOR;
     }
+    return (uint8_t)divisor;
 }
 
-static void gnss_init_callback (struct console_desc_t* console, void* context) {
-    // Set output/fix rate to once per second
-    console_send_str(console, "$PMTK220,1000*1F\r\n");
-    // Set navigation mode to "avionic"
-    console_send_str(console, "$PMTK886,2*2A\r\n");
-    // Disable EPE information sentence
-    console_send_str(console, "$PGCMD,231,1*5C\r\n");
+void gnss_xa1110_calc_mode (uint8_t fix_rate, struct gnss_xa1110_mode *mode)
+{
+    if (fix_rate < 1) {
+        fix_rate = 1;
+    } else if (fix_rate > GNSS_MAX_FIX_RATE) {
+        fix_rate = GNSS_MAX_FIX_RATE;
+    }
+    
+    mode->fix_rate = fix_rate;
+    mode->gsa_divisor = gnss_clamp_divisor((uint32_t)fix_rate *
+                                           GNSS_GSA_PERIOD);
 #ifdef GNSS_STORE_IN_VIEW_SAT_INFO
-    // Enable RMC every fix, GGA and GSA every 3 fixes and GSV every 5 fixes
-    console_send_str(console, "$PMTK314,0,1,0,3,3,5,0,0,0,0,0,0,0,0,0,0,0,0,0"
-                              "*08\r\n");
+    mode->gsv_divisor = gnss_clamp_divisor((uint32_t)fix_rate *
+                                           GNSS_GSV_PERIOD);
 #else
-    // Enable RMC every fix and GGA and GSA every 3 fixes
-    console_send_str(console, "$PMTK314,0,1,0,3,3,0,0,0,0,0,0,0,0,0,0,0,0,0,0"
-                              "*0D\r\n");
+    mode->gsv_divisor = 0;
 #endif
     
-    // Poll antenna advisor
-    console_send_str(console, "$PGCMD,203*40\r\n");
+    // Find the slowest baud rate which can carry the sentences without using
+    // too much of the bandwidth, if even the fastest baud rate is not enough
+    // the satellite information and then the DOP sentences are dropped
+    for (;;) {
+        // Each byte is 10 bits on the wire
+        uint32_t const min_baud = ((gnss_mode_bytes_per_second(mode) * 10 *
+                                    100) / GNSS_MAX_UART_LOAD);
+        for (uint8_t i = 0; i < NUM_GNSS_BAUDS; i++) {
+            if (gnss_bauds[i] >= min_baud) {
+                mode->baud = gnss_bauds[i];
+                return;
+            }
+        }
+        
+        if (mode->gsv_divisor != 0) {
+            mode->gsv_divisor = 0;
+        } else if (mode->gsa_divisor != 0) {
+            mode->gsa_divisor = 0;
+        } else {
+            mode->baud = gnss_bauds[NUM_GNSS_BAUDS - 1];
+            return;
+        }
+    }
 }
 
-uint8_t init_gnss_xa1110 (struct console_desc_t* console)
+uint8_t init_gnss_xa1110 (struct sercom_uart_desc_t *uart, uint8_t fix_rate)
 {
-    console_set_line_callback(console, gnss_line_callback, NULL);
-    console_set_init_callback(console, gnss_init_callback, NULL);
+    gnss_uart = uart;
+    gnss_valid_sentences = 0;
+    gnss_rmc_time = GNSS_NO_FIX_TIME;
+    gnss_gga_time = GNSS_NO_FIX_TIME;
+    init_nmea_parser(&gnss_parser, nmea_parsers, NUM_NMEA_PARSERS,
+                     &gnss_xa1110_descriptor);
+    
+    // Start by listening at the baud rate the UART was configured with
+    gnss_baud_index = NUM_GNSS_BAUDS - 1;
+    for (uint8_t i = 0; i < NUM_GNSS_BAUDS; i++) {
+        if (gnss_bauds[i] == sercom_uart_get_baud(uart)) {
+            gnss_baud_index = i;
+            break;
+        }
+    }
+    
+    gnss_xa1110_set_fix_rate(fix_rate);
     return 0;
 }
 
+void gnss_xa1110_set_fix_rate (uint8_t fix_rate)
+{
+    gnss_xa1110_calc_mode(fix_rate, &gnss_mode);
+    
+    // Configure the module once we hear from it
+    gnss_state = GNSS_STATE_SEARCH;
+    gnss_state_time = millis;
+}
+
+const struct gnss_xa1110_mode *gnss_xa1110_get_mode (void)
+{
+    return &gnss_mode;
+}
+
+/**
+ *  Discard any data which has been received from the GNSS module but not yet
+ *  parsed.
+ */
+static void gnss_discard_received (void)
+{
+    const uint8_t *data;
+    uint16_t length;
+    while ((length = sercom_uart_get_received(gnss_uart, &data)) != 0) {
+        sercom_uart_consume(gnss_uart, length);
+    }
+}
+
+void gnss_xa1110_service (void)
+{
+    /* Parse received data in place in the UART input buffer */
+    // The received data is in at most two contiguous pieces, only parsing that
+    // much keeps a constant stream of data from holding up the main loop
+    for (uint8_t i = 0; i < 2; i++) {
+        const uint8_t *data;
+        uint16_t const length = sercom_uart_get_received(gnss_uart, &data);
+        if (length == 0) {
+            break;
+        }
+        nmea_parse(&gnss_parser, data, length);
+        if (sercom_uart_consume(gnss_uart, length) != 0) {
+            // Some of the data was overwritten while it was being parsed
+            nmea_discard_sentence(&gnss_parser);
+        }
+    }
+    
+    uint8_t const got_sentence = (gnss_parser.valid_sentences !=
+                                  gnss_valid_sentences);
+    if (got_sentence) {
+        gnss_valid_sentences = gnss_parser.valid_sentences;
+        gnss_xa1110_descriptor.last_sentence = millis;
+    }
+    
+    /* Configure the module */
+    switch (gnss_state) {
+        case GNSS_STATE_SEARCH:
+            if (got_sentence) {
+                // The module is using the same baud rate as us
+                if (sercom_uart_get_baud(gnss_uart) != gnss_mode.baud) {
+                    gnss_send_baud(gnss_mode.baud);
+                    gnss_state_time = millis;
+                    gnss_state = GNSS_STATE_CHANGE_BAUD;
+                } else {
+                    gnss_send_config();
+                    gnss_state = GNSS_STATE_RUNNING;
+                }
+            } else if ((millis - gnss_state_time) > GNSS_SEARCH_TIMEOUT) {
+                // Try the next baud rate
+                gnss_baud_index = (gnss_baud_index + 1) % NUM_GNSS_BAUDS;
+                sercom_uart_set_baud(gnss_uart, gnss_bauds[gnss_baud_index]);
+                gnss_discard_received();
+                gnss_state_time = millis;
+            }
+            break;
+        case GNSS_STATE_CHANGE_BAUD:
+            // Wait for the last character of the command to have been shifted
+            // out before changing our baud rate
+            if (sercom_uart_tx_idle(gnss_uart)) {
+                sercom_uart_set_baud(gnss_uart, gnss_mode.baud);
+                gnss_discard_received();
+                for (uint8_t i = 0; i < NUM_GNSS_BAUDS; i++) {
+                    if (gnss_bauds[i] == gnss_mode.baud) {
+                        gnss_baud_index = i;
+                    }
+                }
+                // Make sure that the module can be heard at the new baud rate
+                // before configuring it
+                gnss_state_time = millis;
+                gnss_state = GNSS_STATE_SEARCH;
+            }
+            break;
+        case GNSS_STATE_RUNNING:
+            if ((millis - gnss_xa1110_descriptor.last_sentence) >
+                    GNSS_LOST_TIMEOUT) {
+                // The module may have been reset, find it again
+                gnss_state_time = millis;
+                gnss_state = GNSS_STATE_SEARCH;
+            }
+            break;
+    }
+}
+
+uint32_t gnss_xa1110_get_checksum_errors (void)
+{
+    return gnss_parser.checksum_errors;
+}
@@ -10,7 +10,8 @@
 #define gnss_h
 
 #include "global.h"
-#include "console.h"
+#include "sercom-uart.h"
+#include "nmea.h"
 
 /* Define in order to parse store the satellite numbers of in use satellites */
 #define GNSS_STORE_IN_USE_SAT_SVS
@@ -22,6 +23,9 @@
 #define GPS_SV_OFFSET       0
 #define GLONASS_SV_OFFSET   65
 
+/* Fastest fix rate supported by the module in Hz */
+#define GNSS_MAX_FIX_RATE   10
+
 /**
  *  Type of fix reported by the GNSS module.
  */
@@ -145,14 +149,71 @@ extern struct gnss {
 
 
 
+/**
+ *  Output configuration for the GNSS module.
+ */
+struct gnss_xa1110_mode {
+    /** Baud rate used to communicate with the module */
+    uint32_t baud;
+    /** Number of fixes per second */
+    uint8_t fix_rate;
+    /** Number of fixes between GSA sentences, 0 if GSA sentences are
+        disabled */
+    uint8_t gsa_divisor;
+    /** Number of fixes between GSV sentences, 0 if GSV sentences are
+        disabled */
+    uint8_t gsv_divisor;
+};
+
+
 /**
  *  Configures the descriptor structure with all the necessary data for the GNSS
  *  reciever to work. Begin the process of sending any commands to the module
  *  that are necessary to initialize it.
  *
- *  @param console Console used to communicate with GNSS module
+ *  @param uart UART used to communicate with GNSS module
+ *  @param fix_rate Number of fixes per second
+ */
+extern uint8_t init_gnss_xa1110(struct sercom_uart_desc_t *uart,
+                                uint8_t fix_rate);
+
+/**
+ *  Change the GNSS module's fix rate. The sentences output by the module and
+ *  the baud rate are chosen so that the UART is not overloaded.
+ *
+ *  @param fix_rate Number of fixes per second
+ */
+extern void gnss_xa1110_set_fix_rate(uint8_t fix_rate);
+
+/**
+ *  Find the output configuration for the GNSS module for a given fix rate.
+ *  RMC and GGA sentences are sent with every fix. GSA and GSV sentences are
+ *  sent less often and the slowest baud rate which can carry all of the
+ *  sentences is chosen. If even the fastest baud rate is not fast enough,
+ *  GSV and then GSA sentences are disabled.
+ *
+ *  @param fix_rate Number of fixes per second
+ *  @param mode Structure in which the configuration will be stored
+ */
+extern void gnss_xa1110_calc_mode(uint8_t fix_rate,
+                                  struct gnss_xa1110_mode *mode);
+
+/**
+ *  Get the current output configuration for the GNSS module.
+ */
+extern const struct gnss_xa1110_mode *gnss_xa1110_get_mode(void);
+
+/**
+ *  Parse any data which has been received from the GNSS module. Should be
+ *  called in each iteration of the main loop.
+ */
+extern void gnss_xa1110_service(void);
+
+/**
+ *  Get the number of sentences which have been received from the GNSS module
+ *  with incorrect or missing checksums.
  */
-extern uint8_t init_gnss_xa1110(struct console_desc_t* console);
+extern uint32_t gnss_xa1110_get_checksum_errors(void);
 
 
 #endif /* gnss_h */
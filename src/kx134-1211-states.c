@@ -10,6 +10,8 @@
 #include "kx134-1211-states.h"
 #include "kx134-1211-registers.h"
 
+#include "timebase.h"
+
 // MARK: Constants
 #define KX134_1211_POWER_ON_DELAY           MS_TO_MILLIS(50)
 #define KX134_1211_SW_RESET_DELAY           MS_TO_MILLIS(5)
@@ -567,32 +569,29 @@ static int kx134_1211_handle_config(struct kx134_1211_desc_t *inst)
 
 static int kx134_1211_handle_running(struct kx134_1211_desc_t *inst)
 {
+    // Reads are normally started from interrupts and callbacks. Retry any
+    // which could not be started because the SPI queue was full. The sensor
+    // does not generate any more interrupts while a read is pending, so the
+    // flags can not be changed under us.
+    if (inst->buffer_read_pending) {
+        if (kx134_1211_start_buffer_read(inst,
+                                         inst->pending_watermark_time) == 0) {
+            inst->buffer_read_pending = 0;
+        }
+    } else if (inst->output_read_pending) {
+        if (kx134_1211_start_output_read(inst) == 0) {
+            inst->output_read_pending = 0;
+        }
+    }
+
     return 0;
 }
 
 int kx134_1211_handle_read_buffer(struct kx134_1211_desc_t *inst)
 {
-    inst->last_reading_time = millis;
-
-    // TODO: Check out a buffer of some kind from logging service
-
-    inst->buffer[0] = KX134_1211_REG_BUF_READ | KX134_1211_READ;
-
-    uint16_t const in_length = ((inst->resolution == KX134_1211_RES_8_BIT) ?
-                                (KX134_1211_SAMPLE_THRESHOLD_8BIT * 3) :
-                                (KX134_1211_SAMPLE_THRESHOLD_16BIT * 6));
-
-    uint8_t const ret = sercom_spi_start_with_cb(inst->spi_inst, &inst->t_id,
-                                                 KX134_1211_BAUDRATE,
-                                                 inst->cs_pin_group,
-                                                 inst->cs_pin_mask,
-                                                 inst->buffer, 1, inst->buffer,
-                                                 in_length,
-                                                 kx134_1211_spi_callback, inst);
-
-    if (ret == 0) {
-        // Success fully queued SPI transaction, end of transaction will be
-        // handled in 
+    if (kx134_1211_start_buffer_read(inst, timebase_micros()) == 0) {
+        // Successfully queued SPI transaction, end of transaction will be
+        // handled in kx134_1211_spi_callback()
         inst->state = KX134_1211_RUNNING;
     }
 
@@ -19,6 +19,30 @@ typedef int (*kx134_1211_state_handler_t)(struct kx134_1211_desc_t *inst);
 extern void kx134_1211_spi_callback(void *context);
 extern int kx134_1211_handle_read_buffer(struct kx134_1211_desc_t *inst);
 
+/**
+ *  Start reading the sensor's sample buffer. The samples are read directly into
+ *  a buffer checked out from the telemetry service. If no buffer can be checked
+ *  out, the samples are discarded and only the most recent sample is read.
+ *  kx134_1211_spi_callback() is called when the read is complete.
+ *
+ *  @param inst The driver instance for which the buffer should be read
+ *  @param watermark_time Timebase time at which the watermark was reached
+ *
+ *  @return 0 if the read was started, a non-zero value otherwise
+ */
+extern uint8_t kx134_1211_start_buffer_read(struct kx134_1211_desc_t *inst,
+                                            uint32_t watermark_time);
+
+/**
+ *  Start reading the most recent sample from the sensor's output registers.
+ *  kx134_1211_spi_callback() is called when the read is complete.
+ *
+ *  @param inst The driver instance for which the sample should be read
+ *
+ *  @return 0 if the read was started, a non-zero value otherwise
+ */
+extern uint8_t kx134_1211_start_output_read(struct kx134_1211_desc_t *inst);
+
 
 /**
  *  Array of functions for handling FSM states.
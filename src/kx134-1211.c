@@ -11,11 +11,59 @@
 #include "kx134-1211-states.h"
 #include "kx134-1211-registers.h"
 
+#include "timebase.h"
+
+#include <string.h>
+
 // Interrupt handling functions
 static void kx134_1211_int1_callback(void *context, union gpio_pin_t pin,
                                      uint8_t value);
 
 
+// MARK: Helpers
+
+/**
+ *  Get the nominal interval between samples for an output data rate.
+ *
+ *  @param odr The output data rate
+ *
+ *  @return The nominal sample period in 256ths of a microsecond
+ */
+static uint32_t kx134_1211_nominal_period(enum kx134_1211_odr odr)
+{
+    // 25.6 kHz gives a period of 39.0625 us, or 10000 256ths of a microsecond,
+    // and each slower data rate is half of the next faster one
+    return 10000UL << (KX134_1211_ODR_25600000 - odr);
+}
+
+/**
+ *  Update the sample period estimate from the time between two watermark
+ *  interrupts.
+ *
+ *  @param inst The driver instance
+ *  @param watermark_time Time of the latest watermark interrupt
+ *  @param num_samples Number of samples in the sensor's buffer at the watermark
+ */
+static void kx134_1211_update_period(struct kx134_1211_desc_t *inst,
+                                     uint32_t watermark_time,
+                                     uint16_t num_samples)
+{
+    if (inst->watermark_time_valid) {
+        uint32_t const period = (uint32_t)(((uint64_t)(watermark_time -
+                                                       inst->watermark_time) <<
+                                            8) / num_samples);
+        // Ignore measurements that are more than 25% off from the nominal
+        // period, they are the result of interrupts that were missed or
+        // serviced late
+        uint32_t const nominal = kx134_1211_nominal_period(inst->odr);
+        if ((period > (nominal - (nominal / 4))) &&
+                (period < (nominal + (nominal / 4)))) {
+            inst->sample_period = ((inst->sample_period * 3) + period) / 4;
+        }
+    }
+    inst->watermark_time = watermark_time;
+}
+
 // MARK: Public Functions
 
 void init_kx134_1211 (struct kx134_1211_desc_t *inst,
@@ -43,6 +91,10 @@ void init_kx134_1211 (struct kx134_1211_desc_t *inst,
     inst->delay_done = 0;
     inst->cmd_ready = 0;
     inst->spi_in_progress = 0;
+    inst->watermark_time_valid = 0;
+    inst->buffer_read_pending = 0;
+    inst->output_read_pending = 0;
+    inst->sample_period = kx134_1211_nominal_period(odr);
 
     // Configure interrupt pin
     gpio_set_pin_mode(int1_pin, GPIO_PIN_INPUT);
@@ -97,52 +149,156 @@ void kx134_1211_service (struct kx134_1211_desc_t *inst)
 
 // MARK: Callbacks
 
-static void kx134_1211_int1_callback(void *context, union gpio_pin_t pin,
-                                     uint8_t value)
+uint8_t kx134_1211_start_output_read(struct kx134_1211_desc_t *inst)
+{
+    inst->buffer[0] = KX134_1211_REG_XOUT_L | KX134_1211_READ;
+
+    return sercom_spi_start_with_cb(inst->spi_inst, &inst->t_id,
+                                    KX134_1211_BAUDRATE, inst->cs_pin_group,
+                                    inst->cs_pin_mask, inst->buffer, 1,
+                                    inst->buffer, 6, kx134_1211_spi_callback,
+                                    inst);
+}
+
+/**
+ *  Callback for when the sensor's sample buffer has been cleared because there
+ *  was nowhere to put the samples. Reads the most recent sample from the
+ *  output registers instead.
+ */
+static void kx134_1211_buffer_clear_callback(void *context)
 {
     struct kx134_1211_desc_t *const inst = (struct kx134_1211_desc_t *)context;
 
-    inst->next_reading_time = millis;
+    if (kx134_1211_start_output_read(inst) != 0) {
+        // The SPI queue is full, have the service function try again
+        inst->output_read_pending = 1;
+        sched_event_signal(&inst->event);
+    }
+}
 
-    // Read from sample buffer
-    inst->buffer[0] = KX134_1211_REG_BUF_READ | KX134_1211_READ;
+uint8_t kx134_1211_start_buffer_read(struct kx134_1211_desc_t *inst,
+                                     uint32_t watermark_time)
+{
+    if (!sercom_spi_queue_has_space(inst->spi_inst)) {
+        // Don't check out a telemetry buffer that we might not be able to fill
+        return 1;
+    }
 
+    inst->next_reading_time = millis;
+
+    uint16_t const num_samples = ((inst->resolution == KX134_1211_RES_8_BIT) ?
+                                  KX134_1211_SAMPLE_THRESHOLD_8BIT :
+                                  KX134_1211_SAMPLE_THRESHOLD_16BIT);
     uint16_t const in_length = ((inst->resolution == KX134_1211_RES_8_BIT) ?
-                                (KX134_1211_SAMPLE_THRESHOLD_8BIT * 3) :
-                                (KX134_1211_SAMPLE_THRESHOLD_16BIT * 6));
+                                (num_samples * 3) : (num_samples * 6));
+
+    kx134_1211_update_period(inst, watermark_time, num_samples);
+
+    // The watermark time is the time of the newest sample in the buffer, work
+    // back to find the time of the oldest one
+    uint32_t const sample_time = (watermark_time -
+                                  (uint32_t)(((uint64_t)(num_samples - 1) *
+                                              inst->sample_period) >> 8));
 
     // Try to get a buffer from the telemetry service to put the data into
     uint8_t *buffer = NULL;
     if (inst->telem != NULL) {
         buffer = telemetry_post_kx134_accel(inst->telem,
-                                            inst->next_reading_time, inst->odr,
+                                            inst->next_reading_time,
+                                            sample_time, inst->sample_period,
+                                            inst->odr,
                                             inst->range, inst->rolloff,
                                             inst->resolution, in_length);
     }
 
     if (buffer == NULL) {
-        buffer = inst->buffer;
-    } else {
-        inst->telem_buffer = buffer;
-        inst->telem_buffer_write = 1;
+        // There is nowhere to put the samples, clear the sensor's buffer so
+        // that the watermark interrupt is released and then read only the most
+        // recent sample. Clearing the buffer means that the next watermark
+        // will not come exactly one watermark worth of samples after this one.
+        inst->watermark_time_valid = 0;
+        inst->buffer[0] = KX134_1211_REG_BUF_CLEAR | KX134_1211_WRITE;
+        inst->buffer[1] = 0;
+        return sercom_spi_start_with_cb(inst->spi_inst, &inst->t_id,
+                                        KX134_1211_BAUDRATE, inst->cs_pin_group,
+                                        inst->cs_pin_mask, inst->buffer, 2,
+                                        inst->buffer, 0,
+                                        kx134_1211_buffer_clear_callback, inst);
     }
 
-    sercom_spi_start_with_cb(inst->spi_inst, &inst->t_id, KX134_1211_BAUDRATE,
-                             inst->cs_pin_group, inst->cs_pin_mask,
-                             inst->buffer, 1, buffer, in_length,
-                             kx134_1211_spi_callback, inst);
+    // Read from sample buffer directly into the telemetry buffer
+    inst->watermark_time_valid = 1;
+    inst->telem_buffer = buffer;
+    inst->telem_buffer_write = 1;
+    inst->buffer[0] = KX134_1211_REG_BUF_READ | KX134_1211_READ;
+
+    uint8_t const ret = sercom_spi_start_with_cb(inst->spi_inst, &inst->t_id,
+                                                 KX134_1211_BAUDRATE,
+                                                 inst->cs_pin_group,
+                                                 inst->cs_pin_mask,
+                                                 inst->buffer, 1, buffer,
+                                                 in_length,
+                                                 kx134_1211_spi_callback, inst);
+    if (ret != 0) {
+        // The SPI queue was filled from an interrupt since we checked it, give
+        // the telemetry buffer back without logging any samples
+        telemetry_abandon_kx134_accel(inst->telem, buffer);
+        inst->telem_buffer_write = 0;
+    }
+    return ret;
 }
 
-void kx134_1211_spi_callback(void *context)
+static void kx134_1211_int1_callback(void *context, union gpio_pin_t pin,
+                                     uint8_t value)
 {
     struct kx134_1211_desc_t *const inst = (struct kx134_1211_desc_t *)context;
 
-    // We have read to the sample buffer
-    uint8_t *const buffer = inst->telem_buffer_write ? inst->telem_buffer :
-                                                       inst->buffer;
+    // Get the time of the interrupt before doing anything else so that as
+    // little latency as possible is included if it was not captured in hardware
+    uint32_t const watermark_time = timebase_get_event_time(pin);
+
+    sched_event_signal(&inst->event);
+
+    if (kx134_1211_start_buffer_read(inst, watermark_time) != 0) {
+        // The SPI queue is full. The watermark interrupt will not be asserted
+        // again until the buffer has been read, so the service function must
+        // try again.
+        inst->pending_watermark_time = watermark_time;
+        inst->buffer_read_pending = 1;
+    }
+}
+
+void kx134_1211_spi_callback(void *context)
+{
+    struct kx134_1211_desc_t *const inst = (struct kx134_1211_desc_t *)context;
 
     // Save last reading
     inst->last_reading_time = inst->next_reading_time;
+
+    // The tasks which are woken are not run until this interrupt has returned
+    // and the new sample has been stored
+    sched_event_signal(&inst->event);
+
+    if (!inst->telem_buffer_write) {
+        // Only the most recent sample was read from the output registers,
+        // which always have 16 bit resolution
+        int16_t const *const sample = (int16_t *)__builtin_assume_aligned(
+                                                            inst->buffer, 2);
+        if (inst->resolution == KX134_1211_RES_8_BIT) {
+            inst->last_x = sample[0] >> 8;
+            inst->last_y = sample[1] >> 8;
+            inst->last_z = sample[2] >> 8;
+        } else {
+            inst->last_x = sample[0];
+            inst->last_y = sample[1];
+            inst->last_z = sample[2];
+        }
+        return;
+    }
+
+    // We have read the sample buffer into a telemetry buffer
+    uint8_t *const buffer = inst->telem_buffer;
+
     if (inst->resolution == KX134_1211_RES_8_BIT) {
         // 8-Bit samples
         int8_t *const samples = ((int8_t*)buffer +
@@ -159,9 +315,7 @@ void kx134_1211_spi_callback(void *context)
         inst->last_z = samples[2];
     }
 
-    // Check in telemetry buffer if we used one
-    if (inst->telem_buffer_write) {
-        telemetry_finish_kx134_accel(inst->telem, inst->telem_buffer);
-        inst->telem_buffer_write = 0;
-    }
+    // Check in telemetry buffer
+    telemetry_finish_kx134_accel(inst->telem, inst->telem_buffer);
+    inst->telem_buffer_write = 0;
 }
@@ -142,12 +142,18 @@ struct kx134_1211_desc_t {
     /** Telemetry service instance */
     struct telemetry_service_desc_t *telem;
 
+    /** Tasks to be marked ready when the sensor's interrupt pin is asserted
+        and when new samples have been read */
+    struct sched_event_t event;
+
     /** Mask for SPI chip select pin */
     uint32_t cs_pin_mask;
 
-    /** Buffer for commands and data from sensor */
-    uint8_t buffer[480];
+    /** Buffer for commands and register data, samples from the sensor's
+        buffer are read directly into telemetry service buffers */
+    uint8_t buffer[16];
 
+    /** Telemetry service buffer into which samples are being read */
     uint8_t *telem_buffer;
 
     /** Time of last reading from sensor */
@@ -160,6 +166,13 @@ struct kx134_1211_desc_t {
         /** Time used for delays during initialization */
         uint32_t init_delay_start_time;
     };
+    /** Timebase time of the most recent watermark interrupt in microseconds */
+    uint32_t watermark_time;
+    /** Timebase time of a watermark interrupt for which the buffer read could
+        not be started */
+    uint32_t pending_watermark_time;
+    /** Estimated interval between samples in 256ths of a microsecond */
+    uint32_t sample_period;
     /** X acceleration from last sensor reading */
     int16_t last_x;
     /** Y acceleration from last sensor reading */
@@ -199,6 +212,16 @@ struct kx134_1211_desc_t {
     uint8_t spi_in_progress:1;
     /** Flag to indicate that we currently are writing to a telemetry buffer */
     uint8_t telem_buffer_write:1;
+    /** Flag to indicate that exactly one watermark worth of samples has been
+        produced since watermark_time */
+    uint8_t watermark_time_valid:1;
+    /** Flag to indicate that a buffer read could not be started from the
+        watermark interrupt and must be retried by the service function */
+    uint8_t buffer_read_pending:1;
+    /** Flag to indicate that an output register read could not be started after
+        the sensor's buffer was cleared and must be retried by the service
+        function */
+    uint8_t output_read_pending:1;
 };
 
 /**
@@ -309,6 +332,8 @@ static inline uint16_t kx134_1211_get_sensitivity(
  *
  *  @param inst Telemetry service instance
  *  @param time Mission time for data being posted
+ *  @param sample_time Time of the first sample in microseconds
+ *  @param sample_period Interval between samples in 256ths of a microsecond
  *  @param odr Output data rate
  *  @param range Acceleration range
  *  @param roll Low-pass filter rolloff
@@ -320,7 +345,9 @@ static inline uint16_t kx134_1211_get_sensitivity(
  */
 extern uint8_t *telemetry_post_kx134_accel(
                                         struct telemetry_service_desc_t *inst,
-                                        uint32_t time, enum kx134_1211_odr odr,
+                                        uint32_t time, uint32_t sample_time,
+                                        uint32_t sample_period,
+                                        enum kx134_1211_odr odr,
                                         enum kx134_1211_range range,
                                         enum kx134_1211_low_pass_rolloff roll,
                                         enum kx134_1211_resolution res,
@@ -336,4 +363,15 @@ extern uint8_t *telemetry_post_kx134_accel(
 extern int telemetry_finish_kx134_accel(struct telemetry_service_desc_t *inst,
                                         uint8_t *buffer);
 
+/**
+ *  Return a buffer received from telemetry_post_kx134_accel() to the telemetry
+ *  service without recording its contents. The space that had been reserved
+ *  for the buffer is logged as a spacer block.
+ *
+ *  @param inst Telemetry service instance
+ *  @param buffer The buffer to be abandoned.
+ */
+extern int telemetry_abandon_kx134_accel(struct telemetry_service_desc_t *inst,
+                                         uint8_t *buffer);
+
 #endif /* kx134_1211_h */
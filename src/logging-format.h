@@ -12,7 +12,8 @@
 
 #include <stdint.h>
 
-#define LOGGING_FORMAT_VERSION  1
+/** Version 2 added sample times to the IMU and accelerometer payloads */
+#define LOGGING_FORMAT_VERSION  2
 
 #define LOGGING_SB_MAGIC        "CUInSpac"
 #define LOGGING_SB_NUM_FLIGHTS  32
@@ -63,7 +64,52 @@ enum logging_metadata_block_type {
 };
 
 enum logging_diag_block_type {
-    LOGGING_DIAG_TYPE_MSG = 0x0
+    LOGGING_DIAG_TYPE_MSG = 0x0,
+    LOGGING_DIAG_TYPE_PROFILE = 0x1
+};
+
+
+/** Number of histogram buckets in each profile block entry */
+#define LOGGING_PROFILE_BUCKETS 16
+
+/**
+ *  Start of the payload for a profile diagnostic block. It is followed by
+ *  num_entries instances of struct logging_diag_profile_entry.
+ */
+struct logging_diag_profile_head {
+    /** Mission time at which the block was created */
+    uint32_t time;
+    /** Frequency of the clock used to measure execution times in Hz */
+    uint32_t tick_freq;
+    /** CPU clock frequency in Hz, interrupt latency is measured in cycles */
+    uint32_t cycle_freq;
+    /** Number of bits that values are shifted right before finding their
+        histogram bucket */
+    uint8_t hist_shift;
+    /** Number of entries in the block */
+    uint8_t num_entries;
+    uint16_t RESERVED;
+};
+
+/**
+ *  Statistics for a measured quantity in a profile diagnostic block. The
+ *  first three entries are always interrupt entry latency, time with
+ *  interrupts disabled and main loop pass time, followed by each scheduler
+ *  task in the order in which they are run.
+ */
+struct logging_diag_profile_entry {
+    /** Name of the measured quantity, not nul terminated if 8 chars long */
+    char name[8];
+    /** Number of recorded values */
+    uint32_t count;
+    /** Smallest recorded value */
+    uint32_t min;
+    /** Largest recorded value */
+    uint32_t max;
+    /** Mean of recorded values */
+    uint32_t mean;
+    /** Log base 2 histogram of recorded values */
+    uint16_t buckets[LOGGING_PROFILE_BUCKETS];
 };
 
 
@@ -17,31 +17,65 @@
 #define LOGGING_BUFFER_WRITE_INTERVAL   10000
 #define LOGGING_SB_WRITE_INTERVAL       20000
 #define LOGGING_WATERMARK               32
+/** Number of blocks at the start of a new flight to be erased ahead of time */
+#define LOGGING_PRE_ERASE_BLOCKS        ((64UL * 1024 * 1024) / SD_BLOCK_LENGTH)
+/** Number of blocks erased in each pre-erase operation. Data writes have to
+    wait for an ongoing erase, so the erase is done in small pieces. */
+#define LOGGING_PRE_ERASE_CHUNK_BLOCKS  ((1UL * 1024 * 1024) / SD_BLOCK_LENGTH)
 
 
 
 void init_logging(struct logging_desc_t *inst, sd_desc_ptr_t sd_desc,
                   struct sd_funcs sd_funcs, uint8_t continue_flight)
 {
-    inst->buffer[0].count = 0;
-    inst->buffer[0].checkout_count = 0;
-    inst->buffer[1].count = 0;
-    inst->buffer[1].checkout_count = 0;
+    for (int i = 0; i < LOGGING_NUM_BUFFERS; i++) {
+        inst->buffer[i].count = 0;
+        inst->buffer[i].checkout_count = 0;
+    }
 
     inst->sd_desc = sd_desc;
     inst->sd_funcs = sd_funcs;
 
     inst->init_retry_count = 0;
     inst->out_of_space_count = 0;
+    inst->max_write_latency = 0;
+    for (int i = 0; i < LOGGING_LATENCY_HIST_BUCKETS; i++) {
+        inst->write_latency_hist[i] = 0;
+    }
 
-    inst->insert_point = NULL;
+    inst->prod_cursor = 0;
+    inst->cons_cursor = 0;
+    inst->blocks_in_progress = 0;
+    inst->buffers_in_progress = 0;
+    inst->erase_next = 0;
+    inst->erase_end = 0;
     inst->continue_flight = !!continue_flight;
+    inst->erase_in_progress = 0;
     inst->state = LOGGING_GET_MBR;
     inst->should_pause = 0;
 
     logging_service(inst);
 }
 
+/**
+ *  Add the time taken by a data write to the write latency histogram.
+ *
+ *  @param inst Logging service instance descriptor
+ *  @param latency Time taken by write in milliseconds
+ */
+static void record_write_latency(struct logging_desc_t *inst, uint32_t latency)
+{
+    uint8_t bucket = (latency == 0) ? 0 : (32 - __builtin_clz(latency));
+    if (bucket >= LOGGING_LATENCY_HIST_BUCKETS) {
+        bucket = LOGGING_LATENCY_HIST_BUCKETS - 1;
+    }
+    inst->write_latency_hist[bucket]++;
+
+    if (latency > inst->max_write_latency) {
+        inst->max_write_latency = latency;
+    }
+}
+
 /**
  *  Callback function for when SD operation is complete.
  *
@@ -77,6 +111,15 @@ static void logging_sd_callback(void *context, enum sd_op_result result,
         }
         inst->sd_write_in_progress = 0;
         return;
+    } else if (inst->erase_in_progress) {
+        if (result != SD_OP_SUCCESS) {
+            // Pre-erasing is only an optimization, stop trying if the card
+            // does not support it
+            inst->erase_next = inst->erase_end;
+        }
+        inst->erase_in_progress = 0;
+        inst->sd_write_in_progress = 0;
+        return;
     }
 
     // Check if a buffer is being written
@@ -86,9 +129,16 @@ static void logging_sd_callback(void *context, enum sd_op_result result,
         return;
     }
 
+    if (result == SD_OP_SUCCESS) {
+        // Failed writes can return early and would skew the histogram
+        record_write_latency(inst, MILLIS_TO_MS(millis -
+                                                inst->last_data_write));
+    }
+
     if (num_blocks != inst->blocks_in_progress) {
         // Failed to write all of the blocks to the card, will need to try again
         inst->blocks_in_progress = 0;
+        inst->buffers_in_progress = 0;
         inst->sd_write_in_progress = 0;
         return;
     }
@@ -96,11 +146,19 @@ static void logging_sd_callback(void *context, enum sd_op_result result,
     // Write complete, increment num blocks
     inst->sb.flights[inst->flight].num_blocks += inst->blocks_in_progress;
 
-    // Clear buffer
-    inst->buffer[inst->buffer_write_num].count = 0;
-    inst->buffer[inst->buffer_write_num].pending_write = 0;
+    // Clear buffers
+    for (uint8_t i = 0; i < inst->buffers_in_progress; i++) {
+        inst->buffer[LOGGING_BUF_IDX(inst->cons_cursor + i)].count = 0;
+    }
+
+    // Release buffers back to producers, the counts must be cleared before this
+    // is done
+    __atomic_store_n(&inst->cons_cursor,
+                     (uint16_t)(inst->cons_cursor + inst->buffers_in_progress),
+                     __ATOMIC_SEQ_CST);
 
     inst->blocks_in_progress = 0;
+    inst->buffers_in_progress = 0;
     inst->sd_write_in_progress = 0;
     return;
 }
@@ -135,7 +193,71 @@ static int write_superblock(struct logging_desc_t *inst, uint8_t now)
 }
 
 /**
- *  Write a data buffer to the SD card if needed.
+ *  Close the buffer that is currently being filled and move the producer cursor
+ *  on to the next buffer in the ring.
+ *
+ *  @param inst Logging service instance descriptor
+ *  @param cursor Pointer to the value of the producer cursor that was last
+ *                loaded, will be updated with the new value of the cursor
+ *
+ *  @return 0 if the cursor has been moved on (possibly by someone else), 1 if
+ *          the ring is full
+ */
+static int advance_buffer(struct logging_desc_t *inst, uint32_t *cursor)
+{
+    uint16_t const next_seq = LOGGING_CURSOR_SEQ(*cursor) + 1;
+    uint16_t const cons = __atomic_load_n(&inst->cons_cursor, __ATOMIC_SEQ_CST);
+
+    if ((uint16_t)(next_seq - cons) >= LOGGING_NUM_BUFFERS) {
+        // The next buffer in the ring has not been written yet
+        return 1;
+    }
+
+    uint32_t const new_cursor = (uint32_t)next_seq << 16;
+    if (__atomic_compare_exchange_n(&inst->prod_cursor, cursor, new_cursor, 0,
+                                    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+        *cursor = new_cursor;
+    }
+    // If the exchange failed __atomic_compare_exchange_n will have updated
+    // cursor with the current value
+    return 0;
+}
+
+/**
+ *  Fill the unused part of the last SD card block in a buffer with a spacer.
+ *
+ *  @param inst Logging service instance descriptor
+ *  @param buf_idx Index of buffer to be padded
+ *
+ *  @return The number of SD card blocks in the padded buffer
+ */
+static uint16_t pad_buffer(struct logging_desc_t *inst, uint8_t buf_idx)
+{
+    uint16_t const count = inst->buffer[buf_idx].count;
+    uint16_t const blocks = ((count + (SD_BLOCK_LENGTH - 1)) / SD_BLOCK_LENGTH);
+    // Calculate how many unused bytes we have in the last block
+    uint16_t const extra_bytes = (blocks * SD_BLOCK_LENGTH) - count;
+
+    if (extra_bytes != 0) {
+        // Need to add a spacer to take up the rest of the last SD card block
+        logging_block_marshal_header(inst->data[buf_idx] + count,
+                                     LOGGING_BLOCK_CLASS_METADATA,
+                                     LOGGING_METADATA_TYPE_SPACER,
+                                     extra_bytes);
+        // Zero out everything after the spacer header
+        memset(inst->data[buf_idx] + count + 4, 0, extra_bytes - 4);
+        inst->buffer[buf_idx].count += extra_bytes;
+    }
+
+    return blocks;
+}
+
+/**
+ *  Write data buffers to the SD card if needed. All of the consecutive buffers
+ *  that are ready to be written are written in a single operation. If the SD
+ *  card driver supports vectored writes the buffers are passed to the driver
+ *  as a list of segments, so the run may wrap around the end of the ring and
+ *  include buffers that are only partly full.
  *
  *  @param inst Logging service instance descriptor
  */
@@ -147,109 +269,168 @@ static void write_buffer(struct logging_desc_t *inst)
         return;
     }
 
-    // Disable interrupts
-    uint32_t const old_primask = __get_PRIMASK();
-    __disable_irq();
-
-    // Find any full buffers and mark them as pending write
-    uint8_t const current_buf = (uintptr_t)inst->insert_point & 0x3;
-
+    uint32_t cursor = __atomic_load_n(&inst->prod_cursor, __ATOMIC_SEQ_CST);
+    uint16_t const offset = LOGGING_CURSOR_OFFSET(cursor);
 
-    for (int i = 0; i < LOGGING_NUM_BUFFERS; i++) {
-        if ((inst->buffer[i].count + LOGGING_WATERMARK) > LOGGING_BUFFER_SIZE) {
-            inst->buffer[i].pending_write = 1;
+    // Close the current buffer if it is almost full or if it has been too long
+    // since data was last written
+    if ((offset != 0) &&
+        (((offset + LOGGING_WATERMARK) > LOGGING_BUFFER_SIZE) ||
+         ((millis - inst->last_data_write) >= LOGGING_BUFFER_WRITE_INTERVAL))) {
+        advance_buffer(inst, &cursor);
+    }
 
-            if ((inst->insert_point != NULL) && (i == current_buf)) {
-                // This shouldn't be the active buffer anymore
-                inst->insert_point = NULL;
-            }
+    // Find the run of closed buffers, starting at the consumer cursor, that are
+    // not checked out and, unless we can do a vectored write, are contiguous in
+    // memory
+    uint8_t const vectored = inst->sd_funcs.write_v != NULL;
+    uint16_t const prod_seq = LOGGING_CURSOR_SEQ(cursor);
+    uint16_t seq = inst->cons_cursor;
+    uint16_t blocks = 0;
+    uint8_t num_buffers = 0;
+
+    while (seq != prod_seq) {
+        uint8_t const buf_idx = LOGGING_BUF_IDX(seq);
+
+        if ((inst->buffer[buf_idx].checkout_count != 0) ||
+            (!vectored && (num_buffers != 0) && (buf_idx == 0))) {
+            // Buffer is still being filled or run would wrap around the end of
+            // the ring
+            break;
         }
-    }
 
-    // Re-enable interrupts
-    __set_PRIMASK(old_primask);
+        if ((num_buffers == 0) && (inst->buffer[buf_idx].count == 0)) {
+            // Nothing to write in this buffer, release it right away
+            seq++;
+            __atomic_store_n(&inst->cons_cursor, seq, __ATOMIC_SEQ_CST);
+            continue;
+        }
 
-    // Check for timeout
-    if ((millis - inst->last_data_write) >= LOGGING_BUFFER_WRITE_INTERVAL) {
-        // Make the current buffer ready to write as long as there is data in it
-        if (inst->buffer[current_buf].count != 0) {
-            inst->buffer[current_buf].pending_write = 1;
+        uint16_t const buf_blocks = pad_buffer(inst, buf_idx);
+        if (vectored) {
+            inst->write_segments[num_buffers].data = inst->data[buf_idx];
+            inst->write_segments[num_buffers].num_blocks = buf_blocks;
         }
-    }
+        blocks += buf_blocks;
+        num_buffers++;
+        seq++;
 
-    // Check for buffers that are ready to write
-    uint8_t buf;
-    for (buf = 0; buf < LOGGING_NUM_BUFFERS; buf++) {
-        if (inst->buffer[buf].pending_write &&
-            (inst->buffer[buf].checkout_count == 0)) {
+        if (vectored) {
+            if (num_buffers == SD_MAX_SEGMENTS) {
+                // No more room in segment list
+                break;
+            }
+        } else if (buf_blocks != (LOGGING_BUFFER_SIZE / SD_BLOCK_LENGTH)) {
+            // The next buffer does not follow on directly from this one's data
             break;
         }
     }
 
-    if (buf == LOGGING_NUM_BUFFERS) {
+    if (num_buffers == 0) {
         // No buffer ready to be written
         return;
     }
 
-    // Get buffer ready to write
-    uint16_t blocks_to_write = ((inst->buffer[buf].count +
-                                 (SD_BLOCK_LENGTH - 1)) / SD_BLOCK_LENGTH);
-    uint16_t extra_bytes;
     uint32_t const free_blocks = (inst->part_blocks -
                                   (inst->sb.flights[inst->flight].first_block +
                                    inst->sb.flights[inst->flight].num_blocks));
-    if (blocks_to_write > free_blocks) {
-        // Not enough free blocks, cap blocks_to_write
-        blocks_to_write = free_blocks;
-        extra_bytes = 0;
-    } else {
-        // Calculate how many unused bytes we have in the last block
-        extra_bytes = ((blocks_to_write * SD_BLOCK_LENGTH) -
-                       inst->buffer[buf].count);
-
-        if (extra_bytes != 0) {
-            // Need to add a spacer to take up the rest of the last SD card
-            // block
-            logging_block_marshal_header(inst->buffer[buf].data +
-                                         inst->buffer[buf].count,
-                                         LOGGING_BLOCK_CLASS_METADATA,
-                                         LOGGING_METADATA_TYPE_SPACER,
-                                         extra_bytes);
-            // Zero out everything after the spacer header
-            memset(inst->buffer[buf].data + inst->buffer[buf].count + 4, 0,
-                   extra_bytes - 4);
-            inst->buffer[buf].count += extra_bytes;
+    uint8_t num_segments = num_buffers;
+    if (blocks > free_blocks) {
+        // Not enough free blocks, cap blocks to be written
+        blocks = free_blocks;
+
+        if (vectored) {
+            // Trim the segment list to match
+            uint16_t remaining = blocks;
+            for (num_segments = 0; remaining != 0; num_segments++) {
+                struct sd_segment *const seg =
+                                        &inst->write_segments[num_segments];
+                if (seg->num_blocks > remaining) {
+                    seg->num_blocks = remaining;
+                }
+                remaining -= seg->num_blocks;
+            }
         }
     }
 
-    if (blocks_to_write == 0) {
+    if (blocks == 0) {
         // We have run out of space to write blocks
         inst->state = LOGGING_OUT_OF_SPACE;
         write_superblock(inst, 1);
         return;
     }
 
-    // Start writing block
+    // Start writing blocks
     inst->sd_write_in_progress = 1;
-    inst->blocks_in_progress = blocks_to_write;
-    inst->buffer_write_num = buf;
+    inst->blocks_in_progress = blocks;
+    inst->buffers_in_progress = num_buffers;
 
     uint32_t const addr = (inst->part_start +
                            inst->sb.flights[inst->flight].first_block +
                            inst->sb.flights[inst->flight].num_blocks);
-    int const ret = inst->sd_funcs.write(inst->sd_desc, addr,
-                                blocks_to_write, inst->buffer[buf].data,
-                                logging_sd_callback, inst);
+    int ret;
+    if (vectored) {
+        // Hand the buffers straight to the driver's DMA without gathering them
+        ret = inst->sd_funcs.write_v(inst->sd_desc, addr, inst->write_segments,
+                                     num_segments, logging_sd_callback, inst);
+    } else {
+        uint8_t const *const data =
+                                inst->data[LOGGING_BUF_IDX(inst->cons_cursor)];
+        ret = inst->sd_funcs.write(inst->sd_desc, addr, blocks, data,
+                                   logging_sd_callback, inst);
+    }
 
     if (ret != 0) {
         // Could not start write
         inst->blocks_in_progress = 0;
+        inst->buffers_in_progress = 0;
         inst->sd_write_in_progress = 0;
     } else {
         inst->last_data_write = millis;
     }
 }
 
+/**
+ *  Erase the next few blocks that are expected to be used by the current
+ *  flight if the SD card is not otherwise busy. Only blocks past the end of
+ *  the data that has already been written are erased.
+ *
+ *  @param inst Logging service instance descriptor
+ */
+static void pre_erase(struct logging_desc_t *inst)
+{
+    if (inst->sd_write_in_progress) {
+        return;
+    }
+
+    uint32_t const write_next = (inst->sb.flights[inst->flight].first_block +
+                                 inst->sb.flights[inst->flight].num_blocks);
+    if (inst->erase_next < write_next) {
+        // Data has been written past the blocks that have been erased
+        inst->erase_next = write_next;
+    }
+
+    if (inst->erase_next >= inst->erase_end) {
+        // Nothing left to erase
+        return;
+    }
+
+    uint32_t num_blocks = inst->erase_end - inst->erase_next;
+    if (num_blocks > LOGGING_PRE_ERASE_CHUNK_BLOCKS) {
+        num_blocks = LOGGING_PRE_ERASE_CHUNK_BLOCKS;
+    }
+
+    int const ret = inst->sd_funcs.erase(inst->sd_desc,
+                                         inst->part_start + inst->erase_next,
+                                         num_blocks, logging_sd_callback, inst);
+
+    if (ret == 0) {
+        inst->sd_write_in_progress = 1;
+        inst->erase_in_progress = 1;
+        inst->erase_next += num_blocks;
+    }
+}
+
 void logging_service(struct logging_desc_t *inst)
 {
     int ret;
@@ -357,6 +538,20 @@ void logging_service(struct logging_desc_t *inst)
 
                 inst->sb.flights[inst->flight].num_blocks = 0;
                 inst->sb.flights[inst->flight].timestamp = 0;
+
+                if (inst->sd_funcs.erase != NULL) {
+                    // Erase the blocks we expect this flight to use in the
+                    // background so that the card does not need to erase them
+                    // as we write
+                    uint32_t const first_block =
+                                    inst->sb.flights[inst->flight].first_block;
+                    inst->erase_next = first_block;
+                    inst->erase_end = first_block + LOGGING_PRE_ERASE_BLOCKS;
+                    if ((inst->erase_end > inst->part_blocks) ||
+                            (inst->erase_end < first_block)) {
+                        inst->erase_end = inst->part_blocks;
+                    }
+                }
             }
 
             if (inst->should_pause) {
@@ -371,6 +566,7 @@ void logging_service(struct logging_desc_t *inst)
             // Check if we need to write some blocks
             write_superblock(inst, 0);
             write_buffer(inst);
+            pre_erase(inst);
             break;
         case LOGGING_PAUSED:
             break;
@@ -409,74 +605,6 @@ void logging_set_timestamp(struct logging_desc_t *inst, uint32_t timestamp)
 
 
 
-/**
- *  Switch to a new buffer.
- *
- *  @param inst Logging service instance descriptor
- *  @param required_length The number of bytes required right away in the new
- *                         buffer
- *  @param new_insert_point Pointer to where new insert point will be stored
- *
- *  @return 0 if successful
- */
-static int select_buffer(struct logging_desc_t *inst, uint16_t required_length,
-                         uintptr_t *new_insert_point)
-{
-    // Grab the current insert point
-    uintptr_t ip = (uintptr_t)__atomic_load_n(&inst->insert_point, __ATOMIC_SEQ_CST);
-
-    for (;;) {
-        // Get current buffer index from lower bits of insert point
-        uint8_t const cur_buf_idx = ip & (uintptr_t)0x3;
-        // Clear lower bits of insert point to get proper pointer
-        ip &= ~((uintptr_t)0x3);
-
-        // If the current insert point is valid we might be able to use it
-        if (ip != (uintptr_t)NULL) {
-            // Check if we have enough space in the current buffer
-            uint32_t const curr_count = ip - (uintptr_t)inst->buffer[cur_buf_idx].data;
-            if ((curr_count + required_length) <= LOGGING_BUFFER_SIZE) {
-                // No need to select a different buffer
-                break;
-            }
-        }
-
-        // Search for an empty buffer we can use
-        uint8_t buf_idx = (cur_buf_idx + 1) % LOGGING_NUM_BUFFERS;
-        while (buf_idx != cur_buf_idx) {
-            if (inst->buffer[buf_idx].count == 0) {
-                break;
-            }
-            buf_idx = (buf_idx + 1) % LOGGING_NUM_BUFFERS;
-        }
-
-        if (buf_idx == cur_buf_idx) {
-            // No empty buffers where available
-            return 1;
-        }
-
-        // Switch to the chosen buffer
-        uintptr_t const new_ip = (uintptr_t)inst->buffer[buf_idx].data | buf_idx;
-
-        // Try to update the insert point to make space in the buffer
-        ip |= cur_buf_idx;
-        if (__atomic_compare_exchange_n(&inst->insert_point, &ip, new_ip, 0,
-                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
-            if (inst->buffer[cur_buf_idx].count != 0) {
-                inst->buffer[cur_buf_idx].pending_write = 1;
-            }
-            break;
-        }
-        // __atomic_compare_exchange_n will have updated ip
-    }
-
-    *new_insert_point = (uintptr_t)inst->insert_point;
-    return 0;
-}
-
-
-
-
 int log_data(struct logging_desc_t *inst, uint8_t const *data, uint16_t length)
 {
     struct logging_gather_element gather = {
@@ -521,24 +649,22 @@ int log_gather(struct logging_desc_t *inst,
 
 int log_checkout(struct logging_desc_t *inst, uint8_t **data, uint16_t length)
 {
-    // Grab the current insert point
-    uintptr_t ip = (uintptr_t)__atomic_load_n(&inst->insert_point,
-                                              __ATOMIC_SEQ_CST);
+    if (length > LOGGING_BUFFER_SIZE) {
+        // This checkout could never fit in a buffer
+        inst->out_of_space_count++;
+        return 1;
+    }
+
+    // Grab the current producer cursor
+    uint32_t cursor = __atomic_load_n(&inst->prod_cursor, __ATOMIC_SEQ_CST);
 
     for (;;) {
-        // Get current buffer index from lower bits of insert point
-        uint8_t const buf_idx = ip & (uintptr_t)0x3;
-        // Clear lower bits of insert point to get proper pointer
-        ip &= ~((uintptr_t)0x3);
-
-        // Check that the insert point is valid and there is enough space in the
-        // current buffer
-        uint32_t const current_count = ip - (uintptr_t)inst->buffer[buf_idx].data;
-        if ((ip == (uintptr_t)NULL) || ((current_count + length) >
-                                        LOGGING_BUFFER_SIZE)) {
-            int const ret = select_buffer(inst, length, &ip);
-
-            if (ret != 0) {
+        uint16_t const offset = LOGGING_CURSOR_OFFSET(cursor);
+        uint8_t const buf_idx = LOGGING_BUF_IDX(LOGGING_CURSOR_SEQ(cursor));
+
+        // Check that there is enough space in the current buffer
+        if ((offset + length) > LOGGING_BUFFER_SIZE) {
+            if (advance_buffer(inst, &cursor) != 0) {
                 // No buffers available
                 inst->out_of_space_count++;
                 return 1;
@@ -546,46 +672,43 @@ int log_checkout(struct logging_desc_t *inst, uint8_t **data, uint16_t length)
             continue;
         }
 
-        // Figure out what we need to update the insert point to
-        uintptr_t const new_ip = (ip + length) | buf_idx;
-
         // Checkout buffer
         __atomic_add_fetch(&inst->buffer[buf_idx].checkout_count, 1,
                            __ATOMIC_SEQ_CST);
 
-        // Try and update the insert point to make space in the buffer
-        ip |= buf_idx;
-        if (__atomic_compare_exchange_n(&inst->insert_point, &ip, new_ip, 0,
-                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+        // Try and update the producer cursor to make space in the buffer
+        if (__atomic_compare_exchange_n(&inst->prod_cursor, &cursor,
+                                        cursor + length, 0, __ATOMIC_SEQ_CST,
+                                        __ATOMIC_SEQ_CST)) {
             // Update count
             __atomic_add_fetch(&inst->buffer[buf_idx].count, length,
                                __ATOMIC_SEQ_CST);
             // Successfully reserved space in buffer
-            break;
+            *data = inst->data[buf_idx] + offset;
+            return 0;
         }
 
         // Release checkout on buffer since we might end up using a different
         // buffer next time through the loop
         __atomic_sub_fetch(&inst->buffer[buf_idx].checkout_count, 1,
                            __ATOMIC_SEQ_CST);
-        // __atomic_compare_exchange_n will have updated ip
+        // __atomic_compare_exchange_n will have updated cursor
     }
-
-    *data = (uint8_t*)(ip & ~0x3);
-    return 0;
 }
 
 int log_checkin(struct logging_desc_t *inst, uint8_t *data)
 {
     // Figure out which buffer data is from
-    for (int i = 0; i < LOGGING_NUM_BUFFERS; i++) {
-        uint8_t *const buffer_end = inst->buffer[i].data + LOGGING_BUFFER_SIZE;
-        if ((data >= inst->buffer[i].data) && (data < buffer_end)) {
-            // Release checkout on buffer
-            __atomic_sub_fetch(&inst->buffer[i].checkout_count, 1,
-                               __ATOMIC_SEQ_CST);
-            return 0;
-        }
+    uint8_t *const ring_start = inst->data[0];
+    uint8_t *const ring_end = inst->data[LOGGING_NUM_BUFFERS - 1] +
+                                LOGGING_BUFFER_SIZE;
+    if ((data < ring_start) || (data >= ring_end)) {
+        return 1;
     }
-    return 1;
+
+    uint8_t const buf_idx = (data - ring_start) / LOGGING_BUFFER_SIZE;
+    // Release checkout on buffer
+    __atomic_sub_fetch(&inst->buffer[buf_idx].checkout_count, 1,
+                       __ATOMIC_SEQ_CST);
+    return 0;
 }
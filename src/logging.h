@@ -13,13 +13,31 @@
 #include "global.h"
 #include "sd.h"
 
-#include "target.h" // For LOGGING_BUFFER_SIZE
+#include "target.h" // For LOGGING_BUFFER_SIZE and LOGGING_NUM_BUFFERS
 
 #include "logging-format.h"
 
 
+#if (LOGGING_NUM_BUFFERS & (LOGGING_NUM_BUFFERS - 1)) != 0
+#error LOGGING_NUM_BUFFERS must be a power of two.
+#endif
 
-#define LOGGING_NUM_BUFFERS 2
+#if ((LOGGING_BUFFER_SIZE % SD_BLOCK_LENGTH) != 0) || \
+    (LOGGING_BUFFER_SIZE > UINT16_MAX)
+#error LOGGING_BUFFER_SIZE must be a multiple of the SD card block length.
+#endif
+
+/** Get the sequence number of the buffer that a producer cursor points into */
+#define LOGGING_CURSOR_SEQ(c)       ((uint16_t)((c) >> 16))
+/** Get the offset within its buffer of the insert point for a cursor */
+#define LOGGING_CURSOR_OFFSET(c)    ((uint16_t)((c) & 0xFFFF))
+/** Get the index in the buffer ring for a buffer sequence number */
+#define LOGGING_BUF_IDX(seq)        ((seq) & (LOGGING_NUM_BUFFERS - 1))
+
+/** Number of buckets in SD card write latency histogram. Bucket 0 counts writes
+    that took less than 1 ms, bucket n counts writes that took at least 2^(n-1)
+    ms but less than 2^n ms and the last bucket counts all longer writes. */
+#define LOGGING_LATENCY_HIST_BUCKETS    10
 
 
 /**
@@ -49,16 +67,16 @@ enum logging_state {
 };
 
 struct logging_desc_t {
-    /* Buffers and associated state */
+    /** Ring of buffers. The buffers are contiguous so that any run of
+        consecutive buffers can be written to the SD card in one operation. */
+    uint8_t data[LOGGING_NUM_BUFFERS][LOGGING_BUFFER_SIZE]
+                                                    __attribute__((aligned(4)));
+    /* State associated with each buffer */
     struct {
-        /** Buffer */
-        uint8_t data[LOGGING_BUFFER_SIZE];
         /** Number of valid bytes currently in buffer */
         uint16_t count;
         /** Number of active checkouts for buffer */
         uint8_t checkout_count;
-        /** Whether the buffer is ready to be written */
-        uint8_t pending_write:1;
     } buffer[LOGGING_NUM_BUFFERS];
 
     union {
@@ -73,14 +91,23 @@ struct logging_desc_t {
     /** Access function for SD card driver */
     struct sd_funcs sd_funcs;
 
-    /** Pointer to where in the buffers data should be placed next. The lower
-        two bits of this value are used to store the current buffer number. */
-    uint8_t *insert_point;
+    /** Producer cursor. The upper 16 bits are the free running sequence number
+        of the buffer currently being filled and the lower 16 bits are the
+        offset within that buffer where data should be placed next. Every
+        buffer with a sequence number lower than the current one is closed and
+        waiting to be written. */
+    uint32_t prod_cursor;
     /** Address of first block in partition */
     uint32_t part_start;
     /** Number of blocks in partition */
     uint32_t part_blocks;
 
+    /** Offset within the partition of the next block to be pre-erased */
+    uint32_t erase_next;
+    /** Offset within the partition of the block after the last block to be
+        pre-erased */
+    uint32_t erase_end;
+
     /** Last time that a buffer of data was written to the SD card */
     uint32_t last_data_write;
     /** Last time that the SD card's superblock was updated */
@@ -90,9 +117,25 @@ struct logging_desc_t {
         that there wasn't enough space for */
     uint32_t out_of_space_count;
 
+    /** Histogram of the time taken for each data write to the SD card */
+    uint32_t write_latency_hist[LOGGING_LATENCY_HIST_BUCKETS];
+    /** Longest time taken for a data write to the SD card */
+    uint32_t max_write_latency;
+
+    /** Consumer cursor. Sequence number of the next buffer to be written to
+        the SD card. */
+    uint16_t cons_cursor;
+
     /** Number of blocks that are being written in the current SD write
         operation */
     uint16_t blocks_in_progress;
+    /** Number of buffers that are being written in the current SD write
+        operation */
+    uint8_t buffers_in_progress;
+
+    /** List of buffers for the current SD write operation when the SD card
+        driver supports vectored writes */
+    struct sd_segment write_segments[SD_MAX_SEGMENTS];
 
     union {
         /** The current flight number */
@@ -107,11 +150,11 @@ struct logging_desc_t {
     uint8_t continue_flight:1;
     /** Whether an SD card write operation is ongoing */
     uint8_t sd_write_in_progress:1;
-    /** Which buffer is currently being written to the SD card */
-    uint8_t buffer_write_num:2;
     /** Whether the logging service should be paused as soon as it reaches the
         active state */
     uint8_t should_pause:1;
+    /** Whether the ongoing SD card operation is a pre-erase */
+    uint8_t erase_in_progress:1;
 };
 
 /**
@@ -190,6 +233,8 @@ extern int log_gather(struct logging_desc_t *inst,
  *  will be reserved. The buffer will not be written to the SD card until it is
  *  checked back in.
  *
+ *  @note This function is safe to call from an interrupt context.
+ *
  *  @param inst Logging service instance descriptor
  *  @param data Pointer to where pointer to buffer will be stored
  *  @param length Size of buffer to check out
@@ -20,6 +20,59 @@
 
 #define RADIO_SIG_REPORT_PERIOD MS_TO_MILLIS(5000)
 
+//
+//
+//  Link Control
+//
+//
+
+/*  Index of the link profile used at startup, see radio-chanmgr.c */
+#define LORA_LINK_INITIAL_PROFILE 2
+/*  Step to a more robust link profile when the link margin falls below this
+    many dB */
+#define LORA_LINK_MARGIN_LOW 3
+/*  Margin in dB that the profile stepped down to should have, profiles are
+    2 to 3 dB apart so this must be close enough to the low margin to allow
+    stepping down by one profile */
+#define LORA_LINK_MARGIN_TARGET 5
+/*  Step to a faster link profile when the margin it would have is at least
+    this many dB */
+#define LORA_LINK_MARGIN_HIGH 10
+/*  Time for which the margin must stay high before stepping to a faster
+    profile */
+#define LORA_LINK_STEP_UP_HOLD MS_TO_MILLIS(10000)
+/*  Minimum time after any profile change before stepping to a faster
+    profile */
+#define LORA_LINK_HOLDOFF MS_TO_MILLIS(15000)
+/*  Time between attempts to send a profile change request */
+#define LORA_LINK_REQUEST_PERIOD MS_TO_MILLIS(1000)
+/*  Number of times a profile change request is sent before giving up */
+#define LORA_LINK_REQUEST_TRIES 4
+/*  Time without receiving a packet after which the most robust profile is used
+    until the link is re-established */
+#define LORA_LINK_LOSS_TIMEOUT MS_TO_MILLIS(15000)
+
+//
+//
+//  Erasure Coding
+//
+//
+
+/*  Number of data packets in each erasure coded group, from 1 to 8 */
+#define LORA_FEC_DATA_PACKETS 4
+//  Number of parity packets that the ground station asks for after each group,
+//  from 0 to 4. Up to this many lost packets in a group can be recovered. Zero
+//  turns erasure coding off. May be overridden by the build.
+#ifndef LORA_FEC_PARITY_PACKETS
+#define LORA_FEC_PARITY_PACKETS 0
+#endif
+/*  Time between attempts to send an erasure coding configuration request */
+#define LORA_FEC_REQUEST_PERIOD MS_TO_MILLIS(1000)
+/*  Number of times a configuration request is sent before giving up */
+#define LORA_FEC_REQUEST_TRIES 4
+/*  Time to wait after giving up before requesting the configuration again */
+#define LORA_FEC_RETRY_PERIOD MS_TO_MILLIS(10000)
+
 //
 //
 // Callsign
@@ -65,6 +118,25 @@
 #define LORA_SYNC_WORD 0x43
 
 
+//
+//
+//  Channels
+//
+//
+
+//  Number of channels over which the rocket spreads its transmissions, from 1
+//  to 4. Channel n is centred at LORA_FREQ plus n times the channel spacing.
+//  The ground station listens on every channel at once with one radio per
+//  channel and always transmits on channel 0, so it should have at least this
+//  many radios. May be overridden by the build.
+#ifndef LORA_NUM_CHANNELS
+#define LORA_NUM_CHANNELS 1
+#endif
+/*  Spacing between channels in hertz, must be at least the widest bandwidth
+    that is used */
+#define LORA_CHANNEL_SPACING 500000
+
+
 //
 //
 //  Search Mode LoRa Settings
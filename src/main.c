@@ -11,9 +11,8 @@
 #include "target.h"
 #include "board.h"
 #include "variant.h"
-
-// MARK: Function prototypes
-static void main_loop(void);
+#include "scheduler.h"
+#include "profiler.h"
 
 // MARK: Variable Definitions
 volatile uint8_t inhibit_sleep_g;
@@ -22,25 +21,19 @@ volatile uint8_t inhibit_sleep_g;
 int main(void)
 {
     init_target();
+    init_profiler();
     init_board();
     init_variant();
 
     // Main Loop
     for (;;) {
-        // Run the main loop
-        main_loop();
+        // Run any services which have work to do
+        sched_run();
 
-        // Sleep if sleep is not inhibited
-        if (!inhibit_sleep_g) {
-            __WFI();
-        }
+        // Sleep if sleep is not inhibited and no services have been marked
+        // ready since they were run
+        sched_sleep();
     }
 
     return 0; // never reached
 }
-
-static void main_loop (void)
-{
-    board_service();
-    variant_service();
-}
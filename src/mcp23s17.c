@@ -68,7 +68,7 @@ void mcp23s17_service(struct mcp23s17_desc_t *inst)
     /* Mark the GPIO registers as dirty if the automatic polling period has
        expired */
     if (inst->poll_period &&
-        ((millis - inst->last_polled) > inst->poll_period)) {
+        ((millis - inst->last_polled) >= inst->poll_period)) {
         inst->gpio_dirty = 1;
     }
     
@@ -14,6 +14,10 @@
 
 #include "mpu9250-self-test.h"
 
+#include "timebase.h"
+
+#include <string.h>
+
 // MARK: Constants
 
 #define MPU9250_RESET_WAIT_PERIOD       MS_TO_MILLIS(2)
@@ -25,6 +29,19 @@
 
 #define MPU9250_AG_ACC_SAMPLE_LEN       12
 
+/** Size of the MPU9250's FIFO in bytes */
+#define MPU9250_FIFO_LENGTH             512
+/** Largest number of whole samples that fit in the FIFO */
+#define MPU9250_FIFO_MAX_SAMPLES        (MPU9250_FIFO_LENGTH / \
+                                         MPU9250_SAMPLE_LEN)
+/** Amount of time worth of samples to leave space for in the FIFO when
+    scheduling drains, this needs to cover the latency of starting a drain */
+#define MPU9250_FIFO_HEADROOM_PERIOD    MS_TO_MILLIS(40)
+/** Most samples that will be included in the acceleration sums */
+#define MPU9250_ACCEL_SUM_MAX_SAMPLES   1024
+/** Longest period over which the FIFO fill level will be extrapolated */
+#define MPU9250_FIFO_MAX_PREDICT_PERIOD MS_TO_MILLIS(10000)
+
 
 // MARK: Helpers
 
@@ -134,7 +151,186 @@ void parse_mpu9250_data(struct mpu9250_desc_t *const inst,
     inst->last_mag_x = mag_adjust_sensitivity(mag_x, inst->mag_asa[0]);
     inst->last_mag_y = mag_adjust_sensitivity(mag_y, inst->mag_asa[1]);
     inst->last_mag_z = mag_adjust_sensitivity(mag_z, inst->mag_asa[2]);
-    inst->last_mag_overflow = !!(inst->buffer[20] & AK8963_ST2_HOFL);
+    inst->last_mag_overflow = !!(s[20] & AK8963_ST2_HOFL);
+}
+
+void mpu9250_accumulate_accel(struct mpu9250_desc_t *const inst,
+                              const uint8_t *s, uint8_t count)
+{
+    for (; count > 0; count--, s += MPU9250_SAMPLE_LEN) {
+        if (inst->accel_sum_count >= MPU9250_ACCEL_SUM_MAX_SAMPLES) {
+            // Nobody is taking the sums, start over rather than overflow
+            memset(inst->accel_sums, 0, sizeof(inst->accel_sums));
+            inst->accel_sum_count = 0;
+        }
+        inst->accel_sums[0] += (int16_t)((((uint16_t)s[0]) << 8) |
+                                         (uint16_t)s[1]);
+        inst->accel_sums[1] += (int16_t)((((uint16_t)s[2]) << 8) |
+                                         (uint16_t)s[3]);
+        inst->accel_sums[2] += (int16_t)((((uint16_t)s[4]) << 8) |
+                                         (uint16_t)s[5]);
+        inst->accel_sum_count++;
+    }
+}
+
+/**
+ *  @return The number of samples in the FIFO at which a drain should be
+ *          started so that MPU9250_FIFO_HEADROOM_PERIOD worth of space is left
+ */
+static uint8_t fifo_drain_samples(struct mpu9250_desc_t const *const inst)
+{
+    uint32_t const headroom = (((MPU9250_FIFO_HEADROOM_PERIOD *
+                                 inst->fifo_rate) + ((1000UL << 8) - 1)) /
+                               (1000UL << 8));
+
+    if (headroom >= MPU9250_FIFO_MAX_SAMPLES) {
+        // The FIFO fills up quicker than the headroom period, drain it as soon
+        // as there is anything in it
+        return 1;
+    }
+    return MPU9250_FIFO_MAX_SAMPLES - headroom;
+}
+
+/**
+ *  Start waiting for samples to be written into a FIFO which has just been
+ *  enabled or reset. Until the FIFO count has been read we assume that samples
+ *  are being written at the estimated rate.
+ *
+ *  @param inst MPU9250 driver instance
+ */
+static void restart_fifo_wait(struct mpu9250_desc_t *const inst)
+{
+    inst->wait_start = millis;
+    inst->samples_to_read = fifo_drain_samples(inst);
+    inst->fifo_count_valid = 0;
+    inst->fifo_head_valid = 0;
+    inst->state = MPU9250_FIFO_WAIT;
+}
+
+/**
+ *  Predict how many samples are in the FIFO based on the last FIFO count and
+ *  the estimated sample rate. The number of new samples is rounded down and
+ *  reduced by a margin so that the prediction does not exceed the real number
+ *  of samples in the FIFO because of a small error in the rate estimate.
+ *
+ *  @param inst MPU9250 driver instance
+ *  @return The number of samples which can safely be read from the FIFO
+ */
+static uint8_t predict_fifo_samples(struct mpu9250_desc_t const *const inst)
+{
+    uint32_t elapsed = millis - inst->fifo_count_time;
+    if (elapsed > MPU9250_FIFO_MAX_PREDICT_PERIOD) {
+        elapsed = MPU9250_FIFO_MAX_PREDICT_PERIOD;
+    }
+
+    uint32_t const new_samples = (elapsed * inst->fifo_rate) / (1000UL << 8);
+    uint32_t const margin = (new_samples / 16) + 1;
+
+    uint32_t predicted = inst->fifo_samples;
+    if (new_samples > margin) {
+        predicted += new_samples - margin;
+    }
+
+    if (predicted > MPU9250_FIFO_MAX_SAMPLES) {
+        predicted = MPU9250_FIFO_MAX_SAMPLES;
+    }
+    return (uint8_t)predicted;
+}
+
+/**
+ *  Record a new FIFO count and update the estimate of the rate at which
+ *  samples are being written to the FIFO.
+ *
+ *  @param inst MPU9250 driver instance
+ *  @param count Raw value read from the FIFO_COUNTH and FIFO_COUNTL registers
+ *  @param samples_read Number of samples that have been read from the FIFO
+ *                      since the previous count was recorded
+ */
+static void update_fifo_count(struct mpu9250_desc_t *const inst,
+                              uint8_t const *const count,
+                              uint8_t const samples_read)
+{
+    uint16_t const bytes = ((((uint16_t)count[0]) & 0x1f) << 8) | count[1];
+    uint8_t samples = bytes / MPU9250_SAMPLE_LEN;
+    if (samples > MPU9250_FIFO_MAX_SAMPLES) {
+        samples = MPU9250_FIFO_MAX_SAMPLES;
+    }
+
+    uint32_t const now = millis;
+    uint32_t const elapsed = now - inst->fifo_count_time;
+    int32_t const produced = ((int32_t)samples + samples_read -
+                              inst->fifo_samples);
+
+    // The count was sampled at some point between when its read was started
+    // and now, assume that it was half way through
+    uint32_t const now_micros = timebase_micros();
+    uint32_t const count_micros = (inst->fifo_request_time +
+                                   ((now_micros - inst->fifo_request_time) /
+                                    2));
+
+    if (inst->fifo_count_valid && (produced > 0) && (elapsed != 0) &&
+            (elapsed < MPU9250_FIFO_MAX_PREDICT_PERIOD)) {
+        // Update the moving average of the sample rate
+        uint32_t const rate = ((uint32_t)produced * (1000UL << 8)) / elapsed;
+        inst->fifo_rate = ((inst->fifo_rate * 3) + rate) / 4;
+
+        // Update the moving average of the sample period, ignoring
+        // measurements that are more than 25% off from the nominal period
+        uint32_t const period = (uint32_t)(((uint64_t)(count_micros -
+                                                inst->fifo_count_micros) << 8) /
+                                           (uint32_t)produced);
+        uint32_t const nominal = mpu9250_get_ag_period(inst);
+        if ((period > (nominal - (nominal / 4))) &&
+                (period < (nominal + (nominal / 4)))) {
+            inst->sample_period = ((inst->sample_period * 3) + period) / 4;
+        }
+    }
+
+    if (samples != 0) {
+        // The newest sample in the FIFO was written no more than one sample
+        // period before the read was started and no later than now, which
+        // bounds the time of the oldest sample
+        uint32_t const period = inst->sample_period;
+        uint32_t const earliest = (inst->fifo_request_time -
+                                   (uint32_t)(((uint64_t)samples * period) >>
+                                              8));
+        uint32_t const latest = (now_micros -
+                                 (uint32_t)(((uint64_t)(samples - 1) *
+                                             period) >> 8));
+
+        if (!inst->fifo_head_valid) {
+            inst->fifo_head_time = earliest + ((latest - earliest) / 2);
+            inst->fifo_head_frac = 0;
+            inst->fifo_head_valid = 1;
+        } else if ((int32_t)(inst->fifo_head_time - earliest) < 0) {
+            inst->fifo_head_time = earliest;
+            inst->fifo_head_frac = 0;
+        } else if ((int32_t)(inst->fifo_head_time - latest) > 0) {
+            inst->fifo_head_time = latest;
+            inst->fifo_head_frac = 0;
+        }
+    }
+
+    inst->fifo_samples = samples;
+    inst->fifo_count_time = now;
+    inst->fifo_count_micros = count_micros;
+    inst->fifo_count_valid = 1;
+}
+
+/**
+ *  Advance the estimated time of the oldest sample in the FIFO past samples
+ *  which have been read.
+ *
+ *  @param inst MPU9250 driver instance
+ *  @param samples_read Number of samples that were read from the FIFO
+ */
+static void advance_fifo_head(struct mpu9250_desc_t *const inst,
+                              uint8_t const samples_read)
+{
+    uint32_t const advance = (((uint32_t)samples_read * inst->sample_period) +
+                              inst->fifo_head_frac);
+    inst->fifo_head_time += advance >> 8;
+    inst->fifo_head_frac = advance & 0xff;
 }
 
 
@@ -1475,7 +1671,7 @@ static int mpu9250_handle_ag_config_sensors( struct mpu9250_desc_t *const inst)
 
     // Move to next state
     if (inst->use_fifo) {
-        inst->state = MPU9250_AG_CONFIG_FIFO;
+        inst->state = MPU9250_AG_CONFIG_FIFO_INT;
     } else {
         inst->state = MPU9250_AG_CONFIG_INT;
     }
@@ -1513,6 +1709,32 @@ static int mpu9250_handle_ag_config_int(struct mpu9250_desc_t *const inst)
 }
 
 
+/** Write to INT_ENABLE to enable FIFO overflow interrupt status so that
+    overflows can be detected when the FIFO is drained */
+static int mpu9250_handle_ag_config_fifo_int(struct mpu9250_desc_t *const inst)
+{
+    if (!inst->cmd_ready) {
+        // INT_ENABLE
+        inst->buffer[0] = MPU9250_INT_ENABLE_FIFO_OVERFLOW_EN;
+
+        inst->cmd_ready = 1;
+    }
+
+    enum state_helper_result const res = do_reg_state(inst, inst->mpu9250_addr,
+                                                      MPU9250_REG_INT_ENABLE, 1,
+                                                      inst->buffer, 1, 0);
+
+    if (res != STATE_DONE) {
+        // Not done yet
+        return 0;
+    }
+
+    // Move to next state
+    inst->state = MPU9250_AG_CONFIG_FIFO;
+    return 1;
+}
+
+
 /** Write to FIFO_EN to enable writing of gyro x, y and z, accel, temp and I2C
     slave 0 data to FIFO */
 static int mpu9250_handle_ag_config_fifo(struct mpu9250_desc_t *const inst)
@@ -1538,11 +1760,11 @@ static int mpu9250_handle_ag_config_fifo(struct mpu9250_desc_t *const inst)
         return 0;
     }
 
-    // Move to next state
-    inst->wait_start = millis;
-    inst->samples_to_read = calc_num_samples_to_wait_for(0, 0,
-                                                         MPU9250_SAMPLE_LEN);
-    inst->state = MPU9250_FIFO_WAIT;
+    // Move to next state, until the FIFO count has been read we assume that
+    // samples are written at the configured ODR
+    inst->fifo_rate = ((uint32_t)mpu9250_get_ag_odr(inst)) << 8;
+    inst->sample_period = mpu9250_get_ag_period(inst);
+    restart_fifo_wait(inst);
     return 1;
 }
 
@@ -1557,16 +1779,40 @@ static int mpu9250_handle_running(struct mpu9250_desc_t *const inst)
 /** Wait for samples to be written into FIFO */
 static int mpu9250_handle_fifo_wait(struct mpu9250_desc_t *const inst)
 {
-    uint32_t const wait_period = (((uint32_t)inst->samples_to_read * 1000) /
-                                  mpu9250_get_ag_odr(inst)) + 1;
-    if ((millis - inst->wait_start) < wait_period) {
-        // Not done waiting
-        return 0;
+    if (!inst->fifo_count_valid) {
+        // We do not know how full the FIFO is, wait for samples_to_read sample
+        // periods at the configured ODR and then read the FIFO count
+        uint32_t const wait_period = (((uint32_t)inst->samples_to_read *
+                                       1000) / mpu9250_get_ag_odr(inst)) + 1;
+        if ((millis - inst->wait_start) < wait_period) {
+            // Not done waiting
+            return 0;
+        }
+
+        inst->wait_start = millis;
+        inst->next_sample_time = inst->wait_start;
+        inst->fifo_request_time = timebase_micros();
+        inst->state = MPU9250_FIFO_READ_COUNT;
+        return 1;
+    }
+
+    // Wait until the FIFO is expected to be nearly full so that it can be
+    // drained in as few transactions as possible
+    uint8_t const drain_samples = fifo_drain_samples(inst);
+    if (inst->fifo_samples < drain_samples) {
+        uint32_t const wait_period = (((uint32_t)(drain_samples -
+                                                  inst->fifo_samples) *
+                                       (1000UL << 8)) / inst->fifo_rate);
+        if ((millis - inst->fifo_count_time) < wait_period) {
+            // Not done waiting
+            return 0;
+        }
     }
 
     inst->wait_start = millis;
     inst->next_sample_time = inst->wait_start;
-    inst->state = MPU9250_FIFO_READ_COUNT;
+    inst->samples_to_read = predict_fifo_samples(inst);
+    inst->state = MPU9250_FIFO_READ;
     return 1;
 }
 
@@ -1583,8 +1829,16 @@ static int mpu9250_handle_fifo_read_count(struct mpu9250_desc_t *const inst)
         return 0;
     }
 
-    // Calculate how many samples we can read from the FIFO
-    calc_samples_to_read(inst, 0, MPU9250_SAMPLE_LEN);
+    // Read all of the samples that are in the FIFO
+    update_fifo_count(inst, inst->buffer, 0);
+    inst->samples_to_read = inst->fifo_samples;
+
+    if (inst->samples_to_read == 0) {
+        // Nothing to read yet
+        inst->wait_start = millis;
+        inst->state = MPU9250_FIFO_WAIT;
+        return 1;
+    }
 
     // Move to next state
     inst->state = MPU9250_FIFO_READ;
@@ -1595,47 +1849,151 @@ static int mpu9250_handle_fifo_read_count(struct mpu9250_desc_t *const inst)
 /** Read samples from FIFO */
 static int mpu9250_handle_fifo_reads(struct mpu9250_desc_t *const inst)
 {
-    uint16_t const read_len = inst->samples_to_read * MPU9250_SAMPLE_LEN;
-
     if (!inst->cmd_ready) {
+        if (inst->samples_to_read == 0) {
+            // Not enough time has passed to be sure that there are any samples
+            // in the FIFO, get the count again instead
+            inst->fifo_request_time = timebase_micros();
+            inst->state = MPU9250_FIFO_READ_COUNT;
+            return 1;
+        }
+
         // Try to get a buffer from the telemetry service to put the data into
         inst->telem_buffer = NULL;
         if (inst->telem != NULL) {
             inst->telem_buffer = telemetry_post_mpu9250_imu(inst->telem,
-                                                        inst->next_sample_time,
-                                                        inst->odr,
-                                                        inst->mag_odr,
-                                                        inst->accel_fsr,
-                                                        inst->gyro_fsr,
-                                                        inst->accel_bw,
-                                                        inst->gyro_bw,
-                                                        read_len);
+                                        inst->next_sample_time,
+                                        inst->fifo_head_time,
+                                        inst->sample_period, inst->odr,
+                                        inst->mag_odr, inst->accel_fsr,
+                                        inst->gyro_fsr, inst->accel_bw,
+                                        inst->gyro_bw,
+                                        (inst->samples_to_read *
+                                         MPU9250_SAMPLE_LEN));
         }
 
         if (inst->telem_buffer == NULL) {
+            // Fall back to our own buffer, any samples that do not fit will be
+            // read in the next drain
+            uint8_t const max = MPU9250_BUFFER_LENGTH / MPU9250_SAMPLE_LEN;
+            if (inst->samples_to_read > max) {
+                inst->samples_to_read = max;
+            }
             inst->telem_buffer = inst->buffer;
         } else {
             inst->telemetry_buffer_checked_out = 1;
         }
 
+        inst->fifo_read_done = 0;
+        inst->fifo_count_queued = 0;
+        inst->int_status_queued = 0;
         inst->cmd_ready = 1;
     }
 
-    enum state_helper_result const res = do_reg_state(inst, inst->mpu9250_addr,
-                                                      MPU9250_REG_FIFO_R_W,
-                                                      read_len,
-                                                      inst->telem_buffer, 0, 0);
+    uint16_t const read_len = inst->samples_to_read * MPU9250_SAMPLE_LEN;
 
-    if (res != STATE_DONE) {
-        // Not done yet
+    if (!inst->fifo_read_done && !inst->i2c_in_progress) {
+        // Start reading samples from the FIFO, the queued count read can not
+        // happen any earlier than this
+        inst->fifo_request_time = timebase_micros();
+        inst->i2c_in_progress = !sercom_i2c_start_reg_read(inst->i2c_inst,
+                                                           &inst->t_id,
+                                                           inst->mpu9250_addr,
+                                                           MPU9250_REG_FIFO_R_W,
+                                                           inst->telem_buffer,
+                                                           read_len);
+        if (!inst->i2c_in_progress) {
+            // Could not start transaction, try again later
+            return 0;
+        }
+
+        // Queue a read of the FIFO count right behind the data read so that we
+        // know how many samples to read next time without waiting for a
+        // separate transaction
+        inst->fifo_count_queued = !sercom_i2c_start_reg_read(inst->i2c_inst,
+                                                        &inst->count_t_id,
+                                                        inst->mpu9250_addr,
+                                                        MPU9250_REG_FIFO_COUNTH,
+                                                        inst->fifo_count, 2);
+        // Queue a read of INT_STATUS behind that to find out whether the FIFO
+        // overflowed at any point before the data was read out of it
+        inst->int_status_queued = !sercom_i2c_start_reg_read(inst->i2c_inst,
+                                                        &inst->status_t_id,
+                                                        inst->mpu9250_addr,
+                                                        MPU9250_REG_INT_STATUS,
+                                                        &inst->int_status, 1);
         return 0;
     }
 
-    // Take the last sample and record it in the instance descriptor
-    off_t const off = (inst->samples_to_read - 1) * MPU9250_SAMPLE_LEN;
-    const uint8_t *const sample = inst->telem_buffer + off;
-    parse_mpu9250_data(inst, sample);
-    inst->last_sample_time = inst->next_sample_time;
+    int read_failed = 0;
+    if (inst->i2c_in_progress) {
+        // Data read has finished
+        inst->i2c_in_progress = 0;
+        inst->fifo_read_done = 1;
+
+        read_failed = (sercom_i2c_transaction_state(inst->i2c_inst,
+                                                    inst->t_id) !=
+                       I2C_STATE_DONE);
+        sercom_i2c_clear_transaction(inst->i2c_inst, inst->t_id);
+    }
+
+    int count_valid = 0;
+    if (inst->fifo_count_queued) {
+        if (!sercom_i2c_transaction_done(inst->i2c_inst, inst->count_t_id)) {
+            // Still waiting for FIFO count
+            return 0;
+        }
+
+        count_valid = (sercom_i2c_transaction_state(inst->i2c_inst,
+                                                    inst->count_t_id) ==
+                       I2C_STATE_DONE);
+        sercom_i2c_clear_transaction(inst->i2c_inst, inst->count_t_id);
+        inst->fifo_count_queued = 0;
+    }
+
+    // If we could not find out whether the FIFO overflowed we have to assume
+    // that it did
+    int overflowed = 1;
+    if (inst->int_status_queued) {
+        if (!sercom_i2c_transaction_done(inst->i2c_inst, inst->status_t_id)) {
+            // Still waiting for INT_STATUS
+            return 0;
+        }
+
+        if (sercom_i2c_transaction_state(inst->i2c_inst, inst->status_t_id) ==
+                I2C_STATE_DONE) {
+            overflowed = !!(inst->int_status &
+                            MPU9250_INT_STATUS_FIFO_OVERFLOW_INT);
+        }
+        sercom_i2c_clear_transaction(inst->i2c_inst, inst->status_t_id);
+        inst->int_status_queued = 0;
+    }
+
+    if (read_failed || overflowed) {
+        // We do not know how much data was removed from the FIFO and, since
+        // the FIFO length is not a multiple of the sample length, where the
+        // next sample starts. Drop the data that was read without recording
+        // any of it and reset the FIFO to get back into alignment.
+        if (inst->telemetry_buffer_checked_out) {
+            telemetry_abandon_mpu9250_imu(inst->telem, inst->telem_buffer);
+            inst->telemetry_buffer_checked_out = 0;
+        }
+
+        inst->cmd_ready = 0;
+        inst->state = MPU9250_FIFO_RESET;
+        return 1;
+    }
+
+    if (inst->samples_to_read != 0) {
+        // Take the last sample and record it in the instance descriptor
+        off_t const off = (inst->samples_to_read - 1) * MPU9250_SAMPLE_LEN;
+        const uint8_t *const sample = inst->telem_buffer + off;
+        parse_mpu9250_data(inst, sample);
+        mpu9250_accumulate_accel(inst, inst->telem_buffer,
+                                 inst->samples_to_read);
+        inst->last_sample_time = inst->next_sample_time;
+        advance_fifo_head(inst, inst->samples_to_read);
+    }
 
     // Check in telemetry service buffer if we used one
     if (inst->telemetry_buffer_checked_out) {
@@ -1643,16 +2001,52 @@ static int mpu9250_handle_fifo_reads(struct mpu9250_desc_t *const inst)
         inst->telemetry_buffer_checked_out = 0;
     }
 
-    // Calculate how many samples we need to wait for
-    inst->samples_to_read = calc_num_samples_to_wait_for(0, inst->extra_samples,
-                                                         MPU9250_SAMPLE_LEN);
+    // Update our knowledge of how full the FIFO is
+    if (count_valid) {
+        update_fifo_count(inst, inst->fifo_count, inst->samples_to_read);
+    } else {
+        // Wait one sample period and then read the count on its own
+        inst->fifo_count_valid = 0;
+        inst->samples_to_read = 1;
+    }
 
     // Go to wait state
+    inst->cmd_ready = 0;
+    inst->wait_start = millis;
     inst->state = MPU9250_FIFO_WAIT;
     return 1;
 }
 
 
+/** Write to USER_CTRL to reset FIFO after it overflowed or a read from it
+    failed */
+static int mpu9250_handle_fifo_reset(struct mpu9250_desc_t *const inst)
+{
+    if (!inst->cmd_ready) {
+        // USER_CTRL
+        inst->buffer[0] = (MPU9250_USER_CTRL_I2C_MST_EN |
+                           MPU9250_USER_CTRL_FIFO_EN |
+                           MPU9250_USER_CTRL_FIFO_RST);
+
+        inst->cmd_ready = 1;
+    }
+
+    enum state_helper_result const res = do_reg_state(inst, inst->mpu9250_addr,
+                                                      MPU9250_REG_USER_CTRL, 1,
+                                                      inst->buffer, 1, 0);
+
+    if (res != STATE_DONE) {
+        // Not done yet
+        return 0;
+    }
+
+    // The FIFO is empty now, start over with the sample rate that we have
+    // already estimated
+    restart_fifo_wait(inst);
+    return 1;
+}
+
+
 
 
 static int mpu9250_handle_failed(struct mpu9250_desc_t *const inst)
@@ -1722,6 +2116,7 @@ const mpu9250_state_handler_t mpu9250_state_handlers[] = {
 // For interrupt driven operation:
     mpu9250_handle_ag_config_int,           // MPU9250_AG_CONFIG_INT
 // For FIFO driven operation:
+    mpu9250_handle_ag_config_fifo_int,      // MPU9250_AG_CONFIG_FIFO_INT
     mpu9250_handle_ag_config_fifo,          // MPU9250_AG_CONFIG_FIFO
 
 // ##### Normal operation (interrupt driven) #####
@@ -1730,6 +2125,7 @@ const mpu9250_state_handler_t mpu9250_state_handlers[] = {
     mpu9250_handle_fifo_wait,               // MPU9250_FIFO_WAIT
     mpu9250_handle_fifo_read_count,         // MPU9250_FIFO_READ_COUNT
     mpu9250_handle_fifo_reads,              // MPU9250_FIFO_READ
+    mpu9250_handle_fifo_reset,              // MPU9250_FIFO_RESET
 
 // ##### Failure states #####
     mpu9250_handle_failed,                  // MPU9250_FAILED
@@ -35,6 +35,17 @@ typedef int (*mpu9250_state_handler_t)(struct mpu9250_desc_t *inst);
 extern void parse_mpu9250_data(struct mpu9250_desc_t *const inst,
                                const uint8_t *const s);
 
+/**
+ *  Add the acceleration values from a block of raw samples to the running
+ *  acceleration sums.
+ *
+ *  @param inst Driver instance
+ *  @param s Pointer to raw sample data from IMU
+ *  @param count Number of 21 byte samples in s
+ */
+extern void mpu9250_accumulate_accel(struct mpu9250_desc_t *const inst,
+                                     const uint8_t *s, uint8_t count);
+
 
 
 /**
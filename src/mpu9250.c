@@ -11,6 +11,8 @@
 #include "mpu9250-states.h"
 #include "mpu9250-registers.h"
 
+#include "timebase.h"
+
 
 // Interrupt handling functions
 static void mpu9250_int_callback(void *context, union gpio_pin_t pin,
@@ -35,11 +37,21 @@ int init_mpu9250(struct mpu9250_desc_t *inst,
     inst->wait_start = 0;
     memset(inst->accel_accumulators, 0, 3 * sizeof(int32_t));
     memset(inst->gyro_accumulators, 0, 3 * sizeof(int32_t));
+    memset(inst->accel_sums, 0, 3 * sizeof(int32_t));
+    inst->accel_sum_count = 0;
     memset(inst->mag_asa, 0, 3);
     inst->samples_to_read = 0;
     inst->extra_samples = 0;
     inst->samples_left = 0;
+    inst->fifo_samples = 0;
+    inst->fifo_count_time = 0;
+    inst->fifo_rate = 0;
+    inst->fifo_request_time = 0;
+    inst->fifo_count_micros = 0;
+    inst->fifo_head_time = 0;
+    inst->fifo_head_frac = 0;
     inst->t_id = 0;
+    inst->count_t_id = 0;
     inst->retry_count = 0;
     inst->state = MPU9250_READ_AG_WAI;
     inst->next_state = MPU9250_FAILED;
@@ -48,6 +60,10 @@ int init_mpu9250(struct mpu9250_desc_t *inst,
     inst->post_cmd_wait = 0;
     inst->acc_subtract = 0;
     inst->telemetry_buffer_checked_out = 0;
+    inst->fifo_count_valid = 0;
+    inst->fifo_count_queued = 0;
+    inst->fifo_read_done = 0;
+    inst->fifo_head_valid = 0;
     inst->telem = NULL;
 
     // Store settings
@@ -63,6 +79,7 @@ int init_mpu9250(struct mpu9250_desc_t *inst,
         return 1;
     }
     inst->odr = (uint8_t)odr_reg_val;
+    inst->sample_period = mpu9250_get_ag_period(inst);
 
     inst->use_fifo = !!use_fifo;
 
@@ -114,6 +131,21 @@ void mpu9250_service(struct mpu9250_desc_t *inst)
     } while (do_next_state);
 }
 
+uint16_t mpu9250_take_accel_sums(struct mpu9250_desc_t *inst, int32_t *sums)
+{
+    // Samples may be accumulated from an interrupt in interrupt driven mode
+    profiler_disable_irq();
+    uint16_t const count = inst->accel_sum_count;
+    for (int i = 0; i < 3; i++) {
+        sums[i] = inst->accel_sums[i];
+        inst->accel_sums[i] = 0;
+    }
+    inst->accel_sum_count = 0;
+    profiler_enable_irq();
+
+    return count;
+}
+
 int32_t mpu9250_get_temperature(const struct mpu9250_desc_t *inst)
 {
     int32_t const t_val = (int32_t)inst->last_temp - MPU9250_TEMP_ROOM_OFFSET;
@@ -135,6 +167,12 @@ static void mpu9250_int_callback(void *const context,
 {
     struct mpu9250_desc_t *const inst = (struct mpu9250_desc_t *)context;
 
+    // Get the time of the interrupt before doing anything else so that as
+    // little latency as possible is included if it was not captured in hardware
+    uint32_t const sample_time = timebase_get_event_time(pin);
+
+    sched_event_signal(&inst->event);
+
     if (inst->state != MPU9250_RUNNING) {
         return;
     }
@@ -146,6 +184,8 @@ static void mpu9250_int_callback(void *const context,
     if (inst->telem != NULL) {
         inst->telem_buffer = telemetry_post_mpu9250_imu(inst->telem,
                                                         inst->next_sample_time,
+                                                        sample_time,
+                                                        inst->sample_period,
                                                         inst->odr,
                                                         inst->mag_odr,
                                                         inst->accel_fsr,
@@ -191,6 +231,7 @@ static void mpu9250_i2c_callback(enum i2c_transaction_state const state,
 
     inst->async_i2c_in_progress = 0;
     parse_mpu9250_data(inst, inst->telem_buffer);
+    mpu9250_accumulate_accel(inst, inst->telem_buffer, 1);
     inst->last_sample_time = inst->next_sample_time;
 
     // Check in telemetry buffer if we used one
@@ -198,4 +239,6 @@ static void mpu9250_i2c_callback(enum i2c_transaction_state const state,
         telemetry_finish_mpu9250_imu(inst->telem, inst->telem_buffer);
         inst->telemetry_buffer_checked_out = 0;
     }
+
+    sched_event_signal(&inst->event);
 }
@@ -217,6 +217,9 @@ enum mpu9250_state {
         to enable raw data ready interrupt */
     MPU9250_AG_CONFIG_INT,
 // For FIFO driven operation:
+    /** Write to INT_ENABLE to enable FIFO overflow interrupt status (the
+        interrupt pin is not used) */
+    MPU9250_AG_CONFIG_FIFO_INT,
     /** Write to FIFO_EN to enable writing of gyro x, y and z, accel, temp and
         I2C slave 0 data to FIFO */
     MPU9250_AG_CONFIG_FIFO,
@@ -232,6 +235,9 @@ enum mpu9250_state {
     MPU9250_FIFO_READ_COUNT,
     /** Read samples from FIFO */
     MPU9250_FIFO_READ,
+    /** Write to USER_CTRL to reset FIFO after it overflowed or a read from it
+        failed */
+    MPU9250_FIFO_RESET,
 
 // ##### Failure states #####
     /** Driver failed */
@@ -254,6 +260,10 @@ struct mpu9250_desc_t {
     /** Telemetry service instance */
     struct telemetry_service_desc_t *telem;
 
+    /** Tasks to be marked ready when the sensor's interrupt pin is asserted
+        and when a new sample has been read */
+    struct sched_event_t event;
+
     /** Buffer used for I2C transaction data */
     uint8_t buffer[MPU9250_BUFFER_LENGTH];
 
@@ -272,10 +282,32 @@ struct mpu9250_desc_t {
         calibration */
     int32_t gyro_accumulators[3];
 
+    /** Sums of acceleration samples on each axis since the sums were last
+        taken */
+    int32_t accel_sums[3];
+    /** Number of samples included in accel_sums */
+    uint16_t accel_sum_count;
+
     /** Records time of interrupt before a sample is read from the chip */
     uint32_t next_sample_time;
 
     uint32_t last_sample_time;
+
+    /** Time at which the FIFO count in fifo_samples was read */
+    uint32_t fifo_count_time;
+    /** Estimated rate at which samples are written to the FIFO in samples per
+        second as a 24.8 fixed point value */
+    uint32_t fifo_rate;
+    /** Timebase time at which the transaction that reads the FIFO count was
+        started */
+    uint32_t fifo_request_time;
+    /** Estimated timebase time at which the FIFO count was read */
+    uint32_t fifo_count_micros;
+    /** Estimated timebase time of the oldest sample in the FIFO */
+    uint32_t fifo_head_time;
+    /** Estimated interval between samples in 256ths of a microsecond */
+    uint32_t sample_period;
+
     int16_t last_accel_x;
     int16_t last_accel_y;
     int16_t last_accel_z;
@@ -295,12 +327,26 @@ struct mpu9250_desc_t {
 
     uint8_t samples_left;
 
+    /** Number of samples in the FIFO at fifo_count_time */
+    uint8_t fifo_samples;
+    /** Fractional part of fifo_head_time in 256ths of a microsecond */
+    uint8_t fifo_head_frac;
+    /** Buffer for FIFO count reads queued behind FIFO data reads */
+    uint8_t fifo_count[2];
+    /** Buffer for INT_STATUS reads queued behind FIFO data reads */
+    uint8_t int_status;
+
     /** Sensor I2C address */
     uint8_t mpu9250_addr;
 
 
     /** I2C transaction id */
     uint8_t t_id;
+    /** I2C transaction id for FIFO count reads queued behind FIFO data
+        reads */
+    uint8_t count_t_id;
+    /** I2C transaction id for INT_STATUS reads queued behind FIFO data reads */
+    uint8_t status_t_id;
 
     uint8_t retry_count;
 
@@ -347,6 +393,18 @@ struct mpu9250_desc_t {
     /** Flag to indicate that an I2C transaction initiated from an interrupt is
         in progress (separate from i2c_in_progress to avoid affecting FSM) */
     uint8_t async_i2c_in_progress:1;
+    /** Flag to indicate that fifo_samples and fifo_count_time are valid */
+    uint8_t fifo_count_valid:1;
+    /** Flag to indicate that a FIFO count read has been queued behind the
+        current FIFO data read */
+    uint8_t fifo_count_queued:1;
+    /** Flag to indicate that the current FIFO data read has completed */
+    uint8_t fifo_read_done:1;
+    /** Flag to indicate that an INT_STATUS read has been queued behind the
+        current FIFO data read */
+    uint8_t int_status_queued:1;
+    /** Flag to indicate that fifo_head_time is valid */
+    uint8_t fifo_head_valid:1;
 };
 
 
@@ -369,6 +427,21 @@ static inline void mpu9250_register_telem(struct mpu9250_desc_t *inst,
 
 extern void mpu9250_service(struct mpu9250_desc_t *inst);
 
+/**
+ *  Get the sums of all of the acceleration samples on each axis that have been
+ *  read since the last time the sums were taken and reset the sums. This
+ *  allows a consumer which runs less often than the sample rate to use every
+ *  sample.
+ *
+ *  @param inst The MPU9250 driver instance
+ *  @param sums Array of three values in which the raw sums for the x, y and z
+ *              axes will be placed
+ *
+ *  @return The number of samples included in the sums
+ */
+extern uint16_t mpu9250_take_accel_sums(struct mpu9250_desc_t *inst,
+                                        int32_t *sums);
+
 
 
 
@@ -449,6 +522,19 @@ static inline uint16_t mpu9250_get_ag_odr(const struct mpu9250_desc_t *inst)
     return (uint16_t)1000 / ((uint16_t)(inst->odr) + 1);
 }
 
+/**
+ *  Get the nominal interval between accelerometer and gyroscope samples.
+ *
+ *  @param inst The MPU9250 driver instance
+ *
+ *  @return The nominal sample period in 256ths of a microsecond
+ */
+static inline uint32_t mpu9250_get_ag_period(const struct mpu9250_desc_t *inst)
+{
+    // The sample rate divider divides an internal sample rate of 1 kHz
+    return ((uint32_t)inst->odr + 1) * (1000UL << 8);
+}
+
 /**
  *  Get the full scale range for the accelerometer.
  *
@@ -647,6 +733,8 @@ static inline int mpu9250_get_mag_overflow(const struct mpu9250_desc_t *inst)
  *
  *  @param inst Telemetry service instance
  *  @param time Mission time for data being posted
+ *  @param sample_time Time of the first sample in microseconds
+ *  @param sample_period Interval between samples in 256ths of a microsecond
  *  @param ag_sr_div Sample rate division register value
  *  @param accel_fsr Acceleration full scale range
  *  @param gyro_frs Angular velocity full scale range
@@ -659,7 +747,10 @@ static inline int mpu9250_get_mag_overflow(const struct mpu9250_desc_t *inst)
  */
 extern uint8_t *telemetry_post_mpu9250_imu(
                                            struct telemetry_service_desc_t *inst,
-                                           uint32_t time, uint8_t ag_sr_div,
+                                           uint32_t time,
+                                           uint32_t sample_time,
+                                           uint32_t sample_period,
+                                           uint8_t ag_sr_div,
                                            enum ak8963_odr mag_odr,
                                            enum mpu9250_accel_fsr accel_fsr,
                                            enum mpu9250_gyro_fsr gyro_frs,
@@ -677,5 +768,16 @@ extern uint8_t *telemetry_post_mpu9250_imu(
 extern int telemetry_finish_mpu9250_imu(struct telemetry_service_desc_t *inst,
                                         uint8_t *buffer);
 
+/**
+ *  Return a buffer received from telemetry_post_mpu9250_imu() to the telemetry
+ *  service without recording its contents. The space that had been reserved
+ *  for the buffer is logged as a spacer block.
+ *
+ *  @param inst Telemetry service instance
+ *  @param buffer The buffer to be abandoned.
+ */
+extern int telemetry_abandon_mpu9250_imu(struct telemetry_service_desc_t *inst,
+                                         uint8_t *buffer);
+
 
 #endif /* mpu9250_h */
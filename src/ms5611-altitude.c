@@ -0,0 +1,200 @@
+/**
+ * @file ms5611-altitude.c
+ * @desc Fixed point barometric altitude calculation
+ * @author agent
+ * @date 2026-10-16
+ * Last Author:
+ * Last Edited On:
+ */
+
+#include "ms5611-altitude.h"
+
+/** Number of fractional bits in fixed point values */
+#define ALT_FRAC_BITS   30
+/** Number of bits used to index the tables */
+#define ALT_TABLE_BITS  8
+/** Number of bits of mantissa which are interpolated between table entries */
+#define ALT_INTERP_BITS (31 - ALT_TABLE_BITS)
+
+/** Exponent of the hypsometric formula, 0.1902225604, with 30 fractional
+    bits */
+#define ALT_EXPONENT    INT64_C(204249919)
+/** 20000 / 13 with 16 fractional bits, multiplying a temperature in
+    hundredths of a Kelvin by this value is the same as dividing the
+    temperature in Kelvin by the lapse rate (0.0065 K/m) and converting the
+    result to millimeters */
+#define ALT_LAPSE_RECIP INT64_C(100824615)
+
+/**
+ *  log2(1 + i / 256) with 30 fractional bits for i from 0 to 256.
+ */
+static const uint32_t log2_table[] = {
+    0x00000000, 0x005C2712, 0x00B7F286, 0x01136311, 0x016E7968, 0x01C9363C,
+    0x02239A3B, 0x027DA613, 0x02D75A6F, 0x0330B7F8, 0x0389BF57, 0x03E27130,
+    0x043ACE28, 0x0492D6E0, 0x04EA8BF7, 0x0541EE0E, 0x0598FDBF, 0x05EFBBA6,
+    0x0646285C, 0x069C4478, 0x06F21090, 0x07478D39, 0x079CBB04, 0x07F19A84,
+    0x08462C46, 0x089A70DA, 0x08EE68CC, 0x094214A6, 0x099574F1, 0x09E88A37,
+    0x0A3B54FD, 0x0A8DD5C8, 0x0AE00D1D, 0x0B31FB7D, 0x0B83A16A, 0x0BD4FF64,
+    0x0C2615E8, 0x0C76E574, 0x0CC76E84, 0x0D17B192, 0x0D67AF17, 0x0DB7678C,
+    0x0E06DB67, 0x0E560B1E, 0x0EA4F726, 0x0EF39FF2, 0x0F4205F4, 0x0F90299D,
+    0x0FDE0B5D, 0x102BABA2, 0x10790ADC, 0x10C62975, 0x111307DB, 0x115FA677,
+    0x11AC05B3, 0x11F825F7, 0x124407AB, 0x128FAB36, 0x12DB10FC, 0x13263963,
+    0x137124CF, 0x13BBD3A1, 0x1406463B, 0x14507CFF, 0x149A784C, 0x14E43881,
+    0x152DBDFC, 0x1577091B, 0x15C01A3A, 0x1608F1B4, 0x16518FE4, 0x1699F525,
+    0x16E221CE, 0x172A1638, 0x1771D2BA, 0x17B957AC, 0x1800A563, 0x1847BC34,
+    0x188E9C73, 0x18D54674, 0x191BBA89, 0x1961F905, 0x19A80239, 0x19EDD676,
+    0x1A33760A, 0x1A78E147, 0x1ABE1879, 0x1B031BF0, 0x1B47EBF7, 0x1B8C88DC,
+    0x1BD0F2EA, 0x1C152A6C, 0x1C592FAD, 0x1C9D02F7, 0x1CE0A492, 0x1D2414C8,
+    0x1D6753E0, 0x1DAA6222, 0x1DED3FD4, 0x1E2FED3D, 0x1E726AA2, 0x1EB4B848,
+    0x1EF6D673, 0x1F38C568, 0x1F7A8569, 0x1FBC16B9, 0x1FFD799B, 0x203EAE4F,
+    0x207FB517, 0x20C08E34, 0x210139E5, 0x2141B86A, 0x21820A02, 0x21C22EEB,
+    0x22022763, 0x2241F3A7, 0x228193F5, 0x22C10889, 0x2300519F, 0x233F6F72,
+    0x237E623D, 0x23BD2A3B, 0x23FBC7A6, 0x243A3AB7, 0x247883A8, 0x24B6A2B1,
+    0x24F4980B, 0x253263ED, 0x2570068E, 0x25AD8027, 0x25EAD0EC, 0x2627F914,
+    0x2664F8D5, 0x26A1D065, 0x26DE7FF7, 0x271B07C0, 0x275767F5, 0x2793A0C9,
+    0x27CFB26F, 0x280B9D1A, 0x284760FD, 0x2882FE4A, 0x28BE7531, 0x28F9C5E6,
+    0x2934F098, 0x296FF578, 0x29AAD4B6, 0x29E58E83, 0x2A20230E, 0x2A5A9286,
+    0x2A94DD19, 0x2ACF02F7, 0x2B09044D, 0x2B42E149, 0x2B7C9A19, 0x2BB62EEA,
+    0x2BEF9FE8, 0x2C28ED40, 0x2C62171F, 0x2C9B1DAF, 0x2CD4011D, 0x2D0CC193,
+    0x2D455F3D, 0x2D7DDA45, 0x2DB632D5, 0x2DEE6918, 0x2E267D36, 0x2E5E6F5A,
+    0x2E963FAD, 0x2ECDEE56, 0x2F057B80, 0x2F3CE751, 0x2F7431F2, 0x2FAB5B8B,
+    0x2FE26443, 0x30194C41, 0x305013AB, 0x3086BAAA, 0x30BD4161, 0x30F3A7F9,
+    0x3129EE96, 0x3160155E, 0x31961C77, 0x31CC0404, 0x3201CC2C, 0x32377512,
+    0x326CFEDB, 0x32A269AB, 0x32D7B5A5, 0x330CE2EE, 0x3341F1A7, 0x3376E1F5,
+    0x33ABB3FB, 0x33E067DA, 0x3414FDB5, 0x344975AE, 0x347DCFE7, 0x34B20C82,
+    0x34E62BA0, 0x351A2D63, 0x354E11EB, 0x3581D959, 0x35B583CE, 0x35E9116A,
+    0x361C824D, 0x364FD698, 0x36830E69, 0x36B629E1, 0x36E9291F, 0x371C0C41,
+    0x374ED367, 0x37817EB0, 0x37B40E3A, 0x37E68223, 0x3818DA89, 0x384B178B,
+    0x387D3946, 0x38AF3FD7, 0x38E12B5D, 0x3912FBF4, 0x3944B1B9, 0x39764CCA,
+    0x39A7CD42, 0x39D9333E, 0x3A0A7EDA, 0x3A3BB033, 0x3A6CC765, 0x3A9DC48B,
+    0x3ACEA7C0, 0x3AFF7121, 0x3B3020C8, 0x3B60B6D1, 0x3B913356, 0x3BC19673,
+    0x3BF1E041, 0x3C2210DB, 0x3C52285C, 0x3C8226DD, 0x3CB20C79, 0x3CE1D949,
+    0x3D118D67, 0x3D4128EC, 0x3D70ABF2, 0x3DA01691, 0x3DCF68E3, 0x3DFEA301,
+    0x3E2DC504, 0x3E5CCF03, 0x3E8BC118, 0x3EBA9B5A, 0x3EE95DE2, 0x3F1808C8,
+    0x3F469C23, 0x3F75180C, 0x3FA37C99, 0x3FD1C9E3, 0x40000000
+};
+
+/**
+ *  2^(i / 256) with 30 fractional bits for i from 0 to 256.
+ */
+static const uint32_t exp2_table[] = {
+    0x40000000, 0x402C6BE9, 0x4058F6A8, 0x4085A051, 0x40B268FA, 0x40DF50B8,
+    0x410C57A2, 0x41397DCC, 0x4166C34C, 0x41942839, 0x41C1ACA7, 0x41EF50AE,
+    0x421D1462, 0x424AF7DA, 0x4278FB2B, 0x42A71E6C, 0x42D561B4, 0x4303C518,
+    0x433248AE, 0x4360EC8D, 0x438FB0CB, 0x43BE957F, 0x43ED9AC0, 0x441CC0A3,
+    0x444C0740, 0x447B6EAD, 0x44AAF702, 0x44DAA054, 0x450A6ABB, 0x453A564D,
+    0x456A6323, 0x459A9152, 0x45CAE0F2, 0x45FB521A, 0x462BE4E2, 0x465C9961,
+    0x468D6FAE, 0x46BE67E0, 0x46EF8210, 0x4720BE55, 0x47521CC6, 0x47839D7B,
+    0x47B5408C, 0x47E70611, 0x4818EE22, 0x484AF8D6, 0x487D2646, 0x48AF768A,
+    0x48E1E9BA, 0x49147FEE, 0x4947393F, 0x497A15C4, 0x49AD1598, 0x49E038D0,
+    0x4A137F88, 0x4A46E9D6, 0x4A7A77D4, 0x4AAE299B, 0x4AE1FF43, 0x4B15F8E6,
+    0x4B4A169C, 0x4B7E587E, 0x4BB2BEA5, 0x4BE7492B, 0x4C1BF829, 0x4C50CBB8,
+    0x4C85C3F1, 0x4CBAE0EF, 0x4CF022CA, 0x4D25899C, 0x4D5B157E, 0x4D90C68B,
+    0x4DC69CDD, 0x4DFC988C, 0x4E32B9B4, 0x4E69006E, 0x4E9F6CD4, 0x4ED5FF00,
+    0x4F0CB70C, 0x4F439514, 0x4F7A9930, 0x4FB1C37C, 0x4FE91413, 0x50208B0E,
+    0x50582888, 0x508FEC9C, 0x50C7D765, 0x50FFE8FE, 0x51382182, 0x5170810B,
+    0x51A907B4, 0x51E1B59A, 0x521A8AD7, 0x52538786, 0x528CABC3, 0x52C5F7AA,
+    0x52FF6B55, 0x533906E0, 0x5372CA68, 0x53ACB607, 0x53E6C9DA, 0x542105FD,
+    0x545B6A8B, 0x5495F7A1, 0x54D0AD5A, 0x550B8BD4, 0x55469329, 0x5581C378,
+    0x55BD1CDB, 0x55F89F70, 0x56344B52, 0x567020A0, 0x56AC1F75, 0x56E847EF,
+    0x57249A29, 0x57611642, 0x579DBC57, 0x57DA8C83, 0x581786E6, 0x5854AB9B,
+    0x5891FAC1, 0x58CF7474, 0x590D18D3, 0x594AE7FB, 0x5988E209, 0x59C7071C,
+    0x5A055751, 0x5A43D2C6, 0x5A82799A, 0x5AC14BEA, 0x5B0049D4, 0x5B3F7377,
+    0x5B7EC8F2, 0x5BBE4A61, 0x5BFDF7E5, 0x5C3DD19C, 0x5C7DD7A4, 0x5CBE0A1C,
+    0x5CFE6923, 0x5D3EF4D7, 0x5D7FAD59, 0x5DC092C7, 0x5E01A53F, 0x5E42E4E3,
+    0x5E8451D0, 0x5EC5EC26, 0x5F07B405, 0x5F49A98C, 0x5F8BCCDB, 0x5FCE1E12,
+    0x60109D51, 0x60534AB7, 0x60962665, 0x60D9307B, 0x611C6919, 0x615FD05E,
+    0x61A3666D, 0x61E72B65, 0x622B1F66, 0x626F4292, 0x62B39509, 0x62F816EB,
+    0x633CC85B, 0x6381A978, 0x63C6BA64, 0x640BFB41, 0x64516C2E, 0x64970D4F,
+    0x64DCDEC3, 0x6522E0AD, 0x6569132F, 0x65AF766A, 0x65F60A7F, 0x663CCF92,
+    0x6683C5C3, 0x66CAED35, 0x6712460B, 0x6759D065, 0x67A18C68, 0x67E97A34,
+    0x683199ED, 0x6879EBB6, 0x68C26FB1, 0x690B2601, 0x69540EC9, 0x699D2A2C,
+    0x69E6784D, 0x6A2FF94F, 0x6A79AD56, 0x6AC39485, 0x6B0DAEFF, 0x6B57FCE9,
+    0x6BA27E65, 0x6BED3399, 0x6C381CA6, 0x6C8339B2, 0x6CCE8AE1, 0x6D1A1057,
+    0x6D65CA38, 0x6DB1B8A8, 0x6DFDDBCC, 0x6E4A33C9, 0x6E96C0C3, 0x6EE382DE,
+    0x6F307A41, 0x6F7DA710, 0x6FCB096F, 0x7018A185, 0x70666F76, 0x70B47368,
+    0x7102AD80, 0x71511DE4, 0x719FC4B9, 0x71EEA226, 0x723DB650, 0x728D015D,
+    0x72DC8374, 0x732C3CBA, 0x737C2D55, 0x73CC556D, 0x741CB528, 0x746D4CAC,
+    0x74BE1C20, 0x750F23AB, 0x75606374, 0x75B1DBA2, 0x76038C5B, 0x765575C8,
+    0x76A7980F, 0x76F9F359, 0x774C87CC, 0x779F5590, 0x77F25CCE, 0x78459DAC,
+    0x78991854, 0x78ECCCEC, 0x7940BB9E, 0x7994E492, 0x79E947EF, 0x7A3DE5DF,
+    0x7A92BE8B, 0x7AE7D21A, 0x7B3D20B6, 0x7B92AA88, 0x7BE86FBA, 0x7C3E7073,
+    0x7C94ACDE, 0x7CEB2523, 0x7D41D96E, 0x7D98C9E6, 0x7DEFF6B6, 0x7E476009,
+    0x7E9F0606, 0x7EF6E8DA, 0x7F4F08AE, 0x7FA765AD, 0x80000000
+};
+
+
+/**
+ *  Interpolate linearly between two adjacent table entries.
+ *
+ *  @param table The table to be interpolated in
+ *  @param frac Position within the table with 31 fractional bits
+ *
+ *  @return The interpolated value with 30 fractional bits
+ */
+static inline uint32_t interpolate(uint32_t const *const table,
+                                   uint32_t const frac)
+{
+    uint32_t const i = frac >> ALT_INTERP_BITS;
+    uint32_t const rem = frac & ((UINT32_C(1) << ALT_INTERP_BITS) - 1);
+    uint32_t const step = table[i + 1] - table[i];
+
+    return table[i] + (uint32_t)(((uint64_t)step * rem) >> ALT_INTERP_BITS);
+}
+
+/**
+ *  Calculate the base 2 logarithm of a positive integer.
+ *
+ *  @param x The value for which the logarithm should be found
+ *
+ *  @return log2(x) with 30 fractional bits
+ */
+static int64_t fixed_log2(uint32_t const x)
+{
+    uint32_t const n = 31 - __builtin_clz(x);
+    // Normalize so that the leading one is bit 31 and drop it, leaving the
+    // fractional part of the mantissa
+    uint32_t const frac = (x << (31 - n)) << 1 >> 1;
+
+    return ((int64_t)n << ALT_FRAC_BITS) + interpolate(log2_table, frac);
+}
+
+/**
+ *  Raise 2 to a fixed point power.
+ *
+ *  @param x The exponent with 30 fractional bits
+ *
+ *  @return 2^x with 30 fractional bits
+ */
+static int64_t fixed_exp2(int64_t const x)
+{
+    // Split the exponent into an integer part (rounded towards negative
+    // infinity) and a positive fractional part
+    int64_t const n = x >> ALT_FRAC_BITS;
+    uint32_t const frac = (uint32_t)(x - (n << ALT_FRAC_BITS)) << 1;
+
+    int64_t const mantissa = interpolate(exp2_table, frac);
+    return (n >= 0) ? (mantissa << n) : (mantissa >> -n);
+}
+
+int32_t ms5611_altitude(int32_t pressure, int32_t p0, int32_t temperature)
+{
+    if ((pressure <= 0) || (p0 <= 0)) {
+        return 0;
+    }
+
+    // (p0 / p)^k = 2^(k * (log2(p0) - log2(p)))
+    int64_t const log_ratio = fixed_log2(p0) - fixed_log2(pressure);
+    int64_t const power = fixed_exp2((log_ratio * ALT_EXPONENT) >>
+                                     ALT_FRAC_BITS);
+
+    // Multiply by the temperature in hundredths of a Kelvin and then by the
+    // reciprocal of the lapse rate
+    int64_t const t = temperature + 27315;
+    int64_t const scaled = ((power - (INT64_C(1) << ALT_FRAC_BITS)) * t) >> 16;
+    int64_t const altitude = ((scaled * ALT_LAPSE_RECIP) +
+                              (INT64_C(1) << (ALT_FRAC_BITS - 1))) >>
+                             ALT_FRAC_BITS;
+
+    return (int32_t)altitude;
+}
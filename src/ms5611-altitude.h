@@ -0,0 +1,37 @@
+/**
+ * @file ms5611-altitude.h
+ * @desc Fixed point barometric altitude calculation
+ * @author agent
+ * @date 2026-10-16
+ * Last Author:
+ * Last Edited On:
+ */
+
+#ifndef ms5611_altitude_h
+#define ms5611_altitude_h
+
+#include "global.h"
+
+/**
+ *  Calculate altitude above a reference pressure using the hypsometric formula
+ *
+ *      h = ((p0 / p)^0.1902225604 - 1) * T / 0.0065
+ *
+ *  using only integer arithmetic. The power is found as an exponential of a
+ *  logarithm, each of which is calculated by linear interpolation in a 256
+ *  entry table.
+ *
+ *  Between -500 m and 12 km the result is within 0.1 m of the same formula
+ *  evaluated in double precision floating point.
+ *
+ *  @param pressure The measured pressure in Pascals
+ *  @param p0 The reference pressure in Pascals
+ *  @param temperature The measured temperature in hundredths of a degree
+ *                     celsius
+ *
+ *  @return The altitude in millimeters, or 0 if either pressure is not positive
+ */
+extern int32_t ms5611_altitude(int32_t pressure, int32_t p0,
+                               int32_t temperature);
+
+#endif /* ms5611_altitude_h */
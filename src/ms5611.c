@@ -10,15 +10,47 @@
 #include "ms5611.h"
 
 #include "ms5611-commands.h"
-
-#include <math.h>
+#include "ms5611-altitude.h"
 
 
 #define CONV_WAIT_TIME MS_TO_MILLIS(10)
+#define RATE_WINDOW MS_TO_MILLIS(1000)
 
 static const uint8_t reset_cmd = MS5611_CMD_RESET;
-static const uint8_t adc_conv_d1_cmd = MS5611_CMD_D1 | MS5611_OSR_4096;
-static const uint8_t adc_conv_d2_cmd = MS5611_CMD_D2 | MS5611_OSR_4096;
+static const uint8_t adc_conv_d1_cmds[] = {
+    MS5611_CMD_D1 | MS5611_OSR_256,
+    MS5611_CMD_D1 | MS5611_OSR_512,
+    MS5611_CMD_D1 | MS5611_OSR_1024,
+    MS5611_CMD_D1 | MS5611_OSR_2048,
+    MS5611_CMD_D1 | MS5611_OSR_4096
+};
+static const uint8_t adc_conv_d2_cmds[] = {
+    MS5611_CMD_D2 | MS5611_OSR_256,
+    MS5611_CMD_D2 | MS5611_OSR_512,
+    MS5611_CMD_D2 | MS5611_OSR_1024,
+    MS5611_CMD_D2 | MS5611_OSR_2048,
+    MS5611_CMD_D2 | MS5611_OSR_4096
+};
+
+/** Time to wait for a conversion with each oversampling ratio, the maximum
+    conversion time from the datasheet rounded up with an extra millisecond
+    to account for the resolution of millis */
+static const uint8_t conv_wait_times[] = {
+    MS_TO_MILLIS(2),    // OSR 256, 0.60 ms
+    MS_TO_MILLIS(3),    // OSR 512, 1.17 ms
+    MS_TO_MILLIS(4),    // OSR 1024, 2.28 ms
+    MS_TO_MILLIS(6),    // OSR 2048, 4.54 ms
+    CONV_WAIT_TIME      // OSR 4096, 9.04 ms
+};
+
+enum adc_read_result {
+    /** Read is still in progress */
+    ADC_READ_WAIT,
+    /** A new result was read */
+    ADC_READ_DONE,
+    /** The result was lost, but the next conversion has been started */
+    ADC_READ_LOST
+};
 
 
 void init_ms5611 (struct ms5611_desc_t *inst,
@@ -26,12 +58,19 @@ void init_ms5611 (struct ms5611_desc_t *inst,
                   uint32_t period, uint8_t calculate_altitude)
 {
     inst->address = MS5611_ADDR | ((csb) << MS5611_ADDR_CSB_Pos);
-    inst->period = period;
     inst->calc_altitude = !!calculate_altitude;
     
     inst->i2c_inst = i2c_inst;
     
     inst->p0_set = 0;
+    inst->conv_queued = 0;
+    inst->temp_valid = 0;
+    inst->sample_rate = 0;
+    inst->rate_sample_count = 0;
+    inst->rate_window_start = millis;
+
+    ms5611_set_sampling(inst, period, MS5611_OSR_SEL_4096, MS5611_OSR_SEL_4096,
+                        1);
     
     // Start by reading the factory calibration data
     inst->state = MS5611_READ_C1;
@@ -94,10 +133,7 @@ static uint8_t handle_write_state (struct ms5611_desc_t *inst,
         inst->i2c_in_progress = 0;
         
         if (state == I2C_STATE_DONE) {
-            // Got result!
-            // Swap the bytes so that they are in the correct order
-            inst->prom_values[0] = __builtin_bswap16(inst->prom_values[0]);
-            // go to next state
+            // Command sent, go to next state
             return 1;
         }
         // I2C transaction failed, start a new one
@@ -111,6 +147,131 @@ static uint8_t handle_write_state (struct ms5611_desc_t *inst,
     return 0;
 }
 
+/**
+ * Handle a state in which an ADC result should be read from the sensor. The
+ * command to start the next conversion, if any, is queued right behind the
+ * read so that the conversion starts as soon as the result has been read out.
+ *
+ * @param inst The MS5611 driver instance
+ * @param result The address in which the result should be stored if it is
+ *               read successfully
+ * @param next_cmd Command to start the next conversion or NULL
+ *
+ * @return The status of the read
+ */
+static enum adc_read_result handle_adc_read_state (struct ms5611_desc_t *inst,
+                                                   uint32_t *result,
+                                                   uint8_t const *next_cmd)
+{
+    if (inst->i2c_in_progress) {
+        // Just finished read transaction
+        enum i2c_transaction_state state = sercom_i2c_transaction_state(
+                                                    inst->i2c_inst, inst->t_id);
+        sercom_i2c_clear_transaction(inst->i2c_inst, inst->t_id);
+        inst->i2c_in_progress = 0;
+
+        uint32_t const value = (((uint32_t)inst->adc_buffer[0] << 16) |
+                                ((uint32_t)inst->adc_buffer[1] << 8) |
+                                (uint32_t)inst->adc_buffer[2]);
+
+        // The sensor gives a result of 0 if the conversion was not complete
+        if ((state == I2C_STATE_DONE) && (value != 0)) {
+            *result = value;
+            return ADC_READ_DONE;
+        } else if (inst->conv_queued) {
+            // The next conversion has already been started, so we can't try
+            // the read again
+            return ADC_READ_LOST;
+        }
+        // I2C transaction failed, start a new one
+    }
+    // Need to start read transaction
+    inst->i2c_in_progress = !sercom_i2c_start_reg_read(inst->i2c_inst,
+                                                       &inst->t_id,
+                                                       inst->address,
+                                                       MS5611_CMD_ADC_READ,
+                                                       inst->adc_buffer, 3);
+    if (inst->i2c_in_progress && (next_cmd != NULL)) {
+        inst->conv_queued = !sercom_i2c_start_generic(inst->i2c_inst,
+                                                      &inst->conv_t_id,
+                                                      inst->address, next_cmd,
+                                                      1, NULL, 0);
+    }
+    // Check if transaction is complete on next call
+    return ADC_READ_WAIT;
+}
+
+/**
+ * Handle a state in which we wait for a conversion to complete.
+ *
+ * @param inst The MS5611 driver instance
+ * @param retry_state State to go to if a queued conversion command failed
+ *
+ * @return 1 if the FSM should procceed to the next state, 0 otherwise
+ */
+static uint8_t handle_conv_wait_state (struct ms5611_desc_t *inst,
+                                       enum ms5611_state retry_state)
+{
+    if (inst->conv_queued) {
+        // Conversion command was queued behind the last read
+        if (!sercom_i2c_transaction_done(inst->i2c_inst, inst->conv_t_id)) {
+            return 0;
+        }
+
+        enum i2c_transaction_state state = sercom_i2c_transaction_state(
+                                                inst->i2c_inst, inst->conv_t_id);
+        sercom_i2c_clear_transaction(inst->i2c_inst, inst->conv_t_id);
+        inst->conv_queued = 0;
+
+        if (state != I2C_STATE_DONE) {
+            // Conversion was not started, send the command again
+            inst->state = retry_state;
+            return 0;
+        }
+    }
+
+    return (millis - inst->conv_start_time) >= conv_wait_times[inst->conv_osr];
+}
+
+/**
+ * Decide what should follow the pressure reading which is about to be read.
+ *
+ * @param inst The MS5611 driver instance
+ *
+ * @return The state for the next conversion, or MS5611_IDLE if it is not yet
+ *         time for the next reading
+ */
+static enum ms5611_state next_after_pressure (struct ms5611_desc_t *inst)
+{
+    if ((millis - inst->cycle_start_time) < inst->period) {
+        return MS5611_IDLE;
+    }
+    inst->cycle_start_time = millis;
+
+    if ((inst->pres_since_temp + 1) >= inst->temp_interval) {
+        return MS5611_CONVERT_TEMP;
+    }
+    return MS5611_CONVERT_PRES;
+}
+
+/**
+ * Update the measured sample rate after a pressure reading.
+ *
+ * @param inst The MS5611 driver instance
+ */
+static void update_sample_rate (struct ms5611_desc_t *inst)
+{
+    inst->rate_sample_count++;
+
+    uint32_t const elapsed = millis - inst->rate_window_start;
+    if (elapsed >= RATE_WINDOW) {
+        inst->sample_rate = (((uint32_t)inst->rate_sample_count * 100 *
+                              MS_TO_MILLIS(1000)) / elapsed);
+        inst->rate_sample_count = 0;
+        inst->rate_window_start = millis;
+    }
+}
+
 /**
  *  Perform calculations to find temperature, pressure and altitude based on
  *  most recent values from sensor.
@@ -146,20 +307,33 @@ static void do_calculations (struct ms5611_desc_t *inst)
     inst->pressure = ((((inst->d1 * sensitivity) / 2097152) - offset) / 32768);
     // Set p0 if it has not already been set
     if (!inst->p0_set) {
-        inst->p0 = ((float)inst->pressure) / 100.0f;
+        inst->p0 = inst->pressure;
         inst->p0_set = 1;
     }
     // Calculate altitude
     if (inst->calc_altitude) {
-        float t = ((float)(inst->temperature + 27315)) / 100;
-        float p = ((float)inst->pressure) / 100;
-        inst->altitude = (((powf((inst->p0 / p), 0.1902225604f) - 1.0f) * t) /
-                          0.0065f);
+        inst->altitude = ms5611_altitude(inst->pressure, inst->p0,
+                                         inst->temperature);
     }
 }
 
+void ms5611_set_sampling (struct ms5611_desc_t *inst, uint32_t period,
+                          enum ms5611_osr pres_osr, enum ms5611_osr temp_osr,
+                          uint8_t temp_interval)
+{
+    inst->period = period;
+    inst->pres_osr = pres_osr;
+    inst->temp_osr = temp_osr;
+    inst->temp_interval = (temp_interval != 0) ? temp_interval : 1;
+    // Take a new temperature reading with the new settings right away
+    inst->pres_since_temp = inst->temp_interval;
+}
+
 void ms5611_service (struct ms5611_desc_t *inst)
 {
+    enum adc_read_result read_result;
+    uint8_t const *next_cmd = NULL;
+
     // If this is a wait state there is no point in continuing unless the I2C
     // transaction has completed
     if (inst->i2c_in_progress && !sercom_i2c_transaction_done(inst->i2c_inst,
@@ -266,76 +440,116 @@ void ms5611_service (struct ms5611_desc_t *inst)
             /* fall through */
         case MS5611_IDLE:
             // Waiting for it to be time to start a new read
-            if ((millis - inst->last_reading_time) < inst->period) {
+            if ((millis - inst->cycle_start_time) < inst->period) {
                 // Not yet time to move on
                 break;
             }
-            inst->last_reading_time = millis;
-            inst->state = MS5611_CONVERT_PRES;
+            inst->cycle_start_time = millis;
+            if (inst->pres_since_temp < inst->temp_interval) {
+                // This reading does not need a new temperature
+                inst->state = MS5611_CONVERT_PRES;
+                break;
+            }
+            inst->state = MS5611_CONVERT_TEMP;
             /* fall through */
-        case MS5611_CONVERT_PRES:
-            // In process of sending command to take presure measurment
-            if (handle_write_state(inst, &adc_conv_d1_cmd)) {
+        case MS5611_CONVERT_TEMP:
+            // In process of sending command to take temperature measurment
+            if (handle_write_state(inst, &adc_conv_d2_cmds[inst->temp_osr])) {
                 // Go to the next state
-                inst->state = MS5611_CONVERT_PRES_WAIT;
+                inst->state = MS5611_CONVERT_TEMP_WAIT;
                 // Record time
                 inst->conv_start_time = millis;
+                inst->conv_osr = inst->temp_osr;
             } else {
                 break;
             }
             /* fall through */
-        case MS5611_CONVERT_PRES_WAIT:
+        case MS5611_CONVERT_TEMP_WAIT:
             // Waiting for it to be time to read result
-            if ((millis - inst->conv_start_time) < CONV_WAIT_TIME) {
+            if (!handle_conv_wait_state(inst, MS5611_CONVERT_TEMP)) {
                 // Not yet time to move on
                 break;
             }
-            inst->state = MS5611_READ_PRES;
+            inst->state = MS5611_READ_TEMP;
             /* fall through */
-        case MS5611_READ_PRES:
-            // In process of reading back pressure measurment
-            if (handle_read_state(inst, 3, MS5611_CMD_ADC_READ,
-                                  ((uint8_t*)(&(inst->d1))) + 1)) {
-                *((uint8_t*)(&(inst->d1))) = 0;
-                // Swap bytes to correct endianness
-                inst->d1 = __builtin_bswap32(inst->d1);
-                // Go to the next state
-                inst->state = MS5611_CONVERT_TEMP;
-            } else {
+        case MS5611_READ_TEMP:
+            // In process of reading back temperature measurment, a pressure
+            // reading always follows
+            read_result = handle_adc_read_state(inst, &inst->d2,
+                                        &adc_conv_d1_cmds[inst->pres_osr]);
+            if (read_result == ADC_READ_WAIT) {
                 break;
+            } else if (read_result == ADC_READ_DONE) {
+                inst->pres_since_temp = 0;
+                inst->temp_valid = 1;
             }
-            /* fall through */
-        case MS5611_CONVERT_TEMP:
-            // In process of sending command to take temperature measurment
-            if (handle_write_state(inst, &adc_conv_d2_cmd)) {
+            // Go to the next state
+            if (inst->conv_queued) {
+                inst->state = MS5611_CONVERT_PRES_WAIT;
+                inst->conv_start_time = millis;
+                inst->conv_osr = inst->pres_osr;
+            } else {
+                inst->state = MS5611_CONVERT_PRES;
+            }
+            break;
+        case MS5611_CONVERT_PRES:
+            // In process of sending command to take presure measurment
+            if (handle_write_state(inst, &adc_conv_d1_cmds[inst->pres_osr])) {
                 // Go to the next state
-                inst->state = MS5611_CONVERT_TEMP_WAIT;
+                inst->state = MS5611_CONVERT_PRES_WAIT;
                 // Record time
                 inst->conv_start_time = millis;
+                inst->conv_osr = inst->pres_osr;
             } else {
                 break;
             }
             /* fall through */
-        case MS5611_CONVERT_TEMP_WAIT:
+        case MS5611_CONVERT_PRES_WAIT:
             // Waiting for it to be time to read result
-            if ((millis - inst->conv_start_time) < CONV_WAIT_TIME) {
+            if (!handle_conv_wait_state(inst, MS5611_CONVERT_PRES)) {
                 // Not yet time to move on
                 break;
             }
-            inst->state = MS5611_READ_TEMP;
+            inst->state = MS5611_READ_PRES;
             /* fall through */
-        case MS5611_READ_TEMP:
-            // In process of reading back temperature measurment
-            if (!(handle_read_state(inst, 3, MS5611_CMD_ADC_READ,
-                                   ((uint8_t*)(&(inst->d2))) + 1))) {
+        case MS5611_READ_PRES:
+            // In process of reading back pressure measurment
+            if (!inst->i2c_in_progress) {
+                // About to start the read, decide which conversion should be
+                // queued behind it
+                inst->next_state = next_after_pressure(inst);
+            }
+            if (inst->next_state == MS5611_CONVERT_TEMP) {
+                next_cmd = &adc_conv_d2_cmds[inst->temp_osr];
+            } else if (inst->next_state == MS5611_CONVERT_PRES) {
+                next_cmd = &adc_conv_d1_cmds[inst->pres_osr];
+            }
+            uint32_t const pres_conv_start_time = inst->conv_start_time;
+            read_result = handle_adc_read_state(inst, &inst->d1, next_cmd);
+            if (read_result == ADC_READ_WAIT) {
                 break;
+            } else if ((read_result == ADC_READ_DONE) && inst->temp_valid) {
+                if (inst->pres_since_temp < UINT8_MAX) {
+                    inst->pres_since_temp++;
+                }
+                inst->last_reading_time = pres_conv_start_time;
+                do_calculations(inst);
+                update_sample_rate(inst);
+            }
+            // Go to the next state
+            if (inst->next_state == MS5611_IDLE) {
+                inst->state = MS5611_IDLE;
+            } else if (!inst->conv_queued) {
+                inst->state = inst->next_state;
+            } else if (inst->next_state == MS5611_CONVERT_TEMP) {
+                inst->state = MS5611_CONVERT_TEMP_WAIT;
+                inst->conv_start_time = millis;
+                inst->conv_osr = inst->temp_osr;
+            } else {
+                inst->state = MS5611_CONVERT_PRES_WAIT;
+                inst->conv_start_time = millis;
+                inst->conv_osr = inst->pres_osr;
             }
-            // Swap bytes to correct endianness
-            *((uint8_t*)(&(inst->d2))) = 0;
-            inst->d2 = __builtin_bswap32(inst->d2);
-            do_calculations(inst);
-            // Wait till next measurment should be taken
-            inst->state = MS5611_IDLE;
             break;
         case MS5611_FAILED:
             // Something has gone wrong
@@ -33,21 +33,35 @@ enum ms5611_state {
     MS5611_FAILED
 };
 
+/** Oversampling ratio used for conversions, higher oversampling ratios give
+    lower noise but take longer */
+enum ms5611_osr {
+    MS5611_OSR_SEL_256,
+    MS5611_OSR_SEL_512,
+    MS5611_OSR_SEL_1024,
+    MS5611_OSR_SEL_2048,
+    MS5611_OSR_SEL_4096
+};
+
 struct ms5611_desc_t {
     /** I2C instance used by this sensor */
     struct sercom_i2c_desc_t *i2c_inst;
     
-    /** Time of last reading from sensor */
+    /** Time at which the pressure conversion for the last reading from the
+        sensor was started */
     uint32_t last_reading_time;
+    /** Time at which the most recent reading cycle was started, used to
+        schedule readings */
+    uint32_t cycle_start_time;
     /** Temperature compensated pressure read from sensor */
     int32_t pressure;
     /** Temperature read from sensor */
     int32_t temperature;
-    /** Altitude calculated from sensor */
-    float altitude;
+    /** Altitude calculated from sensor in millimeters */
+    int32_t altitude;
     
-    /** Pressure used as 0 for altitude calculations */
-    float p0;
+    /** Pressure used as 0 for altitude calculations in Pascals */
+    int32_t p0;
     /** Digital pressure value from ADC  */
     uint32_t d1;
     /** Digital tempuratue value from ADC */
@@ -58,21 +72,51 @@ struct ms5611_desc_t {
     
     /** Time between readings of the sensor */
     uint32_t period;
+
+    /** Start of the window over which the sample rate is being measured */
+    uint32_t rate_window_start;
+    /** Number of pressure readings completed in the current window */
+    uint16_t rate_sample_count;
+    /** Measured rate at which pressure readings are completed in hundredths
+        of a Hertz */
+    uint16_t sample_rate;
     
     /** Values read from sensor PROM */
     uint16_t prom_values[6];
+    /** Buffer for raw ADC results */
+    uint8_t adc_buffer[3];
     /** I2C address for sensor */
     uint8_t address;
     /** I2C transaction id */
     uint8_t t_id;
+    /** I2C transaction id for conversion commands queued behind ADC reads */
+    uint8_t conv_t_id;
+    /** Number of pressure readings to take for each temperature reading */
+    uint8_t temp_interval;
+    /** Number of pressure readings taken since the last temperature
+        reading */
+    uint8_t pres_since_temp;
     /** Current driver state */
     enum ms5611_state state:4;
+    /** State to go to once the current pressure reading has been read */
+    enum ms5611_state next_state:4;
+    /** Oversampling ratio for pressure conversions */
+    enum ms5611_osr pres_osr:3;
+    /** Oversampling ratio for temperature conversions */
+    enum ms5611_osr temp_osr:3;
+    /** Oversampling ratio of the conversion which is currently running */
+    enum ms5611_osr conv_osr:3;
     /** Currently waiting for an I2C transaction to complete */
     uint8_t i2c_in_progress:1;
     /** Flag to indicate whether altitude should be calculated */
     uint8_t calc_altitude:1;
     /** Flag to indicate whether p0 has been initialized */
     uint8_t p0_set:1;
+    /** Flag to indicate that a conversion command has been queued behind the
+        current ADC read */
+    uint8_t conv_queued:1;
+    /** Flag to indicate that a temperature reading has been taken */
+    uint8_t temp_valid:1;
 };
 
 /**
@@ -92,6 +136,25 @@ extern void init_ms5611 (struct ms5611_desc_t *inst,
 
 
 
+/**
+ * Configure how readings are taken. One temperature reading is taken for every
+ * temp_interval pressure readings, the pressure readings in between are
+ * compensated using the most recent temperature reading. The conversion for
+ * the next reading is started in the I2C transaction right after the previous
+ * result is read, so with a period of 0 readings are taken back to back as
+ * fast as the sensor allows.
+ *
+ * @param inst The MS5611 driver instance
+ * @param period Period in milliseconds at which readings should be started
+ * @param pres_osr Oversampling ratio for pressure conversions
+ * @param temp_osr Oversampling ratio for temperature conversions
+ * @param temp_interval Number of pressure readings per temperature reading
+ */
+extern void ms5611_set_sampling (struct ms5611_desc_t *inst, uint32_t period,
+                                 enum ms5611_osr pres_osr,
+                                 enum ms5611_osr temp_osr,
+                                 uint8_t temp_interval);
+
 /**
  * Service to be run in each iteration of the main loop.
  *
@@ -132,6 +195,18 @@ static inline int32_t ms5611_get_temperature (struct ms5611_desc_t *inst)
  * @return The most recently measured altitude in meters
  */
 static inline float ms5611_get_altitude (struct ms5611_desc_t *inst)
+{
+    return ((float)inst->altitude) / 1000.0f;
+}
+
+/**
+ * Get the most recently measured altitude value in millimeters.
+ *
+ * @param inst The MS5611 driver instance
+ *
+ * @return The most recently measured altitude in millimeters
+ */
+static inline int32_t ms5611_get_altitude_mm (struct ms5611_desc_t *inst)
 {
     return inst->altitude;
 }
@@ -148,6 +223,18 @@ static inline uint32_t ms5611_get_last_reading_time (struct ms5611_desc_t *inst)
     return inst->last_reading_time;
 }
 
+/**
+ * Get the rate at which pressure readings are being completed.
+ *
+ * @param inst The MS5611 driver instance
+ *
+ * @return The measured sample rate in hundredths of a Hertz
+ */
+static inline uint16_t ms5611_get_sample_rate (struct ms5611_desc_t *inst)
+{
+    return inst->sample_rate;
+}
+
 /**
  * Set the period at which readings are taken.
  *
@@ -169,7 +256,7 @@ static inline void ms5611_set_period (struct ms5611_desc_t *inst,
  */
 static inline void ms5611_tare_now (struct ms5611_desc_t *inst)
 {
-    inst->p0 = ((float)inst->pressure) / 100.0f;
+    inst->p0 = inst->pressure;
 }
 
 /**
@@ -0,0 +1,251 @@
+/**
+ * @file nmea.c
+ * @desc Streaming parser for NMEA 0183 sentences
+ * @author agent
+ * @date 2026-10-16
+ * Last Author:
+ * Last Edited On:
+ */
+
+#include "nmea.h"
+
+static const uint32_t powers_of_ten[] = { 1, 10, 100, 1000, 10000, 100000,
+                                          1000000, 10000000, 100000000,
+                                          1000000000 };
+
+#define NUM_POWERS_OF_TEN (sizeof(powers_of_ten) / sizeof(powers_of_ten[0]))
+
+
+void init_nmea_parser(struct nmea_parser_t *const parser,
+                      const struct nmea_sentence_t *const sentences,
+                      uint8_t const num_sentences, void *const context)
+{
+    parser->sentences = sentences;
+    parser->num_sentences = num_sentences;
+    parser->context = context;
+    parser->current = NULL;
+    parser->valid_sentences = 0;
+    parser->checksum_errors = 0;
+    parser->state = NMEA_STATE_IDLE;
+}
+
+/**
+ *  Get the value of a hexadecimal digit.
+ *
+ *  @param c The digit
+ *
+ *  @return The value of the digit, or 0xFF if c is not a hexadecimal digit
+ */
+static inline uint8_t hex_value(uint8_t const c)
+{
+    if ((c >= '0') && (c <= '9')) {
+        return c - '0';
+    } else if ((c >= 'A') && (c <= 'F')) {
+        return c - 'A' + 10;
+    } else if ((c >= 'a') && (c <= 'f')) {
+        return c - 'a' + 10;
+    }
+    return 0xFF;
+}
+
+static inline void reset_field(struct nmea_field_t *const field)
+{
+    field->value = 0;
+    field->decimals = 0;
+    field->length = 0;
+    field->negative = 0;
+    field->seen_decimal = 0;
+}
+
+/**
+ *  Start parsing a new sentence.
+ *
+ *  @param parser The parser instance
+ */
+static void start_sentence(struct nmea_parser_t *const parser)
+{
+    parser->checksum = 0;
+    parser->id = 0;
+    parser->index = 0;
+    parser->current = NULL;
+    reset_field(&parser->field);
+    parser->state = NMEA_STATE_ADDRESS;
+}
+
+/**
+ *  Add a character to the field that is being received.
+ *
+ *  @param field The field
+ *  @param c The received character
+ */
+static void field_add_char(struct nmea_field_t *const field, uint8_t const c)
+{
+    if (field->length < NMEA_FIELD_TEXT_LEN) {
+        field->text[field->length] = (char)c;
+    }
+
+    if ((c >= '0') && (c <= '9')) {
+        // Digits past what we can store are ignored, fractional digits past
+        // the maximum number of decimals are truncated
+        if ((field->value <= ((UINT32_MAX - 9) / 10)) &&
+                (!field->seen_decimal ||
+                 (field->decimals < NMEA_MAX_DECIMALS))) {
+            field->value = (field->value * 10) + (c - '0');
+            field->decimals += field->seen_decimal;
+        }
+    } else if (c == '.') {
+        field->seen_decimal = 1;
+    } else if ((c == '-') && (field->length == 0)) {
+        field->negative = 1;
+    }
+
+    if (field->length < UINT8_MAX) {
+        field->length++;
+    }
+}
+
+/**
+ *  Handle the end of a field.
+ *
+ *  @param parser The parser instance
+ */
+static void end_field(struct nmea_parser_t *const parser)
+{
+    struct nmea_field_t *const field = &parser->field;
+
+    field->text[(field->length < NMEA_FIELD_TEXT_LEN) ? field->length :
+                                                        NMEA_FIELD_TEXT_LEN] =
+            '\0';
+
+    if (parser->index == 0) {
+        // End of the address, look for a parser for this sentence
+        if ((field->length == 0) || (field->length > NMEA_ID_MAX_CHARS)) {
+            return;
+        }
+        for (uint8_t i = 0; i < parser->num_sentences; i++) {
+            if (parser->sentences[i].id == parser->id) {
+                parser->current = parser->sentences + i;
+                break;
+            }
+        }
+    } else if ((parser->current != NULL) &&
+               (parser->current->field != NULL)) {
+        parser->current->field(parser->context, parser->id, parser->index,
+                               field);
+    }
+}
+
+/**
+ *  Handle a checksum character.
+ *
+ *  @param parser The parser instance
+ *  @param c The received character
+ */
+static void parse_checksum(struct nmea_parser_t *const parser, uint8_t const c)
+{
+    uint8_t const value = hex_value(c);
+
+    if (value == 0xFF) {
+        parser->checksum_errors++;
+        if (c == '$') {
+            start_sentence(parser);
+        } else {
+            parser->state = NMEA_STATE_IDLE;
+        }
+        return;
+    }
+
+    if (parser->state == NMEA_STATE_CHECKSUM_HIGH) {
+        parser->received_checksum = (uint8_t)(value << 4);
+        parser->state = NMEA_STATE_CHECKSUM_LOW;
+        return;
+    }
+
+    parser->received_checksum |= value;
+    parser->state = NMEA_STATE_IDLE;
+
+    if (parser->received_checksum != parser->checksum) {
+        parser->checksum_errors++;
+        return;
+    }
+
+    parser->valid_sentences++;
+    if ((parser->current != NULL) && (parser->current->commit != NULL)) {
+        parser->current->commit(parser->context, parser->id);
+    }
+}
+
+void nmea_parse(struct nmea_parser_t *const parser, const uint8_t *data,
+                uint16_t length)
+{
+    for (; length > 0; length--, data++) {
+        uint8_t const c = *data;
+
+        switch (parser->state) {
+            case NMEA_STATE_IDLE:
+                if (c == '$') {
+                    start_sentence(parser);
+                }
+                break;
+            case NMEA_STATE_ADDRESS:
+            case NMEA_STATE_FIELD:
+                if (c == '$') {
+                    // Start of a new sentence before the end of this one
+                    parser->checksum_errors++;
+                    start_sentence(parser);
+                } else if (c == '*') {
+                    end_field(parser);
+                    parser->state = NMEA_STATE_CHECKSUM_HIGH;
+                } else if ((c == '\r') || (c == '\n')) {
+                    // Sentence has no checksum
+                    parser->checksum_errors++;
+                    parser->state = NMEA_STATE_IDLE;
+                } else if (c == ',') {
+                    parser->checksum ^= c;
+                    end_field(parser);
+                    parser->index++;
+                    reset_field(&parser->field);
+                    parser->state = NMEA_STATE_FIELD;
+                } else {
+                    parser->checksum ^= c;
+                    if (parser->state == NMEA_STATE_ADDRESS) {
+                        parser->id = NMEA_ID_CHAR(parser->id, c);
+                    }
+                    field_add_char(&parser->field, c);
+                }
+                break;
+            case NMEA_STATE_CHECKSUM_HIGH:
+            case NMEA_STATE_CHECKSUM_LOW:
+                parse_checksum(parser, c);
+                break;
+            default:
+                parser->state = NMEA_STATE_IDLE;
+                break;
+        }
+    }
+}
+
+void nmea_discard_sentence(struct nmea_parser_t *const parser)
+{
+    if (parser->state != NMEA_STATE_IDLE) {
+        // Counted the same way as a sentence which is cut off
+        parser->checksum_errors++;
+        parser->state = NMEA_STATE_IDLE;
+    }
+}
+
+int32_t nmea_field_fixed(const struct nmea_field_t *const field,
+                         uint8_t const decimals)
+{
+    uint32_t value = field->value;
+
+    if (decimals > field->decimals) {
+        uint8_t const shift = decimals - field->decimals;
+        value *= powers_of_ten[(shift < NUM_POWERS_OF_TEN) ?
+                               shift : (NUM_POWERS_OF_TEN - 1)];
+    } else if (decimals < field->decimals) {
+        value /= powers_of_ten[field->decimals - decimals];
+    }
+
+    return field->negative ? -(int32_t)value : (int32_t)value;
+}
@@ -0,0 +1,188 @@
+/**
+ * @file nmea.h
+ * @desc Streaming parser for NMEA 0183 sentences
+ * @author agent
+ * @date 2026-10-16
+ * Last Author:
+ * Last Edited On:
+ */
+
+#ifndef nmea_h
+#define nmea_h
+
+#include "global.h"
+
+/*
+ *  The parser is fed received bytes one at a time and never buffers a whole
+ *  sentence. The checksum is calculated as bytes arrive and the sentence
+ *  address (talker and type, ie. "GPRMC") is packed into an integer ID as it
+ *  is received so that the sentence can be looked up without any string
+ *  comparisons.
+ *
+ *  Each field is accumulated as it arrives into a fixed point number and a
+ *  short prefix of its text. When a field is complete it is passed to the
+ *  field callback for the sentence, which should store anything it needs in
+ *  a staging area. Once the checksum has been received and verified the commit
+ *  callback for the sentence is called to make the staged values visible.
+ */
+
+/** Maximum number of fractional digits kept for numeric fields, a longitude
+    with this many digits still fits in 32 bits */
+#define NMEA_MAX_DECIMALS       5
+/** Number of characters from the start of each field which are kept */
+#define NMEA_FIELD_TEXT_LEN     15
+
+/**
+ *  Pack a character of a sentence address into a sentence ID. Six bits are
+ *  used per character, which covers digits and upper case letters.
+ */
+#define NMEA_ID_CHAR(id, c) ((uint32_t)(((uint32_t)(id) << 6) | \
+                                        (((uint32_t)(c) - '0') & 0x3F)))
+
+/**
+ *  Get the ID for a five character sentence address.
+ */
+#define NMEA_ID(a, b, c, d, e) NMEA_ID_CHAR(NMEA_ID_CHAR(NMEA_ID_CHAR( \
+                               NMEA_ID_CHAR(NMEA_ID_CHAR(0, a), b), c), d), e)
+
+/** Longest sentence address which can be represented as an ID */
+#define NMEA_ID_MAX_CHARS   5
+
+
+/**
+ *  A field from a NMEA sentence.
+ */
+struct nmea_field_t {
+    /** Magnitude of the numeric value of the field with decimals fractional
+        decimal digits */
+    uint32_t value;
+    /** Number of fractional decimal digits in value */
+    uint8_t decimals;
+    /** Number of characters in the field */
+    uint8_t length;
+    /** Flag to indicate that the field started with a minus sign */
+    uint8_t negative:1;
+    /** Flag to indicate that a decimal point has been received */
+    uint8_t seen_decimal:1;
+    /** The start of the text of the field, null terminated */
+    char text[NMEA_FIELD_TEXT_LEN + 1];
+};
+
+/**
+ *  Parser for a type of NMEA sentence.
+ */
+struct nmea_sentence_t {
+    /** Sentence ID, as created by NMEA_ID() */
+    uint32_t id;
+    /** Function called for each complete field after the sentence address,
+        the first field after the address has index 1 */
+    void (*field)(void *context, uint32_t id, uint8_t index,
+                  const struct nmea_field_t *field);
+    /** Function called once the sentence has been received with a correct
+        checksum */
+    void (*commit)(void *context, uint32_t id);
+};
+
+enum nmea_parser_state {
+    /** Waiting for the start of a sentence */
+    NMEA_STATE_IDLE,
+    /** Receiving the sentence address */
+    NMEA_STATE_ADDRESS,
+    /** Receiving the fields of a sentence */
+    NMEA_STATE_FIELD,
+    /** Receiving the first character of the checksum */
+    NMEA_STATE_CHECKSUM_HIGH,
+    /** Receiving the second character of the checksum */
+    NMEA_STATE_CHECKSUM_LOW
+};
+
+/**
+ *  Instance of an NMEA parser.
+ */
+struct nmea_parser_t {
+    /** Table of sentences which can be parsed */
+    const struct nmea_sentence_t *sentences;
+    /** Parser for the current sentence, NULL if it is not in the table */
+    const struct nmea_sentence_t *current;
+    /** Context passed to sentence callbacks */
+    void *context;
+
+    /** Field currently being received */
+    struct nmea_field_t field;
+    /** ID of the current sentence */
+    uint32_t id;
+
+    /** Number of sentences received with a correct checksum */
+    uint32_t valid_sentences;
+    /** Number of sentences received with an incorrect or missing checksum */
+    uint32_t checksum_errors;
+
+    /** Checksum calculated over the current sentence */
+    uint8_t checksum;
+    /** Checksum received at the end of the current sentence */
+    uint8_t received_checksum;
+    /** Index of the field currently being received */
+    uint8_t index;
+    /** Number of entries in the sentence table */
+    uint8_t num_sentences;
+    /** Current parser state */
+    enum nmea_parser_state state:3;
+};
+
+
+/**
+ *  Initialize an NMEA parser.
+ *
+ *  @param parser The parser instance to be initialized
+ *  @param sentences Table of sentences to be parsed
+ *  @param num_sentences Number of entries in the sentence table
+ *  @param context Pointer which is passed to sentence callbacks
+ */
+extern void init_nmea_parser(struct nmea_parser_t *parser,
+                             const struct nmea_sentence_t *sentences,
+                             uint8_t num_sentences, void *context);
+
+/**
+ *  Feed received bytes to an NMEA parser.
+ *
+ *  @param parser The parser instance
+ *  @param data The received bytes
+ *  @param length The number of bytes in data
+ */
+extern void nmea_parse(struct nmea_parser_t *parser, const uint8_t *data,
+                       uint16_t length);
+
+/**
+ *  Throw away the sentence that is currently being received, for example
+ *  because some of the data that was passed to nmea_parse() turned out to be
+ *  corrupt. Parsing starts again at the next sentence.
+ *
+ *  @param parser The parser instance
+ */
+extern void nmea_discard_sentence(struct nmea_parser_t *parser);
+
+/**
+ *  Get the value of a numeric field as a fixed point number.
+ *
+ *  @param field The field
+ *  @param decimals The number of fractional decimal digits in the result
+ *
+ *  @return The value of the field multiplied by 10^decimals
+ */
+extern int32_t nmea_field_fixed(const struct nmea_field_t *field,
+                                uint8_t decimals);
+
+/**
+ *  Get the value of a numeric field as an integer, any fractional part is
+ *  truncated.
+ *
+ *  @param field The field
+ *
+ *  @return The integer value of the field
+ */
+static inline int32_t nmea_field_int(const struct nmea_field_t *field)
+{
+    return nmea_field_fixed(field, 0);
+}
+
+#endif /* nmea_h */
@@ -0,0 +1,171 @@
+/**
+ * @file profiler.c
+ * @desc Execution time and interrupt latency profiling
+ * @author agent
+ * @date 2026-10-16
+ * Last Author:
+ * Last Edited On:
+ */
+
+#include "profiler.h"
+
+#include <string.h>
+
+#include "global.h"
+#include "scheduler.h"
+#include "logging.h"
+#include "logging-format.h"
+
+#if defined(SAMD2x)
+#include "timebase.h"
+#endif
+
+_Static_assert(PROFILER_HIST_BUCKETS == LOGGING_PROFILE_BUCKETS, "Profiler "
+               "histograms must have the same number of buckets as profile "
+               "log entries.");
+
+struct profiler_hist_t profiler_isr_latency_g;
+struct profiler_hist_t profiler_irq_off_g;
+uint32_t profiler_irq_off_start_g;
+
+
+void init_profiler(void)
+{
+#if defined(SAMx5x)
+    // Enable the DWT cycle counter
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#ifdef ENABLE_PROFILER
+    // millis comes from the RTC on SAMx5x, so SysTick is only used to measure
+    // interrupt latency
+    SysTick_Config(F_CPU / 1000);
+    NVIC_SetPriority(SysTick_IRQn, 0);
+#endif
+#endif
+
+    profiler_clear();
+}
+
+#if defined(SAMD2x)
+uint32_t profiler_now(void)
+{
+    return timebase_micros();
+}
+#endif
+
+void profiler_hist_record(struct profiler_hist_t *hist, uint32_t value)
+{
+    if ((hist->count == 0) || (value < hist->min)) {
+        hist->min = value;
+    }
+    if (value > hist->max) {
+        hist->max = value;
+    }
+    hist->total += value;
+    hist->count++;
+
+    uint32_t const scaled = value >> PROFILER_HIST_SHIFT;
+    uint8_t bucket = (scaled == 0) ? 0 : (32 - __builtin_clz(scaled));
+    if (bucket >= PROFILER_HIST_BUCKETS) {
+        bucket = PROFILER_HIST_BUCKETS - 1;
+    }
+    if (hist->buckets[bucket] != UINT16_MAX) {
+        hist->buckets[bucket]++;
+    }
+}
+
+void profiler_hist_clear(struct profiler_hist_t *hist)
+{
+    hist->total = 0;
+    hist->count = 0;
+    hist->min = 0;
+    hist->max = 0;
+    memset(hist->buckets, 0, sizeof(hist->buckets));
+}
+
+uint32_t profiler_ticks_to_ns(uint32_t ticks)
+{
+    uint64_t const ns = ((uint64_t)ticks * 1000000000UL) / PROFILER_TICK_FREQ;
+    return (ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)ns;
+}
+
+uint32_t profiler_cycles_to_ns(uint32_t cycles)
+{
+    uint64_t const ns = ((uint64_t)cycles * 1000000000UL) / F_CPU;
+    return (ns > UINT32_MAX) ? UINT32_MAX : (uint32_t)ns;
+}
+
+void profiler_clear(void)
+{
+    __disable_irq();
+    profiler_hist_clear(&profiler_isr_latency_g);
+    profiler_hist_clear(&profiler_irq_off_g);
+    __enable_irq();
+}
+
+/**
+ *  Marshal a histogram into a profile log block entry.
+ */
+static void profiler_marshal_entry(struct logging_diag_profile_entry *entry,
+                                   const char *name,
+                                   const struct profiler_hist_t *hist)
+{
+    memset(entry->name, 0, sizeof(entry->name));
+    memcpy(entry->name, name, strnlen(name, sizeof(entry->name)));
+    entry->count = hist->count;
+    entry->min = hist->min;
+    entry->max = hist->max;
+    entry->mean = profiler_hist_mean(hist);
+    memcpy(entry->buckets, hist->buckets, sizeof(entry->buckets));
+}
+
+int profiler_log(struct logging_desc_t *logging)
+{
+    // Include as many tasks as will fit in a logging buffer
+    uint16_t const max_entries = ((LOGGING_BUFFER_SIZE -
+                                   LOGGING_BLOCK_HEADER_LENGTH -
+                                   sizeof(struct logging_diag_profile_head)) /
+                                  sizeof(struct logging_diag_profile_entry));
+    uint16_t num_entries = 3;
+    for (struct sched_task_t *t = sched_get_tasks();
+            (t != NULL) && (num_entries < max_entries); t = t->next) {
+        num_entries++;
+    }
+
+    uint16_t const length = (LOGGING_BLOCK_HEADER_LENGTH +
+                             sizeof(struct logging_diag_profile_head) +
+                             (num_entries *
+                              sizeof(struct logging_diag_profile_entry)));
+
+    uint8_t *buffer;
+    if (log_checkout(logging, &buffer, length) != 0) {
+        return 1;
+    }
+
+    logging_block_marshal_header(buffer, LOGGING_BLOCK_CLASS_DIAG,
+                                 LOGGING_DIAG_TYPE_PROFILE, length);
+
+    struct logging_diag_profile_head *const head =
+                (struct logging_diag_profile_head *)__builtin_assume_aligned(
+                                    buffer + LOGGING_BLOCK_HEADER_LENGTH, 4);
+    head->time = millis;
+    head->tick_freq = PROFILER_TICK_FREQ;
+    head->cycle_freq = F_CPU;
+    head->hist_shift = PROFILER_HIST_SHIFT;
+    head->num_entries = num_entries;
+    head->RESERVED = 0;
+
+    struct logging_diag_profile_entry *entry =
+                                (struct logging_diag_profile_entry *)(head + 1);
+    profiler_marshal_entry(entry++, "isr-lat", &profiler_isr_latency_g);
+    profiler_marshal_entry(entry++, "irq-off", &profiler_irq_off_g);
+    profiler_marshal_entry(entry++, "loop", &sched_get_stats()->pass_time);
+
+    struct sched_task_t *t = sched_get_tasks();
+    for (uint16_t i = 3; i < num_entries; i++, t = t->next) {
+        profiler_marshal_entry(entry++, t->name, &t->run_time);
+    }
+
+    return log_checkin(logging, buffer);
+}
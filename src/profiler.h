@@ -0,0 +1,201 @@
+/**
+ * @file profiler.h
+ * @desc Execution time and interrupt latency profiling
+ * @author agent
+ * @date 2026-10-16
+ * Last Author:
+ * Last Edited On:
+ */
+
+#ifndef profiler_h
+#define profiler_h
+
+#include "target.h"
+
+#include <stdint.h>
+
+/*
+ *  Times are measured in profiler ticks. On SAMx5x a profiler tick is one CPU
+ *  cycle as counted by the DWT cycle counter. The Cortex-M0+ in the SAMD2x
+ *  does not have a cycle counter, so the microsecond timebase TC is used
+ *  instead.
+ *
+ *  Interrupt entry latency is measured in CPU cycles on both targets by
+ *  looking at how far the SysTick counter has gotten past its reload value
+ *  when the SysTick handler starts.
+ *
+ *  Periods with interrupts disabled by inhibit_sleep(), allow_sleep() and the
+ *  circular buffer functions are only measured when the firmware is built
+ *  with ENABLE_PROFILER defined (make PROFILE=1) because the measurement
+ *  makes every one of those critical sections longer.
+ */
+
+#if defined(SAMD2x)
+/** Frequency of profiler ticks */
+#define PROFILER_TICK_FREQ      1000000UL
+/** Number of bits that values are shifted right before finding their
+    histogram bucket */
+#define PROFILER_HIST_SHIFT     0
+#elif defined(SAMx5x)
+/** Frequency of profiler ticks */
+#define PROFILER_TICK_FREQ      F_CPU
+/** Number of bits that values are shifted right before finding their
+    histogram bucket */
+#define PROFILER_HIST_SHIFT     4
+#endif
+
+/** Number of buckets in each histogram. Bucket 0 counts values that are less
+    than 2^PROFILER_HIST_SHIFT, bucket n counts values that are at least
+    2^(n - 1 + PROFILER_HIST_SHIFT) but less than 2^(n + PROFILER_HIST_SHIFT)
+    and the last bucket counts all larger values. */
+#define PROFILER_HIST_BUCKETS   16
+
+/**
+ *  Histogram and summary statistics for a measured quantity.
+ */
+struct profiler_hist_t {
+    /** Sum of all recorded values */
+    uint64_t total;
+    /** Number of recorded values */
+    uint32_t count;
+    /** Smallest recorded value */
+    uint32_t min;
+    /** Largest recorded value */
+    uint32_t max;
+    /** Number of values in each bucket, saturates at UINT16_MAX */
+    uint16_t buckets[PROFILER_HIST_BUCKETS];
+};
+
+/** Interrupt entry latency in CPU cycles */
+extern struct profiler_hist_t profiler_isr_latency_g;
+/** Lengths of periods with interrupts disabled in profiler ticks */
+extern struct profiler_hist_t profiler_irq_off_g;
+/** Profiler tick count at which interrupts were last disabled */
+extern uint32_t profiler_irq_off_start_g;
+
+
+/**
+ *  Start the profiler's clock.
+ */
+extern void init_profiler(void);
+
+/**
+ *  Get the current value of the profiler's clock.
+ *
+ *  @return The current time in profiler ticks
+ */
+#if defined(SAMx5x)
+static inline uint32_t profiler_now(void)
+{
+    return DWT->CYCCNT;
+}
+#else
+extern uint32_t profiler_now(void);
+#endif
+
+/**
+ *  Add a value to a histogram.
+ *
+ *  @param hist The histogram
+ *  @param value The value to be recorded
+ */
+extern void profiler_hist_record(struct profiler_hist_t *hist, uint32_t value);
+
+/**
+ *  Clear all of the values from a histogram.
+ *
+ *  @param hist The histogram
+ */
+extern void profiler_hist_clear(struct profiler_hist_t *hist);
+
+/**
+ *  Get the mean of the values recorded in a histogram.
+ *
+ *  @param hist The histogram
+ *
+ *  @return The mean value or 0 if no values have been recorded
+ */
+static inline uint32_t profiler_hist_mean(const struct profiler_hist_t *hist)
+{
+    return (hist->count == 0) ? 0 : (uint32_t)(hist->total / hist->count);
+}
+
+/**
+ *  Convert a time from profiler ticks to nanoseconds.
+ *
+ *  @param ticks Time in profiler ticks
+ *
+ *  @return Time in nanoseconds, saturated at UINT32_MAX
+ */
+extern uint32_t profiler_ticks_to_ns(uint32_t ticks);
+
+/**
+ *  Convert a time from CPU cycles to nanoseconds.
+ *
+ *  @param cycles Time in CPU cycles
+ *
+ *  @return Time in nanoseconds, saturated at UINT32_MAX
+ */
+extern uint32_t profiler_cycles_to_ns(uint32_t cycles);
+
+/**
+ *  Clear the interrupt latency and interrupts disabled histograms.
+ */
+extern void profiler_clear(void);
+
+struct logging_desc_t;
+
+/**
+ *  Write the interrupt latency, interrupts disabled, main loop and scheduler
+ *  task statistics to the log as a profile diagnostic block. Tasks which do
+ *  not fit in a single logging buffer are left out.
+ *
+ *  @param logging Logging service instance descriptor
+ *
+ *  @return 0 if successful
+ */
+extern int profiler_log(struct logging_desc_t *logging);
+
+/**
+ *  Record the interrupt entry latency for the SysTick interrupt. Must be the
+ *  first thing done in the SysTick handler.
+ */
+static inline void profiler_systick_entry(void)
+{
+#ifdef ENABLE_PROFILER
+    profiler_hist_record(&profiler_isr_latency_g,
+                         SysTick->LOAD - SysTick->VAL);
+#endif
+}
+
+/**
+ *  Disable interrupts, recording when they were disabled if the profiler is
+ *  enabled.
+ */
+static inline void profiler_disable_irq(void)
+{
+#ifdef ENABLE_PROFILER
+    uint32_t const was_masked = __get_PRIMASK();
+    __disable_irq();
+    if (!was_masked) {
+        profiler_irq_off_start_g = profiler_now();
+    }
+#else
+    __disable_irq();
+#endif
+}
+
+/**
+ *  Enable interrupts, recording how long they were disabled for if the
+ *  profiler is enabled.
+ */
+static inline void profiler_enable_irq(void)
+{
+#ifdef ENABLE_PROFILER
+    profiler_hist_record(&profiler_irq_off_g,
+                         profiler_now() - profiler_irq_off_start_g);
+#endif
+    __enable_irq();
+}
+
+#endif /* profiler_h */
@@ -11,10 +11,32 @@
 
 #include "lora-config.h"
 
+#include <string.h>
+
 #define AVG_RX_LOSS_FALL_FACTOR  3
 #define AVG_RX_LOSS_RISE_FACTOR  2
 #define AVG_TX_LOSS_FALL_FACTOR  2
 #define AVG_TX_LOSS_RISE_FACTOR  2
+#define AVG_RSSI_FACTOR          3
+
+/** Time between probes of alternate antennas */
+#define ANTMGR_PROBE_PERIOD     MS_TO_MILLIS(2000)
+/** Longest time to wait for packets on an antenna being probed */
+#define ANTMGR_PROBE_TIMEOUT    MS_TO_MILLIS(1000)
+/** Number of packets to receive on an antenna being probed */
+#define ANTMGR_PROBE_PACKETS    2
+/** Time after a packet has been received during which the other device is
+    not expected to be transmitting, so the antenna can be switched without
+    losing a packet */
+#define ANTMGR_IDLE_WINDOW      MS_TO_MILLIS(20)
+/** Time without receiving anything after which antennas are probed whether or
+    not we are in an idle window */
+#define ANTMGR_SILENCE_TIMEOUT  MS_TO_MILLIS(3000)
+/** Time after which an antenna's average RSSI is no longer trusted */
+#define ANTMGR_STALE_TIME       MS_TO_MILLIS(10000)
+/** Difference in dB by which another antenna's average RSSI must exceed that
+    of the best antenna for it to become the best antenna */
+#define ANTMGR_SWITCH_MARGIN    3
 
 static enum sky13414_state ant_num_to_sky13414_state (unsigned int antenna);
 
@@ -24,6 +46,7 @@ void init_radio_antmgr(struct radio_instance_desc *inst,
 {
     // Store antenna manager data
     inst->antmgr = info->antmgr;
+    memset(inst->antmgr, 0, sizeof(*inst->antmgr));
     inst->antmgr->antenna_mask = info->antenna_mask;
 
     // Initialize antenna switch driver
@@ -32,12 +55,150 @@ void init_radio_antmgr(struct radio_instance_desc *inst,
 
     // Select first enabled antenna
     int ant = __builtin_ffs(inst->antmgr->antenna_mask);
+    inst->antmgr->best_antenna = ant;
+    inst->antmgr->tx_antenna = ant;
+    inst->antmgr->probe_antenna = ant;
     sky13414_set(&inst->antmgr->antenna_switch, ant_num_to_sky13414_state(ant));
 }
 
+/**
+ *  Get the count of samples for an antenna from a set of packed 2 bit counts.
+ */
+static inline uint8_t get_count(uint8_t counts, uint8_t antenna_num)
+{
+    return (counts >> (2 * (antenna_num - 1))) & 0x3;
+}
+
+/**
+ *  Update the count of samples for an antenna in a set of packed 2 bit counts.
+ */
+static inline void set_count(uint8_t *counts, uint8_t antenna_num,
+                             uint8_t count)
+{
+    *counts &= ~(0x3 << (2 * (antenna_num - 1)));
+    *counts |= (count << (2 * (antenna_num - 1)));
+}
+
+/**
+ *  Connect the radio to an antenna.
+ */
+static void select_antenna(struct radio_instance_desc *inst,
+                           uint8_t antenna_num)
+{
+    if (radio_antmgr_get_current_antenna(inst) != antenna_num) {
+        sky13414_set(&inst->antmgr->antenna_switch,
+                     ant_num_to_sky13414_state(antenna_num));
+    }
+}
+
+/**
+ *  Determine whether an antenna's average RSSI can be compared against other
+ *  antennas.
+ */
+static int antenna_is_fresh(const struct radio_antmgr_desc *antmgr,
+                            uint8_t antenna_num)
+{
+    return ((get_count(antmgr->rssi_counts, antenna_num) != 0) &&
+            ((millis - antmgr->last_rx_time[antenna_num - 1]) <
+             ANTMGR_STALE_TIME));
+}
+
+/**
+ *  Finish probing an alternate antenna. The probed antenna becomes the best
+ *  antenna if it has done consistently better than the current best antenna,
+ *  the radio is then switched back to whichever antenna is best.
+ */
+static void end_probe(struct radio_instance_desc *inst)
+{
+    struct radio_antmgr_desc *const antmgr = inst->antmgr;
+    const uint8_t probed = antmgr->probe_antenna;
+    const uint8_t best = antmgr->best_antenna;
+
+    // The probed antenna needs a full average, a single good packet is not
+    // enough to switch
+    const int probed_ok = (antenna_is_fresh(antmgr, probed) &&
+                           (get_count(antmgr->rssi_counts, probed) >=
+                            AVG_RSSI_FACTOR));
+    if (probed_ok && (!antenna_is_fresh(antmgr, best) ||
+                      (antmgr->avg_rssi[probed - 1] >=
+                       (antmgr->avg_rssi[best - 1] + ANTMGR_SWITCH_MARGIN)))) {
+        antmgr->best_antenna = probed;
+        antmgr->num_switches++;
+    }
+
+    antmgr->probing = 0;
+    antmgr->probe_time = millis;
+    select_antenna(inst, antmgr->best_antenna);
+}
+
+/**
+ *  Start listening on the next enabled antenna other than the best one.
+ *
+ *  @return 0 if there is no other antenna to probe
+ */
+static int start_probe(struct radio_instance_desc *inst)
+{
+    struct radio_antmgr_desc *const antmgr = inst->antmgr;
+
+    uint8_t next = antmgr->probe_antenna;
+    for (uint8_t i = 0; i < RADIO_MAX_NUM_ANTENNAS; i++) {
+        next = (next % RADIO_MAX_NUM_ANTENNAS) + 1;
+        if ((next != antmgr->best_antenna) &&
+                (antmgr->antenna_mask & (1 << (next - 1)))) {
+            antmgr->probe_antenna = next;
+            antmgr->probe_packets = 0;
+            antmgr->probing = 1;
+            antmgr->probe_time = millis;
+            antmgr->num_probes++;
+            select_antenna(inst, next);
+            return 1;
+        }
+    }
+    return 0;
+}
+
 void radio_antmgr_service(struct radio_instance_desc *inst)
 {
+    struct radio_antmgr_desc *const antmgr = inst->antmgr;
+
+    if (antmgr->probing) {
+        if ((antmgr->probe_packets >= ANTMGR_PROBE_PACKETS) ||
+                ((millis - antmgr->probe_time) >= ANTMGR_PROBE_TIMEOUT)) {
+            end_probe(inst);
+        }
+        return;
+    }
+
+    if (((millis - antmgr->probe_time) < ANTMGR_PROBE_PERIOD) ||
+            (inst->rn2483.send_buffer != NULL)) {
+        // Not time to probe yet, or we are about to transmit on the best
+        // antenna
+        return;
+    }
+
+    // Only switch antennas when doing so is unlikely to cut off a packet that
+    // is being received. Right after a packet has been received the other
+    // device has just finished transmitting. If nothing has been received in
+    // a long time there is nothing to lose.
+    const uint32_t since_rx = millis - antmgr->last_any_rx_time;
+    if ((since_rx <= ANTMGR_IDLE_WINDOW) ||
+            (since_rx >= ANTMGR_SILENCE_TIMEOUT)) {
+        start_probe(inst);
+    }
+}
+
+void radio_antmgr_prepare_tx(struct radio_instance_desc *inst)
+{
+    struct radio_antmgr_desc *const antmgr = inst->antmgr;
+
+    if (antmgr->probing) {
+        end_probe(inst);
+    }
 
+    // Antennas are assumed to be reciprocal, so we transmit on the antenna
+    // that receives best
+    antmgr->tx_antenna = antmgr->best_antenna;
+    select_antenna(inst, antmgr->tx_antenna);
 }
 
 void radio_antmgr_set_fixed(struct radio_instance_desc *inst,
@@ -72,30 +233,63 @@ uint8_t radio_antmgr_get_current_antenna(const struct radio_instance_desc *inst)
     }
 }
 
+uint8_t radio_antmgr_get_tx_antenna(const struct radio_instance_desc *inst)
+{
+    if (inst->antmgr == NULL) {
+        return 0;
+    }
+    return inst->antmgr->tx_antenna;
+}
+
 void radio_antmgr_metadata_cb(struct radio_transport_desc *transport,
                               struct radio_instance_desc *radio,
                               uint8_t antenna_num, int8_t snr, int8_t rssi)
 {
+    struct radio_antmgr_desc *const antmgr = radio->antmgr;
+
+    if ((antenna_num == 0) || (antenna_num > RADIO_MAX_NUM_ANTENNAS)) {
+        return;
+    }
 
+    // The transmit power of the other device does not change from packet to
+    // packet, so a difference in RSSI between antennas is a difference in
+    // loss
+    uint8_t count = get_count(antmgr->rssi_counts, antenna_num);
+    count = update_moving_average(&antmgr->avg_rssi[antenna_num - 1], rssi,
+                                  count, AVG_RSSI_FACTOR);
+    set_count(&antmgr->rssi_counts, antenna_num, count);
+
+    if (antmgr->rx_packets[antenna_num - 1] != UINT16_MAX) {
+        antmgr->rx_packets[antenna_num - 1]++;
+    }
+    antmgr->last_rx_time[antenna_num - 1] = millis;
+    antmgr->last_any_rx_time = millis;
+
+    if (antmgr->probing && (antenna_num == antmgr->probe_antenna) &&
+            (antmgr->probe_packets < ANTMGR_PROBE_PACKETS)) {
+        antmgr->probe_packets++;
+    }
 }
 
 void radio_antmgr_rx_loss_cb(struct radio_transport_desc *transport,
                              struct radio_instance_desc *radio,
                              uint8_t antenna_num, int8_t rx_loss)
 {
+    if ((antenna_num == 0) || (antenna_num > RADIO_MAX_NUM_ANTENNAS)) {
+        return;
+    }
     // Get point to value to be updated
-    int8_t *const avg = &radio->antmgr->avg_rx_power_loss[antenna_num];
+    int8_t *const avg = &radio->antmgr->avg_rx_power_loss[antenna_num - 1];
     // Get current count of rx power loss data points
-    uint8_t count = ((radio->antmgr->rx_power_loss_counts >>
-                      (2 * antenna_num)) & 0x3);
+    uint8_t count = get_count(radio->antmgr->rx_power_loss_counts,
+                              antenna_num);
     // Determine window size
     const uint8_t factor = ((rx_loss > *avg) ?
                             AVG_RX_LOSS_RISE_FACTOR : AVG_RX_LOSS_FALL_FACTOR);
     // Update the average
     count = update_moving_average(avg, rx_loss, count, factor);
     // Update the count of rx power loss data points
-    radio->antmgr->rx_power_loss_counts &= ~(0x3 << (2 * antenna_num));
-    radio->antmgr->rx_power_loss_counts |= (count << (2 * antenna_num));
+    set_count(&radio->antmgr->rx_power_loss_counts, antenna_num, count);
 }
 
 void radio_antmgr_tx_loss_cb(struct radio_transport_desc *transport,
@@ -103,19 +297,21 @@ void radio_antmgr_tx_loss_cb(struct radio_transport_desc *transport,
                              uint8_t antenna_num, int8_t tx_loss,
                              int8_t remote_snr)
 {
+    if ((antenna_num == 0) || (antenna_num > RADIO_MAX_NUM_ANTENNAS)) {
+        return;
+    }
     // Get point to value to be updated
-    int8_t *const avg = &tx_radio->antmgr->avg_tx_power_loss[antenna_num];
+    int8_t *const avg = &tx_radio->antmgr->avg_tx_power_loss[antenna_num - 1];
     // Get current count of tx power loss data points
-    uint8_t count = ((tx_radio->antmgr->tx_power_loss_counts >>
-                      (2 * antenna_num)) & 0x3);
+    uint8_t count = get_count(tx_radio->antmgr->tx_power_loss_counts,
+                              antenna_num);
     // Determine window size
     const uint8_t factor = ((tx_loss > *avg) ?
-                            AVG_RX_LOSS_RISE_FACTOR : AVG_RX_LOSS_FALL_FACTOR);
+                            AVG_TX_LOSS_RISE_FACTOR : AVG_TX_LOSS_FALL_FACTOR);
     // Update the average
     count = update_moving_average(avg, tx_loss, count, factor);
-    // Update the count of rx power loss data points
-    tx_radio->antmgr->tx_power_loss_counts &= ~(0x3 << (2 * antenna_num));
-    tx_radio->antmgr->tx_power_loss_counts |= (count << (2 * antenna_num));
+    // Update the count of tx power loss data points
+    set_count(&tx_radio->antmgr->tx_power_loss_counts, antenna_num, count);
 }
 
 static enum sky13414_state ant_num_to_sky13414_state (unsigned int antenna)
@@ -23,14 +23,51 @@
 extern void init_radio_antmgr(struct radio_instance_desc *inst,
                               const struct radio_antenna_info *info);
 
+/**
+ *  Service to be run in each iteration of the main loop. Probes alternate
+ *  antennas at times when no packet is expected to be arriving and switches to
+ *  an antenna that consistently receives packets with a higher RSSI than the
+ *  antenna in use.
+ *
+ *  @param inst The radio instance
+ */
 extern void radio_antmgr_service(struct radio_instance_desc *inst);
 
+/**
+ *  Select the antenna to be used for a transmission. Must be called before
+ *  each transmission is started so that a probe of an alternate antenna does
+ *  not end up being used to transmit.
+ *
+ *  @param inst The radio instance which is about to transmit
+ */
+extern void radio_antmgr_prepare_tx(struct radio_instance_desc *inst);
+
 extern void radio_antmgr_set_fixed(struct radio_instance_desc *inst,
                                    const struct radio_antenna_info *info);
 
 extern uint8_t radio_antmgr_get_current_antenna(
                                         const struct radio_instance_desc *inst);
 
+/**
+ *  Get the antenna that was used for the most recent transmission.
+ *
+ *  @param inst The radio instance
+ *
+ *  @return The number of the antenna or zero if the radio does not have an
+ *          antenna manager
+ */
+extern uint8_t radio_antmgr_get_tx_antenna(
+                                        const struct radio_instance_desc *inst);
+
+/**
+ *  Callback for when a packet is received.
+ *
+ *  @param transport The radio transport instance
+ *  @param radio The radio instance on which the packet was received
+ *  @param antenna_num Number of the antenna on which the packet was received
+ *  @param snr The signal to noise ratio of the packet
+ *  @param rssi The received signal strength of the packet
+ */
 extern void radio_antmgr_metadata_cb(struct radio_transport_desc *transport,
                                      struct radio_instance_desc *radio,
                                      uint8_t antenna_num, int8_t snr,
@@ -15,29 +15,331 @@
 
 #include "lora-config.h"
 
+#include <string.h>
+
 #define AVG_RX_LOSS_FALL_FACTOR  6
 #define AVG_RX_LOSS_RISE_FACTOR  2
 #define AVG_TX_LOSS_FALL_FACTOR  4
 #define AVG_TX_LOSS_RISE_FACTOR  2
+#define AVG_LINK_SNR_FACTOR      4
+
+/**
+ *  Spreading factor, coding rate and bandwidth used for a link profile.
+ */
+struct radio_link_profile {
+    enum rn2483_sf spreading_factor:3;
+    enum rn2483_cr coding_rate:2;
+    enum rn2483_bw bandwidth:2;
+};
+
+/** Link profiles ordered from the fastest to the most robust. The last profile
+    uses the search mode settings and is fallen back to when the link is
+    lost. Both ends of the link must have the same list. */
+static const struct radio_link_profile radio_link_profiles[] = {
+    { .spreading_factor = RN2483_SF_SF7, .coding_rate = RN2483_CR_4_5,
+      .bandwidth = RN2483_BW_500 },
+    { .spreading_factor = RN2483_SF_SF8, .coding_rate = RN2483_CR_4_5,
+      .bandwidth = RN2483_BW_500 },
+    { .spreading_factor = LORA_SPREADING_FACTOR,
+      .coding_rate = LORA_CODING_RATE, .bandwidth = LORA_BANDWIDTH },
+    { .spreading_factor = RN2483_SF_SF9, .coding_rate = RN2483_CR_4_7,
+      .bandwidth = RN2483_BW_250 },
+    { .spreading_factor = LORA_SEARCH_SPREADING_FACTOR,
+      .coding_rate = LORA_SEARCH_CODING_RATE,
+      .bandwidth = LORA_SEARCH_BANDWIDTH }
+};
+
+#define RADIO_LINK_NUM_PROFILES (sizeof(radio_link_profiles) / \
+                                 sizeof(radio_link_profiles[0]))
+#define RADIO_LINK_FALLBACK_PROFILE (RADIO_LINK_NUM_PROFILES - 1)
+
+_Static_assert(LORA_LINK_INITIAL_PROFILE < RADIO_LINK_NUM_PROFILES,
+               "Initial link profile does not exist.");
+_Static_assert((LORA_NUM_CHANNELS >= 1) &&
+               (LORA_NUM_CHANNELS <= RADIO_MAX_NUM_RADIOS),
+               "Number of LoRa channels must be from 1 to 4.");
+_Static_assert((LORA_FREQ + ((LORA_NUM_CHANNELS - 1) *
+                             LORA_CHANNEL_SPACING)) <= 434790000,
+               "LoRa channels extend past the end of the band.");
+
+/** Lowest SNR in dB at which packets can be demodulated for each spreading
+    factor, rounded up */
+static const int8_t radio_link_min_snr[] = { -7, -10, -12, -15, -17, -20 };
+/** Noise power in dB for each bandwidth relative to 125 kHz */
+static const int8_t radio_link_bw_noise[] = { 0, 3, 6 };
 
 
 void init_radio_chanmgr(struct radio_transport_desc *inst)
 {
+    const struct radio_link_profile *const profile =
+                                &radio_link_profiles[LORA_LINK_INITIAL_PROFILE];
+
     // Load initial lora settings
     rn2483_settings_set_freq(&inst->radio_settings, LORA_FREQ);
     rn2483_settings_set_rf(&inst->radio_settings, LORA_POWER,
-                           LORA_SPREADING_FACTOR, LORA_CODING_RATE,
-                           LORA_BANDWIDTH);
+                           profile->spreading_factor, profile->coding_rate,
+                           profile->bandwidth);
     rn2483_settings_set_sync(&inst->radio_settings, LORA_CRC, LORA_INVERT_IQ,
                              LORA_SYNC_WORD, LORA_PRLEN);
+
+    memset(&inst->link, 0, sizeof(inst->link));
+    inst->link.profile = LORA_LINK_INITIAL_PROFILE;
+}
+
+void radio_chanmgr_init_radio(struct radio_transport_desc *inst,
+                              struct radio_instance_desc *radio,
+                              uint8_t channel)
+{
+    radio->settings = inst->radio_settings;
+    rn2483_settings_set_freq(&radio->settings,
+                             LORA_FREQ + (channel * LORA_CHANNEL_SPACING));
+    radio->channel = channel;
+    radio->tx_busy = 0;
+    radio->last_tx_time = 0;
+}
+
+// MARK: Link Control
+
+/**
+ *  Determine whether this device decides when the link profile changes.
+ */
+static inline int link_is_leader(const struct radio_transport_desc *inst)
+{
+    return inst->address == RADIO_DEVICE_ADDRESS_GROUND_STATION;
+}
+
+/**
+ *  Calculate the link margin that a link profile would have.
+ *
+ *  @param profile The profile for which the margin should be found
+ *  @param measured_profile The profile with which the SNR was measured
+ *  @param snr The measured SNR
+ *
+ *  @return The number of dB by which the SNR would exceed the lowest SNR at
+ *          which the profile can be received
+ */
+static int16_t link_margin(uint8_t profile, uint8_t measured_profile,
+                           int8_t snr)
+{
+    const struct radio_link_profile *const p = &radio_link_profiles[profile];
+    const struct radio_link_profile *const m =
+                                        &radio_link_profiles[measured_profile];
+    // Noise power scales with bandwidth, so the SNR at a narrower bandwidth is
+    // higher by the ratio of the bandwidths
+    return ((int16_t)snr + radio_link_bw_noise[m->bandwidth] -
+            radio_link_bw_noise[p->bandwidth] -
+            radio_link_min_snr[p->spreading_factor]);
+}
+
+/**
+ *  Start using a link profile.
+ *
+ *  @param inst The radio transport instance
+ *  @param profile The index of the profile to be used
+ */
+static void link_apply(struct radio_transport_desc *inst, uint8_t profile)
+{
+    struct radio_chanmgr_link *const link = &inst->link;
+    const struct radio_link_profile *const p = &radio_link_profiles[profile];
+
+    // Carry the SNR averages over to the new bandwidth
+    const int8_t bw_delta = (radio_link_bw_noise[
+                                        inst->radio_settings.bandwidth] -
+                             radio_link_bw_noise[p->bandwidth]);
+    link->avg_local_snr += bw_delta;
+    link->avg_remote_snr += bw_delta;
+
+    rn2483_settings_set_rf(&inst->radio_settings, inst->radio_settings.power,
+                           p->spreading_factor, p->coding_rate, p->bandwidth);
+    for (struct radio_instance_desc *const *radio_p = inst->radios;
+         *radio_p != NULL; radio_p++) {
+        rn2483_settings_set_rf(&(*radio_p)->settings,
+                               inst->radio_settings.power, p->spreading_factor,
+                               p->coding_rate, p->bandwidth);
+        rn2483_update_settings(&(*radio_p)->rn2483);
+    }
+
+    link->profile = profile;
+    link->pending = 0;
+    link->step_up_pending = 0;
+    // A signal report might have been missed because of the change
+    link->report_pending = 0;
+    link->change_time = millis;
+    link->num_changes++;
+}
+
+/**
+ *  Queue a link profile block.
+ *
+ *  @param inst The radio transport instance
+ *  @param dest The address of the device that the block is for
+ *  @param seq Sequence number of the profile change
+ *  @param profile Index of the requested profile
+ *  @param ack Whether the block acknowledges a request
+ */
+static void link_send(struct radio_transport_desc *inst,
+                      enum radio_packet_device_address dest, uint8_t seq,
+                      uint8_t profile, int ack)
+{
+    uint8_t block[RADIO_BLOCK_LINK_PROFILE_LENGTH];
+    radio_block_marshal_header(block, RADIO_BLOCK_LINK_PROFILE_LENGTH, 0, dest,
+                               RADIO_BLOCK_TYPE_CONTROL,
+                               RADIO_CONTROL_BLOCK_LINK_PROFILE);
+    radio_block_marshal_link_profile(block, seq, profile, ack);
+    radio_send_block(inst, block, RADIO_BLOCK_LINK_PROFILE_LENGTH, 0,
+                     LORA_LINK_REQUEST_PERIOD, RADIO_BLOCK_PRIORITY_HIGH);
+}
+
+/**
+ *  Start requesting that the other device change to a new link profile.
+ *
+ *  @param inst The radio transport instance
+ *  @param profile Index of the profile to change to
+ */
+static void link_request(struct radio_transport_desc *inst, uint8_t profile)
+{
+    struct radio_chanmgr_link *const link = &inst->link;
+
+    link->pending_profile = profile;
+    link->seq++;
+    link->tries = 0;
+    link->pending = 1;
+    // Send the first request right away
+    link->pending_time = millis - LORA_LINK_REQUEST_PERIOD;
+}
+
+/**
+ *  Decide whether the link profile should be changed based on the SNR
+ *  averages. A more robust profile is requested as soon as the margin is too
+ *  low, a faster profile is only requested once it would have had enough
+ *  margin for some time.
+ *
+ *  @param inst The radio transport instance
+ */
+static void link_evaluate(struct radio_transport_desc *inst)
+{
+    struct radio_chanmgr_link *const link = &inst->link;
+
+    if (link->pending || (link->local_snr_count == 0) ||
+            (link->remote_snr_count == 0)) {
+        return;
+    }
+
+    // The link is only as good as its worst direction
+    const int8_t snr = ((link->avg_local_snr < link->avg_remote_snr) ?
+                        link->avg_local_snr : link->avg_remote_snr);
+
+    if (link_margin(link->profile, link->profile, snr) <
+            LORA_LINK_MARGIN_LOW) {
+        // Step down to the fastest profile that has enough margin, skipping
+        // over profiles that would not
+        uint8_t next = link->profile + 1;
+        while ((next < RADIO_LINK_FALLBACK_PROFILE) &&
+               (link_margin(next, link->profile, snr) <
+                LORA_LINK_MARGIN_TARGET)) {
+            next++;
+        }
+        link->step_up_pending = 0;
+        if (next < RADIO_LINK_NUM_PROFILES) {
+            link_request(inst, next);
+        }
+        return;
+    }
+
+    if ((link->profile == 0) ||
+            (link_margin(link->profile - 1, link->profile, snr) <
+             LORA_LINK_MARGIN_HIGH)) {
+        link->step_up_pending = 0;
+        return;
+    }
+
+    if (!link->step_up_pending) {
+        link->step_up_pending = 1;
+        link->step_up_time = millis;
+    } else if (((millis - link->step_up_time) >= LORA_LINK_STEP_UP_HOLD) &&
+               ((millis - link->change_time) >= LORA_LINK_HOLDOFF)) {
+        link_request(inst, link->profile - 1);
+    }
 }
 
+/**
+ *  Handle a signal report request that was not answered. SNR averages only
+ *  include packets that were received, so they can not show a link that has
+ *  become too weak to carry most packets. Step down by one profile instead.
+ *
+ *  @param inst The radio transport instance
+ */
+static void link_report_missed(struct radio_transport_desc *inst)
+{
+    struct radio_chanmgr_link *const link = &inst->link;
+
+    link->step_up_pending = 0;
+    if (!link->pending && (link->profile < RADIO_LINK_FALLBACK_PROFILE)) {
+        link_request(inst, link->profile + 1);
+    }
+}
+
+/**
+ *  Run the link profile control.
+ *
+ *  @param inst The radio transport instance
+ */
+static void link_service(struct radio_transport_desc *inst)
+{
+    struct radio_chanmgr_link *const link = &inst->link;
+
+    // If we have not heard from the other device for too long the two ends of
+    // the link may no longer agree on the profile, fall back to the most
+    // robust one where they will find each other again
+    if ((link->profile != RADIO_LINK_FALLBACK_PROFILE) &&
+            ((millis - inst->last_rx_time) > LORA_LINK_LOSS_TIMEOUT)) {
+        link_apply(inst, RADIO_LINK_FALLBACK_PROFILE);
+        link->local_snr_count = 0;
+        link->remote_snr_count = 0;
+        return;
+    }
+
+    if (!link_is_leader(inst)) {
+        // Changes that we have acknowledged are applied once the packet
+        // carrying the acknowledgement has been sent
+        return;
+    }
+
+    if (link->new_sample) {
+        link->new_sample = 0;
+        link_evaluate(inst);
+    }
+
+    if (link->pending &&
+            ((millis - link->pending_time) >= LORA_LINK_REQUEST_PERIOD)) {
+        if (link->tries >= LORA_LINK_REQUEST_TRIES) {
+            // Give up, if the other device did switch profiles we will both
+            // end up falling back to the most robust profile
+            link->pending = 0;
+            return;
+        }
+        link_send(inst, RADIO_DEVICE_ADDRESS_MULTICAST, link->seq,
+                  link->pending_profile, 0);
+        link->tries++;
+        link->pending_time = millis;
+    }
+}
+
+// MARK: Service
+
 void radio_chanmgr_service(struct radio_transport_desc *inst)
 {
+    link_service(inst);
+
     // Periodically send a signal report request
     if ((millis - inst->last_sig_report_time) > RADIO_SIG_REPORT_PERIOD) {
         inst->last_sig_report_time = millis;
 
+        if (link_is_leader(inst) && inst->link.report_pending) {
+            link_report_missed(inst);
+        }
+        inst->link.report_pending = 1;
+
         // Find the best most recent snr and rssi from all of the attached
         // radios
         int8_t snr = INT8_MIN;
@@ -56,26 +358,83 @@ void radio_chanmgr_service(struct radio_transport_desc *inst)
                                    RADIO_BLOCK_TYPE_CONTROL,
                                    RADIO_CONTROL_BLOCK_SIGNAL_REPORT);
         radio_block_marshal_sig_report(report, snr, rssi, 0,
-                                       inst->radio_settings.power, 0);
+                                       inst->radio_settings.power, 1);
         radio_send_block(inst, report, RADIO_BLOCK_SIG_REPORT_LENGHT, 1000,
-                         RADIO_SIG_REPORT_PERIOD);
+                         RADIO_SIG_REPORT_PERIOD, RADIO_BLOCK_PRIORITY_NORMAL);
     }
 }
 
-struct radio_instance_desc *radio_chanmgr_get_tx_radio(
-                                            struct radio_transport_desc *inst)
+/**
+ *  Find the radio with the lowest TX loss that can send a packet on a channel
+ *  right now. Only radios which listen on the channel are considered unless
+ *  none do, in which case any radio may be tuned to the channel to send.
+ *
+ *  @param inst The radio transport instance
+ *  @param channel The channel on which the packet is to be sent
+ *
+ *  @return The radio to send on or NULL if no radio can send on the channel yet
+ */
+static struct radio_instance_desc *get_tx_radio_for(
+                                            struct radio_transport_desc *inst,
+                                            uint8_t channel)
 {
+    int any_radio = 1;
+    for (struct radio_instance_desc *const *radio_p = inst->radios;
+         *radio_p != NULL; radio_p++) {
+        if ((*radio_p)->channel == channel) {
+            any_radio = 0;
+            break;
+        }
+    }
+
     struct radio_instance_desc *radio = NULL;
-    int8_t tx_loss = INT8_MAX;
     for (struct radio_instance_desc *const *radio_p = inst->radios;
          *radio_p != NULL; radio_p++) {
-        if ((*radio_p)->avg_tx_power_loss <= tx_loss) {
+        if ((!any_radio && ((*radio_p)->channel != channel)) ||
+                (*radio_p)->tx_busy ||
+                ((millis - (*radio_p)->last_tx_time) <=
+                 RADIO_TX_BACKOFF_TIME)) {
+            continue;
+        }
+        if ((radio == NULL) ||
+                ((*radio_p)->avg_tx_power_loss < radio->avg_tx_power_loss)) {
             radio = (*radio_p);
         }
     }
     return radio;
 }
 
+struct radio_instance_desc *radio_chanmgr_get_tx_radio(
+                                            struct radio_transport_desc *inst,
+                                            uint8_t *channel)
+{
+    // The ground station always sends on channel 0, which is the channel that
+    // the rocket listens on between transmissions. The rocket spreads its
+    // transmissions over all of the channels, starting with the one after the
+    // last channel that was used and skipping channels with no free radio.
+    const uint8_t num_channels = (link_is_leader(inst) ? 1 :
+                                  LORA_NUM_CHANNELS);
+    for (uint8_t i = 0; i < num_channels; i++) {
+        const uint8_t c = (inst->tx_channel + i) % num_channels;
+        struct radio_instance_desc *const radio = get_tx_radio_for(inst, c);
+        if (radio != NULL) {
+            *channel = c;
+            return radio;
+        }
+    }
+    return NULL;
+}
+
+void radio_chanmgr_tune(struct radio_instance_desc *radio, uint8_t channel)
+{
+    const uint32_t freq = LORA_FREQ + (channel * LORA_CHANNEL_SPACING);
+    if (rn2483_settings_get_freq(&radio->settings) == freq) {
+        return;
+    }
+    rn2483_settings_set_freq(&radio->settings, freq);
+    rn2483_update_frequency_settings(&radio->rn2483);
+}
+
 
 void radio_chanmgr_metadata_cb(struct radio_transport_desc *transport,
                                struct radio_instance_desc *radio,
@@ -85,6 +444,12 @@ void radio_chanmgr_metadata_cb(struct radio_transport_desc *transport,
     // information about our rx link quality.
     radio->last_rx_snr = snr;
     radio->last_rx_rssi = rssi;
+
+    transport->link.local_snr_count = update_moving_average(
+                                            &transport->link.avg_local_snr, snr,
+                                            transport->link.local_snr_count,
+                                            AVG_LINK_SNR_FACTOR);
+    transport->link.new_sample = 1;
 }
 
 void radio_chanmgr_rx_loss_cb(struct radio_transport_desc *transport,
@@ -114,4 +479,96 @@ void radio_chanmgr_tx_loss_cb(struct radio_transport_desc *transport,
                                                 tx_radio->tx_power_loss_count,
                                                 factor);
     tx_radio->tx_power_loss_count = count;
+
+    // The SNR reported by the other device tells us how good the link is in
+    // the direction we transmit in
+    transport->link.report_pending = 0;
+    transport->link.remote_snr_count = update_moving_average(
+                                        &transport->link.avg_remote_snr,
+                                        remote_snr,
+                                        transport->link.remote_snr_count,
+                                        AVG_LINK_SNR_FACTOR);
+    transport->link.new_sample = 1;
+}
+
+void radio_chanmgr_link_profile_cb(struct radio_transport_desc *transport,
+                                   const uint8_t *block,
+                                   enum radio_packet_device_address source)
+{
+    struct radio_chanmgr_link *const link = &transport->link;
+    const uint8_t seq = radio_block_link_profile_seq(block);
+    const uint8_t profile = radio_block_link_profile_index(block);
+
+    if (profile >= RADIO_LINK_NUM_PROFILES) {
+        return;
+    }
+
+    if (link_is_leader(transport)) {
+        // The other device has agreed to the change we requested
+        if (radio_block_link_profile_ack(block) && link->pending &&
+                (seq == link->seq) && (profile == link->pending_profile)) {
+            link_apply(transport, profile);
+        }
+        return;
+    } else if (radio_block_link_profile_ack(block)) {
+        return;
+    }
+
+    // Acknowledge the request, this is also done for repeated requests in
+    // case our last acknowledgement was lost
+    link_send(transport, source, seq, profile, 1);
+
+    if ((profile != link->profile) &&
+            !(link->pending && (seq == link->seq))) {
+        // The acknowledgement has to go out with the old settings, so the
+        // change is not applied until it has been sent
+        link->pending_profile = profile;
+        link->seq = seq;
+        link->pending = 1;
+    }
+}
+
+void radio_chanmgr_tx_start_cb(struct radio_transport_desc *transport,
+                               struct radio_instance_desc *radio,
+                               const uint8_t *packet)
+{
+    const struct radio_chanmgr_link *const link = &transport->link;
+
+    radio->tx_link_ack = 0;
+    if (link_is_leader(transport) || !link->pending) {
+        return;
+    }
+
+    // Check whether the packet carries the acknowledgement for the change that
+    // we are waiting to apply, it might have been queued behind other packets
+    const uint8_t packet_length = radio_packet_length(packet);
+    for (uint8_t offset = RADIO_PACKET_HEADER_LENGTH; offset < packet_length;
+            offset += radio_block_length(packet + offset)) {
+        const uint8_t *const block = packet + offset;
+        if ((radio_block_type(block) == RADIO_BLOCK_TYPE_CONTROL) &&
+                (radio_block_subtype(block) ==
+                 RADIO_CONTROL_BLOCK_LINK_PROFILE) &&
+                radio_block_link_profile_ack(block) &&
+                (radio_block_link_profile_seq(block) == link->seq) &&
+                (radio_block_link_profile_index(block) ==
+                 link->pending_profile)) {
+            radio->tx_link_ack = 1;
+            return;
+        }
+    }
+}
+
+void radio_chanmgr_tx_done_cb(struct radio_transport_desc *transport,
+                              struct radio_instance_desc *radio, int sent)
+{
+    if (!radio->tx_link_ack) {
+        return;
+    }
+    radio->tx_link_ack = 0;
+
+    // If the acknowledgement could not be sent the change is applied once the
+    // acknowledgement for a repeated request has been sent instead
+    if (sent && transport->link.pending) {
+        link_apply(transport, transport->link.pending_profile);
+    }
 }
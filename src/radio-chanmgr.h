@@ -31,14 +31,41 @@ extern void init_radio_chanmgr(struct radio_transport_desc *inst);
 extern void radio_chanmgr_service(struct radio_transport_desc *inst);
 
 /**
- *  Get the best radio to transmit on.
+ *  Initialize the channel manager state for a radio. Must be called after the
+ *  channel manager has been initialized and before the radio's driver is
+ *  initialized.
  *
  *  @param inst The radio transport instance
+ *  @param radio The radio instance
+ *  @param channel The channel that the radio should listen on
+ */
+extern void radio_chanmgr_init_radio(struct radio_transport_desc *inst,
+                                     struct radio_instance_desc *radio,
+                                     uint8_t channel);
+
+/**
+ *  Get the best radio and channel to transmit on next. Radios which are still
+ *  sending a packet or which have sent a packet within the transmit backoff
+ *  time are not considered.
  *
- *  @return RN2483 driver descriptor for best transmit radio
+ *  @param inst The radio transport instance
+ *  @param channel Pointer to where the channel to transmit on will be stored
+ *
+ *  @return Best transmit radio or NULL if no radio is ready to transmit
  */
 extern struct radio_instance_desc *radio_chanmgr_get_tx_radio(
-                                            struct radio_transport_desc *inst);
+                                            struct radio_transport_desc *inst,
+                                            uint8_t *channel);
+
+/**
+ *  Tune a radio to a channel. The new frequency is used for any transmission
+ *  or reception started after this function is called.
+ *
+ *  @param radio The radio instance
+ *  @param channel The channel to tune to
+ */
+extern void radio_chanmgr_tune(struct radio_instance_desc *radio,
+                               uint8_t channel);
 
 /**
  *  Function called whenever a packet is received.
@@ -86,5 +113,39 @@ extern void radio_chanmgr_tx_loss_cb(struct radio_transport_desc *transport,
                                      uint8_t antenna_num, int8_t tx_loss,
                                      int8_t remote_snr);
 
+/**
+ *  Callback for when a link profile control block is received.
+ *
+ *  @param transport The radio transport instance
+ *  @param block The link profile block
+ *  @param source The address of the device that sent the block
+ */
+extern void radio_chanmgr_link_profile_cb(
+                                    struct radio_transport_desc *transport,
+                                    const uint8_t *block,
+                                    enum radio_packet_device_address source);
+
+/**
+ *  Function called whenever a packet transmission is started.
+ *
+ *  @param transport The radio transport instance
+ *  @param radio The radio instance on which the packet is being sent
+ *  @param packet The packet being sent
+ */
+extern void radio_chanmgr_tx_start_cb(struct radio_transport_desc *transport,
+                                      struct radio_instance_desc *radio,
+                                      const uint8_t *packet);
+
+/**
+ *  Function called whenever a packet transmission is complete.
+ *
+ *  @param transport The radio transport instance
+ *  @param radio The radio instance on which the packet was sent
+ *  @param sent Non-zero if the packet was sent successfully
+ */
+extern void radio_chanmgr_tx_done_cb(struct radio_transport_desc *transport,
+                                     struct radio_instance_desc *radio,
+                                     int sent);
+
 
 #endif /* radio_chanmgr_h */
@@ -115,4 +115,247 @@ static inline void radio_block_sig_report_set_tx_radio(uint8_t *block,
     block[RADIO_BLOCK_HEADER_LENGTH + 2] |= tx_radio_num & 0x3;
 }
 
+// MARK: Link Profile
+
+#define RADIO_BLOCK_LINK_PROFILE_LENGTH (RADIO_BLOCK_HEADER_LENGTH + 4)
+
+/**
+ *  Get the sequence number from a link profile block.
+ *
+ *  @param block Pointer to the link profile block to be parsed
+ *
+ *  @return The sequence number from the link profile block
+ */
+__attribute__((const))
+static inline uint8_t radio_block_link_profile_seq(const uint8_t *block)
+{
+    return block[RADIO_BLOCK_HEADER_LENGTH + 0];
+}
+
+/**
+ *  Get the index of the requested profile from a link profile block.
+ *
+ *  @param block Pointer to the link profile block to be parsed
+ *
+ *  @return The profile index from the link profile block
+ */
+__attribute__((const))
+static inline uint8_t radio_block_link_profile_index(const uint8_t *block)
+{
+    return block[RADIO_BLOCK_HEADER_LENGTH + 1];
+}
+
+/**
+ *  Get whether a link profile block is an acknowledgement of a request.
+ *
+ *  @param block Pointer to the link profile block to be parsed
+ *
+ *  @return A non-zero value if the block is an acknowledgement, zero if it is
+ *          a request
+ */
+__attribute__((const))
+static inline int radio_block_link_profile_ack(const uint8_t *block)
+{
+    return block[RADIO_BLOCK_HEADER_LENGTH + 2] & 0x80;
+}
+
+/**
+ *  Marshal the payload of a link profile block.
+ *
+ *  @param block Pointer to the block for which the payload should be created
+ *  @param seq Sequence number of the profile change
+ *  @param index Index of the requested link profile
+ *  @param ack Whether the block acknowledges a request
+ */
+static inline void radio_block_marshal_link_profile(uint8_t *block,
+                                                    uint8_t seq, uint8_t index,
+                                                    int ack)
+{
+    block[RADIO_BLOCK_HEADER_LENGTH + 0] = seq;
+    block[RADIO_BLOCK_HEADER_LENGTH + 1] = index;
+    block[RADIO_BLOCK_HEADER_LENGTH + 2] = ack ? 0x80 : 0;
+    block[RADIO_BLOCK_HEADER_LENGTH + 3] = 0;
+}
+
+// MARK: Erasure Coding Configuration
+
+#define RADIO_BLOCK_FEC_CONFIG_LENGTH (RADIO_BLOCK_HEADER_LENGTH + 4)
+
+/**
+ *  Get the sequence number from an erasure coding configuration block.
+ *
+ *  @param block Pointer to the erasure coding configuration block to be parsed
+ *
+ *  @return The sequence number from the erasure coding configuration block
+ */
+__attribute__((const))
+static inline uint8_t radio_block_fec_config_seq(const uint8_t *block)
+{
+    return block[RADIO_BLOCK_HEADER_LENGTH + 0];
+}
+
+/**
+ *  Get the number of data packets in each group from an erasure coding
+ *  configuration block.
+ *
+ *  @param block Pointer to the erasure coding configuration block to be parsed
+ *
+ *  @return The number of data packets in each group
+ */
+__attribute__((const))
+static inline uint8_t radio_block_fec_config_data_packets(const uint8_t *block)
+{
+    return block[RADIO_BLOCK_HEADER_LENGTH + 1];
+}
+
+/**
+ *  Get the number of parity packets sent after each group from an erasure
+ *  coding configuration block.
+ *
+ *  @param block Pointer to the erasure coding configuration block to be parsed
+ *
+ *  @return The number of parity packets sent after each group
+ */
+__attribute__((const))
+static inline uint8_t radio_block_fec_config_parity_packets(
+                                                        const uint8_t *block)
+{
+    return block[RADIO_BLOCK_HEADER_LENGTH + 2];
+}
+
+/**
+ *  Get whether an erasure coding configuration block is an acknowledgement of
+ *  a request.
+ *
+ *  @param block Pointer to the erasure coding configuration block to be parsed
+ *
+ *  @return A non-zero value if the block is an acknowledgement, zero if it is
+ *          a request
+ */
+__attribute__((const))
+static inline int radio_block_fec_config_ack(const uint8_t *block)
+{
+    return block[RADIO_BLOCK_HEADER_LENGTH + 3] & 0x80;
+}
+
+/**
+ *  Marshal the payload of an erasure coding configuration block.
+ *
+ *  @param block Pointer to the block for which the payload should be created
+ *  @param seq Sequence number of the configuration change
+ *  @param data_packets Number of data packets in each group
+ *  @param parity_packets Number of parity packets sent after each group
+ *  @param ack Whether the block acknowledges a request
+ */
+static inline void radio_block_marshal_fec_config(uint8_t *block, uint8_t seq,
+                                                  uint8_t data_packets,
+                                                  uint8_t parity_packets,
+                                                  int ack)
+{
+    block[RADIO_BLOCK_HEADER_LENGTH + 0] = seq;
+    block[RADIO_BLOCK_HEADER_LENGTH + 1] = data_packets;
+    block[RADIO_BLOCK_HEADER_LENGTH + 2] = parity_packets;
+    block[RADIO_BLOCK_HEADER_LENGTH + 3] = ack ? 0x80 : 0;
+}
+
+// MARK: Erasure Coding Parity
+
+/** Length of the parity block payload which comes before the parity symbol */
+#define RADIO_BLOCK_FEC_PARITY_HEADER_LENGTH    4
+
+/**
+ *  Get the packet number of the first packet in the group which a parity block
+ *  protects.
+ *
+ *  @param block Pointer to the parity block to be parsed
+ *
+ *  @return The number of the first packet in the group
+ */
+__attribute__((const))
+static inline uint16_t radio_block_fec_parity_first(const uint8_t *block)
+{
+    return (block[RADIO_BLOCK_HEADER_LENGTH + 0] |
+            ((uint16_t)(block[RADIO_BLOCK_HEADER_LENGTH + 1] & 0xf) << 8));
+}
+
+/**
+ *  Get the number of data packets in the group which a parity block protects.
+ *
+ *  @param block Pointer to the parity block to be parsed
+ *
+ *  @return The number of data packets in the group
+ */
+__attribute__((const))
+static inline uint8_t radio_block_fec_parity_data_packets(const uint8_t *block)
+{
+    return block[RADIO_BLOCK_HEADER_LENGTH + 1] >> 4;
+}
+
+/**
+ *  Get the index of the parity symbol within its group from a parity block.
+ *
+ *  @param block Pointer to the parity block to be parsed
+ *
+ *  @return The index of the parity symbol
+ */
+__attribute__((const))
+static inline uint8_t radio_block_fec_parity_index(const uint8_t *block)
+{
+    return block[RADIO_BLOCK_HEADER_LENGTH + 2] & 0xf;
+}
+
+/**
+ *  Get the number of parity packets sent for the group which a parity block
+ *  protects.
+ *
+ *  @param block Pointer to the parity block to be parsed
+ *
+ *  @return The number of parity packets in the group
+ */
+__attribute__((const))
+static inline uint8_t radio_block_fec_parity_parity_packets(
+                                                        const uint8_t *block)
+{
+    return block[RADIO_BLOCK_HEADER_LENGTH + 2] >> 4;
+}
+
+/**
+ *  Get a pointer to the parity symbol in a parity block.
+ *
+ *  @param block Pointer to the parity block to be parsed
+ *
+ *  @return Pointer to the parity symbol
+ */
+__attribute__((const))
+static inline const uint8_t *radio_block_fec_parity_symbol(
+                                                        const uint8_t *block)
+{
+    return block + RADIO_BLOCK_HEADER_LENGTH +
+                RADIO_BLOCK_FEC_PARITY_HEADER_LENGTH;
+}
+
+/**
+ *  Marshal the payload header of a parity block. The parity symbol follows the
+ *  payload header.
+ *
+ *  @param block Pointer to the block for which the payload should be created
+ *  @param first Packet number of the first packet in the group
+ *  @param data_packets Number of data packets in the group
+ *  @param index Index of the parity symbol within the group
+ *  @param parity_packets Number of parity packets sent for the group
+ */
+static inline void radio_block_marshal_fec_parity(uint8_t *block,
+                                                  uint16_t first,
+                                                  uint8_t data_packets,
+                                                  uint8_t index,
+                                                  uint8_t parity_packets)
+{
+    block[RADIO_BLOCK_HEADER_LENGTH + 0] = first & 0xff;
+    block[RADIO_BLOCK_HEADER_LENGTH + 1] = (((first >> 8) & 0xf) |
+                                            (data_packets << 4));
+    block[RADIO_BLOCK_HEADER_LENGTH + 2] = ((index & 0xf) |
+                                            (parity_packets << 4));
+    block[RADIO_BLOCK_HEADER_LENGTH + 3] = 0;
+}
+
 #endif /* radio_control_block_layout_h */
@@ -0,0 +1,848 @@
+/**
+ * @file radio-fec.c
+ * @desc Packet level erasure coding for the radio transport. Parity packets
+ *       sent after each group of packets allow lost packets to be rebuilt.
+ * @author agent
+ * @date 2026-10-16
+ * Last Author:
+ * Last Edited On:
+ */
+
+#include "radio-fec.h"
+#include "radio-transport.h"
+#include "radio-packet-layout.h"
+#include "radio-control-block-layout.h"
+
+#include "lora-config.h"
+
+#include <string.h>
+
+/*
+ *  Each packet is coded as a symbol made up of the length of its payload
+ *  followed by the payload and enough zeros to pad the symbol to the length of
+ *  the longest symbol in its group. Parity symbols are linear combinations of
+ *  the data symbols in GF(2^8), so a parity symbol for a group of k data
+ *  symbols d_i is
+ *
+ *      p_j = c(j, 0) * d_0 + c(j, 1) * d_1 + ... + c(j, k - 1) * d_(k - 1)
+ *
+ *  The coefficients are a Cauchy matrix with each column scaled so that the
+ *  first row is all ones. Every square sub-matrix of the coefficient matrix is
+ *  invertible, so any e lost data symbols can be found from any e parity
+ *  symbols (this is a Reed-Solomon erasure code). With a single parity packet
+ *  the code is just the exclusive or of the data symbols.
+ */
+
+_Static_assert((RADIO_FEC_WINDOW & (RADIO_FEC_WINDOW - 1)) == 0,
+               "Erasure coding window must be a power of two.");
+_Static_assert(RADIO_FEC_WINDOW >= (RADIO_FEC_MAX_DATA_PACKETS +
+                                    RADIO_FEC_MAX_PARITY_PACKETS),
+               "Erasure coding window must be able to hold a whole group.");
+_Static_assert(((RADIO_FEC_MAX_PACKET_LENGTH - RADIO_PACKET_HEADER_LENGTH + 4) &
+                ~3) <= RADIO_FEC_MAX_SYMBOL_LENGTH,
+               "Longest symbol must fit the longest packet that is coded.");
+_Static_assert((RADIO_PACKET_HEADER_LENGTH + RADIO_BLOCK_HEADER_LENGTH +
+                RADIO_BLOCK_FEC_PARITY_HEADER_LENGTH +
+                RADIO_FEC_MAX_SYMBOL_LENGTH) < RADIO_MAX_PACKET_SIZE,
+               "Parity packets must fit in a single transmission.");
+_Static_assert((LORA_FEC_DATA_PACKETS >= 1) &&
+               (LORA_FEC_DATA_PACKETS <= RADIO_FEC_MAX_DATA_PACKETS),
+               "Invalid number of erasure coding data packets.");
+_Static_assert(LORA_FEC_PARITY_PACKETS <= RADIO_FEC_MAX_PARITY_PACKETS,
+               "Invalid number of erasure coding parity packets.");
+
+
+// MARK: GF(2^8)
+
+//  Exponent and logarithm tables for GF(2^8) with the polynomial
+//  x^8 + x^4 + x^3 + x^2 + 1 and generator 2. The exponent table is repeated
+//  so that the sum of two logarithms can be used as an index without reducing
+//  it modulo 255.
+//  #! /usr/bin/env python3
+//  exp, log, x = [], [0] * 256, 1
+//  for i in range(255):
+//      exp.append(x)
+//      log[x] = i
+//      x = (x << 1) ^ (0x11d if x & 0x80 else 0)
+//  for t in (exp + exp, log):
+//      for i in range(0, len(t), 12):
+//          print(', '.join('0x{:02x}'.format(v) for v in t[i:i+12]))
+static const uint8_t gf_exp[510] = {
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1d, 0x3a, 0x74, 0xe8,
+    0xcd, 0x87, 0x13, 0x26, 0x4c, 0x98, 0x2d, 0x5a, 0xb4, 0x75, 0xea, 0xc9,
+    0x8f, 0x03, 0x06, 0x0c, 0x18, 0x30, 0x60, 0xc0, 0x9d, 0x27, 0x4e, 0x9c,
+    0x25, 0x4a, 0x94, 0x35, 0x6a, 0xd4, 0xb5, 0x77, 0xee, 0xc1, 0x9f, 0x23,
+    0x46, 0x8c, 0x05, 0x0a, 0x14, 0x28, 0x50, 0xa0, 0x5d, 0xba, 0x69, 0xd2,
+    0xb9, 0x6f, 0xde, 0xa1, 0x5f, 0xbe, 0x61, 0xc2, 0x99, 0x2f, 0x5e, 0xbc,
+    0x65, 0xca, 0x89, 0x0f, 0x1e, 0x3c, 0x78, 0xf0, 0xfd, 0xe7, 0xd3, 0xbb,
+    0x6b, 0xd6, 0xb1, 0x7f, 0xfe, 0xe1, 0xdf, 0xa3, 0x5b, 0xb6, 0x71, 0xe2,
+    0xd9, 0xaf, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0d, 0x1a, 0x34, 0x68,
+    0xd0, 0xbd, 0x67, 0xce, 0x81, 0x1f, 0x3e, 0x7c, 0xf8, 0xed, 0xc7, 0x93,
+    0x3b, 0x76, 0xec, 0xc5, 0x97, 0x33, 0x66, 0xcc, 0x85, 0x17, 0x2e, 0x5c,
+    0xb8, 0x6d, 0xda, 0xa9, 0x4f, 0x9e, 0x21, 0x42, 0x84, 0x15, 0x2a, 0x54,
+    0xa8, 0x4d, 0x9a, 0x29, 0x52, 0xa4, 0x55, 0xaa, 0x49, 0x92, 0x39, 0x72,
+    0xe4, 0xd5, 0xb7, 0x73, 0xe6, 0xd1, 0xbf, 0x63, 0xc6, 0x91, 0x3f, 0x7e,
+    0xfc, 0xe5, 0xd7, 0xb3, 0x7b, 0xf6, 0xf1, 0xff, 0xe3, 0xdb, 0xab, 0x4b,
+    0x96, 0x31, 0x62, 0xc4, 0x95, 0x37, 0x6e, 0xdc, 0xa5, 0x57, 0xae, 0x41,
+    0x82, 0x19, 0x32, 0x64, 0xc8, 0x8d, 0x07, 0x0e, 0x1c, 0x38, 0x70, 0xe0,
+    0xdd, 0xa7, 0x53, 0xa6, 0x51, 0xa2, 0x59, 0xb2, 0x79, 0xf2, 0xf9, 0xef,
+    0xc3, 0x9b, 0x2b, 0x56, 0xac, 0x45, 0x8a, 0x09, 0x12, 0x24, 0x48, 0x90,
+    0x3d, 0x7a, 0xf4, 0xf5, 0xf7, 0xf3, 0xfb, 0xeb, 0xcb, 0x8b, 0x0b, 0x16,
+    0x2c, 0x58, 0xb0, 0x7d, 0xfa, 0xe9, 0xcf, 0x83, 0x1b, 0x36, 0x6c, 0xd8,
+    0xad, 0x47, 0x8e, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1d,
+    0x3a, 0x74, 0xe8, 0xcd, 0x87, 0x13, 0x26, 0x4c, 0x98, 0x2d, 0x5a, 0xb4,
+    0x75, 0xea, 0xc9, 0x8f, 0x03, 0x06, 0x0c, 0x18, 0x30, 0x60, 0xc0, 0x9d,
+    0x27, 0x4e, 0x9c, 0x25, 0x4a, 0x94, 0x35, 0x6a, 0xd4, 0xb5, 0x77, 0xee,
+    0xc1, 0x9f, 0x23, 0x46, 0x8c, 0x05, 0x0a, 0x14, 0x28, 0x50, 0xa0, 0x5d,
+    0xba, 0x69, 0xd2, 0xb9, 0x6f, 0xde, 0xa1, 0x5f, 0xbe, 0x61, 0xc2, 0x99,
+    0x2f, 0x5e, 0xbc, 0x65, 0xca, 0x89, 0x0f, 0x1e, 0x3c, 0x78, 0xf0, 0xfd,
+    0xe7, 0xd3, 0xbb, 0x6b, 0xd6, 0xb1, 0x7f, 0xfe, 0xe1, 0xdf, 0xa3, 0x5b,
+    0xb6, 0x71, 0xe2, 0xd9, 0xaf, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0d,
+    0x1a, 0x34, 0x68, 0xd0, 0xbd, 0x67, 0xce, 0x81, 0x1f, 0x3e, 0x7c, 0xf8,
+    0xed, 0xc7, 0x93, 0x3b, 0x76, 0xec, 0xc5, 0x97, 0x33, 0x66, 0xcc, 0x85,
+    0x17, 0x2e, 0x5c, 0xb8, 0x6d, 0xda, 0xa9, 0x4f, 0x9e, 0x21, 0x42, 0x84,
+    0x15, 0x2a, 0x54, 0xa8, 0x4d, 0x9a, 0x29, 0x52, 0xa4, 0x55, 0xaa, 0x49,
+    0x92, 0x39, 0x72, 0xe4, 0xd5, 0xb7, 0x73, 0xe6, 0xd1, 0xbf, 0x63, 0xc6,
+    0x91, 0x3f, 0x7e, 0xfc, 0xe5, 0xd7, 0xb3, 0x7b, 0xf6, 0xf1, 0xff, 0xe3,
+    0xdb, 0xab, 0x4b, 0x96, 0x31, 0x62, 0xc4, 0x95, 0x37, 0x6e, 0xdc, 0xa5,
+    0x57, 0xae, 0x41, 0x82, 0x19, 0x32, 0x64, 0xc8, 0x8d, 0x07, 0x0e, 0x1c,
+    0x38, 0x70, 0xe0, 0xdd, 0xa7, 0x53, 0xa6, 0x51, 0xa2, 0x59, 0xb2, 0x79,
+    0xf2, 0xf9, 0xef, 0xc3, 0x9b, 0x2b, 0x56, 0xac, 0x45, 0x8a, 0x09, 0x12,
+    0x24, 0x48, 0x90, 0x3d, 0x7a, 0xf4, 0xf5, 0xf7, 0xf3, 0xfb, 0xeb, 0xcb,
+    0x8b, 0x0b, 0x16, 0x2c, 0x58, 0xb0, 0x7d, 0xfa, 0xe9, 0xcf, 0x83, 0x1b,
+    0x36, 0x6c, 0xd8, 0xad, 0x47, 0x8e
+};
+
+static const uint8_t gf_log[256] = {
+    0x00, 0x00, 0x01, 0x19, 0x02, 0x32, 0x1a, 0xc6, 0x03, 0xdf, 0x33, 0xee,
+    0x1b, 0x68, 0xc7, 0x4b, 0x04, 0x64, 0xe0, 0x0e, 0x34, 0x8d, 0xef, 0x81,
+    0x1c, 0xc1, 0x69, 0xf8, 0xc8, 0x08, 0x4c, 0x71, 0x05, 0x8a, 0x65, 0x2f,
+    0xe1, 0x24, 0x0f, 0x21, 0x35, 0x93, 0x8e, 0xda, 0xf0, 0x12, 0x82, 0x45,
+    0x1d, 0xb5, 0xc2, 0x7d, 0x6a, 0x27, 0xf9, 0xb9, 0xc9, 0x9a, 0x09, 0x78,
+    0x4d, 0xe4, 0x72, 0xa6, 0x06, 0xbf, 0x8b, 0x62, 0x66, 0xdd, 0x30, 0xfd,
+    0xe2, 0x98, 0x25, 0xb3, 0x10, 0x91, 0x22, 0x88, 0x36, 0xd0, 0x94, 0xce,
+    0x8f, 0x96, 0xdb, 0xbd, 0xf1, 0xd2, 0x13, 0x5c, 0x83, 0x38, 0x46, 0x40,
+    0x1e, 0x42, 0xb6, 0xa3, 0xc3, 0x48, 0x7e, 0x6e, 0x6b, 0x3a, 0x28, 0x54,
+    0xfa, 0x85, 0xba, 0x3d, 0xca, 0x5e, 0x9b, 0x9f, 0x0a, 0x15, 0x79, 0x2b,
+    0x4e, 0xd4, 0xe5, 0xac, 0x73, 0xf3, 0xa7, 0x57, 0x07, 0x70, 0xc0, 0xf7,
+    0x8c, 0x80, 0x63, 0x0d, 0x67, 0x4a, 0xde, 0xed, 0x31, 0xc5, 0xfe, 0x18,
+    0xe3, 0xa5, 0x99, 0x77, 0x26, 0xb8, 0xb4, 0x7c, 0x11, 0x44, 0x92, 0xd9,
+    0x23, 0x20, 0x89, 0x2e, 0x37, 0x3f, 0xd1, 0x5b, 0x95, 0xbc, 0xcf, 0xcd,
+    0x90, 0x87, 0x97, 0xb2, 0xdc, 0xfc, 0xbe, 0x61, 0xf2, 0x56, 0xd3, 0xab,
+    0x14, 0x2a, 0x5d, 0x9e, 0x84, 0x3c, 0x39, 0x53, 0x47, 0x6d, 0x41, 0xa2,
+    0x1f, 0x2d, 0x43, 0xd8, 0xb7, 0x7b, 0xa4, 0x76, 0xc4, 0x17, 0x49, 0xec,
+    0x7f, 0x0c, 0x6f, 0xf6, 0x6c, 0xa1, 0x3b, 0x52, 0x29, 0x9d, 0x55, 0xaa,
+    0xfb, 0x60, 0x86, 0xb1, 0xbb, 0xcc, 0x3e, 0x5a, 0xcb, 0x59, 0x5f, 0xb0,
+    0x9c, 0xa9, 0xa0, 0x51, 0x0b, 0xf5, 0x16, 0xeb, 0x7a, 0x75, 0x2c, 0xd7,
+    0x4f, 0xae, 0xd5, 0xe9, 0xe6, 0xe7, 0xad, 0xe8, 0x74, 0xd6, 0xf4, 0xea,
+    0xa8, 0x50, 0x58, 0xaf
+};
+
+/**
+ *  Multiply two elements of GF(2^8).
+ */
+static inline uint8_t gf_mul(uint8_t a, uint8_t b)
+{
+    if ((a == 0) || (b == 0)) {
+        return 0;
+    }
+    return gf_exp[gf_log[a] + gf_log[b]];
+}
+
+/**
+ *  Find the multiplicative inverse of a non-zero element of GF(2^8).
+ */
+static inline uint8_t gf_inv(uint8_t a)
+{
+    return gf_exp[255 - gf_log[a]];
+}
+
+/**
+ *  Invert a square matrix over GF(2^8) by Gauss-Jordan elimination.
+ *
+ *  @param m The matrix to be inverted, is destroyed
+ *  @param inv Matrix in which the inverse is stored
+ *  @param n The number of rows and columns in the matrix
+ *
+ *  @return Zero if the matrix was inverted, non-zero if it is singular
+ */
+static int gf_invert(uint8_t m[][RADIO_FEC_MAX_PARITY_PACKETS],
+                     uint8_t inv[][RADIO_FEC_MAX_PARITY_PACKETS], uint8_t n)
+{
+    for (uint8_t row = 0; row < n; row++) {
+        for (uint8_t col = 0; col < n; col++) {
+            inv[row][col] = (row == col);
+        }
+    }
+
+    for (uint8_t col = 0; col < n; col++) {
+        // Find a row with a non-zero value in this column
+        uint8_t pivot = col;
+        while ((pivot < n) && (m[pivot][col] == 0)) {
+            pivot++;
+        }
+        if (pivot == n) {
+            return 1;
+        }
+
+        for (uint8_t c = 0; c < n; c++) {
+            const uint8_t tm = m[pivot][c];
+            m[pivot][c] = m[col][c];
+            m[col][c] = tm;
+            const uint8_t ti = inv[pivot][c];
+            inv[pivot][c] = inv[col][c];
+            inv[col][c] = ti;
+        }
+
+        // Scale the pivot row so that the pivot is one
+        const uint8_t scale = gf_inv(m[col][col]);
+        for (uint8_t c = 0; c < n; c++) {
+            m[col][c] = gf_mul(m[col][c], scale);
+            inv[col][c] = gf_mul(inv[col][c], scale);
+        }
+
+        // Clear this column from every other row
+        for (uint8_t row = 0; row < n; row++) {
+            const uint8_t f = m[row][col];
+            if ((row == col) || (f == 0)) {
+                continue;
+            }
+            for (uint8_t c = 0; c < n; c++) {
+                m[row][c] ^= gf_mul(f, m[col][c]);
+                inv[row][c] ^= gf_mul(f, inv[col][c]);
+            }
+        }
+    }
+
+    return 0;
+}
+
+uint8_t radio_fec_coefficient(uint8_t parity_index, uint8_t data_index)
+{
+    // Cauchy matrix entry 1 / (x_j + y_i) with x_j = j and
+    // y_i = RADIO_FEC_MAX_PARITY_PACKETS + i, scaled by y_i
+    const uint8_t y = RADIO_FEC_MAX_PARITY_PACKETS + data_index;
+    return gf_mul(y, gf_inv(parity_index ^ y));
+}
+
+void radio_fec_mul_add(uint8_t *restrict dst, const uint8_t *restrict src,
+                       uint8_t coef, uint8_t length)
+{
+    if (coef == 0) {
+        return;
+    } else if (coef == 1) {
+        for (uint8_t i = 0; i < length; i++) {
+            dst[i] ^= src[i];
+        }
+        return;
+    }
+
+    const uint8_t log_coef = gf_log[coef];
+    for (uint8_t i = 0; i < length; i++) {
+        if (src[i] != 0) {
+            dst[i] ^= gf_exp[gf_log[src[i]] + log_coef];
+        }
+    }
+}
+
+
+// MARK: Helpers
+
+/**
+ *  Determine whether this device decodes (ground station) or encodes (rocket).
+ *
+ *  @param inst The radio transport instance
+ *
+ *  @return Non-zero if this device decodes parity and decides the configuration
+ */
+static inline int fec_is_decoder(const struct radio_transport_desc *inst)
+{
+    return inst->address == RADIO_DEVICE_ADDRESS_GROUND_STATION;
+}
+
+/**
+ *  Get the length of the symbol used to code a packet payload.
+ *
+ *  @param payload_length The number of bytes in the packet after the header
+ *
+ *  @return The symbol length, the length byte and the payload rounded up to a
+ *          multiple of 4 bytes
+ */
+static inline uint8_t fec_symbol_length(uint8_t payload_length)
+{
+    return (payload_length + 4) & ~3;
+}
+
+/**
+ *  Determine whether an erasure coding configuration is valid.
+ */
+static inline int fec_config_valid(uint8_t data_packets, uint8_t parity_packets)
+{
+    return ((data_packets >= 1) &&
+            (data_packets <= RADIO_FEC_MAX_DATA_PACKETS) &&
+            (parity_packets <= RADIO_FEC_MAX_PARITY_PACKETS));
+}
+
+/**
+ *  Send an erasure coding configuration block.
+ *
+ *  @param inst The radio transport instance
+ *  @param dest The device to which the block should be sent
+ *  @param seq The sequence number of the configuration change
+ *  @param data_packets Number of data packets in each group
+ *  @param parity_packets Number of parity packets sent after each group
+ *  @param ack Whether the block acknowledges a request
+ */
+static void fec_send(struct radio_transport_desc *inst,
+                     enum radio_packet_device_address dest, uint8_t seq,
+                     uint8_t data_packets, uint8_t parity_packets, int ack)
+{
+    uint8_t block[RADIO_BLOCK_FEC_CONFIG_LENGTH];
+    radio_block_marshal_header(block, RADIO_BLOCK_FEC_CONFIG_LENGTH, 0, dest,
+                               RADIO_BLOCK_TYPE_CONTROL,
+                               RADIO_CONTROL_BLOCK_FEC_CONFIG);
+    radio_block_marshal_fec_config(block, seq, data_packets, parity_packets,
+                                   ack);
+    radio_send_block(inst, block, RADIO_BLOCK_FEC_CONFIG_LENGTH, 0,
+                     LORA_FEC_REQUEST_PERIOD, RADIO_BLOCK_PRIORITY_HIGH);
+}
+
+/**
+ *  Start sending requests for the current configuration.
+ *
+ *  @param fec The erasure coding state
+ */
+static void fec_start_request(struct radio_fec_desc *fec)
+{
+    fec->seq++;
+    fec->tries = 0;
+    fec->pending = 1;
+    fec->confirmed = 0;
+    // Send the first request right away
+    fec->request_time = millis - LORA_FEC_REQUEST_PERIOD;
+}
+
+/**
+ *  Start using a new erasure coding configuration for sending.
+ *
+ *  @param inst The radio transport instance
+ *  @param data_packets Number of data packets in each group
+ *  @param parity_packets Number of parity packets sent after each group
+ */
+static void fec_apply(struct radio_transport_desc *inst, uint8_t data_packets,
+                      uint8_t parity_packets)
+{
+    struct radio_fec_desc *const fec = inst->fec;
+
+    fec->data_packets = data_packets;
+    fec->parity_packets = parity_packets;
+    fec->confirmed = 1;
+    fec->encoder.count = 0;
+    fec->encoder.parity_sent = 0;
+
+    // Packets are kept short enough that a parity packet for them still fits
+    // in a single transmission
+    inst->max_packet_length = ((parity_packets != 0) ?
+                               RADIO_FEC_MAX_PACKET_LENGTH :
+                               RADIO_MAX_PACKET_SIZE);
+}
+
+
+// MARK: Configuration
+
+void init_radio_fec(struct radio_transport_desc *inst)
+{
+    struct radio_fec_desc *const fec = inst->fec;
+
+    memset(fec, 0, sizeof(*fec));
+
+    if (!fec_is_decoder(inst)) {
+        // Parity is not sent until the ground station asks for it
+        fec_apply(inst, LORA_FEC_DATA_PACKETS, 0);
+        return;
+    }
+
+    fec->data_packets = LORA_FEC_DATA_PACKETS;
+    fec->parity_packets = LORA_FEC_PARITY_PACKETS;
+    if (fec->parity_packets != 0) {
+        fec_start_request(fec);
+    } else {
+        // The rocket starts without parity, so there is nothing to ask for
+        fec->confirmed = 1;
+    }
+}
+
+void radio_fec_service(struct radio_transport_desc *inst)
+{
+    struct radio_fec_desc *const fec = inst->fec;
+
+    if (!fec_is_decoder(inst)) {
+        return;
+    }
+
+    if (fec->confirmed && (fec->parity_packets != 0) &&
+            (fec->packets_since_parity >
+             (2 * (fec->data_packets + fec->parity_packets)))) {
+        // Parity should have arrived by now, the rocket may have been reset
+        // and forgotten the configuration
+        fec->packets_since_parity = 0;
+        fec_start_request(fec);
+    } else if (!fec->confirmed && !fec->pending &&
+            ((millis - fec->request_time) >= LORA_FEC_RETRY_PERIOD)) {
+        fec_start_request(fec);
+    }
+
+    if (fec->pending &&
+            ((millis - fec->request_time) >= LORA_FEC_REQUEST_PERIOD)) {
+        if (fec->tries >= LORA_FEC_REQUEST_TRIES) {
+            // Give up for now, try again after the retry period
+            fec->pending = 0;
+            fec->request_time = millis;
+            return;
+        }
+        fec_send(inst, RADIO_DEVICE_ADDRESS_MULTICAST, fec->seq,
+                 fec->data_packets, fec->parity_packets, 0);
+        fec->tries++;
+        fec->request_time = millis;
+    }
+}
+
+int radio_fec_request(struct radio_transport_desc *inst, uint8_t data_packets,
+                      uint8_t parity_packets)
+{
+    struct radio_fec_desc *const fec = inst->fec;
+
+    if (!fec_is_decoder(inst) ||
+            !fec_config_valid(data_packets, parity_packets)) {
+        return 1;
+    }
+
+    fec->data_packets = data_packets;
+    fec->parity_packets = parity_packets;
+    fec->packets_since_parity = 0;
+    fec_start_request(fec);
+    return 0;
+}
+
+void radio_fec_config_cb(struct radio_transport_desc *inst,
+                         const uint8_t *block,
+                         enum radio_packet_device_address source)
+{
+    struct radio_fec_desc *const fec = inst->fec;
+    const uint8_t seq = radio_block_fec_config_seq(block);
+    const uint8_t data_packets = radio_block_fec_config_data_packets(block);
+    const uint8_t parity_packets = radio_block_fec_config_parity_packets(block);
+
+    if (!fec_config_valid(data_packets, parity_packets)) {
+        return;
+    }
+
+    if (fec_is_decoder(inst)) {
+        // The other device has started using the configuration we requested
+        if (radio_block_fec_config_ack(block) && fec->pending &&
+                (seq == fec->seq) && (data_packets == fec->data_packets) &&
+                (parity_packets == fec->parity_packets)) {
+            fec->pending = 0;
+            fec->confirmed = 1;
+            fec->packets_since_parity = 0;
+        }
+        return;
+    } else if (radio_block_fec_config_ack(block)) {
+        return;
+    }
+
+    // Acknowledge the request, this is also done for repeated requests in case
+    // our last acknowledgement was lost
+    fec_send(inst, source, seq, data_packets, parity_packets, 1);
+
+    fec->seq = seq;
+    if ((data_packets != fec->data_packets) ||
+            (parity_packets != fec->parity_packets)) {
+        // Unlike a link profile change this can take effect right away, the
+        // ground station can decode packets whether or not they are coded
+        fec_apply(inst, data_packets, parity_packets);
+    }
+}
+
+
+// MARK: Encoder
+
+void radio_fec_encode_packet(struct radio_transport_desc *inst,
+                             const uint8_t *packet)
+{
+    struct radio_fec_desc *const fec = inst->fec;
+    struct radio_fec_encoder *const enc = &fec->encoder;
+
+    if (fec_is_decoder(inst) || (fec->parity_packets == 0)) {
+        return;
+    }
+
+    const uint16_t number = radio_packet_number(packet);
+    const uint8_t length = (radio_packet_length(packet) -
+                            RADIO_PACKET_HEADER_LENGTH);
+    const uint8_t symbol_length = fec_symbol_length(length);
+
+    if (symbol_length > RADIO_FEC_MAX_SYMBOL_LENGTH) {
+        // This packet is too long to be protected, start a new group after it
+        enc->count = 0;
+        return;
+    }
+
+    if ((enc->count >= fec->data_packets) ||
+            (number != ((enc->first + enc->count) & 0xfff))) {
+        // Packets in a group must have consecutive numbers, if the last group
+        // is complete or was interrupted a new group is started
+        enc->count = 0;
+    }
+
+    if (enc->count == 0) {
+        enc->first = number;
+        enc->symbol_length = 0;
+        enc->parity_sent = 0;
+        memset(enc->parity, 0, sizeof(enc->parity));
+    }
+
+    if (symbol_length > enc->symbol_length) {
+        enc->symbol_length = symbol_length;
+    }
+
+    for (uint8_t j = 0; j < fec->parity_packets; j++) {
+        const uint8_t coef = radio_fec_coefficient(j, enc->count);
+        enc->parity[j][0] ^= gf_mul(coef, length);
+        radio_fec_mul_add(enc->parity[j] + 1,
+                          packet + RADIO_PACKET_HEADER_LENGTH, coef, length);
+    }
+
+    enc->count++;
+}
+
+uint8_t radio_fec_make_parity_packet(struct radio_transport_desc *inst,
+                                     uint8_t *packet)
+{
+    struct radio_fec_desc *const fec = inst->fec;
+    struct radio_fec_encoder *const enc = &fec->encoder;
+
+    if (fec_is_decoder(inst) || (fec->parity_packets == 0) ||
+            (enc->count < fec->data_packets) ||
+            (enc->parity_sent >= fec->parity_packets)) {
+        return 0;
+    }
+
+    uint8_t *const block = packet + RADIO_PACKET_HEADER_LENGTH;
+    const uint8_t block_length = (RADIO_BLOCK_HEADER_LENGTH +
+                                  RADIO_BLOCK_FEC_PARITY_HEADER_LENGTH +
+                                  enc->symbol_length);
+    radio_block_marshal_header(block, block_length, 0,
+                               RADIO_DEVICE_ADDRESS_GROUND_STATION,
+                               RADIO_BLOCK_TYPE_CONTROL,
+                               RADIO_CONTROL_BLOCK_FEC_PARITY);
+    radio_block_marshal_fec_parity(block, enc->first, fec->data_packets,
+                                   enc->parity_sent, fec->parity_packets);
+    memcpy(block + RADIO_BLOCK_HEADER_LENGTH +
+                RADIO_BLOCK_FEC_PARITY_HEADER_LENGTH,
+           enc->parity[enc->parity_sent], enc->symbol_length);
+
+    const uint8_t length = RADIO_PACKET_HEADER_LENGTH + block_length;
+    radio_packet_set_length(packet, length);
+    return length;
+}
+
+void radio_fec_parity_sent(struct radio_transport_desc *inst)
+{
+    struct radio_fec_desc *const fec = inst->fec;
+    struct radio_fec_encoder *const enc = &fec->encoder;
+
+    enc->parity_sent++;
+    if (enc->parity_sent >= fec->parity_packets) {
+        // This group is done, the next packet starts a new one
+        enc->count = 0;
+        fec->num_groups++;
+    }
+}
+
+
+// MARK: Decoder
+
+/**
+ *  Get the window slot for a packet number.
+ */
+static inline uint8_t decoder_slot(uint16_t number)
+{
+    return number & (RADIO_FEC_WINDOW - 1);
+}
+
+/**
+ *  Find the symbol for a packet in the window.
+ *
+ *  @param dec The decoder state
+ *  @param number The packet number
+ *
+ *  @return The symbol or NULL if the packet has not been received
+ */
+static const uint8_t *decoder_find(const struct radio_fec_decoder *dec,
+                                   uint16_t number)
+{
+    const uint8_t slot = decoder_slot(number);
+    if ((dec->valid & (1 << slot)) && (dec->numbers[slot] == number)) {
+        return dec->symbols[slot];
+    }
+    return NULL;
+}
+
+/**
+ *  Count the packets in the current group which have not been received or
+ *  rebuilt.
+ *
+ *  @param dec The decoder state
+ *  @param missing Array in which the index within the group of each missing
+ *                 packet is stored
+ *
+ *  @return The number of missing packets
+ */
+static uint8_t decoder_find_missing(const struct radio_fec_decoder *dec,
+                                    uint8_t *missing)
+{
+    uint8_t num_missing = 0;
+    for (uint8_t i = 0; i < dec->data_packets; i++) {
+        if (decoder_find(dec, (dec->first + i) & 0xfff) == NULL) {
+            missing[num_missing++] = i;
+        }
+    }
+    return num_missing;
+}
+
+/**
+ *  Stop working on the current group, any packets from it that are still
+ *  missing are lost.
+ *
+ *  @param fec The erasure coding state
+ */
+static void decoder_finish_group(struct radio_fec_desc *fec)
+{
+    struct radio_fec_decoder *const dec = &fec->decoder;
+
+    if (dec->active && !dec->done) {
+        uint8_t missing[RADIO_FEC_MAX_DATA_PACKETS];
+        fec->num_unrecoverable += decoder_find_missing(dec, missing);
+    }
+    dec->done = 1;
+}
+
+/**
+ *  Rebuild a packet from a recovered symbol and pass it to the transport.
+ *
+ *  @param inst The radio transport instance
+ *  @param radio The radio on which the parity was received
+ *  @param symbol The recovered symbol
+ *  @param number The packet number of the recovered packet
+ */
+static void decoder_deliver(struct radio_transport_desc *inst,
+                            struct radio_instance_desc *radio,
+                            const uint8_t *symbol, uint16_t number)
+{
+    struct radio_fec_desc *const fec = inst->fec;
+    const uint8_t length = symbol[0];
+
+    if ((length < RADIO_BLOCK_HEADER_LENGTH) || ((length % 4) != 0) ||
+            (fec_symbol_length(length) > fec->decoder.symbol_length)) {
+        // The recovered symbol does not make sense
+        fec->num_unrecoverable++;
+        return;
+    }
+
+    uint8_t packet[RADIO_MAX_PACKET_SIZE];
+    memcpy(packet, fec->decoder.header, RADIO_PACKET_HEADER_LENGTH);
+    radio_packet_set_number(packet, number);
+    radio_packet_set_length(packet, RADIO_PACKET_HEADER_LENGTH + length);
+    memcpy(packet + RADIO_PACKET_HEADER_LENGTH, symbol + 1, length);
+
+    fec->num_recovered++;
+    radio_handle_recovered_packet(inst, radio, packet);
+}
+
+/**
+ *  Rebuild the lost packets in the current group if enough parity has been
+ *  received.
+ *
+ *  @param inst The radio transport instance
+ *  @param radio The radio on which the last packet was received
+ */
+static void decoder_try_recover(struct radio_transport_desc *inst,
+                                struct radio_instance_desc *radio)
+{
+    struct radio_fec_desc *const fec = inst->fec;
+    struct radio_fec_decoder *const dec = &fec->decoder;
+
+    uint8_t missing[RADIO_FEC_MAX_DATA_PACKETS];
+    const uint8_t num_missing = decoder_find_missing(dec, missing);
+    if (num_missing == 0) {
+        dec->done = 1;
+        return;
+    }
+
+    // Pick one received parity symbol for each lost packet
+    uint8_t rows[RADIO_FEC_MAX_PARITY_PACKETS];
+    uint8_t num_rows = 0;
+    for (uint8_t j = 0; (j < dec->parity_packets) && (num_rows < num_missing);
+            j++) {
+        if (dec->parity_mask & (1 << j)) {
+            rows[num_rows++] = j;
+        }
+    }
+    if (num_rows < num_missing) {
+        // Wait for more packets or parity
+        return;
+    }
+
+    // Remove the received packets from the parity symbols so that only the
+    // lost packets are left
+    for (uint8_t a = 0; a < num_rows; a++) {
+        for (uint8_t i = 0; i < dec->data_packets; i++) {
+            const uint16_t number = (dec->first + i) & 0xfff;
+            const uint8_t *const symbol = decoder_find(dec, number);
+            if (symbol != NULL) {
+                radio_fec_mul_add(dec->parity[rows[a]], symbol,
+                                  radio_fec_coefficient(rows[a], i),
+                                  dec->symbol_length);
+            }
+        }
+    }
+
+    // Solve for the lost packets
+    uint8_t m[RADIO_FEC_MAX_PARITY_PACKETS][RADIO_FEC_MAX_PARITY_PACKETS];
+    uint8_t inv[RADIO_FEC_MAX_PARITY_PACKETS][RADIO_FEC_MAX_PARITY_PACKETS];
+    for (uint8_t a = 0; a < num_rows; a++) {
+        for (uint8_t b = 0; b < num_missing; b++) {
+            m[a][b] = radio_fec_coefficient(rows[a], missing[b]);
+        }
+    }
+    dec->done = 1;
+    if (gf_invert(m, inv, num_missing)) {
+        // Should not be possible, every square sub-matrix is invertible
+        fec->num_unrecoverable += num_missing;
+        return;
+    }
+
+    for (uint8_t b = 0; b < num_missing; b++) {
+        const uint16_t number = (dec->first + missing[b]) & 0xfff;
+        const uint8_t slot = decoder_slot(number);
+        uint8_t *const symbol = dec->symbols[slot];
+
+        memset(symbol, 0, RADIO_FEC_MAX_SYMBOL_LENGTH);
+        for (uint8_t a = 0; a < num_rows; a++) {
+            radio_fec_mul_add(symbol, dec->parity[rows[a]], inv[b][a],
+                              dec->symbol_length);
+        }
+        dec->numbers[slot] = number;
+        dec->valid |= (1 << slot);
+    }
+
+    for (uint8_t b = 0; b < num_missing; b++) {
+        const uint16_t number = (dec->first + missing[b]) & 0xfff;
+        decoder_deliver(inst, radio, dec->symbols[decoder_slot(number)],
+                        number);
+    }
+}
+
+void radio_fec_decode_packet(struct radio_transport_desc *inst,
+                             struct radio_instance_desc *radio,
+                             const uint8_t *packet)
+{
+    struct radio_fec_desc *const fec = inst->fec;
+    struct radio_fec_decoder *const dec = &fec->decoder;
+
+    if (!fec_is_decoder(inst)) {
+        return;
+    }
+
+    const uint8_t *const block = radio_packet_fist_block(packet);
+    if ((block != NULL) &&
+            (radio_block_type(block) == RADIO_BLOCK_TYPE_CONTROL) &&
+            (radio_block_subtype(block) == RADIO_CONTROL_BLOCK_FEC_PARITY)) {
+        // Parity packets are not part of any group
+        return;
+    }
+
+    if (fec->packets_since_parity != UINT16_MAX) {
+        fec->packets_since_parity++;
+    }
+
+    const uint16_t number = radio_packet_number(packet);
+    const uint8_t length = (radio_packet_length(packet) -
+                            RADIO_PACKET_HEADER_LENGTH);
+    const uint8_t slot = decoder_slot(number);
+
+    dec->valid &= ~(1 << slot);
+    if (fec_symbol_length(length) > RADIO_FEC_MAX_SYMBOL_LENGTH) {
+        // This packet is too long to have been coded
+        return;
+    }
+
+    uint8_t *const symbol = dec->symbols[slot];
+    symbol[0] = length;
+    memcpy(symbol + 1, packet + RADIO_PACKET_HEADER_LENGTH, length);
+    memset(symbol + 1 + length, 0, RADIO_FEC_MAX_SYMBOL_LENGTH - 1 - length);
+    dec->numbers[slot] = number;
+    dec->valid |= (1 << slot);
+
+    if (dec->active && !dec->done &&
+            (((number - dec->first) & 0xfff) < dec->data_packets)) {
+        // This packet might be the last one needed to rebuild its group
+        decoder_try_recover(inst, radio);
+    }
+}
+
+void radio_fec_parity_cb(struct radio_transport_desc *inst,
+                         struct radio_instance_desc *radio,
+                         const uint8_t *packet, const uint8_t *block)
+{
+    struct radio_fec_desc *const fec = inst->fec;
+    struct radio_fec_decoder *const dec = &fec->decoder;
+
+    if (!fec_is_decoder(inst)) {
+        return;
+    }
+
+    fec->packets_since_parity = 0;
+
+    const uint16_t first = radio_block_fec_parity_first(block);
+    const uint8_t data_packets = radio_block_fec_parity_data_packets(block);
+    const uint8_t parity_packets = radio_block_fec_parity_parity_packets(block);
+    const uint8_t index = radio_block_fec_parity_index(block);
+    const uint8_t block_length = radio_block_length(block);
+    const uint8_t symbol_length = (block_length - RADIO_BLOCK_HEADER_LENGTH -
+                                   RADIO_BLOCK_FEC_PARITY_HEADER_LENGTH);
+
+    if ((block_length <= (RADIO_BLOCK_HEADER_LENGTH +
+                          RADIO_BLOCK_FEC_PARITY_HEADER_LENGTH)) ||
+            (symbol_length > RADIO_FEC_MAX_SYMBOL_LENGTH) ||
+            !fec_config_valid(data_packets, parity_packets) ||
+            (index >= parity_packets)) {
+        return;
+    }
+
+    if (!dec->active || (first != dec->first) ||
+            (data_packets != dec->data_packets) ||
+            (parity_packets != dec->parity_packets) ||
+            (symbol_length != dec->symbol_length)) {
+        // This is the first parity received for a new group
+        decoder_finish_group(fec);
+        dec->first = first;
+        dec->data_packets = data_packets;
+        dec->parity_packets = parity_packets;
+        dec->symbol_length = symbol_length;
+        dec->parity_mask = 0;
+        dec->active = 1;
+        dec->done = 0;
+        fec->num_groups++;
+    } else if (dec->done || (dec->parity_mask & (1 << index))) {
+        return;
+    }
+
+    memcpy(dec->parity[index], radio_block_fec_parity_symbol(block),
+           symbol_length);
+    dec->parity_mask |= (1 << index);
+    memcpy(dec->header, packet, RADIO_PACKET_HEADER_LENGTH);
+
+    decoder_try_recover(inst, radio);
+}
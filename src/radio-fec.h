@@ -0,0 +1,147 @@
+/**
+ * @file radio-fec.h
+ * @desc Packet level erasure coding for the radio transport. Parity packets
+ *       sent after each group of packets allow lost packets to be rebuilt.
+ * @author agent
+ * @date 2026-10-16
+ * Last Author:
+ * Last Edited On:
+ */
+
+#ifndef radio_fec_h
+#define radio_fec_h
+
+#include "global.h"
+
+#include "radio-types.h"
+
+
+/**
+ *  Initialize erasure coding for a radio transport. Must be called after the
+ *  transport's address has been set.
+ *
+ *  @param inst The radio transport instance
+ */
+extern void init_radio_fec(struct radio_transport_desc *inst);
+
+/**
+ *  Service to be called regularly for a radio transport which uses erasure
+ *  coding.
+ *
+ *  @param inst The radio transport instance
+ */
+extern void radio_fec_service(struct radio_transport_desc *inst);
+
+/**
+ *  Ask the other device to use a new erasure coding configuration. Only has
+ *  an effect on the ground station.
+ *
+ *  @param inst The radio transport instance
+ *  @param data_packets Number of data packets in each group, from 1 to
+ *                      RADIO_FEC_MAX_DATA_PACKETS
+ *  @param parity_packets Number of parity packets sent after each group, from
+ *                        0 to RADIO_FEC_MAX_PARITY_PACKETS
+ *
+ *  @return Zero if the request will be sent, non-zero if the configuration is
+ *          not valid
+ */
+extern int radio_fec_request(struct radio_transport_desc *inst,
+                             uint8_t data_packets, uint8_t parity_packets);
+
+/**
+ *  Handle a received erasure coding configuration block.
+ *
+ *  @param inst The radio transport instance
+ *  @param block The received block
+ *  @param source The address of the device which sent the block
+ */
+extern void radio_fec_config_cb(struct radio_transport_desc *inst,
+                                const uint8_t *block,
+                                enum radio_packet_device_address source);
+
+// MARK: Encoder
+
+/**
+ *  Add a packet which has been sent to the current group. Must be called for
+ *  every packet other than parity packets, in the order that they are sent.
+ *
+ *  @param inst The radio transport instance
+ *  @param packet The packet which was sent
+ */
+extern void radio_fec_encode_packet(struct radio_transport_desc *inst,
+                                    const uint8_t *packet);
+
+/**
+ *  Create the next parity packet for the most recently completed group.
+ *
+ *  @param inst The radio transport instance
+ *  @param packet Buffer in which the parity packet should be created, the
+ *                header must already be initialized
+ *
+ *  @return The length of the parity packet or zero if there is no parity to be
+ *          sent
+ */
+extern uint8_t radio_fec_make_parity_packet(struct radio_transport_desc *inst,
+                                            uint8_t *packet);
+
+/**
+ *  Record that the parity packet most recently created has been sent.
+ *
+ *  @param inst The radio transport instance
+ */
+extern void radio_fec_parity_sent(struct radio_transport_desc *inst);
+
+// MARK: Decoder
+
+/**
+ *  Keep a received packet so that it can be used to rebuild lost packets from
+ *  the same group. Must be called for every packet that is not a duplicate.
+ *
+ *  @param inst The radio transport instance
+ *  @param radio The radio on which the packet was received
+ *  @param packet The received packet
+ */
+extern void radio_fec_decode_packet(struct radio_transport_desc *inst,
+                                    struct radio_instance_desc *radio,
+                                    const uint8_t *packet);
+
+/**
+ *  Handle a received parity block. Any lost packets which can be rebuilt are
+ *  passed to radio_handle_recovered_packet().
+ *
+ *  @param inst The radio transport instance
+ *  @param radio The radio on which the block was received
+ *  @param packet The packet which contained the block
+ *  @param block The received block
+ */
+extern void radio_fec_parity_cb(struct radio_transport_desc *inst,
+                                struct radio_instance_desc *radio,
+                                const uint8_t *packet, const uint8_t *block);
+
+// MARK: Coding
+
+/**
+ *  Get the coefficient by which a data symbol is multiplied when it is added
+ *  to a parity symbol. The coefficients for the first parity symbol are all
+ *  one so that it is the exclusive or of the data symbols.
+ *
+ *  @param parity_index Index of the parity symbol
+ *  @param data_index Index of the data symbol within its group
+ *
+ *  @return The coefficient in GF(2^8)
+ */
+extern uint8_t radio_fec_coefficient(uint8_t parity_index, uint8_t data_index);
+
+/**
+ *  Multiply a symbol by a coefficient in GF(2^8) and add it to another symbol.
+ *
+ *  @param dst The symbol to which the product should be added
+ *  @param src The symbol to be multiplied
+ *  @param coef The coefficient
+ *  @param length The number of bytes in the symbols
+ */
+extern void radio_fec_mul_add(uint8_t *restrict dst,
+                              const uint8_t *restrict src, uint8_t coef,
+                              uint8_t length);
+
+#endif /* radio_fec_h */
@@ -12,7 +12,8 @@
 
 #include <stdint.h>
 #include <string.h>
-#define RADIO_SUPPORTED_FORMAT_VERSION  0
+/** Version 1 added sample times to the IMU and accelerometer data blocks */
+#define RADIO_SUPPORTED_FORMAT_VERSION  1
 
 
 /** Minimum amount of time between transmissions */
@@ -271,10 +272,13 @@ enum radio_block_control_subtype {
     RADIO_CONTROL_BLOCK_CMD_NONCE_REQ = 0x02,
     RADIO_CONTROL_BLOCK_CMD_NONCE = 0x03,
     RADIO_CONTROL_BLOCK_BEACON = 0x04,
-    RADIO_CONTROL_BLOCK_BEACON_RSP = 0x05
+    RADIO_CONTROL_BLOCK_BEACON_RSP = 0x05,
+    RADIO_CONTROL_BLOCK_LINK_PROFILE = 0x06,
+    RADIO_CONTROL_BLOCK_FEC_CONFIG = 0x07,
+    RADIO_CONTROL_BLOCK_FEC_PARITY = 0x08
 };
 
-#define RADIO_CONTROL_BLOCK_NUM_SUBTYPES    6
+#define RADIO_CONTROL_BLOCK_NUM_SUBTYPES    9
 
 /**
  *  Possible subtypes for radio packet command blocks.
@@ -306,7 +310,7 @@ enum radio_block_data_subtype {
     RADIO_DATA_BLOCK_KX134_1211_ACCEL = 0x0b
 };
 
-#define RADIO_DATA_BLOCK_NUM_SUBTYPES    9
+#define RADIO_DATA_BLOCK_NUM_SUBTYPES    12
 
 //
 //
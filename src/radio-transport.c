@@ -14,6 +14,7 @@
 
 #include "radio-chanmgr.h"
 #include "radio-antmgr.h"
+#include "radio-fec.h"
 
 #define RADIO_PACKET_WATERLINE  100
 
@@ -45,12 +46,15 @@ void init_radio_transport(struct radio_transport_desc *inst,
                           struct radio_instance_desc *const *radios,
                           struct sercom_uart_desc_t *const *radio_uarts,
                           const struct radio_antenna_info *radio_antennas,
+                          struct radio_fec_desc *fec,
                           enum radio_search_role search_role,
                           enum radio_packet_device_address address)
 {
     inst->radios = radios;
     inst->search_role = search_role;
     inst->address = address;
+    inst->fec = fec;
+    inst->max_packet_length = RADIO_MAX_PACKET_SIZE;
 
     inst->last_tx_time = 0;
     inst->last_rx_time = 0;
@@ -58,6 +62,11 @@ void init_radio_transport(struct radio_transport_desc *inst,
     // Initialize channel manager
     init_radio_chanmgr(inst);
 
+    // Initialize erasure coding
+    if (fec != NULL) {
+        init_radio_fec(inst);
+    }
+
     // Initialize radios and antennas
     for (unsigned int i = 0; i < RADIO_MAX_NUM_RADIOS; i++) {
         if (radios[i] == NULL) {
@@ -68,8 +77,12 @@ void init_radio_transport(struct radio_transport_desc *inst,
         struct sercom_uart_desc_t *u = ((struct sercom_uart_desc_t *)
                                         ((uintptr_t)radio_uarts[i] & (~0b11)));
 
+        // Each radio listens on its own channel, any extra radios double up
+        // on the lowest channels
+        radio_chanmgr_init_radio(inst, radios[i], i % LORA_NUM_CHANNELS);
+
         // Initialize RN2483 driver
-        init_rn2483(&radios[i]->rn2483, u, &inst->radio_settings);
+        init_rn2483(&radios[i]->rn2483, u, &radios[i]->settings);
 
         // Initialize antennas
         if (radio_antennas[i].antmgr != NULL) {
@@ -95,19 +108,25 @@ void init_radio_transport(struct radio_transport_desc *inst,
 
     // Set TX state
     inst->tx_state = RADIO_TRANS_TX_IDLE;
-
-    // Initialize buffer block descriptors
-    for (unsigned int i = 0; i < RADIO_BLOCKS_PER_PACKET; i++) {
-        inst->buffer_info[i].length = 0;
+    inst->tx_channel = 0;
+
+    // Initialize packet headers in transmit queue
+    for (unsigned int i = 0; i < RADIO_TX_QUEUE_LENGTH; i++) {
+        radio_packet_marshal_header(inst->tx_queue[i].buffer, LORA_CALLSIGN,
+                                    RADIO_SUPPORTED_FORMAT_VERSION, address, 0,
+                                    RADIO_PACKET_HEADER_LENGTH);
+        inst->tx_queue[i].num_blocks = 0;
     }
+    inst->tx_queue_head = 0;
+    inst->tx_queue_count = 0;
 
-    // Initialize packet header in buffer
-    radio_packet_marshal_header(inst->packet_buffer, LORA_CALLSIGN,
+    // Initialize packet header in priority buffer
+    radio_packet_marshal_header(inst->priority_packet_buffer, LORA_CALLSIGN,
                                 RADIO_SUPPORTED_FORMAT_VERSION, address, 0,
                                 RADIO_PACKET_HEADER_LENGTH);
 
-    // Initialize packet header in priority buffer
-    radio_packet_marshal_header(inst->priority_packet_buffer, LORA_CALLSIGN,
+    // Initialize packet header in erasure coding parity buffer
+    radio_packet_marshal_header(inst->fec_packet_buffer, LORA_CALLSIGN,
                                 RADIO_SUPPORTED_FORMAT_VERSION, address, 0,
                                 RADIO_PACKET_HEADER_LENGTH);
 
@@ -115,53 +134,56 @@ void init_radio_transport(struct radio_transport_desc *inst,
 
     // Initialize flags
     inst->priority_tx_in_progress = 0;
-    inst->buffer_slack_time_valid = 0;
-    inst->prebuffer_slack_time_valid = 0;
+    inst->fec_tx_in_progress = 0;
+
+    // Start collecting transmit statistics
+    radio_reset_tx_stats(inst);
 }
 
 // MARK: Service
 
 /**
- *  Reset the packet buffer after a packet has been sent. Any prebuffered blocks
- *  will be moved into position to be sent in the next packet.
+ *  Get a packet from the transmit queue.
+ *
+ *  @param inst The instance from which the packet should be gotten
+ *  @param n The position of the packet in the queue, 0 is the oldest packet
  *
- *  @param inst The instance for which the packet buffer should be reset
+ *  @return The packet at the given position in the queue
  */
-static void reset_packet_buffer(struct radio_transport_desc *inst)
-{
-    // Clear out blocks that have been sent and shift over any prebuffered
-    // blocks
-    uint8_t block_shift_index = 0;
-    uint8_t new_length = RADIO_PACKET_HEADER_LENGTH;
-
-    for (unsigned int i = 0; i < RADIO_BLOCKS_PER_PACKET; i++) {
-        struct radio_trans_buff_blk_info *block = &inst->buffer_info[i];
-        if (block->prebuffered && block->length) {
-            // This is a prebuffered block, shift it down if necessary
-            block->prebuffered = 0;
-            // Shift data
-            memmove(inst->packet_buffer + new_length,
-                    inst->packet_buffer + block->offset, block->length);
-            new_length += block->length;
-            // Shift descriptor
-            memcpy(&inst->buffer_info[block_shift_index], block,
-                   sizeof(struct radio_trans_buff_blk_info));
-            block_shift_index++;
-        }
-        // Clear block
-        block->length = 0;
-    }
-
-    // Update slack time
-    if (inst->prebuffer_slack_time_valid) {
-        inst->buffer_slack_time_base = inst->prebuffer_slack_time_base;
-        inst->buffer_slack_time = inst->prebuffer_slack_time;
-    }
-    inst->buffer_slack_time_valid = inst->prebuffer_slack_time_valid;
-    inst->prebuffer_slack_time_valid = 0;
+static inline struct radio_trans_tx_packet *tx_queue_get(
+                                            struct radio_transport_desc *inst,
+                                            uint8_t n)
+{
+    return &inst->tx_queue[(inst->tx_queue_head + n) % RADIO_TX_QUEUE_LENGTH];
+}
 
-    // Update packet length
-    radio_packet_set_length(inst->packet_buffer, new_length);
+/**
+ *  Determine whether the oldest packet in the transmit queue is currently being
+ *  transmitted.
+ *
+ *  @param inst The instance for which the transmit queue should be checked
+ *
+ *  @return Non-zero if the oldest packet in the queue is being transmitted
+ */
+static inline int tx_queue_head_in_flight(struct radio_transport_desc *inst)
+{
+    return ((inst->tx_state == RADIO_TRANS_TX_IN_PROGRESS) &&
+            !inst->priority_tx_in_progress && !inst->fec_tx_in_progress);
+}
+
+/**
+ *  Remove the oldest packet from the transmit queue after it has been sent.
+ *
+ *  @param inst The instance for which the oldest packet should be removed
+ */
+static void tx_queue_pop(struct radio_transport_desc *inst)
+{
+    struct radio_trans_tx_packet *const packet = tx_queue_get(inst, 0);
+    packet->num_blocks = 0;
+    radio_packet_set_length(packet->buffer, RADIO_PACKET_HEADER_LENGTH);
+
+    inst->tx_queue_head = (inst->tx_queue_head + 1) % RADIO_TX_QUEUE_LENGTH;
+    inst->tx_queue_count--;
 }
 
 /**
@@ -185,109 +207,220 @@ static void update_sig_report_radio_nums(uint8_t *packet, uint8_t radio_num)
     }
 }
 
+/**
+ *  Get the transmit statistics for a block.
+ *
+ *  @param inst The instance in which the statistics are stored
+ *  @param block The block for which the statistics should be found
+ *
+ *  @return The statistics for the block's subtype or NULL if statistics are not
+ *          kept for the block
+ */
+static inline struct radio_trans_tx_stats *tx_stats_for(
+                                            struct radio_transport_desc *inst,
+                                            const uint8_t *block)
+{
+    const uint8_t subtype = radio_block_subtype(block);
+    if ((radio_block_type(block) != RADIO_BLOCK_TYPE_DATA) ||
+            (subtype >= RADIO_DATA_BLOCK_NUM_SUBTYPES)) {
+        return NULL;
+    }
+    return &inst->tx_stats[subtype];
+}
+
+/**
+ *  Record that a block will not be sent.
+ *
+ *  @param inst The instance in which the statistics are stored
+ *  @param block The block which was dropped
+ */
+static inline void tx_stats_drop(struct radio_transport_desc *inst,
+                                 const uint8_t *block)
+{
+    struct radio_trans_tx_stats *const stats = tx_stats_for(inst, block);
+    if (stats != NULL) {
+        stats->dropped++;
+    }
+}
+
+/**
+ *  Record the transmission of a packet.
+ *
+ *  @param inst The instance in which the statistics are stored
+ *  @param packet The packet which is being transmitted
+ *  @param length The length of the packet
+ */
+static void tx_stats_send(struct radio_transport_desc *inst,
+                          const uint8_t *packet, uint8_t length)
+{
+    for (uint8_t offset = RADIO_PACKET_HEADER_LENGTH; offset < length;
+            offset += radio_block_length(packet + offset)) {
+        struct radio_trans_tx_stats *const stats = tx_stats_for(inst,
+                                                            packet + offset);
+        if (stats != NULL) {
+            stats->sent++;
+        }
+    }
+
+    inst->tx_block_bytes += length - RADIO_PACKET_HEADER_LENGTH;
+    inst->tx_airtime += (radio_lora_airtime(&inst->radio_settings, length) +
+                         500) / 1000;
+}
+
 /**
  *  Start a transmission.
  *
  *  @param inst The instance for which the transmission should be started
+ *  @param tx_radio The radio on which the transmission should be started
+ *  @param channel The channel on which the transmission should be sent
  *  @param buffer The buffer to be transmitted
  *  @param length The number of bytes to be transmitted
+ *
+ *  @return 0 if the transmission was started
  */
-static void start_tx(struct radio_transport_desc *inst, uint8_t *buffer,
-                     uint8_t length)
+static int start_tx(struct radio_transport_desc *inst,
+                    struct radio_instance_desc *tx_radio, uint8_t channel,
+                    uint8_t *buffer, uint8_t length)
 {
     radio_packet_set_number(buffer, inst->packet_number);
-    struct radio_instance_desc *tx_radio = radio_chanmgr_get_tx_radio(inst);
     update_sig_report_radio_nums(buffer, tx_radio->radio_num);
-    inst->tx_radio = &tx_radio->rn2483;
-    const enum rn2483_operation_result result = rn2483_send(inst->tx_radio,
-                                    buffer, length, &inst->tx_transaction_id);
-    if (result == RN2483_OP_SUCCESS) {
-        inst->last_tx_time = millis;
-        inst->packet_number++;
-        inst->tx_state = RADIO_TRANS_TX_IN_PROGRESS;
+    if (tx_radio->antmgr != NULL) {
+        radio_antmgr_prepare_tx(tx_radio);
     }
+    // The frequency must be updated before the send is started so that the
+    // radio driver updates it first
+    radio_chanmgr_tune(tx_radio, channel);
+    const enum rn2483_operation_result result = rn2483_send(&tx_radio->rn2483,
+                                    buffer, length,
+                                    &tx_radio->tx_transaction_id);
+    if (result != RN2483_OP_SUCCESS) {
+        radio_chanmgr_tune(tx_radio, tx_radio->channel);
+        return 1;
+    }
+
+    inst->last_tx_time = millis;
+    inst->packet_number++;
+    inst->tx_state = RADIO_TRANS_TX_IN_PROGRESS;
+    inst->tx_radio = tx_radio;
+    inst->tx_channel = (channel + 1) % LORA_NUM_CHANNELS;
+    tx_radio->last_tx_time = millis;
+    tx_radio->tx_busy = 1;
+    radio_chanmgr_tx_start_cb(inst, tx_radio, buffer);
+    tx_stats_send(inst, buffer, length);
+    if ((inst->fec != NULL) && (buffer != inst->fec_packet_buffer)) {
+        // Add the packet to the current erasure coded group
+        radio_fec_encode_packet(inst, buffer);
+    }
+    return 0;
 }
 
 /**
- *  Remove a contiguous sequence of blocks from the packet buffer.
+ *  Get the time by which a block should be sent.
+ *
+ *  @param blk_info The block for which the deadline should be found
  *
- *  @param inst The instance for which block should be removed
- *  @param first The index of the first block to be removed
- *  @param end The index of the next block after first that should not be
- *             removed
+ *  @return The block's deadline
  */
-static void remove_blocks(struct radio_transport_desc *inst, unsigned int first,
-                          unsigned int end)
-{
-    if ((end > RADIO_BLOCKS_PER_PACKET) ||
-            (inst->buffer_info[end].length == 0)) {
-        // We are going off the end of the array (or at least off the end of
-        // the in use portion of the array). No need to shift anything as there
-        // are no blocks after the one(s) to be removed, we can just mark all
-        // the blocks to be removed as invalid.
-        for (unsigned int i = first; i < RADIO_BLOCKS_PER_PACKET; i++) {
-            inst->buffer_info[i].length = 0;
+static inline uint32_t blk_deadline(
+                                const struct radio_trans_buff_blk_info *blk_info)
+{
+    return blk_info->enqueue_time + blk_info->slack_time;
+}
+
+/**
+ *  Update a packet's deadline to be the earliest deadline of the blocks that it
+ *  contains.
+ *
+ *  @param packet The packet for which the deadline should be updated
+ */
+static void tx_packet_update_deadline(struct radio_trans_tx_packet *packet)
+{
+    for (unsigned int i = 0; i < packet->num_blocks; i++) {
+        const uint32_t deadline = blk_deadline(&packet->blocks[i]);
+        if ((i == 0) || ((int32_t)(deadline - packet->deadline) < 0)) {
+            packet->deadline = deadline;
         }
-        return;
     }
+}
 
-    // All of the blocks from end on need to be shifted down
-    // Find how many bytes need to be shifted down and shift block descriptors
-    uint8_t keep_lenth = 0;
-    unsigned int new_first = first;
-    for (unsigned int i = end; i < RADIO_BLOCKS_PER_PACKET; i++) {
-        if (inst->buffer_info[i].length == 0) {
-            break;
+/**
+ *  Remove any expired blocks from a packet. The remaining blocks are moved down
+ *  to fill the space left by the removed blocks.
+ *
+ *  @param inst The instance to which the packet belongs
+ *  @param packet The packet from which blocks should be culled
+ */
+static void cull_blocks(struct radio_transport_desc *inst,
+                        struct radio_trans_tx_packet *packet)
+{
+    uint8_t length = RADIO_PACKET_HEADER_LENGTH;
+    uint8_t num_kept = 0;
+
+    for (unsigned int i = 0; i < packet->num_blocks; i++) {
+        const struct radio_trans_buff_blk_info blk_info = packet->blocks[i];
+        if ((blk_info.time_to_live != 0) &&
+                ((millis - blk_info.enqueue_time) > blk_info.time_to_live)) {
+            // Block has expired and should be culled
+            tx_stats_drop(inst, packet->buffer + blk_info.offset);
+            continue;
         }
-        keep_lenth += inst->buffer_info[i].length;
 
-        inst->buffer_info[new_first] = inst->buffer_info[i];
-        new_first++;
+        if (blk_info.offset != length) {
+            // Move block down to fill in space left by culled blocks
+            memmove(packet->buffer + length, packet->buffer + blk_info.offset,
+                    blk_info.length);
+        }
 
-        inst->buffer_info[i].length = 0;
+        packet->blocks[num_kept] = blk_info;
+        packet->blocks[num_kept].offset = length;
+        num_kept++;
+        length += blk_info.length;
     }
 
-    // Copy over the blocks in the buffer
-    memmove(inst->packet_buffer + inst->buffer_info[first].offset,
-            inst->packet_buffer + inst->buffer_info[end].offset, keep_lenth);
+    packet->num_blocks = num_kept;
+    radio_packet_set_length(packet->buffer, length);
+    tx_packet_update_deadline(packet);
 }
 
 /**
- *  Remove any expired blocks from the packet buffer.
+ *  Start sending the oldest packet in the transmit queue if it is ready to be
+ *  sent. The oldest packet is ready if it would not finish being transmitted
+ *  before its deadline if we waited any longer, if it has passed the waterline
+ *  or if newer packets have been queued behind it (in which case no more blocks
+ *  will be added to it until it is sent).
  *
- *  @param inst The instance for which blocks should be culled
+ *  @param inst The instance for which a packet should be sent
+ *  @param tx_radio The radio on which the packet should be sent
+ *  @param channel The channel on which the packet should be sent
  */
-static void cull_blocks(struct radio_transport_desc *inst)
+static void send_queued_packet(struct radio_transport_desc *inst,
+                               struct radio_instance_desc *tx_radio,
+                               uint8_t channel)
 {
-    for (unsigned int i = 0; i < RADIO_BLOCKS_PER_PACKET; i++) {
-        const struct radio_trans_buff_blk_info *blk_info =
-                                                        &inst->buffer_info[i];
-        if (!blk_info->length) {
-            break;
+    while (inst->tx_queue_count != 0) {
+        struct radio_trans_tx_packet *const packet = tx_queue_get(inst, 0);
+        const uint8_t length = radio_packet_length(packet->buffer);
+        const uint32_t airtime = radio_lora_airtime(&inst->radio_settings,
+                                                    length) / 1000;
+        const int ready = (((int32_t)((millis + airtime) -
+                                      packet->deadline) > 0) ||
+                           (length > RADIO_PACKET_WATERLINE) ||
+                           (inst->tx_queue_count > 1));
+        if (!ready) {
+            return;
         }
-        if ((millis - blk_info->enqueue_time) > blk_info->time_to_live) {
-            // Block has expired, should be culled
-            // Find the index of the next block that shouldn't be culled, this
-            // way we can remove a section of consecutive blocks all at once if
-            // there is one
-            unsigned int end = i;
-            for (; end < RADIO_BLOCKS_PER_PACKET; end++) {
-                const struct radio_trans_buff_blk_info *bi =
-                                                    &inst->buffer_info[end];
-                if (!bi->length || ((millis - bi->enqueue_time) <=
-                                    bi->time_to_live)) {
-                    // This block is either invalid or hasn't expired, either
-                    // way it shouldn't be shifted
-                    break;
-                }
-            }
-            // Remove the section of blocks
-            remove_blocks(inst, i, end);
 
-            // Decrement i because the next iteration of the loop should use the
-            // same index as this iteration
-            i--;
+        // Cull any blocks that have exceeded their time to live
+        cull_blocks(inst, packet);
+
+        if (packet->num_blocks != 0) {
+            start_tx(inst, tx_radio, channel, packet->buffer,
+                     radio_packet_length(packet->buffer));
+            return;
         }
+
+        // Nothing left to send in this packet, try the next one
+        tx_queue_pop(inst);
     }
 }
 
@@ -307,69 +440,89 @@ void radio_transport_service(struct radio_transport_desc *inst)
     // Run channel manager service
     radio_chanmgr_service(inst);
 
-    // If we have a transmission in progress, check its state
-    if ((inst->tx_state == RADIO_TRANS_TX_IN_PROGRESS) ||
-            (inst->tx_state == RADIO_TRANS_TX_CLEANUP)) {
+    // Run erasure coding service
+    if (inst->fec != NULL) {
+        radio_fec_service(inst);
+    }
+
+    // Check the state of the transmissions in progress on each radio
+    for (unsigned int i = 0; i < RADIO_MAX_NUM_RADIOS; i++) {
+        struct radio_instance_desc *const radio = inst->radios[i];
+        if (radio == NULL) {
+            break;
+        } else if (!radio->tx_busy) {
+            continue;
+        }
+
         const enum rn2483_send_trans_state state = rn2483_get_send_state(
-                                    inst->tx_radio, inst->tx_transaction_id);
+                                    &radio->rn2483, radio->tx_transaction_id);
         const int complete = ((state == RN2483_SEND_TRANS_DONE) ||
                               (state == RN2483_SEND_TRANS_FAILED));
         const int written = complete || (state == RN2483_SEND_TRANS_WRITTEN);
 
-        if ((inst->tx_state == RADIO_TRANS_TX_IN_PROGRESS) && written) {
+        if ((inst->tx_state == RADIO_TRANS_TX_IN_PROGRESS) &&
+                (inst->tx_radio == radio) && written) {
             // The buffer is no longer in use, we are free to start creating
-            // the next packet
-            if (inst->priority_tx_in_progress) {
+            // the next packet and sending it on another radio
+            if (inst->fec_tx_in_progress) {
+                inst->fec_tx_in_progress = 0;
+            } else if (inst->priority_tx_in_progress) {
                 radio_packet_set_length(inst->priority_packet_buffer,
                                         RADIO_PACKET_HEADER_LENGTH);
                 inst->priority_tx_in_progress = 0;
             } else {
-                reset_packet_buffer(inst);
+                tx_queue_pop(inst);
             }
-            inst->tx_state = RADIO_TRANS_TX_CLEANUP;
+            inst->tx_state = RADIO_TRANS_TX_IDLE;
+            // Go back to listening on the radio's own channel once it is done
+            // sending
+            radio_chanmgr_tune(radio, radio->channel);
         }
 
-        if ((inst->tx_state == RADIO_TRANS_TX_CLEANUP) && complete) {
+        if (complete) {
             // This transmission is totally complete now
-            rn2483_clear_send_transaction(inst->tx_radio,
-                                          inst->tx_transaction_id);
-            inst->tx_state = RADIO_TRANS_TX_IDLE;
+            rn2483_clear_send_transaction(&radio->rn2483,
+                                          radio->tx_transaction_id);
+            radio->tx_busy = 0;
+            radio_chanmgr_tx_done_cb(inst, radio,
+                                     state == RN2483_SEND_TRANS_DONE);
         }
     }
 
-    // If we don't have a transmission in progress and the tx backoff time has
-    // expired check if we need to start a new transmission or do packet buffer
-    // housekeeping
+    // If we are not writing a packet to a radio check if we need to start a
+    // new transmission on a radio which is ready to send
     if (inst->tx_state == RADIO_TRANS_TX_IDLE) {
-        // No transmission in progress
-        const int transmit_backoff_expired = (millis - inst->last_tx_time) >
-                                                        RADIO_TX_BACKOFF_TIME;
-        int regular_packet_tx_started = 0;
+        uint8_t channel;
+        struct radio_instance_desc *const tx_radio =
+                                    radio_chanmgr_get_tx_radio(inst, &channel);
+        if (tx_radio == NULL) {
+            return;
+        }
+
+        // Parity for a completed group is sent before anything else so that
+        // the next group does not interrupt it
+        const uint8_t fec_len = ((inst->fec != NULL) ?
+                                 radio_fec_make_parity_packet(inst,
+                                                    inst->fec_packet_buffer) :
+                                 0);
         // Check if we have a priority packet to send now
         const uint8_t priority_len = radio_packet_length(
                                                 inst->priority_packet_buffer);
-        if (transmit_backoff_expired &&
-                (priority_len > RADIO_PACKET_HEADER_LENGTH)) {
+        if (fec_len != 0) {
+            if (!start_tx(inst, tx_radio, channel, inst->fec_packet_buffer,
+                          fec_len)) {
+                inst->fec_tx_in_progress = 1;
+                radio_fec_parity_sent(inst);
+            }
+        } else if (priority_len > RADIO_PACKET_HEADER_LENGTH) {
             // There is data to be sent in the priority buffer
-            start_tx(inst, inst->priority_packet_buffer, priority_len);
-            inst->priority_tx_in_progress = 1;
-        } else if (transmit_backoff_expired) {
-            const uint8_t packet_len = radio_packet_length(inst->packet_buffer);
-            const int packet_has_data = packet_len > RADIO_PACKET_HEADER_LENGTH;
-            // Check if we need to send the buffered packet now
-            if (packet_has_data && (((millis - inst->buffer_slack_time_base) >
-                                     inst->buffer_slack_time) ||
-                                    (packet_len > RADIO_PACKET_WATERLINE))) {
-                // There is data to be sent and slack time has expired or
-                // waterline has been passed.
-                // start sending packet
-                start_tx(inst, inst->packet_buffer, packet_len);
-                regular_packet_tx_started = 1;
+            if (!start_tx(inst, tx_radio, channel,
+                          inst->priority_packet_buffer, priority_len)) {
+                inst->priority_tx_in_progress = 1;
             }
-        }
-        if (!regular_packet_tx_started) {
-            // Cull any blocks that have exceeded their time to live
-            cull_blocks(inst);
+        } else {
+            // Check if the oldest packet in the queue should be sent now
+            send_queued_packet(inst, tx_radio, channel);
         }
     }
 }
@@ -377,110 +530,286 @@ void radio_transport_service(struct radio_transport_desc *inst)
 // MARK: TX
 
 /**
- *  Update the slack time for a packet if the new slack time is shorter.
+ *  Determine whether a packet in the transmit queue has space for a block.
  *
- *  @param base Pointer to the base of the slack time to be updated
- *  @param slack_time Pointer the the slack time to be updated
- *  @param new_base The base of the new slack time
- *  @param new_slack_time The new slack time
- *  @param slack_time_valid Whether the slack time to be updated is valid
+ *  @param inst The instance to which the packet belongs
+ *  @param packet The packet to be checked
+ *  @param block_length The length of the block
+ *
+ *  @return Non-zero if the block can be added to the packet
  */
-static void update_slack_time(uint32_t *base, uint16_t *slack_time,
-                              uint32_t new_base, uint16_t new_slack_time,
-                              uint8_t slack_time_valid)
+static inline int tx_packet_has_space(const struct radio_transport_desc *inst,
+                                      const struct radio_trans_tx_packet *packet,
+                                      uint8_t block_length)
 {
-    if (!slack_time_valid) {
-        *base = new_base;
-        *slack_time = new_slack_time;
+    return ((packet->num_blocks < RADIO_BLOCKS_PER_PACKET) &&
+            ((radio_packet_length(packet->buffer) + block_length) <=
+             inst->max_packet_length));
+}
+
+/**
+ *  Determine whether one block is more important than another. Blocks with a
+ *  higher priority are always more important, blocks with the same priority are
+ *  ordered by deadline.
+ *
+ *  @param a The first block
+ *  @param b The second block
+ *
+ *  @return Non-zero if block a is more important than block b
+ */
+static inline int blk_more_urgent(const struct radio_trans_buff_blk_info *a,
+                                  const struct radio_trans_buff_blk_info *b)
+{
+    if (a->priority != b->priority) {
+        return a->priority > b->priority;
     }
+    return (int32_t)(blk_deadline(a) - blk_deadline(b)) < 0;
+}
 
-    uint32_t low_base = *base;
-    uint16_t low_slack_time = *slack_time;
-    uint32_t high_base = new_base;
-    uint16_t high_slack_time = new_slack_time;
+/**
+ *  Add a block to the end of a packet. The packet must have space for the
+ *  block.
+ *
+ *  @param packet The packet to which the block should be added
+ *  @param blk_info Information about the block, the offset is ignored
+ *  @param block The block data
+ */
+static void tx_packet_append(struct radio_trans_tx_packet *packet,
+                             const struct radio_trans_buff_blk_info *blk_info,
+                             const uint8_t *block)
+{
+    struct radio_trans_buff_blk_info *const block_desc =
+                                            &packet->blocks[packet->num_blocks];
+    *block_desc = *blk_info;
+    block_desc->offset = radio_packet_length(packet->buffer);
+
+    // Update the packet's deadline if this block needs to be sent sooner
+    const uint32_t deadline = blk_deadline(blk_info);
+    if ((packet->num_blocks == 0) ||
+            ((int32_t)(deadline - packet->deadline) < 0)) {
+        packet->deadline = deadline;
+    }
+    packet->num_blocks++;
+
+    // Copy block data into packet and update packet length
+    memcpy(packet->buffer + block_desc->offset, block, blk_info->length);
+    radio_packet_set_length(packet->buffer,
+                            block_desc->offset + blk_info->length);
+}
+
+/**
+ *  Remove a block from a packet. The following blocks are moved down to fill
+ *  the space left by the removed block.
+ *
+ *  @param packet The packet from which the block should be removed
+ *  @param index The index of the block to be removed
+ */
+static void tx_packet_remove(struct radio_trans_tx_packet *packet,
+                             uint8_t index)
+{
+    const struct radio_trans_buff_blk_info removed = packet->blocks[index];
+    const uint8_t length = radio_packet_length(packet->buffer);
+    const uint8_t end = removed.offset + removed.length;
+
+    memmove(packet->buffer + removed.offset, packet->buffer + end,
+            length - end);
 
-    if (*base > new_base) {
-        low_base = new_base;
-        low_slack_time = new_slack_time;
-        high_base = *base;
-        high_slack_time = *slack_time;
+    for (unsigned int i = index + 1; i < packet->num_blocks; i++) {
+        packet->blocks[i - 1] = packet->blocks[i];
+        packet->blocks[i - 1].offset -= removed.length;
     }
 
-    uint32_t base_diff = high_base - low_base;
+    packet->num_blocks--;
+    radio_packet_set_length(packet->buffer, length - removed.length);
+    tx_packet_update_deadline(packet);
+}
 
-    if (((uint32_t)high_slack_time + base_diff) < low_slack_time) {
-        *base = high_base;
-        *slack_time = high_slack_time;
-    } else {
-        *base = low_base;
-        *slack_time = low_slack_time;
+/**
+ *  Find the least important block in a packet which could be removed to make
+ *  space for a more important block.
+ *
+ *  @param inst The instance to which the packet belongs
+ *  @param packet The packet in which a block should be found
+ *  @param blk_info Information about the block for which space is needed
+ *
+ *  @return The index of the block to be removed or -1 if there is no block in
+ *          the packet which is less important than the new block and which
+ *          would make enough space for it
+ */
+static int tx_packet_find_victim(const struct radio_transport_desc *inst,
+                                 const struct radio_trans_tx_packet *packet,
+                                 const struct radio_trans_buff_blk_info *blk_info)
+{
+    // A packet can be longer than the current limit if it was formed before
+    // the limit was lowered
+    const int16_t free_bytes = ((int16_t)inst->max_packet_length -
+                                radio_packet_length(packet->buffer));
+    int victim = -1;
+
+    for (int i = 0; i < packet->num_blocks; i++) {
+        const struct radio_trans_buff_blk_info *const blk = &packet->blocks[i];
+        if (!blk_more_urgent(blk_info, blk) ||
+                ((free_bytes + blk->length) < blk_info->length)) {
+            continue;
+        }
+        if ((victim < 0) || blk_more_urgent(&packet->blocks[victim], blk)) {
+            victim = i;
+        }
     }
+
+    return victim;
 }
 
-int radio_send_block(struct radio_transport_desc *inst, const uint8_t *block,
-                     uint8_t block_length, uint16_t slack_time,
-                     uint16_t time_to_live)
-{
-    // Find the index of the next free block descriptor
-    struct radio_trans_buff_blk_info *block_desc = NULL;
-    struct radio_trans_buff_blk_info *prev_block_desc = NULL;
-    for (unsigned int i = 0; i < RADIO_BLOCKS_PER_PACKET; i++) {
-        if (inst->buffer_info[i].length == 0) {
-            block_desc = &inst->buffer_info[i];
-            break;
+/**
+ *  Get a packet from the transmit queue which can have blocks added to it. If
+ *  the position is one past the newest packet in the queue, a new empty packet
+ *  is added to the queue.
+ *
+ *  @param inst The instance from which the packet should be gotten
+ *  @param n The position of the packet in the queue
+ *
+ *  @return The packet or NULL if there is no packet at the given position
+ */
+static struct radio_trans_tx_packet *tx_queue_get_open(
+                                            struct radio_transport_desc *inst,
+                                            uint8_t n)
+{
+    if (n >= RADIO_TX_QUEUE_LENGTH) {
+        return NULL;
+    } else if (n < inst->tx_queue_count) {
+        return tx_queue_get(inst, n);
+    }
+
+    struct radio_trans_tx_packet *const packet = tx_queue_get(inst,
+                                                        inst->tx_queue_count);
+    packet->num_blocks = 0;
+    radio_packet_set_length(packet->buffer, RADIO_PACKET_HEADER_LENGTH);
+    inst->tx_queue_count++;
+    return packet;
+}
+
+/**
+ *  Get the position of the oldest packet in the transmit queue which is not
+ *  being transmitted.
+ *
+ *  @param inst The instance for which the position should be found
+ *
+ *  @return The position of the first packet which blocks can be added to
+ */
+static inline uint8_t tx_queue_first_open(struct radio_transport_desc *inst)
+{
+    return ((inst->tx_queue_count != 0) && tx_queue_head_in_flight(inst)) ?
+                1 : 0;
+}
+
+/**
+ *  Add a block to the oldest packet, starting from a given position in the
+ *  transmit queue, that has space for it.
+ *
+ *  @param inst The instance to which the block should be added
+ *  @param n The position in the queue from which to start looking for space
+ *  @param blk_info Information about the block
+ *  @param block The block data
+ *
+ *  @return Zero if the block was added, non-zero if there was no space
+ */
+static int tx_queue_place(struct radio_transport_desc *inst, uint8_t n,
+                          const struct radio_trans_buff_blk_info *blk_info,
+                          const uint8_t *block)
+{
+    struct radio_trans_tx_packet *packet;
+    for (; (packet = tx_queue_get_open(inst, n)) != NULL; n++) {
+        if (!tx_packet_has_space(inst, packet, blk_info->length)) {
+            // Make space by getting rid of any expired blocks
+            cull_blocks(inst, packet);
+        }
+        if (tx_packet_has_space(inst, packet, blk_info->length)) {
+            tx_packet_append(packet, blk_info, block);
+            return 0;
         }
-        prev_block_desc = &inst->buffer_info[i];
     }
+    return 1;
+}
 
-    if (block_desc == NULL) {
-        // There are no free block descriptors in the packet buffer
-        return 1;
+/**
+ *  Add a block to the transmit queue. The block is placed in the oldest packet
+ *  which has space for it. If a packet does not have space but contains a less
+ *  important block, that block is moved to a later packet (or dropped if there
+ *  is no space for it) to make room.
+ *
+ *  @param inst The instance to which the block should be added
+ *  @param blk_info Information about the block
+ *  @param block The block data
+ *
+ *  @return Zero if the block was added, non-zero if there was no space
+ */
+static int tx_queue_insert(struct radio_transport_desc *inst,
+                           const struct radio_trans_buff_blk_info *blk_info,
+                           const uint8_t *block)
+{
+    struct radio_trans_tx_packet *packet;
+    for (uint8_t n = tx_queue_first_open(inst);
+            (packet = tx_queue_get_open(inst, n)) != NULL; n++) {
+        if (!tx_packet_has_space(inst, packet, blk_info->length)) {
+            // Make space by getting rid of any expired blocks
+            cull_blocks(inst, packet);
+        }
+        if (tx_packet_has_space(inst, packet, blk_info->length)) {
+            tx_packet_append(packet, blk_info, block);
+            return 0;
+        }
+
+        // Try to make space by moving a less important block back
+        const int victim = tx_packet_find_victim(inst, packet, blk_info);
+        if (victim < 0) {
+            continue;
+        }
+
+        const struct radio_trans_buff_blk_info *const victim_info =
+                                                    &packet->blocks[victim];
+        const uint8_t *const victim_block = packet->buffer +
+                                                        victim_info->offset;
+        if (tx_queue_place(inst, n + 1, victim_info, victim_block)) {
+            // There is nowhere else for the less important block to go
+            tx_stats_drop(inst, victim_block);
+        }
+        tx_packet_remove(packet, victim);
+        tx_packet_append(packet, blk_info, block);
+        return 0;
     }
+    return 1;
+}
 
-    // Find the offset where the block should be placed in the buffer
-    if (prev_block_desc == NULL) {
-        // This is the first block in the buffer, it goes right after the header
-        block_desc->offset = radio_packet_length(inst->packet_buffer);
-    } else {
-        // This block goes after the previous one
-        block_desc->offset = prev_block_desc->offset + prev_block_desc->length;
+int radio_send_block(struct radio_transport_desc *inst, const uint8_t *block,
+                     uint8_t block_length, uint16_t slack_time,
+                     uint16_t time_to_live, enum radio_block_priority priority)
+{
+    struct radio_trans_tx_stats *const stats = tx_stats_for(inst, block);
+    if (stats != NULL) {
+        stats->requested++;
     }
 
-    // Check that there is enough space in the  buffer for the packet
-    const uint8_t new_buffer_len = block_desc->offset + block_length;
-    if (new_buffer_len > RADIO_MAX_PACKET_SIZE) {
-        // There is not enough space in the buffer to queue the block
+    if ((RADIO_PACKET_HEADER_LENGTH + block_length) > inst->max_packet_length) {
+        // This block could never fit in a packet
+        tx_stats_drop(inst, block);
         return 1;
     }
 
     // Setup our block descriptor
-    block_desc->enqueue_time = millis;
-    block_desc->time_to_live = time_to_live;
-    block_desc->length = block_length;
-
-    // Check if we need to prebuffer this packet because a tx is ongoing
-    block_desc->prebuffered = (!inst->priority_tx_in_progress &&
-                               (inst->tx_state != RADIO_TRANS_TX_IDLE) &&
-                               (inst->tx_state != RADIO_TRANS_TX_CLEANUP));
-
-    // Update the buffered packet's slack time and update packet length if
-    // needed
-    if (block_desc->prebuffered) {
-        update_slack_time(&inst->prebuffer_slack_time_base,
-                          &inst->prebuffer_slack_time, block_desc->enqueue_time,
-                          slack_time, inst->prebuffer_slack_time_valid);
-        inst->prebuffer_slack_time_valid = 1;
-    } else {
-        update_slack_time(&inst->buffer_slack_time_base,
-                          &inst->buffer_slack_time, block_desc->enqueue_time,
-                          slack_time, inst->buffer_slack_time_valid);
-        inst->buffer_slack_time_valid = 1;
-        radio_packet_set_length(inst->packet_buffer, new_buffer_len);
+    const struct radio_trans_buff_blk_info blk_info = {
+        .enqueue_time = millis,
+        .time_to_live = time_to_live,
+        .slack_time = slack_time,
+        .length = block_length,
+        .priority = priority
+    };
+
+    if (tx_queue_insert(inst, &blk_info, block)) {
+        // There is no space in the transmit queue for the block
+        tx_stats_drop(inst, block);
+        return 1;
     }
 
-    // Copy block data into buffer
-    memcpy(inst->packet_buffer + block_desc->offset, block, block_length);
-
     // Run the service function to start sending right away if possible
     radio_transport_service(inst);
 
@@ -515,6 +844,37 @@ int radio_send_block_priority(struct radio_transport_desc *inst,
     return 0;
 }
 
+uint32_t radio_lora_airtime(const struct rn2483_lora_settings_t *settings,
+                            uint8_t length)
+{
+    // Time on air calculation from the Semtech SX1272/73 datasheet (section
+    // 4.1.1.7) with an explicit header
+    const int32_t sf = settings->spreading_factor + 7;
+    // The symbol time is 2^SF / BW, with BW in MHz to get microseconds
+    const uint32_t t_sym = (UINT32_C(1) << sf) * (8 >> settings->bandwidth);
+    // Low data rate optimization is used when the symbol time exceeds 16 ms
+    const int32_t de = t_sym > 16000;
+    const int32_t cr = settings->coding_rate + 1;
+
+    const int32_t num = ((8 * (int32_t)length) - (4 * sf) + 28 +
+                         (16 * settings->crc));
+    const int32_t den = 4 * (sf - (2 * de));
+    const int32_t payload_groups = (num > 0) ? ((num + den - 1) / den) : 0;
+    const uint32_t payload_symbols = 8 + (payload_groups * (cr + 4));
+
+    // The preamble is followed by 4.25 symbols of sync word
+    return (((settings->preamble_length + payload_symbols) * t_sym) +
+            ((17 * t_sym) / 4));
+}
+
+void radio_reset_tx_stats(struct radio_transport_desc *inst)
+{
+    memset(inst->tx_stats, 0, sizeof(inst->tx_stats));
+    inst->tx_stats_start_time = millis;
+    inst->tx_airtime = 0;
+    inst->tx_block_bytes = 0;
+}
+
 
 // MARK: RX
 
@@ -623,6 +983,7 @@ static inline int8_t calc_tx_loss(int8_t tx_power, int8_t remote_rssi)
  *  @param inst The radio transport instance
  *  @param radio The radio instance on which the block was received
  *  @param antenna_num The number of the antenna that the block was received on
+ *  @param packet The packet which contains the block
  *  @param block The control block to be handled
  *  @param source The source address of the packet
  *  @param is_duplicate Whether this block is from a duplicate packet
@@ -631,7 +992,8 @@ static inline int8_t calc_tx_loss(int8_t tx_power, int8_t remote_rssi)
  */
 static inline void handle_control(struct radio_transport_desc *inst,
                                   struct radio_instance_desc *radio,
-                                  uint8_t antenna_num, const uint8_t *block,
+                                  uint8_t antenna_num, const uint8_t *packet,
+                                  const uint8_t *block,
                                   enum radio_packet_device_address source,
                                   int is_duplicate, int8_t snr, int8_t rssi)
 {
@@ -670,7 +1032,7 @@ static inline void handle_control(struct radio_transport_desc *inst,
                 radio_block_marshal_sig_report(report, snr, rssi, tx_radio_num,
                                                inst->radio_settings.power, 0);
                 radio_send_block(inst, report, RADIO_BLOCK_SIG_REPORT_LENGHT,
-                                 250, 0);
+                                 250, 0, RADIO_BLOCK_PRIORITY_HIGH);
             } else {
                 /* This is a reply */
                 // Identify tx radio
@@ -681,7 +1043,7 @@ static inline void handle_control(struct radio_transport_desc *inst,
                     return;
                 }
                 // Identify TX antenna
-                uint8_t tx_antenna = radio_antmgr_get_current_antenna(tx_radio);
+                uint8_t tx_antenna = radio_antmgr_get_tx_antenna(tx_radio);
                 // Calculate TX power loss
                 int8_t tx_loss = calc_tx_loss(inst->radio_settings.power,
                                               remote_rssi);
@@ -694,6 +1056,19 @@ static inline void handle_control(struct radio_transport_desc *inst,
                 }
             }
             break;
+        case RADIO_CONTROL_BLOCK_LINK_PROFILE:
+            radio_chanmgr_link_profile_cb(inst, block, source);
+            break;
+        case RADIO_CONTROL_BLOCK_FEC_CONFIG:
+            if (inst->fec != NULL) {
+                radio_fec_config_cb(inst, block, source);
+            }
+            break;
+        case RADIO_CONTROL_BLOCK_FEC_PARITY:
+            if (inst->fec != NULL) {
+                radio_fec_parity_cb(inst, radio, packet, block);
+            }
+            break;
         case RADIO_CONTROL_BLOCK_CMD_ACK:
             break;
         case RADIO_CONTROL_BLOCK_CMD_NONCE_REQ:
@@ -734,6 +1109,71 @@ static inline void handle_block(struct radio_transport_desc *inst,
     }
 }
 
+/**
+ *  Check whether a packet has already been received and record its
+ *  deduplication code if it has not.
+ *
+ *  @param inst The radio transport instance
+ *  @param packet The received packet
+ *
+ *  @return Non-zero if the packet is a duplicate
+ */
+static int check_duplicate(struct radio_transport_desc *inst,
+                           const uint8_t *packet)
+{
+    uint16_t dedup_code = radio_packet_deduplication_code(packet);
+    for (int i = 0; ((inst->dedup_codes_full &&
+                      (i < RADIO_DEDUPLICATION_LIST_LENGTH)) ||
+                     (i < inst->dedup_code_position)); i++) {
+        if (dedup_code == inst->rx_deduplication_codes[i]) {
+            // This packet is a duplicate
+            return 1;
+        }
+    }
+
+    // Record deduplication code
+    inst->rx_deduplication_codes[inst->dedup_code_position] = dedup_code;
+    inst->dedup_code_position++;
+    inst->dedup_codes_full |= (inst->dedup_code_position == 0);
+    return 0;
+}
+
+void radio_handle_recovered_packet(struct radio_transport_desc *inst,
+                                   struct radio_instance_desc *radio,
+                                   const uint8_t *packet)
+{
+    if (check_duplicate(inst, packet)) {
+        // The packet arrived after all
+        return;
+    }
+
+    const uint8_t length = radio_packet_length(packet);
+
+    // There is no signal information for a packet which was not received
+    if (inst->ground_callback != NULL) {
+        inst->ground_callback(packet, length, radio->radio_num, 0, 0, 0, 1);
+    }
+
+    const uint8_t *block = radio_packet_fist_block(packet);
+    for (; block != NULL; block = radio_packet_next_block(packet, block)) {
+        if (!radio_block_sanity_check(packet, block)) {
+            // Block is not valid
+            continue;
+        }
+        enum radio_packet_device_address address = radio_block_dest_addr(block);
+        if ((address != inst->address) &&
+            (address != RADIO_DEVICE_ADDRESS_MULTICAST)) {
+            // Block is not for us
+            continue;
+        }
+
+        // Control blocks are skipped, they describe a transmission which never
+        // arrived and any request they carry has since been repeated
+        if (radio_block_type(block) != RADIO_BLOCK_TYPE_CONTROL) {
+            handle_block(inst, block);
+        }
+    }
+}
 
 static int radio_rx_callback(struct rn2483_desc_t *rn2483, void *context,
                              uint8_t *data, uint8_t length, int8_t snr,
@@ -792,23 +1232,11 @@ static int radio_rx_callback(struct rn2483_desc_t *rn2483, void *context,
     }
 
     // Check deduplication code
-    int is_duplicate = 0;
-    uint16_t dedup_code = radio_packet_deduplication_code(data);
-    for (int i = 0; ((inst->dedup_codes_full &&
-                      (i < RADIO_DEDUPLICATION_LIST_LENGTH)) ||
-                     (i < inst->dedup_code_position)); i++) {
-        if (dedup_code == inst->rx_deduplication_codes[i]) {
-            // This packet is a duplicate
-            is_duplicate = 1;
-            break;
-        }
-    }
+    const int is_duplicate = check_duplicate(inst, data);
 
-    // Record deduplication code
-    if (!is_duplicate) {
-        inst->rx_deduplication_codes[inst->dedup_code_position] = dedup_code;
-        inst->dedup_code_position++;
-        inst->dedup_codes_full |= (inst->dedup_code_position == 0);
+    // Keep the packet in case it is needed to rebuild a lost packet
+    if ((inst->fec != NULL) && !is_duplicate) {
+        radio_fec_decode_packet(inst, radio, data);
     }
 
     // Handle blocks
@@ -826,7 +1254,7 @@ static int radio_rx_callback(struct rn2483_desc_t *rn2483, void *context,
         }
 
         if (radio_block_type(block) == RADIO_BLOCK_TYPE_CONTROL) {
-            handle_control(inst, radio, antenna_num, block,
+            handle_control(inst, radio, antenna_num, data, block,
                            radio_packet_src_addr(data), is_duplicate, snr,
                            rssi);
         } else if (!is_duplicate) {
@@ -16,6 +16,7 @@
 #include "radio-types.h"
 #include "radio-chanmgr.h"
 #include "radio-antmgr.h"
+#include "radio-fec.h"
 
 
 #define RADIO_FIXED_ANTENNA_VAL(ant) (1 & (ant << 1))
@@ -31,6 +32,7 @@
  *  @param radio_uarts Array of pointers to sercom_uart descriptors for uarts
  *                     to which radios are connected
  *  @param radio_antennas Array of descriptions antenna configurations
+ *  @param fec Erasure coding state, NULL if erasure coding should not be used
  *  @param search_role The role that this radio should take when falling back
  *                     into search mode
  *  @param address The device address that should be used when sending packets
@@ -40,6 +42,7 @@ extern void init_radio_transport(struct radio_transport_desc *inst,
                                  struct radio_instance_desc *const *radios,
                                  struct sercom_uart_desc_t *const *radio_uarts,
                                  const struct radio_antenna_info *radio_antennas,
+                                 struct radio_fec_desc *fec,
                                  enum radio_search_role search_role,
                                  enum radio_packet_device_address address);
 
@@ -55,6 +58,12 @@ extern void radio_transport_service(struct radio_transport_desc *inst);
 /**
  *  Send a block.
  *
+ *  Blocks are packed into the oldest queued packet which has space for them so
+ *  that blocks with close deadlines go out in the earliest possible
+ *  transmission. If there is no space in the queue for a block, a less
+ *  important block (lower priority, or equal priority and a later deadline)
+ *  may be moved to a later packet, or dropped, to make room.
+ *
  *  @param inst Radio transport instance
  *  @param block The block to be sent
  *  @param block_length Number of bytes to be sent
@@ -63,13 +72,15 @@ extern void radio_transport_service(struct radio_transport_desc *inst);
  *  @param time_to_live The amount of time before the block is no longer valid
  *                      and should not be sent, zero if the block should be sent
  *                      under any circumstance
+ *  @param priority The scheduling priority of the block
  *
  *  @return Zero if the block was queued for transmission, a non-zero value if
  *          the block could not be queued and will not be sent
  */
 extern int radio_send_block(struct radio_transport_desc *inst,
                             const uint8_t *block, uint8_t block_length,
-                            uint16_t slack_time, uint16_t time_to_live);
+                            uint16_t slack_time, uint16_t time_to_live,
+                            enum radio_block_priority priority);
 
 /**
  *  Send a block using the priority queue. Blocks queued on the priority queue
@@ -89,6 +100,38 @@ extern int radio_send_block_priority(struct radio_transport_desc *inst,
                                      const uint8_t *block,
                                      uint8_t block_length);
 
+/**
+ *  Calculate the time that it will take to transmit a LoRa packet with the
+ *  given settings.
+ *
+ *  @param settings The LoRa radio settings to be used for the transmission
+ *  @param length The number of bytes in the packet
+ *
+ *  @return The time on air for the packet in microseconds
+ */
+extern uint32_t radio_lora_airtime(const struct rn2483_lora_settings_t *settings,
+                                   uint8_t length);
+
+/**
+ *  Reset the transmit statistics for a radio transport.
+ *
+ *  @param inst Radio transport instance
+ */
+extern void radio_reset_tx_stats(struct radio_transport_desc *inst);
+
+/**
+ *  Handle a packet which was lost and has been rebuilt from erasure coding
+ *  parity. The packet is passed to the ground station callback and its command
+ *  and data blocks are handled as if it had been received.
+ *
+ *  @param inst Radio transport instance
+ *  @param radio The radio on which the parity for the packet was received
+ *  @param packet The rebuilt packet
+ */
+extern void radio_handle_recovered_packet(struct radio_transport_desc *inst,
+                                          struct radio_instance_desc *radio,
+                                          const uint8_t *packet);
+
 /**
  *  Set a callback function to be called whenever a packet is received.
  *
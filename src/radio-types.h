@@ -21,11 +21,15 @@
 
 /** Maximum number of blocks to be queued in a single packet */
 #define RADIO_BLOCKS_PER_PACKET     8
+/** Number of packets which can be queued for transmission (including the
+    packet currently being transmitted) */
+#define RADIO_TX_QUEUE_LENGTH       3
 /** Length of priority buffer */
 #define RADIO_PRIORITY_BUF_LENGTH   16
 
-/** Number of deduplication code to be stored */
-#define RADIO_DEDUPLICATION_LIST_LENGTH 4
+/** Number of deduplication code to be stored, enough for a packet to be heard
+    by several radios while packets on other channels are also arriving */
+#define RADIO_DEDUPLICATION_LIST_LENGTH 8
 
 //  MARK: Helpers
 /**
@@ -49,7 +53,11 @@ static inline uint8_t update_moving_average(int8_t *average, int8_t new_value,
 {
     const uint8_t new_count = count + 1;
     const uint8_t num = (new_count >= factor) ? factor : new_count;
-    *average += ((new_value - *average) + (num / 2)) / num;
+    // Round away from zero so that the average can reach the new value from
+    // either direction
+    const int16_t diff = new_value - *average;
+    const int16_t half = (diff < 0) ? -(num / 2) : (num / 2);
+    *average += (diff + half) / num;
     return (count < factor) ? new_count : count;
 }
 
@@ -84,8 +92,36 @@ struct radio_antmgr_desc {
     /** The counts for the number of samples in the weighted average for each
         antenna's TX power loss */
     uint8_t tx_power_loss_counts;
+    /** A weighted average of the RSSI of packets received on each antenna */
+    int8_t avg_rssi[RADIO_MAX_NUM_ANTENNAS];
+    /** The counts for the number of samples in the weighted average for each
+        antenna's RSSI */
+    uint8_t rssi_counts;
+    /** The number of packets received on each antenna */
+    uint16_t rx_packets[RADIO_MAX_NUM_ANTENNAS];
+    /** The last time at which a packet was received on each antenna */
+    uint32_t last_rx_time[RADIO_MAX_NUM_ANTENNAS];
+    /** The last time at which a packet was received on any antenna */
+    uint32_t last_any_rx_time;
+    /** The time at which the current probe started or the last probe
+        ended */
+    uint32_t probe_time;
+    /** The number of times the selected antenna has changed */
+    uint16_t num_switches;
+    /** The number of times an alternate antenna has been probed */
+    uint16_t num_probes;
     /** A mask that indicates which antennas are in use */
     uint8_t antenna_mask:RADIO_MAX_NUM_ANTENNAS;
+    /** The antenna that is believed to be best */
+    uint8_t best_antenna:3;
+    /** The antenna used for the most recent transmission */
+    uint8_t tx_antenna:3;
+    /** The antenna being probed or the antenna that was probed last */
+    uint8_t probe_antenna:3;
+    /** The number of packets received on the antenna being probed */
+    uint8_t probe_packets:2;
+    /** Set while an alternate antenna is being probed */
+    uint8_t probing:1;
 };
 
 /**
@@ -123,6 +159,15 @@ struct radio_instance_desc {
         not require dynamic antenna selection */
     struct radio_antmgr_desc *antmgr;
 
+    /** Settings for this radio, the same as the radio transport's settings
+        except for the frequency of the channel that the radio is tuned to */
+    struct rn2483_lora_settings_t settings;
+    /** The last time at which a packet was sent on this radio */
+    uint32_t last_tx_time;
+    /** The radio driver transaction id for the transmission in progress on
+        this radio */
+    uint8_t tx_transaction_id;
+
     /** A weighted average of the power loss experienced by received packets */
     int8_t avg_rx_power_loss;
     /** A weighted average of the power loss experienced by transmitted
@@ -140,12 +185,186 @@ struct radio_instance_desc {
     /** User facing number for this radio (this is radio number from the
         configuration file) */
     uint8_t radio_num:2;
-    
+    /** Channel that this radio listens on */
+    uint8_t channel:2;
+    /** Indicates whether there is a transmission in progress on this radio */
+    uint8_t tx_busy:1;
+    /** Set while the transmission in progress on this radio carries the
+        acknowledgement for a pending link profile change */
+    uint8_t tx_link_ack:1;
+};
+
+
+//  MARK: Channel Manager
+
+/**
+ *  State of the channel manager's control of the link profile (spreading
+ *  factor, coding rate and bandwidth). The ground station decides when the
+ *  profile should change and the rocket follows.
+ */
+struct radio_chanmgr_link {
+    /** Time at which the link profile was last changed */
+    uint32_t change_time;
+    /** Time at which the margin first became high enough to step to a faster
+        profile, only valid if step_up_pending is set */
+    uint32_t step_up_time;
+    /** Time at which a change request was last sent by the ground station */
+    uint32_t pending_time;
+
+    /** Weighted average of the SNR of packets received from the other
+        device */
+    int8_t avg_local_snr;
+    /** Weighted average of the SNR that the other device reports for our
+        packets */
+    int8_t avg_remote_snr;
+    /** Number of samples in the local SNR average */
+    uint8_t local_snr_count:3;
+    /** Number of samples in the remote SNR average */
+    uint8_t remote_snr_count:3;
+    /** Set when a new SNR sample has not yet been evaluated */
+    uint8_t new_sample:1;
+    /** Set when the margin is high enough to step to a faster profile */
+    uint8_t step_up_pending:1;
+
+    /** Index of the link profile in use */
+    uint8_t profile;
+    /** Index of the link profile being changed to */
+    uint8_t pending_profile;
+    /** Sequence number of the most recent change */
+    uint8_t seq;
+    /** Number of times the pending change request has been sent */
+    uint8_t tries:4;
+    /** Set while a change is waiting to be acknowledged by the rocket or for
+        the rocket's acknowledgement to be sent */
+    uint8_t pending:1;
+    /** Set from when a signal report request is sent until a reply is
+        received */
+    uint8_t report_pending:1;
+    /** Number of profile changes since startup */
+    uint16_t num_changes;
+};
+
+
+//  MARK: Erasure Coding
+
+/** Maximum number of data packets in an erasure coded group */
+#define RADIO_FEC_MAX_DATA_PACKETS      8
+/** Maximum number of parity packets sent after an erasure coded group */
+#define RADIO_FEC_MAX_PARITY_PACKETS    4
+/** Longest packet that is sent while erasure coding is in use, chosen so that
+    a parity packet for a group of the longest packets still fits in a single
+    transmission */
+#define RADIO_FEC_MAX_PACKET_LENGTH     112
+/** Length of the longest coded symbol. A symbol is a length byte followed by
+    the blocks from a packet, padded with zeros to a multiple of 4 bytes. */
+#define RADIO_FEC_MAX_SYMBOL_LENGTH     104
+/** Number of received packets which are kept so that lost packets can be
+    rebuilt, must be a power of two */
+#define RADIO_FEC_WINDOW                16
+
+/**
+ *  State of the erasure encoder. Parity symbols are accumulated as each packet
+ *  in a group is sent and are sent once the group is complete.
+ */
+struct radio_fec_encoder {
+    /** Parity symbols for the current group */
+    uint8_t parity[RADIO_FEC_MAX_PARITY_PACKETS][RADIO_FEC_MAX_SYMBOL_LENGTH];
+    /** Packet number of the first packet in the current group */
+    uint16_t first;
+    /** Number of packets that have been added to the current group */
+    uint8_t count;
+    /** Length of the longest symbol in the current group */
+    uint8_t symbol_length;
+    /** Number of parity packets sent for the current group */
+    uint8_t parity_sent;
+};
+
+/**
+ *  State of the erasure decoder. Recently received packets are kept by packet
+ *  number so that they are available when the parity for their group arrives.
+ */
+struct radio_fec_decoder {
+    /** Symbols for recently received packets, indexed by packet number */
+    uint8_t symbols[RADIO_FEC_WINDOW][RADIO_FEC_MAX_SYMBOL_LENGTH];
+    /** Parity symbols received for the current group */
+    uint8_t parity[RADIO_FEC_MAX_PARITY_PACKETS][RADIO_FEC_MAX_SYMBOL_LENGTH];
+    /** Header of the most recent parity packet, used to rebuild the headers of
+        recovered packets */
+    uint8_t header[RADIO_PACKET_HEADER_LENGTH];
+    /** Packet number of the symbol in each slot */
+    uint16_t numbers[RADIO_FEC_WINDOW];
+    /** Mask of slots which hold a symbol */
+    uint16_t valid;
+    /** Packet number of the first packet in the current group */
+    uint16_t first;
+    /** Number of data packets in the current group */
+    uint8_t data_packets;
+    /** Number of parity packets sent for the current group */
+    uint8_t parity_packets;
+    /** Length of the symbols in the current group */
+    uint8_t symbol_length;
+    /** Mask of parity symbols that have been received for the current group */
+    uint8_t parity_mask:RADIO_FEC_MAX_PARITY_PACKETS;
+    /** Set once parity has been received for the current group */
+    uint8_t active:1;
+    /** Set once every packet in the current group is accounted for */
+    uint8_t done:1;
+};
+
+/**
+ *  State of packet level erasure coding. The ground station decides how much
+ *  parity it wants and the rocket sends it.
+ */
+struct radio_fec_desc {
+    union {
+        /** Encoder state, used by the rocket */
+        struct radio_fec_encoder encoder;
+        /** Decoder state, used by the ground station */
+        struct radio_fec_decoder decoder;
+    };
+
+    /** Time at which a configuration request was last sent or given up on */
+    uint32_t request_time;
+    /** Number of groups which have been completed */
+    uint32_t num_groups;
+    /** Number of lost packets which have been rebuilt */
+    uint32_t num_recovered;
+    /** Number of lost packets which could not be rebuilt */
+    uint32_t num_unrecoverable;
+    /** Number of packets received since the last parity packet */
+    uint16_t packets_since_parity;
+
+    /** Number of data packets in each group */
+    uint8_t data_packets;
+    /** Number of parity packets sent after each group, zero if erasure coding
+        is off */
+    uint8_t parity_packets;
+    /** Sequence number of the most recent configuration change */
+    uint8_t seq;
+    /** Number of times the pending configuration request has been sent */
+    uint8_t tries:4;
+    /** Set while a configuration request is waiting to be acknowledged */
+    uint8_t pending:1;
+    /** Set once the other device has acknowledged the configuration */
+    uint8_t confirmed:1;
 };
 
 
 //  MARK: Per Transport Instance Data
 
+/**
+ *  Priority with which a block should be scheduled. When the transmit queue is
+ *  full, more important blocks are placed ahead of less important ones.
+ */
+enum radio_block_priority {
+    /** Block may be delayed or dropped to make room for other blocks */
+    RADIO_BLOCK_PRIORITY_LOW,
+    /** Default priority */
+    RADIO_BLOCK_PRIORITY_NORMAL,
+    /** Block should be sent ahead of all other blocks */
+    RADIO_BLOCK_PRIORITY_HIGH
+};
+
 /** Information about a block in the radio transport buffer. */
 struct radio_trans_buff_blk_info {
     /** The time at which the block was added to the queue */
@@ -153,24 +372,49 @@ struct radio_trans_buff_blk_info {
     /** The number of milliseconds the block can sit in the buffer before it is
         stale and should no longer be sent */
     uint16_t time_to_live;
+    /** The number of milliseconds after the enqueue time by which the block
+        should be sent */
+    uint16_t slack_time;
     /** The offset of the block data in the buffer */
     uint8_t offset;
     /** The size of the block in the buffer */
-    uint8_t length:7;
-    /** Indicates whether this block has been stored in the buffer while the
-        previous packet was still in the process of being sent */
-    uint8_t prebuffered:1;
+    uint8_t length;
+    /** The scheduling priority of the block */
+    enum radio_block_priority priority:2;
+};
+
+/** Transmit statistics for a data block subtype. */
+struct radio_trans_tx_stats {
+    /** Number of blocks which have been submitted for transmission */
+    uint32_t requested;
+    /** Number of blocks which have been transmitted */
+    uint32_t sent;
+    /** Number of blocks which could not be queued or which expired before
+        they could be sent */
+    uint32_t dropped;
 };
 
-/** State of the radio transports transmit capability. */
+/** A packet in the radio transport transmit queue. */
+struct radio_trans_tx_packet {
+    /** Descriptions of blocks currently in the packet */
+    struct radio_trans_buff_blk_info blocks[RADIO_BLOCKS_PER_PACKET];
+    /** The time by which the packet should be sent, this is the earliest
+        deadline given by the slack times of the blocks in the packet */
+    uint32_t deadline;
+    /** Buffer in which the packet is formed */
+    uint8_t buffer[RADIO_MAX_PACKET_SIZE];
+    /** Number of blocks in the packet */
+    uint8_t num_blocks;
+};
+
+/** State of the radio transports transmit capability. Once a packet has been
+    written to a radio the transport is free to start sending the next packet
+    on another radio while the first is still on air. */
 enum radio_trans_tx_state {
-    /** No transmission is in progress */
+    /** No packet is waiting to be written to a radio */
     RADIO_TRANS_TX_IDLE,
-    /** A transmission is in progress */
-    RADIO_TRANS_TX_IN_PROGRESS,
-    /** A transmission has been completed by the driver, but the radio transport
-        code has not yet clean up all of the state from the transmission */
-    RADIO_TRANS_TX_CLEANUP
+    /** A packet is being written to a radio, its buffer is still in use */
+    RADIO_TRANS_TX_IN_PROGRESS
 };
 
 /**
@@ -199,34 +443,45 @@ struct radio_transport_desc {
     /** The last time at which a signal report was sent */
     uint32_t last_sig_report_time;
 
-    /** The radio to be used for the current transmission */
-    struct rn2483_desc_t *tx_radio;
+    /** The radio to which the packet for the current transmission is being
+        written */
+    struct radio_instance_desc *tx_radio;
 
     /** Buffer that can be used to send a single high priority block without
         needing to queue it normally */
     uint8_t priority_packet_buffer[RADIO_PRIORITY_BUF_LENGTH];
-    /** Descriptions of blocks currently in buffered packet */
-    struct radio_trans_buff_blk_info buffer_info[RADIO_BLOCKS_PER_PACKET];
-    /** The base time that the buffer slack time is an offset from */
-    uint32_t buffer_slack_time_base;
-    /** The base time that the prebuffer slack time is an offset from */
-    uint32_t prebuffer_slack_time_base;
-    /** The duration from the buffer slack time base at which point the buffer
-        should be sent */
-    uint16_t buffer_slack_time;
-    /** Slack time for prebuffered blocks */
-    uint16_t prebuffer_slack_time;
-    /** Buffer in which packets are formed */
-    uint8_t packet_buffer[RADIO_MAX_PACKET_SIZE];
+    /** Buffer in which erasure coding parity packets are formed */
+    uint8_t fec_packet_buffer[RADIO_MAX_PACKET_SIZE];
+    /** Queue of packets to be transmitted, blocks are added to the oldest
+        packet in the queue that has space for them and the oldest packet is
+        sent first */
+    struct radio_trans_tx_packet tx_queue[RADIO_TX_QUEUE_LENGTH];
+
+    /** Transmit statistics for each data block subtype */
+    struct radio_trans_tx_stats tx_stats[RADIO_DATA_BLOCK_NUM_SUBTYPES];
+    /** The time at which transmit statistics started being collected */
+    uint32_t tx_stats_start_time;
+    /** Total time spent transmitting in milliseconds */
+    uint32_t tx_airtime;
+    /** Total number of block bytes transmitted */
+    uint32_t tx_block_bytes;
 
     /** Settings for radios */
     struct rn2483_lora_settings_t radio_settings;
+    /** Link profile control state */
+    struct radio_chanmgr_link link;
+    /** Erasure coding state, NULL if erasure coding is not used */
+    struct radio_fec_desc *fec;
 
     /** Received deduplication codes */
     uint16_t rx_deduplication_codes[RADIO_DEDUPLICATION_LIST_LENGTH];
 
-    /** The radio driver transaction id for the current transmission */
-    uint8_t tx_transaction_id;
+    /** Index of the oldest packet in the transmit queue */
+    uint8_t tx_queue_head;
+    /** Number of packets in the transmit queue */
+    uint8_t tx_queue_count;
+    /** Longest packet that may be formed in the transmit queue */
+    uint8_t max_packet_length;
 
     /** The current packet deduplication number */
     uint16_t packet_number:12;
@@ -238,17 +493,18 @@ struct radio_transport_desc {
     enum radio_search_role search_role:1;
     /** The index where the next deduplication code should be inserted in the
         deduplication code buffer */
-    uint8_t dedup_code_position:2;
+    uint8_t dedup_code_position:3;
     /** Indicates whether the deduplication code buffer has empty slots */
     uint8_t dedup_codes_full:1;
     /** Indicates whether there is a transmission in progress from the priority
         buffer */
     uint8_t priority_tx_in_progress:1;
-    /** Indicates whether the a slack time has been set for the TX buffer */
-    uint8_t buffer_slack_time_valid:1;
-    /** Indicates whether the a slack time has been set for the prebuffered
-        packets in the TX buffer */
-    uint8_t prebuffer_slack_time_valid:1;
+    /** Indicates whether there is a transmission in progress from the erasure
+        coding parity buffer */
+    uint8_t fec_tx_in_progress:1;
+    /** The channel to try first for the next transmission when transmissions
+        are spread over several channels */
+    uint8_t tx_channel:2;
 };
 
 
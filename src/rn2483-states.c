@@ -11,7 +11,6 @@
 #include "rn2483-states.h"
 
 #include <string.h>
-#include <ctype.h>
 
 /** Data stored at the beginning of the instance buffer during the receive wait,
     snr and rssi states */
@@ -28,6 +27,10 @@ struct rn2483_rx_info {
             /** Character left over from last time the rx data wait state was
                 run */
             char leftover;
+            /** Boolean value to indicate that some of the packet was
+                overwritten in the uart's rx buffer before it could be parsed
+                and the rest of it should be skipped */
+            uint8_t discard;
         };
     };
     /** Place to store signal to noise ratio while getting the rssi */
@@ -73,6 +76,43 @@ static const char* const RN2483_RSP_PAUSE_MAC = "4294967245";
 
 #define RN2483_RX_DATA_OFFSET (sizeof(struct rn2483_rx_info))
 
+/** Maximum number of received bytes which can be stored in the instance
+    buffer */
+#define RN2483_RX_MAX_LENGTH \
+            (((RN2483_BUFFER_LEN - RN2483_RX_DATA_OFFSET) < UINT8_MAX) ? \
+             (RN2483_BUFFER_LEN - RN2483_RX_DATA_OFFSET) : UINT8_MAX)
+
+/** Flag set in the hex lookup table for hexadecimal digits */
+#define RN2483_HEX_DIGIT    0x10
+/** Mask for the value of a hexadecimal digit in the hex lookup table */
+#define RN2483_HEX_VALUE    0x0F
+/** Hex lookup table value for a space */
+#define RN2483_HEX_SPACE    0x20
+/** Hex lookup table value for a carriage return */
+#define RN2483_HEX_CR       0x40
+/** Hex lookup table value for a newline */
+#define RN2483_HEX_LF       0x80
+
+/** Lookup table used to classify and decode received characters. Hexadecimal
+    digits have RN2483_HEX_DIGIT set and their value in the low nibble, any
+    character that is not a digit, space, carriage return or newline is 0. */
+static const uint8_t rn2483_hex_table[256] = {
+    ['0'] = RN2483_HEX_DIGIT | 0x0, ['1'] = RN2483_HEX_DIGIT | 0x1,
+    ['2'] = RN2483_HEX_DIGIT | 0x2, ['3'] = RN2483_HEX_DIGIT | 0x3,
+    ['4'] = RN2483_HEX_DIGIT | 0x4, ['5'] = RN2483_HEX_DIGIT | 0x5,
+    ['6'] = RN2483_HEX_DIGIT | 0x6, ['7'] = RN2483_HEX_DIGIT | 0x7,
+    ['8'] = RN2483_HEX_DIGIT | 0x8, ['9'] = RN2483_HEX_DIGIT | 0x9,
+    ['A'] = RN2483_HEX_DIGIT | 0xA, ['B'] = RN2483_HEX_DIGIT | 0xB,
+    ['C'] = RN2483_HEX_DIGIT | 0xC, ['D'] = RN2483_HEX_DIGIT | 0xD,
+    ['E'] = RN2483_HEX_DIGIT | 0xE, ['F'] = RN2483_HEX_DIGIT | 0xF,
+    ['a'] = RN2483_HEX_DIGIT | 0xA, ['b'] = RN2483_HEX_DIGIT | 0xB,
+    ['c'] = RN2483_HEX_DIGIT | 0xC, ['d'] = RN2483_HEX_DIGIT | 0xD,
+    ['e'] = RN2483_HEX_DIGIT | 0xE, ['f'] = RN2483_HEX_DIGIT | 0xF,
+    [' '] = RN2483_HEX_SPACE,
+    ['\r'] = RN2483_HEX_CR,
+    ['\n'] = RN2483_HEX_LF
+};
+
 static const char* const RN2483_CMD_RESET = "sys reset\r\n";
 static const char* const RN2483_CMD_WDT = "radio set wdt 0\r\n";
 static const char* const RN2483_CMD_PAUSE_MAC = "mac pause\r\n";
@@ -201,38 +241,6 @@ static uint8_t __attribute__((pure)) parse_version (struct rn2483_desc_t *inst,
     return 0;
 }
 
-/**
- *  Parse a nibble from a single hexadecimal digit.
- *
- *  @param c Character containing the digit to be parsed
- *  @param dest Pointer to where data should be stored
- *  @param offset Number of bits which data should be offset within byte
- *
- *  @return 0 If successful
- */
-static uint8_t parse_nibble (char c, uint8_t *dest, int offset)
-{
-    if (c < '0') {
-        return 1;
-    } else if (c >= 'a') {
-        c -= 32;
-    }
-    c -= '0';
-    if (c <= 9) {
-        goto store_nibble;
-    }
-    c -= 7;
-    if (c <= 9) {
-        return 1;
-    } else if (c <= 15) {
-        goto store_nibble;
-    }
-    return 1;
-store_nibble:
-    *dest |= (c << offset);
-    return 0;
-}
-
 /**
  *  Handle a state where a command is sent and a response is read back.
  *
@@ -735,8 +743,8 @@ static int rn2483_case_send (struct rn2483_desc_t *inst)
 {
     if (!inst->waiting_for_line) {
         // Continue sending command
-        uint8_t cmd_len = (uint8_t)strlen(RN2483_CMD_TX);
-        uint8_t data_len = (uint8_t)inst->send_length * 2;
+        uint16_t cmd_len = (uint16_t)strlen(RN2483_CMD_TX);
+        uint16_t data_len = (uint16_t)inst->send_length * 2;
         if (inst->position < cmd_len) {
             // Still sending command
             inst->position += sercom_uart_put_string(inst->uart,
@@ -748,25 +756,18 @@ static int rn2483_case_send (struct rn2483_desc_t *inst)
             }
         }
         
-        // Send data
-        while (inst->position < (cmd_len + data_len)) {
-            uint8_t data_pos = inst->position - cmd_len;
-            uint8_t i = data_pos / 2;
-            uint8_t shift = (data_pos & 1) ? 0 : 4;
-            
-            uint8_t data = (inst->send_buffer[i] >> shift) & 0xF;
-            char str[2];
-            str[0] = (data < 10) ? ('0' + data) : ('A' + data - 10);
-            str[1] = '\0';
-            
-            uint8_t sent = sercom_uart_put_string(inst->uart, str);
+        // Send data, encoded directly into the uart buffer as hex
+        if (inst->position < (cmd_len + data_len)) {
+            uint16_t const data_pos = (inst->position - cmd_len) / 2;
+            uint16_t const sent = sercom_uart_put_hex(inst->uart,
+                                            inst->send_buffer + data_pos,
+                                            inst->send_length - data_pos);
+            inst->position += sent * 2;
             
-            if (sent == 0) {
-                // Character was not sent, uart buffer must be full
+            if (inst->position < (cmd_len + data_len)) {
+                // Didn't finish sending data, uart buffer must be full
                 return 0;
             }
-            
-            inst->position++;
         }
         
         // Sending line terminator
@@ -923,6 +924,7 @@ static int rn2483_case_rx_ok_wait (struct rn2483_desc_t *inst)
         struct rn2483_rx_info *const rx_info =
                                         (struct rn2483_rx_info*)inst->buffer;
         rx_info->have_leftover = 0;
+        rx_info->discard = 0;
         rx_info->length = 0;
         // We got the correct response! Start parsing the data from the message
         inst->state = RN2483_RX_DATA_WAIT;
@@ -944,123 +946,121 @@ static int rn2483_case_rx_ok_wait (struct rn2483_desc_t *inst)
 static int rn2483_case_rx_data_wait (struct rn2483_desc_t *inst)
 {
     struct rn2483_rx_info *const rx_info = (struct rn2483_rx_info*)inst->buffer;
-    // Calculate where we should be putting the next received byte
-    const uint16_t offset = RN2483_RX_DATA_OFFSET + rx_info->length;
-
-    // Keep trying to get more bytes and parse them until we run out of bytes in
-    // the uart's rx buffer
-    uint8_t chars_in;
-    uint8_t new_char;
-    char rx_data[3];
-    do {
-        // Get up to the next two bytes of data from the uart in buffer
-        sercom_uart_get_string(inst->uart, rx_data, 2);
-        chars_in = strlen(rx_data);
-
-        if (chars_in == 0) {
-            // No new data to parse
-            break;
-        }
-
-        // Skip spaces and determine how many new usable char we have
-        if ((chars_in == 1) && (rx_data[0] == ' ')) {
-            // The only char we got was a space, no new data to parse
-            break;
-        } else if ((chars_in == 2) && (rx_data[0] == ' ') &&
-                   (rx_data[1] == ' ')) {
-            // The only two new chars we got where spaces, no new data to parse
-            // (but since we got a full two chars there could be more chars in
-            // the uart buffer)
-            continue;
-        } else if ((chars_in == 2) && (rx_data[0] == ' ')) {
-            // The first char we got is a space but the second one is good,
-            // shift the second char over and pretend we never received the
-            // first one
-            rx_data[0] = rx_data[1];
-            new_char = 1;
-        } else if ((chars_in == 2) && (rx_data[1] == ' ')) {
-            // The second char we got is a space, set new_chars to 1 and pretend
-            // we never received the second one
-            new_char = 1;
-        } else {
-            // All of the chars we got from the buffer are not spaces
-            new_char = chars_in;
+    uint8_t *const rx_data = (uint8_t*)inst->buffer + RN2483_RX_DATA_OFFSET;
+    uint16_t length = rx_info->length;
+
+    // Decode each contiguous span of received characters directly from the
+    // uart's rx buffer until we run out of characters
+    const uint8_t *data;
+    uint16_t avail;
+    while ((avail = sercom_uart_get_received(inst->uart, &data)) != 0) {
+        if (rx_info->discard) {
+            // Skip the rest of the line and drop the packet as if the receive
+            // had timed out
+            const uint8_t *const lf = memchr(data, '\n', avail);
+            if (lf == NULL) {
+                sercom_uart_consume(inst->uart, avail);
+                continue;
+            }
+            sercom_uart_consume(inst->uart, (uint16_t)(lf - data) + 1);
+            return handle_rx_timeout(inst);
         }
 
-        if (!rx_info->have_leftover && (new_char == 1)) {
-            // We only have one char to work with, just store it as a leftover
-            // for next time
-            rx_info->leftover = rx_data[0];
-            rx_info->have_leftover = 1;
-            break;
-        }
+        uint16_t i = 0;
+
+        while (i < avail) {
+            if (!rx_info->have_leftover) {
+                // Decode as many whole bytes as we can without looking at
+                // characters one at a time. This stops at the first pair of
+                // characters that are not both hexadecimal digits.
+                uint16_t pairs = (avail - i) / 2;
+                if (pairs > (RN2483_RX_MAX_LENGTH - length)) {
+                    pairs = RN2483_RX_MAX_LENGTH - length;
+                }
+                for (; pairs != 0; pairs--) {
+                    uint8_t const high = rn2483_hex_table[data[i]];
+                    uint8_t const low = rn2483_hex_table[data[i + 1]];
+                    if (!(high & low & RN2483_HEX_DIGIT)) {
+                        break;
+                    }
+                    rx_data[length++] = (uint8_t)((high << 4) |
+                                                  (low & RN2483_HEX_VALUE));
+                    i += 2;
+                }
+                if (i == avail) {
+                    break;
+                }
+            }
 
-        // At this point we have two chars to work with. We should be able to
-        // parse out a byte of received data (or find the end of the line).
-
-        // Identify our high and low chars
-        char high_char;
-        char low_char;
-        if (rx_info->have_leftover) {
-            high_char = rx_info->leftover;
-            low_char = rx_data[0];
-            if (new_char == 2) {
-                // We have a char left over for next time
-                rx_info->leftover = rx_data[1];
-            } else {
-                rx_info->have_leftover = 0;
+            // Handle a single character that could not be decoded as part of
+            // a pair
+            char const c = (char)data[i++];
+            uint8_t const low = rn2483_hex_table[(uint8_t)c];
+
+            if (low == RN2483_HEX_SPACE) {
+                // Skip spaces
+                continue;
+            } else if (!rx_info->have_leftover) {
+                // Keep the char until we have another one to pair it with
+                rx_info->leftover = c;
+                rx_info->have_leftover = 1;
+                continue;
             }
-        } else {
-            high_char = rx_data[0];
-            low_char = rx_data[1];
-        }
 
-        // Check if we have a newline
-        if ((high_char == '\r') && (low_char == '\n')) {
-            // That's all the data, get the SNR now
-            inst->state = RN2483_GET_SNR;
-            return 1;
-        } else if (!isxdigit(high_char) || !isxdigit(low_char)) {
-            // If our pair of chars is not a newline and either of our chars are
-            // not a hexadecimal digit a few different things are could be going
-            // on:
-            //      - We received an odd number of hexadecimal digits before the
-            //        newline so we are now looking at a valid digit and a
-            //        carriage return together
-            //      - We received a character that is neither a valid digit, a
-            //        carriage return nor a newline
-            //      - The carriage return and newline are backwards
-            //      - We received a a carriage return and then something after
-            //        it that was not a newline
-            // No matter what it is, something has gone very wrong and we can't
-            // keep parsing the data. Because we don't know what the radio might
-            // send next (we could still be in the middle of a line) we need to
-            // go straight to the failed state.
-            inst->state = RN2483_FAILED;
-            return 0;
-        } else if (offset >= RN2483_BUFFER_LEN) {
-            // We have a valid byte to parse, but there is no space left in the
-            // buffer. We don't have a lot of options here, but in the interest
-            // of not crashing the radio driver if we receive a packet that is
-            // too big we are going to just ignore any bytes that don't fit in
-            // the buffer and pretend that they never happened
-            continue;
-        } else {
-            // We have a valid byte to parse and space for it in the buffer
-            inst->buffer[offset] = 0;
-            uint8_t ret = parse_nibble(high_char,
-                                       (uint8_t*)&inst->buffer[offset], 4);
-            ret |= parse_nibble(low_char, (uint8_t*)&inst->buffer[offset], 0);
-            if (ret != 0) {
-                // This should never happen because we already checked that
-                // both of our bytes are valid hex chars
+            rx_info->have_leftover = 0;
+            uint8_t const high = rn2483_hex_table[(uint8_t)rx_info->leftover];
+
+            if ((high == RN2483_HEX_CR) && (low == RN2483_HEX_LF)) {
+                // That's all the data, get the SNR now
+                if (sercom_uart_consume(inst->uart, i) != 0) {
+                    // Some of the data was overwritten before we parsed it
+                    return handle_rx_timeout(inst);
+                }
+                rx_info->length = (uint8_t)length;
+                inst->state = RN2483_GET_SNR;
+                return 1;
+            } else if (!(high & low & RN2483_HEX_DIGIT)) {
+                // If our pair of chars is not a newline and either of our
+                // chars are not a hexadecimal digit a few different things
+                // are could be going on:
+                //      - We received an odd number of hexadecimal digits
+                //        before the newline so we are now looking at a valid
+                //        digit and a carriage return together
+                //      - We received a character that is neither a valid
+                //        digit, a carriage return nor a newline
+                //      - The carriage return and newline are backwards
+                //      - We received a a carriage return and then something
+                //        after it that was not a newline
+                // No matter what it is, something has gone very wrong and we
+                // can't keep parsing the data. Because we don't know what the
+                // radio might send next (we could still be in the middle of a
+                // line) we need to go straight to the failed state.
+                if (sercom_uart_consume(inst->uart, i) != 0) {
+                    // The bad characters are from data being overwritten in
+                    // the uart's rx buffer, not from the radio
+                    rx_info->discard = 1;
+                    return 1;
+                }
                 inst->state = RN2483_FAILED;
                 return 0;
+            } else if (length < RN2483_RX_MAX_LENGTH) {
+                rx_data[length++] = (uint8_t)((high << 4) |
+                                              (low & RN2483_HEX_VALUE));
             }
-            rx_info->length++;
+            // If there is no space left in the buffer we don't have a lot of
+            // options, but in the interest of not crashing the radio driver
+            // if we receive a packet that is too big we are going to just
+            // ignore any bytes that don't fit in the buffer and pretend that
+            // they never happened
+        }
+
+        if (sercom_uart_consume(inst->uart, avail) != 0) {
+            // Some of the data was overwritten before we parsed it
+            rx_info->discard = 1;
         }
-    } while (chars_in == 2);
+    }
 
+    rx_info->length = (uint8_t)length;
     return 0;
 }
 
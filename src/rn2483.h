@@ -299,7 +299,7 @@ struct rn2483_desc_t {
     
     /** Pointer for sending commands over multiple calls to service if UART
         buffer becomes full */
-    uint8_t position;
+    uint16_t position;
     
     /** Pin which is the target of the current GPIO command */
     enum rn2483_pin current_pin:8;
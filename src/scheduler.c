@@ -0,0 +1,135 @@
+/**
+ * @file scheduler.c
+ * @desc Run queue scheduler for main loop services
+ * @author agent
+ * @date 2026-10-16
+ * Last Author:
+ * Last Edited On:
+ */
+
+#include "scheduler.h"
+
+volatile uint8_t sched_pending_g;
+
+/** First task in the task list */
+static struct sched_task_t *sched_head;
+/** Last task in the task list */
+static struct sched_task_t *sched_tail;
+
+/** Main loop statistics */
+static struct sched_stats_t sched_stats;
+
+
+void sched_add_task(struct sched_task_t *task, sched_task_func_t func,
+                    void *context, const char *name, uint32_t period,
+                    uint8_t poll)
+{
+    task->next = NULL;
+    task->func = func;
+    task->context = context;
+    task->name = name;
+    task->period = period;
+    task->next_run = millis + period;
+    profiler_hist_clear(&task->run_time);
+    task->ready = 0;
+    task->poll = !!poll;
+
+    if (sched_tail == NULL) {
+        sched_head = task;
+    } else {
+        sched_tail->next = task;
+    }
+    sched_tail = task;
+}
+
+int sched_event_add_task(struct sched_event_t *event,
+                         struct sched_task_t *task)
+{
+    for (uint8_t i = 0; i < event->num_tasks; i++) {
+        if (event->tasks[i] == task) {
+            return 0;
+        }
+    }
+
+    if (event->num_tasks >= SCHED_EVENT_MAX_TASKS) {
+        return 1;
+    }
+
+    // The task is stored before the count is updated so that the event can
+    // be signalled from an interrupt at any time
+    event->tasks[event->num_tasks] = task;
+    event->num_tasks++;
+    return 0;
+}
+
+void sched_run(void)
+{
+    // Clear the pending flag before looking at any tasks so that a task which
+    // is marked ready while the list is being run prevents the next sleep
+    sched_pending_g = 0;
+
+    uint32_t const now = millis;
+    uint32_t const pass_start = profiler_now();
+
+    for (struct sched_task_t *t = sched_head; t != NULL; t = t->next) {
+        uint8_t run = t->poll || t->ready;
+
+        if ((t->period != 0) && ((int32_t)(now - t->next_run) >= 0)) {
+            run = 1;
+            t->next_run += t->period;
+            if ((int32_t)(now - t->next_run) >= 0) {
+                // We have fallen more than a period behind, don't try to
+                // catch up on the runs that were missed
+                t->next_run = now + t->period;
+            }
+        }
+
+        if (!run) {
+            continue;
+        }
+
+        // Clear the ready flag before running the task so that the task is
+        // run again if it is marked ready while it is running
+        t->ready = 0;
+
+        uint32_t const start = profiler_now();
+        t->func(t->context);
+        profiler_hist_record(&t->run_time, profiler_now() - start);
+    }
+
+    profiler_hist_record(&sched_stats.pass_time, profiler_now() - pass_start);
+}
+
+void sched_sleep(void)
+{
+    // Interrupts are disabled so that a task can not be marked ready between
+    // checking the pending flag and going to sleep. A pending interrupt still
+    // wakes the CPU and is handled once interrupts are enabled again.
+    __disable_irq();
+    if (!inhibit_sleep_g && !sched_pending_g) {
+        uint32_t const start = profiler_now();
+        __WFI();
+        sched_stats.sleep_time += profiler_now() - start;
+    }
+    __enable_irq();
+}
+
+struct sched_task_t *sched_get_tasks(void)
+{
+    return sched_head;
+}
+
+const struct sched_stats_t *sched_get_stats(void)
+{
+    return &sched_stats;
+}
+
+void sched_clear_stats(void)
+{
+    for (struct sched_task_t *t = sched_head; t != NULL; t = t->next) {
+        profiler_hist_clear(&t->run_time);
+    }
+
+    profiler_hist_clear(&sched_stats.pass_time);
+    sched_stats.sleep_time = 0;
+}
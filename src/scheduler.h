@@ -0,0 +1,183 @@
+/**
+ * @file scheduler.h
+ * @desc Run queue scheduler for main loop services
+ * @author agent
+ * @date 2026-10-16
+ * Last Author:
+ * Last Edited On:
+ */
+
+#ifndef scheduler_h
+#define scheduler_h
+
+#include "global.h"
+#include "profiler.h"
+
+/**
+ *  Function run by a scheduler task.
+ *
+ *  @param context The context pointer which was given when the task was added
+ */
+typedef void (*sched_task_func_t)(void *context);
+
+/**
+ *  Define a task function which calls a service function that takes a pointer
+ *  to a driver instance descriptor as its only argument.
+ *
+ *  @param name Name of the task function to be defined
+ *  @param service Service function to be called
+ *  @param type Type of the driver instance descriptor
+ */
+#define SCHED_TASK_FUNC(name, service, type) \
+    static void name(void *context) { service((type *)context); }
+
+struct sched_task_t {
+    /** Next task in the scheduler's task list */
+    struct sched_task_t *next;
+    /** Function to be run */
+    sched_task_func_t func;
+    /** Context pointer passed to the task function */
+    void *context;
+    /** Name of the task for run time statistics */
+    const char *name;
+
+    /** Period at which the task should be run in milliseconds, 0 if the task
+        is not run periodically */
+    uint32_t period;
+    /** Time at which the task should next be run because of its period */
+    uint32_t next_run;
+
+    /** Time taken by each run of the task in profiler ticks */
+    struct profiler_hist_t run_time;
+
+    /** Flag set when the task has work to do and should be run on the next
+        pass through the task list */
+    volatile uint8_t ready;
+    /** Flag to indicate that the task is run on every pass through the task
+        list whether or not it has been marked ready */
+    uint8_t poll:1;
+};
+
+/** Maximum number of tasks which can be woken by a single event */
+#define SCHED_EVENT_MAX_TASKS   6
+
+/**
+ *  A set of tasks to be marked ready together. Drivers signal an event from
+ *  their interrupts and callbacks so that the tasks which are waiting on the
+ *  driver are run without having to be polled.
+ */
+struct sched_event_t {
+    /** Tasks to be marked ready when the event is signalled */
+    struct sched_task_t *tasks[SCHED_EVENT_MAX_TASKS];
+    /** Number of tasks in the tasks array */
+    uint8_t num_tasks;
+};
+
+/**
+ *  Statistics about the main loop as a whole.
+ */
+struct sched_stats_t {
+    /** Time taken by each pass through the task list in profiler ticks */
+    struct profiler_hist_t pass_time;
+    /** Time spent sleeping in profiler ticks */
+    uint64_t sleep_time;
+};
+
+/**
+ *  Flag which is set whenever a task is marked ready. The main loop will not
+ *  sleep until it has made another pass through the task list.
+ */
+extern volatile uint8_t sched_pending_g;
+
+
+/**
+ *  Add a task to the scheduler. Tasks are run in the order in which they are
+ *  added.
+ *
+ *  @param task Task descriptor to be initialized and added
+ *  @param func Function to be run for the task
+ *  @param context Pointer to be passed to the task function
+ *  @param name Name of the task
+ *  @param period Period in milliseconds at which the task should be run, 0 if
+ *                the task should not be run periodically
+ *  @param poll Non-zero if the task should be run on every pass through the
+ *              task list
+ */
+extern void sched_add_task(struct sched_task_t *task, sched_task_func_t func,
+                           void *context, const char *name, uint32_t period,
+                           uint8_t poll);
+
+/**
+ *  Mark a task as having work to do so that it is run on the next pass through
+ *  the task list. May be called from interrupt handlers and callbacks.
+ *
+ *  @param task The task to be marked ready
+ */
+static inline void sched_mark_ready(struct sched_task_t *task)
+{
+    task->ready = 1;
+    sched_pending_g = 1;
+}
+
+/**
+ *  Add a task to the set of tasks which are marked ready when an event is
+ *  signalled. Adding a task which is already in the set has no effect.
+ *
+ *  @param event The event to which the task should be added
+ *  @param task The task to be marked ready when the event is signalled
+ *
+ *  @return 0 if successful, 1 if the event already has the maximum number of
+ *          tasks
+ */
+extern int sched_event_add_task(struct sched_event_t *event,
+                                struct sched_task_t *task);
+
+/**
+ *  Mark all of the tasks for an event as ready. May be called from interrupt
+ *  handlers and callbacks.
+ *
+ *  @param event The event to be signalled
+ */
+static inline void sched_event_signal(struct sched_event_t *event)
+{
+    for (uint8_t i = 0; i < event->num_tasks; i++) {
+        event->tasks[i]->ready = 1;
+    }
+    if (event->num_tasks != 0) {
+        sched_pending_g = 1;
+    }
+}
+
+/**
+ *  Make one pass through the task list, running every task which is ready, due
+ *  or polled.
+ */
+extern void sched_run(void);
+
+/**
+ *  Sleep until the next interrupt unless sleep is inhibited or a task has been
+ *  marked ready since the start of the last pass through the task list.
+ */
+extern void sched_sleep(void);
+
+/**
+ *  Get the first task in the scheduler's task list. The rest of the list can
+ *  be walked using the next field of each task.
+ *
+ *  @return The first task or NULL if there are no tasks
+ */
+extern struct sched_task_t *sched_get_tasks(void);
+
+/**
+ *  Get the statistics for the main loop.
+ *
+ *  @return Pointer to the main loop statistics
+ */
+extern const struct sched_stats_t *sched_get_stats(void);
+
+/**
+ *  Clear the run time statistics for the main loop and all tasks.
+ */
+extern void sched_clear_stats(void);
+
+#endif /* scheduler_h */
@@ -14,6 +14,10 @@
 
 #define SD_BLOCK_LENGTH 512
 
+/** Maximum number of segments that may be passed to a vectored write. Every
+    driver that provides a vectored write must support at least this many. */
+#define SD_MAX_SEGMENTS 8
+
 /**
  *  Represents the possible statuses for an SD card operation.
  */
@@ -26,6 +30,17 @@ enum sd_op_result {
 typedef void (*sd_op_cb_t)(void *context, enum sd_op_result result,
                            uint32_t num_blocks);
 
+/**
+ *  Single element in a list of buffers for a vectored write. Each segment is a
+ *  whole number of blocks.
+ */
+struct sd_segment {
+    /** Data to be written, must be word aligned */
+    uint8_t const *data;
+    /** Number of 512 byte blocks in segment */
+    uint32_t num_blocks;
+};
+
 
 
 // The sdspi.h and sdhc.h need to be included here because the above type are
@@ -86,6 +101,10 @@ struct sd_funcs {
     /**
      *  Function to write to SD card.
      *
+     *  For writes of more than one block the driver tells the card how many
+     *  blocks are about to be written (ACMD23) so that the card can pre-erase
+     *  them instead of erasing each block as it arrives.
+     *
      *  @note   It is important to be aware that the callback function may be
      *          called from an interrupt context.
      *
@@ -106,6 +125,54 @@ struct sd_funcs {
      */
     int (*write)(sd_desc_ptr_t inst, uint32_t addr, uint32_t num_blocks,
                  uint8_t const *data, sd_op_cb_t cb, void *context);
+    /**
+     *  Function to write data from several buffers to consecutive blocks on
+     *  the SD card in a single operation.
+     *
+     *  @note   It is important to be aware that the callback function may be
+     *          called from an interrupt context.
+     *
+     *  @param inst The pointer to driver instance for type of SD card driver
+     *              to which this function belongs
+     *  @param addr Address to be written to in blocks, the address passed to
+     *              this function is always in blocks, even for older cards that
+     *              are byte addressed
+     *  @param segments List of buffers to be written to the card in order, the
+     *                  list and the buffers must remain valid until callback
+     *                  function is called
+     *  @param num_segments The number of segments in the list, at most
+     *                      SD_MAX_SEGMENTS
+     *  @param cb Callback function for when write operation is complete
+     *  @param context Pointer that will be passed to callback function
+     *
+     *  @return Zero if successfully started or queued to be started, a non-zero
+     *          value otherwise
+     */
+    int (*write_v)(sd_desc_ptr_t inst, uint32_t addr,
+                   struct sd_segment const *segments, uint8_t num_segments,
+                   sd_op_cb_t cb, void *context);
+    /**
+     *  Function to erase a range of blocks on the SD card. Writing to blocks
+     *  that have already been erased can be much faster than writing to blocks
+     *  that still contain old data.
+     *
+     *  @note   It is important to be aware that the callback function may be
+     *          called from an interrupt context.
+     *
+     *  @param inst The pointer to driver instance for type of SD card driver
+     *              to which this function belongs
+     *  @param addr Address of the first block to be erased, the address passed
+     *              to this function is always in blocks, even for older cards
+     *              that are byte addressed
+     *  @param num_blocks The number of 512 byte blocks to be erased
+     *  @param cb Callback function for when erase operation is complete
+     *  @param context Pointer that will be passed to callback function
+     *
+     *  @return Zero if successfully started or queued to be started, a non-zero
+     *          value otherwise
+     */
+    int (*erase)(sd_desc_ptr_t inst, uint32_t addr, uint32_t num_blocks,
+                 sd_op_cb_t cb, void *context);
     /**
      *  Function to get SD card driver state.
      *
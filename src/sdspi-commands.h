@@ -93,6 +93,7 @@ enum sdspi_application_command_index {
 };
 
 #define SDSPI_ACMD41_HCS    (1 << 30)
+#define SDSPI_ACMD23_MAX_BLOCKS 0x7FFFFF
 #define SDSPI_CMD1_HCS    ( 1 << 30)
 
 
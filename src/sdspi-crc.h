@@ -0,0 +1,40 @@
+/**
+ * @file sdspi-crc.h
+ * @desc Software CRC calculations for SD Card via SPI driver.
+ * @author agent
+ * @date 2026-10-16
+ * Last Author:
+ * Last Edited On:
+ */
+
+#ifndef sdspi_crc_h
+#define sdspi_crc_h
+
+#include "global.h"
+
+/**
+ *  Calculate the 7 bit CRC used for SD card commands.
+ *
+ *  @param msg The bytes over which the CRC should be calculated
+ *  @param length The number of bytes in msg
+ *
+ *  @return The CRC7 value (in the low 7 bits)
+ */
+extern uint8_t sdspi_crc_7(uint8_t const *msg, size_t length);
+
+/**
+ *  Calculate the 16 bit CRC (CRC-CCITT, init 0) used for SD card data blocks.
+ *
+ *  The calculation can be split across multiple calls by passing the result of
+ *  the previous call as the crc argument. This is also the value that the DMAC
+ *  CRC engine must be seeded with to continue the calculation in hardware.
+ *
+ *  @param crc The CRC of any preceding data, 0 to start a new calculation
+ *  @param msg The bytes over which the CRC should be calculated
+ *  @param length The number of bytes in msg
+ *
+ *  @return The CRC16 value
+ */
+extern uint16_t sdspi_crc_16(uint16_t crc, uint8_t const *msg, size_t length);
+
+#endif /* sdspi_crc_h */
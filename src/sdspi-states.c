@@ -12,6 +12,8 @@
 #include <string.h>
 
 #include "board.h"
+#include "sdspi-crc.h"
+#include "dma.h"
 
 #ifdef ENABLE_SDSPI
 
@@ -25,121 +27,64 @@
 #define SDSPI_NUM_INIT_RETRIES  5
 
 #define SDSPI_CMD_TIMEOUT           MS_TO_MILLIS(50)
+#define SDSPI_ERASE_TIMEOUT         MS_TO_MILLIS(10000)
 #define SDSPI_BLK_READ_TIMEOUT      MS_TO_MILLIS(250)
 #define SDSPI_WRITE_BUSY_TIMEOUT    MS_TO_MILLIS(250)
 #define SDSPI_WRITE_RSP_TIMEOUT     MS_TO_MILLIS(10)
 
 
-static uint8_t sdspi_crc_7(uint8_t const *msg, size_t length)
+static inline int sdspi_init_retry(struct sdspi_desc_t *inst)
 {
-    static uint8_t const sdspi_crc7_lut[] = {
-        0x00, 0x09, 0x12, 0x1B, 0x24, 0x2D, 0x36, 0x3F,
-        0x48, 0x41, 0x5A, 0x53, 0x6C, 0x65, 0x7E, 0x77,
-        0x19, 0x10, 0x0B, 0x02, 0x3D, 0x34, 0x2F, 0x26,
-        0x51, 0x58, 0x43, 0x4A, 0x75, 0x7C, 0x67, 0x6E,
-        0x32, 0x3B, 0x20, 0x29, 0x16, 0x1F, 0x04, 0x0D,
-        0x7A, 0x73, 0x68, 0x61, 0x5E, 0x57, 0x4C, 0x45,
-        0x2B, 0x22, 0x39, 0x30, 0x0F, 0x06, 0x1D, 0x14,
-        0x63, 0x6A, 0x71, 0x78, 0x47, 0x4E, 0x55, 0x5C,
-        0x64, 0x6D, 0x76, 0x7F, 0x40, 0x49, 0x52, 0x5B,
-        0x2C, 0x25, 0x3E, 0x37, 0x08, 0x01, 0x1A, 0x13,
-        0x7D, 0x74, 0x6F, 0x66, 0x59, 0x50, 0x4B, 0x42,
-        0x35, 0x3C, 0x27, 0x2E, 0x11, 0x18, 0x03, 0x0A,
-        0x56, 0x5F, 0x44, 0x4D, 0x72, 0x7B, 0x60, 0x69,
-        0x1E, 0x17, 0x0C, 0x05, 0x3A, 0x33, 0x28, 0x21,
-        0x4F, 0x46, 0x5D, 0x54, 0x6B, 0x62, 0x79, 0x70,
-        0x07, 0x0E, 0x15, 0x1C, 0x23, 0x2A, 0x31, 0x38,
-        0x41, 0x48, 0x53, 0x5A, 0x65, 0x6C, 0x77, 0x7E,
-        0x09, 0x00, 0x1B, 0x12, 0x2D, 0x24, 0x3F, 0x36,
-        0x58, 0x51, 0x4A, 0x43, 0x7C, 0x75, 0x6E, 0x67,
-        0x10, 0x19, 0x02, 0x0B, 0x34, 0x3D, 0x26, 0x2F,
-        0x73, 0x7A, 0x61, 0x68, 0x57, 0x5E, 0x45, 0x4C,
-        0x3B, 0x32, 0x29, 0x20, 0x1F, 0x16, 0x0D, 0x04,
-        0x6A, 0x63, 0x78, 0x71, 0x4E, 0x47, 0x5C, 0x55,
-        0x22, 0x2B, 0x30, 0x39, 0x06, 0x0F, 0x14, 0x1D,
-        0x25, 0x2C, 0x37, 0x3E, 0x01, 0x08, 0x13, 0x1A,
-        0x6D, 0x64, 0x7F, 0x76, 0x49, 0x40, 0x5B, 0x52,
-        0x3C, 0x35, 0x2E, 0x27, 0x18, 0x11, 0x0A, 0x03,
-        0x74, 0x7D, 0x66, 0x6F, 0x50, 0x59, 0x42, 0x4B,
-        0x17, 0x1E, 0x05, 0x0C, 0x33, 0x3A, 0x21, 0x28,
-        0x5F, 0x56, 0x4D, 0x44, 0x7B, 0x72, 0x69, 0x60,
-        0x0E, 0x07, 0x1C, 0x15, 0x2A, 0x23, 0x38, 0x31,
-        0x46, 0x4F, 0x54, 0x5D, 0x62, 0x6B, 0x70, 0x79
-    };
+    inst->init_retry_count++;
 
-    uint8_t crc = 0;
-    for (size_t i = 0; i < length; i++) {
-        uint8_t const pos = ((crc << 1) ^ msg[i]);
-        crc = sdspi_crc7_lut[pos];
+    if (inst->init_retry_count > SDSPI_NUM_INIT_RETRIES) {
+        inst->state = SDSPI_TOO_MANY_INIT_RETRIES;
+        return 0;
     }
 
-    return crc;
+    // Retry right away
+    return 1;
 }
 
 #if SDSPI_USE_CRC == 1
-static uint16_t sdspi_crc_16(uint8_t const *msg, size_t length)
+/**
+ *  Try to have the DMAC CRC engine calculate the CRC for the data transfered by
+ *  the next block transaction. If the SPI instance does not use DMA in the
+ *  required direction or the CRC engine is busy the inst->hw_crc flag will be
+ *  left clear and the CRC should be calculated in software instead.
+ *
+ *  @param inst The sdspi driver instance
+ *  @param rx Whether the CRC should be calculated for received data rather than
+ *            transmitted data
+ *  @param initial CRC of any block data which has already been transfered
+ */
+static inline void sdspi_start_hw_crc(struct sdspi_desc_t *inst, uint8_t rx,
+                                      uint16_t initial)
 {
-    // CRC: width=16 poly=0x1021 init=0x0000 refin=false refout=false
-    //      xorout=0x0000
-
-    static uint16_t const sdspi_crc16_lut[] = {
-        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
-        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
-        0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
-        0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
-        0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
-        0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
-        0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
-        0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
-        0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
-        0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
-        0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
-        0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
-        0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
-        0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
-        0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
-        0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
-        0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
-        0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
-        0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
-        0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
-        0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
-        0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
-        0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
-        0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
-        0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
-        0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
-        0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
-        0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
-        0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
-        0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
-        0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
-        0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
-    };
-
-    uint16_t crc = 0;
-    for (size_t i = 0; i < length; i++) {
-        uint8_t const pos = (uint8_t)((crc >> 8) ^ msg[i]);
-        crc = (uint16_t)((crc << 8) ^ sdspi_crc16_lut[pos]);
-    }
+    struct sercom_spi_desc_t *const spi = inst->spi_inst;
+    uint8_t const use_dma = rx ? spi->rx_use_dma : spi->tx_use_dma;
+    uint8_t const chan = rx ? spi->rx_dma_chan : spi->tx_dma_chan;
 
-    return crc;
+    inst->hw_crc = use_dma && (dma_start_crc16(chan, initial) == 0);
 }
-#endif
 
-
-static inline int sdspi_init_retry(struct sdspi_desc_t *inst)
+/**
+ *  Release the DMAC CRC engine if it is in use by this instance.
+ *
+ *  @param inst The sdspi driver instance
+ *
+ *  @return The CRC calculated by the CRC engine
+ */
+static inline uint16_t sdspi_stop_hw_crc(struct sdspi_desc_t *inst)
 {
-    inst->init_retry_count++;
-
-    if (inst->init_retry_count > SDSPI_NUM_INIT_RETRIES) {
-        inst->state = SDSPI_TOO_MANY_INIT_RETRIES;
+    if (!inst->hw_crc) {
         return 0;
     }
 
-    // Retry right away
-    return 1;
+    inst->hw_crc = 0;
+    return crc_calc_crc16();
 }
+#endif
 
 static inline void sdspi_end_spi_session(struct sdspi_desc_t *inst)
 {
@@ -150,6 +95,10 @@ static inline void sdspi_end_spi_session(struct sdspi_desc_t *inst)
     sercom_spi_end_session(inst->spi_inst, inst->spi_tid);
     inst->spi_session_open = 0;
 
+#if SDSPI_USE_CRC == 1
+    sdspi_stop_hw_crc(inst);
+#endif
+
     allow_sleep();
 }
 
@@ -548,12 +497,21 @@ static enum sdspi_blk_read_state_result sdspi_handle_read_block(
             if (send_stop_cmd) {
                 in_len -= sizeof(union sdspi_command) - 2;
             }
+#if SDSPI_USE_CRC == 1
+            // Have the DMAC calculate the CRC as the rest of the block is
+            // received, continuing on from any bytes we already have
+            inst->block_crc_valid = 0;
+            sdspi_start_hw_crc(inst, 1, sdspi_crc_16(0, dest, inst->bytes_in));
+#endif
             ret = sercom_spi_start_session_transaction(inst->spi_inst,
                                                 inst->spi_tid, NULL, 0,
                                                 dest + inst->bytes_in, in_len);
 
             if (ret != 0) {
                 // Could not queue transaction in session
+#if SDSPI_USE_CRC == 1
+                sdspi_stop_hw_crc(inst);
+#endif
                 return SDSPI_BLK_READ_RES_QUEUE_WAIT;
             }
 
@@ -608,6 +566,14 @@ static enum sdspi_blk_read_state_result sdspi_handle_read_block(
             inst->substate = SDSPI_BLK_READ_READ_CRC;
             /* fallthrough */
         case SDSPI_BLK_READ_READ_CRC:
+#if SDSPI_USE_CRC == 1
+            // The whole block has been received, grab the CRC from the DMAC
+            // before it sees the CRC bytes
+            if (inst->hw_crc) {
+                inst->block_crc = sdspi_stop_hw_crc(inst);
+                inst->block_crc_valid = 1;
+            }
+#endif
             if (send_stop_cmd) {
                 // If we made it here the previous stop command/data transaction
                 // is complete
@@ -652,7 +618,11 @@ static enum sdspi_blk_read_state_result sdspi_handle_read_block(
             // Verify crc
             uint16_t const crc = ((((uint16_t)inst->cmd_buffer[0]) << 8) |
                                   inst->cmd_buffer[1]);
-            if (crc != sdspi_crc_16(dest, block_length)) {
+            uint16_t const calc_crc = (inst->block_crc_valid ?
+                                       inst->block_crc :
+                                       sdspi_crc_16(0, dest, block_length));
+            inst->block_crc_valid = 0;
+            if (crc != calc_crc) {
                 // CRC failed
                 inst->substate = 0;
                 return SDSPI_BLK_READ_RES_CRC_ERROR;
@@ -782,6 +752,10 @@ static enum sdspi_blk_write_state_result sdspi_handle_write_block(
             // If we make it here the SPI transaction is done
             inst->spi_in_progress = 0;
 
+#if SDSPI_USE_CRC == 1
+            // Have the DMAC calculate the CRC as the block is sent
+            sdspi_start_hw_crc(inst, 0, 0);
+#endif
             // Send block
             ret = sercom_spi_start_session_transaction(inst->spi_inst,
                                                        inst->spi_tid,
@@ -790,6 +764,9 @@ static enum sdspi_blk_write_state_result sdspi_handle_write_block(
 
             if (ret != 0) {
                 // Could not queue transaction in session
+#if SDSPI_USE_CRC == 1
+                sdspi_stop_hw_crc(inst);
+#endif
                 return SDSPI_BLK_WRITE_RES_QUEUE_WAIT;
             }
 
@@ -798,9 +775,12 @@ static enum sdspi_blk_write_state_result sdspi_handle_write_block(
 
             // Calculate CRC
 #if SDSPI_USE_CRC == 1
-            uint16_t const crc = sdspi_crc_16(data, block_length);
-            inst->cmd_buffer[0] = (uint8_t)(crc >> 8);
-            inst->cmd_buffer[1] = (uint8_t)(crc & 0xFF);
+            if (!inst->hw_crc) {
+                // Calculate the CRC in software while the block is sent
+                uint16_t const crc = sdspi_crc_16(0, data, block_length);
+                inst->cmd_buffer[0] = (uint8_t)(crc >> 8);
+                inst->cmd_buffer[1] = (uint8_t)(crc & 0xFF);
+            }
 #else
             inst->cmd_buffer[0] = 0;
             inst->cmd_buffer[1] = 0;
@@ -811,6 +791,15 @@ static enum sdspi_blk_write_state_result sdspi_handle_write_block(
             // If we make it here the SPI transaction is done
             inst->spi_in_progress = 0;
 
+#if SDSPI_USE_CRC == 1
+            if (inst->hw_crc) {
+                // Get the CRC that the DMAC calculated for the block
+                uint16_t const crc = sdspi_stop_hw_crc(inst);
+                inst->cmd_buffer[0] = (uint8_t)(crc >> 8);
+                inst->cmd_buffer[1] = (uint8_t)(crc & 0xFF);
+            }
+#endif
+
             // Clear out the response buffer because while we just want to grab
             // one byte of response for now the check data rsp state will look
             // for the data response token in the whole response buffer.
@@ -1107,8 +1096,9 @@ static int sdspi_case_handler_set_crc(struct sdspi_desc_t *inst)
  *  After this state completes it will go into the state specified by
  *  inst->acmd_state. If CMD55 fails with the illegal command bit set and
  *  inst->acmd_state is SDSPI_INIT_CARD it will go to SDSPI_INIT_V1_CARD and set
- *  inst->v1_card. If CMD55 fails for any other reason or inst->acmd_state is
- *  not SDSPI_INIT_CARD it will go to SDSPI_FAILED.
+ *  inst->v1_card. If CMD55 is rejected while inst->acmd_state is
+ *  SDSPI_WRITE_SET_ERASE_COUNT the write will be started without pre-erasing.
+ *  If CMD55 fails for any other reason it will go to SDSPI_FAILED.
  */
 static int sdspi_case_handler_next_cmd_app_specific(struct sdspi_desc_t *inst)
 {
@@ -1133,6 +1123,12 @@ static int sdspi_case_handler_next_cmd_app_specific(struct sdspi_desc_t *inst)
             }
 
             if ((rsp.raw != 0x00) && (rsp.raw != 0x01)) {
+                if (inst->acmd_state == SDSPI_WRITE_SET_ERASE_COUNT) {
+                    // Pre-erasing is only an optimization, go ahead with the
+                    // write without it
+                    inst->state = SDSPI_START_WRITE;
+                    return 1;
+                }
                 // Command failed
                 inst->state = SDSPI_FAILED;
                 return 0;
@@ -1152,6 +1148,14 @@ static int sdspi_case_handler_next_cmd_app_specific(struct sdspi_desc_t *inst)
             break;
         case SDSPI_CMD_RES_FAILED:
         case SDSPI_CMD_RES_TIMEOUT:
+            if (inst->acmd_state == SDSPI_WRITE_SET_ERASE_COUNT) {
+                // Command failed
+                if (inst->callback != NULL) {
+                    inst->callback(inst->cb_context, SD_OP_FAILED, 0);
+                }
+                inst->state = SDSPI_IDLE;
+                break;
+            }
             return sdspi_init_retry(inst);
         default:
             // Should not happen
@@ -1661,6 +1665,49 @@ static int sdspi_case_handler_read_get_stop_rsp(struct sdspi_desc_t *inst)
 
 
 
+/**
+ *  Send ACMD23 to tell the card how many blocks are about to be written so that
+ *  it can pre-erase them.
+ */
+static int sdspi_case_handler_write_set_erase_count(struct sdspi_desc_t *inst)
+{
+    uint32_t const count = ((inst->block_count < SDSPI_ACMD23_MAX_BLOCKS) ?
+                            inst->block_count : SDSPI_ACMD23_MAX_BLOCKS);
+
+    enum sdspi_cmd_state_result res;
+    res = sdspi_handle_cmd_state(inst, SDSPI_ACMD23, count, SDSPI_BAUDRATE, 1,
+                                 1, 1, 1);
+
+    switch (res) {
+        case SDSPI_CMD_RES_DONE:
+            // The pre-erase count is only a hint, so we go ahead with the write
+            // even if the card did not accept it
+            inst->state = SDSPI_START_WRITE;
+            return 1;
+        case SDSPI_CMD_RES_AGAIN:
+            return 1;
+        case SDSPI_CMD_RES_BUSY_WAIT:
+        case SDSPI_CMD_RES_QUEUE_WAIT:
+        case SDSPI_CMD_RES_IN_PROGRESS:
+            // Come back later
+            break;
+        case SDSPI_CMD_RES_FAILED:
+        case SDSPI_CMD_RES_TIMEOUT:
+            // Command failed
+            if (inst->callback != NULL) {
+                inst->callback(inst->cb_context, SD_OP_FAILED, 0);
+            }
+            inst->state = SDSPI_IDLE;
+            break;
+        default:
+            // Should not happen
+            inst->state = SDSPI_FAILED;
+            break;
+    }
+
+    return 0;
+}
+
 /**
  *  Send CMD24 or CMD25 to start writing a block or mutliple blocks.
  */
@@ -1719,8 +1766,16 @@ static int sdspi_case_handler_write_blocks(struct sdspi_desc_t *inst)
 {
     enum sdspi_blk_write_state_result res;
 
-    uint8_t const *const data = inst->write_data + (SDSPI_BLOCK_SIZE *
-                                                    inst->blocks_done);
+    uint8_t const *data;
+
+    if (inst->num_segments == 0) {
+        data = inst->write_data + (SDSPI_BLOCK_SIZE * inst->blocks_done);
+    } else {
+        struct sd_segment const *const seg =
+                                    &inst->write_segments[inst->cur_segment];
+        data = seg->data + (SDSPI_BLOCK_SIZE * (inst->blocks_done -
+                                                inst->segment_start));
+    }
 
     res = sdspi_handle_write_block(inst, data, SDSPI_BLOCK_SIZE, 0,
                                    (inst->blocks_done != 0),
@@ -1732,6 +1787,13 @@ static int sdspi_case_handler_write_blocks(struct sdspi_desc_t *inst)
 
             if (inst->blocks_done < inst->block_count) {
                 // Not done yet
+                if ((inst->num_segments != 0) && ((inst->blocks_done -
+                        inst->segment_start) ==
+                        inst->write_segments[inst->cur_segment].num_blocks)) {
+                    // Move on to next segment
+                    inst->segment_start = inst->blocks_done;
+                    inst->cur_segment++;
+                }
                 return 1;
             }
 
@@ -1921,6 +1983,150 @@ static int sdspi_case_handler_write_get_status(struct sdspi_desc_t *inst)
 
 
 
+/**
+ *  Send a command that is part of the erase sequence and go into the next state
+ *  if it succeeds.
+ */
+static int sdspi_handle_erase_cmd(struct sdspi_desc_t *inst, uint8_t cmd_index,
+                                  uint32_t arg, enum sdspi_state next_state)
+{
+    enum sdspi_cmd_state_result res;
+    res = sdspi_handle_cmd_state(inst, cmd_index, arg, SDSPI_BAUDRATE, 1, 1, 1,
+                                 1);
+    union sdspi_response_r1 rsp;
+
+    switch (res) {
+        case SDSPI_CMD_RES_DONE:
+            rsp.raw = inst->cmd_buffer[0];
+
+            if (rsp.raw != 0) {
+                // Command failed
+                if (inst->callback != NULL) {
+                    inst->callback(inst->cb_context, SD_OP_FAILED, 0);
+                }
+
+                inst->state = SDSPI_IDLE;
+                return 0;
+            }
+
+            // Go right into next state
+            inst->state = next_state;
+            return 1;
+        case SDSPI_CMD_RES_AGAIN:
+            return 1;
+        case SDSPI_CMD_RES_BUSY_WAIT:
+        case SDSPI_CMD_RES_QUEUE_WAIT:
+        case SDSPI_CMD_RES_IN_PROGRESS:
+            // Come back later
+            break;
+        case SDSPI_CMD_RES_FAILED:
+        case SDSPI_CMD_RES_TIMEOUT:
+            // Command failed
+            if (inst->callback != NULL) {
+                inst->callback(inst->cb_context, SD_OP_FAILED, 0);
+            }
+            inst->state = SDSPI_IDLE;
+            break;
+        default:
+            // Should not happen
+            inst->state = SDSPI_FAILED;
+            break;
+    }
+
+    return 0;
+}
+
+/**
+ *  Send CMD32 to set the address of the first block to be erased.
+ */
+static int sdspi_case_handler_erase_start(struct sdspi_desc_t *inst)
+{
+    return sdspi_handle_erase_cmd(inst, SDSPI_CMD32, inst->op_addr,
+                                  SDSPI_ERASE_END);
+}
+
+/**
+ *  Send CMD33 to set the address of the last block to be erased.
+ */
+static int sdspi_case_handler_erase_end(struct sdspi_desc_t *inst)
+{
+    uint32_t const last = (inst->op_addr + ((inst->block_count - 1) *
+                                            (inst->block_addressed ? 1 :
+                                             SDSPI_BLOCK_SIZE)));
+    return sdspi_handle_erase_cmd(inst, SDSPI_CMD33, last, SDSPI_ERASE);
+}
+
+/**
+ *  Send CMD38 to erase the selected blocks.
+ */
+static int sdspi_case_handler_erase(struct sdspi_desc_t *inst)
+{
+    // This is updated until the command has been sent so that it ends up being
+    // the time at which the card started erasing
+    inst->erase_start_time = millis;
+    return sdspi_handle_erase_cmd(inst, SDSPI_CMD38, 0,
+                                  SDSPI_ERASE_GET_STATUS);
+}
+
+/**
+ *  Send CMD13 to get card status to see if erase operation suceeded. The card
+ *  holds the bus busy until the erase is complete, which can take much longer
+ *  than the normal command timeout.
+ */
+static int sdspi_case_handler_erase_get_status(struct sdspi_desc_t *inst)
+{
+    enum sdspi_cmd_state_result res;
+    res = sdspi_handle_cmd_state(inst, SDSPI_CMD13, 0, SDSPI_BAUDRATE, 2, 1, 1,
+                                 1);
+    union sdspi_response_r2 rsp;
+
+    switch (res) {
+        case SDSPI_CMD_RES_DONE:
+            rsp = sdspi_swap_r2(inst->cmd_buffer);
+
+            if (inst->callback != NULL) {
+                if ((rsp.raw[0] != 0) || (rsp.raw[1] != 0)) {
+                    inst->callback(inst->cb_context, SD_OP_FAILED, 0);
+                } else {
+                    inst->callback(inst->cb_context, SD_OP_SUCCESS,
+                                   inst->block_count);
+                }
+            }
+
+            // We are all done the erase operation
+            inst->state = SDSPI_IDLE;
+            return 0;
+        case SDSPI_CMD_RES_AGAIN:
+            return 1;
+        case SDSPI_CMD_RES_BUSY_WAIT:
+        case SDSPI_CMD_RES_QUEUE_WAIT:
+        case SDSPI_CMD_RES_IN_PROGRESS:
+            // Come back later
+            break;
+        case SDSPI_CMD_RES_TIMEOUT:
+            if ((millis - inst->erase_start_time) < SDSPI_ERASE_TIMEOUT) {
+                // Card is still busy erasing, check again later
+                break;
+            }
+            /* fallthrough */
+        case SDSPI_CMD_RES_FAILED:
+            // Command failed
+            if (inst->callback != NULL) {
+                inst->callback(inst->cb_context, SD_OP_FAILED, 0);
+            }
+            inst->state = SDSPI_IDLE;
+            break;
+        default:
+            // Should not happen
+            inst->state = SDSPI_FAILED;
+            break;
+    }
+
+    return 0;
+}
+
+
+
 static int sdspi_case_handler_failed(struct sdspi_desc_t *inst)
 {
     // Make sure that we are not leaving a session hanging open
@@ -1950,11 +2156,17 @@ const sdspi_state_handler_t sdspi_state_handlers[] = {
     sdspi_case_handler_read_blocks,             // SDSPI_READ_BLOCKS
     sdspi_case_handler_read_get_stop_rsp,       // SDSPI_READ_GET_STOP_RSP
 
+    sdspi_case_handler_write_set_erase_count,   // SDSPI_WRITE_SET_ERASE_COUNT
     sdspi_case_handler_start_write,             // SDSPI_START_WRITE
     sdspi_case_handler_write_blocks,            // SDSPI_WRITE_BLOCKS
     sdspi_case_handler_write_send_stop_token,   // SDSPI_WRITE_SEND_STOP_TOKEN
     sdspi_case_handler_write_get_status,        // SDSPI_WRITE_GET_STATUS
 
+    sdspi_case_handler_erase_start,             // SDSPI_ERASE_START
+    sdspi_case_handler_erase_end,               // SDSPI_ERASE_END
+    sdspi_case_handler_erase,                   // SDSPI_ERASE
+    sdspi_case_handler_erase_get_status,        // SDSPI_ERASE_GET_STATUS
+
     sdspi_case_handler_failed,                  // SDSPI_UNUSABLE_CARD
     sdspi_case_handler_failed,                  // SDSPI_TOO_MANY_INIT_RETRIES
     sdspi_case_handler_failed                   // SDSPI_FAILED
@@ -87,6 +87,7 @@ void init_sdpsi(struct sdspi_desc_t *inst, struct sercom_spi_desc_t *spi_inst,
     inst->write_data = NULL;
     inst->block_count = 0;
     inst->blocks_done = 0;
+    inst->num_segments = 0;
 
     /** Run service function to get started on initilization of card */
     sdspi_service(inst);
@@ -101,17 +102,25 @@ void init_sdpsi(struct sdspi_desc_t *inst, struct sercom_spi_desc_t *spi_inst,
  */
 void sdspi_service(struct sdspi_desc_t *inst)
 {
+    enum sdspi_state const start_state = inst->state;
+
     int do_next_state = 1;
     while (do_next_state) {
         // Check for ongoing SPI transaction
         if (inst->spi_in_progress &&
             !sercom_spi_transaction_done(inst->spi_inst, inst->spi_tid)) {
             // Waiting for an SPI transaction to complete
-            return;
+            break;
         }
 
         do_next_state = sdspi_state_handlers[inst->state](inst);
     }
+
+    if (inst->state != start_state) {
+        // An operation may have been completed, wake any tasks which are
+        // waiting on the card
+        sched_event_signal(&inst->event);
+    }
 }
 
 enum sdspi_status sdspi_get_status(struct sdspi_desc_t *inst)
@@ -119,11 +128,16 @@ enum sdspi_status sdspi_get_status(struct sdspi_desc_t *inst)
     switch (inst->state) {
         case SDSPI_NOT_PRESENT:
             return SDSPI_STATUS_NO_CARD;
+        case SDSPI_NEXT_CMD_APP_SPECIFIC:
+            if (inst->acmd_state == SDSPI_WRITE_SET_ERASE_COUNT) {
+                // Part of a write operation
+                return SDSPI_STATUS_READY;
+            }
+            /* fallthrough */
         case SDSPI_INIT_CYCLES:
         case SDSPI_SOFT_RESET:
         case SDSPI_SEND_HOST_VOLT_INFO:
         case SDSPI_SET_CRC:
-        case SDSPI_NEXT_CMD_APP_SPECIFIC:
         case SDSPI_INIT_CARD:
         case SDSPI_INIT_V1_CARD:
         case SDSPI_READ_OCR:
@@ -176,6 +190,7 @@ static int sdspi_start_op(struct sdspi_desc_t *inst, uint32_t addr,
     inst->cb_context = context;
     inst->block_count = num_blocks;
     inst->blocks_done = 0;
+    inst->num_segments = 0;
 
     return 0;
 }
@@ -183,6 +198,18 @@ static int sdspi_start_op(struct sdspi_desc_t *inst, uint32_t addr,
 
 
 
+static inline void sdspi_start_write(struct sdspi_desc_t *inst)
+{
+    if (inst->block_count > 1) {
+        // Let the card know how many blocks are coming so that it can pre-erase
+        // them
+        inst->state = SDSPI_NEXT_CMD_APP_SPECIFIC;
+        inst->acmd_state = SDSPI_WRITE_SET_ERASE_COUNT;
+    } else {
+        inst->state = SDSPI_START_WRITE;
+    }
+}
+
 static int sdspi_read(sd_desc_ptr_t inst, uint32_t addr, uint32_t num_blocks,
                       uint8_t *buffer, sd_op_cb_t cb, void *context)
 {
@@ -215,7 +242,65 @@ static int sdspi_write(sd_desc_ptr_t inst, uint32_t addr, uint32_t num_blocks,
     inst.sdspi->write_data = data;
 
     // Jump to correct driver state to start operation
-    inst.sdspi->state = SDSPI_START_WRITE;
+    sdspi_start_write(inst.sdspi);
+
+    // Run the service function to get started right away
+    sdspi_service(inst.sdspi);
+
+    return 0;
+}
+
+static int sdspi_write_v(sd_desc_ptr_t inst, uint32_t addr,
+                         struct sd_segment const *segments,
+                         uint8_t num_segments, sd_op_cb_t cb, void *context)
+{
+    if ((num_segments == 0) || (num_segments > SD_MAX_SEGMENTS)) {
+        return 1;
+    }
+
+    // Find total length of write
+    uint32_t num_blocks = 0;
+    for (uint8_t i = 0; i < num_segments; i++) {
+        if ((segments[i].num_blocks == 0) ||
+                __builtin_add_overflow(num_blocks, segments[i].num_blocks,
+                                       &num_blocks)) {
+            return 1;
+        }
+    }
+
+    int const ret = sdspi_start_op(inst.sdspi, addr, num_blocks, cb, context);
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    // Each block is sent in its own SPI transaction, so the segments can be
+    // sent directly from the caller's buffers without being gathered first
+    inst.sdspi->write_segments = segments;
+    inst.sdspi->num_segments = num_segments;
+    inst.sdspi->cur_segment = 0;
+    inst.sdspi->segment_start = 0;
+
+    // Jump to correct driver state to start operation
+    sdspi_start_write(inst.sdspi);
+
+    // Run the service function to get started right away
+    sdspi_service(inst.sdspi);
+
+    return 0;
+}
+
+static int sdspi_erase(sd_desc_ptr_t inst, uint32_t addr, uint32_t num_blocks,
+                       sd_op_cb_t cb, void *context)
+{
+    int const ret = sdspi_start_op(inst.sdspi, addr, num_blocks, cb, context);
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    // Jump to correct driver state to start operation
+    inst.sdspi->state = SDSPI_ERASE_START;
 
     // Run the service function to get started right away
     sdspi_service(inst.sdspi);
@@ -256,6 +341,8 @@ static uint32_t sdspi_get_num_blocks(sd_desc_ptr_t inst)
 struct sd_funcs const sdspi_sd_funcs = {
     .read = &sdspi_read,
     .write = &sdspi_write,
+    .write_v = &sdspi_write_v,
+    .erase = &sdspi_erase,
     .get_status = sdspi_get_sd_status,
     .get_num_blocks = sdspi_get_num_blocks
 };
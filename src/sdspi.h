@@ -11,6 +11,7 @@
 #include "global.h"
 #include "sd.h"
 #include "sercom-spi.h"
+#include "scheduler.h"
 #include "gpio.h"
 
 enum sdspi_state {
@@ -53,6 +54,9 @@ enum sdspi_state {
     /** Get the response from CMD12 */
     SDSPI_READ_GET_STOP_RSP,
 
+    /** Send ACMD23 to tell the card how many blocks are about to be written so
+        that it can pre-erase them */
+    SDSPI_WRITE_SET_ERASE_COUNT,
     /** Send CMD24 or CMD25 to start writing a block or mutliple blocks */
     SDSPI_START_WRITE,
     /** Send blocks to card with block start tokens and CRCs */
@@ -62,6 +66,16 @@ enum sdspi_state {
     /** Send CMD13 to get status from write operation */
     SDSPI_WRITE_GET_STATUS,
 
+    /** Send CMD32 to set the address of the first block to be erased */
+    SDSPI_ERASE_START,
+    /** Send CMD33 to set the address of the last block to be erased */
+    SDSPI_ERASE_END,
+    /** Send CMD38 to erase the selected blocks */
+    SDSPI_ERASE,
+    /** Send CMD13 to get status from erase operation once the card is no
+        longer busy */
+    SDSPI_ERASE_GET_STATUS,
+
     /** Failure state for when card is not supported */
     SDSPI_UNUSABLE_CARD,
     /** Failure state for when we exceed the retry count while initializing
@@ -102,16 +116,31 @@ struct sdspi_desc_t {
     sd_op_cb_t callback;
     /** Context argument for callback function */
     void *cb_context;
+    /** Tasks to be marked ready when the driver changes state, such as when an
+        operation is completed */
+    struct sched_event_t event;
 
     union {
         /** Buffer where data from read operation should be placed */
         uint8_t *read_buffer;
         /** Buffer from which data should be written in write operation */
         uint8_t const *write_data;
+        /** List of buffers from which data should be written in vectored
+            write operation */
+        struct sd_segment const *write_segments;
+    };
+    union {
+        /** Block number within the current operation at which the current
+            write segment starts */
+        uint32_t segment_start;
+        /** The time at which the erase command was sent, used for timeout */
+        uint32_t erase_start_time;
     };
 
     /** Number of bytes transfered from current block */
     uint16_t bytes_in;
+    /** CRC calculated by the DMAC for the block currently being read */
+    uint16_t block_crc;
 
     /** Pin connected to card detect switch on SD card socket */
     union gpio_pin_t card_detect_pin;
@@ -124,6 +153,12 @@ struct sdspi_desc_t {
     /** Counter for command retries during initialization process */
     uint8_t init_retry_count;
 
+    /** Number of segments in vectored write operation, zero if write data is
+        a single contiguous buffer */
+    uint8_t num_segments;
+    /** Index of segment currently being written in vectored write */
+    uint8_t cur_segment;
+
     /** ID to keep track of SPI transactions */
     uint8_t spi_tid;
 
@@ -147,6 +182,12 @@ struct sdspi_desc_t {
     /** Flag to indicate that the connected card is block rather than byte
         addressed */
     uint8_t block_addressed:1;
+    /** Flag to indicate that the DMAC CRC engine is calculating the CRC for
+        the block currently being transfered */
+    uint8_t hw_crc:1;
+    /** Flag to indicate that block_crc holds the CRC of the block that was
+        just read */
+    uint8_t block_crc_valid:1;
 };
 
 
@@ -0,0 +1,344 @@
+/**
+ * @file spsc-ring.h
+ * @desc Single producer, single consumer ring buffer with power of two capacity
+ * @author agent
+ * @date 2026-10-16
+ * Last Author:
+ * Last Edited On:
+ */
+
+#ifndef spsc_ring_h
+#define spsc_ring_h
+
+#include "global.h"
+
+#include <string.h>
+
+/*
+ *  Unlike circular_buffer_t, this ring never disables interrupts. It is safe
+ *  for exactly one producer and exactly one consumer to access the ring
+ *  concurrently (for example, an ISR producing data and the main loop consuming
+ *  it). The head index is only ever written by the consumer and the tail index
+ *  is only ever written by the producer.
+ *
+ *  The indices are free running and are only masked when the underlying memory
+ *  is accessed, so the number of items in the ring is always tail - head and a
+ *  full ring can be told apart from an empty one without a separate length.
+ *
+ *  Functions which are intended for use only by the producer or only by the
+ *  consumer are noted as such.
+ */
+
+/**
+ *  Instance of a single producer, single consumer ring buffer.
+ */
+struct spsc_ring_t {
+    /** Memory in which the ring contents are stored */
+    uint8_t *buffer;
+    /** Capacity of the ring minus one, the capacity is a power of two */
+    uint16_t mask;
+    /** Free running index of the next item to be read, written only by the
+        consumer */
+    uint16_t head;
+    /** Free running index of the next item to be written, written only by the
+        producer */
+    uint16_t tail;
+};
+
+
+/**
+ *  Initialize a new ring buffer from an existing array.
+ *
+ *  @param ring The ring descriptor to be initialized.
+ *  @param memory The underlying array for the new ring.
+ *  @param capacity The size of the ring, must be a power of two no greater
+ *                  than 32768.
+ *
+ *  @return 0 on success, 1 if the capacity is not valid
+ */
+static inline int init_spsc_ring(struct spsc_ring_t *ring, uint8_t *memory,
+                                 uint16_t capacity)
+{
+    if ((capacity == 0) || ((capacity & (capacity - 1)) != 0) ||
+            (capacity > (UINT16_MAX / 2 + 1))) {
+        return 1;
+    }
+
+    ring->buffer = memory;
+    ring->mask = capacity - 1;
+    ring->head = 0;
+    ring->tail = 0;
+
+    return 0;
+}
+
+/**
+ *  Get the capacity of a ring buffer.
+ *
+ *  @param ring The ring for which the capacity should be determined.
+ *
+ *  @return The capacity of the ring.
+ */
+static inline uint16_t spsc_ring_capacity(struct spsc_ring_t const *ring)
+{
+    return ring->mask + 1;
+}
+
+/**
+ *  Get the number of items in a ring buffer. The result may be stale by the
+ *  time it is used if the other side of the ring is active, but it is always
+ *  safe for the producer to assume at least this much space is used and for
+ *  the consumer to assume at least this many items are available.
+ *
+ *  @param ring The ring for which the number of items should be found.
+ *
+ *  @return The number of items in the ring.
+ */
+static inline uint16_t spsc_ring_length(struct spsc_ring_t const *ring)
+{
+    uint16_t const tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    uint16_t const head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    return (uint16_t)(tail - head);
+}
+
+/**
+ *  Determine the amount of unused space in a ring buffer.
+ *
+ *  @param ring The ring for which the amount of free space should be found.
+ *
+ *  @return The number of free bytes in the ring.
+ */
+static inline uint16_t spsc_ring_unused(struct spsc_ring_t const *ring)
+{
+    return spsc_ring_capacity(ring) - spsc_ring_length(ring);
+}
+
+/**
+ *  Determine if a ring buffer is empty.
+ *
+ *  @param ring The ring for which the empty-ness should be determined.
+ *
+ *  @return A non-zero value if the ring is empty, 0 otherwise
+ */
+static inline int spsc_ring_is_empty(struct spsc_ring_t const *ring)
+{
+    return spsc_ring_length(ring) == 0;
+}
+
+/**
+ *  Determine if a ring buffer is full.
+ *
+ *  @param ring The ring for which the full-ness should be determined.
+ *
+ *  @return A non-zero value if the ring is full, 0 otherwise
+ */
+static inline int spsc_ring_is_full(struct spsc_ring_t const *ring)
+{
+    return spsc_ring_length(ring) == spsc_ring_capacity(ring);
+}
+
+/**
+ *  Get a pointer to the tail of the ring and the number of contiguous unused
+ *  bytes following the pointer. Data can be written directly into this space
+ *  and then added to the ring with spsc_ring_move_tail(). Producer only.
+ *
+ *  @param ring The ring for which the tail should be found.
+ *  @param tail Pointer where a pointer to the tail will be placed.
+ *
+ *  @return The number of contiguous unused bytes in the ring after the tail.
+ */
+static inline uint16_t spsc_ring_get_tail(struct spsc_ring_t *ring,
+                                          uint8_t **tail)
+{
+    // Acquire the head so that the consumer is done with any space it has
+    // released before we write over it
+    uint16_t const head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint16_t const unused = (uint16_t)(spsc_ring_capacity(ring) -
+                                       (uint16_t)(ring->tail - head));
+    uint16_t const index = ring->tail & ring->mask;
+    uint16_t const contiguous = spsc_ring_capacity(ring) - index;
+
+    *tail = ring->buffer + index;
+    return (unused < contiguous) ? unused : contiguous;
+}
+
+/**
+ *  Move the tail of the ring forwards by a certain number of bytes. This has
+ *  the effect of adding `length` bytes, which have already been written after
+ *  the tail, to the ring. Producer only.
+ *
+ *  @note The length must not be greater than the amount of unused space in the
+ *        ring.
+ *
+ *  @param ring The ring for which the tail should be moved.
+ *  @param length The distance which the tail should be moved.
+ */
+static inline void spsc_ring_move_tail(struct spsc_ring_t *ring,
+                                       uint16_t length)
+{
+    // Release the data that was written before the tail is published
+    __atomic_store_n(&ring->tail, (uint16_t)(ring->tail + length),
+                     __ATOMIC_RELEASE);
+}
+
+/**
+ *  Get a pointer to the head of the ring and the number of contiguous bytes in
+ *  the ring following the pointer. Consumer only.
+ *
+ *  @param ring The ring for which the head should be found.
+ *  @param head Pointer where a pointer to the head will be placed.
+ *
+ *  @return The number of contiguous bytes in the ring after the head.
+ */
+static inline uint16_t spsc_ring_get_head(struct spsc_ring_t *ring,
+                                          uint8_t **head)
+{
+    // Acquire the tail so that the data written by the producer is visible
+    uint16_t const tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    uint16_t const length = (uint16_t)(tail - ring->head);
+    uint16_t const index = ring->head & ring->mask;
+    uint16_t const contiguous = spsc_ring_capacity(ring) - index;
+
+    *head = ring->buffer + index;
+    return (length < contiguous) ? length : contiguous;
+}
+
+/**
+ *  Move the head of the ring forwards by a certain number of bytes. This has
+ *  the effect of removing `length` bytes from the ring. Consumer only.
+ *
+ *  @note The length must not be greater than the number of items in the ring.
+ *
+ *  @param ring The ring for which the head should be moved.
+ *  @param length The distance which the head should be moved.
+ */
+static inline void spsc_ring_move_head(struct spsc_ring_t *ring,
+                                       uint16_t length)
+{
+    // Release our reads of the data before the space is given back to the
+    // producer
+    __atomic_store_n(&ring->head, (uint16_t)(ring->head + length),
+                     __ATOMIC_RELEASE);
+}
+
+/**
+ *  Insert an item at the tail of a ring buffer iff there is space available.
+ *  Producer only.
+ *
+ *  @param ring The ring into which data should be inserted.
+ *  @param value The data to be inserted.
+ *
+ *  @return 0 on success, 1 if the ring is full
+ */
+static inline int spsc_ring_push(struct spsc_ring_t *ring, uint8_t value)
+{
+    uint16_t const head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if ((uint16_t)(ring->tail - head) == spsc_ring_capacity(ring)) {
+        return 1;
+    }
+
+    ring->buffer[ring->tail & ring->mask] = value;
+    spsc_ring_move_tail(ring, 1);
+    return 0;
+}
+
+/**
+ *  Get the item from the head of a ring buffer, if available, and remove it
+ *  from the ring. Consumer only.
+ *
+ *  @param ring The ring from which an item should be popped.
+ *  @param value Pointer where the popped item will be stored.
+ *
+ *  @return 0 on success, 1 if the ring is empty
+ */
+static inline int spsc_ring_pop(struct spsc_ring_t *ring, uint8_t *value)
+{
+    uint16_t const tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (tail == ring->head) {
+        return 1;
+    }
+
+    *value = ring->buffer[ring->head & ring->mask];
+    spsc_ring_move_head(ring, 1);
+    return 0;
+}
+
+/**
+ *  Insert as many items as will fit from an array at the tail of a ring
+ *  buffer. Producer only.
+ *
+ *  @param ring The ring into which data should be inserted.
+ *  @param data The data to be inserted.
+ *  @param length The number of items in data.
+ *
+ *  @return The number of items which were inserted.
+ */
+static inline uint16_t spsc_ring_push_n(struct spsc_ring_t *ring,
+                                        uint8_t const *data, uint16_t length)
+{
+    uint16_t const head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint16_t const unused = (uint16_t)(spsc_ring_capacity(ring) -
+                                       (uint16_t)(ring->tail - head));
+    if (length > unused) {
+        length = unused;
+    }
+
+    uint16_t const index = ring->tail & ring->mask;
+    uint16_t const first = spsc_ring_capacity(ring) - index;
+
+    if (length <= first) {
+        memcpy(ring->buffer + index, data, length);
+    } else {
+        memcpy(ring->buffer + index, data, first);
+        memcpy(ring->buffer, data + first, length - first);
+    }
+
+    spsc_ring_move_tail(ring, length);
+    return length;
+}
+
+/**
+ *  Remove up to a certain number of items from the head of a ring buffer and
+ *  copy them into an array. Consumer only.
+ *
+ *  @param ring The ring from which items should be popped.
+ *  @param data The array into which items should be copied.
+ *  @param length The maximum number of items to be popped.
+ *
+ *  @return The number of items which were popped.
+ */
+static inline uint16_t spsc_ring_pop_n(struct spsc_ring_t *ring,
+                                       uint8_t *data, uint16_t length)
+{
+    uint16_t const tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    uint16_t const available = (uint16_t)(tail - ring->head);
+    if (length > available) {
+        length = available;
+    }
+
+    uint16_t const index = ring->head & ring->mask;
+    uint16_t const first = spsc_ring_capacity(ring) - index;
+
+    if (length <= first) {
+        memcpy(data, ring->buffer + index, length);
+    } else {
+        memcpy(data, ring->buffer + index, first);
+        memcpy(data + first, ring->buffer, length - first);
+    }
+
+    spsc_ring_move_head(ring, length);
+    return length;
+}
+
+/**
+ *  Remove all items from a ring buffer. Consumer only.
+ *
+ *  @param ring The ring to be cleared.
+ */
+static inline void spsc_ring_clear(struct spsc_ring_t *ring)
+{
+    uint16_t const tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&ring->head, tail, __ATOMIC_RELEASE);
+}
+
+#endif /* spsc_ring_h */
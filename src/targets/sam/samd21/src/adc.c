@@ -319,7 +319,7 @@ uint8_t init_adc (uint32_t clock_mask, uint32_t clock_freq,
 
 void adc_service (void)
 {
-    if ((millis - adc_state_g.last_sweep_time) > adc_state_g.sweep_period) {
+    if ((millis - adc_state_g.last_sweep_time) >= adc_state_g.sweep_period) {
         /* Enable ADC */
         ADC->CTRLA.bit.ENABLE = 1;
         // Wait for synchronization
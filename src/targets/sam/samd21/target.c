@@ -11,6 +11,7 @@
 
 #include "board.h"
 #include "dma.h"
+#include "profiler.h"
 
 // Micro Trace Buffer
 #ifdef ENABLE_MTB
@@ -119,6 +120,18 @@ static void init_clocks (void)
     // Wait for synchronization
     while (GCLK->STATUS.reg & GCLK_STATUS_SYNCBUSY);
 
+    /* Configure Generic Clock Generator 4 */
+    // Set division factor to 48 for a 1 MHz clock
+    GCLK->GENDIV.reg = GCLK_GENDIV_DIV(48) | GCLK_GENDIV_ID(4);
+    // Wait for synchronization
+    while (GCLK->STATUS.bit.SYNCBUSY);
+    // Write Generic Clock Generator 4 configuration
+    // source from DFLL48M, and enable
+    GCLK->GENCTRL.reg = (GCLK_GENCTRL_ID(4) | GCLK_GENCTRL_SRC_DFLL48M |
+                         GCLK_GENCTRL_GENEN);
+    // Wait for synchronization
+    while (GCLK->STATUS.reg & GCLK_STATUS_SYNCBUSY);
+
     /* Configure OSC8M */
     // Set Prescaler to generate 8 MHz
     SYSCTRL->OSC8M.bit.PRESC = SYSCTRL_OSC8M_PRESC_0_Val;
@@ -239,6 +252,7 @@ void set_perph_generic_clock(enum peripheral_generic_clock channel,
 /* Interrupt Service Routines */
 RAMFUNC void SysTick_Handler(void)
 {
+    profiler_systick_entry();
     millis++;
 }
 
@@ -27,13 +27,16 @@ extern volatile uint32_t millis;
 #define MS_TO_MILLIS(x) (x)
 #define MILLIS_TO_MS(x) (x)
 
-/** Size of logging service buffers */
-#define LOGGING_BUFFER_SIZE 2048
+/** Size of each logging service buffer (must be a multiple of 512 bytes) */
+#define LOGGING_BUFFER_SIZE 1024
+/** Number of buffers in logging service ring (must be a power of two) */
+#define LOGGING_NUM_BUFFERS 4
 
 /* Clocks */
 #define SAMD21_CLK_MSK_48MHZ    GCLK_CLKCTRL_GEN_GCLK0  // DFLL48M
 #define SAMD21_CLK_MSK_32KHZ    GCLK_CLKCTRL_GEN_GCLK1  // XOSC32K
 #define SAMD21_CLK_MSK_8MHZ     GCLK_CLKCTRL_GEN_GCLK3  // OSC8M
+#define SAMD21_CLK_MSK_1MHZ     GCLK_CLKCTRL_GEN_GCLK4  // DFLL48M / 48
 #define SAMD21_CLK_MSK_8KHZ     GCLK_CLKCTRL_GEN_GCLK7  // OSCULP32K / 4
 
 /**
@@ -177,6 +177,8 @@ union sd_acmd23_arg {
     uint32_t raw;
 };
 
+#define SD_ACMD23_MAX_BLOCKS    0x7FFFFF
+
 /**
  *  See SD Physical Layer Simplified Specification v3.01 - Figure 4-3
  */
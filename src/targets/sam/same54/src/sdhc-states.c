@@ -264,7 +264,9 @@ static enum sdhc_substate_rsp sdhc_handle_data(struct sdhc_desc_t *inst,
                                                uint8_t command, uint32_t arg,
                                                uint16_t block_count,
                                                uint16_t block_size,
-                                               uint32_t dma_addr, int write)
+                                               uint32_t dma_addr,
+                                               struct sd_segment const *segments,
+                                               uint8_t num_segments, int write)
 {
     switch (inst->substate) {
         case SDHC_SUBSTATE_START:
@@ -276,21 +278,37 @@ static enum sdhc_substate_rsp sdhc_handle_data(struct sdhc_desc_t *inst,
             inst->sdhc->CCR.bit.SDCLKEN = 1;
             // Enable required interrupts
             sdhc_enable_cmd_interrupts(inst, 1, 1);
-            // Configure ADMA2 descriptor
-            uint32_t const len = block_count * block_size;
-            if (len < 65536) {
-                inst->adma2_desc.length = len;
-            } else if (len == 65536) {
-                inst->adma2_desc.length = 0;
+            // Configure ADMA2 descriptors
+            if (num_segments == 0) {
+                uint32_t const len = block_count * block_size;
+                if (len < 65536) {
+                    inst->adma2_desc[0].length = len;
+                } else if (len == 65536) {
+                    inst->adma2_desc[0].length = 0;
+                } else {
+                    return SDHC_SUBSTATE_RSP_FAILED;
+                }
+                inst->adma2_desc[0].address = dma_addr;
+                inst->adma2_desc[0].attributes.raw = (SDHC_ADMA2_DESC_VALID |
+                                                      SDHC_ADMA2_DESC_END |
+                                                      SDHC_ADMA2_DESC_ACT_TRAN);
             } else {
-                return SDHC_SUBSTATE_RSP_FAILED;
+                // One descriptor per segment, lengths were checked when the
+                // operation was started. A 65536 byte segment is truncated to
+                // a length of 0, which is what the descriptor needs.
+                for (uint8_t i = 0; i < num_segments; i++) {
+                    inst->adma2_desc[i].length = (uint16_t)(
+                                    segments[i].num_blocks * block_size);
+                    inst->adma2_desc[i].address = (uint32_t)segments[i].data;
+                    inst->adma2_desc[i].attributes.raw = (
+                                                    SDHC_ADMA2_DESC_VALID |
+                                                    SDHC_ADMA2_DESC_ACT_TRAN);
+                }
+                inst->adma2_desc[num_segments - 1].attributes.raw |=
+                                                        SDHC_ADMA2_DESC_END;
             }
-            inst->adma2_desc.address = dma_addr;
-            inst->adma2_desc.attributes.raw = (SDHC_ADMA2_DESC_VALID |
-                                               SDHC_ADMA2_DESC_END |
-                                               SDHC_ADMA2_DESC_ACT_TRAN);
             // Set ADMA2 descriptor base address
-            inst->sdhc->ASAR[0].reg = (uint32_t)&inst->adma2_desc;
+            inst->sdhc->ASAR[0].reg = (uint32_t)inst->adma2_desc;
             // Configure registers for command
             unsigned const multi = block_count > 1;
             unsigned const cmd23 = multi && inst->cmd23_supported;
@@ -358,16 +376,18 @@ static enum sdhc_substate_rsp sdhc_handle_read(struct sdhc_desc_t *inst,
                                                uint8_t *destination)
 {
     return sdhc_handle_data(inst, command, arg, block_count, block_size,
-                            (uint32_t)destination, 0);
+                            (uint32_t)destination, NULL, 0, 0);
 }
 
 static enum sdhc_substate_rsp sdhc_handle_write(struct sdhc_desc_t *inst,
                                                 uint8_t command, uint32_t addr,
                                                 uint16_t block_count,
-                                                uint8_t const *source)
+                                                uint8_t const *source,
+                                                struct sd_segment const *segments,
+                                                uint8_t num_segments)
 {
     return sdhc_handle_data(inst, command, addr, block_count, SD_BLOCK_LENGTH,
-                            (uint32_t)source, 1);
+                            (uint32_t)source, segments, num_segments, 1);
 }
 
 
@@ -1195,12 +1215,48 @@ static int sdhc_state_handler_read(struct sdhc_desc_t *inst)
     return 1;
 }
 
+/** Send ACMD23 to set the number of blocks to be pre-erased before writing */
+static int sdhc_state_handler_set_wr_blk_erase_count(struct sdhc_desc_t *inst)
+{
+    union sd_acmd23_arg const arg = {
+        .num_blocks = ((inst->block_count < SD_ACMD23_MAX_BLOCKS) ?
+                       inst->block_count : SD_ACMD23_MAX_BLOCKS)
+    };
+    enum sdhc_substate_rsp res;
+    res = sdhc_handle_command(inst, SD_ACMD23, arg.raw, SDHC_CMD_RSP_TYPE_R1);
+
+    switch (res) {
+        case SDHC_SUBSTATE_RSP_DONE:
+            // The pre-erase count is only a hint, so we go ahead with the write
+            // even if the card did not accept it
+            inst->state = SDHC_WRITE;
+            return 1;
+        case SDHC_SUBSTATE_RSP_LATER:
+            return 0;
+        case SDHC_SUBSTATE_RSP_AGAIN:
+            return 1;
+        case SDHC_SUBSTATE_RSP_CMD_LINE_CONFLICT:
+        case SDHC_SUBSTATE_RSP_CMD_TIMEOUT:
+        case SDHC_SUBSTATE_RSP_CMD_CRC_ERROR:
+        case SDHC_SUBSTATE_RSP_CMD_RSP_ERROR:
+        case SDHC_SUBSTATE_RSP_FAILED:
+            // Skip pre-erasing and go ahead with the write
+            inst->state = SDHC_WRITE;
+            return 1;
+        default:
+            // This shouldn't happen
+            inst->state = SDHC_FAILED;
+            return 0;
+    }
+}
+
 /** Send CMD24 to write a single block or CMD25 to write multiple blocks */
 static int sdhc_state_handler_write(struct sdhc_desc_t *inst)
 {
     enum sdhc_substate_rsp res;
     res = sdhc_handle_write(inst, (inst->block_count > 1) ? SD_CMD25 : SD_CMD24,
-                           inst->op_addr, inst->block_count, inst->write_data);
+                           inst->op_addr, inst->block_count, inst->write_data,
+                           inst->write_segments, inst->num_segments);
     union sd_card_status_rsp rsp;
 
     switch (res) {
@@ -1327,6 +1383,151 @@ static int sdhc_state_handler_get_num_blocks_written(struct sdhc_desc_t *inst)
 
 
 
+/**
+ *  Handle the result of a command that is part of the erase sequence and go
+ *  into the next state if it succeeded.
+ */
+static int sdhc_handle_erase_rsp(struct sdhc_desc_t *inst,
+                                 enum sdhc_substate_rsp res,
+                                 enum sdhc_state next_state)
+{
+    union sd_card_status_rsp rsp;
+
+    switch (res) {
+        case SDHC_SUBSTATE_RSP_DONE:
+            // Check CMD response
+            rsp = sd_get_card_status_rsp(inst->sdhc->RR);
+
+            if (rsp.error || rsp.cc_error || rsp.illegal_comand ||
+                rsp.com_crc_error || rsp.card_is_locked || rsp.erase_param ||
+                rsp.erase_seq_error || rsp.address_error || rsp.out_of_range) {
+                // Command failed
+                inst->callback(inst->cb_context, SD_OP_FAILED, 0);
+                inst->state = SDHC_IDLE;
+                return 1;
+            }
+
+            if (next_state == SDHC_IDLE) {
+                // The erase command was the last in the sequence
+                inst->callback(inst->cb_context, SD_OP_SUCCESS,
+                               inst->block_count);
+            }
+
+            // Success! Ready to move on to next state.
+            inst->state = next_state;
+            return 1;
+        case SDHC_SUBSTATE_RSP_LATER:
+            return 0;
+        case SDHC_SUBSTATE_RSP_AGAIN:
+            return 1;
+        case SDHC_SUBSTATE_RSP_TRAN_TIMEOUT:
+            if (next_state == SDHC_IDLE) {
+                // The erase is taking longer than the data timeout, poll the
+                // card until it is done
+                inst->state = SDHC_ERASE_WAIT;
+                return 0;
+            }
+            /* fallthrough */
+        case SDHC_SUBSTATE_RSP_CMD_LINE_CONFLICT:
+        case SDHC_SUBSTATE_RSP_CMD_TIMEOUT:
+        case SDHC_SUBSTATE_RSP_CMD_CRC_ERROR:
+        case SDHC_SUBSTATE_RSP_CMD_RSP_ERROR:
+        case SDHC_SUBSTATE_RSP_TRAN_CRC_ERROR:
+        case SDHC_SUBSTATE_RSP_TRAN_RSP_ERROR:
+        case SDHC_SUBSTATE_RSP_ACMD_ERROR:
+        case SDHC_SUBSTATE_RSP_ADMA_ERROR:
+        case SDHC_SUBSTATE_RSP_FAILED:
+            // Erase failed
+            inst->callback(inst->cb_context, SD_OP_FAILED, 0);
+            inst->state = SDHC_IDLE;
+            return 1;
+        default:
+            // This shouldn't happen
+            inst->state = SDHC_FAILED;
+            return 0;
+    }
+}
+
+/** Send CMD32 to set the address of the first block to be erased */
+static int sdhc_state_handler_erase_start(struct sdhc_desc_t *inst)
+{
+    enum sdhc_substate_rsp res;
+    res = sdhc_handle_command(inst, SD_CMD32, inst->op_addr,
+                              SDHC_CMD_RSP_TYPE_R1);
+    return sdhc_handle_erase_rsp(inst, res, SDHC_ERASE_END);
+}
+
+/** Send CMD33 to set the address of the last block to be erased */
+static int sdhc_state_handler_erase_end(struct sdhc_desc_t *inst)
+{
+    uint32_t const last = (inst->op_addr + ((inst->block_count - 1) *
+                                            (inst->block_addressed ? 1 :
+                                             SD_BLOCK_LENGTH)));
+    enum sdhc_substate_rsp res;
+    res = sdhc_handle_command(inst, SD_CMD33, last, SDHC_CMD_RSP_TYPE_R1);
+    return sdhc_handle_erase_rsp(inst, res, SDHC_ERASE);
+}
+
+/** Send CMD38 to erase the selected blocks */
+static int sdhc_state_handler_erase(struct sdhc_desc_t *inst)
+{
+    if (inst->substate == SDHC_SUBSTATE_START) {
+        inst->cmd_start_time = millis;
+    }
+
+    enum sdhc_substate_rsp res;
+    res = sdhc_handle_command(inst, SD_CMD38, 0, SDHC_CMD_RSP_TYPE_R1B);
+    return sdhc_handle_erase_rsp(inst, res, SDHC_IDLE);
+}
+
+/** Send CMD13 to check whether the card has finished erasing */
+static int sdhc_state_handler_erase_wait(struct sdhc_desc_t *inst)
+{
+    union sd_rca_arg const arg = { .rca = inst->rca };
+    enum sdhc_substate_rsp res;
+    res = sdhc_handle_command(inst, SD_CMD13, arg.raw, SDHC_CMD_RSP_TYPE_R1);
+    union sd_card_status_rsp rsp;
+
+    switch (res) {
+        case SDHC_SUBSTATE_RSP_DONE:
+            rsp = sd_get_card_status_rsp(inst->sdhc->RR);
+
+            if (rsp.current_state == SD_CURRENT_STATE_PRG) {
+                // Still erasing
+                break;
+            }
+
+            if (rsp.error || rsp.cc_error || rsp.erase_reset) {
+                inst->callback(inst->cb_context, SD_OP_FAILED, 0);
+            } else {
+                inst->callback(inst->cb_context, SD_OP_SUCCESS,
+                               inst->block_count);
+            }
+            inst->state = SDHC_IDLE;
+            return 1;
+        case SDHC_SUBSTATE_RSP_LATER:
+            return 0;
+        case SDHC_SUBSTATE_RSP_AGAIN:
+            return 1;
+        default:
+            // Try again later
+            break;
+    }
+
+    if ((millis - inst->cmd_start_time) > SDHC_ERASE_TIMEOUT) {
+        // Card has been busy for too long
+        inst->callback(inst->cb_context, SD_OP_FAILED, 0);
+        inst->state = SDHC_IDLE;
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+
+
 static int sdhc_state_handler_failed(struct sdhc_desc_t *inst)
 {
     // Make sure that SD clock is off
@@ -1360,9 +1561,15 @@ const sdhc_state_handler_t sdhc_state_handlers[] = {
 
     sdhc_state_handler_read,                    // SDHC_READ
 
+    sdhc_state_handler_set_wr_blk_erase_count,  // SDHC_SET_WR_BLK_ERASE_COUNT
     sdhc_state_handler_write,                   // SDHC_WRITE
     sdhc_state_handler_get_num_blocks_written,  // SDHC_GET_NUM_BLOCKS_WRITTEN
 
+    sdhc_state_handler_erase_start,             // SDHC_ERASE_START
+    sdhc_state_handler_erase_end,               // SDHC_ERASE_END
+    sdhc_state_handler_erase,                   // SDHC_ERASE
+    sdhc_state_handler_erase_wait,              // SDHC_ERASE_WAIT
+
     sdhc_state_handler_failed,                  // SDHC_UNUSABLE_CARD
     sdhc_state_handler_failed,                  // SDHC_TOO_MANY_INIT_RETRIES
     sdhc_state_handler_failed,                  // SDHC_INIT_TIMEOUT
@@ -23,6 +23,7 @@
 #define SDHC_NUM_INIT_RETRIES       5
 #define SDHC_ACMD41_INIT_TIMEOUT    MS_TO_MILLIS(1000)
 #define SDHC_NUM_OP_RETRIES         3
+#define SDHC_ERASE_TIMEOUT          MS_TO_MILLIS(10000)
 
 #define SDHC_BLOCK_SIZE 512
 
@@ -100,6 +100,7 @@ void init_sdhc(struct sdhc_desc_t *inst, Sdhc *sdhc, uint32_t clock_freq,
     inst->read_buffer = NULL;
     inst->write_data = NULL;
     inst->block_count = 0;
+    inst->num_segments = 0;
 
     /* Enable bus clock for SDHC instance */
     enable_bus_clock(sdhc_bus_clocks[inst_num]);
@@ -144,14 +145,22 @@ void init_sdhc(struct sdhc_desc_t *inst, Sdhc *sdhc, uint32_t clock_freq,
 
 void sdhc_service(struct sdhc_desc_t *inst)
 {
+    enum sdhc_state const start_state = inst->state;
+
     int do_next_state = 1;
     while (do_next_state) {
         if (inst->waiting_for_interrupt) {
-            return;
+            break;
         }
 
         do_next_state = sdhc_state_handlers[inst->state](inst);
     }
+
+    if (inst->state != start_state) {
+        // An operation may have been completed, wake any tasks which are
+        // waiting on the card
+        sched_event_signal(&inst->event);
+    }
 }
 
 enum sdhc_status sdhc_get_status(struct sdhc_desc_t *inst)
@@ -160,6 +169,12 @@ enum sdhc_status sdhc_get_status(struct sdhc_desc_t *inst)
         case SDHC_NOT_PRESENT:
             return SDHC_STATUS_NO_CARD;
         case SDHC_APP_CMD:
+            if ((inst->acmd_state == SDHC_SET_WR_BLK_ERASE_COUNT) ||
+                    (inst->acmd_state == SDHC_GET_NUM_BLOCKS_WRITTEN)) {
+                // Part of a write operation
+                return SDHC_STATUS_READY;
+            }
+            /* fallthrough */
         case SDHC_ABORT:
             // Not sure where these two states should go
         case SDHC_RESET:
@@ -178,8 +193,13 @@ enum sdhc_status sdhc_get_status(struct sdhc_desc_t *inst)
             return SDHC_STATUS_INITIALIZING;
         case SDHC_IDLE:
         case SDHC_READ:
+        case SDHC_SET_WR_BLK_ERASE_COUNT:
         case SDHC_WRITE:
         case SDHC_GET_NUM_BLOCKS_WRITTEN:
+        case SDHC_ERASE_START:
+        case SDHC_ERASE_END:
+        case SDHC_ERASE:
+        case SDHC_ERASE_WAIT:
             return SDHC_STATUS_READY;
         case SDHC_UNUSABLE_CARD:
             return SDHC_STATUS_UNUSABLE_CARD;
@@ -209,10 +229,8 @@ static inline int sdhc_start_op(struct sdhc_desc_t *inst, uint32_t addr,
         return 1;
     }
 
-    if ((num_blocks == 0) ||
-        (__builtin_mul_overflow_p(num_blocks, SD_BLOCK_LENGTH,
-                                  inst->adma2_desc.length))) {
-        // Too few or too many blocks
+    if (num_blocks == 0) {
+        // Too few blocks
         return 1;
     }
 
@@ -234,13 +252,33 @@ static inline int sdhc_start_op(struct sdhc_desc_t *inst, uint32_t addr,
     inst->callback = cb;
     inst->cb_context = context;
     inst->block_count = num_blocks;
+    inst->num_segments = 0;
 
     return 0;
 }
 
+static inline void sdhc_start_write(struct sdhc_desc_t *inst)
+{
+    if (inst->block_count > 1) {
+        // Let the card know how many blocks are coming so that it can pre-erase
+        // them. This is separate from the auto CMD23 (SET_BLOCK_COUNT) which
+        // ends the transfer on cards that support it, CMD23 does not cause the
+        // card to pre-erase anything.
+        inst->state = SDHC_APP_CMD;
+        inst->acmd_state = SDHC_SET_WR_BLK_ERASE_COUNT;
+    } else {
+        inst->state = SDHC_WRITE;
+    }
+}
+
 static int sdhc_read(sd_desc_ptr_t inst, uint32_t addr, uint32_t num_blocks,
                      uint8_t *buffer, sd_op_cb_t cb, void *context)
 {
+    if (num_blocks > SDHC_ADMA2_DESC_MAX_BLOCKS) {
+        // Too many blocks for a single ADMA2 descriptor
+        return 1;
+    }
+
     int const ret = sdhc_start_op(inst.sdhc, addr, num_blocks, cb, context);
 
     if (ret != 0) {
@@ -261,6 +299,11 @@ static int sdhc_read(sd_desc_ptr_t inst, uint32_t addr, uint32_t num_blocks,
 static int sdhc_write(sd_desc_ptr_t inst, uint32_t addr, uint32_t num_blocks,
                       uint8_t const *data, sd_op_cb_t cb, void *context)
 {
+    if (num_blocks > SDHC_ADMA2_DESC_MAX_BLOCKS) {
+        // Too many blocks for a single ADMA2 descriptor
+        return 1;
+    }
+
     int const ret = sdhc_start_op(inst.sdhc, addr, num_blocks, cb, context);
 
     if (ret != 0) {
@@ -270,7 +313,67 @@ static int sdhc_write(sd_desc_ptr_t inst, uint32_t addr, uint32_t num_blocks,
     inst.sdhc->write_data = data;
 
     // Jump to correct driver state to start operation
-    inst.sdhc->state = SDHC_WRITE;
+    sdhc_start_write(inst.sdhc);
+
+    // Run the service function to get started right away
+    sdhc_service(inst.sdhc);
+
+    return 0;
+}
+
+static int sdhc_write_v(sd_desc_ptr_t inst, uint32_t addr,
+                        struct sd_segment const *segments, uint8_t num_segments,
+                        sd_op_cb_t cb, void *context)
+{
+    if ((num_segments == 0) || (num_segments > SDHC_ADMA2_NUM_DESC)) {
+        return 1;
+    }
+
+    // Each segment gets its own ADMA2 descriptor
+    uint32_t num_blocks = 0;
+    for (uint8_t i = 0; i < num_segments; i++) {
+        if ((segments[i].num_blocks == 0) ||
+                (segments[i].num_blocks > SDHC_ADMA2_DESC_MAX_BLOCKS) ||
+                (((uint32_t)segments[i].data & 0x3) != 0)) {
+            return 1;
+        }
+        num_blocks += segments[i].num_blocks;
+    }
+
+    if (num_blocks > UINT16_MAX) {
+        // Too many blocks for block count register
+        return 1;
+    }
+
+    int const ret = sdhc_start_op(inst.sdhc, addr, num_blocks, cb, context);
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    inst.sdhc->write_segments = segments;
+    inst.sdhc->num_segments = num_segments;
+
+    // Jump to correct driver state to start operation
+    sdhc_start_write(inst.sdhc);
+
+    // Run the service function to get started right away
+    sdhc_service(inst.sdhc);
+
+    return 0;
+}
+
+static int sdhc_erase(sd_desc_ptr_t inst, uint32_t addr, uint32_t num_blocks,
+                      sd_op_cb_t cb, void *context)
+{
+    int const ret = sdhc_start_op(inst.sdhc, addr, num_blocks, cb, context);
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    // Jump to correct driver state to start operation
+    inst.sdhc->state = SDHC_ERASE_START;
 
     // Run the service function to get started right away
     sdhc_service(inst.sdhc);
@@ -305,6 +408,8 @@ static uint32_t sdhc_get_num_blocks(sd_desc_ptr_t inst)
 struct sd_funcs const sdhc_sd_funcs = {
     .read = &sdhc_read,
     .write = &sdhc_write,
+    .write_v = &sdhc_write_v,
+    .erase = &sdhc_erase,
     .get_status = sdhc_get_sd_status,
     .get_num_blocks = sdhc_get_num_blocks
 };
@@ -351,6 +456,7 @@ static void sdhc_isr(struct sdhc_desc_t *inst)
         inst->waiting_for_interrupt = 1;
         inst->sdhc->NISTER.reg = SDHC_NISTER_CINS;
         inst->sdhc->NISIER.reg = SDHC_NISIER_CINS;
+        sched_event_signal(&inst->event);
         return;
     }
 
@@ -401,6 +507,10 @@ static void sdhc_isr(struct sdhc_desc_t *inst)
     if (ret) {
         (void)sdhc_state_handlers[inst->state](inst);
     }
+
+    // Run the service for anything that was left for it by the state handlers
+    // and wake any tasks which are waiting on an operation that was completed
+    sched_event_signal(&inst->event);
 }
 
 #ifdef SDHC0
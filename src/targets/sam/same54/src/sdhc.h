@@ -12,6 +12,7 @@
 
 #include "global.h"
 #include "sd.h"
+#include "scheduler.h"
 
 
 #define SDHC_ADMA2_DESC_ACT_NOP_Val     0b00
@@ -26,6 +27,13 @@
 #define SDHC_ADMA2_DESC_ACT_TRAN    SDHC_ADMA2_DESC_ACT(SDHC_ADMA2_DESC_ACT_TRAN_Val)
 #define SDHC_ADMA2_DESC_ACT_LINK    SDHC_ADMA2_DESC_ACT(SDHC_ADMA2_DESC_ACT_LINK_Val)
 
+/** Number of entries in ADMA2 descriptor table, one per vectored write segment */
+#define SDHC_ADMA2_NUM_DESC         SD_MAX_SEGMENTS
+/** Largest number of blocks that can be transferred by one ADMA2 descriptor. A
+    descriptor can transfer up to 65536 bytes, a length of 0 in the descriptor
+    means 65536. */
+#define SDHC_ADMA2_DESC_MAX_BLOCKS  (65536UL / SD_BLOCK_LENGTH)
+
 struct sdhc_adma2_descriptor32 {
     union {
         struct {
@@ -97,11 +105,25 @@ enum sdhc_state {
     //
     //  Write States
     //
+    /** Tell the card how many blocks are about to be written with ACMD23 so
+        that it can pre-erase them */
+    SDHC_SET_WR_BLK_ERASE_COUNT,
     /** Write a single block with CMD24 or multiple blocks with CMD25 */
     SDHC_WRITE,
     /** Get the number of blocks that were written with ACMD22 */
     SDHC_GET_NUM_BLOCKS_WRITTEN,
     //
+    //  Erase States
+    //
+    /** Set the address of the first block to be erased with CMD32 */
+    SDHC_ERASE_START,
+    /** Set the address of the last block to be erased with CMD33 */
+    SDHC_ERASE_END,
+    /** Erase the selected blocks with CMD38 */
+    SDHC_ERASE,
+    /** Poll card status with CMD13 until erase is complete */
+    SDHC_ERASE_WAIT,
+    //
     //  Failure States
     //
     /** Failure state for when card is not supported */
@@ -119,7 +141,7 @@ enum sdhc_state {
 struct sdhc_desc_t {
     uint8_t buffer[64];
 
-    struct sdhc_adma2_descriptor32 adma2_desc;
+    struct sdhc_adma2_descriptor32 adma2_desc[SDHC_ADMA2_NUM_DESC];
 
     /** SD Host Controller Instance */
     Sdhc *sdhc;
@@ -135,19 +157,28 @@ struct sdhc_desc_t {
 
     /** Address for read or write operation */
     uint32_t op_addr;
-    /** Total number of blocks for read or write operation */
-    uint16_t block_count;
+    /** Total number of blocks for read, write or erase operation */
+    uint32_t block_count;
     /** Callback function to be called when operation is complete */
     sd_op_cb_t callback;
     /** Context argument for callback function */
     void *cb_context;
+    /** Tasks to be marked ready when the driver changes state, such as when an
+        operation is completed */
+    struct sched_event_t event;
 
     union {
         /** Buffer where data from read operation should be placed */
         uint8_t *read_buffer;
         /** Buffer from which data should be written in write operation */
         uint8_t const *write_data;
+        /** List of buffers from which data should be written in vectored
+            write operation */
+        struct sd_segment const *write_segments;
     };
+    /** Number of segments in vectored write operation, zero if write data is
+        a single contiguous buffer */
+    uint8_t num_segments;
 
     uint16_t rca;
 
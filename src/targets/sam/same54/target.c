@@ -11,6 +11,7 @@
 
 #include "board.h"
 #include "dma.h"
+#include "profiler.h"
 
 /* Initialization functions */
 
@@ -148,6 +149,13 @@ static void init_clocks (void)
     // Wait for generic clock generator 2 to be ready
     while (GCLK->SYNCBUSY.reg & GCLK_SYNCBUSY_GENCTRL2);
 
+    /* Configure Generic Clock Generator 6 with DFLL as source div by 48 */
+    // Divide by 48 for a 1 MHz clock, DFLL as source
+    GCLK->GENCTRL[6].reg = (GCLK_GENCTRL_DIV(48) | GCLK_GENCTRL_SRC_DFLL |
+                            GCLK_GENCTRL_GENEN);
+    // Wait for generic clock generator 6 to be ready
+    while (GCLK->SYNCBUSY.reg & GCLK_SYNCBUSY_GENCTRL6);
+
 
 #ifdef ENABLE_XOSC0
     // XOSC0 is enabled, use it to provide a 12 MHz clock on GCLK_GEN 4.
@@ -423,7 +431,8 @@ void set_perph_generic_clock(enum peripheral_generic_clock channel,
 
 void SysTick_Handler(void)
 {
-    return;
+    // SysTick is only enabled to measure interrupt latency
+    profiler_systick_entry();
 }
 
 void HardFault_Handler(void)
@@ -27,8 +27,10 @@
 #define MS_TO_MILLIS(x) ((((x) * UINT32_C(1024)) + UINT32_C(500)) / UINT32_C(1000))
 #define MILLIS_TO_MS(x) ((((x) * UINT32_C(1000)) + UINT32_C(512)) / UINT32_C(1024))
 
-/** Size of logging service buffers */
-#define LOGGING_BUFFER_SIZE 8192
+/** Size of each logging service buffer (must be a multiple of 512 bytes) */
+#define LOGGING_BUFFER_SIZE 2048
+/** Number of buffers in logging service ring (must be a power of two) */
+#define LOGGING_NUM_BUFFERS 8
 
 /* Clocks */
 #define ENABLE_XOSC0
@@ -38,6 +40,7 @@
 #define SAME54_CLK_MSK_32KHZ    GCLK_PCHCTRL_GEN_GCLK3  // XOSC32K
 #define SAME54_CLK_MSK_12MHZ    GCLK_PCHCTRL_GEN_GCLK4  // XOSC0 or DFLL48M / 4
 #define SAME54_CLK_MSK_100MHZ   GCLK_PCHCTRL_GEN_GCLK5  // DPLL1
+#define SAME54_CLK_MSK_1MHZ     GCLK_PCHCTRL_GEN_GCLK6  // DFLL48M / 48
 
 /**
  *  Enum that defines common names for SAM peripheral clock channels that can be
@@ -11,6 +11,9 @@
 
 #define DMA_IRQ_PRIORITY    2
 
+/** CRC input source value which selects a DMA channel */
+#define DMA_CRC_SRC_CHAN(chan)  (0x20 + (chan))
+
 
 static DmacDescriptor dmacDescriptors_g[DMAC_CH_NUM] __attribute__((aligned(16)));
 static DmacDescriptor dmacWriteBack_g[DMAC_CH_NUM] __attribute__((aligned(16)));
@@ -19,6 +22,9 @@ static DmacDescriptor dmacWriteBack_g[DMAC_CH_NUM] __attribute__((aligned(16)));
 struct dma_callback_t dma_callbacks[DMAC_CH_NUM];
 static struct dma_circ_transfer_t *dmaCircBufferTransfers[DMAC_CH_NUM];
 
+/** Set while the CRC engine has been claimed by dma_start_crc16() */
+static uint8_t dma_crc_in_use;
+
 
 void init_dmac(void)
 {
@@ -162,6 +168,39 @@ void dma_config_transfer(uint8_t chan, enum dma_width beatsize,
 
 
 
+void dma_config_looping_transfer(uint8_t chan, enum dma_width beatsize,
+                                 const volatile void *source,
+                                 int increment_source,
+                                 volatile void *destination,
+                                 int increment_destination, uint16_t length,
+                                 uint8_t trigger, uint8_t priority)
+{
+    /* Configure DMA channel */
+    dma_config_channel(chan, trigger, priority);
+
+    /* Configure transfer descriptor */
+    // The descriptor is its own next descriptor so that the transfer starts
+    // over as soon as the block is complete. No interrupt is generated at the
+    // end of each block.
+    dma_config_desc(&dmacDescriptors_g[chan], beatsize, source,
+                    increment_source, destination, increment_destination,
+                    length, &dmacDescriptors_g[chan]);
+
+    /* Enable channel */
+    dma_enable_channel(chan);
+}
+
+uint16_t dma_get_remaining_beats(uint8_t chan)
+{
+    // If the channel is currently active the count in the write back
+    // descriptor may be stale, use the count from the active channel instead
+    if (DMAC->ACTIVE.bit.ABUSY && (DMAC->ACTIVE.bit.ID == chan)) {
+        return DMAC->ACTIVE.bit.BTCNT;
+    }
+
+    return dmacWriteBack_g[chan].BTCNT.reg;
+}
+
 int8_t dma_config_circular_buffer_to_static(struct dma_circ_transfer_t *tran,
                                             uint8_t chan,
                                             struct circular_buffer_t *buffer,
@@ -266,6 +305,54 @@ void dma_abort_transfer(uint8_t chan)
 #endif
 }
 
+
+int8_t dma_start_crc16(uint8_t chan, uint16_t initial)
+{
+    if (dma_crc_in_use) {
+        return 1;
+    }
+    dma_crc_in_use = 1;
+
+#if defined(SAMD2x)
+    // The CRC control and checksum registers can only be written while the
+    // CRC module is disabled
+    DMAC->CTRL.bit.CRCENABLE = 0b0;
+    DMAC->CRCCTRL.reg = (DMAC_CRCCTRL_CRCBEATSIZE_BYTE |
+                         DMAC_CRCCTRL_CRCPOLY_CRC16 |
+                         DMAC_CRCCTRL_CRCSRC(DMA_CRC_SRC_CHAN(chan)));
+    DMAC->CRCCHKSUM.reg = initial;
+    DMAC->CTRL.bit.CRCENABLE = 0b1;
+#elif defined(SAMx5x)
+    // The checksum register can only be written while the CRC source is
+    // disabled
+    DMAC->CRCCTRL.reg = DMAC_CRCCTRL_CRCSRC_DISABLE;
+    DMAC->CRCSTATUS.reg = DMAC_CRCSTATUS_CRCBUSY;
+    DMAC->CRCCHKSUM.reg = initial;
+    DMAC->CRCCTRL.reg = (DMAC_CRCCTRL_CRCBEATSIZE_BYTE |
+                         DMAC_CRCCTRL_CRCPOLY_CRC16 |
+                         DMAC_CRCCTRL_CRCSRC(DMA_CRC_SRC_CHAN(chan)));
+#endif
+
+    return 0;
+}
+
+uint16_t crc_calc_crc16(void)
+{
+    uint16_t const crc = (uint16_t)DMAC->CRCCHKSUM.reg;
+
+    // Stop feeding DMA beats into the CRC engine
+#if defined(SAMD2x)
+    DMAC->CTRL.bit.CRCENABLE = 0b0;
+    DMAC->CRCCTRL.reg = DMAC_CRCCTRL_CRCSRC_NOACT;
+#elif defined(SAMx5x)
+    DMAC->CRCCTRL.reg = DMAC_CRCCTRL_CRCSRC_DISABLE;
+    DMAC->CRCSTATUS.reg = DMAC_CRCSTATUS_CRCBUSY;
+#endif
+
+    dma_crc_in_use = 0;
+    return crc;
+}
+
 #if defined(SAMD2x)
 void DMAC_Handler (void)
 #elif defined(SAMx5x)
@@ -96,6 +96,43 @@ extern void dma_config_transfer(uint8_t chan, enum dma_width beatsize,
                                 uint8_t trigger, uint8_t priority,
                                 DmacDescriptor *next);
 
+/**
+ *  Configure a DMA transfer which starts over from the beginning each time it
+ *  completes and enable the channel. This can be used to continuously fill a
+ *  ring buffer from a peripheral. The transfer runs until it is aborted and
+ *  does not generate any interrupts.
+ *
+ *  @note The source and destination addresses must be aligned to the beat size.
+ *
+ *  @param chan The DMA channel to be used.
+ *  @param beatsize The number of bytes to transfer in each beat of this
+ *                  transfer
+ *  @param source The address from which data should be copied
+ *  @param increment_source Whether the source address should be incremented
+ *  @param destination The address to which data should be copied
+ *  @param increment_destination Whether the destination address should be
+ *                               incremented
+ *  @param length The number of beats in each repetition of the transfer
+ *  @param trigger The trigger which should be used to control the transfer
+ *  @param priority The priority level of the transfer
+ */
+extern void dma_config_looping_transfer(uint8_t chan, enum dma_width beatsize,
+                                        const volatile void *source,
+                                        int increment_source,
+                                        volatile void *destination,
+                                        int increment_destination,
+                                        uint16_t length, uint8_t trigger,
+                                        uint8_t priority);
+
+/**
+ *  Get the number of beats remaining in the current block of a transfer.
+ *
+ *  @param chan The DMA channel for which the remaining beats should be found.
+ *
+ *  @return The number of beats left before the end of the current block.
+ */
+extern uint16_t dma_get_remaining_beats(uint8_t chan);
+
 /**
  *  Transfer all of the data in a circular buffer to a static address. Uses a
  *  one byte block size.
@@ -147,6 +184,29 @@ inline static uint8_t dma_chan_is_active(uint8_t chan)
 
 
 
+/**
+ *  Start calculating a CRC-16 (CRC-CCITT) over every byte that is transferred
+ *  by a DMA channel. The CRC engine can only be used by one channel at a time
+ *  and must be released with crc_calc_crc16() once the transfers are done.
+ *
+ *  @note The CRC is calculated over all beats of the channel, so the engine
+ *        should be started before the transfer is configured and the result
+ *        read only after the transfer is complete.
+ *
+ *  @param chan The DMA channel whose transfers should be fed into the CRC
+ *  @param initial The value to seed the CRC checksum with, this can be used to
+ *                 continue a CRC started in software
+ *
+ *  @return 0 on success, 1 if the CRC engine is already in use
+ */
+extern int8_t dma_start_crc16(uint8_t chan, uint16_t initial);
+
+/**
+ *  Get the result of a CRC-16 calculation started with dma_start_crc16() and
+ *  release the CRC engine.
+ *
+ *  @return The calculated CRC-16 value
+ */
 extern uint16_t crc_calc_crc16(void);
 
 extern void crc_calc_crc32(void);
@@ -723,6 +723,39 @@ uint8_t gpio_disable_interrupt(union gpio_pin_t pin)
 }
 
 
+uint8_t gpio_enable_event(union gpio_pin_t pin, uint8_t *generator)
+{
+    if (pin.type != GPIO_INTERNAL_PIN) {
+        // Only the EIC can generate events
+        return 1;
+    }
+
+    int8_t const int_num = gpio_pin_interrupts[pin.internal.raw];
+
+    union gpio_pin_t enabled_pin;
+    if ((int_num < 0) || get_pin_for_interrupt(int_num, &enabled_pin) ||
+            (enabled_pin.raw != pin.raw)) {
+        // The EIC line for this pin is not configured for this pin
+        return 1;
+    }
+
+#if defined(SAMx5x)
+    // Disable EIC since EVCTRL register is enable protected
+    EIC->CTRLA.bit.ENABLE = 0;
+    while(EIC->SYNCBUSY.bit.ENABLE);
+#endif
+
+    EIC->EVCTRL.reg |= (1 << int_num);
+
+#if defined(SAMx5x)
+    // Re-enable EIC
+    EIC->CTRLA.bit.ENABLE = 1;
+#endif
+
+    *generator = EVSYS_ID_GEN_EIC_EXTINT_0 + int_num;
+    return 0;
+}
+
 
 static void gpio_mcp23s17_int_cb (void *context, union gpio_pin_t pin,
                                   uint8_t value)
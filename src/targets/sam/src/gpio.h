@@ -223,6 +223,19 @@ extern uint8_t gpio_enable_interrupt(union gpio_pin_t pin,
  */
 extern uint8_t gpio_disable_interrupt(union gpio_pin_t pin);
 
+/**
+ *  Enable the event output for a pin which already has an interrupt enabled.
+ *  An event is generated on the same condition that triggers the interrupt.
+ *
+ *  @param pin The pin for which the event should be enabled, must be an
+ *             internal pin
+ *  @param generator Pointer to where the EVSYS event generator ID for the pin
+ *                   will be stored
+ *
+ *  @return 0 if the event was enabled successfully, 1 otherwise
+ */
+extern uint8_t gpio_enable_event(union gpio_pin_t pin, uint8_t *generator);
+
 /**
  *  Check if a pin is invalid (e.g. PIN_NONE).
  *
@@ -478,6 +478,9 @@ static inline void sercom_i2c_end_transaction (
         transaction_queue_invalidate(t);
         s->reg.callback(state, context);
     }
+
+    // Wake any tasks which are waiting on this transaction
+    sched_event_signal(&i2c_inst->event);
     
     // Run the I2C service to start the next transaction if there is one
     sercom_i2c_service(i2c_inst);
@@ -561,6 +564,14 @@ void sercom_i2c_service (struct sercom_i2c_desc_t *i2c_inst)
             i2c_inst->sercom->I2CM.INTENCLR.reg = (SERCOM_I2CM_INTENCLR_MB |
                                                    SERCOM_I2CM_INTENCLR_SB |
                                                    SERCOM_I2CM_INTENCLR_ERROR);
+
+            // Wake any tasks which are waiting on this transaction
+            sched_event_signal(&i2c_inst->event);
+        } else if ((s->state == I2C_STATE_WAIT_FOR_RX) ||
+                   (s->state == I2C_STATE_WAIT_FOR_DONE)) {
+            // There is no interrupt for the bus becoming idle, make sure that
+            // the service is run again on the next pass through the main loop
+            sched_event_signal(&i2c_inst->event);
         }
         
         i2c_inst->service_lock = 0;
@@ -575,6 +586,7 @@ void sercom_i2c_service (struct sercom_i2c_desc_t *i2c_inst)
     } else if (i2c_inst->wait_for_idle) {
         // The bus still isn't idle, return now so that we don't start
         // doubly waiting for idle.
+        sched_event_signal(&i2c_inst->event);
         i2c_inst->service_lock = 0;
         return;
     }
@@ -614,6 +626,9 @@ void sercom_i2c_service (struct sercom_i2c_desc_t *i2c_inst)
     } else {
         // There is a pending transaction but the bus is not idle... eek
         i2c_inst->wait_for_idle = 1;
+        // There is no interrupt for the bus becoming idle, make sure that the
+        // service is run again on the next pass through the main loop
+        sched_event_signal(&i2c_inst->event);
         // Keep checking if the bus has become idle as often as possible
         //inhibit_sleep();
     }
@@ -833,6 +848,8 @@ void sercom_i2c_dma_callback (uint8_t chan, void *state)
                 // Inhibit sleep as the delay before the bus is idle may be much
                 // less than the time that the CPU normally spends sleeping
                 inhibit_sleep();
+                // The service must be run to finish the transaction
+                sched_event_signal(&i2c_inst->event);
                 break;
             }
             // RX Complete, transaction is done
@@ -848,6 +865,8 @@ void sercom_i2c_dma_callback (uint8_t chan, void *state)
             // Inhibit sleep as the delay before the bus is idle may be much
             // less than the time that the CPU normally spends sleeping
             inhibit_sleep();
+            // The service must be run to finish the transaction
+            sched_event_signal(&i2c_inst->event);
             break;
         default:
             break;
@@ -13,6 +13,7 @@
 #include "global.h"
 
 #include "transaction-queue.h"
+#include "scheduler.h"
 
 #define I2C_ADDRESS_MASK 0xFE
 
@@ -170,6 +171,10 @@ struct sercom_i2c_desc_t {
     struct sercom_i2c_transaction_t states[SERCOM_I2C_TRANSACTION_QUEUE_LENGTH];
     /** Queue of I2C transactions. */
     struct transaction_queue_t queue;
+
+    /** Tasks to be marked ready when a transaction is completed or when the
+        service needs to be run to make progress on a transaction */
+    struct sched_event_t event;
     
     /** The instance number of the SERCOM hardware of this I2C instance. */
     uint8_t sercom_instnum;
@@ -604,6 +604,9 @@ static inline void sercom_spi_end_transaction (
         s->callback(s->context);
     }
 
+    // Wake any tasks which are waiting on this transaction
+    sched_event_signal(&spi_inst->event);
+
     // Run the SPI service to start the next transaction if there is one
     sercom_spi_service(spi_inst);
 }
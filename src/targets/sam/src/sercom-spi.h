@@ -13,6 +13,7 @@
 #include "global.h"
 
 #include "transaction-queue.h"
+#include "scheduler.h"
 
 #define SERCOM_SPI_TRANSACTION_QUEUE_LENGTH 16
 
@@ -88,6 +89,9 @@ struct sercom_spi_desc_t {
     /** Queue of SPI transactions. */
     struct transaction_queue_t queue;
 
+    /** Tasks to be marked ready when a transaction is completed */
+    struct sched_event_t event;
+
     /** The instance number of the SERCOM hardware of this SPI instance. */
     uint8_t sercom_instnum;
 
@@ -243,6 +247,22 @@ extern uint8_t sercom_spi_transaction_done(struct sercom_spi_desc_t *spi_inst,
 extern uint8_t sercom_spi_clear_transaction(struct sercom_spi_desc_t *spi_inst,
                                             uint8_t trans_id);
 
+/**
+ *  Check if there is space in the queue for another SPI transaction.
+ *
+ *  @note A transaction started from an interrupt after this check may still
+ *        take the last space in the queue.
+ *
+ *  @param spi_inst The SPI instance for which the queue should be checked.
+ *
+ *  @return A non-zero value if there is space for another transaction.
+ */
+static inline uint8_t sercom_spi_queue_has_space(
+                                        struct sercom_spi_desc_t *spi_inst)
+{
+    return transaction_queue_get_free(&spi_inst->queue) != NULL;
+}
+
 /**
  *  Queue a session transaction. When a session transaction is at the head of
  *  the queue, the queue will not advance until the session is ended with
@@ -16,13 +16,16 @@
 static void sercom_uart_isr_dre (Sercom *sercom, uint8_t inst_num, void *state);
 static void sercom_uart_isr_rxc (Sercom *sercom, uint8_t inst_num, void *state);
 static void sercom_uart_dma_callback (uint8_t chan, void *state);
+static uint16_t sercom_uart_rx_dma_sync (struct sercom_uart_desc_t *uart);
+static void sercom_uart_start_tx (struct sercom_uart_desc_t *uart);
 
 
 
 void init_sercom_uart (struct sercom_uart_desc_t *descriptor, Sercom *sercom,
                        uint32_t baudrate, uint32_t core_freq,
                        uint32_t core_clock_mask, int8_t dma_channel,
-                       uint8_t echo, uint8_t tx_pin_group, uint8_t tx_pin_num)
+                       int8_t rx_dma_channel, uint8_t echo,
+                       uint8_t tx_pin_group, uint8_t tx_pin_num)
 {
     uint8_t instance_num = sercom_get_inst_num(sercom);
 
@@ -77,6 +80,8 @@ void init_sercom_uart (struct sercom_uart_desc_t *descriptor, Sercom *sercom,
     descriptor->sercom = sercom;
     descriptor->sercom_instnum = instance_num;
     descriptor->echo = echo;
+    descriptor->baudrate = baudrate;
+    descriptor->core_freq = core_freq;
 
     // Configure buffers
     init_circular_buffer(&descriptor->out_buffer,
@@ -85,6 +90,7 @@ void init_sercom_uart (struct sercom_uart_desc_t *descriptor, Sercom *sercom,
     init_circular_buffer(&descriptor->in_buffer,
                          (uint8_t*)descriptor->in_buffer_mem,
                          SERCOM_UART_IN_BUFFER_LEN);
+    descriptor->rx_dropped = 0;
 
     // Configure DMA
     if ((dma_channel >= 0) && (dma_channel < DMAC_CH_NUM)) {
@@ -97,9 +103,17 @@ void init_sercom_uart (struct sercom_uart_desc_t *descriptor, Sercom *sercom,
         };
     }
 
+    // Configure DMA for reception, the receive complete interrupt is used when
+    // echo is enabled so that line editing can be handled as bytes arrive
+    if ((rx_dma_channel >= 0) && (rx_dma_channel < DMAC_CH_NUM) && !echo) {
+        descriptor->rx_dma_chan = (uint8_t)rx_dma_channel;
+        descriptor->rx_use_dma = 0b1;
+    }
+
     // Configure break condition state
     descriptor->break_duration = 0;
     descriptor->break_pending = 0;
+    descriptor->tx_started = 0;
 
     // Store TX pin info
     descriptor->tx_pin_group = tx_pin_group;
@@ -113,6 +127,21 @@ void init_sercom_uart (struct sercom_uart_desc_t *descriptor, Sercom *sercom,
 
     /* Enable SERCOM instance */
     sercom->USART.CTRLA.bit.ENABLE = 0b1;
+
+    if (descriptor->rx_use_dma) {
+        // Received bytes are moved by the DMAC instead of the RXC interrupt
+        sercom->USART.INTENCLR.bit.RXC = 0b1;
+
+        // Start a transfer which fills the input buffer memory over and over
+        // again, the input buffer's tail is caught up to the DMA transfer's
+        // position by sercom_uart_rx_dma_sync()
+        dma_config_looping_transfer(descriptor->rx_dma_chan, DMA_WIDTH_BYTE,
+                            (volatile uint8_t*)&sercom->USART.DATA, 0,
+                            descriptor->in_buffer_mem, 1,
+                            SERCOM_UART_IN_BUFFER_LEN,
+                            sercom_get_dma_rx_trigger(instance_num),
+                            SERCOM_DMA_RX_PRIORITY);
+    }
 }
 
 uint16_t sercom_uart_put_string(struct sercom_uart_desc_t *uart,
@@ -135,7 +164,7 @@ uint16_t sercom_uart_put_string(struct sercom_uart_desc_t *uart,
     
     // Make sure that we start transmission right away if there is no
     // transmission already in progress.
-    sercom_uart_service(uart);
+    sercom_uart_start_tx(uart);
     
     return i;
 }
@@ -150,7 +179,7 @@ void sercom_uart_put_string_blocking(struct sercom_uart_desc_t *uart,
         while (circular_buffer_is_full(&uart->out_buffer)) {
             // Make sure that we aren't waiting for a transaction which is not
             // in progress.
-            sercom_uart_service(uart);
+            sercom_uart_start_tx(uart);
         }
         
         if (carriage_return) {
@@ -172,7 +201,7 @@ void sercom_uart_put_string_blocking(struct sercom_uart_desc_t *uart,
     
     // Make sure that we start transmission right away if there is no
     // transmission already in progress.
-    sercom_uart_service(uart);
+    sercom_uart_start_tx(uart);
 }
 
 uint16_t sercom_uart_put_bytes(struct sercom_uart_desc_t *uart,
@@ -189,7 +218,7 @@ uint16_t sercom_uart_put_bytes(struct sercom_uart_desc_t *uart,
     
     // Make sure that we start transmission right away if there is no
     // transmission already in progress.
-    sercom_uart_service(uart);
+    sercom_uart_start_tx(uart);
     
     return i;
 }
@@ -202,7 +231,7 @@ void sercom_uart_put_bytes_blocking(struct sercom_uart_desc_t *uart,
         while (circular_buffer_is_full(&uart->out_buffer)) {
             // Make sure that we aren't waiting for a transaction which is not
             // in progress.
-            sercom_uart_service(uart);
+            sercom_uart_start_tx(uart);
         }
         
         circular_buffer_push(&uart->out_buffer, bytes[i]);
@@ -210,7 +239,58 @@ void sercom_uart_put_bytes_blocking(struct sercom_uart_desc_t *uart,
     
     // Make sure that we start transmission right away if there is no
     // transmission already in progress.
-    sercom_uart_service(uart);
+    sercom_uart_start_tx(uart);
+}
+
+uint16_t sercom_uart_put_hex(struct sercom_uart_desc_t *uart,
+                             const uint8_t *bytes, uint16_t length)
+{
+    static const char hex_digits[] = "0123456789ABCDEF";
+
+    uint16_t i = 0;
+    while (i < length) {
+        uint8_t *tail;
+        uint16_t const space = circular_buffer_get_tail(&uart->out_buffer,
+                                                        &tail);
+
+        if (space < 2) {
+            // The contiguous space at the end of the buffer can't fit a whole
+            // byte, split the next byte across the end of the buffer if there
+            // is room for it
+            if (circular_buffer_unused(&uart->out_buffer) < 2) {
+                break;
+            }
+            circular_buffer_push(&uart->out_buffer,
+                                 (uint8_t)hex_digits[bytes[i] >> 4]);
+            circular_buffer_push(&uart->out_buffer,
+                                 (uint8_t)hex_digits[bytes[i] & 0xF]);
+            i++;
+            continue;
+        }
+
+        uint16_t chunk = space / 2;
+        if (chunk > (length - i)) {
+            chunk = length - i;
+        }
+
+        for (uint16_t j = 0; j < chunk; j++) {
+            uint8_t const b = bytes[i + j];
+            tail[2 * j] = (uint8_t)hex_digits[b >> 4];
+            tail[(2 * j) + 1] = (uint8_t)hex_digits[b & 0xF];
+        }
+
+        circular_buffer_move_tail(&uart->out_buffer, chunk * 2);
+        i += chunk;
+
+        // Start transmitting this chunk while the next one is encoded
+        sercom_uart_start_tx(uart);
+    }
+
+    // Make sure that we start transmission right away if there is no
+    // transmission already in progress.
+    sercom_uart_start_tx(uart);
+
+    return i;
 }
 
 void sercom_uart_put_char (struct sercom_uart_desc_t *uart, char c)
@@ -225,12 +305,14 @@ void sercom_uart_put_char (struct sercom_uart_desc_t *uart, char c)
     
     // Make sure that we start transmission right away if there is no
     // transmission already in progress.
-    sercom_uart_service(uart);
+    sercom_uart_start_tx(uart);
 }
 
 void sercom_uart_get_string (struct sercom_uart_desc_t *uart, char *str,
                              uint16_t len)
 {
+    sercom_uart_rx_dma_sync(uart);
+
     for (uint16_t i = 0; i < (len - 1); i++) {
         uint8_t pop_failed = circular_buffer_pop(&uart->in_buffer,
                                                  (uint8_t*)(str + i));
@@ -246,12 +328,15 @@ void sercom_uart_get_string (struct sercom_uart_desc_t *uart, char *str,
 
 uint8_t sercom_uart_has_delim (struct sercom_uart_desc_t *uart, char delim)
 {
+    sercom_uart_rx_dma_sync(uart);
     return circular_buffer_has_char(&uart->in_buffer, delim);
 }
 
 void sercom_uart_get_line_delim (struct sercom_uart_desc_t *uart, char delim,
                                  char *str, uint16_t len)
 {
+    sercom_uart_rx_dma_sync(uart);
+
     for (uint16_t i = 0; i < (len - 1); i++) {
         uint8_t pop_failed = circular_buffer_pop(&uart->in_buffer,
                                                  (uint8_t*)(str + i));
@@ -267,12 +352,15 @@ void sercom_uart_get_line_delim (struct sercom_uart_desc_t *uart, char delim,
 
 uint8_t sercom_uart_has_line (struct sercom_uart_desc_t *uart)
 {
+    sercom_uart_rx_dma_sync(uart);
     return circular_buffer_has_line(&uart->in_buffer);
 }
 
 void sercom_uart_get_line (struct sercom_uart_desc_t *uart, char *str,
                            uint16_t len)
 {
+    sercom_uart_rx_dma_sync(uart);
+
     uint8_t last_char_cr = 0;
     for (uint16_t i = 0; i < (len - 1); i++) {
         uint8_t pop_failed = circular_buffer_pop(&uart->in_buffer,
@@ -306,16 +394,89 @@ void sercom_uart_get_line (struct sercom_uart_desc_t *uart, char *str,
 
 char sercom_uart_get_char (struct sercom_uart_desc_t *uart)
 {
+    sercom_uart_rx_dma_sync(uart);
+
     char c = '\0';
     circular_buffer_pop(&uart->in_buffer, (uint8_t*)&c);
     return c;
 }
 
+uint16_t sercom_uart_get_received (struct sercom_uart_desc_t *uart,
+                                   const uint8_t **data)
+{
+    sercom_uart_rx_dma_sync(uart);
+    // Only count bytes which are lost while the caller has this data
+    uart->rx_dropped = 0;
+
+    uint8_t *head;
+    uint16_t const length = circular_buffer_get_head(&uart->in_buffer, &head);
+    *data = head;
+    return length;
+}
+
+uint8_t sercom_uart_consume (struct sercom_uart_desc_t *uart, uint16_t length)
+{
+    // If the DMA caught up to the head of the buffer while the caller was
+    // parsing the data the bytes which were overwritten have already been
+    // dropped from the buffer
+    sercom_uart_rx_dma_sync(uart);
+    uint16_t const dropped = uart->rx_dropped;
+    uart->rx_dropped = 0;
+
+    if (dropped < length) {
+        circular_buffer_move_head(&uart->in_buffer, length - dropped);
+    }
+    return dropped != 0;
+}
+
 uint8_t sercom_uart_out_buffer_empty (struct sercom_uart_desc_t *uart)
 {
     return circular_buffer_is_empty(&uart->out_buffer);
 }
 
+uint8_t sercom_uart_tx_idle (struct sercom_uart_desc_t *uart)
+{
+    if (!circular_buffer_is_empty(&uart->out_buffer) ||
+            (uart->use_dma && dma_chan_is_active(uart->dma_chan)) ||
+            (!uart->use_dma && uart->sercom->USART.INTENSET.bit.DRE) ||
+            (uart->break_duration != 0)) {
+        return 0;
+    }
+
+    // The output buffer can be empty while the last characters are still in
+    // the data register and the shift register. TXC is only set once they have
+    // been sent, but it is never set if nothing has been sent.
+    return !uart->tx_started || uart->sercom->USART.INTFLAG.bit.TXC;
+}
+
+void sercom_uart_set_baud (struct sercom_uart_desc_t *uart, uint32_t baudrate)
+{
+    Sercom *const sercom = uart->sercom;
+
+    /* Find baud setting */
+    uint16_t baud = 0;
+    uint8_t sampr = 0;
+    sercom_calc_async_baud(baudrate, uart->core_freq, &baud, &sampr);
+
+    /* Disable SERCOM instance, sample rate and baud can not be changed while
+       it is enabled */
+    sercom->USART.CTRLA.bit.ENABLE = 0b0;
+    // Wait for synchronization
+    while (sercom->USART.SYNCBUSY.bit.ENABLE);
+
+    /* Set sample rate and baudrate */
+    sercom->USART.CTRLA.bit.SAMPR = sampr;
+    sercom->USART.BAUD.USARTFP.BAUD = baud;
+
+    /* Enable SERCOM instance */
+    sercom->USART.CTRLA.bit.ENABLE = 0b1;
+    // Wait for synchronization
+    while (sercom->USART.SYNCBUSY.bit.ENABLE);
+
+    uart->baudrate = baudrate;
+    uart->tx_started = 0;
+}
+
 void sercom_uart_send_break (struct sercom_uart_desc_t *uart,
                              uint8_t duration)
 {
@@ -326,10 +487,27 @@ void sercom_uart_send_break (struct sercom_uart_desc_t *uart,
     uart->break_duration = duration;
     uart->break_pending = 1;
 
-    sercom_uart_service(uart);
+    sercom_uart_start_tx(uart);
 }
 
 void sercom_uart_service (struct sercom_uart_desc_t *uart)
+{
+    /* Make any data received by DMA available */
+    if (sercom_uart_rx_dma_sync(uart) != 0) {
+        sched_event_signal(&uart->event);
+    }
+
+    sercom_uart_start_tx(uart);
+}
+
+/**
+ *  Start sending data from the output buffer or a break condition if the UART
+ *  is not already busy. This is safe to call from interrupts, unlike
+ *  sercom_uart_service() it does not touch the input buffer.
+ *
+ *  @param uart The UART for which transmission should be started
+ */
+static void sercom_uart_start_tx (struct sercom_uart_desc_t *uart)
 {
     /* Acquire service function lock */
     if (uart->service_lock) {
@@ -386,10 +564,12 @@ void sercom_uart_service (struct sercom_uart_desc_t *uart)
                                 (volatile uint8_t*)&uart->sercom->USART.DATA,
                                 sercom_get_dma_tx_trigger(uart->sercom_instnum),
                                 SERCOM_DMA_TX_PRIORITY);
+        uart->tx_started = 1;
     } else if (!uart->use_dma && !uart->sercom->USART.INTENSET.bit.DRE) {
         // A interrupt driven write operation is not in progress
         // Start data register empty interrupts.
         uart->sercom->USART.INTENSET.bit.DRE = 0b1;
+        uart->tx_started = 1;
     }
     
     uart->service_lock = 0;
@@ -411,12 +591,15 @@ static void sercom_uart_isr_dre (Sercom *sercom, uint8_t inst_num, void *state)
     } else {
         // All chars sent, disable DRE interrupt
         sercom->USART.INTENCLR.bit.DRE = 0b1;
+        sched_event_signal(&uart->event);
     }
 
     // For some reason the RXC interrupt seems to get disabled every time the
     // interrupt service routine runs. Not clear why this happens, it is not
     // mentioned in the datasheet.
-    sercom->USART.INTENSET.bit.RXC = 0b1;
+    if (!uart->rx_use_dma) {
+        sercom->USART.INTENSET.bit.RXC = 0b1;
+    }
 }
 
 static void sercom_uart_isr_rxc (Sercom *sercom, uint8_t inst_num, void *state)
@@ -449,6 +632,8 @@ static void sercom_uart_isr_rxc (Sercom *sercom, uint8_t inst_num, void *state)
         }
     }
 
+    sched_event_signal(&uart->event);
+
     // For some reason the RXC interrupt seems to get disabled every time the
     // interrupt service routine runs. Not clear why this happens, it is not
     // mentioned in the datasheet.
@@ -457,5 +642,60 @@ static void sercom_uart_isr_rxc (Sercom *sercom, uint8_t inst_num, void *state)
 
 static void sercom_uart_dma_callback (uint8_t chan, void *state)
 {
-    sercom_uart_service((struct sercom_uart_desc_t*)state);
+    struct sercom_uart_desc_t *uart = (struct sercom_uart_desc_t*)state;
+
+    // Space has been freed in the output buffer
+    sched_event_signal(&uart->event);
+    sercom_uart_start_tx(uart);
+}
+
+/**
+ *  Move the tail of the input buffer up to the position of the looping DMA
+ *  receive transfer. If the transfer has caught up to the head of the buffer
+ *  the oldest data has been overwritten and the head is moved as well.
+ *
+ *  @note If more than a full buffer of data is received between calls the
+ *        number of bytes lost can not be determined.
+ *
+ *  @param uart The UART for which the input buffer should be updated
+ *
+ *  @return The number of bytes which were added to the input buffer
+ */
+static uint16_t sercom_uart_rx_dma_sync (struct sercom_uart_desc_t *uart)
+{
+    if (!uart->rx_use_dma) {
+        return 0;
+    }
+
+    // The DMA position is read and the buffer updated all at once so that a
+    // stale position can never be applied to a buffer which has moved on
+    profiler_disable_irq();
+
+    uint16_t const remaining = dma_get_remaining_beats(uart->rx_dma_chan);
+    uint16_t const dma_pos = ((SERCOM_UART_IN_BUFFER_LEN - remaining) %
+                              SERCOM_UART_IN_BUFFER_LEN);
+    uint16_t const received = ((dma_pos + SERCOM_UART_IN_BUFFER_LEN -
+                                uart->in_buffer.tail) %
+                               SERCOM_UART_IN_BUFFER_LEN);
+
+    if (received == 0) {
+        profiler_enable_irq();
+        return 0;
+    }
+
+    uint16_t const unused = circular_buffer_unused(&uart->in_buffer);
+    if (received > unused) {
+        // Oldest data has been overwritten. The bytes after the head are no
+        // longer the ones which were scanned for lines, so the counts are
+        // thrown away before the lost bytes are dropped instead of taking the
+        // lost bytes out of the counts one by one.
+        circular_buffer_rescan_from_head(&uart->in_buffer);
+        circular_buffer_move_head(&uart->in_buffer, received - unused);
+        uart->rx_dropped += received - unused;
+    }
+
+    circular_buffer_move_tail(&uart->in_buffer, received);
+
+    profiler_enable_irq();
+    return received;
 }
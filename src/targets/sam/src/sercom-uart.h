@@ -14,11 +14,16 @@
 
 #include "circular-buffer.h"
 #include "dma.h"
+#include "scheduler.h"
 
 /** The length of the circular output buffer for SERCOM UART instances */
 #define SERCOM_UART_OUT_BUFFER_LEN  256
 /** The length of the circular input buffer for SERCOM UART instances */
 #define SERCOM_UART_IN_BUFFER_LEN  256
+/** Period at which the service should be run so that data received by DMA is
+    noticed and the tasks waiting on the UART are woken. Must be well under the
+    time taken to fill the input buffer at the fastest baud rate in use. */
+#define SERCOM_UART_RX_SYNC_PERIOD  MS_TO_MILLIS(5)
 
 /**
  *  Descriptor for the a SERCOM UART driver instance
@@ -28,12 +33,25 @@ struct sercom_uart_desc_t {
 
     uint32_t break_start_time;
 
+    /** Current baud rate */
+    uint32_t baudrate;
+    /** Frequency of the core clock for the SERCOM instance */
+    uint32_t core_freq;
+
     /** Circular buffer for data to be transmitted */
     char out_buffer_mem[SERCOM_UART_OUT_BUFFER_LEN];
     struct circular_buffer_t out_buffer;
     /** Circular buffer for received data */
     char in_buffer_mem[SERCOM_UART_IN_BUFFER_LEN];
     struct circular_buffer_t in_buffer;
+    /** Number of received bytes which were overwritten by the receive DMA
+        before they were consumed since sercom_uart_get_received() was last
+        called */
+    uint16_t rx_dropped;
+
+    /** Tasks to be marked ready when data is received or when all of the data
+        in the output buffer has been sent */
+    struct sched_event_t event;
     
     uint8_t sercom_instnum;
 
@@ -45,6 +63,12 @@ struct sercom_uart_desc_t {
     /** DMA channel for data transmission */
     uint8_t dma_chan:DMAC_CH_BITS;
     uint8_t use_dma:1;
+
+    /** DMA channel for data reception */
+    uint8_t rx_dma_chan:DMAC_CH_BITS;
+    /** Whether received data is placed in the input buffer by a looping DMA
+        transfer rather than by the receive complete interrupt */
+    uint8_t rx_use_dma:1;
     
     uint8_t echo:1;
     
@@ -53,6 +77,9 @@ struct sercom_uart_desc_t {
     uint8_t service_lock:1;
 
     uint8_t break_pending:1;
+    /** Flag which is set once data has been written to the transmitter since
+        the SERCOM instance was last enabled */
+    uint8_t tx_started:1;
     
     struct dma_circ_transfer_t dma_tran;
 };
@@ -71,6 +98,14 @@ struct sercom_uart_desc_t {
  *                         core clock;
  *  @param dma_channel The DMA channel to be used for transmission or a negative
  *                     value for interrupt driven communication.
+ *  @param rx_dma_channel The DMA channel to be used for reception or a
+ *                        negative value for interrupt driven reception. When
+ *                        DMA is used the input buffer is filled continuously
+ *                        and received data is made visible to the consumer
+ *                        functions each time they are called or the service
+ *                        function is run. The service must be run at least
+ *                        every SERCOM_UART_RX_SYNC_PERIOD. Ignored if echo is
+ *                        enabled.
  *  @param echo If true bytes received will be treated as characters and
  *              echoed and simple line editing (backspace) will be possible.
  *  @param tx_pin_group Group number for TX pin
@@ -79,7 +114,8 @@ struct sercom_uart_desc_t {
 extern void init_sercom_uart(struct sercom_uart_desc_t *descriptor,
                              Sercom *sercom, uint32_t baudrate,
                              uint32_t core_freq, uint32_t core_clock_mask,
-                             int8_t dma_channel, uint8_t echo,
+                             int8_t dma_channel, int8_t rx_dma_channel,
+                             uint8_t echo,
                              uint8_t tx_pin_group, uint8_t tx_pin_num);
 
 /**
@@ -127,6 +163,21 @@ extern void sercom_uart_put_bytes_blocking(struct sercom_uart_desc_t *uart,
                                            const uint8_t *bytes,
                                            uint16_t length);
 
+/**
+ *  Queue a byte array to be written to the UART as upper case hexadecimal
+ *  characters. Characters are encoded directly into the UART output buffer in
+ *  contiguous chunks. Only whole bytes (two characters) are ever queued so the
+ *  encoding can be resumed from the returned count.
+ *
+ *  @param uart The UART to which the array should be written.
+ *  @param bytes The array to be encoded
+ *  @param length The number of bytes to be encoded
+ *
+ *  @return The number of bytes which could be encoded into the queue.
+ */
+extern uint16_t sercom_uart_put_hex(struct sercom_uart_desc_t *uart,
+                                    const uint8_t *bytes, uint16_t length);
+
 /**
  *  Write a character to a UART.
  *
@@ -200,6 +251,37 @@ extern void sercom_uart_get_line (struct sercom_uart_desc_t *uart, char *str,
  */
 extern char sercom_uart_get_char (struct sercom_uart_desc_t *uart);
 
+/**
+ *  Get a pointer to the oldest data in the UART input buffer and the number of
+ *  contiguous bytes following it. This allows received data to be processed
+ *  without being copied out of the input buffer. The data remains in the
+ *  buffer until it is removed with sercom_uart_consume().
+ *
+ *  @param uart The UART for which received data should be found.
+ *  @param data Pointer where a pointer to the received data will be placed.
+ *
+ *  @return The number of contiguous bytes available at the pointer.
+ */
+extern uint16_t sercom_uart_get_received (struct sercom_uart_desc_t *uart,
+                                          const uint8_t **data);
+
+/**
+ *  Remove data from the UART input buffer.
+ *
+ *  If the UART receives by DMA and more data arrives than fits in the input
+ *  buffer, the DMA overwrites the data returned by sercom_uart_get_received()
+ *  while the caller is still looking at it. The overwritten bytes are dropped
+ *  from the buffer and any data which was parsed from them must be discarded.
+ *
+ *  @param uart The UART from which data should be removed.
+ *  @param length The number of bytes to be removed.
+ *
+ *  @return 0 if the data was intact, 1 if some of the data returned by the last
+ *          call to sercom_uart_get_received() was overwritten.
+ */
+extern uint8_t sercom_uart_consume (struct sercom_uart_desc_t *uart,
+                                    uint16_t length);
+
 /**
  *  Determine if the out buffer of a UART is empty.
  *
@@ -208,6 +290,42 @@ extern char sercom_uart_get_char (struct sercom_uart_desc_t *uart);
  */
 extern uint8_t sercom_uart_out_buffer_empty (struct sercom_uart_desc_t *uart);
 
+/**
+ *  Determine if a UART has finished sending all of its data. Unlike
+ *  sercom_uart_out_buffer_empty(), this also waits for the last characters to
+ *  be shifted out of the transmitter.
+ *
+ *  @param uart The UART which should be checked.
+ *
+ *  @return A non-zero value if there is nothing left to be sent.
+ */
+extern uint8_t sercom_uart_tx_idle (struct sercom_uart_desc_t *uart);
+
+/**
+ *  Change the baud rate of a UART.
+ *
+ *  @note Any data which is being sent or received while the baud rate is
+ *        changed will be corrupted. Use sercom_uart_tx_idle() to make sure
+ *        that all data has been sent first.
+ *
+ *  @param uart The UART for which the baud rate should be changed.
+ *  @param baudrate The new baud rate.
+ */
+extern void sercom_uart_set_baud (struct sercom_uart_desc_t *uart,
+                                  uint32_t baudrate);
+
+/**
+ *  Get the baud rate of a UART.
+ *
+ *  @param uart The UART for which the baud rate should be found.
+ *
+ *  @return The current baud rate.
+ */
+static inline uint32_t sercom_uart_get_baud (struct sercom_uart_desc_t *uart)
+{
+    return uart->baudrate;
+}
+
 /**
  *  Set the TX line low for a given period of time.
  *
@@ -219,7 +337,8 @@ extern void sercom_uart_send_break (struct sercom_uart_desc_t *uart,
                                     uint8_t duration);
 
 /**
- *  Start any pending transactions.
+ *  Start any pending transactions and make any data received by DMA available.
+ *  The UART's event is signalled if new data was received.
  *
  *  @param uart The console for which the service should be run.
  */
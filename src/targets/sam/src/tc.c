@@ -96,6 +96,33 @@ static const uint8_t tc_evsys_gen_ovf_ids[] = {
 #endif
 };
 
+static const uint8_t tc_evsys_user_ids[] = {
+#ifdef TC0
+    EVSYS_ID_USER_TC0_EVU,
+#endif
+#ifdef TC1
+    EVSYS_ID_USER_TC1_EVU,
+#endif
+#ifdef TC2
+    EVSYS_ID_USER_TC2_EVU,
+#endif
+#ifdef TC3
+    EVSYS_ID_USER_TC3_EVU,
+#endif
+#ifdef TC4
+    EVSYS_ID_USER_TC4_EVU,
+#endif
+#ifdef TC5
+    EVSYS_ID_USER_TC5_EVU,
+#endif
+#ifdef TC6
+    EVSYS_ID_USER_TC6_EVU,
+#endif
+#ifdef TC7
+    EVSYS_ID_USER_TC7_EVU,
+#endif
+};
+
 #define TC_NUM_PRESCALER_VALUES 8
 static const uint16_t tc_prescaler_values[] = {1, 2, 4, 8, 16, 64, 256, 1024};
 
@@ -210,3 +237,133 @@ uint8_t tc_get_evsys_gen_ovf_id (Tc *tc)
 {
     return tc_evsys_gen_ovf_ids[tc_get_inst_num(tc)];
 }
+
+uint8_t init_tc_capture_counter (Tc *tc, uint32_t count_freq,
+                                 uint32_t clock_mask, uint32_t clock_freq)
+{
+    int8_t const inst_num = tc_get_inst_num(tc);
+    
+    if ((inst_num < 0) || ((inst_num + 1) >= TC_INST_NUM)) {
+        // The next Timer Counter is needed as the slave for 32 bit mode
+        return 1;
+    }
+    
+    /* Find prescaler */
+    uint8_t prescaler = 0xFF;
+    for (uint8_t i = 0; i < TC_NUM_PRESCALER_VALUES; i++) {
+        if ((clock_freq / tc_prescaler_values[i]) == count_freq) {
+            prescaler = i;
+            break;
+        }
+    }
+    
+    if ((prescaler == 0xFF) || ((clock_freq % count_freq) != 0)) {
+        // The count frequency can not be derived exactly from the clock
+        return 1;
+    }
+    
+    /* Enable interface clocks for master and slave TC instances */
+    enable_bus_clock(tc_bus_clocks[inst_num]);
+    enable_bus_clock(tc_bus_clocks[inst_num + 1]);
+    
+    /* Configure generic clock for TC instances */
+    set_perph_generic_clock(tc_glcks[inst_num], clock_mask);
+    set_perph_generic_clock(tc_glcks[inst_num + 1], clock_mask);
+    
+    /* Reset TC */
+    tc->COUNT32.CTRLA.bit.SWRST = 1;
+    // Wait for reset to complete
+#if defined(SAMD2x)
+    while (tc->COUNT32.CTRLA.bit.SWRST | tc->COUNT32.STATUS.bit.SYNCBUSY);
+#elif defined(SAMx5x)
+    while (tc->COUNT32.CTRLA.bit.SWRST | tc->COUNT32.SYNCBUSY.bit.SWRST);
+#endif
+    
+    /* Write CTRLA */
+    // Counter is free running (normal frequency mode) so that it wraps at
+    // 2^32, capture channel 0 captures the count when an event is received
+    tc->COUNT32.CTRLA.reg = (TC_CTRLA_PRESCSYNC_RESYNC |
+                             TC_CTRLA_PRESCALER(prescaler) |
+#if defined(SAMx5x)
+                             TC_CTRLA_CAPTEN0 |
+#endif
+                             TC_CTRLA_MODE_COUNT32);
+#if defined(SAMD2x)
+    // Wait for synchronization
+    while (tc->COUNT32.STATUS.bit.SYNCBUSY);
+    
+    tc->COUNT32.CTRLC.reg = TC_CTRLC_CPTEN0;
+    // Wait for synchronization
+    while (tc->COUNT32.STATUS.bit.SYNCBUSY);
+#endif
+    
+    /* Configure events */
+    tc->COUNT32.EVCTRL.reg = (TC_EVCTRL_TCEI | TC_EVCTRL_EVACT_OFF);
+    
+    /* Clear any stale capture */
+    tc->COUNT32.INTFLAG.reg = TC_INTFLAG_MC0;
+    
+    /* Enable timer */
+    tc->COUNT32.CTRLA.bit.ENABLE = 1;
+    // Wait for synchronization
+#if defined(SAMD2x)
+    while (tc->COUNT32.STATUS.bit.SYNCBUSY);
+
+    /* Start continuous read synchronization of COUNT */
+    // The count is read often (every scheduler task is timed with it), with
+    // continuous synchronization a read does not have to wait for a read
+    // request to go through the 1 MHz clock domain
+    tc->COUNT32.READREQ.reg = (TC_READREQ_RREQ | TC_READREQ_RCONT |
+                               TC_READREQ_ADDR(TC_COUNT32_COUNT_OFFSET));
+#elif defined(SAMx5x)
+    while (tc->COUNT32.SYNCBUSY.bit.ENABLE);
+#endif
+    
+    return 0;
+}
+
+uint32_t tc_capture_counter_get_count (Tc *tc)
+{
+#if defined(SAMD2x)
+    // COUNT is continuously synchronized, it can be read directly
+#elif defined(SAMx5x)
+    // Request read synchronization of the COUNT register
+    tc->COUNT32.CTRLBSET.reg = TC_CTRLBSET_CMD_READSYNC;
+    while (tc->COUNT32.SYNCBUSY.bit.CTRLB);
+    while (tc->COUNT32.SYNCBUSY.bit.COUNT);
+#endif
+    return tc->COUNT32.COUNT.reg;
+}
+
+uint8_t tc_capture_counter_take_capture (Tc *tc, uint32_t *value)
+{
+    if (!(tc->COUNT32.INTFLAG.reg & TC_INTFLAG_MC0)) {
+        // Nothing has been captured since the last capture was taken
+        return 0;
+    }
+    
+#if defined(SAMD2x)
+    // Request read synchronization of the CC0 register, this replaces the
+    // continuous read synchronization of COUNT. Interrupts are disabled so
+    // that COUNT is not read from an interrupt until continuous
+    // synchronization has been restarted.
+    profiler_disable_irq();
+    tc->COUNT32.READREQ.reg = (TC_READREQ_RREQ |
+                               TC_READREQ_ADDR(TC_COUNT32_CC_OFFSET));
+    while (tc->COUNT32.STATUS.bit.SYNCBUSY);
+#endif
+    *value = tc->COUNT32.CC[0].reg;
+    tc->COUNT32.INTFLAG.reg = TC_INTFLAG_MC0;
+#if defined(SAMD2x)
+    // Go back to continuously synchronizing COUNT
+    tc->COUNT32.READREQ.reg = (TC_READREQ_RREQ | TC_READREQ_RCONT |
+                               TC_READREQ_ADDR(TC_COUNT32_COUNT_OFFSET));
+    profiler_enable_irq();
+#endif
+    return 1;
+}
+
+uint8_t tc_get_evsys_user_id (Tc *tc)
+{
+    return tc_evsys_user_ids[tc_get_inst_num(tc)];
+}
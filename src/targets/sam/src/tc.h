@@ -38,4 +38,57 @@ extern uint8_t init_tc_periodic_event (Tc *tc, uint32_t period,
  */
 extern uint8_t tc_get_evsys_gen_ovf_id (Tc *tc) __attribute__((const));
 
+/**
+ *  Initialize a pair of Timer Counters as a free running 32 bit counter and
+ *  start it. The counter wraps at 2^32 and copies its count into capture
+ *  channel 0 whenever an event is received from the event system. The Timer
+ *  Counter after tc is used as the slave and can not be used for anything
+ *  else.
+ *
+ *  @param tc The master Timer Counter instance, must be an even numbered
+ *            instance
+ *  @param count_freq The frequency at which the counter should count, must be
+ *                    the clock frequency divided by one of the prescaler
+ *                    values
+ *  @param clock_mask Mask for the Generic Clock Generator which should provide
+ *                    the Generic Clock for the Timer Counter
+ *  @param clock_freq The frequency of the Generic Clock Generator for the Timer
+ *                    Counter
+ *
+ *  @return 0 if successfull
+ */
+extern uint8_t init_tc_capture_counter (Tc *tc, uint32_t count_freq,
+                                        uint32_t clock_mask,
+                                        uint32_t clock_freq);
+
+/**
+ *  Get the current count of a counter initialized with
+ *  init_tc_capture_counter().
+ *
+ *  @param tc The master Timer Counter instance
+ *
+ *  @return The current count
+ */
+extern uint32_t tc_capture_counter_get_count (Tc *tc);
+
+/**
+ *  Get the count that was captured by a counter initialized with
+ *  init_tc_capture_counter() when it last received an event.
+ *
+ *  @param tc The master Timer Counter instance
+ *  @param value Pointer to where the captured count will be stored
+ *
+ *  @return 1 if there was a capture which had not yet been taken, 0 otherwise
+ */
+extern uint8_t tc_capture_counter_take_capture (Tc *tc, uint32_t *value);
+
+/**
+ *  Get the EVSYS user ID for a Timer Counter's event input.
+ *
+ *  @param tc The Timer Counter for which the user ID should be found
+ *
+ *  @return The event user ID for the Timer Counter's event input
+ */
+extern uint8_t tc_get_evsys_user_id (Tc *tc) __attribute__((const));
+
 #endif /* tc_h */
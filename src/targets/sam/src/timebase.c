@@ -0,0 +1,81 @@
+/**
+ * @file timebase.c
+ * @desc Free running microsecond timebase with hardware event capture
+ * @author agent
+ * @date 2026-10-16
+ * Last Author:
+ * Last Edited On:
+ */
+
+#include "timebase.h"
+
+#include "tc.h"
+#include "evsys.h"
+
+/** Timer Counter used for the timebase, NULL if not initialized */
+static Tc *timebase_tc;
+/** Pin which is captured by hardware */
+static union gpio_pin_t timebase_capture;
+/** Flag to indicate that a pin is being captured */
+static uint8_t timebase_capture_enabled;
+
+
+uint8_t init_timebase(Tc *tc, uint32_t clock_mask, uint32_t clock_freq)
+{
+    timebase_capture_enabled = 0;
+
+    if (init_tc_capture_counter(tc, TIMEBASE_FREQ, clock_mask, clock_freq)) {
+        timebase_tc = NULL;
+        return 1;
+    }
+
+    timebase_tc = tc;
+    return 0;
+}
+
+uint8_t timebase_capture_pin(union gpio_pin_t pin, uint8_t channel,
+                             uint32_t clock_mask)
+{
+    if ((timebase_tc == NULL) || timebase_capture_enabled) {
+        return 1;
+    }
+
+    uint8_t generator;
+    if (gpio_enable_event(pin, &generator)) {
+        return 1;
+    }
+
+    // The EIC and TC are in different clock domains, the asynchronous path is
+    // used so that the event reaches the counter with the least delay
+    evsys_configure_channel(channel, generator, clock_mask,
+                            EVSYS_PATH_ASYNCHRONOUS, EVSYS_EDGE_NO_EVT_OUTPUT);
+    evsys_configure_user_mux(tc_get_evsys_user_id(timebase_tc), channel);
+
+    timebase_capture = pin;
+    timebase_capture_enabled = 1;
+    return 0;
+}
+
+uint32_t timebase_micros(void)
+{
+    if (timebase_tc == NULL) {
+        return 0;
+    }
+
+    return tc_capture_counter_get_count(timebase_tc);
+}
+
+uint32_t timebase_get_event_time(union gpio_pin_t pin)
+{
+    if (timebase_tc == NULL) {
+        return 0;
+    }
+
+    uint32_t time;
+    if (timebase_capture_enabled && (pin.raw == timebase_capture.raw) &&
+            tc_capture_counter_take_capture(timebase_tc, &time)) {
+        return time;
+    }
+
+    return tc_capture_counter_get_count(timebase_tc);
+}
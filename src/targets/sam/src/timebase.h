@@ -0,0 +1,81 @@
+/**
+ * @file timebase.h
+ * @desc Free running microsecond timebase with hardware event capture
+ * @author agent
+ * @date 2026-10-16
+ * Last Author:
+ * Last Edited On:
+ */
+
+#ifndef timebase_h
+#define timebase_h
+
+#include "global.h"
+
+#include "gpio.h"
+
+/*
+ *  The timebase is a 32 bit Timer Counter which counts microseconds and wraps
+ *  about every 71 minutes. It is used where millis is too coarse, for example
+ *  to time stamp samples from sensors with high output data rates.
+ *
+ *  One interrupt pin can be routed through the event system to the counter's
+ *  capture channel so that the time at which the pin was asserted is recorded
+ *  by hardware, independent of interrupt latency. Interrupts on other pins are
+ *  time stamped in software when their handlers call
+ *  timebase_get_event_time().
+ */
+
+/** Frequency at which the timebase counts */
+#define TIMEBASE_FREQ   1000000UL
+
+
+/**
+ *  Initialize the timebase.
+ *
+ *  @param tc The master Timer Counter for the timebase, the Timer Counter after
+ *            it is also used
+ *  @param clock_mask Mask for the Generic Clock Generator to be used for the
+ *                    Timer Counter
+ *  @param clock_freq Frequency of the Generic Clock Generator, must be
+ *                    TIMEBASE_FREQ multiplied by one of the Timer Counter
+ *                    prescaler values
+ *
+ *  @return 0 if successful
+ */
+extern uint8_t init_timebase(Tc *tc, uint32_t clock_mask, uint32_t clock_freq);
+
+/**
+ *  Route a pin's interrupt to the timebase's capture channel. The interrupt
+ *  must already be enabled on the pin. Only one pin can be captured.
+ *
+ *  @param pin The pin to be captured
+ *  @param channel The event channel to be used
+ *  @param clock_mask Mask for the Generic Clock Generator to be used for the
+ *                    event channel
+ *
+ *  @return 0 if successful
+ */
+extern uint8_t timebase_capture_pin(union gpio_pin_t pin, uint8_t channel,
+                                    uint32_t clock_mask);
+
+/**
+ *  Get the current time.
+ *
+ *  @return The current time in microseconds, 0 if the timebase has not been
+ *          initialized
+ */
+extern uint32_t timebase_micros(void);
+
+/**
+ *  Get the time at which an interrupt occurred. This should be called early in
+ *  the interrupt handler. If the pin is the captured pin the time recorded by
+ *  hardware is returned, otherwise the current time is returned.
+ *
+ *  @param pin The pin for which the interrupt occurred
+ *
+ *  @return The time of the interrupt in microseconds
+ */
+extern uint32_t timebase_get_event_time(union gpio_pin_t pin);
+
+#endif /* timebase_h */
@@ -123,6 +123,8 @@ struct telem_gnss_meta {
 //
 struct telem_mpu9250_imu_pl_head {
     uint32_t measurement_time;
+    uint32_t sample_time;
+    uint32_t sample_period;
     uint32_t ag_sr_div:8;
     uint32_t mag_odr:1;
     uint32_t accel_fsr:2;
@@ -140,6 +142,8 @@ struct telem_mpu9250_imu_pl_head {
 //
 struct telem_kx124_accel_pl_head {
     uint32_t measurement_time;
+    uint32_t sample_time;
+    uint32_t sample_period;
     uint16_t odr:4;
     uint16_t range:2;
     uint16_t roll:1;
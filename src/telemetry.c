@@ -28,6 +28,12 @@
 #define GNSS_META_LOG_PERIOD        1000
 #define IMU_TRANSMIT_PERIOD         2500
 
+#define STATUS_TRANSMIT_PRIORITY    RADIO_BLOCK_PRIORITY_NORMAL
+#define ALTITUDE_TRANSMIT_PRIORITY  RADIO_BLOCK_PRIORITY_HIGH
+#define GNSS_LOC_TRANSMIT_PRIORITY  RADIO_BLOCK_PRIORITY_HIGH
+#define GNSS_META_TRANSMIT_PRIORITY RADIO_BLOCK_PRIORITY_LOW
+#define IMU_TRANSMIT_PRIORITY       RADIO_BLOCK_PRIORITY_LOW
+
 
 
 #ifdef ENABLE_ALTIMETER
@@ -97,6 +103,7 @@ static void telemetry_marshal_status(uint32_t *pl_buf, void *arg);
  *  @param log_samp Whether the sample should be logged to the SD card
  *  @param send_samp Whether the sample should be send with the radio
  *  @param transmit_period How often this type of sample is send with the radio
+ *  @param transmit_priority Scheduling priority for the radio block
  *  @param pl_len The length of the payload to be posted
  *  @param marshal_func Function to marshal the payload
  *  @param marshal_func_arg Argument passed to marshaling function
@@ -107,6 +114,7 @@ static void telemetry_marshal_status(uint32_t *pl_buf, void *arg);
 static int telemetry_post_internal(struct telemetry_service_desc_t *const inst,
                                    uint8_t log_samp, uint8_t send_samp,
                                    uint32_t const transmit_period,
+                                   enum radio_block_priority transmit_priority,
                                    size_t const pl_len,
                                    void (*const marshal_func)(uint32_t*, void*),
                                    void *const marshal_func_arg,
@@ -154,7 +162,8 @@ static int telemetry_post_internal(struct telemetry_service_desc_t *const inst,
                                    RADIO_BLOCK_TYPE_DATA, subtype);
         // Send radio block header
         radio_send_block(inst->radio, buffer, total_bytes,
-                         transmit_period, transmit_period * 2);
+                         transmit_period, transmit_period * 2,
+                         transmit_priority);
     }
 
     // Log to sd card
@@ -169,6 +178,33 @@ static int telemetry_post_internal(struct telemetry_service_desc_t *const inst,
     return 0;
 }
 
+/**
+ *  Check in a logging buffer which was checked out for a sensor data block
+ *  without recording the sensor data. The reserved space can not be handed
+ *  back to the logging service, so the block is turned into a spacer.
+ *
+ *  @param inst Telemetry service instance descriptor
+ *  @param data Sensor data pointer which was returned when the block was posted
+ *  @param subhead_size Length of the payload header which preceeds the sensor
+ *                      data
+ *
+ *  @return 0 if successful, a non-zero value otherwise
+ */
+static int telemetry_abandon_internal(struct telemetry_service_desc_t *inst,
+                                      uint8_t *const data,
+                                      size_t const subhead_size)
+{
+    uint8_t *const block = data - (subhead_size + LOGGING_BLOCK_HEADER_LENGTH);
+    uint16_t const length = logging_block_length(block);
+
+    logging_block_marshal_header(block, LOGGING_BLOCK_CLASS_METADATA,
+                                 LOGGING_METADATA_TYPE_SPACER, length);
+    memset(block + LOGGING_BLOCK_HEADER_LENGTH, 0,
+           length - LOGGING_BLOCK_HEADER_LENGTH);
+
+    return log_checkin(inst->logging, block);
+}
+
 
 
 
@@ -199,6 +235,7 @@ void telemetry_service(struct telemetry_service_desc_t *inst)
                                   ALTITUDE_TRANSMIT_PERIOD);
         telemetry_post_internal(inst, log_alt, send_alt,
                                 ALTITUDE_TRANSMIT_PERIOD,
+                                ALTITUDE_TRANSMIT_PRIORITY,
                                 sizeof(struct telem_altitude),
                                 telemetry_marshal_ms5611_altitude,
                                 inst->ms5611_alt, RADIO_DATA_BLOCK_ALTITUDE);
@@ -219,6 +256,7 @@ void telemetry_service(struct telemetry_service_desc_t *inst)
                                   GNSS_LOC_TRANSMIT_PERIOD);
         telemetry_post_internal(inst, log_loc, send_loc,
                                 GNSS_LOC_TRANSMIT_PERIOD,
+                                GNSS_LOC_TRANSMIT_PRIORITY,
                                 sizeof(struct telem_gnss_loc),
                                 telemetry_marshal_gnss_loc,
                                 inst->gnss, RADIO_DATA_BLOCK_GNSS);
@@ -243,6 +281,7 @@ void telemetry_service(struct telemetry_service_desc_t *inst)
 
         telemetry_post_internal(inst, log_meta, send_meta,
                                 GNSS_META_TRANSMIT_PERIOD,
+                                GNSS_META_TRANSMIT_PRIORITY,
                                 sizeof(struct telem_gnss_meta) + sat_length,
                                 telemetry_marshal_gnss_metadata,
                                 inst->gnss, RADIO_DATA_BLOCK_GNSS_META);
@@ -268,11 +307,13 @@ void telemetry_service(struct telemetry_service_desc_t *inst)
         uint8_t const send_imu = ((imu_time - inst->last_mpu9250_radio_time) >
                                   IMU_TRANSMIT_PERIOD);
         telemetry_post_internal(inst, 0, send_imu, IMU_TRANSMIT_PERIOD,
+                                IMU_TRANSMIT_PRIORITY,
                                 sizeof(struct telem_acceleration),
                                 telemetry_marshal_mpu9250_acceleration,
                                 inst->mpu9250_imu,
                                 RADIO_DATA_BLOCK_ACCELERATION);
         telemetry_post_internal(inst, 0, send_imu, IMU_TRANSMIT_PERIOD,
+                                IMU_TRANSMIT_PRIORITY,
                                 sizeof(struct telem_angular_velocity),
                                 telemetry_marshal_mpu9250_angular_velocity,
                                 inst->mpu9250_imu,
@@ -288,7 +329,8 @@ void telemetry_service(struct telemetry_service_desc_t *inst)
     uint8_t const send_status = ((millis - inst->last_status_radio_time) >
                                  STATUS_TRANSMIT_PERIOD);
     telemetry_post_internal(inst, log_status, send_status,
-                            STATUS_TRANSMIT_PERIOD, sizeof(struct telem_status),
+                            STATUS_TRANSMIT_PERIOD, STATUS_TRANSMIT_PRIORITY,
+                            sizeof(struct telem_status),
                             telemetry_marshal_status, NULL,
                             RADIO_DATA_BLOCK_STATUS);
     if (log_status) {
@@ -355,7 +397,8 @@ int telemetry_post_msg(struct telemetry_service_desc_t *const inst,
                                    RADIO_BLOCK_TYPE_DATA,
                                    RADIO_DATA_BLOCK_DEBUG);
         // Send radio block
-        radio_send_block(inst->radio, buffer, total_bytes, 500, 0);
+        radio_send_block(inst->radio, buffer, total_bytes, 500, 0,
+                         RADIO_BLOCK_PRIORITY_HIGH);
     }
 
     // Check if we only made it here by allocating on the stack
@@ -385,7 +428,7 @@ static void telemetry_marshal_ms5611_altitude(uint32_t *pl_buf, void *arg)
     pl->measurement_time = ms5611_get_last_reading_time(ms5611);
     pl->pressure = ms5611_get_pressure(ms5611);
     pl->temperature = ms5611_get_temperature(ms5611) * 10;
-    pl->altitude = (int32_t)(ms5611_get_altitude(ms5611) * 1000.0f);
+    pl->altitude = ms5611_get_altitude_mm(ms5611);
 }
 #endif
 
@@ -522,7 +565,9 @@ static void telemetry_marshal_status(uint32_t *pl_buf, void *arg)
 
 
 uint8_t *telemetry_post_kx134_accel(struct telemetry_service_desc_t *inst,
-                                    uint32_t time, enum kx134_1211_odr odr,
+                                    uint32_t time, uint32_t sample_time,
+                                    uint32_t sample_period,
+                                    enum kx134_1211_odr odr,
                                     enum kx134_1211_range range,
                                     enum kx134_1211_low_pass_rolloff roll,
                                     enum kx134_1211_resolution res,
@@ -571,6 +616,8 @@ uint8_t *telemetry_post_kx134_accel(struct telemetry_service_desc_t *inst,
     struct telem_kx124_accel_pl_head *const pl_head =
             (struct telem_kx124_accel_pl_head*)__builtin_assume_aligned(pl, 4);
     pl_head->measurement_time = time;
+    pl_head->sample_time = sample_time;
+    pl_head->sample_period = sample_period;
     pl_head->odr = odr;
     pl_head->range = range;
     pl_head->roll = roll;
@@ -595,10 +642,23 @@ int telemetry_finish_kx134_accel(struct telemetry_service_desc_t *inst,
     return log_checkin(inst->logging, buffer);
 }
 
+int telemetry_abandon_kx134_accel(struct telemetry_service_desc_t *inst,
+                                  uint8_t *buffer)
+{
+    if (inst->logging == NULL) {
+        return 1;
+    }
+
+    return telemetry_abandon_internal(inst, buffer,
+                                      offsetof(struct telem_kx124_accel_pl_head,
+                                               data));
+}
+
 
 
 uint8_t *telemetry_post_mpu9250_imu(struct telemetry_service_desc_t *inst,
-                                    uint32_t time, uint8_t ag_sr_div,
+                                    uint32_t time, uint32_t sample_time,
+                                    uint32_t sample_period, uint8_t ag_sr_div,
                                     enum ak8963_odr mag_odr,
                                     enum mpu9250_accel_fsr accel_fsr,
                                     enum mpu9250_gyro_fsr gyro_fsr,
@@ -648,6 +708,8 @@ uint8_t *telemetry_post_mpu9250_imu(struct telemetry_service_desc_t *inst,
     struct telem_mpu9250_imu_pl_head *const pl_head =
             (struct telem_mpu9250_imu_pl_head*)__builtin_assume_aligned(pl, 4);
     pl_head->measurement_time = time;
+    pl_head->sample_time = sample_time;
+    pl_head->sample_period = sample_period;
     pl_head->ag_sr_div = ag_sr_div;
     pl_head->mag_odr = mag_odr;
     pl_head->accel_fsr = accel_fsr;
@@ -672,3 +734,15 @@ int telemetry_finish_mpu9250_imu(struct telemetry_service_desc_t *inst,
 
     return log_checkin(inst->logging, buffer);
 }
+
+int telemetry_abandon_mpu9250_imu(struct telemetry_service_desc_t *inst,
+                                  uint8_t *buffer)
+{
+    if (inst->logging == NULL) {
+        return 1;
+    }
+
+    return telemetry_abandon_internal(inst, buffer,
+                                      offsetof(struct telem_mpu9250_imu_pl_head,
+                                               data));
+}
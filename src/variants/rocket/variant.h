@@ -66,15 +66,19 @@
 /* Mininum altitude threashold for transition into coasting ascent state in
    meters */
 #define DEPLOYMENT_COASTING_ASCENT_ALT_MINIMUM      500
-/* Number of consecutive samples below the maximum altitude we have seen
-   required to deploy drogue chute */
-#define DEPLOYMENT_DESCENDING_SAMPLE_THREASHOLD     5
-/* Amount of change in altitude required to indicate that we are still moving in
-   meters */
-#define DEPLOYMENT_LANDED_ALT_CHANGE                0.5f
-/* Number of consecutive samples of staying still required before we can be
-   sure that we have landed */
-#define DEPLOYMENT_LANDED_SAMPLE_THREASHOLD         100
+/* Estimated vertical velocity below which we are sure that we are descending
+   and the drogue chute should be deployed in millimeters per second */
+#define DEPLOYMENT_DESCENDING_VELOCITY              -1000
+/* Magnitude of estimated vertical velocity which indicates that we are still
+   moving in millimeters per second */
+#define DEPLOYMENT_LANDED_VELOCITY                  500
+/* Length of time that the estimated vertical velocity must stay below the
+   landed velocity before we can be sure that we have landed */
+#define DEPLOYMENT_LANDED_TIME                      MS_TO_MILLIS(10000)
+/* IMU accelerometer axis which points up along the body of the rocket */
+#define DEPLOYMENT_UP_AXIS                          2
+/* Set to 1 if the up axis of the accelerometer points down the rocket */
+#define DEPLOYMENT_UP_AXIS_INVERTED                 0
 
 /* Length of time that current is applied to ematches in milliseconds */
 #define DEPLOYMENT_EMATCH_FIRE_DURATION             500
@@ -270,6 +274,15 @@ extern struct radio_instance_desc *const radios_g[];
 #define ALTIMETER_CSB 0
 /* Altimeter sample period in milliseconds */
 #define ALTIMETER_PERIOD MS_TO_MILLIS(100)
+/* Altimeter sample period during ascent in milliseconds */
+#define ALTIMETER_ASCENT_PERIOD MS_TO_MILLIS(20)
+/* Altimeter pressure oversampling ratio during ascent */
+#define ALTIMETER_ASCENT_PRES_OSR MS5611_OSR_SEL_1024
+/* Altimeter temperature oversampling ratio during ascent */
+#define ALTIMETER_ASCENT_TEMP_OSR MS5611_OSR_SEL_1024
+/* Number of altimeter pressure readings per temperature reading during
+   ascent */
+#define ALTIMETER_ASCENT_TEMP_INTERVAL 10
 extern struct ms5611_desc_t altimeter_g;
 
 //
@@ -307,6 +320,9 @@ extern struct mpu9250_desc_t imu_g;
 #define ENABLE_GNSS
 /* UART used to communicate with GNSS */
 #define GNSS_UART uart2_g
+/* Number of GNSS fixes per second, the module's baud rate and output sentences
+   are chosen to suit */
+#define GNSS_FIX_RATE 10
 
 //
 //
@@ -316,6 +332,9 @@ extern struct mpu9250_desc_t imu_g;
 
 #define ENABLE_LOGGING
 //#define LOGGING_START_PAUSED
+/* Period at which profiler statistics are logged when the firmware is built
+   with PROFILE=1, 0 to disable */
+#define PROFILER_LOG_PERIOD MS_TO_MILLIS(10000)
 
 #ifdef ENABLE_LOGGING
 extern struct logging_desc_t logging_g;
@@ -258,6 +258,9 @@ extern struct mpu9250_desc_t imu_g;
 #define ENABLE_GNSS
 /* UART used to communicate with GNSS */
 #define GNSS_UART uart2_g
+/* Number of GNSS fixes per second, the module's baud rate and output sentences
+   are chosen to suit */
+#define GNSS_FIX_RATE 1
 
 //
 //
@@ -23,11 +23,14 @@
 #include "kx134-1211.h"
 
 #include "radio-transport.h"
+#include "lora-config.h"
 #include "logging.h"
 
 #include "ground.h"
 #include "telemetry.h"
 #include "deployment.h"
+#include "scheduler.h"
+#include "profiler.h"
 
 
 #ifdef ENABLE_LORA
@@ -35,6 +38,14 @@
 // uses the two least significant bits of a pointer to this structure to store
 // other information.
 struct radio_transport_desc radio_transport_g __attribute__((__aligned__(4)));
+// The erasure coding state includes a large decoder window, so it is only
+// allocated when the build asks for parity packets.
+#if LORA_FEC_PARITY_PACKETS > 0
+static struct radio_fec_desc radio_fec_g;
+#define RADIO_FEC_DESC  (&radio_fec_g)
+#else
+#define RADIO_FEC_DESC  NULL
+#endif
 
 #ifdef LORA_RADIO_0_UART
 static struct radio_instance_desc radio_0_g;
@@ -188,10 +199,6 @@ struct ms5611_desc_t altimeter_g;
 struct mpu9250_desc_t imu_g;
 #endif
 
-#ifdef ENABLE_GNSS
-struct console_desc_t gnss_console_g;
-#endif
-
 #ifdef ENABLE_GROUND_SERVICE
 struct console_desc_t ground_station_console_g;
 #endif
@@ -216,6 +223,183 @@ struct telemetry_service_desc_t telemetry_g;
 struct deployment_service_desc_t deployment_g;
 #endif
 
+// MARK: Scheduler Tasks
+/** Period at which the altimeter and IMU are run for conversion and FIFO fill
+    times, which are not signalled by the sensors */
+#define SENSOR_TASK_PERIOD MS_TO_MILLIS(1)
+/** Period at which the GNSS driver is run for its timeouts */
+#define GNSS_TASK_PERIOD MS_TO_MILLIS(10)
+/** Period at which the radio transport is run for its transmit schedule and
+    for the timeouts in the radio drivers */
+#define RADIO_TASK_PERIOD MS_TO_MILLIS(1)
+/** Period at which the logging service is run to write out buffers which have
+    been checked in and to retry operations on the SD card */
+#define LOGGING_TASK_PERIOD MS_TO_MILLIS(10)
+/** Period at which the ground service retries starting reception */
+#define GROUND_TASK_PERIOD MS_TO_MILLIS(100)
+/** Period at which the telemetry service is run for status reports */
+#define TELEMETRY_TASK_PERIOD MS_TO_MILLIS(100)
+
+#ifdef ENABLE_CONSOLE
+static struct sched_task_t console_task_g;
+SCHED_TASK_FUNC(console_task, console_service, struct console_desc_t)
+#endif
+
+#ifdef ENABLE_ALTIMETER
+static struct sched_task_t altimeter_task_g;
+SCHED_TASK_FUNC(altimeter_task, ms5611_service, struct ms5611_desc_t)
+#endif
+
+#ifdef ENABLE_IMU
+static struct sched_task_t imu_task_g;
+SCHED_TASK_FUNC(imu_task, mpu9250_service, struct mpu9250_desc_t)
+#endif
+
+#ifdef ENABLE_GNSS
+static struct sched_task_t gnss_task_g;
+
+static void gnss_task(void *context)
+{
+    gnss_xa1110_service();
+}
+#endif
+
+#ifdef ENABLE_LORA
+static struct sched_task_t radio_transport_task_g;
+SCHED_TASK_FUNC(radio_transport_task, radio_transport_service,
+                struct radio_transport_desc)
+#endif
+
+#if (defined(ENABLE_LOGGING) && \
+     (defined(ENABLE_SDHC0) || defined(ENABLE_SDSPI)))
+static struct sched_task_t logging_task_g;
+SCHED_TASK_FUNC(logging_task, logging_service, struct logging_desc_t)
+#endif
+
+#if (defined(ENABLE_LOGGING) && defined(ENABLE_PROFILER) && \
+     defined(PROFILER_LOG_PERIOD) && (PROFILER_LOG_PERIOD != 0) && \
+     (defined(ENABLE_SDHC0) || defined(ENABLE_SDSPI)))
+#define ENABLE_PROFILER_LOG
+static struct sched_task_t profiler_log_task_g;
+
+static void profiler_log_task(void *context)
+{
+    profiler_log((struct logging_desc_t *)context);
+}
+#endif
+
+#ifdef ENABLE_GROUND_SERVICE
+static struct sched_task_t ground_task_g;
+
+static void ground_task(void *context)
+{
+    ground_service();
+}
+#endif
+
+#ifdef ENABLE_TELEMETRY_SERVICE
+static struct sched_task_t telemetry_task_g;
+SCHED_TASK_FUNC(telemetry_task, telemetry_service,
+                struct telemetry_service_desc_t)
+#endif
+
+#ifdef ENABLE_DEPLOYMENT_SERVICE
+static struct sched_task_t deployment_task_g;
+SCHED_TASK_FUNC(deployment_task, deployment_service,
+                struct deployment_service_desc_t)
+#endif
+
+/**
+ *  Add the service functions for variant level services to the scheduler.
+ *  Services are run when the drivers that they wait on signal an event and
+ *  periodically for anything that depends only on time. A console on USB and
+ *  the deployment service are polled on every pass through the main loop.
+ */
+static void init_variant_tasks(void)
+{
+#ifdef ENABLE_CONSOLE
+#ifdef CONSOLE_UART
+    sched_add_task(&console_task_g, console_task, &console_g, "console", 0, 0);
+    sched_event_add_task(&CONSOLE_UART.event, &console_task_g);
+#else
+    // The USB CDC driver does not signal when data is received
+    sched_add_task(&console_task_g, console_task, &console_g, "console", 0, 1);
+#endif
+#endif
+#ifdef ENABLE_ALTIMETER
+    sched_add_task(&altimeter_task_g, altimeter_task, &altimeter_g, "ms5611",
+                   SENSOR_TASK_PERIOD, 0);
+    sched_event_add_task(&altimeter_g.i2c_inst->event, &altimeter_task_g);
+#endif
+#ifdef ENABLE_IMU
+    sched_add_task(&imu_task_g, imu_task, &imu_g, "mpu9250",
+                   SENSOR_TASK_PERIOD, 0);
+    sched_event_add_task(&imu_g.event, &imu_task_g);
+    sched_event_add_task(&imu_g.i2c_inst->event, &imu_task_g);
+#endif
+#ifdef ENABLE_GNSS
+    sched_add_task(&gnss_task_g, gnss_task, NULL, "gnss", GNSS_TASK_PERIOD, 0);
+    sched_event_add_task(&GNSS_UART.event, &gnss_task_g);
+#endif
+#ifdef ENABLE_LORA
+    sched_add_task(&radio_transport_task_g, radio_transport_task,
+                   &radio_transport_g, "radio", RADIO_TASK_PERIOD, 0);
+#ifdef LORA_RADIO_0_UART
+    sched_event_add_task(&LORA_RADIO_0_UART.event, &radio_transport_task_g);
+#endif
+#ifdef LORA_RADIO_1_UART
+    sched_event_add_task(&LORA_RADIO_1_UART.event, &radio_transport_task_g);
+#endif
+#ifdef LORA_RADIO_2_UART
+    sched_event_add_task(&LORA_RADIO_2_UART.event, &radio_transport_task_g);
+#endif
+#ifdef LORA_RADIO_3_UART
+    sched_event_add_task(&LORA_RADIO_3_UART.event, &radio_transport_task_g);
+#endif
+#endif
+#if (defined(ENABLE_LOGGING) && \
+     (defined(ENABLE_SDHC0) || defined(ENABLE_SDSPI)))
+    sched_add_task(&logging_task_g, logging_task, &logging_g, "logging",
+                   LOGGING_TASK_PERIOD, 0);
+#if defined(ENABLE_SDHC0)
+    sched_event_add_task(&sdhc0_g.event, &logging_task_g);
+#elif defined(ENABLE_SDSPI)
+    sched_event_add_task(&sdspi_g.event, &logging_task_g);
+#endif
+#endif
+#ifdef ENABLE_PROFILER_LOG
+    sched_add_task(&profiler_log_task_g, profiler_log_task, &logging_g,
+                   "prof-log", PROFILER_LOG_PERIOD, 0);
+#endif
+#ifdef ENABLE_GROUND_SERVICE
+    sched_add_task(&ground_task_g, ground_task, NULL, "ground",
+                   GROUND_TASK_PERIOD, 0);
+#endif
+#ifdef ENABLE_TELEMETRY_SERVICE
+    // New sensor readings are posted as soon as the tasks which make them have
+    // run
+    sched_add_task(&telemetry_task_g, telemetry_task, &telemetry_g, "telem",
+                   TELEMETRY_TASK_PERIOD, 0);
+#ifdef ENABLE_ALTIMETER
+    sched_event_add_task(&altimeter_g.i2c_inst->event, &telemetry_task_g);
+#endif
+#ifdef ENABLE_IMU
+    sched_event_add_task(&imu_g.event, &telemetry_task_g);
+    sched_event_add_task(&imu_g.i2c_inst->event, &telemetry_task_g);
+#endif
+#ifdef ENABLE_GNSS
+    sched_event_add_task(&GNSS_UART.event, &telemetry_task_g);
+#endif
+#endif
+#ifdef ENABLE_DEPLOYMENT_SERVICE
+    // Deployment decisions are checked on every pass so that they are made
+    // with as little latency as possible
+    sched_add_task(&deployment_task_g, deployment_task, &deployment_g,
+                   "deploy", 0, 1);
+#endif
+}
+
+
 void init_variant(void)
 {
 #ifdef ENABLE_TELEMETRY_SERVICE
@@ -245,7 +429,7 @@ void init_variant(void)
     // LoRa Radios
 #ifdef ENABLE_LORA
     init_radio_transport(&radio_transport_g, radios_g, radio_uarts_g,
-                         radio_antennas_g, LORA_RADIO_SEARCH_ROLE,
+                         radio_antennas_g, RADIO_FEC_DESC, LORA_RADIO_SEARCH_ROLE,
                          LORA_DEVICE_ADDRESS);
 #ifdef ENABLE_TELEMETRY_SERVICE
     telem_radio = &radio_transport_g;
@@ -281,8 +465,7 @@ void init_variant(void)
 
     // Init GNSS
 #ifdef ENABLE_GNSS
-    init_uart_console(&gnss_console_g, &GNSS_UART, '\0');
-    init_gnss_xa1110(&gnss_console_g);
+    init_gnss_xa1110(&GNSS_UART, GNSS_FIX_RATE);
 #ifdef ENABLE_TELEMETRY_SERVICE
     telemetry_register_gnss(&telemetry_g, &gnss_xa1110_descriptor);
 #endif
@@ -334,43 +517,6 @@ void init_variant(void)
 #endif
     init_deployment(&deployment_g, &altimeter_g, &imu_g);
 #endif
-}
-
-void variant_service(void)
-{
-#ifdef ENABLE_CONSOLE
-    console_service(&console_g);
-#endif
-
-#ifdef ENABLE_ALTIMETER
-    ms5611_service(&altimeter_g);
-#endif
 
-#ifdef ENABLE_IMU
-    mpu9250_service(&imu_g);
-#endif
-
-#ifdef ENABLE_GNSS
-    console_service(&gnss_console_g);
-#endif
-
-#ifdef ENABLE_LORA
-    radio_transport_service(&radio_transport_g);
-#endif
-
-#ifdef ENABLE_LOGGING
-    logging_service(&logging_g);
-#endif
-
-#ifdef ENABLE_GROUND_SERVICE
-    ground_service();
-#endif
-
-#ifdef ENABLE_TELEMETRY_SERVICE
-    telemetry_service(&telemetry_g);
-#endif
-
-#ifdef ENABLE_DEPLOYMENT_SERVICE
-    deployment_service(&deployment_g);
-#endif
+    init_variant_tasks();
 }
@@ -0,0 +1,243 @@
+#include <unittest.h>
+#include SOURCE_C
+
+#include <string.h>
+
+/*
+ *  Replay harness for the altitude filter. With no arguments a noisy flight is
+ *  simulated and the filter estimates are checked against the true state,
+ *  including the time at which the deployment service would detect apogee and
+ *  landing.
+ *
+ *  A logged flight can be replayed by giving a CSV file as the first argument.
+ *  Each line of the file holds one measurement:
+ *
+ *      <time in ms>,alt,<altitude in mm>
+ *      <time in ms>,acc,<vertical acceleration in mm/s^2 not including gravity>
+ *
+ *  The filter estimates are printed after each altitude measurement as
+ *  "<time>,<altitude in mm>,<velocity in mm/s>".
+ */
+
+/** Velocity below which the deployment service decides we are descending */
+#define DESCENDING_VELOCITY     -1000
+/** Velocity magnitude below which the deployment service decides we are
+    still */
+#define LANDED_VELOCITY         500
+/** Time we must be still for before the deployment service decides we have
+    landed */
+#define LANDED_TIME             10000
+
+/** Interval between acceleration inputs to the filter in ms */
+#define SIM_IMU_PERIOD          10
+/** Interval between barometer measurements during ascent in ms */
+#define SIM_ASCENT_BARO_PERIOD  20
+/** Interval between barometer measurements during descent in ms */
+#define SIM_DESCENT_BARO_PERIOD 100
+
+/** Time of ignition in ms */
+#define SIM_IGNITION_TIME       5000
+/** Length of motor burn in ms */
+#define SIM_BURN_TIME           3000
+/** Acceleration during motor burn in mm/s^2 */
+#define SIM_THRUST_ACCEL        100000
+/** Acceleration due to gravity in mm/s^2 */
+#define SIM_GRAVITY             9807
+/** Descent rate under parachute in mm/s */
+#define SIM_DESCENT_RATE        -20000
+/** Time constant for reaching the descent rate after apogee in ms */
+#define SIM_CHUTE_TIME_CONSTANT 2000
+
+/** Standard deviation of barometer noise in mm */
+#define SIM_BARO_NOISE          1000
+/** Standard deviation of accelerometer noise in mm/s^2 */
+#define SIM_ACCEL_NOISE         500
+/** Constant accelerometer error in mm/s^2 */
+#define SIM_ACCEL_BIAS          300
+
+/** Largest allowed velocity error during the flight in mm/s */
+#define MAX_VELOCITY_ERROR      2000
+/** Longest allowed delay between apogee and detecting descent in ms */
+#define MAX_APOGEE_DELAY        1000
+/** Longest allowed delay between touchdown and detecting landing in ms */
+#define MAX_LANDED_DELAY        (LANDED_TIME + 5000)
+
+
+static struct altitude_filter_t filter;
+
+static uint32_t rand_state = 0x2A;
+
+/**
+ *  Approximately normally distributed noise with a given standard deviation.
+ */
+static int32_t noise(int32_t std_dev)
+{
+    int32_t sum = 0;
+    for (int i = 0; i < 12; i++) {
+        rand_state = (rand_state * 1103515245) + 12345;
+        sum += (int32_t)((rand_state >> 16) & 0x7FFF);
+    }
+    // Sum of 12 uniform values has a variance of 1 when scaled to [0, 1)
+    return (int32_t)(((int64_t)(sum - (6 * 32768)) * std_dev) / 32768);
+}
+
+static int replay_log(const char *path)
+{
+    FILE *const log = fopen(path, "r");
+    if (log == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    init_altitude_filter(&filter, SIM_DESCENT_BARO_PERIOD);
+
+    char line[128];
+    while (fgets(line, sizeof(line), log) != NULL) {
+        unsigned long time;
+        char kind[4];
+        long value;
+        if (sscanf(line, "%lu,%3[a-z],%ld", &time, kind, &value) != 3) {
+            continue;
+        }
+
+        if (!strcmp(kind, "acc")) {
+            altitude_filter_predict(&filter, (int32_t)value, (uint32_t)time);
+        } else if (!strcmp(kind, "alt")) {
+            altitude_filter_update(&filter, (int32_t)value, (uint32_t)time);
+            printf("%lu,%d,%d\n", time,
+                   (int)altitude_filter_get_altitude(&filter),
+                   (int)altitude_filter_get_velocity(&filter));
+        }
+    }
+
+    fclose(log);
+    return 0;
+}
+
+int main (int argc, char **argv)
+{
+    if (argc > 1) {
+        return replay_log(argv[1]);
+    }
+
+    init_altitude_filter(&filter, SIM_DESCENT_BARO_PERIOD);
+
+    // True state integrated at 1 ms, velocity is kept in micrometers per
+    // second so that the acceleration is integrated without rounding
+    int64_t altitude_um = 0;
+    int64_t velocity_um = 0;
+    int32_t velocity = 0;
+    int32_t accel = 0;
+    int64_t accel_sum = 0;
+    int32_t accel_count = 0;
+
+    uint32_t apogee_time = 0;
+    uint32_t descent_detect_time = 0;
+    uint32_t touchdown_time = 0;
+    uint32_t landed_detect_time = 0;
+    uint32_t last_moving_time = 0;
+    uint32_t next_baro_time = 0;
+    int32_t max_velocity_error = 0;
+
+    for (uint32_t t = 1; t < 600000; t++) {
+        // Simulate the flight
+        if (t < SIM_IGNITION_TIME) {
+            accel = 0;
+        } else if (t < (SIM_IGNITION_TIME + SIM_BURN_TIME)) {
+            accel = SIM_THRUST_ACCEL - SIM_GRAVITY;
+        } else if (touchdown_time != 0) {
+            accel = 0;
+        } else if (apogee_time == 0) {
+            accel = -SIM_GRAVITY;
+        } else {
+            // Parachute slows us to the descent rate
+            accel = ((SIM_DESCENT_RATE - velocity) * 1000 /
+                     SIM_CHUTE_TIME_CONSTANT);
+        }
+        velocity_um += accel;
+        velocity = (int32_t)(velocity_um / 1000);
+        altitude_um += velocity;
+
+        if ((t > SIM_IGNITION_TIME) && (apogee_time == 0) && (velocity < 0)) {
+            apogee_time = t;
+        }
+        if ((apogee_time != 0) && (touchdown_time == 0) &&
+                (altitude_um <= 0)) {
+            // The impact stops us within one sample
+            accel -= velocity * 1000;
+            altitude_um = 0;
+            velocity_um = 0;
+            velocity = 0;
+            touchdown_time = t;
+        }
+
+        // Average the accelerometer samples between inputs to the filter
+        accel_sum += accel + SIM_ACCEL_BIAS + noise(SIM_ACCEL_NOISE);
+        accel_count++;
+        if ((t % SIM_IMU_PERIOD) == 0) {
+            altitude_filter_predict(&filter, (int32_t)(accel_sum / accel_count),
+                                    t);
+            accel_sum = 0;
+            accel_count = 0;
+        }
+
+        if (t >= next_baro_time) {
+            int const ascending = ((t >= SIM_IGNITION_TIME) &&
+                                   (descent_detect_time == 0));
+            next_baro_time = t + (ascending ? SIM_ASCENT_BARO_PERIOD :
+                                              SIM_DESCENT_BARO_PERIOD);
+            altitude_filter_update(&filter,
+                                   (int32_t)(altitude_um / 1000) +
+                                        noise(SIM_BARO_NOISE), t);
+        }
+
+        // Check the estimates like the deployment service would
+        if (!filter.initialized) {
+            continue;
+        }
+        int32_t const estimate = altitude_filter_get_velocity(&filter);
+        int32_t const error = (estimate > velocity) ? (estimate - velocity) :
+                                                      (velocity - estimate);
+        // The impact at touchdown is only seen at the next IMU input, so the
+        // error is checked until then
+        if ((touchdown_time == 0) && (error > max_velocity_error)) {
+            max_velocity_error = error;
+        }
+
+        if (t < SIM_IGNITION_TIME) {
+            // Still on the pad
+            continue;
+        } else if (descent_detect_time == 0) {
+            if (estimate < DESCENDING_VELOCITY) {
+                descent_detect_time = t;
+                last_moving_time = t;
+            }
+        } else if (landed_detect_time == 0) {
+            if ((estimate > LANDED_VELOCITY) ||
+                    (estimate < -LANDED_VELOCITY)) {
+                last_moving_time = t;
+            } else if ((t - last_moving_time) > LANDED_TIME) {
+                landed_detect_time = t;
+                break;
+            }
+        }
+    }
+
+    printf("Apogee at %u ms, detected at %u ms\n", apogee_time,
+           descent_detect_time);
+    printf("Touchdown at %u ms, detected at %u ms\n", touchdown_time,
+           landed_detect_time);
+    printf("Maximum velocity error %d mm/s\n", (int)max_velocity_error);
+
+    ut_assert(apogee_time != 0);
+    ut_assert(descent_detect_time >= apogee_time);
+    ut_assert((descent_detect_time - apogee_time) < MAX_APOGEE_DELAY);
+
+    ut_assert(touchdown_time != 0);
+    ut_assert(landed_detect_time >= touchdown_time);
+    ut_assert((landed_detect_time - touchdown_time) < MAX_LANDED_DELAY);
+
+    ut_assert(max_velocity_error < MAX_VELOCITY_ERROR);
+
+    return UT_PASS;
+}
@@ -0,0 +1,78 @@
+#include <unittest.h>
+#include SOURCE_C
+
+/*
+ *  altitude_filter_update() corrects the filter state with a barometric
+ *  altitude measurement. The first measurement initializes the state.
+ */
+
+static struct altitude_filter_t filter;
+
+
+int main (int argc, char **argv)
+{
+    // The first measurement is taken as the altitude with no velocity
+    {
+        init_altitude_filter(&filter, 100);
+        ut_assert(!filter.initialized);
+
+        // Acceleration before the first measurement does not move the state
+        altitude_filter_predict(&filter, 5000, 50);
+        ut_assert(altitude_filter_get_altitude(&filter) == 0);
+        ut_assert(altitude_filter_get_velocity(&filter) == 0);
+
+        altitude_filter_update(&filter, 123456, 100);
+        ut_assert(filter.initialized);
+        ut_assert(altitude_filter_get_altitude(&filter) == 123456);
+        ut_assert(altitude_filter_get_velocity(&filter) == 0);
+    }
+
+    // A constant altitude keeps the state still
+    {
+        init_altitude_filter(&filter, 100);
+        for (uint32_t t = 100; t <= 10000; t += 100) {
+            altitude_filter_predict(&filter, 0, t);
+            altitude_filter_update(&filter, 50000, t);
+        }
+        ut_assert(altitude_filter_get_altitude(&filter) == 50000);
+        ut_assert(altitude_filter_get_velocity(&filter) == 0);
+    }
+
+    // A constant climb rate is tracked without any acceleration input
+    {
+        init_altitude_filter(&filter, 100);
+        for (uint32_t t = 100; t <= 60000; t += 100) {
+            altitude_filter_update(&filter, (int32_t)(t * 10), t);
+        }
+        int32_t const velocity = altitude_filter_get_velocity(&filter);
+        ut_assert((velocity > 9900) && (velocity < 10100));
+        int32_t const altitude = altitude_filter_get_altitude(&filter);
+        ut_assert((altitude > 599900) && (altitude < 600100));
+    }
+
+    // A constant error in the acceleration measurement is learned as bias
+    {
+        init_altitude_filter(&filter, 100);
+        for (uint32_t t = 100; t <= 60000; t += 100) {
+            altitude_filter_predict(&filter, 300, t);
+            altitude_filter_update(&filter, 0, t);
+        }
+        int32_t const accel = altitude_filter_get_accel(&filter);
+        ut_assert((accel > -20) && (accel < 20));
+        int32_t const velocity = altitude_filter_get_velocity(&filter);
+        ut_assert((velocity > -20) && (velocity < 20));
+    }
+
+    // The gains follow a persistent change in the barometer rate
+    {
+        init_altitude_filter(&filter, 100);
+        int32_t const slow_gain = filter.gain_altitude;
+        for (uint32_t t = 100; t <= 2000; t += 20) {
+            altitude_filter_update(&filter, 0, t);
+        }
+        ut_assert(filter.gain_period < 30);
+        ut_assert(filter.gain_altitude < slow_gain);
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,75 @@
+#include <string.h>
+#include "common.c"
+
+/*
+ *  circular_buffer_get_tail() retrieves a pointer to the tail of the buffer and
+ *  returns the length of the largest contiguous block of unused space in the
+ *  buffer starting at the tail.
+ *
+ *  This function can be used to write data directly into the buffer.
+ */
+
+
+int main (int argc, char **argv)
+{
+    struct circular_buffer_t cb;
+    memset(&cb, 0, sizeof(cb));
+
+    // Get space in empty buffer where head and tail are at 0.
+    {
+        cb.buffer = (uint8_t*)0x1000;
+        cb.capacity = 256;
+        cb.head = 0;
+        cb.tail = 0;
+        cb.length = 0;
+        uint8_t *tail;
+        uint16_t ret = circular_buffer_get_tail(&cb, &tail);
+
+        ut_assert(ret == 256);
+        ut_assert(tail == cb.buffer + cb.tail);
+    }
+
+    // Get space where tail is after head.
+    {
+        cb.buffer = (uint8_t*)0x12345678;
+        cb.capacity = 32768;
+        cb.head = 10000;
+        cb.tail = 24500;
+        cb.length = 14500;
+        uint8_t *tail;
+        uint16_t ret = circular_buffer_get_tail(&cb, &tail);
+
+        ut_assert(ret == 8268);
+        ut_assert(tail == cb.buffer + cb.tail);
+    }
+
+    // Get space where tail is before head.
+    {
+        cb.buffer = (uint8_t*)0xAAAA;
+        cb.capacity = 123;
+        cb.head = 100;
+        cb.tail = 30;
+        cb.length = 53;
+        uint8_t *tail;
+        uint16_t ret = circular_buffer_get_tail(&cb, &tail);
+
+        ut_assert(ret == 70);
+        ut_assert(tail == cb.buffer + cb.tail);
+    }
+
+    // Get space in full buffer.
+    {
+        cb.buffer = (uint8_t*)0x5555;
+        cb.capacity = 64;
+        cb.head = 20;
+        cb.tail = 20;
+        cb.length = 64;
+        uint8_t *tail;
+        uint16_t ret = circular_buffer_get_tail(&cb, &tail);
+
+        ut_assert(ret == 0);
+        ut_assert(tail == cb.buffer + cb.tail);
+    }
+
+    return UT_PASS;
+}
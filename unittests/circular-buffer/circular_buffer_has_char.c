@@ -22,8 +22,14 @@ int main (int argc, char **argv)
         cb.length = 27;
         memset(buffer, 0, sizeof(buffer));
         strcpy((char*)buffer, "abcdefghijklmnopqrstuvwxyz!");
+        // Buffer state was set directly, nothing has been scanned yet
+        cb.scanned = 0;
+        cb.line_count = 0;
+        cb.delim_count = 0;
+        interrupts_status = INTERRUPTS_ENABLED;
         int ret = circular_buffer_has_char(&cb, '!');
 
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
         ut_assert(ret);
         ut_assert(cb.head == 0);
         ut_assert(cb.tail == 27);
@@ -38,8 +44,14 @@ int main (int argc, char **argv)
         cb.length = 27;
         memset(buffer, 0, sizeof(buffer));
         strcpy((char*)buffer, "abcdefghijklmnopqrstuvwxyz!");
+        // Buffer state was set directly, nothing has been scanned yet
+        cb.scanned = 0;
+        cb.line_count = 0;
+        cb.delim_count = 0;
+        interrupts_status = INTERRUPTS_ENABLED;
         int ret = circular_buffer_has_char(&cb, '!');
 
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
         ut_assert(ret);
         ut_assert(cb.head == 10);
         ut_assert(cb.tail == 10);
@@ -54,8 +66,14 @@ int main (int argc, char **argv)
         cb.length = 439;
         memset(buffer, 0, sizeof(buffer));
         strcpy((char*)buffer, "abcdefghijklmnopqrstuvwxyz!");
+        // Buffer state was set directly, nothing has been scanned yet
+        cb.scanned = 0;
+        cb.line_count = 0;
+        cb.delim_count = 0;
+        interrupts_status = INTERRUPTS_ENABLED;
         int ret = circular_buffer_has_char(&cb, '\n');
 
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
         ut_assert(!ret);
         ut_assert(cb.head == 87);
         ut_assert(cb.tail == 14);
@@ -69,8 +87,14 @@ int main (int argc, char **argv)
         cb.tail = 155;
         cb.length = 0;
         memset(buffer, '*', sizeof(buffer));
+        // Buffer state was set directly, nothing has been scanned yet
+        cb.scanned = 0;
+        cb.line_count = 0;
+        cb.delim_count = 0;
+        interrupts_status = INTERRUPTS_ENABLED;
         int ret = circular_buffer_has_char(&cb, '*');
 
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
         ut_assert(!ret);
         ut_assert(cb.head == 155);
         ut_assert(cb.tail == 155);
@@ -22,8 +22,14 @@ int main (int argc, char **argv)
         cb.length = 28;
         memset(buffer, 0, sizeof(buffer));
         strcpy((char*)buffer, "abcdefghijklmnopqrstuvwxyz\r\n");
+        // Buffer state was set directly, nothing has been scanned yet
+        cb.scanned = 0;
+        cb.line_count = 0;
+        cb.delim_count = 0;
+        interrupts_status = INTERRUPTS_ENABLED;
         int ret = circular_buffer_has_line(&cb);
 
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
         ut_assert(ret);
         ut_assert(cb.head == 0);
         ut_assert(cb.tail == 28);
@@ -38,8 +44,14 @@ int main (int argc, char **argv)
         cb.length = 362;
         memset(buffer, 0, sizeof(buffer));
         strcpy((char*)buffer + 300, "abcdefghijklmnopqrstuvwxyz\r\n");
+        // Buffer state was set directly, nothing has been scanned yet
+        cb.scanned = 0;
+        cb.line_count = 0;
+        cb.delim_count = 0;
+        interrupts_status = INTERRUPTS_ENABLED;
         int ret = circular_buffer_has_line(&cb);
 
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
         ut_assert(ret);
         ut_assert(cb.head == 500);
         ut_assert(cb.tail == 350);
@@ -54,8 +66,14 @@ int main (int argc, char **argv)
         cb.length = 64;
         memset(buffer, 0, sizeof(buffer));
         strcpy((char*)buffer + 10, "abcdefghij\nklmnopqrstuvwxyz\r");
+        // Buffer state was set directly, nothing has been scanned yet
+        cb.scanned = 0;
+        cb.line_count = 0;
+        cb.delim_count = 0;
+        interrupts_status = INTERRUPTS_ENABLED;
         int ret = circular_buffer_has_line(&cb);
 
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
         ut_assert(!ret);
         ut_assert(cb.head == 0);
         ut_assert(cb.tail == 0);
@@ -70,8 +88,14 @@ int main (int argc, char **argv)
         cb.length = 28;
         memset(buffer, 0, sizeof(buffer));
         strcpy((char*)buffer, "abcdefghij\nklmnopqrstuvwxyz\r\n");
+        // Buffer state was set directly, nothing has been scanned yet
+        cb.scanned = 0;
+        cb.line_count = 0;
+        cb.delim_count = 0;
+        interrupts_status = INTERRUPTS_ENABLED;
         int ret = circular_buffer_has_line(&cb);
 
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
         ut_assert(!ret);
         ut_assert(cb.head == 0);
         ut_assert(cb.tail == 0);
@@ -87,8 +111,14 @@ int main (int argc, char **argv)
         memset(buffer, '\r', sizeof(buffer));
         buffer[10] = '\n';
         buffer[155] = '\n';
+        // Buffer state was set directly, nothing has been scanned yet
+        cb.scanned = 0;
+        cb.line_count = 0;
+        cb.delim_count = 0;
+        interrupts_status = INTERRUPTS_ENABLED;
         int ret = circular_buffer_has_line(&cb);
 
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
         ut_assert(!ret);
         ut_assert(cb.head == 154);
         ut_assert(cb.tail == 154);
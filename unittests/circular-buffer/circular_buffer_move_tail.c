@@ -0,0 +1,92 @@
+#include <string.h>
+#include "common.c"
+
+/*
+ *  circular_buffer_move_tail() moves the tail of a buffer forward by a given
+ *  number of bytes, adding data which has been written directly after the tail
+ *  to the buffer. The tail is never moved past the head.
+ */
+
+
+int main (int argc, char **argv)
+{
+    struct circular_buffer_t cb;
+    memset(&cb, 0, sizeof(cb));
+
+    // Move tail of empty buffer.
+    {
+        cb.capacity = 256;
+        cb.head = 0;
+        cb.tail = 0;
+        cb.length = 0;
+        interrupts_status = INTERRUPTS_ENABLED;
+        circular_buffer_move_tail(&cb, 100);
+
+        ut_assert(cb.head == 0);
+        ut_assert(cb.tail == 100);
+        ut_assert(cb.length == 100);
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
+    }
+
+    // Move tail to exactly the end of the buffer.
+    {
+        cb.capacity = 256;
+        cb.head = 50;
+        cb.tail = 200;
+        cb.length = 150;
+        interrupts_status = INTERRUPTS_ENABLED;
+        circular_buffer_move_tail(&cb, 56);
+
+        ut_assert(cb.head == 50);
+        ut_assert(cb.tail == 0);
+        ut_assert(cb.length == 206);
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
+    }
+
+    // Move tail when tail is before head.
+    {
+        cb.capacity = 1024;
+        cb.head = 900;
+        cb.tail = 100;
+        cb.length = 224;
+        interrupts_status = INTERRUPTS_ENABLED;
+        circular_buffer_move_tail(&cb, 300);
+
+        ut_assert(cb.head == 900);
+        ut_assert(cb.tail == 400);
+        ut_assert(cb.length == 524);
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
+    }
+
+    // Move tail by more than the unused space.
+    {
+        cb.capacity = 512;
+        cb.head = 40;
+        cb.tail = 100;
+        cb.length = 60;
+        interrupts_status = INTERRUPTS_ENABLED;
+        circular_buffer_move_tail(&cb, 600);
+
+        ut_assert(cb.head == 40);
+        ut_assert(cb.tail == 40);
+        ut_assert(cb.length == 512);
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
+    }
+
+    // Try to move tail of full buffer.
+    {
+        cb.capacity = 768;
+        cb.head = 320;
+        cb.tail = 320;
+        cb.length = 768;
+        interrupts_status = INTERRUPTS_ENABLED;
+        circular_buffer_move_tail(&cb, 10);
+
+        ut_assert(cb.head == 320);
+        ut_assert(cb.tail == 320);
+        ut_assert(cb.length == 768);
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,82 @@
+#include <string.h>
+#include "common.c"
+
+/*
+ *  circular_buffer_rescan_from_head() discards the line and delimiter counts
+ *  so that the buffer is scanned again from the head. It is used when the data
+ *  after the head has been overwritten without going through the circular
+ *  buffer functions.
+ */
+
+static void push_str(struct circular_buffer_t *cb, char const *str)
+{
+    for (; *str != '\0'; str++) {
+        interrupts_status = INTERRUPTS_ENABLED;
+        circular_buffer_push(cb, (uint8_t)*str);
+    }
+}
+
+
+int main (int argc, char **argv)
+{
+    struct circular_buffer_t cb;
+    uint8_t buffer[16];
+
+    // Counts are cleared and rebuilt from the data which is now in the buffer
+    {
+        init_circular_buffer(&cb, buffer, sizeof(buffer));
+
+        push_str(&cb, "ab\r\ncd\r\n");
+        interrupts_status = INTERRUPTS_ENABLED;
+        ut_assert(!circular_buffer_has_char(&cb, ','));
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
+        ut_assert(cb.line_count == 2);
+        ut_assert(cb.delim_count == 0);
+
+        // Overwrite the data after the head behind the buffer's back
+        memcpy(buffer, "1,2,3,4,", 8);
+
+        interrupts_status = INTERRUPTS_ENABLED;
+        circular_buffer_rescan_from_head(&cb);
+        ut_assert(interrupts_status == INTERRUPTS_CYCLED);
+        ut_assert(cb.scanned == 0);
+        ut_assert(cb.line_count == 0);
+        ut_assert(cb.delim_count == 0);
+        ut_assert(cb.length == 8);
+        ut_assert(cb.head == 0);
+
+        interrupts_status = INTERRUPTS_ENABLED;
+        ut_assert(!circular_buffer_has_line(&cb));
+        interrupts_status = INTERRUPTS_ENABLED;
+        ut_assert(circular_buffer_has_char(&cb, ','));
+        ut_assert(cb.delim_count == 4);
+    }
+
+    // Dropping overwritten bytes after a rescan does not touch the counts
+    {
+        init_circular_buffer(&cb, buffer, sizeof(buffer));
+
+        push_str(&cb, "xxxxxxxxxxxxxxxx");
+        interrupts_status = INTERRUPTS_ENABLED;
+        ut_assert(!circular_buffer_has_line(&cb));
+        ut_assert(cb.scanned == 16);
+
+        // The oldest bytes are overwritten with line endings which were never
+        // scanned, removing them from the counts one by one would underflow
+        memcpy(buffer, "\r\n\r\n", 4);
+
+        interrupts_status = INTERRUPTS_ENABLED;
+        circular_buffer_rescan_from_head(&cb);
+        interrupts_status = INTERRUPTS_ENABLED;
+        circular_buffer_move_head(&cb, 4);
+        ut_assert(cb.line_count == 0);
+        ut_assert(cb.scanned == 0);
+        ut_assert(cb.length == 12);
+
+        interrupts_status = INTERRUPTS_ENABLED;
+        ut_assert(!circular_buffer_has_line(&cb));
+        ut_assert(cb.scanned == 12);
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,196 @@
+#include <string.h>
+#include "common.c"
+
+/*
+ *  circular_buffer_scan() incrementally counts lines and delimiters in a
+ *  circular buffer. The counts are kept up to date as items are removed from the
+ *  buffer so that circular_buffer_has_line() and circular_buffer_has_char()
+ *  only need to look at new data.
+ */
+
+/** Check for a line by scanning the whole buffer */
+static int ref_has_line(struct circular_buffer_t *cb)
+{
+    for (uint16_t i = 1; i < cb->length; i++) {
+        uint16_t const pos = (cb->head + i) % cb->capacity;
+        uint16_t const prev = (cb->head + i - 1) % cb->capacity;
+        if ((cb->buffer[pos] == '\n') && (cb->buffer[prev] == '\r')) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/** Check for a character by scanning the whole buffer */
+static int ref_has_char(struct circular_buffer_t *cb, char c)
+{
+    for (uint16_t i = 0; i < cb->length; i++) {
+        if (cb->buffer[(cb->head + i) % cb->capacity] == (uint8_t)c) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void push_str(struct circular_buffer_t *cb, char const *str)
+{
+    for (; *str != '\0'; str++) {
+        interrupts_status = INTERRUPTS_ENABLED;
+        circular_buffer_push(cb, (uint8_t)*str);
+    }
+}
+
+static int has_line(struct circular_buffer_t *cb)
+{
+    interrupts_status = INTERRUPTS_ENABLED;
+    int const ret = circular_buffer_has_line(cb);
+    ut_assert(interrupts_status == INTERRUPTS_CYCLED);
+    ut_assert(ret == ref_has_line(cb));
+    return ret;
+}
+
+static int has_char(struct circular_buffer_t *cb, char c)
+{
+    interrupts_status = INTERRUPTS_ENABLED;
+    int const ret = circular_buffer_has_char(cb, c);
+    ut_assert(interrupts_status == INTERRUPTS_CYCLED);
+    ut_assert(ret == ref_has_char(cb, c));
+    return ret;
+}
+
+
+int main (int argc, char **argv)
+{
+    struct circular_buffer_t cb;
+    uint8_t buffer[16];
+    uint8_t c;
+
+    // Lines are counted as they arrive, including lines which wrap
+    {
+        init_circular_buffer(&cb, buffer, sizeof(buffer));
+        cb.head = 12;
+        cb.tail = 12;
+
+        push_str(&cb, "ok\r");
+        ut_assert(!has_line(&cb));
+        ut_assert(cb.scanned == 3);
+        push_str(&cb, "\nab\r\n");
+        ut_assert(has_line(&cb));
+        ut_assert(cb.scanned == 8);
+        ut_assert(cb.line_count == 2);
+        ut_assert(cb.tail == 4);
+
+        // Popping the first line leaves one
+        for (int i = 0; i < 4; i++) {
+            interrupts_status = INTERRUPTS_ENABLED;
+            circular_buffer_pop(&cb, &c);
+        }
+        ut_assert(cb.line_count == 1);
+        ut_assert(cb.scanned == 4);
+        ut_assert(has_line(&cb));
+
+        // Moving the head past the carriage return breaks the second line
+        interrupts_status = INTERRUPTS_ENABLED;
+        circular_buffer_move_head(&cb, 3);
+        ut_assert(cb.line_count == 0);
+        ut_assert(cb.scanned == 1);
+        ut_assert(!has_line(&cb));
+    }
+
+    // A line ending which is split by an unscanned region
+    {
+        init_circular_buffer(&cb, buffer, sizeof(buffer));
+
+        push_str(&cb, "abc\r");
+        ut_assert(!has_line(&cb));
+        push_str(&cb, "\n");
+        ut_assert(has_line(&cb));
+
+        // Unpushing the newline removes the line
+        interrupts_status = INTERRUPTS_ENABLED;
+        circular_buffer_unpush(&cb);
+        ut_assert(cb.line_count == 0);
+        ut_assert(!has_line(&cb));
+    }
+
+    // Delimiters are counted and recounted when the delimiter changes
+    {
+        init_circular_buffer(&cb, buffer, sizeof(buffer));
+
+        push_str(&cb, "radio rx ");
+        ut_assert(has_char(&cb, ' '));
+        ut_assert(cb.delim_count == 2);
+        ut_assert(!has_char(&cb, '\n'));
+        ut_assert(cb.delim_count == 0);
+        ut_assert(has_char(&cb, ' '));
+        ut_assert(cb.delim_count == 2);
+
+        interrupts_status = INTERRUPTS_ENABLED;
+        circular_buffer_move_head(&cb, 6);
+        ut_assert(cb.delim_count == 1);
+        ut_assert(has_char(&cb, ' '));
+        push_str(&cb, "1234 ");
+        ut_assert(has_char(&cb, ' '));
+        ut_assert(cb.delim_count == 2);
+    }
+
+    // Overwriting old data when the buffer is full
+    {
+        init_circular_buffer(&cb, buffer, sizeof(buffer));
+
+        push_str(&cb, "\r\n0123456789abc\r");
+        ut_assert(circular_buffer_is_full(&cb));
+        ut_assert(has_line(&cb));
+        ut_assert(has_char(&cb, '\r'));
+        ut_assert(cb.delim_count == 2);
+
+        // Overwriting the carriage return at the head removes the line
+        push_str(&cb, "\n");
+        ut_assert(cb.line_count == 0);
+        ut_assert(cb.delim_count == 1);
+        // The newline which completes the last line is counted when scanned
+        ut_assert(has_line(&cb));
+        ut_assert(cb.line_count == 1);
+    }
+
+    // Arbitrary sequences of operations always match a full scan
+    {
+        init_circular_buffer(&cb, buffer, sizeof(buffer));
+        static char const alphabet[] = "\r\n\r\nab ";
+        uint32_t seed = 0x12345678;
+
+        for (int i = 0; i < 10000; i++) {
+            seed = seed * 1103515245 + 12345;
+            uint8_t const op = (seed >> 16) & 0x7;
+            uint8_t const arg = (seed >> 20) & 0x7;
+
+            interrupts_status = INTERRUPTS_ENABLED;
+            switch (op) {
+                case 0:
+                case 1:
+                case 2:
+                    circular_buffer_push(&cb, (uint8_t)alphabet[arg % 7]);
+                    break;
+                case 3:
+                    circular_buffer_pop(&cb, &c);
+                    break;
+                case 4:
+                    circular_buffer_move_head(&cb, arg);
+                    break;
+                case 5:
+                    circular_buffer_unpush(&cb);
+                    break;
+                case 6:
+                    has_line(&cb);
+                    break;
+                case 7:
+                    has_char(&cb, (arg & 1) ? ' ' : '\r');
+                    break;
+            }
+
+            ut_assert(cb.scanned <= cb.length);
+        }
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,68 @@
+/*
+ *  Stubs for the UART used by the GNSS driver. Data to be received is placed
+ *  in rx_data and commands sent by the driver are appended to tx_data.
+ */
+
+#include "nmea.c"
+
+volatile uint32_t millis;
+
+static char rx_data[512];
+static uint16_t rx_pos;
+static char tx_data[512];
+static uint8_t num_baud_changes;
+/** Value to be returned by sercom_uart_tx_idle() */
+static uint8_t tx_idle;
+static struct sercom_uart_desc_t test_uart;
+
+char *utoa(unsigned value, char *str, int base)
+{
+    sprintf(str, "%u", value);
+    return str;
+}
+
+static void reset_uart(uint32_t baud)
+{
+    rx_data[0] = '\0';
+    rx_pos = 0;
+    tx_data[0] = '\0';
+    test_uart.baudrate = baud;
+    num_baud_changes = 0;
+    tx_idle = 1;
+}
+
+static void receive(const char *data)
+{
+    strcpy(rx_data, data);
+    rx_pos = 0;
+}
+
+void sercom_uart_put_string_blocking(struct sercom_uart_desc_t *uart,
+                                     const char *str)
+{
+    strcat(tx_data, str);
+}
+
+uint16_t sercom_uart_get_received(struct sercom_uart_desc_t *uart,
+                                  const uint8_t **data)
+{
+    *data = (const uint8_t *)rx_data + rx_pos;
+    return (uint16_t)strlen(rx_data + rx_pos);
+}
+
+uint8_t sercom_uart_consume(struct sercom_uart_desc_t *uart, uint16_t length)
+{
+    rx_pos += length;
+    return 0;
+}
+
+void sercom_uart_set_baud(struct sercom_uart_desc_t *uart, uint32_t baudrate)
+{
+    uart->baudrate = baudrate;
+    num_baud_changes++;
+}
+
+uint8_t sercom_uart_tx_idle(struct sercom_uart_desc_t *uart)
+{
+    return tx_idle;
+}
@@ -0,0 +1,51 @@
+#include <unittest.h>
+
+// Provided by newlib on target but not by the host C library
+char *utoa(unsigned value, char *str, int base);
+
+#include SOURCE_C
+
+#include "gnss_stubs.c"
+
+/*
+ *  gnss_xa1110_calc_mode() picks how often the GSA and GSV sentences are sent
+ *  and the slowest baud rate which can carry every sentence for a fix rate.
+ */
+
+int main (int argc, char **argv)
+{
+    struct gnss_xa1110_mode mode;
+
+    // One fix per second fits at a low baud rate with every sentence enabled
+    gnss_xa1110_calc_mode(1, &mode);
+    ut_assert(mode.fix_rate == 1);
+    ut_assert(mode.gsa_divisor == 1);
+    ut_assert(mode.gsv_divisor == 5);
+    ut_assert(mode.baud == 19200);
+
+    // Every rate gets a baud rate with enough room for all of its sentences
+    for (uint8_t rate = 1; rate <= GNSS_MAX_FIX_RATE; rate++) {
+        gnss_xa1110_calc_mode(rate, &mode);
+        ut_assert(mode.fix_rate == rate);
+        ut_assert(mode.gsa_divisor <= GNSS_MAX_DIVISOR);
+        ut_assert(mode.gsv_divisor <= GNSS_MAX_DIVISOR);
+        ut_assert((gnss_mode_bytes_per_second(&mode) * 10) <=
+                  ((mode.baud * GNSS_MAX_UART_LOAD) / 100));
+    }
+
+    // Ten fixes per second needs the fastest baud rate, GSA and GSV are sent
+    // as rarely as possible
+    gnss_xa1110_calc_mode(10, &mode);
+    ut_assert(mode.fix_rate == 10);
+    ut_assert(mode.gsa_divisor == 5);
+    ut_assert(mode.gsv_divisor == 5);
+    ut_assert(mode.baud == 115200);
+
+    // Rates out of range are clamped
+    gnss_xa1110_calc_mode(0, &mode);
+    ut_assert(mode.fix_rate == 1);
+    gnss_xa1110_calc_mode(50, &mode);
+    ut_assert(mode.fix_rate == GNSS_MAX_FIX_RATE);
+
+    return UT_PASS;
+}
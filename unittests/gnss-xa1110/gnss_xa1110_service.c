@@ -0,0 +1,97 @@
+#include <unittest.h>
+
+// Provided by newlib on target but not by the host C library
+char *utoa(unsigned value, char *str, int base);
+
+#include SOURCE_C
+
+#include "gnss_stubs.c"
+
+/*
+ *  gnss_xa1110_service() parses sentences from the module, finds the baud rate
+ *  the module is using, switches it to the baud rate needed for the fix rate
+ *  and then configures its outputs.
+ */
+
+static const char rmc[] = "$GNRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,"
+                          "165.48,260406,3.05,W,A*32\r\n";
+static const char gga[] = "$GNGGA,064951.000,2307.1256,N,12016.4438,E,1,8,"
+                          "0.95,39.9,M,17.8,M,,*7D\r\n";
+static const char rmc_next[] = "$GNRMC,064951.100,A,2307.1256,N,12016.4438,E,"
+                               "0.03,165.48,260406,3.05,W,A*33\r\n";
+
+
+int main (int argc, char **argv)
+{
+    // Module starts out at 9600 baud and is switched to 115200 for 10 Hz
+    reset_uart(9600);
+    millis = 1000;
+    init_gnss_xa1110(&test_uart, 10);
+    gnss_xa1110_service();
+    ut_assert(tx_data[0] == '\0');
+
+    // Nothing heard at 9600, the next baud rate is tried
+    millis += GNSS_SEARCH_TIMEOUT + 1;
+    gnss_xa1110_service();
+    ut_assert(test_uart.baudrate == 19200);
+
+    // Try every other baud rate and wrap back around to 9600
+    for (int i = 0; i < 4; i++) {
+        millis += GNSS_SEARCH_TIMEOUT + 1;
+        gnss_xa1110_service();
+    }
+    ut_assert(test_uart.baudrate == 9600);
+    ut_assert(num_baud_changes == 5);
+
+    // Once the module is heard it is told to change baud rate
+    tx_idle = 0;
+    receive(rmc);
+    gnss_xa1110_service();
+    ut_assert(!strcmp(tx_data, "$PMTK251,115200*1F\r\n"));
+    ut_assert(test_uart.baudrate == 9600);
+
+    // We do not follow until the command has been shifted out, no matter how
+    // long that takes
+    millis += 100;
+    gnss_xa1110_service();
+    ut_assert(test_uart.baudrate == 9600);
+
+    // We follow after the command has been sent
+    tx_idle = 1;
+    gnss_xa1110_service();
+    ut_assert(test_uart.baudrate == 115200);
+    ut_assert(num_baud_changes == 6);
+
+    // The module is configured once it is heard at the new baud rate
+    tx_data[0] = '\0';
+    receive(gga);
+    gnss_xa1110_service();
+    ut_assert(!strcmp(tx_data,
+                      "$PMTK220,100*2F\r\n"
+                      "$PMTK886,2*2A\r\n"
+                      "$PGCMD,231,1*5C\r\n"
+                      "$PMTK314,0,1,0,1,5,5,0,0,0,0,0,0,0,0,0,0,0,0,0*28\r\n"
+                      "$PGCMD,203*40\r\n"));
+    ut_assert(gnss_state == GNSS_STATE_RUNNING);
+
+    // The RMC sentence received earlier was for the same fix as this GGA
+    // sentence, so the fix is complete
+    ut_assert(gnss_xa1110_descriptor.last_fix == millis);
+    ut_assert(gnss_xa1110_descriptor.latitude == 13871256);
+    ut_assert(gnss_xa1110_descriptor.altitude == 39900);
+
+    // The RMC sentence for the next fix does not complete it on its own
+    uint32_t const fix_time = millis;
+    millis += 100;
+    receive(rmc_next);
+    gnss_xa1110_service();
+    ut_assert(gnss_xa1110_descriptor.last_fix == fix_time);
+    ut_assert(gnss_xa1110_descriptor.last_sentence == millis);
+
+    // If the module goes quiet it is searched for again
+    millis += GNSS_LOST_TIMEOUT + 1;
+    gnss_xa1110_service();
+    ut_assert(gnss_state == GNSS_STATE_SEARCH);
+
+    return UT_PASS;
+}
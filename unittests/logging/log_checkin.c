@@ -0,0 +1,49 @@
+#include <unittest.h>
+#include SOURCE_C
+
+#include "logging_stubs.c"
+
+/*
+ *  log_checkin() releases space that was reserved with log_checkout().
+ */
+
+static struct logging_desc_t logging;
+
+int main (int argc, char **argv)
+{
+    // Check in a buffer from the start of the ring.
+    {
+        init_active_logging(&logging);
+        logging.buffer[0].checkout_count = 2;
+        int ret = log_checkin(&logging, logging.data[0] + 10);
+
+        ut_assert(ret == 0);
+        ut_assert(logging.buffer[0].checkout_count == 1);
+    }
+
+    // Check in a buffer from the last byte of the ring.
+    {
+        init_active_logging(&logging);
+        uint8_t const last = LOGGING_NUM_BUFFERS - 1;
+        logging.buffer[last].checkout_count = 1;
+        int ret = log_checkin(&logging, logging.data[last] +
+                                            LOGGING_BUFFER_SIZE - 1);
+
+        ut_assert(ret == 0);
+        ut_assert(logging.buffer[last].checkout_count == 0);
+    }
+
+    // Check in a pointer that is not from the ring.
+    {
+        init_active_logging(&logging);
+        uint8_t other[16];
+        int ret = log_checkin(&logging, other);
+
+        ut_assert(ret != 0);
+        for (int i = 0; i < LOGGING_NUM_BUFFERS; i++) {
+            ut_assert(logging.buffer[i].checkout_count == 0);
+        }
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,118 @@
+#include <unittest.h>
+#include SOURCE_C
+
+#include "logging_stubs.c"
+
+/*
+ *  log_checkout() reserves space in the logging service's ring of buffers.
+ */
+
+static struct logging_desc_t logging;
+
+int main (int argc, char **argv)
+{
+    // Checkout from an empty ring.
+    {
+        init_active_logging(&logging);
+        uint8_t *buffer = NULL;
+        int ret = log_checkout(&logging, &buffer, 100);
+
+        ut_assert(ret == 0);
+        ut_assert(buffer == logging.data[0]);
+        ut_assert(logging.prod_cursor == 100);
+        ut_assert(logging.buffer[0].count == 100);
+        ut_assert(logging.buffer[0].checkout_count == 1);
+        ut_assert(logging.out_of_space_count == 0);
+    }
+
+    // Checkout that fits exactly in the remainder of the current buffer.
+    {
+        init_active_logging(&logging);
+        logging.prod_cursor = LOGGING_BUFFER_SIZE - 64;
+        logging.buffer[0].count = LOGGING_BUFFER_SIZE - 64;
+        uint8_t *buffer = NULL;
+        int ret = log_checkout(&logging, &buffer, 64);
+
+        ut_assert(ret == 0);
+        ut_assert(buffer == (logging.data[0] + LOGGING_BUFFER_SIZE - 64));
+        ut_assert(LOGGING_CURSOR_SEQ(logging.prod_cursor) == 0);
+        ut_assert(LOGGING_CURSOR_OFFSET(logging.prod_cursor) ==
+                  LOGGING_BUFFER_SIZE);
+        ut_assert(logging.buffer[0].count == LOGGING_BUFFER_SIZE);
+    }
+
+    // Checkout that does not fit in the current buffer moves on to the next
+    // buffer in the ring.
+    {
+        init_active_logging(&logging);
+        logging.prod_cursor = LOGGING_BUFFER_SIZE - 64;
+        logging.buffer[0].count = LOGGING_BUFFER_SIZE - 64;
+        uint8_t *buffer = NULL;
+        int ret = log_checkout(&logging, &buffer, 128);
+
+        ut_assert(ret == 0);
+        ut_assert(buffer == logging.data[1]);
+        ut_assert(LOGGING_CURSOR_SEQ(logging.prod_cursor) == 1);
+        ut_assert(LOGGING_CURSOR_OFFSET(logging.prod_cursor) == 128);
+        ut_assert(logging.buffer[0].count == LOGGING_BUFFER_SIZE - 64);
+        ut_assert(logging.buffer[0].checkout_count == 0);
+        ut_assert(logging.buffer[1].count == 128);
+        ut_assert(logging.buffer[1].checkout_count == 1);
+    }
+
+    // Checkout from the last buffer in the ring wraps around to the first.
+    {
+        init_active_logging(&logging);
+        uint16_t const last = LOGGING_NUM_BUFFERS - 1;
+        logging.cons_cursor = last;
+        logging.prod_cursor = ((uint32_t)last << 16) | LOGGING_BUFFER_SIZE;
+        logging.buffer[last].count = LOGGING_BUFFER_SIZE;
+        uint8_t *buffer = NULL;
+        int ret = log_checkout(&logging, &buffer, 32);
+
+        ut_assert(ret == 0);
+        ut_assert(buffer == logging.data[0]);
+        ut_assert(LOGGING_CURSOR_SEQ(logging.prod_cursor) == last + 1);
+        ut_assert(logging.buffer[0].count == 32);
+    }
+
+    // Sequence numbers wrap around without losing track of the ring.
+    {
+        init_active_logging(&logging);
+        logging.cons_cursor = UINT16_MAX;
+        logging.prod_cursor = ((uint32_t)UINT16_MAX << 16) | LOGGING_BUFFER_SIZE;
+        uint8_t *buffer = NULL;
+        int ret = log_checkout(&logging, &buffer, 32);
+
+        ut_assert(ret == 0);
+        ut_assert(LOGGING_CURSOR_SEQ(logging.prod_cursor) == 0);
+        ut_assert(buffer == logging.data[0]);
+    }
+
+    // Checkout fails when every buffer in the ring is waiting to be written.
+    {
+        init_active_logging(&logging);
+        uint16_t const last = LOGGING_NUM_BUFFERS - 1;
+        logging.prod_cursor = ((uint32_t)last << 16) | LOGGING_BUFFER_SIZE;
+        uint8_t *buffer = NULL;
+        int ret = log_checkout(&logging, &buffer, 32);
+
+        ut_assert(ret != 0);
+        ut_assert(buffer == NULL);
+        ut_assert(LOGGING_CURSOR_SEQ(logging.prod_cursor) == last);
+        ut_assert(logging.out_of_space_count == 1);
+    }
+
+    // Checkout that is larger than a buffer fails.
+    {
+        init_active_logging(&logging);
+        uint8_t *buffer = NULL;
+        int ret = log_checkout(&logging, &buffer, LOGGING_BUFFER_SIZE + 4);
+
+        ut_assert(ret != 0);
+        ut_assert(logging.prod_cursor == 0);
+        ut_assert(logging.out_of_space_count == 1);
+    }
+
+    return UT_PASS;
+}
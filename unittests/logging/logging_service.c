@@ -0,0 +1,402 @@
+#include <unittest.h>
+#include SOURCE_C
+
+#include "logging_stubs.c"
+
+/*
+ *  logging_service() writes closed buffers from the logging ring to the SD
+ *  card, combining consecutive buffers into a single multi-block write.
+ */
+
+#define BLOCKS_PER_BUFFER   (LOGGING_BUFFER_SIZE / SD_BLOCK_LENGTH)
+
+static struct logging_desc_t logging;
+
+/**
+ *  Mark a number of buffers, starting at the consumer cursor, as closed with
+ *  the given byte counts.
+ */
+static void close_buffers(const uint16_t *counts, uint8_t num)
+{
+    uint16_t seq = logging.cons_cursor;
+    for (uint8_t i = 0; i < num; i++, seq++) {
+        logging.buffer[LOGGING_BUF_IDX(seq)].count = counts[i];
+    }
+    logging.prod_cursor = (uint32_t)seq << 16;
+}
+
+int main (int argc, char **argv)
+{
+    // Nothing is written when the ring is empty.
+    {
+        init_active_logging(&logging);
+        logging_service(&logging);
+
+        ut_assert(sd_write_call_count == 0);
+        ut_assert(!logging.sd_write_in_progress);
+    }
+
+    // The current buffer is closed and written once it is filled past the
+    // watermark.
+    {
+        init_active_logging(&logging);
+        logging.prod_cursor = LOGGING_BUFFER_SIZE - 16;
+        logging.buffer[0].count = LOGGING_BUFFER_SIZE - 16;
+        logging_service(&logging);
+
+        ut_assert(sd_write_call_count == 1);
+        ut_assert(sd_write_op.addr == TEST_PART_START + 1);
+        ut_assert(sd_write_op.num_blocks == BLOCKS_PER_BUFFER);
+        ut_assert(sd_write_op.data == logging.data[0]);
+        ut_assert(LOGGING_CURSOR_SEQ(logging.prod_cursor) == 1);
+        // Check that a spacer was added at the end of the buffer
+        uint8_t const *spacer = logging.data[0] + LOGGING_BUFFER_SIZE - 16;
+        ut_assert(logging_block_class(spacer) == LOGGING_BLOCK_CLASS_METADATA);
+        ut_assert(logging_block_length(spacer) == 16);
+
+        sd_complete_write();
+
+        ut_assert(logging.cons_cursor == 1);
+        ut_assert(logging.buffer[0].count == 0);
+        ut_assert(logging.sb.flights[0].num_blocks == BLOCKS_PER_BUFFER);
+        ut_assert(!logging.sd_write_in_progress);
+    }
+
+    // A partially filled buffer is not written before the write interval.
+    {
+        init_active_logging(&logging);
+        logging.prod_cursor = 100;
+        logging.buffer[0].count = 100;
+        logging_service(&logging);
+
+        ut_assert(sd_write_call_count == 0);
+        ut_assert(logging.prod_cursor == 100);
+    }
+
+    // A partially filled buffer is closed and written once the write interval
+    // has expired.
+    {
+        init_active_logging(&logging);
+        logging.prod_cursor = 100;
+        logging.buffer[0].count = 100;
+        millis += LOGGING_BUFFER_WRITE_INTERVAL;
+        logging.last_sb_write = millis;
+        logging_service(&logging);
+
+        ut_assert(sd_write_call_count == 1);
+        ut_assert(sd_write_op.num_blocks == 1);
+        ut_assert(logging.buffer[0].count == SD_BLOCK_LENGTH);
+        ut_assert(logging.last_data_write == millis);
+    }
+
+    // Consecutive closed buffers are written in a single operation.
+    {
+        init_active_logging(&logging);
+        uint16_t const counts[] = { LOGGING_BUFFER_SIZE, LOGGING_BUFFER_SIZE,
+                                    LOGGING_BUFFER_SIZE - 8 };
+        close_buffers(counts, 3);
+        logging_service(&logging);
+
+        ut_assert(sd_write_call_count == 1);
+        ut_assert(sd_write_op.num_blocks == 3 * BLOCKS_PER_BUFFER);
+        ut_assert(sd_write_op.data == logging.data[0]);
+        ut_assert(logging.buffers_in_progress == 3);
+
+        sd_complete_write();
+
+        ut_assert(logging.cons_cursor == 3);
+        ut_assert(logging.sb.flights[0].num_blocks == 3 * BLOCKS_PER_BUFFER);
+        for (int i = 0; i < 3; i++) {
+            ut_assert(logging.buffer[i].count == 0);
+        }
+    }
+
+    // A run of buffers ends after a buffer that does not fill all of its
+    // blocks.
+    {
+        init_active_logging(&logging);
+        uint16_t const counts[] = { LOGGING_BUFFER_SIZE - 12, 300,
+                                    LOGGING_BUFFER_SIZE };
+        close_buffers(counts, 3);
+        logging_service(&logging);
+
+        ut_assert(sd_write_call_count == 1);
+        ut_assert(sd_write_op.num_blocks == BLOCKS_PER_BUFFER + 1);
+        ut_assert(logging.buffers_in_progress == 2);
+        uint8_t const *spacer = logging.data[1] + 300;
+        ut_assert(logging_block_class(spacer) == LOGGING_BLOCK_CLASS_METADATA);
+        ut_assert(logging_block_length(spacer) == SD_BLOCK_LENGTH - 300);
+
+        sd_complete_write();
+        logging_service(&logging);
+
+        ut_assert(sd_write_call_count == 2);
+        ut_assert(sd_write_op.addr == (TEST_PART_START + 1 +
+                                       BLOCKS_PER_BUFFER + 1));
+        ut_assert(sd_write_op.data == logging.data[2]);
+        ut_assert(sd_write_op.num_blocks == BLOCKS_PER_BUFFER);
+    }
+
+    // A run of buffers ends at a buffer that is still checked out.
+    {
+        init_active_logging(&logging);
+        uint16_t const counts[] = { LOGGING_BUFFER_SIZE, LOGGING_BUFFER_SIZE };
+        close_buffers(counts, 2);
+        logging.buffer[1].checkout_count = 1;
+        logging_service(&logging);
+
+        ut_assert(sd_write_call_count == 1);
+        ut_assert(sd_write_op.num_blocks == BLOCKS_PER_BUFFER);
+        ut_assert(logging.buffers_in_progress == 1);
+    }
+
+    // Nothing is written while the oldest buffer is checked out.
+    {
+        init_active_logging(&logging);
+        uint16_t const counts[] = { LOGGING_BUFFER_SIZE, LOGGING_BUFFER_SIZE };
+        close_buffers(counts, 2);
+        logging.buffer[0].checkout_count = 1;
+        logging_service(&logging);
+
+        ut_assert(sd_write_call_count == 0);
+    }
+
+    // A run of buffers does not wrap around the end of the ring.
+    {
+        init_active_logging(&logging);
+        logging.cons_cursor = LOGGING_NUM_BUFFERS - 1;
+        uint16_t const counts[] = { LOGGING_BUFFER_SIZE, LOGGING_BUFFER_SIZE };
+        close_buffers(counts, 2);
+        logging_service(&logging);
+
+        ut_assert(sd_write_call_count == 1);
+        ut_assert(sd_write_op.data == logging.data[LOGGING_NUM_BUFFERS - 1]);
+        ut_assert(sd_write_op.num_blocks == BLOCKS_PER_BUFFER);
+
+        sd_complete_write();
+        logging_service(&logging);
+
+        ut_assert(sd_write_call_count == 2);
+        ut_assert(sd_write_op.data == logging.data[0]);
+        ut_assert(logging.cons_cursor == LOGGING_NUM_BUFFERS);
+    }
+
+    // Buffers are kept if the write could not be started.
+    {
+        init_active_logging(&logging);
+        uint16_t const counts[] = { LOGGING_BUFFER_SIZE };
+        close_buffers(counts, 1);
+        sd_write_retval = 1;
+        logging_service(&logging);
+
+        ut_assert(sd_write_call_count == 1);
+        ut_assert(!logging.sd_write_in_progress);
+        ut_assert(logging.cons_cursor == 0);
+
+        sd_write_retval = 0;
+        logging_service(&logging);
+
+        ut_assert(sd_write_call_count == 2);
+        ut_assert(logging.sd_write_in_progress);
+    }
+
+    // Buffers are kept if not all of the blocks could be written.
+    {
+        init_active_logging(&logging);
+        uint16_t const counts[] = { LOGGING_BUFFER_SIZE };
+        close_buffers(counts, 1);
+        logging_service(&logging);
+        sd_write_op.pending = 0;
+        sd_write_op.cb(sd_write_op.context, SD_OP_FAILED, 0);
+
+        ut_assert(!logging.sd_write_in_progress);
+        ut_assert(logging.cons_cursor == 0);
+        ut_assert(logging.buffer[0].count == LOGGING_BUFFER_SIZE);
+        ut_assert(logging.sb.flights[0].num_blocks == 0);
+    }
+
+    // The service stops when the partition is full.
+    {
+        init_active_logging(&logging);
+        logging.sb.flights[0].num_blocks = TEST_PART_BLOCKS - 1;
+        uint16_t const counts[] = { LOGGING_BUFFER_SIZE };
+        close_buffers(counts, 1);
+        logging_service(&logging);
+
+        ut_assert(logging.state == LOGGING_OUT_OF_SPACE);
+        // Only the superblock should have been written
+        ut_assert(sd_write_call_count == 1);
+        ut_assert(sd_write_op.addr == TEST_PART_START);
+    }
+
+    // With vectored writes a run wraps around the end of the ring and carries
+    // on past partly full buffers.
+    {
+        init_active_logging(&logging);
+        enable_vectored_writes(&logging);
+        logging.cons_cursor = LOGGING_NUM_BUFFERS - 1;
+        uint16_t const counts[] = { LOGGING_BUFFER_SIZE, 300,
+                                    LOGGING_BUFFER_SIZE };
+        close_buffers(counts, 3);
+        logging_service(&logging);
+
+        ut_assert(sd_write_call_count == 1);
+        ut_assert(sd_write_op.num_segments == 3);
+        ut_assert(sd_write_op.segments[0].data ==
+                        logging.data[LOGGING_NUM_BUFFERS - 1]);
+        ut_assert(sd_write_op.segments[0].num_blocks == BLOCKS_PER_BUFFER);
+        ut_assert(sd_write_op.segments[1].data == logging.data[0]);
+        ut_assert(sd_write_op.segments[1].num_blocks == 1);
+        ut_assert(sd_write_op.segments[2].data == logging.data[1]);
+        ut_assert(sd_write_op.segments[2].num_blocks == BLOCKS_PER_BUFFER);
+        ut_assert(sd_write_op.num_blocks == 2 * BLOCKS_PER_BUFFER + 1);
+        ut_assert(logging.buffers_in_progress == 3);
+
+        sd_complete_write();
+
+        ut_assert(logging.cons_cursor == LOGGING_NUM_BUFFERS + 2);
+        ut_assert(logging.sb.flights[0].num_blocks ==
+                        2 * BLOCKS_PER_BUFFER + 1);
+        ut_assert(logging.buffer[0].count == 0);
+        ut_assert(logging.buffer[1].count == 0);
+        ut_assert(logging.buffer[LOGGING_NUM_BUFFERS - 1].count == 0);
+    }
+
+    // A vectored write is trimmed to the space left in the partition.
+    {
+        init_active_logging(&logging);
+        enable_vectored_writes(&logging);
+        logging.sb.flights[0].num_blocks = (TEST_PART_BLOCKS - 1 -
+                                            BLOCKS_PER_BUFFER - 1);
+        uint16_t const counts[] = { LOGGING_BUFFER_SIZE, LOGGING_BUFFER_SIZE };
+        close_buffers(counts, 2);
+        logging_service(&logging);
+
+        ut_assert(sd_write_call_count == 1);
+        ut_assert(sd_write_op.num_segments == 2);
+        ut_assert(sd_write_op.segments[1].num_blocks == 1);
+        ut_assert(sd_write_op.num_blocks == BLOCKS_PER_BUFFER + 1);
+    }
+
+    // The time taken by each data write is added to the latency histogram.
+    {
+        init_active_logging(&logging);
+        uint16_t const counts[] = { LOGGING_BUFFER_SIZE };
+        close_buffers(counts, 1);
+        logging_service(&logging);
+        millis += 5;
+        sd_complete_write();
+
+        ut_assert(logging.write_latency_hist[3] == 1);
+        ut_assert(logging.max_write_latency == 5);
+
+        // Superblock writes are not counted
+        logging_pause(&logging);
+        millis += 1000;
+        sd_complete_write();
+
+        ut_assert(logging.write_latency_hist[LOGGING_LATENCY_HIST_BUCKETS - 1]
+                        == 0);
+        ut_assert(logging.max_write_latency == 5);
+    }
+
+    // A failed write is not added to the latency histogram.
+    {
+        init_active_logging(&logging);
+        uint16_t const counts[] = { LOGGING_BUFFER_SIZE };
+        close_buffers(counts, 1);
+        logging_service(&logging);
+        millis += 5;
+        sd_write_op.pending = 0;
+        sd_write_op.cb(sd_write_op.context, SD_OP_FAILED, 0);
+
+        for (int i = 0; i < LOGGING_LATENCY_HIST_BUCKETS; i++) {
+            ut_assert(logging.write_latency_hist[i] == 0);
+        }
+        ut_assert(logging.max_write_latency == 0);
+        ut_assert(!logging.sd_write_in_progress);
+    }
+
+    // Blocks for a new flight are erased a piece at a time while the card is
+    // not being used for data writes, logging does not wait for the erase.
+    {
+        init_active_logging(&logging);
+        logging.sd_funcs.erase = sd_erase_stub;
+        logging.erase_next = 1;
+        logging.erase_end = TEST_PART_BLOCKS;
+        logging_service(&logging);
+
+        ut_assert(sd_erase_op.pending);
+        ut_assert(sd_erase_op.addr == TEST_PART_START + 1);
+        ut_assert(sd_erase_op.num_blocks == LOGGING_PRE_ERASE_CHUNK_BLOCKS);
+        ut_assert(logging.sd_write_in_progress);
+        ut_assert(logging.erase_in_progress);
+
+        // Data written while the erase is ongoing waits for it to finish
+        uint16_t const counts[] = { LOGGING_BUFFER_SIZE };
+        close_buffers(counts, 1);
+        logging_service(&logging);
+        ut_assert(sd_write_call_count == 0);
+
+        sd_erase_op.pending = 0;
+        sd_erase_op.cb(sd_erase_op.context, SD_OP_SUCCESS,
+                       sd_erase_op.num_blocks);
+        ut_assert(!logging.sd_write_in_progress);
+        ut_assert(!logging.erase_in_progress);
+
+        // Data writes come before the rest of the erase
+        logging_service(&logging);
+        ut_assert(sd_write_call_count == 1);
+        ut_assert(!sd_erase_op.pending);
+        sd_complete_write();
+        ut_assert(logging.write_latency_hist[0] == 1);
+
+        logging_service(&logging);
+        ut_assert(sd_erase_op.pending);
+        ut_assert(sd_erase_op.addr ==
+                        TEST_PART_START + 1 + LOGGING_PRE_ERASE_CHUNK_BLOCKS);
+        ut_assert(sd_erase_op.num_blocks ==
+                        TEST_PART_BLOCKS - 1 - LOGGING_PRE_ERASE_CHUNK_BLOCKS);
+
+        sd_erase_op.pending = 0;
+        sd_erase_op.cb(sd_erase_op.context, SD_OP_SUCCESS,
+                       sd_erase_op.num_blocks);
+        ut_assert(logging.erase_next == TEST_PART_BLOCKS);
+
+        logging_service(&logging);
+        ut_assert(!sd_erase_op.pending);
+    }
+
+    // Blocks which have already been written are never erased.
+    {
+        init_active_logging(&logging);
+        logging.sd_funcs.erase = sd_erase_stub;
+        logging.erase_next = 1;
+        logging.erase_end = TEST_PART_BLOCKS;
+        logging.sb.flights[0].num_blocks = LOGGING_PRE_ERASE_CHUNK_BLOCKS + 10;
+        logging_service(&logging);
+
+        ut_assert(sd_erase_op.pending);
+        ut_assert(sd_erase_op.addr ==
+                        TEST_PART_START + 11 + LOGGING_PRE_ERASE_CHUNK_BLOCKS);
+    }
+
+    // Pre-erasing stops if an erase fails.
+    {
+        init_active_logging(&logging);
+        logging.sd_funcs.erase = sd_erase_stub;
+        logging.erase_next = 1;
+        logging.erase_end = TEST_PART_BLOCKS;
+        logging_service(&logging);
+
+        ut_assert(sd_erase_op.pending);
+        sd_erase_op.pending = 0;
+        sd_erase_op.cb(sd_erase_op.context, SD_OP_FAILED, 0);
+        ut_assert(!logging.sd_write_in_progress);
+
+        logging_service(&logging);
+        ut_assert(!sd_erase_op.pending);
+    }
+
+    return UT_PASS;
+}
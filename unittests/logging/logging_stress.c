@@ -0,0 +1,388 @@
+#include <unittest.h>
+
+/*
+ *  Every atomic operation in the logging service is a point at which an
+ *  interrupt could preempt the code that is running. The atomic builtins are
+ *  wrapped so that a simulated interrupt can be run at any one of them.
+ */
+static void atomic_op_hook(void);
+/** Number of compare and exchange operations that have failed */
+static uint32_t cas_fail_count;
+
+#define __atomic_load_n(...) \
+    (atomic_op_hook(), __atomic_load_n(__VA_ARGS__))
+#define __atomic_store_n(...) \
+    (atomic_op_hook(), __atomic_store_n(__VA_ARGS__))
+#define __atomic_add_fetch(...) \
+    (atomic_op_hook(), __atomic_add_fetch(__VA_ARGS__))
+#define __atomic_sub_fetch(...) \
+    (atomic_op_hook(), __atomic_sub_fetch(__VA_ARGS__))
+#define __atomic_compare_exchange_n(...) \
+    (atomic_op_hook(), (__atomic_compare_exchange_n(__VA_ARGS__) ? 1 : \
+                        (cas_fail_count++, 0)))
+
+#include SOURCE_C
+
+#include "logging_stubs.c"
+
+/*
+ *  Stress test for the logging ring. Sensor data is checked out and checked
+ *  in from a simulated interrupt context and from the main loop at flight data
+ *  rates while a simulated SD card periodically stalls for a long time the way
+ *  that real cards do while wear-leveling. Another simulated interrupt
+ *  preempts the main loop producers part way through log_checkout() and
+ *  log_checkin(). No checkouts may be dropped and all of the data must make it
+ *  to the card.
+ */
+
+/** Length of the simulated flight in milliseconds */
+#define SIM_DURATION        30000
+/** Latency of a normal SD card write */
+#define SD_BASE_LATENCY     3
+/** Latency of a write that hits a wear-leveling stall */
+#define SD_STALL_LATENCY    180
+/** Every this many writes will stall */
+#define SD_STALL_INTERVAL   16
+
+/** A source of data to be logged */
+struct producer {
+    /** Period between checkouts in milliseconds */
+    uint32_t period;
+    /** Number of bytes in each checkout */
+    uint16_t length;
+    /** Number of milliseconds for which the checkout is held (as if the data
+        where being filled in by DMA) */
+    uint32_t hold;
+    /** Whether this producer runs in the simulated interrupt context */
+    uint8_t in_isr:1;
+
+    uint8_t *held;
+    uint32_t held_until;
+};
+
+static struct producer producers[] = {
+    // KX134 watermark burst, 32 samples at 1600 Hz
+    { .period = 20, .length = 204, .hold = 2, .in_isr = 1 },
+    // MPU9250 FIFO drain at 100 Hz
+    { .period = 10, .length = 28, .hold = 1, .in_isr = 1 },
+    // Altimeter
+    { .period = 100, .length = 20, .hold = 0, .in_isr = 0 },
+    // GNSS
+    { .period = 1000, .length = 36, .hold = 0, .in_isr = 0 },
+    // Status
+    { .period = 500, .length = 24, .hold = 0, .in_isr = 0 },
+};
+
+#define NUM_PRODUCERS (sizeof(producers) / sizeof(producers[0]))
+
+static struct logging_desc_t logging;
+
+/** Length of each checkout made by the preempting interrupt */
+#define PREEMPT_LENGTH      8
+/** Largest number of atomic operations that may be run before the preempting
+    interrupt fires */
+#define PREEMPT_MAX_DELAY   6
+
+/** Whether the preempting interrupt is waiting to fire */
+static uint8_t preempt_armed;
+/** Whether the preempting interrupt is running */
+static uint8_t preempt_running;
+/** Number of atomic operations left before the preempting interrupt fires */
+static uint8_t preempt_countdown;
+/** Block checked out by the last run of the preempting interrupt */
+static uint8_t *preempt_block;
+/** Number of times that the preempting interrupt has fired */
+static uint32_t preempt_count;
+
+static uint32_t next_seq;
+static uint32_t write_count;
+static uint32_t write_done_time;
+static uint8_t max_buffers_per_write;
+
+static void atomic_op_hook(void)
+{
+    if (!preempt_armed || preempt_running) {
+        return;
+    }
+
+    if (preempt_countdown != 0) {
+        preempt_countdown--;
+        return;
+    }
+
+    // Fire the interrupt, it checks out and fills a block all in one go
+    preempt_armed = 0;
+    preempt_running = 1;
+    preempt_block = checkout_block(&logging, PREEMPT_LENGTH, next_seq++);
+    ut_assert(preempt_block != NULL);
+    ut_assert(log_checkin(&logging, preempt_block) == 0);
+    preempt_count++;
+    preempt_running = 0;
+}
+
+/**
+ *  Arm the preempting interrupt to fire after a number of atomic operations.
+ */
+static void arm_preempt(uint8_t delay)
+{
+    preempt_countdown = delay;
+    preempt_armed = 1;
+}
+
+static void run_producers(uint8_t in_isr)
+{
+    for (unsigned i = 0; i < NUM_PRODUCERS; i++) {
+        struct producer *const p = &producers[i];
+
+        if (p->in_isr != in_isr) {
+            continue;
+        }
+
+        if ((p->held != NULL) && ((int32_t)(millis - p->held_until) >= 0)) {
+            ut_assert(log_checkin(&logging, p->held) == 0);
+            p->held = NULL;
+        }
+
+        if ((millis % p->period) != 0) {
+            continue;
+        }
+
+        if (!in_isr) {
+            arm_preempt(rand() % PREEMPT_MAX_DELAY);
+        }
+        uint8_t *const buffer = checkout_block(&logging, p->length,
+                                               next_seq++);
+        ut_assert(buffer != NULL);
+
+        if (p->hold == 0) {
+            ut_assert(log_checkin(&logging, buffer) == 0);
+        } else {
+            p->held = buffer;
+            p->held_until = millis + p->hold;
+        }
+        preempt_armed = 0;
+    }
+}
+
+static void run_sd_card(void)
+{
+    static uint8_t write_started;
+
+    if (!sd_write_op.pending) {
+        write_started = 0;
+        return;
+    }
+
+    if (!write_started) {
+        // A new write has been started
+        write_started = 1;
+        write_count++;
+        if (logging.buffers_in_progress > max_buffers_per_write) {
+            max_buffers_per_write = logging.buffers_in_progress;
+        }
+        uint32_t const latency = ((write_count % SD_STALL_INTERVAL) == 0) ?
+                                        SD_STALL_LATENCY : SD_BASE_LATENCY;
+        write_done_time = millis + latency + sd_write_op.num_blocks;
+    } else if ((int32_t)(millis - write_done_time) >= 0) {
+        sd_complete_write();
+        write_started = 0;
+    }
+}
+
+/**
+ *  Walk the data blocks in the simulated flight and check that every sequence
+ *  number from zero up appears exactly once. A producer which is preempted
+ *  part way through a checkout may end up with space after the interrupt that
+ *  preempted it, so the blocks are not necessarily in order.
+ *
+ *  @return The number of data blocks found
+ */
+static uint32_t check_flight_unordered(struct logging_desc_t *inst)
+{
+    static uint8_t seen[8192];
+    uint32_t const num_blocks = inst->sb.flights[inst->flight].num_blocks;
+    uint8_t const *const start = sd_card[inst->sb.flights[inst->flight].first_block];
+    uint8_t const *const end = start + (num_blocks * SD_BLOCK_LENGTH);
+    uint32_t count = 0;
+
+    memset(seen, 0, sizeof(seen));
+
+    for (uint8_t const *p = start; p < end;) {
+        uint16_t const length = logging_block_length(p);
+        ut_assert(length >= LOGGING_BLOCK_HEADER_LENGTH);
+        ut_assert((p + length) <= end);
+
+        if (logging_block_class(p) == LOGGING_BLOCK_CLASS_TELEMETRY) {
+            uint32_t seq;
+            memcpy(&seq, p + LOGGING_BLOCK_HEADER_LENGTH, sizeof(seq));
+            ut_assert(seq < sizeof(seen));
+            ut_assert(!seen[seq]);
+            seen[seq] = 1;
+            for (uint16_t i = LOGGING_BLOCK_HEADER_LENGTH + sizeof(seq);
+                 i < length; i++) {
+                ut_assert(p[i] == (uint8_t)seq);
+            }
+            count++;
+        } else {
+            ut_assert(logging_block_class(p) == LOGGING_BLOCK_CLASS_METADATA);
+            ut_assert(logging_block_type(p) == LOGGING_METADATA_TYPE_SPACER);
+        }
+        p += length;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        ut_assert(seen[i]);
+    }
+
+    return count;
+}
+
+/**
+ *  Check out a block from the main loop with the preempting interrupt firing
+ *  at each atomic operation in turn until the checkout and checkin are
+ *  complete before it fires.
+ *
+ *  @param prefill Number of bytes already used in the current buffer
+ *  @param length Length of the block checked out from the main loop
+ *
+ *  @return The number of points at which the checkout was preempted
+ */
+static uint8_t preempt_each_point(uint16_t prefill, uint16_t length)
+{
+    for (uint8_t delay = 0;; delay++) {
+        init_active_logging(&logging);
+        logging.prod_cursor = prefill;
+        logging.buffer[0].count = prefill;
+        if (prefill != 0) {
+            logging_block_marshal_header(logging.data[0],
+                                         LOGGING_BLOCK_CLASS_METADATA,
+                                         LOGGING_METADATA_TYPE_SPACER, prefill);
+        }
+        next_seq = 0;
+        preempt_block = NULL;
+
+        arm_preempt(delay);
+        uint8_t *const block = checkout_block(&logging, length, next_seq++);
+        ut_assert(block != NULL);
+        ut_assert(log_checkin(&logging, block) == 0);
+
+        if (preempt_armed) {
+            // Both checkouts finished before the interrupt fired
+            preempt_armed = 0;
+            return delay;
+        }
+
+        // The two blocks must not overlap and both must be counted
+        ut_assert(preempt_block != NULL);
+        ut_assert(((preempt_block + PREEMPT_LENGTH) <= block) ||
+                  ((block + length) <= preempt_block));
+
+        uint32_t total = 0;
+        for (int i = 0; i < LOGGING_NUM_BUFFERS; i++) {
+            ut_assert(logging.buffer[i].checkout_count == 0);
+            total += logging.buffer[i].count;
+        }
+        ut_assert(total == (uint32_t)(prefill + length + PREEMPT_LENGTH));
+
+        // Both blocks must make it to the card
+        uint32_t const end = millis + LOGGING_BUFFER_WRITE_INTERVAL + 1;
+        for (; millis != end; millis++) {
+            logging_service(&logging);
+            if (sd_write_op.pending) {
+                sd_complete_write();
+            }
+        }
+        ut_assert(LOGGING_CURSOR_SEQ(logging.prod_cursor) ==
+                  logging.cons_cursor);
+        ut_assert(check_flight_unordered(&logging) == 2);
+    }
+}
+
+/**
+ *  Run a simulated flight.
+ *
+ *  @param vectored Whether the simulated SD card driver supports vectored
+ *                  writes
+ */
+static void run_flight(uint8_t vectored)
+{
+    millis = 1;
+    next_seq = 0;
+    write_count = 0;
+    max_buffers_per_write = 0;
+    for (unsigned i = 0; i < NUM_PRODUCERS; i++) {
+        producers[i].held = NULL;
+    }
+
+    init_active_logging(&logging);
+    if (vectored) {
+        enable_vectored_writes(&logging);
+    }
+    // Keep the superblock out of the way for the whole flight
+    logging.last_sb_write = millis + SIM_DURATION;
+
+    uint32_t bytes_logged = 0;
+    for (unsigned i = 0; i < NUM_PRODUCERS; i++) {
+        bytes_logged += (SIM_DURATION / producers[i].period) *
+                            producers[i].length;
+    }
+    // Make sure that this test actually exercises the ring, more than half of
+    // the ring should fill up during a stall (a pair of buffers that made up
+    // the same amount of memory would not be able to keep up)
+    ut_assert(((bytes_logged / (SIM_DURATION / 1000)) * SD_STALL_LATENCY /
+               1000) > ((LOGGING_NUM_BUFFERS * LOGGING_BUFFER_SIZE) / 2));
+
+    for (; millis < SIM_DURATION; millis++) {
+        // Interrupt fires while main loop is between service calls
+        run_producers(1);
+        // Main loop
+        run_producers(0);
+        logging_service(&logging);
+        // SD card completion interrupt
+        run_sd_card();
+        logging_service(&logging);
+    }
+
+    // Release any held checkouts and drain the ring
+    for (unsigned i = 0; i < NUM_PRODUCERS; i++) {
+        if (producers[i].held != NULL) {
+            log_checkin(&logging, producers[i].held);
+        }
+    }
+    for (uint32_t end = millis + LOGGING_BUFFER_WRITE_INTERVAL + 1000;
+         millis < end; millis++) {
+        run_sd_card();
+        logging_service(&logging);
+    }
+
+    ut_assert(logging.out_of_space_count == 0);
+    ut_assert(!logging.sd_write_in_progress);
+    ut_assert(LOGGING_CURSOR_SEQ(logging.prod_cursor) == logging.cons_cursor);
+    ut_assert(check_flight_unordered(&logging) == next_seq);
+    // Consecutive buffers should have been combined into a single write while
+    // catching up after a stall
+    ut_assert(max_buffers_per_write > 1);
+}
+
+int main (int argc, char **argv)
+{
+    // Preempt a checkout that fits in the current buffer and one that has to
+    // move on to the next buffer, the interrupt's checkout fits exactly in the
+    // space that is left
+    millis = 1;
+    cas_fail_count = 0;
+    ut_assert(preempt_each_point(0, 16) >= 4);
+    ut_assert(preempt_each_point(LOGGING_BUFFER_SIZE - PREEMPT_LENGTH,
+                                 16) >= 4);
+    // At least one of the interrupts must have beaten the main loop to the
+    // producer cursor
+    ut_assert(cas_fail_count != 0);
+
+    srand(1);
+    preempt_count = 0;
+    run_flight(0);
+    run_flight(1);
+    ut_assert(preempt_count > 100);
+
+    return UT_PASS;
+}
@@ -0,0 +1,233 @@
+#include <unittest.h>
+
+#include <string.h>
+
+/*
+ *  Stubs for symbols used by the logging service and a simulated SD card.
+ *
+ *  This file is ment to be included into other tests after the source file
+ *  for the logging service.
+ */
+
+volatile uint32_t millis;
+
+#define TEST_PART_START     100
+#define TEST_PART_BLOCKS    4096
+
+/** Contents of simulated logging partition */
+static uint8_t sd_card[TEST_PART_BLOCKS][SD_BLOCK_LENGTH];
+
+/** Most recently started write operation */
+static struct {
+    uint32_t addr;
+    uint32_t num_blocks;
+    uint8_t const *data;
+    struct sd_segment const *segments;
+    uint8_t num_segments;
+    sd_op_cb_t cb;
+    void *context;
+    uint8_t pending:1;
+} sd_write_op;
+
+static int sd_write_call_count;
+static int sd_write_retval;
+
+/** Most recently started erase operation */
+static struct {
+    uint32_t addr;
+    uint32_t num_blocks;
+    sd_op_cb_t cb;
+    void *context;
+    uint8_t pending:1;
+} sd_erase_op;
+
+static int sd_read_stub(sd_desc_ptr_t inst, uint32_t addr, uint32_t num_blocks,
+                        uint8_t *buffer, sd_op_cb_t cb, void *context)
+{
+    return 1;
+}
+
+/**
+ *  Record the start of a write operation on the simulated card.
+ */
+static void start_write_op(uint32_t addr, uint32_t num_blocks,
+                           uint8_t const *data,
+                           struct sd_segment const *segments,
+                           uint8_t num_segments, sd_op_cb_t cb, void *context)
+{
+    ut_assert(!sd_write_op.pending);
+    ut_assert(addr >= TEST_PART_START);
+    ut_assert((addr - TEST_PART_START + num_blocks) <= TEST_PART_BLOCKS);
+
+    sd_write_op.addr = addr;
+    sd_write_op.num_blocks = num_blocks;
+    sd_write_op.data = data;
+    sd_write_op.segments = segments;
+    sd_write_op.num_segments = num_segments;
+    sd_write_op.cb = cb;
+    sd_write_op.context = context;
+    sd_write_op.pending = 1;
+}
+
+static int sd_write_stub(sd_desc_ptr_t inst, uint32_t addr,
+                         uint32_t num_blocks, uint8_t const *data,
+                         sd_op_cb_t cb, void *context)
+{
+    sd_write_call_count++;
+    if (sd_write_retval != 0) {
+        return sd_write_retval;
+    }
+
+    start_write_op(addr, num_blocks, data, NULL, 0, cb, context);
+    return 0;
+}
+
+static int sd_write_v_stub(sd_desc_ptr_t inst, uint32_t addr,
+                           struct sd_segment const *segments,
+                           uint8_t num_segments, sd_op_cb_t cb, void *context)
+{
+    sd_write_call_count++;
+    if (sd_write_retval != 0) {
+        return sd_write_retval;
+    }
+
+    ut_assert(num_segments != 0);
+    ut_assert(num_segments <= SD_MAX_SEGMENTS);
+
+    uint32_t num_blocks = 0;
+    for (uint8_t i = 0; i < num_segments; i++) {
+        ut_assert(segments[i].num_blocks != 0);
+        num_blocks += segments[i].num_blocks;
+    }
+
+    start_write_op(addr, num_blocks, NULL, segments, num_segments, cb, context);
+    return 0;
+}
+
+static int sd_erase_stub(sd_desc_ptr_t inst, uint32_t addr,
+                         uint32_t num_blocks, sd_op_cb_t cb, void *context)
+{
+    ut_assert(!sd_erase_op.pending);
+    ut_assert(!sd_write_op.pending);
+
+    sd_erase_op.addr = addr;
+    sd_erase_op.num_blocks = num_blocks;
+    sd_erase_op.cb = cb;
+    sd_erase_op.context = context;
+    sd_erase_op.pending = 1;
+    return 0;
+}
+
+/**
+ *  Complete the pending SD card write operation, copying the data onto the
+ *  simulated card.
+ */
+static void sd_complete_write(void)
+{
+    ut_assert(sd_write_op.pending);
+    sd_write_op.pending = 0;
+    if (sd_write_op.num_segments == 0) {
+        memcpy(sd_card[sd_write_op.addr - TEST_PART_START], sd_write_op.data,
+               sd_write_op.num_blocks * SD_BLOCK_LENGTH);
+    } else {
+        uint32_t block = sd_write_op.addr - TEST_PART_START;
+        for (uint8_t i = 0; i < sd_write_op.num_segments; i++) {
+            memcpy(sd_card[block], sd_write_op.segments[i].data,
+                   sd_write_op.segments[i].num_blocks * SD_BLOCK_LENGTH);
+            block += sd_write_op.segments[i].num_blocks;
+        }
+    }
+    sd_write_op.cb(sd_write_op.context, SD_OP_SUCCESS, sd_write_op.num_blocks);
+}
+
+/**
+ *  Initialize a logging service instance directly into the active state with
+ *  a fresh flight in the simulated partition.
+ */
+static void init_active_logging(struct logging_desc_t *inst)
+{
+    memset(inst, 0, sizeof(*inst));
+    memset(&sd_write_op, 0, sizeof(sd_write_op));
+    memset(&sd_erase_op, 0, sizeof(sd_erase_op));
+    memset(sd_card, 0, sizeof(sd_card));
+    sd_write_call_count = 0;
+    sd_write_retval = 0;
+
+    struct sd_funcs const funcs = {
+        .read = sd_read_stub,
+        .write = sd_write_stub
+    };
+    inst->sd_funcs = funcs;
+    inst->state = LOGGING_ACTIVE;
+    inst->part_start = TEST_PART_START;
+    inst->part_blocks = TEST_PART_BLOCKS;
+    inst->flight = 0;
+    inst->sb.flights[0].first_block = 1;
+    inst->last_data_write = millis;
+    inst->last_sb_write = millis;
+}
+
+/**
+ *  Give the simulated SD card driver for a logging service instance support
+ *  for vectored writes.
+ */
+static void enable_vectored_writes(struct logging_desc_t *inst)
+{
+    inst->sd_funcs.write_v = sd_write_v_stub;
+}
+
+/**
+ *  Check out space for a data block with the given length and fill it with a
+ *  header and a sequence number.
+ */
+static uint8_t *checkout_block(struct logging_desc_t *inst, uint16_t length,
+                               uint32_t seq)
+{
+    uint8_t *buffer;
+    if (log_checkout(inst, &buffer, length) != 0) {
+        return NULL;
+    }
+    logging_block_marshal_header(buffer, LOGGING_BLOCK_CLASS_TELEMETRY, 1,
+                                 length);
+    memcpy(buffer + LOGGING_BLOCK_HEADER_LENGTH, &seq, sizeof(seq));
+    memset(buffer + LOGGING_BLOCK_HEADER_LENGTH + sizeof(seq), (uint8_t)seq,
+           length - LOGGING_BLOCK_HEADER_LENGTH - sizeof(seq));
+    return buffer;
+}
+
+/**
+ *  Walk the data blocks in the simulated flight and check that they are
+ *  numbered consecutively from zero.
+ *
+ *  @return The number of data blocks found
+ */
+static uint32_t check_flight(struct logging_desc_t *inst)
+{
+    uint32_t const num_blocks = inst->sb.flights[inst->flight].num_blocks;
+    uint8_t const *const start = sd_card[inst->sb.flights[inst->flight].first_block];
+    uint8_t const *const end = start + (num_blocks * SD_BLOCK_LENGTH);
+    uint32_t next_seq = 0;
+
+    for (uint8_t const *p = start; p < end;) {
+        uint16_t const length = logging_block_length(p);
+        ut_assert(length >= LOGGING_BLOCK_HEADER_LENGTH);
+        ut_assert((p + length) <= end);
+
+        if (logging_block_class(p) == LOGGING_BLOCK_CLASS_TELEMETRY) {
+            uint32_t seq;
+            memcpy(&seq, p + LOGGING_BLOCK_HEADER_LENGTH, sizeof(seq));
+            ut_assert(seq == next_seq);
+            for (uint16_t i = LOGGING_BLOCK_HEADER_LENGTH + sizeof(seq);
+                 i < length; i++) {
+                ut_assert(p[i] == (uint8_t)seq);
+            }
+            next_seq++;
+        } else {
+            ut_assert(logging_block_class(p) == LOGGING_BLOCK_CLASS_METADATA);
+            ut_assert(logging_block_type(p) == LOGGING_METADATA_TYPE_SPACER);
+        }
+        p += length;
+    }
+
+    return next_seq;
+}
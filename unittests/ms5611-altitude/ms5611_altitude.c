@@ -0,0 +1,89 @@
+#include <unittest.h>
+#include SOURCE_C
+
+#include <math.h>
+
+/*
+ *  ms5611_altitude() calculates altitude with the hypsometric formula using
+ *  only integer arithmetic. The result is compared against the same formula
+ *  evaluated in double precision over the range of altitudes that the
+ *  altimeter is expected to see in flight.
+ */
+
+/** Largest allowed difference from the reference in millimeters */
+#define MAX_ERROR_MM    100
+
+/**
+ *  Reference altitude calculation, the same formula the driver used to
+ *  evaluate with powf.
+ */
+static double reference_altitude(int32_t pressure, int32_t p0,
+                                 int32_t temperature)
+{
+    double const t = (temperature + 27315) / 100.0;
+    return ((pow((double)p0 / (double)pressure, 0.1902225604) - 1.0) * t) /
+            0.0065;
+}
+
+/**
+ *  Pressure in Pascals at a given altitude in the standard atmosphere.
+ */
+static int32_t isa_pressure(double altitude, double p0)
+{
+    return (int32_t)lround(p0 * pow(1.0 - (0.0065 * altitude) / 288.15,
+                                    5.2558797));
+}
+
+
+int main (int argc, char **argv)
+{
+    // Altitude at the reference pressure is zero
+    ut_assert(ms5611_altitude(101325, 101325, 1500) == 0);
+    ut_assert(ms5611_altitude(84000, 84000, -2000) == 0);
+
+    // Invalid pressures
+    ut_assert(ms5611_altitude(0, 101325, 1500) == 0);
+    ut_assert(ms5611_altitude(101325, 0, 1500) == 0);
+    ut_assert(ms5611_altitude(-5, 101325, 1500) == 0);
+
+    // Lower pressure is higher altitude
+    ut_assert(ms5611_altitude(100000, 101325, 1500) > 0);
+    ut_assert(ms5611_altitude(102000, 101325, 1500) < 0);
+
+    // Accuracy sweep from -500 m to 12 km for a range of reference pressures
+    // and temperatures
+    static const int32_t ground_pressures[] = { 101325, 95000, 84000 };
+    static const int32_t temperatures[] = { -4000, -500, 1500, 4500 };
+
+    int32_t max_error = 0;
+    for (unsigned int i = 0; i < (sizeof(ground_pressures) /
+                                  sizeof(ground_pressures[0])); i++) {
+        int32_t const p0 = ground_pressures[i];
+        for (unsigned int j = 0; j < (sizeof(temperatures) /
+                                      sizeof(temperatures[0])); j++) {
+            int32_t const t = temperatures[j];
+            for (int32_t alt = -500; alt <= 12000; alt += 1) {
+                int32_t const p = isa_pressure(alt, p0);
+                double const ref = reference_altitude(p, p0, t) * 1000.0;
+                double const diff = fabs(ms5611_altitude(p, p0, t) - ref);
+                int32_t const err = (int32_t)diff;
+                if (err > max_error) {
+                    max_error = err;
+                }
+            }
+        }
+    }
+    printf("max error: %d mm\n", (int)max_error);
+    ut_assert(max_error <= MAX_ERROR_MM);
+
+    // Every pressure the sensor can report, stepping one Pascal at a time,
+    // gives a non-increasing altitude as pressure increases
+    int32_t last = INT32_MAX;
+    for (int32_t p = 1000; p <= 120000; p++) {
+        int32_t const alt = ms5611_altitude(p, 101325, 1500);
+        ut_assert(alt <= last);
+        last = alt;
+    }
+
+    return UT_PASS;
+}
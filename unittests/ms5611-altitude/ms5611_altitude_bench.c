@@ -0,0 +1,70 @@
+#include <unittest.h>
+#include SOURCE_C
+
+#include <math.h>
+#include <time.h>
+
+/*
+ *  Host benchmark comparing ms5611_altitude() with the single precision powf
+ *  based calculation that it replaced. Host timings are only a rough guide to
+ *  the relative cost on a Cortex-M0+, where powf is done in software and is
+ *  much more expensive compared to the integer arithmetic than it is here.
+ */
+
+/** Number of times the whole pressure range is swept for each method */
+#define BENCH_ROUNDS    20
+/** Lowest pressure in the benchmark range (about 12 km) */
+#define BENCH_P_MIN     19000
+/** Highest pressure in the benchmark range (about -500 m) */
+#define BENCH_P_MAX     107500
+
+static volatile int32_t sink_fixed;
+static volatile float sink_float;
+
+static float float_altitude(int32_t pressure, float p0, int32_t temperature)
+{
+    float t = ((float)(temperature + 27315)) / 100;
+    float p = ((float)pressure) / 100;
+    return (((powf((p0 / p), 0.1902225604f) - 1.0f) * t) / 0.0065f);
+}
+
+static double elapsed_ns(struct timespec const *start,
+                         struct timespec const *end)
+{
+    return (((double)(end->tv_sec - start->tv_sec) * 1e9) +
+            (double)(end->tv_nsec - start->tv_nsec));
+}
+
+
+int main (int argc, char **argv)
+{
+    uint32_t const calls = (uint32_t)BENCH_ROUNDS *
+                                        (BENCH_P_MAX - BENCH_P_MIN + 1);
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int32_t p = BENCH_P_MIN; p <= BENCH_P_MAX; p++) {
+            sink_fixed = ms5611_altitude(p, 101325, 1500);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double const fixed_ns = elapsed_ns(&start, &end) / calls;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int32_t p = BENCH_P_MIN; p <= BENCH_P_MAX; p++) {
+            sink_float = float_altitude(p, 1013.25f, 1500);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double const float_ns = elapsed_ns(&start, &end) / calls;
+
+    printf("fixed point: %.1f ns/call, powf: %.1f ns/call\n", fixed_ns,
+           float_ns);
+
+    // Both methods should agree on the last value
+    ut_assert(fabsf((sink_fixed / 1000.0f) - sink_float) < 0.5f);
+
+    return UT_PASS;
+}
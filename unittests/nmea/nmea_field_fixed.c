@@ -0,0 +1,48 @@
+#include <unittest.h>
+#include SOURCE_C
+
+#include <string.h>
+
+/*
+ *  nmea_field_fixed() converts the value accumulated for a numeric field to a
+ *  fixed point number with a given number of decimal places.
+ */
+
+static void make_field(struct nmea_field_t *field, uint32_t value,
+                       uint8_t decimals, uint8_t negative)
+{
+    memset(field, 0, sizeof(*field));
+    field->value = value;
+    field->decimals = decimals;
+    field->negative = negative;
+}
+
+
+int main (int argc, char **argv)
+{
+    struct nmea_field_t field;
+
+    // Extra decimal places are added
+    make_field(&field, 12345, 1, 0);
+    ut_assert(nmea_field_fixed(&field, 3) == 1234500);
+
+    // Decimal places are truncated
+    make_field(&field, 4807038, 3, 0);
+    ut_assert(nmea_field_fixed(&field, 1) == 48070);
+    ut_assert(nmea_field_int(&field) == 4807);
+
+    // Sign is applied
+    make_field(&field, 1520, 2, 1);
+    ut_assert(nmea_field_fixed(&field, 2) == -1520);
+    ut_assert(nmea_field_fixed(&field, 3) == -15200);
+
+    // Empty fields are zero
+    make_field(&field, 0, 0, 0);
+    ut_assert(nmea_field_fixed(&field, 4) == 0);
+
+    // Largest longitude fits
+    make_field(&field, 1795999999, 5, 0);
+    ut_assert(nmea_field_fixed(&field, 5) == 1795999999);
+
+    return UT_PASS;
+}
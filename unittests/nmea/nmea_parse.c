@@ -0,0 +1,177 @@
+#include <unittest.h>
+#include SOURCE_C
+
+#include <string.h>
+
+/*
+ *  nmea_parse() parses a stream of bytes, passing each field of known
+ *  sentences to a callback and committing them once the checksum has been
+ *  verified.
+ */
+
+#define MAX_FIELDS  24
+
+struct test_context {
+    struct nmea_field_t fields[MAX_FIELDS];
+    uint32_t field_id;
+    uint32_t commit_id;
+    uint8_t num_fields;
+    uint8_t num_commits;
+};
+
+static void test_field(void *context, uint32_t id, uint8_t index,
+                       const struct nmea_field_t *field)
+{
+    struct test_context *const ctx = (struct test_context*)context;
+    if (index == 1) {
+        // Start of a new sentence
+        ctx->num_fields = 0;
+    }
+    ut_assert(index == (ctx->num_fields + 1));
+    ut_assert(index <= MAX_FIELDS);
+    ctx->fields[index - 1] = *field;
+    ctx->field_id = id;
+    ctx->num_fields++;
+}
+
+static void test_commit(void *context, uint32_t id)
+{
+    struct test_context *const ctx = (struct test_context*)context;
+    ctx->commit_id = id;
+    ctx->num_commits++;
+}
+
+static const struct nmea_sentence_t sentences[] = {
+    {.id = NMEA_ID('G','N','R','M','C'), .field = test_field,
+        .commit = test_commit},
+    {.id = NMEA_ID('P','G','A','C','K'), .field = test_field,
+        .commit = test_commit}
+};
+
+static struct nmea_parser_t parser;
+static struct test_context ctx;
+
+static void reset(void)
+{
+    memset(&ctx, 0, sizeof(ctx));
+    init_nmea_parser(&parser, sentences, 2, &ctx);
+}
+
+static void parse_str(const char *str)
+{
+    nmea_parse(&parser, (const uint8_t*)str, (uint16_t)strlen(str));
+}
+
+static const char *rmc = "$GNRMC,064951.000,A,2307.1256,N,12016.4438,E,0.03,"
+                         "165.48,260406,3.05,W,A*32\r\n";
+
+
+int main (int argc, char **argv)
+{
+    // A whole sentence is parsed into fields and committed
+    {
+        reset();
+        parse_str(rmc);
+
+        ut_assert(parser.valid_sentences == 1);
+        ut_assert(parser.checksum_errors == 0);
+        ut_assert(ctx.num_commits == 1);
+        ut_assert(ctx.commit_id == NMEA_ID('G','N','R','M','C'));
+        ut_assert(ctx.field_id == NMEA_ID('G','N','R','M','C'));
+        ut_assert(ctx.num_fields == 12);
+
+        ut_assert(nmea_field_int(&ctx.fields[0]) == 64951);
+        ut_assert(ctx.fields[1].text[0] == 'A');
+        ut_assert(nmea_field_fixed(&ctx.fields[2], 4) == 23071256);
+        ut_assert(!strcmp(ctx.fields[3].text, "N"));
+        ut_assert(nmea_field_fixed(&ctx.fields[4], 4) == 120164438);
+        ut_assert(nmea_field_fixed(&ctx.fields[6], 2) == 3);
+        ut_assert(nmea_field_fixed(&ctx.fields[7], 2) == 16548);
+        ut_assert(nmea_field_int(&ctx.fields[8]) == 260406);
+        ut_assert(!strcmp(ctx.fields[11].text, "A"));
+    }
+
+    // Bytes can arrive one at a time
+    {
+        reset();
+        for (const char *c = rmc; *c != '\0'; c++) {
+            nmea_parse(&parser, (const uint8_t*)c, 1);
+        }
+        ut_assert(ctx.num_commits == 1);
+        ut_assert(nmea_field_fixed(&ctx.fields[4], 4) == 120164438);
+    }
+
+    // A corrupted sentence is not committed
+    {
+        reset();
+        char bad[128];
+        strcpy(bad, rmc);
+        bad[20] = '8';
+        parse_str(bad);
+        ut_assert(ctx.num_commits == 0);
+        ut_assert(parser.checksum_errors == 1);
+
+        parse_str("$PGACK,SW_ANT_External*11\r\n");
+        ut_assert(ctx.num_commits == 0);
+        ut_assert(parser.checksum_errors == 2);
+
+        // Lower case checksums are accepted
+        parse_str("$PGACK,SW_ANT_Internal*0a\r\n");
+        ut_assert(ctx.num_commits == 1);
+        ut_assert(parser.checksum_errors == 2);
+    }
+
+    // Sentences without checksums and sentences which are cut off are
+    // rejected, the parser recovers at the next sentence
+    {
+        reset();
+        parse_str("$GNRMC,064951.000,A\r\n");
+        parse_str("$GNRMC,064951.000,A,2307.12");
+        parse_str(rmc);
+        ut_assert(parser.checksum_errors == 2);
+        ut_assert(ctx.num_commits == 1);
+    }
+
+    // Unknown sentences are checked but not passed to callbacks
+    {
+        reset();
+        parse_str("$PMTK001,220,3*30\r\n");
+        parse_str("$GPGSA,A,3,,,,,,,,,,,,,1.0,1.0,1.0*00\r\n");
+        ut_assert(ctx.num_fields == 0);
+        ut_assert(ctx.num_commits == 0);
+        ut_assert(parser.valid_sentences == 1);
+        ut_assert(parser.checksum_errors == 1);
+    }
+
+    // A sentence which is discarded part way through is not committed, the
+    // parser recovers at the next sentence
+    {
+        reset();
+        char first[32];
+        strncpy(first, rmc, 20);
+        first[20] = '\0';
+        parse_str(first);
+        nmea_discard_sentence(&parser);
+        parse_str(rmc + 20);
+        ut_assert(ctx.num_commits == 0);
+        ut_assert(parser.checksum_errors == 1);
+
+        nmea_discard_sentence(&parser);
+        ut_assert(parser.checksum_errors == 1);
+        parse_str(rmc);
+        ut_assert(ctx.num_commits == 1);
+    }
+
+    // Long text fields are truncated, negative numbers are parsed
+    {
+        reset();
+        parse_str("$PGACK,SW_ANT_Internal_Antenna,-12.5*13\r\n");
+        ut_assert(parser.valid_sentences == 1);
+        ut_assert(ctx.num_commits == 1);
+        ut_assert(ctx.fields[0].length == 23);
+        ut_assert(!strcmp(ctx.fields[0].text, "SW_ANT_Internal"));
+        ut_assert(nmea_field_fixed(&ctx.fields[1], 1) == -125);
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,66 @@
+#include <string.h>
+#include "profiler_stubs.c"
+
+/*
+ *  profiler_hist_record() adds a value to a histogram, keeping track of the
+ *  minimum, maximum and mean and counting the value in a power of two bucket.
+ */
+
+int main (int argc, char **argv)
+{
+    struct profiler_hist_t hist;
+    memset(&hist, 0xff, sizeof(hist));
+    profiler_hist_clear(&hist);
+
+    ut_assert(hist.count == 0);
+    ut_assert(profiler_hist_mean(&hist) == 0);
+    for (int i = 0; i < PROFILER_HIST_BUCKETS; i++) {
+        ut_assert(hist.buckets[i] == 0);
+    }
+
+    // Summary statistics
+    profiler_hist_record(&hist, 5);
+    ut_assert(hist.min == 5);
+    ut_assert(hist.max == 5);
+    profiler_hist_record(&hist, 3);
+    profiler_hist_record(&hist, 10);
+    ut_assert(hist.count == 3);
+    ut_assert(hist.min == 3);
+    ut_assert(hist.max == 10);
+    ut_assert(hist.total == 18);
+    ut_assert(profiler_hist_mean(&hist) == 6);
+
+    // Buckets, 0 goes in the first bucket and each following bucket covers
+    // the next power of two
+    profiler_hist_clear(&hist);
+    profiler_hist_record(&hist, 0);
+    profiler_hist_record(&hist, 1);
+    profiler_hist_record(&hist, 2);
+    profiler_hist_record(&hist, 3);
+    profiler_hist_record(&hist, 4);
+    ut_assert(hist.buckets[0] == 1);
+    ut_assert(hist.buckets[1] == 1);
+    ut_assert(hist.buckets[2] == 2);
+    ut_assert(hist.buckets[3] == 1);
+
+    // Large values all go in the last bucket
+    profiler_hist_record(&hist, 1UL << (PROFILER_HIST_BUCKETS - 1));
+    profiler_hist_record(&hist, UINT32_MAX);
+    ut_assert(hist.buckets[PROFILER_HIST_BUCKETS - 1] == 2);
+    ut_assert(hist.max == UINT32_MAX);
+
+    // Bucket counts saturate
+    profiler_hist_clear(&hist);
+    for (uint32_t i = 0; i < (UINT16_MAX + 10UL); i++) {
+        profiler_hist_record(&hist, 1);
+    }
+    ut_assert(hist.buckets[1] == UINT16_MAX);
+    ut_assert(hist.count == (UINT16_MAX + 10UL));
+
+    // Conversion to nanoseconds, one profiler tick is a microsecond on SAMD2x
+    ut_assert(profiler_ticks_to_ns(3) == 3000);
+    ut_assert(profiler_ticks_to_ns(UINT32_MAX) == UINT32_MAX);
+    ut_assert(profiler_cycles_to_ns(48) == 1000);
+
+    return UT_PASS;
+}
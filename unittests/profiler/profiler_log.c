@@ -0,0 +1,75 @@
+#include <string.h>
+#include "profiler_stubs.c"
+
+/*
+ *  profiler_log() writes a diagnostic block with an entry for interrupt
+ *  latency, interrupts disabled time, the main loop and each scheduler task,
+ *  leaving out tasks that do not fit in a logging buffer.
+ */
+
+#define NUM_TASKS   40
+
+int main (int argc, char **argv)
+{
+    static struct sched_task_t tasks[NUM_TASKS];
+
+    profiler_clear();
+    profiler_hist_record(&profiler_isr_latency_g, 12);
+    profiler_hist_record(&stub_stats.pass_time, 100);
+
+    tasks[0].name = "a-long-task-name";
+    profiler_hist_record(&tasks[0].run_time, 7);
+    tasks[1].name = "b";
+    stub_tasks = &tasks[0];
+    tasks[0].next = &tasks[1];
+
+    // Two tasks
+    millis = 1234;
+    ut_assert(profiler_log(NULL) == 0);
+    ut_assert(log_checked_in == 1);
+    ut_assert(logging_block_class(log_buffer) == LOGGING_BLOCK_CLASS_DIAG);
+    ut_assert(logging_block_type(log_buffer) == LOGGING_DIAG_TYPE_PROFILE);
+    ut_assert(logging_block_length(log_buffer) == log_length);
+    ut_assert(log_length == (LOGGING_BLOCK_HEADER_LENGTH +
+                             sizeof(struct logging_diag_profile_head) +
+                             (5 * sizeof(struct logging_diag_profile_entry))));
+
+    struct logging_diag_profile_head *head =
+            (struct logging_diag_profile_head *)(log_buffer +
+                                                 LOGGING_BLOCK_HEADER_LENGTH);
+    ut_assert(head->time == 1234);
+    ut_assert(head->tick_freq == PROFILER_TICK_FREQ);
+    ut_assert(head->cycle_freq == F_CPU);
+    ut_assert(head->num_entries == 5);
+
+    struct logging_diag_profile_entry *entry =
+            (struct logging_diag_profile_entry *)(head + 1);
+    ut_assert(!strncmp(entry[0].name, "isr-lat", 8));
+    ut_assert(entry[0].count == 1);
+    ut_assert(entry[0].mean == 12);
+    ut_assert(!strncmp(entry[1].name, "irq-off", 8));
+    ut_assert(entry[1].count == 0);
+    ut_assert(!strncmp(entry[2].name, "loop", 8));
+    ut_assert(entry[2].max == 100);
+    // Names are truncated to fit
+    ut_assert(!memcmp(entry[3].name, "a-long-t", 8));
+    ut_assert(entry[3].min == 7);
+    ut_assert(entry[3].buckets[3] == 1);
+    ut_assert(!strncmp(entry[4].name, "b", 8));
+
+    // More tasks than fit in a buffer
+    for (int i = 1; i < (NUM_TASKS - 1); i++) {
+        tasks[i].name = "t";
+        tasks[i].next = &tasks[i + 1];
+    }
+    tasks[NUM_TASKS - 1].name = "t";
+    ut_assert(profiler_log(NULL) == 0);
+    ut_assert(log_length <= LOGGING_BUFFER_SIZE);
+    ut_assert(head->num_entries < (NUM_TASKS + 3));
+    ut_assert(log_length == (LOGGING_BLOCK_HEADER_LENGTH +
+                             sizeof(struct logging_diag_profile_head) +
+                             (head->num_entries *
+                              sizeof(struct logging_diag_profile_entry))));
+
+    return UT_PASS;
+}
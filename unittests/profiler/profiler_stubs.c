@@ -0,0 +1,59 @@
+#include <unittest.h>
+
+static inline void stub_disable_irq(void) { }
+static inline void stub_enable_irq(void) { }
+
+#define __disable_irq stub_disable_irq
+#define __enable_irq stub_enable_irq
+#include SOURCE_C
+#undef __disable_irq
+#undef __enable_irq
+
+/*
+ *  Stubs for symbols used by the profiler.
+ *
+ *  This file is ment to be included into other tests. Logging buffers are
+ *  checked out of a single static buffer so that the logged profile can be
+ *  inspected.
+ */
+
+volatile uint32_t millis;
+
+uint32_t timebase_micros(void)
+{
+    return 0;
+}
+
+static struct sched_task_t *stub_tasks;
+static struct sched_stats_t stub_stats;
+
+struct sched_task_t *sched_get_tasks(void)
+{
+    return stub_tasks;
+}
+
+const struct sched_stats_t *sched_get_stats(void)
+{
+    return &stub_stats;
+}
+
+static uint8_t log_buffer[LOGGING_BUFFER_SIZE] __attribute__((aligned(4)));
+static uint16_t log_length;
+static int log_checked_in;
+
+int log_checkout(struct logging_desc_t *inst, uint8_t **data, uint16_t length)
+{
+    if (length > sizeof(log_buffer)) {
+        return 1;
+    }
+    log_length = length;
+    *data = log_buffer;
+    return 0;
+}
+
+int log_checkin(struct logging_desc_t *inst, uint8_t *data)
+{
+    ut_assert(data == log_buffer);
+    log_checked_in++;
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include "radio_antmgr_stubs.c"
+
+int main (int argc, char **argv)
+{
+    init_test_radio(ANTMGR_ANT_1_MASK | ANTMGR_ANT_2_MASK | ANTMGR_ANT_3_MASK |
+                    ANTMGR_ANT_4_MASK);
+    ut_assert(test_antmgr.best_antenna == 1);
+    ut_assert(radio_antmgr_get_current_antenna(&test_radio) == 1);
+
+    // The first sample sets the average
+    millis = 100;
+    radio_antmgr_metadata_cb(NULL, &test_radio, 1, 5, -90);
+    ut_assert(test_antmgr.avg_rssi[0] == -90);
+    ut_assert(test_antmgr.rx_packets[0] == 1);
+    ut_assert(test_antmgr.last_rx_time[0] == 100);
+    ut_assert(test_antmgr.last_any_rx_time == 100);
+
+    // Later samples move the average toward them
+    radio_antmgr_metadata_cb(NULL, &test_radio, 1, 5, -96);
+    ut_assert(test_antmgr.avg_rssi[0] == -93);
+    radio_antmgr_metadata_cb(NULL, &test_radio, 1, 5, -96);
+    ut_assert(test_antmgr.avg_rssi[0] == -94);
+    ut_assert(test_antmgr.rx_packets[0] == 3);
+
+    // Antenna 4 is the last entry and does not disturb the others
+    millis = 200;
+    radio_antmgr_metadata_cb(NULL, &test_radio, 4, 5, -70);
+    ut_assert(test_antmgr.avg_rssi[3] == -70);
+    ut_assert(test_antmgr.rx_packets[3] == 1);
+    ut_assert(test_antmgr.last_rx_time[3] == 200);
+    ut_assert(test_antmgr.avg_rssi[0] == -94);
+    ut_assert(get_count(test_antmgr.rssi_counts, 1) == 3);
+    ut_assert(get_count(test_antmgr.rssi_counts, 4) == 1);
+
+    // Invalid antenna numbers are ignored
+    radio_antmgr_metadata_cb(NULL, &test_radio, 0, 5, -50);
+    radio_antmgr_metadata_cb(NULL, &test_radio, 5, 5, -50);
+    ut_assert(test_antmgr.rx_packets[0] == 3);
+    ut_assert(test_antmgr.rx_packets[3] == 1);
+
+    // Loss estimates are stored for the antenna they were measured on
+    radio_antmgr_rx_loss_cb(NULL, &test_radio, 4, 110);
+    radio_antmgr_tx_loss_cb(NULL, &test_radio, 4, 112, 3);
+    ut_assert(test_antmgr.avg_rx_power_loss[3] == 110);
+    ut_assert(test_antmgr.avg_tx_power_loss[3] == 112);
+    ut_assert(get_count(test_antmgr.rx_power_loss_counts, 4) == 1);
+    ut_assert(get_count(test_antmgr.tx_power_loss_counts, 4) == 1);
+    ut_assert(test_antmgr.avg_rx_power_loss[0] == 0);
+
+    return UT_PASS;
+}
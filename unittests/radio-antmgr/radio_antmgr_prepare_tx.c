@@ -0,0 +1,39 @@
+#include "radio_antmgr_stubs.c"
+
+int main (int argc, char **argv)
+{
+    init_test_radio(ANTMGR_ANT_1_MASK | ANTMGR_ANT_2_MASK);
+    millis = 0;
+    ut_assert(radio_antmgr_get_tx_antenna(&test_radio) == 1);
+
+    // Transmitting on the best antenna does not touch the switch
+    radio_antmgr_prepare_tx(&test_radio);
+    ut_assert(num_sets == 0);
+    ut_assert(radio_antmgr_get_tx_antenna(&test_radio) == 1);
+
+    // A probe in progress is ended so that the transmission uses the best
+    // antenna
+    millis = ANTMGR_PROBE_PERIOD;
+    receive_packet(-90);
+    radio_antmgr_service(&test_radio);
+    ut_assert(test_antmgr.probing);
+    ut_assert(radio_antmgr_get_current_antenna(&test_radio) == 2);
+    radio_antmgr_prepare_tx(&test_radio);
+    ut_assert(!test_antmgr.probing);
+    ut_assert(radio_antmgr_get_current_antenna(&test_radio) == 1);
+    ut_assert(radio_antmgr_get_tx_antenna(&test_radio) == 1);
+    ut_assert(num_sets == 2);
+
+    // Transmissions follow the best antenna
+    test_antmgr.best_antenna = 2;
+    radio_antmgr_prepare_tx(&test_radio);
+    ut_assert(radio_antmgr_get_current_antenna(&test_radio) == 2);
+    ut_assert(radio_antmgr_get_tx_antenna(&test_radio) == 2);
+
+    // Radios without an antenna manager have no TX antenna
+    struct radio_instance_desc plain_radio;
+    memset(&plain_radio, 0, sizeof(plain_radio));
+    ut_assert(radio_antmgr_get_tx_antenna(&plain_radio) == 0);
+
+    return UT_PASS;
+}
@@ -0,0 +1,148 @@
+#include "radio_antmgr_stubs.c"
+
+/**
+ *  Receive packets on the best antenna and then probe the next antenna,
+ *  receiving a packet with the given RSSI on it if rssi is not zero.
+ */
+static void probe_cycle(int8_t best_rssi, int8_t probe_rssi)
+{
+    millis += ANTMGR_PROBE_PERIOD;
+    receive_packet(best_rssi);
+    radio_antmgr_service(&test_radio);
+    ut_assert(test_antmgr.probing);
+
+    if (probe_rssi != 0) {
+        millis += 100;
+        receive_packet(probe_rssi);
+        millis += 100;
+        receive_packet(probe_rssi);
+        radio_antmgr_service(&test_radio);
+    } else {
+        millis += ANTMGR_PROBE_TIMEOUT;
+        radio_antmgr_service(&test_radio);
+    }
+    ut_assert(!test_antmgr.probing);
+    ut_assert(radio_antmgr_get_current_antenna(&test_radio) ==
+                    test_antmgr.best_antenna);
+}
+
+static void test_probe_timing(void)
+{
+    init_test_radio(ANTMGR_ANT_1_MASK | ANTMGR_ANT_3_MASK);
+    millis = 0;
+
+    // Nothing happens before the probe period
+    receive_packet(-90);
+    radio_antmgr_service(&test_radio);
+    ut_assert(!test_antmgr.probing);
+    ut_assert(num_sets == 0);
+
+    // No probe outside of the window after a packet was received
+    millis = ANTMGR_PROBE_PERIOD + ANTMGR_IDLE_WINDOW + 1;
+    radio_antmgr_service(&test_radio);
+    ut_assert(!test_antmgr.probing);
+
+    // No probe while a transmission is waiting to be sent
+    static const uint8_t packet[4];
+    receive_packet(-90);
+    test_radio.rn2483.send_buffer = packet;
+    radio_antmgr_service(&test_radio);
+    ut_assert(!test_antmgr.probing);
+    test_radio.rn2483.send_buffer = NULL;
+
+    // Probe right after a packet has been received, skipping the disabled
+    // antenna
+    radio_antmgr_service(&test_radio);
+    ut_assert(test_antmgr.probing);
+    ut_assert(test_antmgr.probe_antenna == 3);
+    ut_assert(radio_antmgr_get_current_antenna(&test_radio) == 3);
+    ut_assert(test_antmgr.num_probes == 1);
+
+    // The probe ends after timing out without packets and the best antenna is
+    // selected again
+    millis += ANTMGR_PROBE_TIMEOUT - 1;
+    radio_antmgr_service(&test_radio);
+    ut_assert(test_antmgr.probing);
+    millis += 1;
+    radio_antmgr_service(&test_radio);
+    ut_assert(!test_antmgr.probing);
+    ut_assert(radio_antmgr_get_current_antenna(&test_radio) == 1);
+    ut_assert(test_antmgr.best_antenna == 1);
+
+    // Probe after a long silence
+    millis += ANTMGR_SILENCE_TIMEOUT;
+    radio_antmgr_service(&test_radio);
+    ut_assert(test_antmgr.probing);
+    ut_assert(test_antmgr.probe_antenna == 3);
+
+    // With a single antenna there is nothing to probe
+    init_test_radio(ANTMGR_ANT_2_MASK);
+    millis += ANTMGR_PROBE_PERIOD;
+    receive_packet(-90);
+    radio_antmgr_service(&test_radio);
+    ut_assert(!test_antmgr.probing);
+    ut_assert(num_sets == 0);
+}
+
+static void test_switching(void)
+{
+    init_test_radio(ANTMGR_ANT_1_MASK | ANTMGR_ANT_2_MASK | ANTMGR_ANT_3_MASK |
+                    ANTMGR_ANT_4_MASK);
+    millis = 0;
+    receive_packet(-90);
+
+    // Antennas are probed in turn, a slightly better antenna does not cause a
+    // switch
+    probe_cycle(-90, -88);
+    ut_assert(test_antmgr.probe_antenna == 2);
+    probe_cycle(-90, -100);
+    ut_assert(test_antmgr.probe_antenna == 3);
+    probe_cycle(-90, 0);
+    ut_assert(test_antmgr.probe_antenna == 4);
+    probe_cycle(-90, -89);
+    ut_assert(test_antmgr.probe_antenna == 2);
+    ut_assert(test_antmgr.best_antenna == 1);
+    ut_assert(test_antmgr.num_switches == 0);
+
+    // A much better antenna is only switched to once it has a full average
+    probe_cycle(-90, -100);
+    probe_cycle(-90, -80);
+    ut_assert(test_antmgr.probe_antenna == 4);
+    ut_assert(test_antmgr.best_antenna == 1);
+    probe_cycle(-90, -89);
+    probe_cycle(-90, -100);
+    probe_cycle(-90, -80);
+    ut_assert(test_antmgr.probe_antenna == 4);
+    ut_assert(test_antmgr.best_antenna == 4);
+    ut_assert(test_antmgr.num_switches == 1);
+    ut_assert(radio_antmgr_get_current_antenna(&test_radio) == 4);
+
+    // The old best antenna is now probed like the others
+    probe_cycle(-80, 0);
+    ut_assert(test_antmgr.probe_antenna == 1);
+
+    // An antenna that has stopped receiving is replaced by any antenna that
+    // has received recently
+    init_test_radio(ANTMGR_ANT_1_MASK | ANTMGR_ANT_2_MASK);
+    millis += ANTMGR_STALE_TIME;
+    receive_packet(-60);
+    millis += ANTMGR_STALE_TIME;
+    radio_antmgr_service(&test_radio);
+    ut_assert(test_antmgr.probing);
+    ut_assert(test_antmgr.probe_antenna == 2);
+    for (int i = 0; i < AVG_RSSI_FACTOR; i++) {
+        millis += 100;
+        receive_packet(-110);
+    }
+    radio_antmgr_service(&test_radio);
+    ut_assert(!test_antmgr.probing);
+    ut_assert(test_antmgr.best_antenna == 2);
+    ut_assert(radio_antmgr_get_current_antenna(&test_radio) == 2);
+}
+
+int main (int argc, char **argv)
+{
+    test_probe_timing();
+    test_switching();
+    return UT_PASS;
+}
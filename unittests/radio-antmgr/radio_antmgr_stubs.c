@@ -0,0 +1,60 @@
+#include <unittest.h>
+
+#include <string.h>
+
+/*
+ *  Stubs for symbols used by the radio antenna manager and a radio with all
+ *  four antennas enabled.
+ *
+ *  This file is ment to be included into other tests.
+ */
+
+#include SOURCE_C
+
+volatile uint32_t millis;
+
+static struct radio_instance_desc test_radio;
+static struct radio_antmgr_desc test_antmgr;
+
+/** Number of times the antenna switch has been set */
+static int num_sets;
+
+void init_sky13414(struct sky13414_desc_t *inst, struct rn2483_desc_t *radio,
+                   enum rn2483_pin v1, enum rn2483_pin v2, enum rn2483_pin v3)
+{
+    inst->radio = radio;
+    inst->state = SKY13414_SHUTDOWN;
+}
+
+void sky13414_set(struct sky13414_desc_t *inst, enum sky13414_state state)
+{
+    inst->state = state;
+    num_sets++;
+}
+
+/**
+ *  Initialize the test radio's antenna manager with a set of enabled
+ *  antennas.
+ */
+static void init_test_radio(uint8_t antenna_mask)
+{
+    const struct radio_antenna_info info = {
+        .antmgr = &test_antmgr,
+        .antenna_mask = antenna_mask,
+        .fixed_antenna_num = 0
+    };
+
+    memset(&test_radio, 0, sizeof(test_radio));
+    init_radio_antmgr(&test_radio, &info);
+    num_sets = 0;
+}
+
+/**
+ *  Simulate a packet being received on the antenna that is currently selected.
+ */
+static void receive_packet(int8_t rssi)
+{
+    radio_antmgr_metadata_cb(NULL, &test_radio,
+                             radio_antmgr_get_current_antenna(&test_radio), 0,
+                             rssi);
+}
@@ -0,0 +1,92 @@
+#include "radio_chanmgr_stubs.c"
+
+/*
+ *  radio_chanmgr_get_tx_radio() spreads the rocket's transmissions over the
+ *  channels while the ground station always sends on channel 0.
+ */
+
+static struct radio_instance_desc radio_a;
+static struct radio_instance_desc radio_b;
+static struct radio_instance_desc radio_c;
+static struct radio_instance_desc radio_d;
+static struct radio_instance_desc *const one_radio[] = {&radio_a, NULL};
+static struct radio_instance_desc *const four_radios[] = {&radio_a, &radio_b,
+                                                          &radio_c, &radio_d,
+                                                          NULL};
+
+static struct radio_transport_desc transport;
+
+
+int main (int argc, char **argv)
+{
+    uint8_t channel;
+
+    // Radios listen on their own channels with extra radios doubling up
+    millis = 1000;
+    init_test_transport(&transport, four_radios, RADIO_DEVICE_ADDRESS_ROCKET);
+    ut_assert(radio_a.settings.freq == LORA_FREQ);
+    ut_assert(radio_b.settings.freq == (LORA_FREQ + LORA_CHANNEL_SPACING));
+    ut_assert(radio_c.settings.freq == (LORA_FREQ +
+                                        (2 * LORA_CHANNEL_SPACING)));
+    ut_assert(radio_d.channel == 0);
+    ut_assert(radio_d.settings.spreading_factor ==
+              transport.radio_settings.spreading_factor);
+
+    // The rocket sends on the radio for the next channel, preferring the
+    // radio with the lowest TX loss when there is more than one
+    radio_a.avg_tx_power_loss = 90;
+    radio_d.avg_tx_power_loss = 80;
+    ut_assert(radio_chanmgr_get_tx_radio(&transport, &channel) == &radio_d);
+    ut_assert(channel == 0);
+
+    transport.tx_channel = 2;
+    ut_assert(radio_chanmgr_get_tx_radio(&transport, &channel) == &radio_c);
+    ut_assert(channel == 2);
+
+    // Channels with no radio ready are skipped
+    radio_c.tx_busy = 1;
+    ut_assert(radio_chanmgr_get_tx_radio(&transport, &channel) == &radio_d);
+    ut_assert(channel == 0);
+    radio_d.last_tx_time = millis;
+    ut_assert(radio_chanmgr_get_tx_radio(&transport, &channel) == &radio_a);
+    radio_a.tx_busy = 1;
+    ut_assert(radio_chanmgr_get_tx_radio(&transport, &channel) == &radio_b);
+    ut_assert(channel == 1);
+    radio_b.tx_busy = 1;
+    ut_assert(radio_chanmgr_get_tx_radio(&transport, &channel) == NULL);
+
+    // A radio can send again once its backoff time has passed
+    millis += RADIO_TX_BACKOFF_TIME + 1;
+    ut_assert(radio_chanmgr_get_tx_radio(&transport, &channel) == &radio_d);
+    ut_assert(channel == 0);
+
+    // The ground station only sends on channel 0
+    init_test_transport(&transport, four_radios,
+                        RADIO_DEVICE_ADDRESS_GROUND_STATION);
+    transport.tx_channel = 1;
+    ut_assert(radio_chanmgr_get_tx_radio(&transport, &channel) == &radio_a);
+    ut_assert(channel == 0);
+    radio_a.tx_busy = 1;
+    radio_d.tx_busy = 1;
+    ut_assert(radio_chanmgr_get_tx_radio(&transport, &channel) == NULL);
+
+    // A single radio is used for every channel
+    init_test_transport(&transport, one_radio, RADIO_DEVICE_ADDRESS_ROCKET);
+    transport.tx_channel = 2;
+    ut_assert(radio_chanmgr_get_tx_radio(&transport, &channel) == &radio_a);
+    ut_assert(channel == 2);
+
+    // Tuning only updates the radio when the frequency changes
+    num_freq_updates = 0;
+    radio_chanmgr_tune(&radio_a, 2);
+    ut_assert(radio_a.settings.freq == (LORA_FREQ +
+                                        (2 * LORA_CHANNEL_SPACING)));
+    ut_assert(num_freq_updates == 1);
+    radio_chanmgr_tune(&radio_a, 2);
+    ut_assert(num_freq_updates == 1);
+    radio_chanmgr_tune(&radio_a, radio_a.channel);
+    ut_assert(radio_a.settings.freq == LORA_FREQ);
+    ut_assert(num_freq_updates == 2);
+
+    return UT_PASS;
+}
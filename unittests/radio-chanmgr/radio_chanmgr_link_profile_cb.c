@@ -0,0 +1,241 @@
+#include "radio_chanmgr_stubs.c"
+
+static struct radio_instance_desc ground_radio;
+static struct radio_instance_desc *const ground_radios[] = {&ground_radio,
+                                                            NULL};
+static struct radio_instance_desc rocket_radio;
+static struct radio_instance_desc *const rocket_radios[] = {&rocket_radio,
+                                                            NULL};
+
+static struct radio_transport_desc ground;
+static struct radio_transport_desc rocket;
+
+static void make_link_block(uint8_t *block,
+                            enum radio_packet_device_address dest, uint8_t seq,
+                            uint8_t profile, int ack)
+{
+    radio_block_marshal_header(block, RADIO_BLOCK_LINK_PROFILE_LENGTH, 0, dest,
+                               RADIO_BLOCK_TYPE_CONTROL,
+                               RADIO_CONTROL_BLOCK_LINK_PROFILE);
+    radio_block_marshal_link_profile(block, seq, profile, ack);
+}
+
+static void make_packet(uint8_t *packet, const uint8_t *block,
+                        uint8_t block_length)
+{
+    memset(packet, 0, RADIO_PACKET_HEADER_LENGTH);
+    memcpy(packet + RADIO_PACKET_HEADER_LENGTH, block, block_length);
+    radio_packet_set_length(packet, RADIO_PACKET_HEADER_LENGTH + block_length);
+}
+
+static void check_sent_link_block(int i, struct radio_transport_desc *inst,
+                                  enum radio_packet_device_address dest,
+                                  uint8_t seq, uint8_t profile, int ack)
+{
+    const uint8_t *const block = sent_blocks[i].data;
+    ut_assert(sent_blocks[i].inst == inst);
+    ut_assert(radio_block_type(block) == RADIO_BLOCK_TYPE_CONTROL);
+    ut_assert(radio_block_subtype(block) == RADIO_CONTROL_BLOCK_LINK_PROFILE);
+    ut_assert(radio_block_dest_addr(block) == dest);
+    ut_assert(radio_block_link_profile_seq(block) == seq);
+    ut_assert(radio_block_link_profile_index(block) == profile);
+    ut_assert(!radio_block_link_profile_ack(block) == !ack);
+}
+
+static void test_follower(void)
+{
+    uint8_t block[RADIO_BLOCK_LINK_PROFILE_LENGTH];
+    uint8_t packet[RADIO_MAX_PACKET_SIZE];
+
+    millis = 1000;
+    init_test_transport(&rocket, rocket_radios, RADIO_DEVICE_ADDRESS_ROCKET);
+    rocket.last_rx_time = millis;
+    rocket.last_sig_report_time = millis;
+    ut_assert(rocket.link.profile == LORA_LINK_INITIAL_PROFILE);
+    num_sent = 0;
+    num_updates = 0;
+
+    // A request for a profile that does not exist is ignored
+    make_link_block(block, RADIO_DEVICE_ADDRESS_MULTICAST, 7,
+                    RADIO_LINK_NUM_PROFILES, 0);
+    radio_chanmgr_link_profile_cb(&rocket, block,
+                                  RADIO_DEVICE_ADDRESS_GROUND_STATION);
+    ut_assert(num_sent == 0);
+    ut_assert(!rocket.link.pending);
+
+    // An acknowledgement is ignored by the follower
+    make_link_block(block, RADIO_DEVICE_ADDRESS_ROCKET, 7, 1, 1);
+    radio_chanmgr_link_profile_cb(&rocket, block,
+                                  RADIO_DEVICE_ADDRESS_GROUND_STATION);
+    ut_assert(num_sent == 0);
+    ut_assert(!rocket.link.pending);
+
+    // A request is acknowledged right away
+    make_link_block(block, RADIO_DEVICE_ADDRESS_MULTICAST, 7, 1, 0);
+    radio_chanmgr_link_profile_cb(&rocket, block,
+                                  RADIO_DEVICE_ADDRESS_GROUND_STATION);
+    ut_assert(num_sent == 1);
+    check_sent_link_block(0, &rocket, RADIO_DEVICE_ADDRESS_GROUND_STATION, 7,
+                          1, 1);
+    ut_assert(rocket.link.pending);
+    ut_assert(rocket.link.profile == LORA_LINK_INITIAL_PROFILE);
+
+    // A repeated request is acknowledged again
+    millis += 50;
+    radio_chanmgr_link_profile_cb(&rocket, block,
+                                  RADIO_DEVICE_ADDRESS_GROUND_STATION);
+    ut_assert(num_sent == 2);
+    check_sent_link_block(1, &rocket, RADIO_DEVICE_ADDRESS_GROUND_STATION, 7,
+                          1, 1);
+    ut_assert(rocket.link.pending);
+
+    // The profile is not changed while the acknowledgement is still queued, no
+    // matter how long it takes to go out
+    millis += 5000;
+    rocket.last_rx_time = millis;
+    rocket.last_sig_report_time = millis;
+    radio_chanmgr_service(&rocket);
+    ut_assert(rocket.link.profile == LORA_LINK_INITIAL_PROFILE);
+    ut_assert(num_updates == 0);
+
+    // Or while other packets, like erasure coding parity, are sent ahead of it
+    make_packet(packet, NULL, 0);
+    radio_chanmgr_tx_start_cb(&rocket, &rocket_radio, packet);
+    ut_assert(!rocket_radio.tx_link_ack);
+    radio_chanmgr_tx_done_cb(&rocket, &rocket_radio, 1);
+    ut_assert(rocket.link.profile == LORA_LINK_INITIAL_PROFILE);
+
+    // Or while the packet carrying it is in flight
+    make_packet(packet, sent_blocks[0].data, sent_blocks[0].length);
+    radio_chanmgr_tx_start_cb(&rocket, &rocket_radio, packet);
+    ut_assert(rocket_radio.tx_link_ack);
+    radio_chanmgr_service(&rocket);
+    ut_assert(rocket.link.profile == LORA_LINK_INITIAL_PROFILE);
+
+    // A failed send does not change the profile
+    radio_chanmgr_tx_done_cb(&rocket, &rocket_radio, 0);
+    ut_assert(!rocket_radio.tx_link_ack);
+    ut_assert(rocket.link.profile == LORA_LINK_INITIAL_PROFILE);
+    ut_assert(rocket.link.pending);
+    ut_assert(num_updates == 0);
+
+    // The profile is changed once the acknowledgement has been sent
+    make_packet(packet, sent_blocks[1].data, sent_blocks[1].length);
+    radio_chanmgr_tx_start_cb(&rocket, &rocket_radio, packet);
+    radio_chanmgr_tx_done_cb(&rocket, &rocket_radio, 1);
+    ut_assert(rocket.link.profile == 1);
+    ut_assert(!rocket.link.pending);
+    ut_assert(rocket.link.num_changes == 1);
+    ut_assert(num_updates == 1);
+    ut_assert(rocket.radio_settings.spreading_factor == RN2483_SF_SF8);
+    ut_assert(rocket.radio_settings.coding_rate == RN2483_CR_4_5);
+    ut_assert(rocket.radio_settings.bandwidth == RN2483_BW_500);
+    // The radio's own settings follow but it stays on its channel
+    ut_assert(rocket_radio.settings.spreading_factor == RN2483_SF_SF8);
+    ut_assert(rocket_radio.settings.bandwidth == RN2483_BW_500);
+    ut_assert(rocket_radio.settings.freq == LORA_FREQ);
+    ut_assert(rocket.radio_settings.power == LORA_POWER);
+
+    // A request for the current profile is acknowledged but changes nothing
+    make_link_block(block, RADIO_DEVICE_ADDRESS_MULTICAST, 8, 1, 0);
+    radio_chanmgr_link_profile_cb(&rocket, block,
+                                  RADIO_DEVICE_ADDRESS_GROUND_STATION);
+    ut_assert(num_sent == 3);
+    ut_assert(!rocket.link.pending);
+
+    // Fall back to the most robust profile once the link is lost
+    millis += LORA_LINK_LOSS_TIMEOUT + 1;
+    radio_chanmgr_service(&rocket);
+    ut_assert(rocket.link.profile == RADIO_LINK_FALLBACK_PROFILE);
+    ut_assert(rocket.radio_settings.spreading_factor ==
+                    LORA_SEARCH_SPREADING_FACTOR);
+    ut_assert(rocket.radio_settings.bandwidth == LORA_SEARCH_BANDWIDTH);
+    ut_assert(num_updates == 2);
+}
+
+static void test_leader(void)
+{
+    uint8_t block[RADIO_BLOCK_LINK_PROFILE_LENGTH];
+
+    millis = 1000;
+    init_test_transport(&ground, ground_radios,
+                        RADIO_DEVICE_ADDRESS_GROUND_STATION);
+    ground.last_rx_time = millis;
+    ground.last_sig_report_time = millis;
+    num_sent = 0;
+    num_updates = 0;
+
+    // Nothing happens without a sample from both directions
+    radio_chanmgr_metadata_cb(&ground, &ground_radio, 0, -10, -110);
+    radio_chanmgr_service(&ground);
+    ut_assert(num_sent == 0);
+    ut_assert(!ground.link.pending);
+
+    // A low margin gets a more robust profile requested, 2 dB of margin at
+    // SF9/500 kHz is 5 dB of margin at SF9/250 kHz
+    radio_chanmgr_tx_loss_cb(&ground, &ground_radio, 0, 100, -10);
+    radio_chanmgr_service(&ground);
+    ut_assert(ground.link.pending);
+    ut_assert(ground.link.pending_profile == 3);
+    ut_assert(num_sent == 1);
+    const uint8_t seq = ground.link.seq;
+    check_sent_link_block(0, &ground, RADIO_DEVICE_ADDRESS_MULTICAST, seq, 3,
+                          0);
+
+    // The request is repeated until it is acknowledged
+    millis += LORA_LINK_REQUEST_PERIOD - 1;
+    ground.last_rx_time = millis;
+    radio_chanmgr_service(&ground);
+    ut_assert(num_sent == 1);
+    millis += 1;
+    radio_chanmgr_service(&ground);
+    ut_assert(num_sent == 2);
+    check_sent_link_block(1, &ground, RADIO_DEVICE_ADDRESS_MULTICAST, seq, 3,
+                          0);
+
+    // Requests are ignored by the leader, as are acknowledgements that do not
+    // match the pending request
+    make_link_block(block, RADIO_DEVICE_ADDRESS_MULTICAST, seq, 3, 0);
+    radio_chanmgr_link_profile_cb(&ground, block, RADIO_DEVICE_ADDRESS_ROCKET);
+    make_link_block(block, RADIO_DEVICE_ADDRESS_GROUND_STATION, seq - 1, 3, 1);
+    radio_chanmgr_link_profile_cb(&ground, block, RADIO_DEVICE_ADDRESS_ROCKET);
+    make_link_block(block, RADIO_DEVICE_ADDRESS_GROUND_STATION, seq, 4, 1);
+    radio_chanmgr_link_profile_cb(&ground, block, RADIO_DEVICE_ADDRESS_ROCKET);
+    ut_assert(num_sent == 2);
+    ut_assert(ground.link.pending);
+    ut_assert(ground.link.profile == LORA_LINK_INITIAL_PROFILE);
+
+    // The matching acknowledgement changes the profile
+    make_link_block(block, RADIO_DEVICE_ADDRESS_GROUND_STATION, seq, 3, 1);
+    radio_chanmgr_link_profile_cb(&ground, block, RADIO_DEVICE_ADDRESS_ROCKET);
+    ut_assert(!ground.link.pending);
+    ut_assert(ground.link.profile == 3);
+    ut_assert(ground.radio_settings.bandwidth == RN2483_BW_250);
+    ut_assert(num_updates == 1);
+    // The averages follow the change in bandwidth
+    ut_assert(ground.link.avg_local_snr == -7);
+    ut_assert(ground.link.avg_remote_snr == -7);
+
+    // A request that is never acknowledged is given up on
+    radio_chanmgr_metadata_cb(&ground, &ground_radio, 0, -30, -110);
+    radio_chanmgr_tx_loss_cb(&ground, &ground_radio, 0, 100, -30);
+    ground.last_rx_time = millis;
+    radio_chanmgr_service(&ground);
+    ut_assert(ground.link.pending);
+    ut_assert(ground.link.pending_profile == RADIO_LINK_FALLBACK_PROFILE);
+    for (int i = 0; i < LORA_LINK_REQUEST_TRIES; i++) {
+        millis += LORA_LINK_REQUEST_PERIOD;
+        ground.last_rx_time = millis;
+        radio_chanmgr_service(&ground);
+    }
+    ut_assert(num_sent == 2 + LORA_LINK_REQUEST_TRIES);
+    ut_assert(!ground.link.pending);
+    ut_assert(ground.link.profile == 3);
+}
+
+int main (int argc, char **argv)
+{
+    test_follower();
+    test_leader();
+    return UT_PASS;
+}
@@ -0,0 +1,452 @@
+#include "radio_chanmgr_stubs.c"
+
+#include <math.h>
+
+/*
+ *  Replayable simulation of a flight with link profile control running on both
+ *  ends of the link. The distance between the ground station and the rocket
+ *  follows a trace of a flight and the SNR of each packet comes from a free
+ *  space path loss model with random fading. Packets are only received if both
+ *  ends use the same settings and the SNR is high enough for the spreading
+ *  factor. There is a blackout partway through the descent during which
+ *  nothing is received.
+ *
+ *  Blocks from the channel manager are sent in packets which take their
+ *  airtime to be sent. Each flight is simulated a second time with the rocket
+ *  waiting for a backoff period after each packet and sending an erasure coding
+ *  parity packet after every few packets, so that acknowledgements are queued
+ *  for a while before they go out.
+ *
+ *  The simulation is deterministic for a given seed, a seed can be given as an
+ *  argument to replay a failing run.
+ */
+
+#define SIM_STEP            50
+#define SIM_END             MS_TO_MILLIS(480000)
+#define TELEMETRY_PERIOD    250
+
+/** Time at which the rocket leaves the pad */
+#define LAUNCH_TIME         MS_TO_MILLIS(60000)
+/** Time at which the rocket reaches apogee */
+#define APOGEE_TIME         MS_TO_MILLIS(100000)
+/** Time at which the rocket lands */
+#define LANDING_TIME        MS_TO_MILLIS(400000)
+/** Period during which nothing is received */
+#define BLACKOUT_START      MS_TO_MILLIS(340000)
+#define BLACKOUT_END        MS_TO_MILLIS(365000)
+
+/** Distances in km from the ground station */
+#define PAD_DISTANCE        0.2
+#define APOGEE_DISTANCE     10.0
+#define LANDING_DISTANCE    2.0
+
+/** Transmit power plus antenna gains minus the noise floor at 500 kHz */
+#define LINK_BUDGET         100.0
+/** Largest random change in SNR for each packet */
+#define FADE_DEPTH          2.0
+
+/** Number of packets sent by the rocket between parity packets when sending
+    is delayed */
+#define PARITY_INTERVAL     2
+/** Time that the rocket waits after each packet when sending is delayed */
+#define TX_BACKOFF          MS_TO_MILLIS(300)
+
+/**
+ *  One end of the simulated link.
+ */
+struct sim_end {
+    struct radio_transport_desc transport;
+    struct radio_instance_desc radio;
+    struct radio_instance_desc *radios[2];
+
+    /** Packet to which blocks from the channel manager are added */
+    uint8_t next_packet[RADIO_MAX_PACKET_SIZE];
+    /** Packet being sent */
+    uint8_t tx_packet[RADIO_MAX_PACKET_SIZE];
+    /** Time at which the packet being sent has been sent */
+    uint32_t tx_end_time;
+    /** Earliest time at which the next packet can be sent */
+    uint32_t tx_next_time;
+    /** Number of packets sent since the last parity packet */
+    uint8_t packets_since_parity;
+    /** Set while a packet is being sent */
+    uint8_t tx_busy;
+};
+
+static struct sim_end ground;
+static struct sim_end rocket;
+
+static uint32_t rng_state;
+
+static uint32_t rng(void)
+{
+    // xorshift32
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static double flight_distance(uint32_t time)
+{
+    if (time < LAUNCH_TIME) {
+        return PAD_DISTANCE;
+    } else if (time < APOGEE_TIME) {
+        return (PAD_DISTANCE + ((APOGEE_DISTANCE - PAD_DISTANCE) *
+                                (time - LAUNCH_TIME)) /
+                (APOGEE_TIME - LAUNCH_TIME));
+    } else if (time < LANDING_TIME) {
+        return (APOGEE_DISTANCE - ((APOGEE_DISTANCE - LANDING_DISTANCE) *
+                                   (time - APOGEE_TIME)) /
+                (LANDING_TIME - APOGEE_TIME));
+    }
+    return LANDING_DISTANCE;
+}
+
+/**
+ *  Find the SNR for a packet received with the given settings, including a
+ *  random fade.
+ */
+static double channel_snr(const struct rn2483_lora_settings_t *settings)
+{
+    static const double bw_gain[] = { 6.0, 3.0, 0.0 };
+    const double path_loss = (20.0 * log10(flight_distance(millis))) + 92.45;
+    const double fade = ((((double)(rng() % 2001)) / 1000.0) - 1.0) *
+                        FADE_DEPTH;
+    return LINK_BUDGET - path_loss + bw_gain[settings->bandwidth] + fade;
+}
+
+static int settings_match(void)
+{
+    const struct rn2483_lora_settings_t *const g =
+                                            &ground.transport.radio_settings;
+    const struct rn2483_lora_settings_t *const r =
+                                            &rocket.transport.radio_settings;
+    return ((g->spreading_factor == r->spreading_factor) &&
+            (g->coding_rate == r->coding_rate) &&
+            (g->bandwidth == r->bandwidth));
+}
+
+/**
+ *  Handle a block from the channel manager which has been received.
+ */
+static void sim_handle_block(struct sim_end *from, struct sim_end *to,
+                             const uint8_t *block, long snr_int)
+{
+    struct radio_transport_desc *const rx = &to->transport;
+
+    switch (radio_block_subtype(block)) {
+        case RADIO_CONTROL_BLOCK_SIGNAL_REPORT:
+            if (radio_block_sig_report_req(block)) {
+                uint8_t report[RADIO_BLOCK_SIG_REPORT_LENGHT];
+                radio_block_marshal_header(report,
+                                           RADIO_BLOCK_SIG_REPORT_LENGHT, 0,
+                                           from->transport.address,
+                                           RADIO_BLOCK_TYPE_CONTROL,
+                                           RADIO_CONTROL_BLOCK_SIGNAL_REPORT);
+                radio_block_marshal_sig_report(report, (int8_t)snr_int, -100,
+                                               0, rx->radio_settings.power, 0);
+                radio_send_block(rx, report, RADIO_BLOCK_SIG_REPORT_LENGHT,
+                                 250, 0, RADIO_BLOCK_PRIORITY_HIGH);
+            } else {
+                radio_chanmgr_tx_loss_cb(rx, &to->radio, 0, 0,
+                                         radio_block_sig_report_snr(block));
+            }
+            break;
+        case RADIO_CONTROL_BLOCK_LINK_PROFILE:
+            radio_chanmgr_link_profile_cb(rx, block, from->transport.address);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ *  Try to send a packet between the ends of the link, optionally carrying
+ *  blocks from the channel manager.
+ *
+ *  @return Non-zero if the packet was received
+ */
+static int sim_deliver(struct sim_end *from, struct sim_end *to,
+                       const uint8_t *packet)
+{
+    // Lowest SNR that can be received for each spreading factor
+    static const double snr_floor[] = { -7.5, -10.0, -12.5, -15.0, -17.5,
+                                        -20.0 };
+    struct radio_transport_desc *const rx = &to->transport;
+
+    if (((millis >= BLACKOUT_START) && (millis < BLACKOUT_END)) ||
+            !settings_match()) {
+        return 0;
+    }
+
+    double snr = channel_snr(&rx->radio_settings);
+    if (snr < snr_floor[rx->radio_settings.spreading_factor]) {
+        return 0;
+    }
+
+    // The radio only reports SNRs in this range
+    if (snr > 10.0) {
+        snr = 10.0;
+    } else if (snr < -20.0) {
+        snr = -20.0;
+    }
+    const long snr_int = lround(snr);
+
+    rx->last_rx_time = millis;
+    radio_chanmgr_metadata_cb(rx, &to->radio, 0, (int8_t)snr_int, -100);
+
+    if (packet == NULL) {
+        return 1;
+    }
+
+    const uint8_t packet_length = radio_packet_length(packet);
+    for (uint8_t offset = RADIO_PACKET_HEADER_LENGTH; offset < packet_length;
+            offset += radio_block_length(packet + offset)) {
+        const uint8_t *const block = packet + offset;
+        const enum radio_packet_device_address dest =
+                                                radio_block_dest_addr(block);
+        if ((dest != rx->address) && (dest != RADIO_DEVICE_ADDRESS_MULTICAST)) {
+            continue;
+        }
+        sim_handle_block(from, to, block, snr_int);
+    }
+    return 1;
+}
+
+/**
+ *  Results of a simulated flight.
+ */
+struct sim_result {
+    uint32_t telemetry_sent;
+    uint32_t telemetry_received;
+    /** Time at which both ends first used the fastest profile */
+    uint32_t fastest_time;
+    /** Most robust profile used by both ends within 10 seconds of apogee */
+    uint8_t apogee_profile;
+    /** Profiles at the end of the blackout */
+    uint8_t blackout_ground_profile;
+    uint8_t blackout_rocket_profile;
+    /** Total time that the two ends used different profiles */
+    uint32_t mismatch_time;
+};
+
+static void sim_init_end(struct sim_end *end,
+                         enum radio_packet_device_address address)
+{
+    memset(end, 0, sizeof(*end));
+    end->radios[0] = &end->radio;
+    end->radios[1] = NULL;
+    init_test_transport(&end->transport, end->radios, address);
+    radio_packet_set_length(end->next_packet, RADIO_PACKET_HEADER_LENGTH);
+}
+
+/**
+ *  Add the blocks sent by an end's channel manager to the packet that it will
+ *  send next. Blocks that do not fit are dropped as if the transmit queue were
+ *  full.
+ */
+static void sim_queue_blocks(struct sim_end *end,
+                             const struct sent_block *blocks, int count)
+{
+    for (int i = 0; i < count; i++) {
+        const uint8_t length = radio_packet_length(end->next_packet);
+        if ((blocks[i].inst != &end->transport) ||
+                ((length + blocks[i].length) > RADIO_MAX_PACKET_SIZE)) {
+            continue;
+        }
+        memcpy(end->next_packet + length, blocks[i].data, blocks[i].length);
+        radio_packet_set_length(end->next_packet, length + blocks[i].length);
+    }
+}
+
+/**
+ *  Finish the packet that an end is sending if it has been sent and start
+ *  sending the next one if there is one.
+ *
+ *  @param delayed Whether the end waits after each packet and sends parity
+ *                 packets ahead of queued packets
+ */
+static void sim_transmit(struct sim_end *from, struct sim_end *to, int delayed)
+{
+    if (from->tx_busy) {
+        if ((int32_t)(millis - from->tx_end_time) < 0) {
+            return;
+        }
+        sim_deliver(from, to, from->tx_packet);
+        radio_chanmgr_tx_done_cb(&from->transport, &from->radio, 1);
+        from->tx_busy = 0;
+        from->tx_next_time = millis + (delayed ? TX_BACKOFF : 0);
+    }
+
+    if ((int32_t)(millis - from->tx_next_time) < 0) {
+        return;
+    }
+
+    uint8_t airtime_length;
+    if (delayed && (from->packets_since_parity >= PARITY_INTERVAL)) {
+        // Parity packets do not carry any blocks but are as long as the
+        // longest packet in their group
+        memset(from->tx_packet, 0, RADIO_PACKET_HEADER_LENGTH);
+        radio_packet_set_length(from->tx_packet, RADIO_PACKET_HEADER_LENGTH);
+        airtime_length = RADIO_MAX_PACKET_SIZE;
+        from->packets_since_parity = 0;
+    } else if (radio_packet_length(from->next_packet) >
+               RADIO_PACKET_HEADER_LENGTH) {
+        memcpy(from->tx_packet, from->next_packet, RADIO_MAX_PACKET_SIZE);
+        radio_packet_set_length(from->next_packet, RADIO_PACKET_HEADER_LENGTH);
+        airtime_length = radio_packet_length(from->tx_packet);
+        from->packets_since_parity++;
+    } else {
+        return;
+    }
+
+    radio_chanmgr_tx_start_cb(&from->transport, &from->radio, from->tx_packet);
+    from->tx_busy = 1;
+    from->tx_end_time = millis + (radio_lora_airtime(
+                                            &from->transport.radio_settings,
+                                            airtime_length) / 1000);
+}
+
+static void run_sim(uint32_t seed, int delayed, struct sim_result *result)
+{
+    static struct sent_block blocks[MAX_SENT_BLOCKS];
+
+    rng_state = seed;
+    millis = 0;
+    num_sent = 0;
+    memset(result, 0, sizeof(*result));
+    result->fastest_time = UINT32_MAX;
+
+    sim_init_end(&ground, RADIO_DEVICE_ADDRESS_GROUND_STATION);
+    sim_init_end(&rocket, RADIO_DEVICE_ADDRESS_ROCKET);
+    // The rocket's signal reports are offset from the ground station's
+    rocket.transport.last_sig_report_time = RADIO_SIG_REPORT_PERIOD / 2;
+
+    for (millis = SIM_STEP; millis < SIM_END; millis += SIM_STEP) {
+        radio_chanmgr_service(&ground.transport);
+        radio_chanmgr_service(&rocket.transport);
+
+        if ((millis % TELEMETRY_PERIOD) == 0) {
+            result->telemetry_sent++;
+            result->telemetry_received += sim_deliver(&rocket, &ground, NULL);
+        }
+
+        // Blocks sent during this step go out in the next packet from each
+        // end
+        const int count = num_sent;
+        memcpy(blocks, sent_blocks, sizeof(sent_blocks[0]) * count);
+        num_sent = 0;
+        sim_queue_blocks(&ground, blocks, count);
+        sim_queue_blocks(&rocket, blocks, count);
+        sim_transmit(&ground, &rocket, 0);
+        sim_transmit(&rocket, &ground, delayed);
+
+        const uint8_t ground_profile = ground.transport.link.profile;
+        const uint8_t rocket_profile = rocket.transport.link.profile;
+
+        if (ground_profile != rocket_profile) {
+            result->mismatch_time += SIM_STEP;
+        } else if ((ground_profile == 0) &&
+                   (result->fastest_time == UINT32_MAX)) {
+            result->fastest_time = millis;
+        }
+
+        if (((millis + MS_TO_MILLIS(10000)) >= APOGEE_TIME) &&
+                (millis <= (APOGEE_TIME + MS_TO_MILLIS(10000))) &&
+                (ground_profile == rocket_profile) &&
+                (ground_profile > result->apogee_profile)) {
+            result->apogee_profile = ground_profile;
+        }
+
+        if (millis == (BLACKOUT_END - SIM_STEP)) {
+            result->blackout_ground_profile = ground_profile;
+            result->blackout_rocket_profile = rocket_profile;
+        }
+    }
+}
+
+static void print_result(uint32_t seed, int delayed,
+                         const struct sim_result *result)
+{
+    printf("Seed: 0x%08x%s\n", seed, delayed ? " (delayed)" : "");
+    printf("Telemetry: %u of %u received\n", result->telemetry_received,
+           result->telemetry_sent);
+    printf("Fastest profile at: %u ms\n", result->fastest_time);
+    printf("Apogee profile: %u\n", result->apogee_profile);
+    printf("Blackout profiles: %u, %u\n", result->blackout_ground_profile,
+           result->blackout_rocket_profile);
+    printf("Final profiles: %u, %u\n", ground.transport.link.profile,
+           rocket.transport.link.profile);
+    printf("Profile changes: %u, %u\n", ground.transport.link.num_changes,
+           rocket.transport.link.num_changes);
+    printf("Mismatch time: %u ms\n", result->mismatch_time);
+}
+
+static int check_result(const struct sim_result *result)
+{
+    const uint8_t ground_profile = ground.transport.link.profile;
+    const uint8_t rocket_profile = rocket.transport.link.profile;
+
+    // The fastest profile is used on the pad
+    if (result->fastest_time >= LAUNCH_TIME) {
+        return 0;
+    }
+    // A more robust profile than the default is used near apogee
+    if (result->apogee_profile <= LORA_LINK_INITIAL_PROFILE) {
+        return 0;
+    }
+    // Both ends have fallen back by the end of the blackout
+    if ((result->blackout_ground_profile != RADIO_LINK_FALLBACK_PROFILE) ||
+            (result->blackout_rocket_profile != RADIO_LINK_FALLBACK_PROFILE)) {
+        return 0;
+    }
+    // Both ends have recovered to the same faster profile after landing
+    if ((ground_profile != rocket_profile) ||
+            (ground_profile == RADIO_LINK_FALLBACK_PROFILE)) {
+        return 0;
+    }
+    // The profile does not change too often
+    if ((ground.transport.link.num_changes > 20) ||
+            (rocket.transport.link.num_changes > 20)) {
+        return 0;
+    }
+    // The ends rarely disagree on the profile other than because of the
+    // blackout
+    if (result->mismatch_time > MS_TO_MILLIS(5000)) {
+        return 0;
+    }
+    // Most telemetry outside of the blackout is received
+    const uint32_t blackout_packets = ((BLACKOUT_END - BLACKOUT_START) /
+                                       TELEMETRY_PERIOD);
+    if ((result->telemetry_received * 100) <
+            ((result->telemetry_sent - blackout_packets) * 95)) {
+        return 0;
+    }
+    return 1;
+}
+
+int main (int argc, char **argv)
+{
+    uint32_t seed = 0x4c6f5261;
+    uint32_t num_runs = 20;
+    if (argc > 1) {
+        seed = (uint32_t)strtoul(argv[1], NULL, 0);
+        num_runs = 1;
+    }
+
+    struct sim_result result;
+    for (uint32_t i = 0; i < num_runs; i++) {
+        for (int delayed = 0; delayed < 2; delayed++) {
+            run_sim(seed, delayed, &result);
+            if (!check_result(&result) || (argc > 1)) {
+                print_result(seed, delayed, &result);
+            }
+            ut_assert(check_result(&result));
+        }
+        rng_state = seed;
+        seed = rng();
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,90 @@
+#include <unittest.h>
+
+#include <string.h>
+
+/*
+ *  Stubs for symbols used by the radio channel manager.
+ *
+ *  This file is ment to be included into other tests. Blocks sent by the
+ *  channel manager are kept in a list along with the transport instance that
+ *  sent them.
+ */
+
+#include SOURCE_C
+
+volatile uint32_t millis;
+
+#define MAX_SENT_BLOCKS 32
+
+/**
+ *  A block sent by a transport instance.
+ */
+struct sent_block {
+    struct radio_transport_desc *inst;
+    uint8_t data[RADIO_MAX_BLOCK_SIZE];
+    uint8_t length;
+};
+
+/** Blocks sent since the list was last cleared */
+static struct sent_block sent_blocks[MAX_SENT_BLOCKS];
+static int num_sent;
+/** Number of times that radio settings have been updated */
+static int num_updates;
+/** Number of times that radio frequencies have been updated */
+static int num_freq_updates;
+
+void rn2483_update_settings(struct rn2483_desc_t *inst)
+{
+    num_updates++;
+}
+
+void rn2483_update_frequency_settings(struct rn2483_desc_t *inst)
+{
+    num_freq_updates++;
+}
+
+int radio_send_block(struct radio_transport_desc *inst, const uint8_t *block,
+                     uint8_t block_length, uint16_t slack_time,
+                     uint16_t time_to_live,
+                     enum radio_block_priority priority)
+{
+    ut_assert(num_sent < MAX_SENT_BLOCKS);
+    ut_assert(block_length == radio_block_length(block));
+
+    sent_blocks[num_sent].inst = inst;
+    memcpy(sent_blocks[num_sent].data, block, block_length);
+    sent_blocks[num_sent].length = block_length;
+    num_sent++;
+    return 0;
+}
+
+uint32_t radio_lora_airtime(const struct rn2483_lora_settings_t *settings,
+                            uint8_t length)
+{
+    // Rough airtime in microseconds, only needs to get longer with the
+    // spreading factor and shorter with the bandwidth
+    static const uint32_t bw_khz[] = { 125, 250, 500 };
+    const uint32_t chips = (uint32_t)1 << (settings->spreading_factor + 7);
+    const uint32_t symbol_us = (chips * 1000) / bw_khz[settings->bandwidth];
+    return symbol_us * (20 + ((length * 2) / (settings->spreading_factor + 7)));
+}
+
+/**
+ *  Initialize a transport instance and its radios for the channel manager.
+ *  Radio n listens on channel n.
+ */
+static void init_test_transport(struct radio_transport_desc *inst,
+                                struct radio_instance_desc *const *radios,
+                                enum radio_packet_device_address address)
+{
+    memset(inst, 0, sizeof(*inst));
+    inst->radios = radios;
+    inst->address = address;
+    init_radio_chanmgr(inst);
+
+    for (uint8_t i = 0; radios[i] != NULL; i++) {
+        memset(radios[i], 0, sizeof(*radios[i]));
+        radios[i]->radio_num = i;
+        radio_chanmgr_init_radio(inst, radios[i], i % LORA_NUM_CHANNELS);
+    }
+}
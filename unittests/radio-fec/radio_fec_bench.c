@@ -0,0 +1,164 @@
+#include "radio_fec_stubs.c"
+
+#include <stdio.h>
+#include <time.h>
+
+/*
+ *  Benchmark for erasure coding. Groups of eight packets with 100 byte
+ *  payloads are coded with one, two and four parity packets and decoded with
+ *  as many data packets lost as can be rebuilt. The multiply and add kernel
+ *  is also timed on its own for the exclusive or path used by the first
+ *  parity packet and the table path used by the others.
+ */
+
+#define BENCH_K             8
+#define BENCH_BLOCK_LEN     100
+#define BENCH_GROUPS        2000
+#define BENCH_KERNEL_RUNS   200000
+
+static struct radio_transport_desc rocket;
+static struct radio_fec_desc rocket_fec;
+static struct radio_transport_desc ground;
+static struct radio_fec_desc ground_fec;
+
+static uint8_t packets[BENCH_K][RADIO_MAX_PACKET_SIZE];
+static uint8_t parity[RADIO_FEC_MAX_PARITY_PACKETS][RADIO_MAX_PACKET_SIZE];
+/** Keeps the result of the kernel benchmark from being optimized away */
+static volatile uint8_t kernel_sink;
+
+static double elapsed_seconds(struct timespec const *start,
+                              struct timespec const *end)
+{
+    return ((double)(end->tv_sec - start->tv_sec) +
+            ((double)(end->tv_nsec - start->tv_nsec) / 1e9));
+}
+
+/**
+ *  Sum the payloads of packets for checking that rebuilt packets match.
+ */
+static uint32_t checksum(const uint8_t *packet)
+{
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < radio_packet_length(packet); i++) {
+        sum = (sum * 31) + packet[i];
+    }
+    return sum;
+}
+
+static double bench_encode(uint8_t r)
+{
+    struct timespec start, end;
+
+    init_test_transport(&rocket, &rocket_fec, RADIO_DEVICE_ADDRESS_ROCKET);
+    fec_apply(&rocket, BENCH_K, r);
+    uint16_t number = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t g = 0; g < BENCH_GROUPS; g++) {
+        for (uint8_t i = 0; i < BENCH_K; i++) {
+            radio_packet_set_number(packets[i], number);
+            number = (number + 1) & 0xfff;
+            radio_fec_encode_packet(&rocket, packets[i]);
+        }
+        for (uint8_t j = 0; j < r; j++) {
+            const uint8_t *const p = rocket_next_parity(&rocket, number);
+            number = (number + 1) & 0xfff;
+            memcpy(parity[j], p, radio_packet_length(p));
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return elapsed_seconds(&start, &end);
+}
+
+static double bench_decode(uint8_t r, uint32_t *sent_sum, uint32_t *rebuilt_sum)
+{
+    struct timespec start, end;
+
+    // Parity for the group which starts at packet number 0
+    bench_encode(r);
+    for (uint8_t i = 0; i < BENCH_K; i++) {
+        radio_packet_set_number(packets[i], i);
+    }
+    for (uint8_t j = 0; j < r; j++) {
+        radio_packet_set_number(parity[j], BENCH_K + j);
+        uint8_t *const block = parity[j] + RADIO_PACKET_HEADER_LENGTH;
+        radio_block_marshal_fec_parity(block, 0, BENCH_K, j, r);
+    }
+
+    init_test_transport(&ground, &ground_fec,
+                        RADIO_DEVICE_ADDRESS_GROUND_STATION);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t g = 0; g < BENCH_GROUPS; g++) {
+        // Alternate between two groups so that each one is decoded afresh
+        const uint16_t first = (g & 1) ? 0 : 0x800;
+        for (uint8_t i = r; i < BENCH_K; i++) {
+            radio_packet_set_number(packets[i], first + i);
+            ground_receive(&ground, packets[i]);
+        }
+        num_recovered = 0;
+        for (uint8_t j = 0; j < r; j++) {
+            uint8_t *const block = parity[j] + RADIO_PACKET_HEADER_LENGTH;
+            radio_block_marshal_fec_parity(block, first, BENCH_K, j, r);
+            ground_receive(&ground, parity[j]);
+        }
+        ut_assert(num_recovered == r);
+        for (uint8_t i = 0; i < r; i++) {
+            radio_packet_set_number(packets[i], first + i);
+            *sent_sum += checksum(packets[i]);
+            *rebuilt_sum += checksum(recovered[i]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return elapsed_seconds(&start, &end);
+}
+
+static double bench_kernel(uint8_t coef)
+{
+    struct timespec start, end;
+    uint8_t dst[RADIO_FEC_MAX_SYMBOL_LENGTH] = { 0 };
+    const uint8_t *const src = packets[0];
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t n = 0; n < BENCH_KERNEL_RUNS; n++) {
+        radio_fec_mul_add(dst, src, coef, RADIO_FEC_MAX_SYMBOL_LENGTH);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    kernel_sink = dst[0];
+    return elapsed_seconds(&start, &end);
+}
+
+int main (int argc, char **argv)
+{
+    for (uint8_t i = 0; i < BENCH_K; i++) {
+        make_packet(packets[i], i, BENCH_BLOCK_LEN, 1000 + i);
+    }
+
+    static const uint8_t parity_counts[] = { 1, 2, 4 };
+    for (unsigned int n = 0; n < sizeof(parity_counts); n++) {
+        const uint8_t r = parity_counts[n];
+        uint32_t sent_sum = 0;
+        uint32_t rebuilt_sum = 0;
+
+        const double encode_time = bench_encode(r);
+        const double decode_time = bench_decode(r, &sent_sum, &rebuilt_sum);
+        ut_assert(sent_sum == rebuilt_sum);
+
+        printf("k=%u r=%u encode: %8.1f ns/packet, decode %u lost: "
+               "%8.1f ns/packet\n", BENCH_K, r,
+               (encode_time * 1e9) / (BENCH_GROUPS * BENCH_K), r,
+               (decode_time * 1e9) / (BENCH_GROUPS * BENCH_K));
+    }
+
+    const double xor_time = bench_kernel(1);
+    const double table_time = bench_kernel(0x8e);
+    const double bytes = ((double)BENCH_KERNEL_RUNS *
+                          RADIO_FEC_MAX_SYMBOL_LENGTH);
+    printf("xor kernel:   %8.1f MB/s\n", bytes / xor_time / 1e6);
+    printf("table kernel: %8.1f MB/s\n", bytes / table_time / 1e6);
+
+    return UT_PASS;
+}
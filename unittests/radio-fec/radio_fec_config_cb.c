@@ -0,0 +1,198 @@
+#include "radio_fec_stubs.c"
+
+/*
+ *  radio_fec_config_cb() handles the negotiation of the erasure coding
+ *  configuration. The ground station asks for the configuration that it wants
+ *  until the rocket acknowledges it, and asks again if parity stops arriving.
+ */
+
+static struct radio_transport_desc rocket;
+static struct radio_fec_desc rocket_fec;
+static struct radio_transport_desc ground;
+static struct radio_fec_desc ground_fec;
+
+/**
+ *  Deliver every block which has been sent to the other device and clear the
+ *  list of sent blocks.
+ */
+static void deliver_blocks(void)
+{
+    struct sent_block blocks[MAX_SENT_BLOCKS];
+    const int n = num_sent;
+    memcpy(blocks, sent_blocks, sizeof(blocks));
+    num_sent = 0;
+
+    for (int i = 0; i < n; i++) {
+        ut_assert(radio_block_type(blocks[i].data) ==
+                  RADIO_BLOCK_TYPE_CONTROL);
+        ut_assert(radio_block_subtype(blocks[i].data) ==
+                  RADIO_CONTROL_BLOCK_FEC_CONFIG);
+        ut_assert(blocks[i].length == RADIO_BLOCK_FEC_CONFIG_LENGTH);
+        if (blocks[i].inst == &ground) {
+            radio_fec_config_cb(&rocket, blocks[i].data,
+                                RADIO_DEVICE_ADDRESS_GROUND_STATION);
+        } else {
+            radio_fec_config_cb(&ground, blocks[i].data,
+                                RADIO_DEVICE_ADDRESS_ROCKET);
+        }
+    }
+}
+
+int main (int argc, char **argv)
+{
+    uint8_t packet[RADIO_MAX_PACKET_SIZE];
+
+    millis = 5000;
+    num_sent = 0;
+    init_test_transport(&rocket, &rocket_fec, RADIO_DEVICE_ADDRESS_ROCKET);
+    init_test_transport(&ground, &ground_fec,
+                        RADIO_DEVICE_ADDRESS_GROUND_STATION);
+
+    // Without a request the rocket does not send parity and the ground station
+    // has nothing to ask for with the default configuration
+    ut_assert(rocket_fec.parity_packets == 0);
+    ut_assert(ground_fec.confirmed == !LORA_FEC_PARITY_PACKETS);
+    if (LORA_FEC_PARITY_PACKETS == 0) {
+        radio_fec_service(&ground);
+        ut_assert(num_sent == 0);
+    }
+
+    // Only the ground station can ask for a configuration and it must be valid
+    ut_assert(radio_fec_request(&rocket, 4, 2));
+    ut_assert(radio_fec_request(&ground, 0, 2));
+    ut_assert(radio_fec_request(&ground, RADIO_FEC_MAX_DATA_PACKETS + 1, 2));
+    ut_assert(radio_fec_request(&ground, 4,
+                                RADIO_FEC_MAX_PARITY_PACKETS + 1));
+
+    // A request is sent right away, acknowledged and applied by the rocket
+    {
+        ut_assert(!radio_fec_request(&ground, 4, 2));
+        radio_fec_service(&ground);
+        ut_assert(num_sent == 1);
+        ut_assert(!radio_block_fec_config_ack(sent_blocks[0].data));
+        ut_assert(radio_block_dest_addr(sent_blocks[0].data) ==
+                  RADIO_DEVICE_ADDRESS_MULTICAST);
+        deliver_blocks();
+
+        ut_assert(num_sent == 1);
+        ut_assert(sent_blocks[0].inst == &rocket);
+        ut_assert(radio_block_fec_config_ack(sent_blocks[0].data));
+        ut_assert(radio_block_dest_addr(sent_blocks[0].data) ==
+                  RADIO_DEVICE_ADDRESS_GROUND_STATION);
+        ut_assert(rocket_fec.data_packets == 4);
+        ut_assert(rocket_fec.parity_packets == 2);
+        ut_assert(rocket.max_packet_length == RADIO_FEC_MAX_PACKET_LENGTH);
+
+        ut_assert(ground_fec.pending);
+        deliver_blocks();
+        ut_assert(!ground_fec.pending);
+        ut_assert(ground_fec.confirmed);
+
+        millis += LORA_FEC_REQUEST_PERIOD;
+        radio_fec_service(&ground);
+        ut_assert(num_sent == 0);
+    }
+
+    // A repeated request is acknowledged again but does not restart the group
+    // being coded
+    {
+        make_packet(packet, 0, 8, 1);
+        radio_fec_encode_packet(&rocket, packet);
+        ut_assert(rocket_fec.encoder.count == 1);
+
+        uint8_t block[RADIO_BLOCK_FEC_CONFIG_LENGTH];
+        radio_block_marshal_header(block, RADIO_BLOCK_FEC_CONFIG_LENGTH, 0,
+                                   RADIO_DEVICE_ADDRESS_MULTICAST,
+                                   RADIO_BLOCK_TYPE_CONTROL,
+                                   RADIO_CONTROL_BLOCK_FEC_CONFIG);
+        radio_block_marshal_fec_config(block, ground_fec.seq, 4, 2, 0);
+        radio_fec_config_cb(&rocket, block,
+                            RADIO_DEVICE_ADDRESS_GROUND_STATION);
+        ut_assert(num_sent == 1);
+        ut_assert(radio_block_fec_config_ack(sent_blocks[0].data));
+        ut_assert(rocket_fec.encoder.count == 1);
+        num_sent = 0;
+
+        // Invalid requests are ignored
+        radio_block_marshal_fec_config(block, ground_fec.seq + 1, 4,
+                                       RADIO_FEC_MAX_PARITY_PACKETS + 1, 0);
+        radio_fec_config_cb(&rocket, block,
+                            RADIO_DEVICE_ADDRESS_GROUND_STATION);
+        ut_assert(num_sent == 0);
+        ut_assert(rocket_fec.parity_packets == 2);
+    }
+
+    // A lost request is repeated a limited number of times, then tried again
+    // after the retry period
+    {
+        ut_assert(!radio_fec_request(&ground, 8, 1));
+        for (int i = 0; i < LORA_FEC_REQUEST_TRIES; i++) {
+            radio_fec_service(&ground);
+            ut_assert(num_sent == (i + 1));
+            radio_fec_service(&ground);
+            ut_assert(num_sent == (i + 1));
+            millis += LORA_FEC_REQUEST_PERIOD;
+        }
+        radio_fec_service(&ground);
+        ut_assert(num_sent == LORA_FEC_REQUEST_TRIES);
+        ut_assert(!ground_fec.pending);
+        ut_assert(!ground_fec.confirmed);
+        num_sent = 0;
+
+        millis += LORA_FEC_RETRY_PERIOD - 1;
+        radio_fec_service(&ground);
+        ut_assert(num_sent == 0);
+        millis += 1;
+        radio_fec_service(&ground);
+        ut_assert(num_sent == 1);
+
+        // An acknowledgement for an older request does not count
+        const uint8_t seq = ground_fec.seq;
+        sent_blocks[0].data[RADIO_BLOCK_HEADER_LENGTH] = seq - 1;
+        deliver_blocks();
+        deliver_blocks();
+        ut_assert(ground_fec.pending);
+
+        millis += LORA_FEC_REQUEST_PERIOD;
+        radio_fec_service(&ground);
+        deliver_blocks();
+        deliver_blocks();
+        ut_assert(ground_fec.confirmed);
+        ut_assert(rocket_fec.data_packets == 8);
+        ut_assert(rocket_fec.parity_packets == 1);
+    }
+
+    // If parity stops arriving the rocket is asked again, a reset rocket has
+    // gone back to not sending parity
+    {
+        init_test_transport(&rocket, &rocket_fec, RADIO_DEVICE_ADDRESS_ROCKET);
+        for (uint16_t i = 0; i < (2 * (8 + 1)); i++) {
+            make_packet(packet, i, 8, i);
+            radio_fec_encode_packet(&rocket, packet);
+            ground_receive(&ground, packet);
+            radio_fec_service(&ground);
+            ut_assert(num_sent == 0);
+        }
+        make_packet(packet, 100, 8, 100);
+        ground_receive(&ground, packet);
+        radio_fec_service(&ground);
+        ut_assert(num_sent == 1);
+        deliver_blocks();
+        deliver_blocks();
+        ut_assert(ground_fec.confirmed);
+        ut_assert(rocket_fec.parity_packets == 1);
+    }
+
+    // Erasure coding can be turned off
+    {
+        ut_assert(!radio_fec_request(&ground, 4, 0));
+        radio_fec_service(&ground);
+        deliver_blocks();
+        deliver_blocks();
+        ut_assert(ground_fec.confirmed);
+        ut_assert(rocket_fec.parity_packets == 0);
+        ut_assert(rocket.max_packet_length == RADIO_MAX_PACKET_SIZE);
+    }
+
+    return UT_PASS;
+}
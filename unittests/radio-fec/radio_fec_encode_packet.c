@@ -0,0 +1,189 @@
+#include "radio_fec_stubs.c"
+
+/*
+ *  radio_fec_encode_packet() adds each packet that is sent to the current
+ *  group and radio_fec_make_parity_packet() creates the parity packets for a
+ *  complete group. The parity is checked against a bit at a time GF(2^8)
+ *  multiply.
+ */
+
+static struct radio_transport_desc rocket;
+static struct radio_fec_desc rocket_fec;
+
+/**
+ *  Multiply in GF(2^8) one bit at a time.
+ */
+static uint8_t ref_mul(uint8_t a, uint8_t b)
+{
+    uint8_t p = 0;
+    for (; b != 0; b >>= 1) {
+        if (b & 1) {
+            p ^= a;
+        }
+        a = (uint8_t)((a << 1) ^ ((a & 0x80) ? 0x1d : 0));
+    }
+    return p;
+}
+
+/**
+ *  Find a coefficient from its definition, y / (x + y).
+ */
+static uint8_t ref_coefficient(uint8_t j, uint8_t i)
+{
+    const uint8_t y = RADIO_FEC_MAX_PARITY_PACKETS + i;
+    const uint8_t d = j ^ y;
+    for (unsigned int c = 1; c < 256; c++) {
+        if (ref_mul((uint8_t)c, d) == y) {
+            return (uint8_t)c;
+        }
+    }
+    ut_assert(0);
+    return 0;
+}
+
+int main (int argc, char **argv)
+{
+    uint8_t packets[4][RADIO_MAX_PACKET_SIZE];
+    static const uint8_t lengths[4] = { 16, 40, 8, 24 };
+
+    // The coefficients match their definition and the first row is all ones
+    for (uint8_t j = 0; j < RADIO_FEC_MAX_PARITY_PACKETS; j++) {
+        for (uint8_t i = 0; i < RADIO_FEC_MAX_DATA_PACKETS; i++) {
+            ut_assert(radio_fec_coefficient(j, i) == ref_coefficient(j, i));
+            if (j == 0) {
+                ut_assert(radio_fec_coefficient(j, i) == 1);
+            }
+        }
+    }
+
+    // The table driven multiply matches the reference for every pair
+    for (unsigned int a = 0; a < 256; a++) {
+        uint8_t src[256];
+        uint8_t dst[256];
+        for (unsigned int b = 0; b < 256; b++) {
+            src[b] = (uint8_t)b;
+            dst[b] = 0x5A;
+        }
+        radio_fec_mul_add(dst, src, (uint8_t)a, 128);
+        radio_fec_mul_add(dst + 128, src + 128, (uint8_t)a, 128);
+        for (unsigned int b = 0; b < 256; b++) {
+            ut_assert(dst[b] == (0x5A ^ ref_mul((uint8_t)a, (uint8_t)b)));
+        }
+    }
+
+    // Nothing is coded until the ground station asks for parity
+    {
+        init_test_transport(&rocket, &rocket_fec, RADIO_DEVICE_ADDRESS_ROCKET);
+        ut_assert(rocket_fec.parity_packets == 0);
+        ut_assert(rocket.max_packet_length == RADIO_MAX_PACKET_SIZE);
+        make_packet(packets[0], 0, 16, 1);
+        radio_fec_encode_packet(&rocket, packets[0]);
+        ut_assert(rocket_fec.encoder.count == 0);
+        ut_assert(radio_fec_make_parity_packet(&rocket,
+                                               rocket.fec_packet_buffer) == 0);
+    }
+
+    // Parity for a group of four packets with two parity packets
+    {
+        init_test_transport(&rocket, &rocket_fec, RADIO_DEVICE_ADDRESS_ROCKET);
+        fec_apply(&rocket, 4, 2);
+        ut_assert(rocket.max_packet_length == RADIO_FEC_MAX_PACKET_LENGTH);
+
+        // The group starts at the first packet and wraps the packet number
+        for (int i = 0; i < 4; i++) {
+            make_packet(packets[i], (0xffe + i) & 0xfff, lengths[i], 100 + i);
+            ut_assert(radio_fec_make_parity_packet(&rocket,
+                                            rocket.fec_packet_buffer) == 0);
+            radio_fec_encode_packet(&rocket, packets[i]);
+        }
+        ut_assert(rocket_fec.encoder.count == 4);
+        ut_assert(rocket_fec.encoder.first == 0xffe);
+        // Longest payload is 40 bytes, plus the length byte rounded up
+        ut_assert(rocket_fec.encoder.symbol_length == 44);
+
+        for (uint8_t j = 0; j < 2; j++) {
+            const uint8_t *const parity = rocket_next_parity(&rocket, 2 + j);
+            ut_assert(parity != NULL);
+            ut_assert(radio_packet_length(parity) ==
+                      (RADIO_PACKET_HEADER_LENGTH + RADIO_BLOCK_HEADER_LENGTH +
+                       RADIO_BLOCK_FEC_PARITY_HEADER_LENGTH + 44));
+
+            const uint8_t *const block = parity + RADIO_PACKET_HEADER_LENGTH;
+            ut_assert(radio_block_type(block) == RADIO_BLOCK_TYPE_CONTROL);
+            ut_assert(radio_block_subtype(block) ==
+                      RADIO_CONTROL_BLOCK_FEC_PARITY);
+            ut_assert(radio_block_dest_addr(block) ==
+                      RADIO_DEVICE_ADDRESS_GROUND_STATION);
+            ut_assert(radio_block_fec_parity_first(block) == 0xffe);
+            ut_assert(radio_block_fec_parity_data_packets(block) == 4);
+            ut_assert(radio_block_fec_parity_index(block) == j);
+            ut_assert(radio_block_fec_parity_parity_packets(block) == 2);
+
+            uint8_t expected[RADIO_FEC_MAX_SYMBOL_LENGTH];
+            memset(expected, 0, sizeof(expected));
+            for (uint8_t i = 0; i < 4; i++) {
+                const uint8_t c = ref_coefficient(j, i);
+                expected[0] ^= ref_mul(c, lengths[i]);
+                for (uint8_t b = 0; b < lengths[i]; b++) {
+                    expected[1 + b] ^= ref_mul(c, packets[i][
+                                            RADIO_PACKET_HEADER_LENGTH + b]);
+                }
+            }
+            ut_assert(!memcmp(radio_block_fec_parity_symbol(block), expected,
+                              44));
+        }
+
+        // The group is over once all of its parity has been sent
+        ut_assert(rocket_next_parity(&rocket, 4) == NULL);
+        ut_assert(rocket_fec.num_groups == 1);
+        ut_assert(rocket_fec.encoder.count == 0);
+    }
+
+    // A gap in the packet numbers or a packet which is too long to code starts
+    // a new group
+    {
+        init_test_transport(&rocket, &rocket_fec, RADIO_DEVICE_ADDRESS_ROCKET);
+        fec_apply(&rocket, 4, 1);
+
+        make_packet(packets[0], 10, 16, 1);
+        radio_fec_encode_packet(&rocket, packets[0]);
+        make_packet(packets[0], 11, 16, 2);
+        radio_fec_encode_packet(&rocket, packets[0]);
+        ut_assert(rocket_fec.encoder.count == 2);
+
+        make_packet(packets[0], 13, 16, 3);
+        radio_fec_encode_packet(&rocket, packets[0]);
+        ut_assert(rocket_fec.encoder.count == 1);
+        ut_assert(rocket_fec.encoder.first == 13);
+
+        make_packet(packets[0], 14, 104, 4);
+        radio_fec_encode_packet(&rocket, packets[0]);
+        ut_assert(rocket_fec.encoder.count == 0);
+
+        make_packet(packets[0], 15, 100, 5);
+        radio_fec_encode_packet(&rocket, packets[0]);
+        ut_assert(rocket_fec.encoder.count == 1);
+        ut_assert(rocket_fec.encoder.symbol_length ==
+                  RADIO_FEC_MAX_SYMBOL_LENGTH);
+    }
+
+    // A data packet sent before the parity of the last group starts a new
+    // group and the old parity is not sent
+    {
+        init_test_transport(&rocket, &rocket_fec, RADIO_DEVICE_ADDRESS_ROCKET);
+        fec_apply(&rocket, 2, 2);
+
+        for (int i = 0; i < 2; i++) {
+            make_packet(packets[i], 20 + i, 8, i);
+            radio_fec_encode_packet(&rocket, packets[i]);
+        }
+        ut_assert(rocket_next_parity(&rocket, 22) != NULL);
+        make_packet(packets[2], 23, 8, 2);
+        radio_fec_encode_packet(&rocket, packets[2]);
+        ut_assert(rocket_fec.encoder.count == 1);
+        ut_assert(rocket_fec.encoder.first == 23);
+        ut_assert(rocket_next_parity(&rocket, 24) == NULL);
+    }
+
+    return UT_PASS;
+}
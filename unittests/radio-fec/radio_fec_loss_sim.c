@@ -0,0 +1,157 @@
+#include "radio_fec_stubs.c"
+
+#include <stdio.h>
+
+/*
+ *  Loss simulation for erasure coding. A stream of packets is coded by a
+ *  rocket and passed to a ground station with packets (data and parity alike)
+ *  lost independently at random. The fraction of data packets delivered,
+ *  whether received or rebuilt, is printed for a range of group sizes and loss
+ *  rates and every rebuilt packet is checked against the packet that was sent.
+ */
+
+#define SIM_DATA_PACKETS    4000
+#define SIM_RING            64
+
+static struct radio_transport_desc rocket;
+static struct radio_fec_desc rocket_fec;
+static struct radio_transport_desc ground;
+static struct radio_fec_desc ground_fec;
+
+/** Recently sent data packets by packet number */
+static uint8_t sent[SIM_RING][RADIO_MAX_PACKET_SIZE];
+
+/** Loss rates in percent */
+static const uint8_t loss_rates[] = { 5, 10, 20, 30 };
+#define NUM_LOSS_RATES  (sizeof(loss_rates) / sizeof(loss_rates[0]))
+
+/** Group configurations, data packets and parity packets */
+static const uint8_t configs[][2] = {
+    { 4, 0 }, { 8, 1 }, { 4, 1 }, { 8, 2 }, { 4, 2 }, { 8, 4 }, { 2, 2 }
+};
+#define NUM_CONFIGS     (sizeof(configs) / sizeof(configs[0]))
+
+/**
+ *  Pass a packet to the ground station unless it is lost, checking any
+ *  packets that are rebuilt.
+ *
+ *  @return The number of data packets that were rebuilt or -1 if the packet
+ *          was lost
+ */
+static int transmit(const uint8_t *packet, uint32_t *rng, uint8_t loss)
+{
+    if ((test_rand(rng) % 100) < loss) {
+        return -1;
+    }
+
+    num_recovered = 0;
+    ground_receive(&ground, packet);
+    for (int i = 0; i < num_recovered; i++) {
+        const uint8_t *const original =
+                        sent[radio_packet_number(recovered[i]) % SIM_RING];
+        ut_assert(radio_packet_number(original) ==
+                  radio_packet_number(recovered[i]));
+        ut_assert(!memcmp(recovered[i], original,
+                          radio_packet_length(original)));
+    }
+    return num_recovered;
+}
+
+/**
+ *  Run a simulation.
+ *
+ *  @param k Number of data packets in each group
+ *  @param r Number of parity packets for each group
+ *  @param loss Loss rate in percent
+ *  @param received Number of data packets received directly
+ *
+ *  @return The number of data packets received or rebuilt
+ */
+static uint32_t simulate(uint8_t k, uint8_t r, uint8_t loss,
+                         uint32_t *received)
+{
+    init_test_transport(&rocket, &rocket_fec, RADIO_DEVICE_ADDRESS_ROCKET);
+    init_test_transport(&ground, &ground_fec,
+                        RADIO_DEVICE_ADDRESS_GROUND_STATION);
+    fec_apply(&rocket, k, r);
+
+    uint32_t rng = 0x9E3779B9 ^ ((uint32_t)loss << 16) ^ (k << 8) ^ r;
+    uint32_t content_seed = 1;
+    uint16_t number = 0;
+    uint32_t delivered = 0;
+    *received = 0;
+
+    for (uint32_t n = 0; n < SIM_DATA_PACKETS; n++) {
+        uint8_t *const packet = sent[number % SIM_RING];
+        const uint8_t block_length = 4 * (1 + (test_rand(&content_seed) % 25));
+        make_packet(packet, number, block_length, test_rand(&content_seed));
+        number = (number + 1) & 0xfff;
+        radio_fec_encode_packet(&rocket, packet);
+
+        const int rebuilt = transmit(packet, &rng, loss);
+        if (rebuilt >= 0) {
+            (*received)++;
+            delivered += 1 + rebuilt;
+        }
+
+        const uint8_t *parity;
+        while ((parity = rocket_next_parity(&rocket, number)) != NULL) {
+            number = (number + 1) & 0xfff;
+            const int parity_rebuilt = transmit(parity, &rng, loss);
+            if (parity_rebuilt > 0) {
+                delivered += parity_rebuilt;
+            }
+        }
+    }
+
+    ut_assert(ground_fec.num_recovered == (delivered - *received));
+    return delivered;
+}
+
+int main (int argc, char **argv)
+{
+    uint32_t delivered[NUM_CONFIGS][NUM_LOSS_RATES];
+    uint32_t received[NUM_CONFIGS][NUM_LOSS_RATES];
+
+    printf("data parity overhead |");
+    for (unsigned int l = 0; l < NUM_LOSS_RATES; l++) {
+        printf("  %2u%% loss", loss_rates[l]);
+    }
+    printf("\n");
+
+    for (unsigned int c = 0; c < NUM_CONFIGS; c++) {
+        const uint8_t k = configs[c][0];
+        const uint8_t r = configs[c][1];
+        printf("%4u %6u %7.1f%% |", k, r, (100.0 * r) / k);
+        for (unsigned int l = 0; l < NUM_LOSS_RATES; l++) {
+            delivered[c][l] = simulate(k, r, loss_rates[l], &received[c][l]);
+            printf("  %7.2f%%",
+                   (100.0 * delivered[c][l]) / SIM_DATA_PACKETS);
+        }
+        printf("\n");
+    }
+
+    for (unsigned int c = 0; c < NUM_CONFIGS; c++) {
+        for (unsigned int l = 0; l < NUM_LOSS_RATES; l++) {
+            if (configs[c][1] == 0) {
+                // Without parity nothing can be rebuilt
+                ut_assert(delivered[c][l] == received[c][l]);
+            } else {
+                ut_assert(delivered[c][l] > received[c][l]);
+            }
+        }
+    }
+
+    // 50% overhead keeps delivery above 99% at 10% loss
+    ut_assert((delivered[4][1] * 100) >= (SIM_DATA_PACKETS * 99));
+    // 25% overhead with a single parity packet more than halves the loss at
+    // 10% loss
+    ut_assert(((SIM_DATA_PACKETS - delivered[2][1]) * 2) <
+              (SIM_DATA_PACKETS - received[2][1]));
+    // 50% overhead in larger groups cuts the loss by at least a factor of four
+    // at 20% loss
+    ut_assert(((SIM_DATA_PACKETS - delivered[5][2]) * 4) <
+              (SIM_DATA_PACKETS - received[5][2]));
+
+    return UT_PASS;
+}
@@ -0,0 +1,172 @@
+#include "radio_fec_stubs.c"
+
+/*
+ *  radio_fec_parity_cb() rebuilds lost packets once enough parity has been
+ *  received. Every pattern of lost data and parity packets is tried for every
+ *  group size. A group can be rebuilt whenever at least as many parity packets
+ *  arrive as data packets are lost.
+ */
+
+static struct radio_transport_desc rocket;
+static struct radio_fec_desc rocket_fec;
+static struct radio_transport_desc ground;
+static struct radio_fec_desc ground_fec;
+
+#define MAX_GROUP_PACKETS   (RADIO_FEC_MAX_DATA_PACKETS + \
+                             RADIO_FEC_MAX_PARITY_PACKETS)
+
+static uint8_t packets[MAX_GROUP_PACKETS][RADIO_MAX_PACKET_SIZE];
+
+/**
+ *  Code a group and create its parity packets.
+ *
+ *  @param first Packet number of the first packet in the group
+ *  @param k Number of data packets
+ *  @param r Number of parity packets
+ *  @param seed Seed for packet lengths and contents
+ */
+static void make_group(uint16_t first, uint8_t k, uint8_t r, uint32_t seed)
+{
+    init_test_transport(&rocket, &rocket_fec, RADIO_DEVICE_ADDRESS_ROCKET);
+    fec_apply(&rocket, k, r);
+
+    uint32_t state = seed | 1;
+    for (uint8_t i = 0; i < k; i++) {
+        const uint8_t block_length = 4 * (1 + (test_rand(&state) % 25));
+        make_packet(packets[i], (first + i) & 0xfff, block_length,
+                    test_rand(&state));
+        radio_fec_encode_packet(&rocket, packets[i]);
+    }
+    for (uint8_t j = 0; j < r; j++) {
+        const uint16_t number = (first + k + j) & 0xfff;
+        const uint8_t *const parity = rocket_next_parity(&rocket, number);
+        ut_assert(parity != NULL);
+        memcpy(packets[k + j], parity, radio_packet_length(parity));
+    }
+    ut_assert(rocket_next_parity(&rocket, 0) == NULL);
+}
+
+/**
+ *  Find the original packet that a rebuilt packet should match.
+ */
+static const uint8_t *find_original(const uint8_t *packet, uint8_t k)
+{
+    for (uint8_t i = 0; i < k; i++) {
+        if (radio_packet_number(packets[i]) == radio_packet_number(packet)) {
+            return packets[i];
+        }
+    }
+    return NULL;
+}
+
+int main (int argc, char **argv)
+{
+    // Every combination of lost data and parity packets
+    for (uint8_t k = 1; k <= RADIO_FEC_MAX_DATA_PACKETS; k++) {
+        for (uint8_t r = 1; r <= RADIO_FEC_MAX_PARITY_PACKETS; r++) {
+            const uint16_t first = (k * 509 + r * 31) & 0xfff;
+            make_group(first, k, r, (k << 8) | r);
+
+            for (unsigned int lost = 0; lost < (1U << k); lost++) {
+                for (unsigned int got = 0; got < (1U << r); got++) {
+                    init_test_transport(&ground, &ground_fec,
+                                        RADIO_DEVICE_ADDRESS_GROUND_STATION);
+                    num_recovered = 0;
+
+                    for (uint8_t i = 0; i < k; i++) {
+                        if (!(lost & (1U << i))) {
+                            ground_receive(&ground, packets[i]);
+                        }
+                    }
+                    for (uint8_t j = 0; j < r; j++) {
+                        if (got & (1U << j)) {
+                            ground_receive(&ground, packets[k + j]);
+                        }
+                    }
+
+                    const int num_lost = __builtin_popcount(lost);
+                    const int num_got = __builtin_popcount(got);
+                    if ((num_lost == 0) || (num_got < num_lost)) {
+                        ut_assert(num_recovered == 0);
+                        continue;
+                    }
+
+                    ut_assert(num_recovered == num_lost);
+                    ut_assert(ground_fec.num_recovered == (uint32_t)num_lost);
+                    for (int n = 0; n < num_recovered; n++) {
+                        const uint8_t *const original =
+                                                find_original(recovered[n], k);
+                        ut_assert(original != NULL);
+                        ut_assert(lost & (1U << (original - packets[0]) /
+                                          RADIO_MAX_PACKET_SIZE));
+                        ut_assert(!memcmp(recovered[n], original,
+                                          radio_packet_length(original)));
+                    }
+                }
+            }
+        }
+    }
+
+    // A lost packet is rebuilt when the last packet it depends on arrives
+    // after the parity
+    {
+        make_group(100, 4, 1, 7);
+        init_test_transport(&ground, &ground_fec,
+                            RADIO_DEVICE_ADDRESS_GROUND_STATION);
+        num_recovered = 0;
+
+        ground_receive(&ground, packets[0]);
+        ground_receive(&ground, packets[1]);
+        ground_receive(&ground, packets[4]);
+        ut_assert(num_recovered == 0);
+        ground_receive(&ground, packets[3]);
+        ut_assert(num_recovered == 1);
+        ut_assert(!memcmp(recovered[0], packets[2],
+                          radio_packet_length(packets[2])));
+
+        // Repeated parity does not rebuild the packet again
+        ground_receive(&ground, packets[4]);
+        ut_assert(num_recovered == 1);
+        ut_assert(ground_fec.num_groups == 1);
+    }
+
+    // Packets that can not be rebuilt are counted once the next group starts
+    {
+        init_test_transport(&ground, &ground_fec,
+                            RADIO_DEVICE_ADDRESS_GROUND_STATION);
+        make_group(200, 4, 1, 8);
+        num_recovered = 0;
+        ground_receive(&ground, packets[0]);
+        ground_receive(&ground, packets[1]);
+        ground_receive(&ground, packets[4]);
+        ut_assert(ground_fec.num_unrecoverable == 0);
+
+        make_group(205, 4, 1, 9);
+        for (uint8_t i = 0; i < 5; i++) {
+            ground_receive(&ground, packets[i]);
+        }
+        ut_assert(num_recovered == 0);
+        ut_assert(ground_fec.num_groups == 2);
+        ut_assert(ground_fec.num_unrecoverable == 2);
+    }
+
+    // Parity which does not make sense is ignored
+    {
+        init_test_transport(&ground, &ground_fec,
+                            RADIO_DEVICE_ADDRESS_GROUND_STATION);
+        make_group(300, 2, 1, 10);
+        uint8_t *const block = packets[2] + RADIO_PACKET_HEADER_LENGTH;
+        radio_block_marshal_fec_parity(block, 300, 2, 1, 1);
+        ground_receive(&ground, packets[2]);
+        radio_block_marshal_fec_parity(block, 300, 0, 0, 1);
+        ground_receive(&ground, packets[2]);
+        radio_block_marshal_fec_parity(block, 300, 9, 0, 1);
+        ground_receive(&ground, packets[2]);
+        radio_block_marshal_fec_parity(block, 300, 2, 0, 5);
+        ground_receive(&ground, packets[2]);
+        ut_assert(ground_fec.num_groups == 0);
+        ut_assert(!ground_fec.decoder.active);
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,159 @@
+#include <unittest.h>
+
+#include <string.h>
+
+/*
+ *  Stubs for symbols used by the radio erasure coding module and helpers for
+ *  moving packets from a rocket's encoder to a ground station's decoder.
+ *
+ *  This file is ment to be included into other tests. Blocks sent through the
+ *  transport and packets rebuilt by the decoder are kept in lists.
+ */
+
+#include SOURCE_C
+
+volatile uint32_t millis;
+
+#define MAX_SENT_BLOCKS     32
+#define MAX_RECOVERED       RADIO_FEC_MAX_PARITY_PACKETS
+
+/**
+ *  A block sent by a transport instance.
+ */
+struct sent_block {
+    struct radio_transport_desc *inst;
+    uint8_t data[RADIO_MAX_BLOCK_SIZE];
+    uint8_t length;
+};
+
+/** Blocks sent since the list was last cleared */
+static struct sent_block sent_blocks[MAX_SENT_BLOCKS];
+static int num_sent;
+
+/** Packets rebuilt by the decoder since the list was last cleared */
+static uint8_t recovered[MAX_RECOVERED][RADIO_MAX_PACKET_SIZE];
+static int num_recovered;
+
+/** Radio passed to the decoder */
+static struct radio_instance_desc test_radio;
+
+int radio_send_block(struct radio_transport_desc *inst, const uint8_t *block,
+                     uint8_t block_length, uint16_t slack_time,
+                     uint16_t time_to_live,
+                     enum radio_block_priority priority)
+{
+    ut_assert(num_sent < MAX_SENT_BLOCKS);
+    ut_assert(block_length == radio_block_length(block));
+
+    sent_blocks[num_sent].inst = inst;
+    memcpy(sent_blocks[num_sent].data, block, block_length);
+    sent_blocks[num_sent].length = block_length;
+    num_sent++;
+    return 0;
+}
+
+void radio_handle_recovered_packet(struct radio_transport_desc *inst,
+                                   struct radio_instance_desc *radio,
+                                   const uint8_t *packet)
+{
+    ut_assert(radio == &test_radio);
+    ut_assert(num_recovered < MAX_RECOVERED);
+    memcpy(recovered[num_recovered], packet, radio_packet_length(packet));
+    num_recovered++;
+}
+
+/**
+ *  Initialize a transport instance with erasure coding.
+ */
+static void init_test_transport(struct radio_transport_desc *inst,
+                                struct radio_fec_desc *fec,
+                                enum radio_packet_device_address address)
+{
+    memset(inst, 0, sizeof(*inst));
+    inst->address = address;
+    inst->fec = fec;
+    inst->max_packet_length = RADIO_MAX_PACKET_SIZE;
+    init_radio_fec(inst);
+    radio_packet_marshal_header(inst->fec_packet_buffer, LORA_CALLSIGN,
+                                RADIO_SUPPORTED_FORMAT_VERSION, address, 0,
+                                RADIO_PACKET_HEADER_LENGTH);
+}
+
+/**
+ *  Simple xorshift generator so that tests are repeatable.
+ */
+static uint32_t test_rand(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/**
+ *  Create a packet holding a single data block with a pseudo random payload.
+ *
+ *  @param packet Buffer in which the packet should be created
+ *  @param number The packet number
+ *  @param block_length The length of the data block, a multiple of 4
+ *  @param seed Seed for the payload
+ */
+static void make_packet(uint8_t *packet, uint16_t number, uint8_t block_length,
+                        uint32_t seed)
+{
+    radio_packet_marshal_header(packet, LORA_CALLSIGN,
+                                RADIO_SUPPORTED_FORMAT_VERSION,
+                                RADIO_DEVICE_ADDRESS_ROCKET, 0,
+                                RADIO_PACKET_HEADER_LENGTH + block_length);
+    radio_packet_set_number(packet, number);
+
+    uint8_t *const block = packet + RADIO_PACKET_HEADER_LENGTH;
+    radio_block_marshal_header(block, block_length, 0,
+                               RADIO_DEVICE_ADDRESS_GROUND_STATION,
+                               RADIO_BLOCK_TYPE_DATA, 0);
+    uint32_t state = seed | 1;
+    for (uint8_t i = RADIO_BLOCK_HEADER_LENGTH; i < block_length; i++) {
+        block[i] = (uint8_t)test_rand(&state);
+    }
+}
+
+/**
+ *  Give a packet to a ground station as the transport would on reception.
+ */
+static void ground_receive(struct radio_transport_desc *ground,
+                           const uint8_t *packet)
+{
+    radio_fec_decode_packet(ground, &test_radio, packet);
+
+    const uint8_t *const block = radio_packet_fist_block(packet);
+    if ((radio_block_type(block) == RADIO_BLOCK_TYPE_CONTROL) &&
+            (radio_block_subtype(block) == RADIO_CONTROL_BLOCK_FEC_PARITY)) {
+        radio_fec_parity_cb(ground, &test_radio, packet, block);
+    }
+}
+
+/**
+ *  Create the next parity packet on a rocket as the transport would before
+ *  sending it.
+ *
+ *  @param rocket The rocket's transport instance
+ *  @param number The packet number to give the parity packet
+ *
+ *  @return The parity packet or NULL if there is no parity to send
+ */
+static const uint8_t *rocket_next_parity(struct radio_transport_desc *rocket,
+                                         uint16_t number)
+{
+    const uint8_t length = radio_fec_make_parity_packet(rocket,
+                                                    rocket->fec_packet_buffer);
+    if (length == 0) {
+        return NULL;
+    }
+    ut_assert(length == radio_packet_length(rocket->fec_packet_buffer));
+    ut_assert(length < RADIO_MAX_PACKET_SIZE);
+    radio_packet_set_number(rocket->fec_packet_buffer, number);
+    radio_fec_parity_sent(rocket);
+    return rocket->fec_packet_buffer;
+}
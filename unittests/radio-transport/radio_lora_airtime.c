@@ -0,0 +1,45 @@
+#include <unittest.h>
+#include SOURCE_C
+
+#include "radio_transport_stubs.c"
+
+/*
+ *  radio_lora_airtime() gives the LoRa time on air for a packet, checked
+ *  against values from the Semtech LoRa calculator.
+ */
+
+int main (int argc, char **argv)
+{
+    struct rn2483_lora_settings_t settings = { 0 };
+
+    // SF7, 125 kHz, 4/5, 8 symbol preamble, CRC, 20 bytes
+    settings.spreading_factor = RN2483_SF_SF7;
+    settings.bandwidth = RN2483_BW_125;
+    settings.coding_rate = RN2483_CR_4_5;
+    settings.preamble_length = 8;
+    settings.crc = 1;
+    ut_assert(radio_lora_airtime(&settings, 20) == 56576);
+
+    // SF12, 125 kHz, 4/5, 8 symbol preamble, CRC, 128 bytes (uses low data
+    // rate optimization)
+    settings.spreading_factor = RN2483_SF_SF12;
+    ut_assert(radio_lora_airtime(&settings, 128) == 4923392);
+
+    // SF9, 250 kHz, 4/8, 6 symbol preamble, no CRC, 50 bytes
+    settings.spreading_factor = RN2483_SF_SF9;
+    settings.bandwidth = RN2483_BW_250;
+    settings.coding_rate = RN2483_CR_4_8;
+    settings.preamble_length = 6;
+    settings.crc = 0;
+    ut_assert(radio_lora_airtime(&settings, 50) == 217600);
+
+    // Time on air never decreases as packets get longer
+    uint32_t last = 0;
+    for (unsigned int length = 0; length <= RADIO_MAX_PACKET_SIZE; length++) {
+        const uint32_t airtime = radio_lora_airtime(&settings, length);
+        ut_assert(airtime >= last);
+        last = airtime;
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,245 @@
+#include <unittest.h>
+#include SOURCE_C
+
+#include "radio_transport_stubs.c"
+
+/*
+ *  radio_send_block() packs a block into the oldest packet in the transmit
+ *  queue that has space for it and is not being transmitted, moving less
+ *  important blocks back if needed, or starts a new packet.
+ */
+
+static struct radio_transport_desc transport;
+
+
+int main (int argc, char **argv)
+{
+    uint8_t block[RADIO_MAX_PACKET_SIZE];
+
+    // Block is packed into a packet and waits for its slack time
+    {
+        init_test_transport(&transport);
+        make_block(block, 16, 0xAA);
+
+        int ret = radio_send_block(&transport, block, 16, 500, 0,
+                                   RADIO_BLOCK_PRIORITY_NORMAL);
+
+        ut_assert(!ret);
+        ut_assert(num_sent == 0);
+        ut_assert(transport.tx_queue_count == 1);
+        struct radio_trans_tx_packet *p = tx_queue_get(&transport, 0);
+        ut_assert(p->num_blocks == 1);
+        ut_assert(p->deadline == 1500);
+        ut_assert(radio_packet_length(p->buffer) ==
+                  (RADIO_PACKET_HEADER_LENGTH + 16));
+        ut_assert(!memcmp(p->buffer + RADIO_PACKET_HEADER_LENGTH, block, 16));
+
+        // A second block with a shorter slack time moves the deadline up
+        millis += 100;
+        make_block(block, 8, 0xBB);
+        ret = radio_send_block(&transport, block, 8, 200, 0,
+                               RADIO_BLOCK_PRIORITY_NORMAL);
+
+        ut_assert(!ret);
+        ut_assert(transport.tx_queue_count == 1);
+        ut_assert(p->num_blocks == 2);
+        ut_assert(p->deadline == 1300);
+        ut_assert(p->blocks[1].offset == (RADIO_PACKET_HEADER_LENGTH + 16));
+        ut_assert(!memcmp(p->buffer + RADIO_PACKET_HEADER_LENGTH + 16, block,
+                          8));
+    }
+
+    // Blocks which arrive while a packet is being transmitted are queued in
+    // new packets
+    {
+        init_test_transport(&transport);
+
+        // Passes the waterline and is sent right away
+        make_block(block, 104, 0x11);
+        ut_assert(!radio_send_block(&transport, block, 104, 1000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(num_sent == 1);
+        ut_assert(transport.tx_state == RADIO_TRANS_TX_IN_PROGRESS);
+        ut_assert(transport.tx_queue_count == 1);
+
+        // These go in new packets, one per packet since two will not fit
+        make_block(block, 60, 0x11);
+        ut_assert(!radio_send_block(&transport, block, 60, 1000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(transport.tx_queue_count == 2);
+        ut_assert(!radio_send_block(&transport, block, 60, 1000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(transport.tx_queue_count == 3);
+
+        // The queue is full
+        ut_assert(radio_send_block(&transport, block, 60, 1000, 0,
+                                   RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(transport.tx_queue_count == 3);
+
+        // Small blocks can still be packed into the oldest packet which is
+        // not being transmitted
+        make_block(block, 8, 0x22);
+        ut_assert(!radio_send_block(&transport, block, 8, 1000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(tx_queue_get(&transport, 1)->num_blocks == 2);
+        ut_assert(tx_queue_get(&transport, 2)->num_blocks == 1);
+    }
+
+    // Expired blocks are culled to make space in the newest packet
+    {
+        init_test_transport(&transport);
+        // Radio is in backoff so the packet is not sent
+        test_radio.last_tx_time = millis;
+        make_block(block, 32, 0x33);
+
+        ut_assert(!radio_send_block(&transport, block, 32, 1000, 50,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(!radio_send_block(&transport, block, 32, 1000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(!radio_send_block(&transport, block, 32, 1000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(num_sent == 0);
+
+        // Once the first block has expired, there is space for another block
+        millis += 51;
+        make_block(block, 24, 0x44);
+        ut_assert(!radio_send_block(&transport, block, 24, 1000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        struct radio_trans_tx_packet *p = tx_queue_get(&transport, 0);
+        ut_assert(transport.tx_queue_count == 1);
+        ut_assert(p->num_blocks == 3);
+        ut_assert(p->blocks[0].offset == RADIO_PACKET_HEADER_LENGTH);
+        ut_assert(p->blocks[2].offset == (RADIO_PACKET_HEADER_LENGTH + 64));
+        ut_assert(radio_packet_length(p->buffer) ==
+                  (RADIO_PACKET_HEADER_LENGTH + 88));
+        ut_assert(p->buffer[RADIO_PACKET_HEADER_LENGTH + 64 +
+                            RADIO_BLOCK_HEADER_LENGTH] == 0x44);
+    }
+
+    // Each packet holds a limited number of blocks
+    {
+        init_test_transport(&transport);
+        make_block(block, 4, 0);
+
+        for (int i = 0; i < RADIO_BLOCKS_PER_PACKET; i++) {
+            ut_assert(!radio_send_block(&transport, block, 4, 1000, 0,
+                                        RADIO_BLOCK_PRIORITY_NORMAL));
+        }
+        ut_assert(transport.tx_queue_count == 1);
+        ut_assert(!radio_send_block(&transport, block, 4, 1000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(transport.tx_queue_count == 2);
+    }
+
+    // Blocks with earlier deadlines move later blocks into newer packets
+    {
+        init_test_transport(&transport);
+        test_radio.last_tx_time = millis;
+
+        make_block(block, 100, 0x01);
+        ut_assert(!radio_send_block(&transport, block, 100, 5000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        make_block(block, 100, 0x02);
+        ut_assert(!radio_send_block(&transport, block, 100, 5000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(transport.tx_queue_count == 2);
+
+        make_block(block, 60, 0x03);
+        ut_assert(!radio_send_block(&transport, block, 60, 500, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(transport.tx_queue_count == 3);
+        ut_assert(num_sent == 0);
+
+        struct radio_trans_tx_packet *p = tx_queue_get(&transport, 0);
+        ut_assert(p->num_blocks == 1);
+        ut_assert(p->deadline == 1500);
+        ut_assert(p->buffer[RADIO_PACKET_HEADER_LENGTH +
+                            RADIO_BLOCK_HEADER_LENGTH] == 0x03);
+        p = tx_queue_get(&transport, 2);
+        ut_assert(p->num_blocks == 1);
+        ut_assert(p->deadline == 6000);
+        ut_assert(p->buffer[RADIO_PACKET_HEADER_LENGTH +
+                            RADIO_BLOCK_HEADER_LENGTH] == 0x01);
+    }
+
+    // Higher priority blocks displace lower priority blocks when the queue is
+    // full, blocks which are no more important than any queued block are
+    // rejected
+    {
+        init_test_transport(&transport);
+        test_radio.last_tx_time = millis;
+
+        make_block(block, 100, 0x01);
+        for (int i = 0; i < RADIO_TX_QUEUE_LENGTH; i++) {
+            ut_assert(!radio_send_block(&transport, block, 100, 1000, 0,
+                                        RADIO_BLOCK_PRIORITY_LOW));
+        }
+        ut_assert(transport.tx_queue_count == RADIO_TX_QUEUE_LENGTH);
+
+        make_block(block, 60, 0x02);
+        ut_assert(!radio_send_block(&transport, block, 60, 1000, 0,
+                                    RADIO_BLOCK_PRIORITY_HIGH));
+        struct radio_trans_tx_packet *p = tx_queue_get(&transport, 0);
+        ut_assert(p->num_blocks == 1);
+        ut_assert(radio_packet_length(p->buffer) ==
+                  (RADIO_PACKET_HEADER_LENGTH + 60));
+        ut_assert(p->buffer[RADIO_PACKET_HEADER_LENGTH +
+                            RADIO_BLOCK_HEADER_LENGTH] == 0x02);
+
+        // The displaced block had nowhere to go
+        ut_assert(transport.tx_stats[0].requested == 4);
+        ut_assert(transport.tx_stats[0].dropped == 1);
+
+        make_block(block, 100, 0x03);
+        ut_assert(radio_send_block(&transport, block, 100, 1000, 0,
+                                   RADIO_BLOCK_PRIORITY_LOW));
+        ut_assert(transport.tx_stats[0].dropped == 2);
+        ut_assert(p->num_blocks == 1);
+    }
+
+    // Blocks which could never fit in a packet are rejected
+    {
+        init_test_transport(&transport);
+        ut_assert(radio_send_block(&transport, block, RADIO_MAX_PACKET_SIZE,
+                                   0, 0, RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(transport.tx_queue_count == 0);
+    }
+
+    // Packets are kept under the shorter limit used with erasure coding, even
+    // if that means starting a new packet
+    {
+        init_test_transport(&transport);
+        transport.max_packet_length = RADIO_FEC_MAX_PACKET_LENGTH;
+        test_radio.last_tx_time = millis;
+
+        make_block(block, 104, 0x51);
+        ut_assert(radio_send_block(&transport, block, 104, 5000, 0,
+                                   RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(transport.tx_queue_count == 0);
+
+        make_block(block, 64, 0x52);
+        ut_assert(!radio_send_block(&transport, block, 64, 5000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        make_block(block, 40, 0x53);
+        ut_assert(!radio_send_block(&transport, block, 40, 5000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(transport.tx_queue_count == 2);
+        ut_assert(radio_packet_length(tx_queue_get(&transport, 0)->buffer) ==
+                  (RADIO_PACKET_HEADER_LENGTH + 64));
+
+        // A packet formed before the limit was lowered can be longer than it
+        transport.max_packet_length = RADIO_MAX_PACKET_SIZE;
+        make_block(block, 48, 0x54);
+        ut_assert(!radio_send_block(&transport, block, 48, 5000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(radio_packet_length(tx_queue_get(&transport, 0)->buffer) ==
+                  (RADIO_PACKET_HEADER_LENGTH + 112));
+        transport.max_packet_length = RADIO_FEC_MAX_PACKET_LENGTH;
+        make_block(block, 8, 0x55);
+        ut_assert(!radio_send_block(&transport, block, 8, 0, 0,
+                                    RADIO_BLOCK_PRIORITY_HIGH));
+        ut_assert(tx_queue_get(&transport, 0)->num_blocks == 2);
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,281 @@
+#include <unittest.h>
+#include SOURCE_C
+
+#include "radio_transport_stubs.c"
+
+/*
+ *  radio_transport_service() sends queued packets once they would otherwise
+ *  finish transmitting after their deadline, they pass the waterline or newer
+ *  packets are queued behind them.
+ */
+
+static struct radio_transport_desc transport;
+/** Erasure coding state for the transport, only used by the simulated
+    erasure encoder through its address */
+static struct radio_fec_desc test_fec;
+
+
+int main (int argc, char **argv)
+{
+    uint8_t block[RADIO_MAX_PACKET_SIZE];
+
+    // Packet is sent once its deadline, less its time on air, passes
+    {
+        init_test_transport(&transport);
+        make_block(block, 16, 0xAA);
+        ut_assert(!radio_send_block(&transport, block, 16, 500, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+
+        const uint32_t airtime = radio_lora_airtime(&transport.radio_settings,
+                                        RADIO_PACKET_HEADER_LENGTH + 16) / 1000;
+        ut_assert(airtime > 0);
+        millis += 500 - airtime;
+        radio_transport_service(&transport);
+        ut_assert(num_sent == 0);
+
+        millis += 1;
+        radio_transport_service(&transport);
+        ut_assert(num_sent == 1);
+        ut_assert(sent_lengths[0] == (RADIO_PACKET_HEADER_LENGTH + 16));
+        ut_assert(!memcmp(sent_packets[0] + RADIO_PACKET_HEADER_LENGTH, block,
+                          16));
+
+        // Packet leaves the queue once it has been written to the radio
+        send_state[0] = RN2483_SEND_TRANS_WRITTEN;
+        radio_transport_service(&transport);
+        ut_assert(transport.tx_queue_count == 0);
+        ut_assert(transport.tx_state == RADIO_TRANS_TX_IDLE);
+        ut_assert(test_radio.tx_busy);
+        finish_tx(&transport);
+    }
+
+    // Packets queued during a transmission are sent back to back, each after
+    // the backoff time
+    {
+        init_test_transport(&transport);
+        make_block(block, 104, 0x55);
+        ut_assert(!radio_send_block(&transport, block, 104, 5000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(num_sent == 1);
+
+        make_block(block, 64, 0x66);
+        ut_assert(!radio_send_block(&transport, block, 64, 5000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(!radio_send_block(&transport, block, 64, 5000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(transport.tx_queue_count == 3);
+
+        finish_tx(&transport);
+        ut_assert(transport.tx_queue_count == 2);
+        ut_assert(num_sent == 1);
+
+        // After the backoff the first queued packet is sent because another
+        // packet is queued behind it, even though its deadline has not passed
+        millis += RADIO_TX_BACKOFF_TIME + 1;
+        radio_transport_service(&transport);
+        ut_assert(num_sent == 2);
+        ut_assert(sent_lengths[1] == (RADIO_PACKET_HEADER_LENGTH + 64));
+        finish_tx(&transport);
+
+        // The last packet waits for its deadline
+        millis += RADIO_TX_BACKOFF_TIME + 1;
+        radio_transport_service(&transport);
+        ut_assert(num_sent == 2);
+        millis += 5000;
+        radio_transport_service(&transport);
+        ut_assert(num_sent == 3);
+        finish_tx(&transport);
+        ut_assert(transport.tx_queue_count == 0);
+    }
+
+    // Expired blocks are culled before a packet is sent and empty packets are
+    // skipped
+    {
+        init_test_transport(&transport);
+        test_radio.last_tx_time = millis;
+
+        make_block(block, 104, 0x77);
+        ut_assert(!radio_send_block(&transport, block, 104, 0, 100,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        make_block(block, 8, 0x88);
+        ut_assert(!radio_send_block(&transport, block, 8, 0, 100,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        make_block(block, 8, 0x99);
+        ut_assert(!radio_send_block(&transport, block, 8, 0, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(transport.tx_queue_count == 2);
+        ut_assert(num_sent == 0);
+
+        millis += RADIO_TX_BACKOFF_TIME + 1;
+        radio_transport_service(&transport);
+
+        // Blocks with a time to live of zero never expire
+        ut_assert(num_sent == 1);
+        ut_assert(sent_lengths[0] == (RADIO_PACKET_HEADER_LENGTH + 8));
+        ut_assert(sent_packets[0][RADIO_PACKET_HEADER_LENGTH +
+                                  RADIO_BLOCK_HEADER_LENGTH] == 0x99);
+        finish_tx(&transport);
+        ut_assert(transport.tx_queue_count == 0);
+    }
+
+    // Slow settings make packets leave earlier and are accounted for in the
+    // transmit statistics
+    {
+        init_test_transport(&transport);
+        transport.radio_settings.spreading_factor = RN2483_SF_SF12;
+        transport.radio_settings.preamble_length = 6;
+        make_block(block, 16, 0xAB);
+        ut_assert(!radio_send_block(&transport, block, 16, 2000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+
+        // 28 bytes take about 1581 ms at SF12
+        millis += 300;
+        radio_transport_service(&transport);
+        ut_assert(num_sent == 0);
+
+        millis += 200;
+        radio_transport_service(&transport);
+        ut_assert(num_sent == 1);
+        ut_assert(transport.tx_stats[0].requested == 1);
+        ut_assert(transport.tx_stats[0].sent == 1);
+        ut_assert(transport.tx_stats[0].dropped == 0);
+        ut_assert(transport.tx_airtime == 1581);
+        ut_assert(transport.tx_block_bytes == 16);
+        finish_tx(&transport);
+    }
+
+    // The priority buffer is sent before queued packets
+    {
+        init_test_transport(&transport);
+        test_radio.last_tx_time = millis;
+
+        make_block(block, 8, 0x12);
+        ut_assert(!radio_send_block(&transport, block, 8, 0, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        make_block(block, 4, 0x34);
+        ut_assert(!radio_send_block_priority(&transport, block, 4));
+        ut_assert(num_sent == 0);
+
+        millis += RADIO_TX_BACKOFF_TIME + 1;
+        radio_transport_service(&transport);
+        ut_assert(num_sent == 1);
+        ut_assert(sent_lengths[0] == (RADIO_PACKET_HEADER_LENGTH + 4));
+        finish_tx(&transport);
+        ut_assert(transport.tx_queue_count == 1);
+
+        millis += RADIO_TX_BACKOFF_TIME + 1;
+        radio_transport_service(&transport);
+        ut_assert(num_sent == 2);
+        ut_assert(sent_packets[1][RADIO_PACKET_HEADER_LENGTH +
+                                  RADIO_BLOCK_HEADER_LENGTH] == 0x12);
+    }
+
+    // Transmissions alternate between channels and a radio goes back to its
+    // own channel once it is done sending on another one
+    {
+        init_test_transport(&transport);
+        make_block(block, 104, 0x21);
+        ut_assert(!radio_send_block(&transport, block, 104, 5000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(!radio_send_block(&transport, block, 104, 5000, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        ut_assert(num_sent == 1);
+        ut_assert(sent_channels[0] == 0);
+        finish_tx(&transport);
+
+        millis += RADIO_TX_BACKOFF_TIME + 1;
+        radio_transport_service(&transport);
+        ut_assert(num_sent == 2);
+        ut_assert(sent_radios[1] == &test_radio);
+        ut_assert(sent_channels[1] == 1);
+
+        send_state[0] = RN2483_SEND_TRANS_WRITTEN;
+        radio_transport_service(&transport);
+        ut_assert(test_radio.settings.freq == 0);
+        finish_tx(&transport);
+    }
+
+    // With two radios a packet can be sent on the second radio while the first
+    // is still on air
+    {
+        init_test_transport(&transport);
+        test_radios[1] = &test_radio_b;
+        make_block(block, 104, 0x31);
+        for (int i = 0; i < 3; i++) {
+            ut_assert(!radio_send_block(&transport, block, 104, 5000, 0,
+                                        RADIO_BLOCK_PRIORITY_NORMAL));
+        }
+        ut_assert(num_sent == 1);
+        ut_assert(sent_radios[0] == &test_radio);
+
+        // The next packet waits until the first has been written
+        radio_transport_service(&transport);
+        ut_assert(num_sent == 1);
+        send_state[0] = RN2483_SEND_TRANS_WRITTEN;
+        radio_transport_service(&transport);
+        ut_assert(num_sent == 2);
+        ut_assert(sent_radios[1] == &test_radio_b);
+        ut_assert(sent_channels[1] == 1);
+        ut_assert(transport.tx_queue_count == 2);
+
+        // Both radios are on air so the last packet has to wait
+        send_state[1] = RN2483_SEND_TRANS_WRITTEN;
+        radio_transport_service(&transport);
+        ut_assert(num_sent == 2);
+        ut_assert(transport.tx_queue_count == 1);
+
+        // The first radio to finish sends it once its backoff has passed
+        send_state[0] = RN2483_SEND_TRANS_DONE;
+        radio_transport_service(&transport);
+        ut_assert(num_sent == 2);
+        millis += RADIO_TX_BACKOFF_TIME + 1;
+        radio_transport_service(&transport);
+        ut_assert(num_sent == 3);
+        ut_assert(sent_radios[2] == &test_radio);
+        ut_assert(sent_channels[2] == 0);
+    }
+
+    // Parity is sent ahead of the priority buffer and the queue, and is not
+    // itself passed to the erasure encoder
+    {
+        init_test_transport(&transport);
+        transport.fec = &test_fec;
+        test_radio.last_tx_time = millis;
+
+        make_block(block, 8, 0x41);
+        ut_assert(!radio_send_block(&transport, block, 8, 0, 0,
+                                    RADIO_BLOCK_PRIORITY_NORMAL));
+        make_block(block, 4, 0x42);
+        ut_assert(!radio_send_block_priority(&transport, block, 4));
+        parity_pending = 1;
+
+        millis += RADIO_TX_BACKOFF_TIME + 1;
+        radio_transport_service(&transport);
+        ut_assert(num_sent == 1);
+        ut_assert(sent_packets[0][RADIO_PACKET_HEADER_LENGTH +
+                                  RADIO_BLOCK_HEADER_LENGTH] == 0xFE);
+        ut_assert(parity_pending == 0);
+        ut_assert(num_encoded == 0);
+        finish_tx(&transport);
+        ut_assert(!transport.fec_tx_in_progress);
+        ut_assert(transport.tx_queue_count == 1);
+        ut_assert(radio_packet_length(transport.priority_packet_buffer) ==
+                  (RADIO_PACKET_HEADER_LENGTH + 4));
+
+        millis += RADIO_TX_BACKOFF_TIME + 1;
+        radio_transport_service(&transport);
+        ut_assert(num_sent == 2);
+        ut_assert(sent_lengths[1] == (RADIO_PACKET_HEADER_LENGTH + 4));
+        ut_assert(num_encoded == 1);
+        ut_assert(radio_packet_number(sent_packets[1]) ==
+                  (radio_packet_number(sent_packets[0]) + 1));
+        finish_tx(&transport);
+
+        millis += RADIO_TX_BACKOFF_TIME + 1;
+        radio_transport_service(&transport);
+        ut_assert(num_sent == 3);
+        ut_assert(num_encoded == 2);
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,250 @@
+#include <unittest.h>
+
+#include <string.h>
+
+/*
+ *  Stubs for symbols used by the radio transport and a simulated radio.
+ *
+ *  This file is ment to be included into other tests after the source file
+ *  for the radio transport.
+ */
+
+volatile uint32_t millis;
+
+/** The radios used by the tests, most tests only use the first */
+static struct radio_instance_desc test_radio;
+static struct radio_instance_desc test_radio_b;
+static struct radio_instance_desc *test_radios[] = {&test_radio, NULL, NULL};
+
+/** Packets sent by the simulated radios */
+static uint8_t sent_packets[16][RADIO_MAX_PACKET_SIZE];
+static uint8_t sent_lengths[16];
+static struct radio_instance_desc *sent_radios[16];
+static uint8_t sent_channels[16];
+static int num_sent;
+
+/** State of each simulated radio's send transaction */
+static enum rn2483_send_trans_state send_state[2];
+
+/** Number of packets passed to the simulated erasure encoder */
+static int num_encoded;
+/** Number of parity packets that the simulated erasure encoder has to send */
+static int parity_pending;
+
+/**
+ *  Get the index of a simulated radio from its driver instance.
+ */
+static int test_radio_index(struct rn2483_desc_t *inst)
+{
+    ut_assert((inst == &test_radio.rn2483) || (inst == &test_radio_b.rn2483));
+    return (inst == &test_radio.rn2483) ? 0 : 1;
+}
+
+void rn2483_service (struct rn2483_desc_t *inst)
+{
+}
+
+enum rn2483_operation_result rn2483_send (struct rn2483_desc_t *inst,
+                                          const uint8_t *data, uint8_t length,
+                                          uint8_t *transaction_id)
+{
+    const int n = test_radio_index(inst);
+    ut_assert(send_state[n] == RN2483_SEND_TRANS_INVALID);
+    ut_assert(num_sent < 16);
+    ut_assert(length == radio_packet_length(data));
+
+    memcpy(sent_packets[num_sent], data, length);
+    sent_lengths[num_sent] = length;
+    sent_radios[num_sent] = (n == 0) ? &test_radio : &test_radio_b;
+    sent_channels[num_sent] = sent_radios[num_sent]->settings.freq;
+    num_sent++;
+
+    *transaction_id = 0;
+    send_state[n] = RN2483_SEND_TRANS_PENDING;
+    return RN2483_OP_SUCCESS;
+}
+
+enum rn2483_send_trans_state rn2483_get_send_state (struct rn2483_desc_t *inst,
+                                                    uint8_t transaction_id)
+{
+    return send_state[test_radio_index(inst)];
+}
+
+void rn2483_clear_send_transaction (struct rn2483_desc_t *inst,
+                                    uint8_t transaction_id)
+{
+    send_state[test_radio_index(inst)] = RN2483_SEND_TRANS_INVALID;
+}
+
+void radio_antmgr_service(struct radio_instance_desc *inst)
+{
+}
+
+void radio_antmgr_prepare_tx(struct radio_instance_desc *inst)
+{
+}
+
+void radio_chanmgr_service(struct radio_transport_desc *inst)
+{
+}
+
+/**
+ *  Simplified channel manager which sends on the next channel in turn, using
+ *  the radio that listens on that channel if it is ready or otherwise the first
+ *  radio that is ready. The simulated radios keep the channel that they are
+ *  tuned to in the frequency field of their settings.
+ */
+struct radio_instance_desc *radio_chanmgr_get_tx_radio(
+                                            struct radio_transport_desc *inst,
+                                            uint8_t *channel)
+{
+    struct radio_instance_desc *radio = NULL;
+    for (struct radio_instance_desc *const *radio_p = inst->radios;
+         *radio_p != NULL; radio_p++) {
+        if ((*radio_p)->tx_busy || ((millis - (*radio_p)->last_tx_time) <=
+                                    RADIO_TX_BACKOFF_TIME)) {
+            continue;
+        }
+        if ((radio == NULL) || ((*radio_p)->channel == inst->tx_channel)) {
+            radio = *radio_p;
+        }
+    }
+    *channel = inst->tx_channel;
+    return radio;
+}
+
+void radio_chanmgr_tune(struct radio_instance_desc *radio, uint8_t channel)
+{
+    radio->settings.freq = channel;
+}
+
+void radio_chanmgr_tx_start_cb(struct radio_transport_desc *transport,
+                               struct radio_instance_desc *radio,
+                               const uint8_t *packet)
+{
+}
+
+void radio_chanmgr_tx_done_cb(struct radio_transport_desc *transport,
+                              struct radio_instance_desc *radio, int sent)
+{
+}
+
+/**
+ *  Initialize the transmit side of a radio transport instance without any of
+ *  the radio drivers.
+ */
+static void init_test_transport(struct radio_transport_desc *inst)
+{
+    memset(inst, 0, sizeof(*inst));
+    memset(&test_radio, 0, sizeof(test_radio));
+    memset(&test_radio_b, 0, sizeof(test_radio_b));
+    test_radio_b.radio_num = 1;
+    test_radio_b.channel = 1;
+    test_radio_b.settings.freq = 1;
+    test_radios[1] = NULL;
+    inst->radios = test_radios;
+    inst->address = RADIO_DEVICE_ADDRESS_ROCKET;
+    inst->max_packet_length = RADIO_MAX_PACKET_SIZE;
+
+    for (unsigned int i = 0; i < RADIO_TX_QUEUE_LENGTH; i++) {
+        radio_packet_marshal_header(inst->tx_queue[i].buffer, LORA_CALLSIGN,
+                                    RADIO_SUPPORTED_FORMAT_VERSION,
+                                    inst->address, 0,
+                                    RADIO_PACKET_HEADER_LENGTH);
+    }
+    radio_packet_marshal_header(inst->priority_packet_buffer, LORA_CALLSIGN,
+                                RADIO_SUPPORTED_FORMAT_VERSION, inst->address,
+                                0, RADIO_PACKET_HEADER_LENGTH);
+    radio_packet_marshal_header(inst->fec_packet_buffer, LORA_CALLSIGN,
+                                RADIO_SUPPORTED_FORMAT_VERSION, inst->address,
+                                0, RADIO_PACKET_HEADER_LENGTH);
+
+    inst->tx_state = RADIO_TRANS_TX_IDLE;
+    // Allow transmission right away
+    millis = 1000;
+    inst->last_tx_time = 0;
+
+    num_sent = 0;
+    send_state[0] = RN2483_SEND_TRANS_INVALID;
+    send_state[1] = RN2483_SEND_TRANS_INVALID;
+    num_encoded = 0;
+    parity_pending = 0;
+}
+
+/**
+ *  Create a data block with a given length filled with a given value.
+ */
+static void make_block(uint8_t *block, uint8_t length, uint8_t fill)
+{
+    radio_block_marshal_header(block, length, 0,
+                               RADIO_DEVICE_ADDRESS_GROUND_STATION,
+                               RADIO_BLOCK_TYPE_DATA, 0);
+    memset(block + RADIO_BLOCK_HEADER_LENGTH, fill,
+           length - RADIO_BLOCK_HEADER_LENGTH);
+}
+
+/**
+ *  Complete the first simulated radio's transmission and let the transport
+ *  clean up.
+ */
+static void finish_tx(struct radio_transport_desc *inst)
+{
+    send_state[0] = RN2483_SEND_TRANS_DONE;
+    radio_transport_service(inst);
+    ut_assert(inst->tx_state == RADIO_TRANS_TX_IDLE);
+    ut_assert(!test_radio.tx_busy);
+}
+
+/*
+ *  Simulated erasure encoder which counts the packets that it is given and
+ *  sends a 16 byte parity block for each pending parity packet.
+ */
+
+void init_radio_fec(struct radio_transport_desc *inst)
+{
+}
+
+void radio_fec_service(struct radio_transport_desc *inst)
+{
+}
+
+void radio_fec_config_cb(struct radio_transport_desc *inst,
+                         const uint8_t *block,
+                         enum radio_packet_device_address source)
+{
+}
+
+void radio_fec_encode_packet(struct radio_transport_desc *inst,
+                             const uint8_t *packet)
+{
+    ut_assert(packet != inst->fec_packet_buffer);
+    num_encoded++;
+}
+
+uint8_t radio_fec_make_parity_packet(struct radio_transport_desc *inst,
+                                     uint8_t *packet)
+{
+    if (parity_pending == 0) {
+        return 0;
+    }
+    make_block(packet + RADIO_PACKET_HEADER_LENGTH, 16, 0xFE);
+    radio_packet_set_length(packet, RADIO_PACKET_HEADER_LENGTH + 16);
+    return RADIO_PACKET_HEADER_LENGTH + 16;
+}
+
+void radio_fec_parity_sent(struct radio_transport_desc *inst)
+{
+    parity_pending--;
+}
+
+void radio_fec_decode_packet(struct radio_transport_desc *inst,
+                             struct radio_instance_desc *radio,
+                             const uint8_t *packet)
+{
+}
+
+void radio_fec_parity_cb(struct radio_transport_desc *inst,
+                         struct radio_instance_desc *radio,
+                         const uint8_t *packet, const uint8_t *block)
+{
+}
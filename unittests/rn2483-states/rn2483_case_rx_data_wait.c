@@ -0,0 +1,151 @@
+#include "rn2483_states_stubs.c"
+
+/*
+ *  rn2483_case_rx_data_wait() decodes the hexadecimal data from a radio_rx
+ *  message directly out of the UART input buffer, moving on to get the SNR
+ *  once the end of the line is reached.
+ */
+
+static const uint8_t *rx_data(void)
+{
+    return (const uint8_t*)test_radio.buffer + RN2483_RX_DATA_OFFSET;
+}
+
+static const struct rn2483_rx_info *rx_info(void)
+{
+    return (const struct rn2483_rx_info*)test_radio.buffer;
+}
+
+int main (int argc, char **argv)
+{
+    // A whole packet at once, the following response stays in the buffer
+    {
+        static const char in[] = "48656C6c6F\r\nok";
+        reset_radio(0);
+        feed_uart(in, sizeof(in) - 1);
+        run_decoder(rn2483_case_rx_data_wait);
+
+        ut_assert(test_radio.state == RN2483_GET_SNR);
+        ut_assert(rx_info()->length == 5);
+        ut_assert(!memcmp(rx_data(), "Hello", 5));
+        ut_assert(circular_buffer_capacity(&test_uart.in_buffer) -
+                  circular_buffer_unused(&test_uart.in_buffer) == 2);
+    }
+
+    // An empty packet
+    {
+        reset_radio(0);
+        feed_uart("\r\n", 2);
+        ut_assert(rn2483_case_rx_data_wait(&test_radio) == 1);
+        ut_assert(test_radio.state == RN2483_GET_SNR);
+        ut_assert(rx_info()->length == 0);
+    }
+
+    // One character at a time with spaces between and within bytes
+    {
+        static const char in[] = "0 1F  E\r \n";
+        reset_radio(0);
+        for (unsigned i = 0; i < (sizeof(in) - 1); i++) {
+            ut_assert(test_radio.state == RN2483_RX_DATA_WAIT);
+            feed_uart(in + i, 1);
+            run_decoder(rn2483_case_rx_data_wait);
+        }
+        ut_assert(test_radio.state == RN2483_GET_SNR);
+        ut_assert(rx_info()->length == 2);
+        ut_assert(rx_data()[0] == 0x01);
+        ut_assert(rx_data()[1] == 0xFE);
+    }
+
+    // Data which wraps around the end of the UART buffer is decoded from two
+    // spans
+    {
+        static const char in[] = "00112233445566778899AABBCCDDEEFF\r\n";
+        reset_radio(SERCOM_UART_IN_BUFFER_LEN - 7);
+        feed_uart(in, sizeof(in) - 1);
+        run_decoder(rn2483_case_rx_data_wait);
+
+        ut_assert(test_radio.state == RN2483_GET_SNR);
+        ut_assert(rx_info()->length == 16);
+        for (int i = 0; i < 16; i++) {
+            ut_assert(rx_data()[i] == (i * 0x11));
+        }
+        ut_assert(circular_buffer_is_empty(&test_uart.in_buffer));
+    }
+
+    // Odd number of digits
+    {
+        reset_radio(0);
+        feed_uart("ABC\r\n", 5);
+        run_decoder(rn2483_case_rx_data_wait);
+        ut_assert(test_radio.state == RN2483_FAILED);
+    }
+
+    // Character which is not a hexadecimal digit
+    {
+        reset_radio(0);
+        feed_uart("AB0G\r\n", 6);
+        run_decoder(rn2483_case_rx_data_wait);
+        ut_assert(test_radio.state == RN2483_FAILED);
+    }
+
+    // Backwards line ending
+    {
+        reset_radio(0);
+        feed_uart("AB\n\r", 4);
+        run_decoder(rn2483_case_rx_data_wait);
+        ut_assert(test_radio.state == RN2483_FAILED);
+    }
+
+    // Data which is overwritten in the UART input buffer while it is being
+    // decoded, the rest of the line is skipped and the packet is dropped
+    // without failing the radio
+    {
+        reset_radio(0);
+        test_radio.receive = 1;
+        feed_uart("4865", 4);
+        uart_data_overwritten = 1;
+        run_decoder(rn2483_case_rx_data_wait);
+        ut_assert(test_radio.state == RN2483_RX_DATA_WAIT);
+        ut_assert(rx_info()->discard);
+
+        feed_uart("6C6C6F\r\nok", 10);
+        run_decoder(rn2483_case_rx_data_wait);
+        ut_assert(test_radio.state == RN2483_IDLE);
+        ut_assert(circular_buffer_capacity(&test_uart.in_buffer) -
+                  circular_buffer_unused(&test_uart.in_buffer) == 2);
+    }
+
+    // Bad characters that come from data being overwritten do not fail the
+    // radio
+    {
+        reset_radio(0);
+        test_radio.receive = 1;
+        feed_uart("AB\n\r", 4);
+        uart_data_overwritten = 1;
+        run_decoder(rn2483_case_rx_data_wait);
+        ut_assert(test_radio.state == RN2483_RX_DATA_WAIT);
+        feed_uart("\n", 1);
+        run_decoder(rn2483_case_rx_data_wait);
+        ut_assert(test_radio.state == RN2483_IDLE);
+    }
+
+    // Packet which is too long for the instance buffer, extra bytes are
+    // dropped
+    {
+        char in[64];
+        memset(in, 'a', sizeof(in));
+        reset_radio(0);
+        for (int i = 0; i < 10; i++) {
+            feed_uart(in, sizeof(in));
+            run_decoder(rn2483_case_rx_data_wait);
+        }
+        feed_uart("\r\n", 2);
+        run_decoder(rn2483_case_rx_data_wait);
+
+        ut_assert(test_radio.state == RN2483_GET_SNR);
+        ut_assert(rx_info()->length == RN2483_RX_MAX_LENGTH);
+        ut_assert(rx_data()[RN2483_RX_MAX_LENGTH - 1] == 0xAA);
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,76 @@
+#include "rn2483_states_stubs.c"
+
+#include <time.h>
+
+/*
+ *  Benchmark for decoding radio_rx data. A 128 byte packet is decoded by
+ *  rn2483_case_rx_data_wait() and the legacy character at a time decoder,
+ *  with the encoded packet placed in the UART buffer in 64 character chunks
+ *  as it would be by the UART receive DMA. On the host the critical sections
+ *  in the circular buffer are free, so the legacy decoder's cost per
+ *  character is understated.
+ */
+
+#define BENCH_PACKET_LEN    128
+#define BENCH_CHUNK_LEN     64
+#define BENCH_PACKETS       20000
+
+static char encoded[(BENCH_PACKET_LEN * 2) + 2];
+
+static double elapsed_seconds(struct timespec const *start,
+                              struct timespec const *end)
+{
+    return ((double)(end->tv_sec - start->tv_sec) +
+            ((double)(end->tv_nsec - start->tv_nsec) / 1e9));
+}
+
+static double bench(rx_decoder_t decoder, uint32_t *checksum)
+{
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t p = 0; p < BENCH_PACKETS; p++) {
+        reset_radio((uint16_t)p);
+        for (uint16_t fed = 0; fed < sizeof(encoded);) {
+            uint16_t chunk = BENCH_CHUNK_LEN;
+            if (chunk > (sizeof(encoded) - fed)) {
+                chunk = sizeof(encoded) - fed;
+            }
+            fed += feed_uart(encoded + fed, chunk);
+            run_decoder(decoder);
+        }
+        ut_assert(test_radio.state == RN2483_GET_SNR);
+        *checksum += (uint8_t)test_radio.buffer[RN2483_RX_DATA_OFFSET +
+                                                 (p % BENCH_PACKET_LEN)];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return elapsed_seconds(&start, &end);
+}
+
+int main (int argc, char **argv)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    for (int i = 0; i < BENCH_PACKET_LEN; i++) {
+        uint8_t const b = (uint8_t)((i * 37) + 11);
+        encoded[2 * i] = digits[b >> 4];
+        encoded[(2 * i) + 1] = digits[b & 0xF];
+    }
+    encoded[BENCH_PACKET_LEN * 2] = '\r';
+    encoded[(BENCH_PACKET_LEN * 2) + 1] = '\n';
+
+    uint32_t legacy_checksum = 0;
+    uint32_t span_checksum = 0;
+    double const legacy_time = bench(legacy_rx_data_wait, &legacy_checksum);
+    double const span_time = bench(rn2483_case_rx_data_wait, &span_checksum);
+
+    ut_assert(legacy_checksum == span_checksum);
+
+    printf("legacy decoder: %8.1f ns/packet\n",
+           (legacy_time * 1e9) / BENCH_PACKETS);
+    printf("span decoder:   %8.1f ns/packet\n",
+           (span_time * 1e9) / BENCH_PACKETS);
+    printf("speedup:        %8.1fx\n", legacy_time / span_time);
+
+    return UT_PASS;
+}
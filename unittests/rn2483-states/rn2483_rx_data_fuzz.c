@@ -0,0 +1,149 @@
+#include "rn2483_states_stubs.c"
+
+/*
+ *  Fuzz test which compares rn2483_case_rx_data_wait() against the legacy
+ *  character at a time decoder. Mostly valid radio_rx data is generated with
+ *  random mutations and fed to each decoder in the same randomly sized chunks
+ *  starting at a random position in the UART buffer. Both decoders must end
+ *  up in the same state with the same data and leave the same number of
+ *  characters in the UART buffer.
+ */
+
+#define FUZZ_ITERATIONS     20000
+#define FUZZ_MAX_INPUT      700
+
+struct decode_result {
+    uint8_t data[RN2483_BUFFER_LEN];
+    uint16_t remaining;
+    uint8_t length;
+    uint8_t have_leftover;
+    enum rn2483_state state;
+};
+
+static uint32_t rng_state;
+
+static uint32_t rng(void)
+{
+    // xorshift32
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void decode(rx_decoder_t decoder, const char *in, uint16_t length,
+                   uint32_t seed, struct decode_result *result)
+{
+    rng_state = seed;
+    reset_radio((uint16_t)rng());
+
+    uint16_t fed = 0;
+    while ((fed < length) && (test_radio.state == RN2483_RX_DATA_WAIT)) {
+        uint16_t chunk = (uint16_t)(1 + (rng() % 80));
+        if (chunk > (length - fed)) {
+            chunk = length - fed;
+        }
+        fed += feed_uart(in + fed, chunk);
+        run_decoder(decoder);
+    }
+
+    const struct rn2483_rx_info *const info =
+                                (const struct rn2483_rx_info*)test_radio.buffer;
+    memcpy(result->data, test_radio.buffer + RN2483_RX_DATA_OFFSET,
+           info->length);
+    result->length = info->length;
+    result->have_leftover = info->have_leftover;
+    result->state = test_radio.state;
+    result->remaining = (uint16_t)(length - fed +
+                                circular_buffer_capacity(&test_uart.in_buffer) -
+                                circular_buffer_unused(&test_uart.in_buffer));
+}
+
+static uint16_t generate(char *in)
+{
+    static const char digits[] = "0123456789ABCDEFabcdef";
+    static const char noise[] = " \r\nGgXz-0F";
+
+    uint16_t const bytes = (uint16_t)(rng() % 300);
+    uint16_t len = 0;
+    for (uint16_t i = 0; (i < bytes) && (len < (FUZZ_MAX_INPUT - 8)); i++) {
+        in[len++] = digits[rng() % (sizeof(digits) - 1)];
+        if ((rng() % 64) == 0) {
+            in[len++] = ' ';
+        }
+        in[len++] = digits[rng() % (sizeof(digits) - 1)];
+    }
+    in[len++] = '\r';
+    in[len++] = '\n';
+    in[len++] = 'o';
+    in[len++] = 'k';
+
+    // Mutate about half of the inputs
+    if (rng() & 1) {
+        uint16_t const num_mutations = (uint16_t)(1 + (rng() % 3));
+        for (uint16_t i = 0; i < num_mutations; i++) {
+            uint16_t const pos = (uint16_t)(rng() % len);
+            switch (rng() % 3) {
+                case 0:
+                    // Replace a character
+                    in[pos] = noise[rng() % (sizeof(noise) - 1)];
+                    break;
+                case 1:
+                    // Remove a character
+                    memmove(in + pos, in + pos + 1, len - pos - 1);
+                    len--;
+                    break;
+                default:
+                    // Insert a character
+                    if (len < FUZZ_MAX_INPUT) {
+                        memmove(in + pos + 1, in + pos, len - pos);
+                        in[pos] = noise[rng() % (sizeof(noise) - 1)];
+                        len++;
+                    }
+                    break;
+            }
+        }
+    }
+
+    return len;
+}
+
+int main (int argc, char **argv)
+{
+    static char in[FUZZ_MAX_INPUT];
+    static struct decode_result legacy;
+    static struct decode_result span;
+    uint32_t num_complete = 0;
+    uint32_t num_failed = 0;
+
+    uint32_t gen_state = 0x2483;
+    for (uint32_t i = 0; i < FUZZ_ITERATIONS; i++) {
+        rng_state = gen_state;
+        uint16_t const len = generate(in);
+        uint32_t const seed = rng() | 1;
+        gen_state = rng();
+
+        decode(legacy_rx_data_wait, in, len, seed, &legacy);
+        decode(rn2483_case_rx_data_wait, in, len, seed, &span);
+
+        ut_assert(span.state == legacy.state);
+        ut_assert(span.remaining == legacy.remaining);
+        if (span.state == RN2483_FAILED) {
+            num_failed++;
+            continue;
+        }
+        ut_assert(span.length == legacy.length);
+        ut_assert(!memcmp(span.data, legacy.data, span.length));
+        if (span.state == RN2483_GET_SNR) {
+            num_complete++;
+        } else {
+            ut_assert(span.have_leftover == legacy.have_leftover);
+        }
+    }
+
+    // Make sure that both outcomes were actually exercised
+    ut_assert(num_complete > (FUZZ_ITERATIONS / 4));
+    ut_assert(num_failed > (FUZZ_ITERATIONS / 8));
+
+    return UT_PASS;
+}
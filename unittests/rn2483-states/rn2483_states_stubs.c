@@ -0,0 +1,331 @@
+#include <unittest.h>
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ *  Stubs for symbols used by the RN2483 state handlers and a copy of the
+ *  character at a time receive data decoder that the span based decoder
+ *  replaced.
+ *
+ *  This file is ment to be included into other tests. The legacy decoder
+ *  writes each byte at the offset for that byte and stops storing bytes at the
+ *  same length as the new decoder. As it was originally written every byte was
+ *  stored at the same offset.
+ */
+
+char *utoa(unsigned value, char *str, int base);
+char *itoa(int value, char *str, int base);
+
+static inline void stub_disable_irq(void) { }
+static inline void stub_enable_irq(void) { }
+
+#define __disable_irq stub_disable_irq
+#define __enable_irq stub_enable_irq
+#include SOURCE_C
+#undef __disable_irq
+#undef __enable_irq
+
+volatile uint32_t millis;
+
+static struct sercom_uart_desc_t test_uart;
+static struct rn2483_desc_t test_radio;
+
+char *utoa(unsigned value, char *str, int base)
+{
+    sprintf(str, "%u", value);
+    return str;
+}
+
+char *itoa(int value, char *str, int base)
+{
+    sprintf(str, "%d", value);
+    return str;
+}
+
+enum rn2483_send_trans_state rn2483_get_send_state(struct rn2483_desc_t *inst,
+                                                   uint8_t transaction_id)
+{
+    return RN2483_SEND_TRANS_INVALID;
+}
+
+uint16_t sercom_uart_put_string(struct sercom_uart_desc_t *uart,
+                                const char *str)
+{
+    return (uint16_t)strlen(str);
+}
+
+uint16_t sercom_uart_put_hex(struct sercom_uart_desc_t *uart,
+                             const uint8_t *bytes, uint16_t length)
+{
+    return length;
+}
+
+void sercom_uart_put_char(struct sercom_uart_desc_t *uart, char c)
+{
+}
+
+void sercom_uart_send_break(struct sercom_uart_desc_t *uart, uint8_t duration)
+{
+}
+
+uint8_t sercom_uart_out_buffer_empty(struct sercom_uart_desc_t *uart)
+{
+    return 1;
+}
+
+uint8_t sercom_uart_has_delim(struct sercom_uart_desc_t *uart, char delim)
+{
+    return 0;
+}
+
+uint8_t sercom_uart_has_line(struct sercom_uart_desc_t *uart)
+{
+    return 0;
+}
+
+void sercom_uart_get_line_delim(struct sercom_uart_desc_t *uart, char delim,
+                                char *str, uint16_t len)
+{
+    str[0] = '\0';
+}
+
+void sercom_uart_get_line(struct sercom_uart_desc_t *uart, char *str,
+                          uint16_t len)
+{
+    str[0] = '\0';
+}
+
+uint16_t sercom_uart_get_received(struct sercom_uart_desc_t *uart,
+                                  const uint8_t **data)
+{
+    uint8_t *head;
+    uint16_t const length = circular_buffer_get_head(&uart->in_buffer, &head);
+    *data = head;
+    return length;
+}
+
+/** Set to make the next call to sercom_uart_consume() report that the data
+    was overwritten while it was being parsed */
+static uint8_t uart_data_overwritten;
+
+uint8_t sercom_uart_consume(struct sercom_uart_desc_t *uart, uint16_t length)
+{
+    circular_buffer_move_head(&uart->in_buffer, length);
+
+    uint8_t const overwritten = uart_data_overwritten;
+    uart_data_overwritten = 0;
+    return overwritten;
+}
+
+void sercom_uart_get_string(struct sercom_uart_desc_t *uart, char *str,
+                            uint16_t len)
+{
+    for (uint16_t i = 0; i < (len - 1); i++) {
+        if (circular_buffer_pop(&uart->in_buffer, (uint8_t*)(str + i))) {
+            str[i] = '\0';
+            return;
+        }
+    }
+    str[len - 1] = '\0';
+}
+
+static uint8_t legacy_parse_nibble (char c, uint8_t *dest, int offset)
+{
+    if (c < '0') {
+        return 1;
+    } else if (c >= 'a') {
+        c -= 32;
+    }
+    c -= '0';
+    if (c <= 9) {
+        goto store_nibble;
+    }
+    c -= 7;
+    if (c <= 9) {
+        return 1;
+    } else if (c <= 15) {
+        goto store_nibble;
+    }
+    return 1;
+store_nibble:
+    *dest |= (c << offset);
+    return 0;
+}
+
+static int legacy_rx_data_wait (struct rn2483_desc_t *inst)
+{
+    struct rn2483_rx_info *const rx_info = (struct rn2483_rx_info*)inst->buffer;
+    // Keep trying to get more bytes and parse them until we run out of bytes in
+    // the uart's rx buffer
+    uint8_t chars_in;
+    uint8_t new_char;
+    char rx_data[3];
+    do {
+        // Get up to the next two bytes of data from the uart in buffer
+        sercom_uart_get_string(inst->uart, rx_data, 2);
+        chars_in = strlen(rx_data);
+
+        if (chars_in == 0) {
+            // No new data to parse
+            break;
+        }
+
+        // Skip spaces and determine how many new usable char we have
+        if ((chars_in == 1) && (rx_data[0] == ' ')) {
+            // The only char we got was a space, no new data to parse
+            break;
+        } else if ((chars_in == 2) && (rx_data[0] == ' ') &&
+                   (rx_data[1] == ' ')) {
+            // The only two new chars we got where spaces, no new data to parse
+            // (but since we got a full two chars there could be more chars in
+            // the uart buffer)
+            continue;
+        } else if ((chars_in == 2) && (rx_data[0] == ' ')) {
+            // The first char we got is a space but the second one is good,
+            // shift the second char over and pretend we never received the
+            // first one
+            rx_data[0] = rx_data[1];
+            new_char = 1;
+        } else if ((chars_in == 2) && (rx_data[1] == ' ')) {
+            // The second char we got is a space, set new_chars to 1 and pretend
+            // we never received the second one
+            new_char = 1;
+        } else {
+            // All of the chars we got from the buffer are not spaces
+            new_char = chars_in;
+        }
+
+        if (!rx_info->have_leftover && (new_char == 1)) {
+            // We only have one char to work with, just store it as a leftover
+            // for next time
+            rx_info->leftover = rx_data[0];
+            rx_info->have_leftover = 1;
+            break;
+        }
+
+        // At this point we have two chars to work with. We should be able to
+        // parse out a byte of received data (or find the end of the line).
+
+        // Identify our high and low chars
+        char high_char;
+        char low_char;
+        if (rx_info->have_leftover) {
+            high_char = rx_info->leftover;
+            low_char = rx_data[0];
+            if (new_char == 2) {
+                // We have a char left over for next time
+                rx_info->leftover = rx_data[1];
+            } else {
+                rx_info->have_leftover = 0;
+            }
+        } else {
+            high_char = rx_data[0];
+            low_char = rx_data[1];
+        }
+
+        // Check if we have a newline
+        if ((high_char == '\r') && (low_char == '\n')) {
+            // That's all the data, get the SNR now
+            inst->state = RN2483_GET_SNR;
+            return 1;
+        } else if (!isxdigit(high_char) || !isxdigit(low_char)) {
+            // If our pair of chars is not a newline and either of our chars are
+            // not a hexadecimal digit a few different things are could be going
+            // on:
+            //      - We received an odd number of hexadecimal digits before the
+            //        newline so we are now looking at a valid digit and a
+            //        carriage return together
+            //      - We received a character that is neither a valid digit, a
+            //        carriage return nor a newline
+            //      - The carriage return and newline are backwards
+            //      - We received a a carriage return and then something after
+            //        it that was not a newline
+            // No matter what it is, something has gone very wrong and we can't
+            // keep parsing the data. Because we don't know what the radio might
+            // send next (we could still be in the middle of a line) we need to
+            // go straight to the failed state.
+            inst->state = RN2483_FAILED;
+            return 0;
+        }
+
+        // Calculate where we should be putting the next received byte
+        const uint16_t offset = RN2483_RX_DATA_OFFSET + rx_info->length;
+
+        if (rx_info->length >= RN2483_RX_MAX_LENGTH) {
+            // We have a valid byte to parse, but there is no space left in the
+            // buffer. We don't have a lot of options here, but in the interest
+            // of not crashing the radio driver if we receive a packet that is
+            // too big we are going to just ignore any bytes that don't fit in
+            // the buffer and pretend that they never happened
+            continue;
+        } else {
+            // We have a valid byte to parse and space for it in the buffer
+            inst->buffer[offset] = 0;
+            uint8_t ret = legacy_parse_nibble(high_char,
+                                       (uint8_t*)&inst->buffer[offset], 4);
+            ret |= legacy_parse_nibble(low_char, (uint8_t*)&inst->buffer[offset], 0);
+            if (ret != 0) {
+                // This should never happen because we already checked that
+                // both of our bytes are valid hex chars
+                inst->state = RN2483_FAILED;
+                return 0;
+            }
+            rx_info->length++;
+        }
+    } while (chars_in == 2);
+
+    return 0;
+}
+
+typedef int (*rx_decoder_t)(struct rn2483_desc_t *inst);
+
+/**
+ *  Reset the test radio to the start of the receive data wait state with an
+ *  empty UART input buffer whose head is at the given position.
+ */
+static void reset_radio(uint16_t head_pos)
+{
+    memset(&test_uart, 0, sizeof(test_uart));
+    init_circular_buffer(&test_uart.in_buffer,
+                         (uint8_t*)test_uart.in_buffer_mem,
+                         SERCOM_UART_IN_BUFFER_LEN);
+    test_uart.in_buffer.head = head_pos % SERCOM_UART_IN_BUFFER_LEN;
+    test_uart.in_buffer.tail = head_pos % SERCOM_UART_IN_BUFFER_LEN;
+
+    memset(&test_radio, 0, sizeof(test_radio));
+    test_radio.uart = &test_uart;
+    test_radio.state = RN2483_RX_DATA_WAIT;
+}
+
+/**
+ *  Place up to length characters in the UART input buffer.
+ *
+ *  @return The number of characters placed in the buffer
+ */
+static uint16_t feed_uart(const char *str, uint16_t length)
+{
+    uint16_t i = 0;
+    for (; (i < length) && !circular_buffer_is_full(&test_uart.in_buffer);
+         i++) {
+        circular_buffer_push(&test_uart.in_buffer, (uint8_t)str[i]);
+    }
+    return i;
+}
+
+/**
+ *  Run a decoder until it leaves the receive data wait state or stops making
+ *  progress.
+ */
+static void run_decoder(rx_decoder_t decoder)
+{
+    while (test_radio.state == RN2483_RX_DATA_WAIT) {
+        uint16_t const unused = circular_buffer_unused(&test_uart.in_buffer);
+        if (!decoder(&test_radio) &&
+                (circular_buffer_unused(&test_uart.in_buffer) == unused)) {
+            // The decoder did not use any characters
+            break;
+        }
+    }
+}
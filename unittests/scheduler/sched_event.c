@@ -0,0 +1,53 @@
+#include "sched_stubs.c"
+
+/*
+ *  sched_event_add_task() and sched_event_signal() let a driver mark every
+ *  task which waits on it ready from an interrupt or callback.
+ */
+
+int main (int argc, char **argv)
+{
+    struct sched_task_t service, client, other;
+    int service_runs = 0, client_runs = 0, other_runs = 0;
+    struct sched_event_t event = { .num_tasks = 0 };
+
+    reset_scheduler();
+    sched_add_task(&service, counting_task, &service_runs, "service", 0, 0);
+    sched_add_task(&client, counting_task, &client_runs, "client", 0, 0);
+    sched_add_task(&other, counting_task, &other_runs, "other", 0, 0);
+
+    // Signalling an event with no tasks does nothing
+    sched_event_signal(&event);
+    ut_assert(!sched_pending_g);
+
+    // Adding a task twice only adds it once
+    ut_assert(sched_event_add_task(&event, &service) == 0);
+    ut_assert(sched_event_add_task(&event, &client) == 0);
+    ut_assert(sched_event_add_task(&event, &service) == 0);
+    ut_assert(event.num_tasks == 2);
+
+    // Every task for the event is run once after it is signalled
+    sched_event_signal(&event);
+    ut_assert(sched_pending_g);
+    ut_assert(service.ready);
+    ut_assert(client.ready);
+    ut_assert(!other.ready);
+    sched_run();
+    ut_assert(service_runs == 1);
+    ut_assert(client_runs == 1);
+    ut_assert(other_runs == 0);
+    sched_run();
+    ut_assert(service_runs == 1);
+    ut_assert(client_runs == 1);
+
+    // An event can only wake a limited number of tasks
+    struct sched_task_t extra[SCHED_EVENT_MAX_TASKS];
+    for (int i = 0; i < (SCHED_EVENT_MAX_TASKS - 2); i++) {
+        ut_assert(sched_event_add_task(&event, &extra[i]) == 0);
+    }
+    ut_assert(event.num_tasks == SCHED_EVENT_MAX_TASKS);
+    ut_assert(sched_event_add_task(&event, &other) == 1);
+    ut_assert(event.num_tasks == SCHED_EVENT_MAX_TASKS);
+
+    return UT_PASS;
+}
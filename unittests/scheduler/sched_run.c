@@ -0,0 +1,109 @@
+#include "sched_stubs.c"
+
+/*
+ *  sched_run() runs polled tasks on every pass, event tasks only after they
+ *  have been marked ready and periodic tasks when their period has elapsed.
+ */
+
+static struct sched_task_t *mark_target;
+
+static void marking_task(void *context)
+{
+    (*(int *)context)++;
+    // Marking another task ready from a task is seen on the same pass if the
+    // other task is later in the list and on the next pass otherwise
+    sched_mark_ready(mark_target);
+}
+
+int main (int argc, char **argv)
+{
+    struct sched_task_t polled, event, periodic;
+    int polled_runs = 0, event_runs = 0, periodic_runs = 0;
+
+    reset_scheduler();
+    sched_add_task(&polled, counting_task, &polled_runs, "polled", 0, 1);
+    sched_add_task(&event, counting_task, &event_runs, "event", 0, 0);
+    sched_add_task(&periodic, counting_task, &periodic_runs, "periodic", 100,
+                   0);
+
+    // Tasks are kept in the order they were added
+    ut_assert(sched_get_tasks() == &polled);
+    ut_assert(polled.next == &event);
+    ut_assert(event.next == &periodic);
+    ut_assert(periodic.next == NULL);
+
+    // Only the polled task has work to do
+    sched_run();
+    ut_assert(polled_runs == 1);
+    ut_assert(event_runs == 0);
+    ut_assert(periodic_runs == 0);
+
+    // Marking a task ready runs it once
+    sched_mark_ready(&event);
+    ut_assert(sched_pending_g);
+    sched_run();
+    ut_assert(!sched_pending_g);
+    ut_assert(event_runs == 1);
+    ut_assert(!event.ready);
+    sched_run();
+    ut_assert(event_runs == 1);
+    ut_assert(polled_runs == 3);
+
+    // Periodic task runs once its period has elapsed and then stays on its
+    // original schedule
+    millis = 99;
+    sched_run();
+    ut_assert(periodic_runs == 0);
+    millis = 105;
+    sched_run();
+    ut_assert(periodic_runs == 1);
+    ut_assert(periodic.next_run == 200);
+    millis = 150;
+    sched_run();
+    ut_assert(periodic_runs == 1);
+    millis = 200;
+    sched_run();
+    ut_assert(periodic_runs == 2);
+
+    // Runs which were missed are skipped rather than run back to back
+    millis = 1000;
+    sched_run();
+    ut_assert(periodic_runs == 3);
+    ut_assert(periodic.next_run == 1100);
+    sched_run();
+    ut_assert(periodic_runs == 3);
+
+    // Run time accounting
+    ut_assert(polled.run_time.count == 9);
+    ut_assert(polled.run_time.total == 90);
+    ut_assert(polled.run_time.max == 10);
+    ut_assert(periodic.run_time.count == 3);
+    ut_assert(periodic.run_time.total == 30);
+    ut_assert(sched_get_stats()->pass_time.count == 9);
+    ut_assert(sched_get_stats()->pass_time.total == 130);
+
+    sched_clear_stats();
+    ut_assert(polled.run_time.count == 0);
+    ut_assert(polled.run_time.total == 0);
+    ut_assert(polled.run_time.max == 0);
+    ut_assert(sched_get_stats()->pass_time.count == 0);
+    ut_assert(sched_get_stats()->pass_time.total == 0);
+
+    // A task marked ready by an earlier task runs in the same pass, a task
+    // marked ready by a later task runs in the next pass and keeps the main
+    // loop from sleeping in between
+    struct sched_task_t first, marker;
+    int first_runs = 0, marker_runs = 0;
+    reset_scheduler();
+    sched_add_task(&first, counting_task, &first_runs, "first", 0, 0);
+    sched_add_task(&marker, marking_task, &marker_runs, "marker", 0, 1);
+    mark_target = &first;
+    sched_run();
+    ut_assert(marker_runs == 1);
+    ut_assert(first_runs == 0);
+    ut_assert(sched_pending_g);
+    sched_run();
+    ut_assert(first_runs == 1);
+
+    return UT_PASS;
+}
@@ -0,0 +1,43 @@
+#include "sched_stubs.c"
+
+/*
+ *  sched_sleep() only sleeps when sleep is not inhibited and no task has been
+ *  marked ready since the last pass through the task list.
+ */
+
+int main (int argc, char **argv)
+{
+    struct sched_task_t event;
+    int event_runs = 0;
+
+    reset_scheduler();
+    sched_add_task(&event, counting_task, &event_runs, "event", 0, 0);
+
+    // Nothing to do
+    sched_run();
+    sched_sleep();
+    ut_assert(wfi_count == 1);
+    ut_assert(!irq_disabled);
+    ut_assert(sched_get_stats()->sleep_time == 500);
+
+    // A task has been marked ready, it must be run before sleeping
+    sched_mark_ready(&event);
+    sched_sleep();
+    ut_assert(wfi_count == 1);
+    ut_assert(!irq_disabled);
+    sched_run();
+    ut_assert(event_runs == 1);
+    sched_sleep();
+    ut_assert(wfi_count == 2);
+
+    // Sleep is inhibited
+    inhibit_sleep_g = 1;
+    sched_sleep();
+    ut_assert(wfi_count == 2);
+    inhibit_sleep_g = 0;
+    sched_sleep();
+    ut_assert(wfi_count == 3);
+    ut_assert(sched_get_stats()->sleep_time == 1500);
+
+    return UT_PASS;
+}
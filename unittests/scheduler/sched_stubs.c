@@ -0,0 +1,80 @@
+#include <unittest.h>
+
+#include <string.h>
+
+static int irq_disabled;
+static int wfi_count;
+
+static inline void stub_disable_irq(void) { irq_disabled = 1; }
+static inline void stub_enable_irq(void) { irq_disabled = 0; }
+
+static uint32_t stub_ticks;
+
+static inline void stub_wfi(void)
+{
+    // Interrupts must be masked so that no task can be marked ready between
+    // checking for pending tasks and going to sleep
+    ut_assert(irq_disabled);
+    wfi_count++;
+    stub_ticks += 500;
+}
+
+#define __disable_irq stub_disable_irq
+#define __enable_irq stub_enable_irq
+#undef __WFI
+#define __WFI stub_wfi
+#include SOURCE_C
+#undef __disable_irq
+#undef __enable_irq
+#undef __WFI
+
+/*
+ *  Stubs and helpers for testing the scheduler on the host.
+ *
+ *  This file is ment to be included into other tests. Each task function
+ *  counts its runs in the integer pointed to by its context and advances the
+ *  fake profiler clock so that run time accounting can be checked.
+ */
+
+volatile uint32_t millis;
+volatile uint8_t inhibit_sleep_g;
+
+uint32_t profiler_now(void)
+{
+    return stub_ticks;
+}
+
+void profiler_hist_record(struct profiler_hist_t *hist, uint32_t value)
+{
+    if ((hist->count == 0) || (value < hist->min)) {
+        hist->min = value;
+    }
+    if (value > hist->max) {
+        hist->max = value;
+    }
+    hist->total += value;
+    hist->count++;
+}
+
+void profiler_hist_clear(struct profiler_hist_t *hist)
+{
+    memset(hist, 0, sizeof(*hist));
+}
+
+static void reset_scheduler(void)
+{
+    sched_head = NULL;
+    sched_tail = NULL;
+    sched_pending_g = 0;
+    sched_clear_stats();
+    millis = 0;
+    inhibit_sleep_g = 0;
+    stub_ticks = 0;
+    wfi_count = 0;
+}
+
+static void counting_task(void *context)
+{
+    (*(int *)context)++;
+    stub_ticks += 10;
+}
@@ -0,0 +1,88 @@
+#include <unittest.h>
+#include SOURCE_C
+
+#include <string.h>
+
+/*
+ *  sdspi_crc_16() calculates the CRC which is sent after every SD card data
+ *  block. The same CRC can be calculated by the DMAC CRC engine as a block is
+ *  transfered, in which case any bytes that were received before the DMA
+ *  transfer started are run through sdspi_crc_16() first and the result is
+ *  used to seed the CRC engine. Both paths need to agree exactly.
+ */
+
+#define NUM_RANDOM_BLOCKS   64
+#define BLOCK_SIZE          512
+
+/**
+ *  Bit serial model of the DMAC CRC-16 engine (CRC-CCITT, MSB first) as
+ *  described in section 19.6.3.7 of the SAMD21 datasheet. Each byte beat is
+ *  shifted into the checksum register which starts at the seeded value.
+ */
+static uint16_t dmac_crc16_model(uint16_t chksum, uint8_t const *data,
+                                 size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        for (int bit = 7; bit >= 0; bit--) {
+            uint8_t const in = (uint8_t)((data[i] >> bit) & 1);
+            uint8_t const msb = (uint8_t)(chksum >> 15);
+            chksum = (uint16_t)(chksum << 1);
+            if (msb ^ in) {
+                chksum ^= 0x1021;
+            }
+        }
+    }
+
+    return chksum;
+}
+
+
+int main (int argc, char **argv)
+{
+    // Standard check value for CRC-16/XMODEM
+    {
+        uint8_t const msg[] = "123456789";
+        ut_assert(sdspi_crc_16(0, msg, 9) == 0x31C3);
+        ut_assert(dmac_crc16_model(0, msg, 9) == 0x31C3);
+    }
+
+    // A block of 0xFF bytes, example from section 4.5 of the SD Card Physical
+    // Layer Simplified Specification
+    {
+        uint8_t block[BLOCK_SIZE];
+        memset(block, 0xFF, sizeof(block));
+        ut_assert(sdspi_crc_16(0, block, sizeof(block)) == 0x7FA1);
+    }
+
+    // Zero length message
+    ut_assert(sdspi_crc_16(0, NULL, 0) == 0);
+    ut_assert(sdspi_crc_16(0x1234, NULL, 0) == 0x1234);
+
+    // Random blocks, check that the lookup table matches the DMAC model and
+    // that the calculation can be handed from software to the DMAC at any
+    // offset (as happens when part of a block is received with the start
+    // token)
+    srand(0x5D5D);
+    for (int n = 0; n < NUM_RANDOM_BLOCKS; n++) {
+        uint8_t block[BLOCK_SIZE];
+        for (size_t i = 0; i < sizeof(block); i++) {
+            block[i] = (uint8_t)rand();
+        }
+
+        uint16_t const expected = dmac_crc16_model(0, block, sizeof(block));
+        ut_assert(sdspi_crc_16(0, block, sizeof(block)) == expected);
+
+        for (size_t split = 0; split <= 16; split++) {
+            uint16_t const seed = sdspi_crc_16(0, block, split);
+            ut_assert(dmac_crc16_model(seed, block + split,
+                                       sizeof(block) - split) == expected);
+        }
+
+        size_t const split = (size_t)rand() % sizeof(block);
+        uint16_t const seed = sdspi_crc_16(0, block, split);
+        ut_assert(sdspi_crc_16(seed, block + split,
+                               sizeof(block) - split) == expected);
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,42 @@
+#include <unittest.h>
+#include SOURCE_C
+
+/*
+ *  sdspi_crc_7() calculates the CRC which is sent at the end of every SD card
+ *  command. The expected values are taken from the example command frames in
+ *  section 4.5 of the SD Card Physical Layer Simplified Specification.
+ */
+
+
+int main (int argc, char **argv)
+{
+    // CMD0 with argument 0, this is the reset command that every card must
+    // accept with a valid CRC
+    {
+        uint8_t const cmd[] = { 0x40, 0x00, 0x00, 0x00, 0x00 };
+        ut_assert(sdspi_crc_7(cmd, sizeof(cmd)) == 0x4A);
+    }
+
+    // CMD17 with argument 0
+    {
+        uint8_t const cmd[] = { 0x51, 0x00, 0x00, 0x00, 0x00 };
+        ut_assert(sdspi_crc_7(cmd, sizeof(cmd)) == 0x2A);
+    }
+
+    // Response to CMD17 with argument 0
+    {
+        uint8_t const cmd[] = { 0x11, 0x00, 0x00, 0x09, 0x00 };
+        ut_assert(sdspi_crc_7(cmd, sizeof(cmd)) == 0x33);
+    }
+
+    // CMD8 with the usual voltage range and check pattern
+    {
+        uint8_t const cmd[] = { 0x48, 0x00, 0x00, 0x01, 0xAA };
+        ut_assert(sdspi_crc_7(cmd, sizeof(cmd)) == 0x43);
+    }
+
+    // Zero length message
+    ut_assert(sdspi_crc_7(NULL, 0) == 0);
+
+    return UT_PASS;
+}
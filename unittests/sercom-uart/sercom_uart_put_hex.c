@@ -0,0 +1,115 @@
+#include "sercom_uart_stubs.c"
+
+/*
+ *  sercom_uart_put_hex() encodes a byte array as hexadecimal characters
+ *  directly into the free space in a UART's output buffer. It only ever queues
+ *  whole bytes and returns the number of bytes that were queued so that the
+ *  caller can resume encoding once there is more space in the buffer.
+ */
+
+static struct sercom_uart_desc_t uart;
+
+
+int main (int argc, char **argv)
+{
+    char out[SERCOM_UART_OUT_BUFFER_LEN + 1];
+
+    // Encode a few bytes into an empty buffer
+    {
+        init_test_uart(&uart);
+        uint8_t const data[] = { 0x01, 0xAB, 0xF0, 0x9C, 0x5E };
+        uint16_t ret = sercom_uart_put_hex(&uart, data, sizeof(data));
+
+        ut_assert(ret == 5);
+        ut_assert(drain_test_uart(&uart, out, sizeof(out)) == 10);
+        ut_assert(!strcmp(out, "01ABF09C5E"));
+        // Transmission should have been started
+        ut_assert(fake_sercom.USART.INTENSET.bit.DRE);
+    }
+
+    // Encode into a buffer where the free space wraps around the end with an
+    // odd number of contiguous bytes before the end of the buffer
+    {
+        init_test_uart(&uart);
+        uart.out_buffer.head = SERCOM_UART_OUT_BUFFER_LEN - 7;
+        uart.out_buffer.tail = SERCOM_UART_OUT_BUFFER_LEN - 7;
+        uint8_t const data[] = { 0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC };
+        uint16_t ret = sercom_uart_put_hex(&uart, data, sizeof(data));
+
+        ut_assert(ret == 6);
+        ut_assert(uart.out_buffer.length == 12);
+        ut_assert(uart.out_buffer.tail == 5);
+        ut_assert(drain_test_uart(&uart, out, sizeof(out)) == 12);
+        ut_assert(!strcmp(out, "123456789ABC"));
+    }
+
+    // Encode into a buffer where the free space wraps around the end with an
+    // even number of contiguous bytes before the end of the buffer
+    {
+        init_test_uart(&uart);
+        uart.out_buffer.head = SERCOM_UART_OUT_BUFFER_LEN - 4;
+        uart.out_buffer.tail = SERCOM_UART_OUT_BUFFER_LEN - 4;
+        uint8_t const data[] = { 0xDE, 0xAD, 0xBE, 0xEF };
+        uint16_t ret = sercom_uart_put_hex(&uart, data, sizeof(data));
+
+        ut_assert(ret == 4);
+        ut_assert(uart.out_buffer.tail == 4);
+        ut_assert(drain_test_uart(&uart, out, sizeof(out)) == 8);
+        ut_assert(!strcmp(out, "DEADBEEF"));
+    }
+
+    // Only enough space for some of the bytes, a byte that would only be half
+    // queued should not be queued at all
+    {
+        init_test_uart(&uart);
+        uart.out_buffer.length = SERCOM_UART_OUT_BUFFER_LEN - 5;
+        uart.out_buffer.tail = SERCOM_UART_OUT_BUFFER_LEN - 5;
+        uint8_t const data[] = { 0xAA, 0xBB, 0xCC };
+        uint16_t ret = sercom_uart_put_hex(&uart, data, sizeof(data));
+
+        ut_assert(ret == 2);
+        ut_assert(circular_buffer_unused(&uart.out_buffer) == 1);
+    }
+
+    // Full buffer
+    {
+        init_test_uart(&uart);
+        uart.out_buffer.length = SERCOM_UART_OUT_BUFFER_LEN;
+        uint8_t const data[] = { 0x00 };
+        uint16_t ret = sercom_uart_put_hex(&uart, data, sizeof(data));
+
+        ut_assert(ret == 0);
+        ut_assert(uart.out_buffer.length == SERCOM_UART_OUT_BUFFER_LEN);
+    }
+
+    // Resume a long encode as the buffer is drained
+    {
+        init_test_uart(&uart);
+        uint8_t data[300];
+        char expected[(2 * sizeof(data)) + 1];
+        for (uint16_t i = 0; i < sizeof(data); i++) {
+            data[i] = (uint8_t)(i * 7);
+            sprintf(expected + (2 * i), "%02X", data[i]);
+        }
+
+        char result[(2 * sizeof(data)) + 1];
+        uint16_t done = 0;
+        uint16_t result_len = 0;
+        int calls = 0;
+        while (done < sizeof(data)) {
+            done += sercom_uart_put_hex(&uart, data + done,
+                                        sizeof(data) - done);
+            calls++;
+            // Drain part of the buffer so that the head keeps moving
+            result_len += drain_test_uart(&uart, result + result_len, 100);
+        }
+        result_len += drain_test_uart(&uart, result + result_len,
+                                      (uint16_t)(sizeof(result) - result_len));
+
+        ut_assert(calls > 1);
+        ut_assert(result_len == (2 * sizeof(data)));
+        ut_assert(!strcmp(result, expected));
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,102 @@
+#include "sercom_uart_stubs.c"
+
+#include <time.h>
+
+/*
+ *  Benchmark for sercom_uart_put_hex(). The RN2483 driver used to queue each
+ *  hex character of a packet with a separate call to sercom_uart_put_string(),
+ *  which means that every nibble goes through the service function and a
+ *  critical section. This measures encoding throughput for maximum length
+ *  radio packets with both approaches and checks that the output matches.
+ */
+
+#define BENCH_PACKET_LEN    127
+#define BENCH_ITERATIONS    20000
+
+static struct sercom_uart_desc_t uart;
+
+/**
+ *  Queue a packet the way the RN2483 driver used to, one character at a time.
+ */
+static uint16_t put_hex_per_nibble(struct sercom_uart_desc_t *u,
+                                   uint8_t const *data, uint16_t length)
+{
+    uint16_t position = 0;
+    while (position < (length * 2)) {
+        uint8_t i = (uint8_t)(position / 2);
+        uint8_t shift = (position & 1) ? 0 : 4;
+
+        uint8_t nibble = (data[i] >> shift) & 0xF;
+        char str[2];
+        str[0] = (char)((nibble < 10) ? ('0' + nibble) : ('A' + nibble - 10));
+        str[1] = '\0';
+
+        if (sercom_uart_put_string(u, str) == 0) {
+            break;
+        }
+
+        position++;
+    }
+    return position / 2;
+}
+
+static double elapsed_seconds(struct timespec const *start,
+                              struct timespec const *end)
+{
+    return ((double)(end->tv_sec - start->tv_sec) +
+            ((double)(end->tv_nsec - start->tv_nsec) / 1e9));
+}
+
+
+int main (int argc, char **argv)
+{
+    uint8_t packet[BENCH_PACKET_LEN];
+    for (uint16_t i = 0; i < sizeof(packet); i++) {
+        packet[i] = (uint8_t)((i * 37) + 11);
+    }
+
+    char per_nibble_out[SERCOM_UART_OUT_BUFFER_LEN + 1];
+    char bulk_out[SERCOM_UART_OUT_BUFFER_LEN + 1];
+
+    // Check that both approaches give the same output
+    init_test_uart(&uart);
+    ut_assert(put_hex_per_nibble(&uart, packet, sizeof(packet)) ==
+                    sizeof(packet));
+    drain_test_uart(&uart, per_nibble_out, sizeof(per_nibble_out));
+
+    init_test_uart(&uart);
+    ut_assert(sercom_uart_put_hex(&uart, packet, sizeof(packet)) ==
+                    sizeof(packet));
+    drain_test_uart(&uart, bulk_out, sizeof(bulk_out));
+
+    ut_assert(!strcmp(per_nibble_out, bulk_out));
+
+    // Time both approaches. The buffer is cleared after each packet, the head
+    // is moved around so that the free space wraps like it would in practice.
+    struct timespec start, end;
+
+    init_test_uart(&uart);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int n = 0; n < BENCH_ITERATIONS; n++) {
+        put_hex_per_nibble(&uart, packet, sizeof(packet));
+        circular_buffer_move_head(&uart.out_buffer, SERCOM_UART_OUT_BUFFER_LEN);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double const per_nibble_time = elapsed_seconds(&start, &end);
+
+    init_test_uart(&uart);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int n = 0; n < BENCH_ITERATIONS; n++) {
+        sercom_uart_put_hex(&uart, packet, sizeof(packet));
+        circular_buffer_move_head(&uart.out_buffer, SERCOM_UART_OUT_BUFFER_LEN);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double const bulk_time = elapsed_seconds(&start, &end);
+
+    double const total_bytes = (double)BENCH_ITERATIONS * BENCH_PACKET_LEN;
+    printf("per nibble: %8.2f MB/s\n", total_bytes / per_nibble_time / 1e6);
+    printf("bulk:       %8.2f MB/s (%.1fx)\n", total_bytes / bulk_time / 1e6,
+           per_nibble_time / bulk_time);
+
+    return UT_PASS;
+}
@@ -0,0 +1,222 @@
+#include "sercom_uart_stubs.c"
+
+/*
+ *  sercom_uart_rx_dma_sync() moves the tail of a UART's input buffer up to the
+ *  position of the looping DMA transfer which receives data into the buffer's
+ *  memory. It is run by the consumer functions and the service function so
+ *  that data received by DMA becomes visible without any per byte interrupts.
+ */
+
+static struct sercom_uart_desc_t uart;
+
+/** Simulate the DMA receiving a string */
+static void dma_receive(char const *str)
+{
+    for (; *str != '\0'; str++) {
+        uint16_t const pos = ((SERCOM_UART_IN_BUFFER_LEN - dma_remaining_beats) %
+                              SERCOM_UART_IN_BUFFER_LEN);
+        uart.in_buffer_mem[pos] = *str;
+
+        dma_remaining_beats--;
+        if (dma_remaining_beats == 0) {
+            // Descriptor is reloaded
+            dma_remaining_beats = SERCOM_UART_IN_BUFFER_LEN;
+        }
+    }
+}
+
+
+int main (int argc, char **argv)
+{
+    char line[SERCOM_UART_IN_BUFFER_LEN];
+
+    // Does nothing when DMA is not used for reception
+    {
+        init_test_uart(&uart);
+        dma_remaining_beats = SERCOM_UART_IN_BUFFER_LEN - 10;
+        sercom_uart_rx_dma_sync(&uart);
+
+        ut_assert(uart.in_buffer.length == 0);
+        ut_assert(uart.in_buffer.tail == 0);
+    }
+
+    // Nothing received yet, the write back descriptor may hold a count of 0
+    // or a full block
+    {
+        init_test_uart(&uart);
+        uart.rx_use_dma = 1;
+        dma_remaining_beats = 0;
+        sercom_uart_rx_dma_sync(&uart);
+        ut_assert(uart.in_buffer.length == 0);
+
+        dma_remaining_beats = SERCOM_UART_IN_BUFFER_LEN;
+        sercom_uart_rx_dma_sync(&uart);
+        ut_assert(uart.in_buffer.length == 0);
+    }
+
+    // Lines received by DMA are visible to the consumer functions
+    {
+        init_test_uart(&uart);
+        uart.rx_use_dma = 1;
+        dma_remaining_beats = SERCOM_UART_IN_BUFFER_LEN;
+
+        ut_assert(!sercom_uart_has_line(&uart));
+        dma_receive("radio_tx_o");
+        ut_assert(!sercom_uart_has_line(&uart));
+        ut_assert(uart.in_buffer.length == 10);
+        dma_receive("k\r\nok\r\n");
+        ut_assert(sercom_uart_has_line(&uart));
+
+        sercom_uart_get_line(&uart, line, sizeof(line));
+        ut_assert(!strcmp(line, "radio_tx_ok"));
+        sercom_uart_get_line(&uart, line, sizeof(line));
+        ut_assert(!strcmp(line, "ok"));
+        ut_assert(!sercom_uart_has_line(&uart));
+    }
+
+    // Data which wraps around the end of the buffer
+    {
+        init_test_uart(&uart);
+        uart.rx_use_dma = 1;
+        uart.in_buffer.head = SERCOM_UART_IN_BUFFER_LEN - 4;
+        uart.in_buffer.tail = SERCOM_UART_IN_BUFFER_LEN - 4;
+        dma_remaining_beats = 4;
+
+        dma_receive("$GPGGA\r\n");
+        ut_assert(sercom_uart_has_line(&uart));
+        ut_assert(uart.in_buffer.tail == 4);
+        ut_assert(uart.in_buffer.length == 8);
+
+        sercom_uart_get_line(&uart, line, sizeof(line));
+        ut_assert(!strcmp(line, "$GPGGA"));
+    }
+
+    // DMA overruns the head of the buffer, the oldest data is lost
+    {
+        init_test_uart(&uart);
+        uart.rx_use_dma = 1;
+        dma_remaining_beats = SERCOM_UART_IN_BUFFER_LEN;
+
+        for (int i = 0; i < (SERCOM_UART_IN_BUFFER_LEN - 4); i++) {
+            dma_receive("x");
+        }
+        sercom_uart_rx_dma_sync(&uart);
+        ut_assert(uart.in_buffer.length == (SERCOM_UART_IN_BUFFER_LEN - 4));
+
+        dma_receive("abcdef");
+        sercom_uart_rx_dma_sync(&uart);
+        ut_assert(uart.in_buffer.length == SERCOM_UART_IN_BUFFER_LEN);
+        ut_assert(uart.in_buffer.head == 2);
+        ut_assert(uart.in_buffer.tail == 2);
+    }
+
+    // DMA overruns a buffer which holds scanned lines and delimiters, the line
+    // and delimiter counts must match the data that is left
+    {
+        init_test_uart(&uart);
+        uart.rx_use_dma = 1;
+        dma_remaining_beats = SERCOM_UART_IN_BUFFER_LEN;
+
+        // Fill the buffer with lines which have all been scanned
+        for (int i = 0; i < (SERCOM_UART_IN_BUFFER_LEN / 8); i++) {
+            dma_receive("a,b,c\r\n");
+        }
+        ut_assert(sercom_uart_has_line(&uart));
+        ut_assert(sercom_uart_has_delim(&uart, ','));
+
+        // Overwrite all but one byte of the buffer with data that has no line
+        // endings or delimiters, the lines which were counted are lost
+        dma_receive("\n");
+        for (int i = 0; i < (SERCOM_UART_IN_BUFFER_LEN - 2); i++) {
+            dma_receive("x");
+        }
+        ut_assert(!sercom_uart_has_line(&uart));
+        ut_assert(!sercom_uart_has_delim(&uart, ','));
+        ut_assert(uart.in_buffer.length == SERCOM_UART_IN_BUFFER_LEN);
+        ut_assert(uart.in_buffer.line_count == 0);
+        ut_assert(uart.in_buffer.delim_count == 0);
+        ut_assert(uart.in_buffer.scanned == uart.in_buffer.length);
+
+        // Overrun a full buffer with line endings which have not been scanned.
+        // They are written over the bytes at the head, which are dropped.
+        dma_receive("\r\n\r\nyy");
+        sercom_uart_rx_dma_sync(&uart);
+        ut_assert(uart.in_buffer.length == SERCOM_UART_IN_BUFFER_LEN);
+        ut_assert(uart.in_buffer.line_count == 0);
+        ut_assert(uart.in_buffer.scanned == 0);
+        ut_assert(sercom_uart_has_line(&uart));
+        ut_assert(uart.in_buffer.line_count == 2);
+
+        // Counts stay correct for new lines
+        dma_receive("1,2\r\n");
+        ut_assert(sercom_uart_has_line(&uart));
+        ut_assert(uart.in_buffer.line_count == 3);
+        ut_assert(sercom_uart_has_delim(&uart, ','));
+        ut_assert(uart.in_buffer.delim_count == 1);
+
+        // Every line can be read back
+        for (int i = 0; i < 3; i++) {
+            ut_assert(sercom_uart_has_line(&uart));
+            sercom_uart_get_line(&uart, line, sizeof(line));
+        }
+        ut_assert(!strcmp(line, "yy1,2"));
+        ut_assert(!sercom_uart_has_line(&uart));
+        ut_assert(uart.in_buffer.line_count == 0);
+        ut_assert(uart.in_buffer.delim_count == 0);
+    }
+
+    // Data handed out by sercom_uart_get_received() which is overwritten by
+    // the DMA before it is consumed is reported and not consumed twice
+    {
+        const uint8_t *data;
+        init_test_uart(&uart);
+        uart.rx_use_dma = 1;
+        dma_remaining_beats = SERCOM_UART_IN_BUFFER_LEN;
+
+        dma_receive("0123456789");
+        ut_assert(sercom_uart_get_received(&uart, &data) == 10);
+        ut_assert(sercom_uart_consume(&uart, 4) == 0);
+        ut_assert(uart.in_buffer.length == 6);
+
+        ut_assert(sercom_uart_get_received(&uart, &data) == 6);
+        for (int i = 0; i < (SERCOM_UART_IN_BUFFER_LEN - 6 + 2); i++) {
+            dma_receive("x");
+        }
+        ut_assert(sercom_uart_consume(&uart, 6) == 1);
+        ut_assert(uart.in_buffer.length == (SERCOM_UART_IN_BUFFER_LEN - 4));
+        ut_assert(uart.in_buffer.head == 10);
+        while (uart.in_buffer.length != 0) {
+            ut_assert(sercom_uart_get_char(&uart) == 'x');
+        }
+
+        // The loss is only reported once
+        dma_receive("y");
+        ut_assert(sercom_uart_get_received(&uart, &data) == 1);
+        ut_assert(sercom_uart_consume(&uart, 1) == 0);
+    }
+
+    // The service wakes the tasks which wait on the UART only when data has
+    // been received by DMA
+    {
+        struct sched_task_t task = { .ready = 0 };
+        init_test_uart(&uart);
+        uart.rx_use_dma = 1;
+        uart.event.tasks[0] = &task;
+        uart.event.num_tasks = 1;
+        dma_remaining_beats = SERCOM_UART_IN_BUFFER_LEN;
+
+        sercom_uart_service(&uart);
+        ut_assert(!task.ready);
+
+        dma_receive("$GPRMC");
+        sercom_uart_service(&uart);
+        ut_assert(task.ready);
+        ut_assert(sched_pending_g);
+
+        task.ready = 0;
+        sercom_uart_service(&uart);
+        ut_assert(!task.ready);
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,76 @@
+#include <unittest.h>
+
+static inline void stub_disable_irq(void) {}
+static inline void stub_enable_irq(void) {}
+
+#define __disable_irq stub_disable_irq
+#define __enable_irq stub_enable_irq
+#include SOURCE_C
+#undef __disable_irq
+#undef __enable_irq
+
+#include <string.h>
+
+/*
+ *  Stubs and helpers for testing the SERCOM UART driver on the host.
+ *
+ *  This file is ment to be included into other tests. The UART instance is
+ *  backed by a fake set of SERCOM registers and uses interrupt driven
+ *  transmission so that nothing is ever removed from the output buffer unless
+ *  the test does so itself.
+ */
+
+volatile uint32_t millis;
+volatile uint8_t sched_pending_g;
+
+struct dma_callback_t dma_callbacks[DMAC_CH_NUM];
+
+static Sercom fake_sercom;
+
+int8_t dma_config_circular_buffer_to_static(struct dma_circ_transfer_t *tran,
+                                            uint8_t chan,
+                                            struct circular_buffer_t *buffer,
+                                            volatile uint8_t *dest,
+                                            uint8_t trigger, uint8_t priority)
+{
+    // Should never be called since DMA is not used
+    ut_assert(0);
+    return 1;
+}
+
+/** Value to be returned by dma_get_remaining_beats() */
+static uint16_t dma_remaining_beats;
+
+uint16_t dma_get_remaining_beats(uint8_t chan)
+{
+    return dma_remaining_beats;
+}
+
+static void init_test_uart(struct sercom_uart_desc_t *uart)
+{
+    memset(uart, 0, sizeof(*uart));
+    memset(&fake_sercom, 0, sizeof(fake_sercom));
+
+    uart->sercom = &fake_sercom;
+    init_circular_buffer(&uart->out_buffer, (uint8_t*)uart->out_buffer_mem,
+                         SERCOM_UART_OUT_BUFFER_LEN);
+    init_circular_buffer(&uart->in_buffer, (uint8_t*)uart->in_buffer_mem,
+                         SERCOM_UART_IN_BUFFER_LEN);
+}
+
+/**
+ *  Pop up to len characters from the UART output buffer into str and add a
+ *  null terminator.
+ */
+static uint16_t drain_test_uart(struct sercom_uart_desc_t *uart, char *str,
+                                uint16_t len)
+{
+    uint16_t i = 0;
+    for (; i < (len - 1); i++) {
+        if (circular_buffer_pop(&uart->out_buffer, (uint8_t*)(str + i))) {
+            break;
+        }
+    }
+    str[i] = '\0';
+    return i;
+}
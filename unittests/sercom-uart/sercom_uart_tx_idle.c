@@ -0,0 +1,44 @@
+#include "sercom_uart_stubs.c"
+
+/*
+ *  sercom_uart_tx_idle() reports whether all of the data queued on a UART has
+ *  been sent. Emptying the output buffer is not enough, the last characters
+ *  must also have been shifted out so that the baud rate can be changed
+ *  without corrupting them.
+ */
+
+static struct sercom_uart_desc_t uart;
+
+
+int main (int argc, char **argv)
+{
+    char out[SERCOM_UART_OUT_BUFFER_LEN + 1];
+
+    // Nothing has been sent yet, so TXC will never be set
+    init_test_uart(&uart);
+    ut_assert(sercom_uart_tx_idle(&uart));
+
+    // Data waiting in the output buffer
+    ut_assert(sercom_uart_put_string(&uart, "$PMTK251,115200*1F\r\n") == 20);
+    ut_assert(!sercom_uart_tx_idle(&uart));
+
+    // The last character has been taken from the output buffer but the data
+    // register empty interrupt has not yet been disabled
+    ut_assert(drain_test_uart(&uart, out, sizeof(out)) == 20);
+    ut_assert(!sercom_uart_tx_idle(&uart));
+
+    // Everything has been written to the data register but is still being
+    // shifted out
+    fake_sercom.USART.INTENSET.bit.DRE = 0;
+    ut_assert(!sercom_uart_tx_idle(&uart));
+
+    // The transmission is complete
+    fake_sercom.USART.INTFLAG.reg = SERCOM_USART_INTFLAG_TXC;
+    ut_assert(sercom_uart_tx_idle(&uart));
+
+    // A break condition is still being sent
+    uart.break_duration = 10;
+    ut_assert(!sercom_uart_tx_idle(&uart));
+
+    return UT_PASS;
+}
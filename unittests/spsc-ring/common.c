@@ -0,0 +1,22 @@
+#include <unittest.h>
+
+/*
+ *  The SPSC ring must never disable interrupts, make sure that any attempt to
+ *  do so fails the test.
+ */
+
+static inline void my_disable_irq(void)
+{
+    ut_assert(0);
+}
+
+static inline void my_enable_irq(void)
+{
+    ut_assert(0);
+}
+
+#define __disable_irq my_disable_irq
+#define __enable_irq my_enable_irq
+#include SOURCE_H
+#undef __disable_irq
+#undef __enable_irq
@@ -0,0 +1,40 @@
+#include <string.h>
+#include "common.c"
+
+/*
+ *  init_spsc_ring() initializes a ring buffer with a power of two capacity.
+ */
+
+
+int main (int argc, char **argv)
+{
+    struct spsc_ring_t ring;
+    uint8_t buffer[64];
+
+    // Valid capacities
+    {
+        memset(&ring, 0xA5, sizeof(ring));
+        int ret = init_spsc_ring(&ring, buffer, 64);
+
+        ut_assert(!ret);
+        ut_assert(ring.buffer == buffer);
+        ut_assert(ring.mask == 63);
+        ut_assert(ring.head == 0);
+        ut_assert(ring.tail == 0);
+
+        ut_assert(!init_spsc_ring(&ring, buffer, 1));
+        ut_assert(ring.mask == 0);
+        ut_assert(!init_spsc_ring(&ring, buffer, 32768));
+        ut_assert(ring.mask == 32767);
+    }
+
+    // Invalid capacities
+    {
+        ut_assert(init_spsc_ring(&ring, buffer, 0));
+        ut_assert(init_spsc_ring(&ring, buffer, 48));
+        ut_assert(init_spsc_ring(&ring, buffer, 65535));
+        ut_assert(init_spsc_ring(&ring, buffer, 255));
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,138 @@
+#include <unittest.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ *  Throughput benchmark for the SPSC ring. The ring is compared against
+ *  circular_buffer_t moving the same amount of data in the same sized chunks,
+ *  first with one thread acting as both producer and consumer and then with
+ *  the producer on a separate thread. On the host the critical sections in
+ *  circular_buffer_t are free, so the single threaded comparison only
+ *  reflects the cost of the modulo arithmetic and per item access.
+ */
+
+static inline void bench_disable_irq(void) {}
+static inline void bench_enable_irq(void) {}
+
+#define __disable_irq bench_disable_irq
+#define __enable_irq bench_enable_irq
+#include "circular-buffer.h"
+#include SOURCE_H
+#undef __disable_irq
+#undef __enable_irq
+
+#define BENCH_RING_LEN      512
+#define BENCH_CHUNK_LEN     64
+#define BENCH_BYTES         (8UL * 1024UL * 1024UL)
+
+static struct spsc_ring_t ring;
+static uint8_t ring_mem[BENCH_RING_LEN];
+
+static double elapsed_seconds(struct timespec const *start,
+                              struct timespec const *end)
+{
+    return ((double)(end->tv_sec - start->tv_sec) +
+            ((double)(end->tv_nsec - start->tv_nsec) / 1e9));
+}
+
+static void *threaded_producer(void *arg)
+{
+    uint8_t chunk[BENCH_CHUNK_LEN];
+    memset(chunk, 0x5A, sizeof(chunk));
+
+    for (uint32_t sent = 0; sent < BENCH_BYTES;) {
+        uint16_t const len = spsc_ring_push_n(&ring, chunk, sizeof(chunk));
+        if (len == 0) {
+            sched_yield();
+        }
+        sent += len;
+    }
+    return NULL;
+}
+
+
+int main (int argc, char **argv)
+{
+    struct timespec start, end;
+    uint8_t in[BENCH_CHUNK_LEN];
+    uint8_t out[BENCH_CHUNK_LEN];
+    uint32_t checksum = 0;
+
+    for (unsigned i = 0; i < sizeof(in); i++) {
+        in[i] = (uint8_t)i;
+    }
+
+    // circular_buffer_t, one item at a time
+    struct circular_buffer_t cb;
+    uint8_t cb_mem[BENCH_RING_LEN];
+    init_circular_buffer(&cb, cb_mem, sizeof(cb_mem));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t moved = 0; moved < BENCH_BYTES; moved += sizeof(in)) {
+        for (unsigned i = 0; i < sizeof(in); i++) {
+            circular_buffer_push(&cb, in[i]);
+        }
+        for (unsigned i = 0; i < sizeof(out); i++) {
+            circular_buffer_pop(&cb, out + i);
+        }
+        checksum += out[sizeof(out) - 1];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double const cb_time = elapsed_seconds(&start, &end);
+
+    // spsc_ring_t, one item at a time
+    init_spsc_ring(&ring, ring_mem, sizeof(ring_mem));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t moved = 0; moved < BENCH_BYTES; moved += sizeof(in)) {
+        for (unsigned i = 0; i < sizeof(in); i++) {
+            spsc_ring_push(&ring, in[i]);
+        }
+        for (unsigned i = 0; i < sizeof(out); i++) {
+            spsc_ring_pop(&ring, out + i);
+        }
+        ut_assert(!memcmp(in, out, sizeof(in)));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double const single_time = elapsed_seconds(&start, &end);
+
+    // spsc_ring_t, bulk
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t moved = 0; moved < BENCH_BYTES; moved += sizeof(in)) {
+        ut_assert(spsc_ring_push_n(&ring, in, sizeof(in)) == sizeof(in));
+        ut_assert(spsc_ring_pop_n(&ring, out, sizeof(out)) == sizeof(out));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double const bulk_time = elapsed_seconds(&start, &end);
+    ut_assert(!memcmp(in, out, sizeof(in)));
+
+    // spsc_ring_t, bulk with producer on another thread
+    init_spsc_ring(&ring, ring_mem, sizeof(ring_mem));
+    pthread_t thread;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ut_assert(!pthread_create(&thread, NULL, threaded_producer, NULL));
+    for (uint32_t received = 0; received < BENCH_BYTES;) {
+        uint16_t const len = spsc_ring_pop_n(&ring, out, sizeof(out));
+        if (len == 0) {
+            sched_yield();
+        }
+        received += len;
+    }
+    ut_assert(!pthread_join(thread, NULL));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double const threaded_time = elapsed_seconds(&start, &end);
+
+    double const mb = (double)BENCH_BYTES / (1024.0 * 1024.0);
+    printf("circular_buffer push/pop:        %8.1f MiB/s\n", mb / cb_time);
+    printf("spsc_ring push/pop:              %8.1f MiB/s\n", mb / single_time);
+    printf("spsc_ring push_n/pop_n:          %8.1f MiB/s\n", mb / bulk_time);
+    printf("spsc_ring threaded push_n/pop_n: %8.1f MiB/s\n",
+           mb / threaded_time);
+    printf("(checksum %u)\n", (unsigned)checksum);
+
+    return UT_PASS;
+}
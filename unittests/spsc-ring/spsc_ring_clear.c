@@ -0,0 +1,25 @@
+#include "common.c"
+
+/*
+ *  spsc_ring_clear() discards all of the data in a ring.
+ */
+
+
+int main (int argc, char **argv)
+{
+    struct spsc_ring_t ring;
+    uint8_t buffer[8];
+    init_spsc_ring(&ring, buffer, sizeof(buffer));
+
+    {
+        ring.head = 65533;
+        ring.tail = 2;
+        spsc_ring_clear(&ring);
+
+        ut_assert(ring.head == 2);
+        ut_assert(ring.tail == 2);
+        ut_assert(spsc_ring_is_empty(&ring));
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,56 @@
+#include "common.c"
+
+/*
+ *  spsc_ring_get_head() finds the contiguous data after the head of a ring.
+ */
+
+
+int main (int argc, char **argv)
+{
+    struct spsc_ring_t ring;
+    uint8_t buffer[32];
+    uint8_t *head;
+    init_spsc_ring(&ring, buffer, sizeof(buffer));
+
+    // Empty ring
+    {
+        ring.head = 40;
+        ring.tail = 40;
+        uint16_t ret = spsc_ring_get_head(&ring, &head);
+
+        ut_assert(ret == 0);
+        ut_assert(head == buffer + 8);
+    }
+
+    // Data is limited by the tail
+    {
+        ring.head = 65534;
+        ring.tail = 65535;
+        uint16_t ret = spsc_ring_get_head(&ring, &head);
+
+        ut_assert(ret == 1);
+        ut_assert(head == buffer + 30);
+    }
+
+    // Data is limited by the end of the memory
+    {
+        ring.head = 65534;
+        ring.tail = 10;
+        uint16_t ret = spsc_ring_get_head(&ring, &head);
+
+        ut_assert(ret == 2);
+        ut_assert(head == buffer + 30);
+    }
+
+    // Full ring
+    {
+        ring.head = 0;
+        ring.tail = 32;
+        uint16_t ret = spsc_ring_get_head(&ring, &head);
+
+        ut_assert(ret == 32);
+        ut_assert(head == buffer);
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,55 @@
+#include "common.c"
+
+/*
+ *  spsc_ring_get_tail() finds the contiguous unused space after the tail of a
+ *  ring.
+ */
+
+
+int main (int argc, char **argv)
+{
+    struct spsc_ring_t ring;
+    uint8_t buffer[32];
+    uint8_t *tail;
+    init_spsc_ring(&ring, buffer, sizeof(buffer));
+
+    // Empty ring
+    {
+        uint16_t ret = spsc_ring_get_tail(&ring, &tail);
+
+        ut_assert(ret == 32);
+        ut_assert(tail == buffer);
+    }
+
+    // Free space is limited by the end of the memory
+    {
+        ring.head = 20;
+        ring.tail = 24;
+        uint16_t ret = spsc_ring_get_tail(&ring, &tail);
+
+        ut_assert(ret == 8);
+        ut_assert(tail == buffer + 24);
+    }
+
+    // Free space is limited by the head
+    {
+        ring.head = 65530;
+        ring.tail = 20;
+        uint16_t ret = spsc_ring_get_tail(&ring, &tail);
+
+        ut_assert(ret == 6);
+        ut_assert(tail == buffer + 20);
+    }
+
+    // Full ring
+    {
+        ring.head = 7;
+        ring.tail = 39;
+        uint16_t ret = spsc_ring_get_tail(&ring, &tail);
+
+        ut_assert(ret == 0);
+        ut_assert(tail == buffer + 7);
+    }
+
+    return UT_PASS;
+}
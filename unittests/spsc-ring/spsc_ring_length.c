@@ -0,0 +1,54 @@
+#include "common.c"
+
+/*
+ *  spsc_ring_length() and the related spsc_ring_unused(),
+ *  spsc_ring_capacity(), spsc_ring_is_empty() and spsc_ring_is_full() find how
+ *  much of a ring is used from the free running indices.
+ */
+
+
+int main (int argc, char **argv)
+{
+    struct spsc_ring_t ring;
+    uint8_t buffer[16];
+    init_spsc_ring(&ring, buffer, sizeof(buffer));
+
+    // Empty ring
+    {
+        ut_assert(spsc_ring_length(&ring) == 0);
+        ut_assert(spsc_ring_unused(&ring) == 16);
+        ut_assert(spsc_ring_capacity(&ring) == 16);
+        ut_assert(spsc_ring_is_empty(&ring));
+        ut_assert(!spsc_ring_is_full(&ring));
+    }
+
+    // Partially full ring where the indices have wrapped past the capacity
+    {
+        ring.head = 100;
+        ring.tail = 105;
+        ut_assert(spsc_ring_length(&ring) == 5);
+        ut_assert(spsc_ring_unused(&ring) == 11);
+        ut_assert(!spsc_ring_is_empty(&ring));
+        ut_assert(!spsc_ring_is_full(&ring));
+    }
+
+    // Full ring where the tail index has overflowed
+    {
+        ring.head = 65530;
+        ring.tail = 10;
+        ut_assert(spsc_ring_length(&ring) == 16);
+        ut_assert(spsc_ring_unused(&ring) == 0);
+        ut_assert(!spsc_ring_is_empty(&ring));
+        ut_assert(spsc_ring_is_full(&ring));
+    }
+
+    // Empty ring where both indices have overflowed
+    {
+        ring.head = 3;
+        ring.tail = 3;
+        ut_assert(spsc_ring_length(&ring) == 0);
+        ut_assert(spsc_ring_is_empty(&ring));
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,41 @@
+#include <string.h>
+#include "common.c"
+
+/*
+ *  spsc_ring_move_head() releases data which has been read from the head of a
+ *  ring.
+ */
+
+
+int main (int argc, char **argv)
+{
+    struct spsc_ring_t ring;
+    uint8_t buffer[16];
+    uint8_t *head;
+    init_spsc_ring(&ring, buffer, sizeof(buffer));
+
+    // Read directly from the ring in two contiguous spans
+    {
+        ring.head = 65530;
+        ring.tail = 65530;
+        ut_assert(spsc_ring_push_n(&ring, (uint8_t const *)"0123456789", 10) ==
+                  10);
+
+        uint16_t len = spsc_ring_get_head(&ring, &head);
+        ut_assert(len == 6);
+        ut_assert(!memcmp(head, "012345", len));
+        spsc_ring_move_head(&ring, len);
+        ut_assert(ring.head == 0);
+
+        len = spsc_ring_get_head(&ring, &head);
+        ut_assert(len == 4);
+        ut_assert(!memcmp(head, "6789", len));
+        spsc_ring_move_head(&ring, len);
+
+        ut_assert(ring.head == 4);
+        ut_assert(spsc_ring_is_empty(&ring));
+        ut_assert(spsc_ring_unused(&ring) == 16);
+    }
+
+    return UT_PASS;
+}
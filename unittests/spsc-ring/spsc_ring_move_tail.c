@@ -0,0 +1,42 @@
+#include <string.h>
+#include "common.c"
+
+/*
+ *  spsc_ring_move_tail() publishes data written after the tail of a ring.
+ */
+
+
+int main (int argc, char **argv)
+{
+    struct spsc_ring_t ring;
+    uint8_t buffer[16];
+    uint8_t *tail;
+    init_spsc_ring(&ring, buffer, sizeof(buffer));
+
+    // Write directly into the ring in two contiguous spans
+    {
+        ring.head = 65530;
+        ring.tail = 65530;
+
+        uint16_t space = spsc_ring_get_tail(&ring, &tail);
+        ut_assert(space == 6);
+        memcpy(tail, "abcdef", space);
+        spsc_ring_move_tail(&ring, space);
+        ut_assert(ring.tail == 0);
+
+        space = spsc_ring_get_tail(&ring, &tail);
+        ut_assert(space == 10);
+        ut_assert(tail == buffer);
+        memcpy(tail, "ghi", 3);
+        spsc_ring_move_tail(&ring, 3);
+
+        ut_assert(ring.tail == 3);
+        ut_assert(spsc_ring_length(&ring) == 9);
+
+        uint8_t out[9];
+        ut_assert(spsc_ring_pop_n(&ring, out, sizeof(out)) == 9);
+        ut_assert(!memcmp(out, "abcdefghi", 9));
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,42 @@
+#include "common.c"
+
+/*
+ *  spsc_ring_pop() removes an item from the head of a ring if one is available.
+ */
+
+
+int main (int argc, char **argv)
+{
+    struct spsc_ring_t ring;
+    uint8_t buffer[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    init_spsc_ring(&ring, buffer, sizeof(buffer));
+    uint8_t value;
+
+    // Pop from an empty ring
+    {
+        value = 0xFF;
+        int ret = spsc_ring_pop(&ring, &value);
+
+        ut_assert(ret);
+        ut_assert(value == 0xFF);
+        ut_assert(ring.head == 0);
+        ut_assert(ring.tail == 0);
+    }
+
+    // Pop across the end of the memory and past index overflow
+    {
+        ring.head = 65534;
+        ring.tail = 2;
+        uint8_t const expected[] = {6, 7, 0, 1};
+        for (int i = 0; i < 4; i++) {
+            int ret = spsc_ring_pop(&ring, &value);
+            ut_assert(!ret);
+            ut_assert(value == expected[i]);
+        }
+
+        ut_assert(ring.head == 2);
+        ut_assert(spsc_ring_pop(&ring, &value));
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,53 @@
+#include <string.h>
+#include "common.c"
+
+/*
+ *  spsc_ring_pop_n() removes up to a given number of items from a ring.
+ */
+
+
+int main (int argc, char **argv)
+{
+    struct spsc_ring_t ring;
+    uint8_t buffer[16];
+    memcpy(buffer, "0123456789abcdef", 16);
+    uint8_t out[32];
+
+    // Pop that does not wrap
+    {
+        init_spsc_ring(&ring, buffer, sizeof(buffer));
+        ring.tail = 10;
+        uint16_t ret = spsc_ring_pop_n(&ring, out, 4);
+
+        ut_assert(ret == 4);
+        ut_assert(ring.head == 4);
+        ut_assert(!memcmp(out, "0123", 4));
+    }
+
+    // Pop that wraps around the end of the memory
+    {
+        init_spsc_ring(&ring, buffer, sizeof(buffer));
+        ring.head = 65532;
+        ring.tail = 4;
+        uint16_t ret = spsc_ring_pop_n(&ring, out, 7);
+
+        ut_assert(ret == 7);
+        ut_assert(ring.head == 3);
+        ut_assert(!memcmp(out, "cdef012", 7));
+    }
+
+    // Pop more than is available
+    {
+        memset(out, 0, sizeof(out));
+        uint16_t ret = spsc_ring_pop_n(&ring, out, sizeof(out));
+
+        ut_assert(ret == 1);
+        ut_assert(ring.head == 4);
+        ut_assert(out[0] == '3');
+        ut_assert(out[1] == 0);
+
+        ut_assert(spsc_ring_pop_n(&ring, out, sizeof(out)) == 0);
+    }
+
+    return UT_PASS;
+}
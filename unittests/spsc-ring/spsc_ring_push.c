@@ -0,0 +1,51 @@
+#include "common.c"
+
+/*
+ *  spsc_ring_push() inserts an item at the tail of a ring if there is space.
+ */
+
+
+int main (int argc, char **argv)
+{
+    struct spsc_ring_t ring;
+    uint8_t buffer[8];
+    init_spsc_ring(&ring, buffer, sizeof(buffer));
+
+    // Push into an empty ring
+    {
+        int ret = spsc_ring_push(&ring, 42);
+
+        ut_assert(!ret);
+        ut_assert(buffer[0] == 42);
+        ut_assert(ring.head == 0);
+        ut_assert(ring.tail == 1);
+    }
+
+    // Push across the end of the memory and past index overflow
+    {
+        ring.head = 65532;
+        ring.tail = 65534;
+        for (uint8_t i = 0; i < 6; i++) {
+            ut_assert(!spsc_ring_push(&ring, i));
+        }
+
+        ut_assert(ring.tail == 4);
+        ut_assert(buffer[6] == 0);
+        ut_assert(buffer[7] == 1);
+        ut_assert(buffer[0] == 2);
+        ut_assert(buffer[3] == 5);
+    }
+
+    // Push into a full ring
+    {
+        ut_assert(spsc_ring_is_full(&ring));
+        int ret = spsc_ring_push(&ring, 0xFF);
+
+        ut_assert(ret);
+        ut_assert(ring.head == 65532);
+        ut_assert(ring.tail == 4);
+        ut_assert(buffer[4] != 0xFF);
+    }
+
+    return UT_PASS;
+}
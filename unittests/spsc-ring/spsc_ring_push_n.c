@@ -0,0 +1,58 @@
+#include <string.h>
+#include "common.c"
+
+/*
+ *  spsc_ring_push_n() inserts as much of an array as will fit into a ring.
+ */
+
+
+int main (int argc, char **argv)
+{
+    struct spsc_ring_t ring;
+    uint8_t buffer[16];
+    static uint8_t const data[] = "0123456789abcdefghij";
+
+    // Push that fits without wrapping
+    {
+        init_spsc_ring(&ring, buffer, sizeof(buffer));
+        memset(buffer, 0, sizeof(buffer));
+        uint16_t ret = spsc_ring_push_n(&ring, data, 10);
+
+        ut_assert(ret == 10);
+        ut_assert(ring.tail == 10);
+        ut_assert(!memcmp(buffer, data, 10));
+    }
+
+    // Push that wraps around the end of the memory
+    {
+        init_spsc_ring(&ring, buffer, sizeof(buffer));
+        memset(buffer, 0, sizeof(buffer));
+        ring.head = 12;
+        ring.tail = 12;
+        uint16_t ret = spsc_ring_push_n(&ring, data, 8);
+
+        ut_assert(ret == 8);
+        ut_assert(ring.tail == 20);
+        ut_assert(!memcmp(buffer + 12, data, 4));
+        ut_assert(!memcmp(buffer, data + 4, 4));
+    }
+
+    // Push more than fits
+    {
+        init_spsc_ring(&ring, buffer, sizeof(buffer));
+        ring.head = 65530;
+        ring.tail = 65535;
+        uint16_t ret = spsc_ring_push_n(&ring, data, 20);
+
+        ut_assert(ret == 11);
+        ut_assert(ring.tail == 10);
+        ut_assert(spsc_ring_is_full(&ring));
+        ut_assert(buffer[15] == '0');
+        ut_assert(!memcmp(buffer, data + 1, 10));
+
+        ut_assert(spsc_ring_push_n(&ring, data, 20) == 0);
+        ut_assert(ring.tail == 10);
+    }
+
+    return UT_PASS;
+}
@@ -0,0 +1,124 @@
+#include <pthread.h>
+#include <sched.h>
+#include "common.c"
+
+/*
+ *  Stream data through a ring with the producer and consumer running on
+ *  separate threads. The producer and consumer mix single item, bulk and span
+ *  based access and the consumer checks that the data arrives intact and in
+ *  order.
+ */
+
+#define STREAM_LENGTH   (8UL * 1024UL * 1024UL)
+
+static struct spsc_ring_t ring;
+static uint8_t ring_mem[256];
+
+static inline uint8_t stream_byte(uint32_t i)
+{
+    return (uint8_t)((i * 2654435761UL) >> 24);
+}
+
+static void *producer(void *arg)
+{
+    uint32_t sent = 0;
+    uint8_t chunk[97];
+
+    while (sent < STREAM_LENGTH) {
+        uint32_t const last = sent;
+
+        switch (sent % 3) {
+            case 0:
+                if (!spsc_ring_push(&ring, stream_byte(sent))) {
+                    sent++;
+                }
+                break;
+            case 1: {
+                uint16_t len = (uint16_t)(1 + (sent % sizeof(chunk)));
+                if (len > (STREAM_LENGTH - sent)) {
+                    len = (uint16_t)(STREAM_LENGTH - sent);
+                }
+                for (uint16_t i = 0; i < len; i++) {
+                    chunk[i] = stream_byte(sent + i);
+                }
+                sent += spsc_ring_push_n(&ring, chunk, len);
+                break;
+            }
+            case 2: {
+                uint8_t *tail;
+                uint16_t len = spsc_ring_get_tail(&ring, &tail);
+                if (len > (STREAM_LENGTH - sent)) {
+                    len = (uint16_t)(STREAM_LENGTH - sent);
+                }
+                for (uint16_t i = 0; i < len; i++) {
+                    tail[i] = stream_byte(sent + i);
+                }
+                spsc_ring_move_tail(&ring, len);
+                sent += len;
+                break;
+            }
+        }
+
+        if (sent == last) {
+            // Let the consumer run if the ring is full
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+
+int main (int argc, char **argv)
+{
+    init_spsc_ring(&ring, ring_mem, sizeof(ring_mem));
+
+    pthread_t thread;
+    ut_assert(!pthread_create(&thread, NULL, producer, NULL));
+
+    uint32_t received = 0;
+    uint8_t chunk[61];
+
+    while (received < STREAM_LENGTH) {
+        uint32_t const last = received;
+
+        switch (received % 3) {
+            case 0: {
+                uint8_t c;
+                if (!spsc_ring_pop(&ring, &c)) {
+                    ut_assert(c == stream_byte(received));
+                    received++;
+                }
+                break;
+            }
+            case 1: {
+                uint16_t len = spsc_ring_pop_n(&ring, chunk, sizeof(chunk));
+                for (uint16_t i = 0; i < len; i++) {
+                    ut_assert(chunk[i] == stream_byte(received + i));
+                }
+                received += len;
+                break;
+            }
+            case 2: {
+                uint8_t *head;
+                uint16_t len = spsc_ring_get_head(&ring, &head);
+                for (uint16_t i = 0; i < len; i++) {
+                    ut_assert(head[i] == stream_byte(received + i));
+                }
+                spsc_ring_move_head(&ring, len);
+                received += len;
+                break;
+            }
+        }
+
+        if (received == last) {
+            // Let the producer run if the ring is empty
+            sched_yield();
+        }
+    }
+
+    ut_assert(!pthread_join(thread, NULL));
+    ut_assert(spsc_ring_is_empty(&ring));
+
+    return UT_PASS;
+}
@@ -74,7 +74,7 @@ endif
 build: $(TEST_BINARIES)
 
 $(BINDIR)/% %.gcno: %.c | $(BINDIR)
-	$(CC) $(CFLAGS) $(SYMBOL_STRIP_ARG) -fprofile-arcs -ftest-coverage "$(abspath $<)" -o "${BINDIR}/$(basename $(notdir $@))"
+	$(CC) $(CFLAGS) $(SYMBOL_STRIP_ARG) -fprofile-arcs -ftest-coverage "$(abspath $<)" -o "${BINDIR}/$(basename $(notdir $@))" $(LDLIBS)
 
 %.gcda: $(BINDIR)/%
 	rm -f $@